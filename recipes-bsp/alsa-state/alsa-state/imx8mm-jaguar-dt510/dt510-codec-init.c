@@ -0,0 +1,699 @@
+/* SPDX-License-Identifier: MIT */
+/*
+ * dt510-codec-init - DT510 boot mixer defaults for all codecs in one pass
+ *
+ * Native replacement for tas6424-init.sh, tas2563-init.sh and
+ * taa5412-init.sh. Each codec gets its own thread, so the tannoy amp, the
+ * driver speaker and the driver mic (separate cards on separate I2C
+ * buses) come up in parallel rather than each waiting on the others'
+ * amixer runs. Per codec it:
+ *
+ *   - waits for the named ctl from /etc/asound.conf (tannoys, drivers,
+ *     driver_mic), polling every 100 ms and falling back to a card whose
+ *     id, name or PCM names contain the codec name, as the scripts do
+ *     with aplay -l
+ *   - lists the card's mixer elements once and resolves every control
+ *     of the profile against that list
+ *   - queues the values (dB settings converted through the element's
+ *     TLV), then writes the batch back to back
+ *
+ * The profiles are the scripts' own environment variables, with the same
+ * defaults; the unit reads overrides from /etc/default/dt510-codec-init.
+ * Each codec logs one line with its wait, write and total time.
+ *
+ *   dt510-codec-init                            # all codecs
+ *   dt510-codec-init tas6424                    # what tas6424-init runs
+ *   dt510-codec-init -n -v                      # resolve and print only
+ *
+ * Like the scripts, a codec that never shows up is a warning, not a
+ * failure: the exit status is 0 unless the command line is wrong.
+ */
+
+#define _GNU_SOURCE
+#include <errno.h>
+#include <getopt.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <syslog.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <alsa/asoundlib.h>
+
+#define MAX_WRITES           16
+#define POLL_MS              100
+#define DEFAULT_TIMEOUT_S    40
+#define NAME_LEN             64
+
+typedef enum {
+    VAL_RAW = 0,        // cset: integer, enum index or boolean
+    VAL_DB,             // sset -- NNdB: through the element's TLV
+    VAL_OFF             // sset off: switch 0, or the enum item "off"
+} val_kind_t;
+
+typedef struct {
+    unsigned int index;         // into the element list
+    val_kind_t kind;
+    double value;
+} write_t;
+
+typedef struct codec codec_t;
+
+struct codec {
+    const char *name;           // tas6424, also the card match
+    const char *mixer;          // named ctl in /etc/asound.conf
+    const char *what;           // for the log
+    void (*plan)(codec_t *c);
+    void (*after)(codec_t *c);
+
+    // Per run
+    snd_ctl_t *ctl;
+    char ctl_name[NAME_LEN];
+    snd_ctl_elem_list_t *list;
+    unsigned int n_elems;
+    write_t writes[MAX_WRITES];
+    unsigned int n_writes;
+    unsigned int written;
+    unsigned int failed;
+    char summary[256];
+    double wait_ms;
+    double write_ms;
+    double total_ms;
+    int found;
+    pthread_t thread;
+};
+
+static int timeout_s = DEFAULT_TIMEOUT_S;
+static int dry_run;
+static int verbose;
+static struct timespec t_start;
+
+// alsa-lib's config parsing (named ctls) is not safe to run concurrently
+static pthread_mutex_t open_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static double ms_since(const struct timespec *t0) {
+    struct timespec t;
+
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (double)(t.tv_sec - t0->tv_sec) * 1e3 + (double)(t.tv_nsec - t0->tv_nsec) / 1e6;
+}
+
+static void logmsg(int prio, const codec_t *c, const char *fmt, ...) {
+    char buf[512];
+    va_list ap;
+
+    va_start(ap, fmt);
+    vsnprintf(buf, sizeof(buf), fmt, ap);
+    va_end(ap);
+    syslog(prio, "%s: %s", c->name, buf);
+    if (verbose || prio <= LOG_WARNING) {
+        fprintf(stderr, "%s: %s\n", c->name, buf);
+    }
+}
+
+static const char *env_or(const char *name, const char *def) {
+    const char *v = getenv(name);
+
+    return v && *v ? v : def;
+}
+
+static double env_num(const char *name, double def) {
+    const char *v = getenv(name);
+    char *end;
+    double d;
+
+    if (!v || !*v) {
+        return def;
+    }
+    d = strtod(v, &end);
+    // TAS6424_BOOT_VOL may carry a dB suffix
+    if (end == v || (*end && strcasecmp(end, "dB") != 0)) {
+        syslog(LOG_WARNING, "%s=%s is not a number, using %g", name, v, def);
+        return def;
+    }
+    return d;
+}
+
+/* ---- Card and element lookup ---- */
+
+static int contains_ci(const char *s, const char *needle) {
+    return s && strcasestr(s, needle) != NULL;
+}
+
+// Does any PCM device of this card carry the codec name (aplay -l / arecord -l)?
+static int pcm_matches(snd_ctl_t *ctl, const char *needle) {
+    snd_pcm_info_t *info;
+    int dev = -1;
+
+    snd_pcm_info_alloca(&info);
+    while (snd_ctl_pcm_next_device(ctl, &dev) == 0 && dev >= 0) {
+        for (int s = 0; s < 2; s++) {
+            snd_pcm_info_set_device(info, dev);
+            snd_pcm_info_set_subdevice(info, 0);
+            snd_pcm_info_set_stream(info, s ? SND_PCM_STREAM_CAPTURE : SND_PCM_STREAM_PLAYBACK);
+            if (snd_ctl_pcm_info(ctl, info) == 0 &&
+                (contains_ci(snd_pcm_info_get_id(info), needle) ||
+                 contains_ci(snd_pcm_info_get_name(info), needle))) {
+                return 1;
+            }
+        }
+    }
+    return 0;
+}
+
+static snd_ctl_t *find_card(const char *needle, char *found, size_t len) {
+    snd_ctl_card_info_t *info;
+    int card = -1;
+
+    snd_ctl_card_info_alloca(&info);
+    while (snd_card_next(&card) == 0 && card >= 0) {
+        char hw[16];
+        snd_ctl_t *ctl;
+
+        snprintf(hw, sizeof(hw), "hw:%d", card);
+        if (snd_ctl_open(&ctl, hw, 0) < 0) {
+            continue;
+        }
+        if (snd_ctl_card_info(ctl, info) == 0 &&
+            (contains_ci(snd_ctl_card_info_get_id(info), needle) ||
+             contains_ci(snd_ctl_card_info_get_name(info), needle) ||
+             contains_ci(snd_ctl_card_info_get_longname(info), needle) ||
+             pcm_matches(ctl, needle))) {
+            snprintf(found, len, "%s", hw);
+            return ctl;
+        }
+        snd_ctl_close(ctl);
+    }
+    return NULL;
+}
+
+static int open_mixer(codec_t *c) {
+    struct timespec t0;
+    int announced = 0;
+
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (;;) {
+        pthread_mutex_lock(&open_lock);
+        if (snd_ctl_open(&c->ctl, c->mixer, 0) == 0) {
+            snprintf(c->ctl_name, sizeof(c->ctl_name), "%s", c->mixer);
+        } else {
+            c->ctl = find_card(c->name, c->ctl_name, sizeof(c->ctl_name));
+            if (c->ctl) {
+                logmsg(LOG_NOTICE, c, "using %s instead of named mixer %s", c->ctl_name, c->mixer);
+            }
+        }
+        pthread_mutex_unlock(&open_lock);
+        if (c->ctl) {
+            c->wait_ms = ms_since(&t0);
+            return 0;
+        }
+        if (ms_since(&t0) >= timeout_s * 1e3) {
+            return -1;
+        }
+        if (!announced && verbose) {
+            logmsg(LOG_INFO, c, "waiting up to %d s for %s", timeout_s, c->mixer);
+            announced = 1;
+        }
+        usleep(POLL_MS * 1000);
+    }
+}
+
+static int list_elems(codec_t *c) {
+    int err;
+
+    if ((err = snd_ctl_elem_list_malloc(&c->list)) < 0 ||
+        (err = snd_ctl_elem_list(c->ctl, c->list)) < 0) {
+        return err;
+    }
+    c->n_elems = snd_ctl_elem_list_get_count(c->list);
+    if ((err = snd_ctl_elem_list_alloc_space(c->list, c->n_elems)) < 0 ||
+        (err = snd_ctl_elem_list(c->ctl, c->list)) < 0) {
+        return err;
+    }
+    c->n_elems = snd_ctl_elem_list_get_used(c->list);
+    return 0;
+}
+
+static int elem_is_mixer(const codec_t *c, unsigned int i) {
+    return snd_ctl_elem_list_get_interface(c->list, i) == SND_CTL_ELEM_IFACE_MIXER;
+}
+
+// Exact element name, as amixer cset name=...
+static int find_exact(const codec_t *c, const char *name) {
+    for (unsigned int i = 0; i < c->n_elems; i++) {
+        if (elem_is_mixer(c, i) && strcmp(snd_ctl_elem_list_get_name(c->list, i), name) == 0) {
+            return (int)i;
+        }
+    }
+    return -1;
+}
+
+// Simple mixer control name, as amixer sset: "X" is "X", "X Playback Volume", ...
+static int find_simple(const codec_t *c, const char *name, int want_switch) {
+    static const char *const volume[] = { "", " Playback Volume", " Volume" };
+    static const char *const swtch[] = { "", " Playback Switch", " Switch" };
+    const char *const *suffix = want_switch ? swtch : volume;
+
+    for (int s = 0; s < 3; s++) {
+        char full[NAME_LEN];
+        int i;
+
+        snprintf(full, sizeof(full), "%s%s", name, suffix[s]);
+        if ((i = find_exact(c, full)) >= 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+// First element whose name contains the fragment (taa5412-init find_ch_ctrl)
+static int find_containing(const codec_t *c, const char *fragment) {
+    for (unsigned int i = 0; i < c->n_elems; i++) {
+        if (elem_is_mixer(c, i) && strstr(snd_ctl_elem_list_get_name(c->list, i), fragment)) {
+            return (int)i;
+        }
+    }
+    return -1;
+}
+
+static const char *elem_name(const codec_t *c, unsigned int i) {
+    return snd_ctl_elem_list_get_name(c->list, i);
+}
+
+/* ---- Write batch ---- */
+
+static void queue(codec_t *c, int index, val_kind_t kind, double value) {
+    if (index < 0) {
+        return;
+    }
+    if (c->n_writes == MAX_WRITES) {
+        logmsg(LOG_WARNING, c, "more than %d writes, dropping %s", MAX_WRITES,
+               elem_name(c, (unsigned int)index));
+        return;
+    }
+    c->writes[c->n_writes++] = (write_t){ (unsigned int)index, kind, value };
+}
+
+// Build the element value for one write; returns 0, or a negative errno
+static int fill_value(codec_t *c, const write_t *w, snd_ctl_elem_id_t *id, snd_ctl_elem_value_t *val) {
+    snd_ctl_elem_info_t *info;
+    unsigned int count;
+    long raw = lround(w->value);
+    int err;
+
+    snd_ctl_elem_info_alloca(&info);
+    snd_ctl_elem_info_set_id(info, id);
+    if ((err = snd_ctl_elem_info(c->ctl, info)) < 0) {
+        return err;
+    }
+    count = snd_ctl_elem_info_get_count(info);
+    snd_ctl_elem_value_set_id(val, id);
+
+    switch (snd_ctl_elem_info_get_type(info)) {
+    case SND_CTL_ELEM_TYPE_BOOLEAN:
+        for (unsigned int i = 0; i < count; i++) {
+            snd_ctl_elem_value_set_boolean(val, i, w->kind == VAL_OFF ? 0 : raw != 0);
+        }
+        return 0;
+    case SND_CTL_ELEM_TYPE_INTEGER:
+        if (w->kind == VAL_OFF) {
+            return -EINVAL;
+        }
+        if (w->kind == VAL_DB &&
+            (err = snd_ctl_convert_from_dB(c->ctl, id, lround(w->value * 100), &raw, 0)) < 0) {
+            return err;
+        }
+        if (raw < snd_ctl_elem_info_get_min(info)) {
+            raw = snd_ctl_elem_info_get_min(info);
+        }
+        if (raw > snd_ctl_elem_info_get_max(info)) {
+            raw = snd_ctl_elem_info_get_max(info);
+        }
+        for (unsigned int i = 0; i < count; i++) {
+            snd_ctl_elem_value_set_integer(val, i, raw);
+        }
+        return 0;
+    case SND_CTL_ELEM_TYPE_INTEGER64:
+        if (w->kind != VAL_RAW) {
+            return -EINVAL;
+        }
+        for (unsigned int i = 0; i < count; i++) {
+            snd_ctl_elem_value_set_integer64(val, i, raw);
+        }
+        return 0;
+    case SND_CTL_ELEM_TYPE_ENUMERATED: {
+        unsigned int items = snd_ctl_elem_info_get_items(info);
+
+        if (w->kind == VAL_DB) {
+            return -EINVAL;
+        }
+        if (w->kind == VAL_OFF) {
+            raw = -1;
+            for (unsigned int k = 0; k < items && raw < 0; k++) {
+                snd_ctl_elem_info_set_item(info, k);
+                if (snd_ctl_elem_info(c->ctl, info) == 0 &&
+                    (strcasecmp(snd_ctl_elem_info_get_item_name(info), "off") == 0 ||
+                     strcasecmp(snd_ctl_elem_info_get_item_name(info), "disabled") == 0)) {
+                    raw = (long)k;
+                }
+            }
+        }
+        if (raw < 0 || (unsigned long)raw >= items) {
+            return -ERANGE;
+        }
+        for (unsigned int i = 0; i < count; i++) {
+            snd_ctl_elem_value_set_enumerated(val, i, (unsigned int)raw);
+        }
+        return 0;
+    }
+    default:
+        return -EINVAL;
+    }
+}
+
+static void flush(codec_t *c) {
+    struct timespec t0;
+    snd_ctl_elem_id_t *id;
+    snd_ctl_elem_value_t *val;
+
+    snd_ctl_elem_id_alloca(&id);
+    snd_ctl_elem_value_alloca(&val);
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (unsigned int k = 0; k < c->n_writes; k++) {
+        const write_t *w = &c->writes[k];
+        int err;
+
+        snd_ctl_elem_list_get_id(c->list, w->index, id);
+        snd_ctl_elem_value_clear(val);
+        err = fill_value(c, w, id, val);
+        if (err == 0 && !dry_run) {
+            err = snd_ctl_elem_write(c->ctl, val);
+        }
+        if (err < 0) {
+            logmsg(LOG_WARNING, c, "%s: %s", elem_name(c, w->index), snd_strerror(err));
+            c->failed++;
+            continue;
+        }
+        if (verbose) {
+            if (w->kind == VAL_OFF) {
+                logmsg(LOG_INFO, c, "%s%s = off", dry_run ? "(dry run) " : "", elem_name(c, w->index));
+            } else {
+                logmsg(LOG_INFO, c, "%s%s = %g%s", dry_run ? "(dry run) " : "", elem_name(c, w->index),
+                       w->value, w->kind == VAL_DB ? " dB" : "");
+            }
+        }
+        c->written++;
+    }
+    c->write_ms = ms_since(&t0);
+}
+
+/* ---- Profiles ---- */
+
+// tas6424-init.sh: Tannoy CH1-CH4 (or legacy Speaker Driver CHn) in dB, Auto Diagnostics off
+static void plan_tas6424(codec_t *c) {
+    const char *custom[4] = {
+        getenv("TAS6424_VOL_CH1"), getenv("TAS6424_VOL_CH2"),
+        getenv("TAS6424_VOL_CH3"), getenv("TAS6424_VOL_CH4"),
+    };
+    double db = env_num("TAS6424_BOOT_VOL", -17.5);
+    const char *prefix = NULL;
+    int n = 0;
+
+    if (custom[0] && *custom[0] && custom[1] && *custom[1] &&
+        custom[2] && *custom[2] && custom[3] && *custom[3]) {
+        for (int ch = 0; ch < 4; ch++) {
+            int i = find_simple(c, custom[ch], 0);
+
+            if (i < 0) {
+                logmsg(LOG_WARNING, c, "no control '%s' on %s", custom[ch], c->ctl_name);
+            }
+            queue(c, i, VAL_DB, db);
+            n += i >= 0;
+        }
+    } else {
+        if (find_simple(c, "Tannoy CH1", 0) >= 0) {
+            prefix = "Tannoy CH";
+        } else if (find_simple(c, "Speaker Driver CH1", 0) >= 0) {
+            prefix = "Speaker Driver CH";
+        } else {
+            logmsg(LOG_WARNING, c, "could not probe CH1-CH4 on %s", c->ctl_name);
+            return;
+        }
+        for (int ch = 1; ch <= 4; ch++) {
+            char name[NAME_LEN];
+            int i;
+
+            snprintf(name, sizeof(name), "%s%d", prefix, ch);
+            i = find_simple(c, name, 0);
+            queue(c, i, VAL_DB, db);
+            n += i >= 0;
+        }
+    }
+    queue(c, find_simple(c, "Auto Diagnostics", 1), VAL_OFF, 0);
+    snprintf(c->summary, sizeof(c->summary), "CH1-CH%d=%gdB AutoDiag off", n, db);
+}
+
+// tas2563-init.sh: ASI1 Sel Left, comlib DVC index or tas2562 DVC, Amp Gain
+static void plan_tas2563(codec_t *c) {
+    const char *dvc_name = env_or("TAS2563_DVC_CTRL", "Speaker Digital Volume");
+    double vol = env_num("TAS2563_BOOT_DVC", 204);
+    double dvc2 = env_num("TAS2562_BOOT_DVC", 100);
+    double amp = env_num("TAS2562_BOOT_AMP_GAIN", 20);
+    int len = 0;
+    int i;
+
+    queue(c, find_exact(c, "ASI1 Sel"), VAL_RAW, 1);
+
+    if ((i = find_exact(c, dvc_name)) >= 0) {
+        queue(c, i, VAL_RAW, vol);
+        len += snprintf(c->summary + len, sizeof(c->summary) - len, "%s=%g", dvc_name, vol);
+    } else if ((i = find_exact(c, "Digital Volume Control")) >= 0) {
+        queue(c, i, VAL_RAW, dvc2);
+        len += snprintf(c->summary + len, sizeof(c->summary) - len, "Digital Volume Control=%g", dvc2);
+    } else {
+        logmsg(LOG_NOTICE, c, "neither '%s' nor 'Digital Volume Control' on %s", dvc_name, c->ctl_name);
+    }
+
+    if ((i = find_exact(c, "Amp Gain Volume")) < 0) {
+        i = find_exact(c, "Amp Gain");
+    }
+    if (i >= 0) {
+        queue(c, i, VAL_RAW, amp);
+        snprintf(c->summary + len, sizeof(c->summary) - len, "%sAmp Gain=%g", len ? " " : "", amp);
+    } else {
+        logmsg(LOG_NOTICE, c, "no Amp Gain Volume on %s (tas2562 driver may not expose it yet)", c->ctl_name);
+    }
+}
+
+/*
+ * Mixer writes alone do not run the TAS2562 DAPM/PCM startup; the first
+ * aplay after boot can be inaudible until the path has opened once, so
+ * play a short stretch of silence (skip with TAS2563_SKIP_PCM_WARMUP=1).
+ */
+static void warmup_tas2563(codec_t *c) {
+    const char *pcm_name = env_or("TAS2563_WARMUP_PCM", "driver_speaker");
+    unsigned int ms = (unsigned int)env_num("TAS2563_WARMUP_MS", 1000);
+    snd_pcm_t *pcm;
+    int16_t zero[2 * 480] = { 0 };
+    unsigned int frames = 48 * ms;
+    int err;
+
+    if (dry_run || getenv("TAS2563_SKIP_PCM_WARMUP")) {
+        return;
+    }
+    pthread_mutex_lock(&open_lock);
+    err = snd_pcm_open(&pcm, pcm_name, SND_PCM_STREAM_PLAYBACK, 0);
+    pthread_mutex_unlock(&open_lock);
+    if (err == 0) {
+        err = snd_pcm_set_params(pcm, SND_PCM_FORMAT_S16_LE, SND_PCM_ACCESS_RW_INTERLEAVED,
+                                 2, 48000, 1, 100000);
+        while (err >= 0 && frames) {
+            snd_pcm_uframes_t n = frames < 480 ? frames : 480;
+            snd_pcm_sframes_t w = snd_pcm_writei(pcm, zero, n);
+
+            if (w < 0) {
+                err = snd_pcm_recover(pcm, (int)w, 1);
+                continue;
+            }
+            frames -= (unsigned int)w;
+        }
+        snd_pcm_drop(pcm);
+        snd_pcm_close(pcm);
+    }
+    if (err < 0) {
+        logmsg(LOG_WARNING, c, "%s PCM warmup failed (first aplay may be silent until retry): %s",
+               pcm_name, snd_strerror(err));
+    } else {
+        logmsg(LOG_INFO, c, "%s PCM warmup (%u ms silence)", pcm_name, ms);
+    }
+}
+
+// taa5412-init.sh: Ch1 Digi/Fine gain, Ch2-Ch4 Digi muted
+static void plan_taa5412(codec_t *c) {
+    double ch1_digi = env_num("TAA5412_CH1_DIGI", 177);
+    double ch1_fine = env_num("TAA5412_CH1_FINE", 8);
+    double ch_fine = env_num("TAA5412_CH_FINE", 8);
+
+    for (int ch = 1; ch <= 4; ch++) {
+        char frag[16];
+        int i;
+
+        snprintf(frag, sizeof(frag), "Ch%d Digi", ch);
+        queue(c, find_containing(c, frag), VAL_RAW, ch == 1 ? ch1_digi : 0);
+        snprintf(frag, sizeof(frag), "Ch%d Fine", ch);
+        if ((i = find_containing(c, frag)) < 0 && verbose) {
+            logmsg(LOG_INFO, c, "no '%s' control on %s", frag, c->ctl_name);
+        }
+        queue(c, i, VAL_RAW, ch == 1 ? ch1_fine : ch_fine);
+    }
+    snprintf(c->summary, sizeof(c->summary), "Ch1 Digi=%g Fine=%g; Ch2-4 Digi=0 Fine=%g",
+             ch1_digi, ch1_fine, ch_fine);
+}
+
+static codec_t codecs[] = {
+    { .name = "tas6424", .what = "tannoy amp", .plan = plan_tas6424 },
+    { .name = "tas2563", .what = "driver speaker", .plan = plan_tas2563, .after = warmup_tas2563 },
+    { .name = "taa5412", .what = "driver mic", .plan = plan_taa5412 },
+};
+
+#define N_CODECS (sizeof(codecs) / sizeof(codecs[0]))
+
+static void *run_codec(void *arg) {
+    codec_t *c = arg;
+    struct timespec t0;
+    int err;
+
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    if (open_mixer(c) < 0) {
+        logmsg(LOG_WARNING, c, "no %s mixer after %d s (named ctl %s, no card matching '%s')",
+               c->what, timeout_s, c->mixer, c->name);
+        c->total_ms = ms_since(&t0);
+        return NULL;
+    }
+    c->found = 1;
+    if ((err = list_elems(c)) < 0) {
+        logmsg(LOG_WARNING, c, "%s: cannot list controls: %s", c->ctl_name, snd_strerror(err));
+    } else {
+        c->plan(c);
+        flush(c);
+    }
+    if (c->after) {
+        c->after(c);
+    }
+    if (c->list) {
+        snd_ctl_elem_list_free_space(c->list);
+        snd_ctl_elem_list_free(c->list);
+    }
+    snd_ctl_close(c->ctl);
+    c->total_ms = ms_since(&t0);
+
+    logmsg(c->failed ? LOG_WARNING : LOG_INFO, c,
+           "%s%s%s %s on %s: %u/%u writes in %.1f ms, mixer after %.1f ms, done in %.1f ms",
+           c->failed ? "" : "OK: ", c->what, dry_run ? " (dry run)" : "", c->summary, c->ctl_name,
+           c->written, c->n_writes, c->write_ms, c->wait_ms, c->total_ms);
+    return NULL;
+}
+
+static void print_usage(const char *prog) {
+    printf("Usage: %s [options] [tas6424|tas2563|taa5412 ...]\n\n", prog);
+    printf("Apply the DT510 boot mixer defaults, all codecs (default) in parallel.\n\n");
+    printf("  -t, --timeout S       Wait this long for each codec's mixer (default %d)\n", DEFAULT_TIMEOUT_S);
+    printf("  -n, --dry-run         Resolve controls and print the writes, change nothing\n");
+    printf("  -v, --verbose         Print every write and the timings on stderr\n");
+    printf("  -h, --help            Show this help\n\n");
+    printf("Profile (environment, as the *-init scripts):\n");
+    printf("  TAS6424_MIXER (tannoys) TAS6424_BOOT_VOL (-17.5 dB) TAS6424_VOL_CH1..CH4\n");
+    printf("  TAS2563_MIXER (drivers) TAS2563_BOOT_DVC (204) TAS2563_DVC_CTRL\n");
+    printf("  TAS2562_BOOT_DVC (100) TAS2562_BOOT_AMP_GAIN (20) TAS2563_SKIP_PCM_WARMUP\n");
+    printf("  TAA5412_MIXER (driver_mic) TAA5412_CH1_DIGI (177) TAA5412_CH1_FINE (8) TAA5412_CH_FINE (8)\n");
+}
+
+int main(int argc, char **argv) {
+    static const struct option long_options[] = {
+        { "timeout", required_argument, NULL, 't' },
+        { "dry-run", no_argument, NULL, 'n' },
+        { "verbose", no_argument, NULL, 'v' },
+        { "help", no_argument, NULL, 'h' },
+        { NULL, 0, NULL, 0 }
+    };
+    int selected[N_CODECS] = { 0 };
+    unsigned int n_selected = 0;
+    unsigned int ready = 0;
+    int opt;
+
+    while ((opt = getopt_long(argc, argv, "t:nvh", long_options, NULL)) != -1) {
+        switch (opt) {
+        case 't':
+            timeout_s = atoi(optarg);
+            if (timeout_s < 0) {
+                fprintf(stderr, "dt510-codec-init: bad timeout '%s'\n", optarg);
+                return 2;
+            }
+            break;
+        case 'n':
+            dry_run = 1;
+            break;
+        case 'v':
+            verbose = 1;
+            break;
+        case 'h':
+            print_usage(argv[0]);
+            return 0;
+        default:
+            print_usage(argv[0]);
+            return 2;
+        }
+    }
+    for (int a = optind; a < argc; a++) {
+        size_t k;
+
+        for (k = 0; k < N_CODECS && strcmp(argv[a], codecs[k].name) != 0; k++) {
+        }
+        if (k == N_CODECS) {
+            fprintf(stderr, "dt510-codec-init: unknown codec '%s'\n", argv[a]);
+            return 2;
+        }
+        selected[k] = 1;
+    }
+
+    openlog("dt510-codec-init", LOG_PID, LOG_USER);
+    codecs[0].mixer = env_or("TAS6424_MIXER", "tannoys");
+    codecs[1].mixer = env_or("TAS2563_MIXER", "drivers");
+    codecs[2].mixer = env_or("TAA5412_MIXER", "driver_mic");
+
+    clock_gettime(CLOCK_MONOTONIC, &t_start);
+    for (size_t k = 0; k < N_CODECS; k++) {
+        if (optind < argc && !selected[k]) {
+            continue;
+        }
+        selected[k] = 1;
+        if (pthread_create(&codecs[k].thread, NULL, run_codec, &codecs[k]) != 0) {
+            // Out of threads: still bring the codec up, just not in parallel
+            run_codec(&codecs[k]);
+            selected[k] = 2;
+        }
+        n_selected++;
+    }
+    for (size_t k = 0; k < N_CODECS; k++) {
+        if (selected[k] == 1) {
+            pthread_join(codecs[k].thread, NULL);
+        }
+        if (selected[k] && codecs[k].found) {
+            ready++;
+        }
+    }
+
+    syslog(LOG_INFO, "%u/%u codecs initialised in %.1f ms", ready, n_selected, ms_since(&t_start));
+    if (verbose) {
+        fprintf(stderr, "dt510-codec-init: %u/%u codecs initialised in %.1f ms\n",
+                ready, n_selected, ms_since(&t_start));
+    }
+    closelog();
+    return 0;
+}
@@ -7,6 +7,12 @@
 # Optional env: TAA5412_MIXER (default driver_mic), TAA5412_CH1_DIGI (default 177),
 # TAA5412_CH1_FINE (default 8 — reg 0x53 lower nibble / Ch1 Fine ALSA control).
 
+# dt510-codec-init applies the same profile natively (one ctl open, batched writes);
+# DT510_CODEC_INIT_SHELL=1 keeps the amixer path below.
+if [ -z "${DT510_CODEC_INIT_SHELL:-}" ] && command -v dt510-codec-init >/dev/null 2>&1; then
+	exec dt510-codec-init taa5412
+fi
+
 MIX=${TAA5412_MIXER:-driver_mic}
 CH1_DIGI=${TAA5412_CH1_DIGI:-177}
 CH1_FINE=${TAA5412_CH1_FINE:-8}
@@ -12,6 +12,12 @@
 #   TAS2562_BOOT_DVC (default 100 — Digital Volume Control; Michael lab 2026-05-28, avoid 110 sustained),
 #   TAS2562_BOOT_AMP_GAIN (default 20 — Amp Gain Volume ~18 dB; Sentai reference, ≤30 W target).
 
+# dt510-codec-init applies the same profile natively (one ctl open, batched writes);
+# DT510_CODEC_INIT_SHELL=1 keeps the amixer path below.
+if [ -z "${DT510_CODEC_INIT_SHELL:-}" ] && command -v dt510-codec-init >/dev/null 2>&1; then
+	exec dt510-codec-init tas2563
+fi
+
 MIX=${TAS2563_MIXER:-drivers}
 VOL=${TAS2563_BOOT_DVC:-204}
 DVC=${TAS2563_DVC_CTRL:-"Speaker Digital Volume"}
@@ -5,6 +5,12 @@
 # TAS6424_BOOT_VOL is dB for amixer sset -- NNdB (lab default -17.5). Use -- before negative dB.
 # Kernel 0026: Tannoy CHn TLV controls; lab/boot use dB sset -- (not linear index 20).
 
+# dt510-codec-init applies the same profile natively (one ctl open, batched writes);
+# DT510_CODEC_INIT_SHELL=1 keeps the amixer path below.
+if [ -z "${DT510_CODEC_INIT_SHELL:-}" ] && command -v dt510-codec-init >/dev/null 2>&1; then
+	exec dt510-codec-init tas6424
+fi
+
 VOL=${TAS6424_BOOT_VOL:--17.5}
 VOL_DB=$(echo "$VOL" | sed 's/[dD][bB]$//')
 MIX=${TAS6424_MIXER:-tannoys}
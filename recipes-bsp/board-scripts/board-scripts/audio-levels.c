@@ -0,0 +1,841 @@
+/* SPDX-License-Identifier: MIT */
+/*
+ * audio-levels - continuous capture level monitor
+ *
+ * Keeps one ALSA capture stream open and measures every hop (default
+ * 100 ms) of audio as it arrives: per channel sum of squares, peak and
+ * the number of samples at or above the clip level. The last window's
+ * worth of hop results (default 1 s) is kept in a ring, and every
+ * publish interval the window RMS, peak, clip count and silence state
+ * are published as one JSON line to stdout, to Unix-socket clients
+ * and/or to a file replaced atomically. Nothing is recorded to storage,
+ * so it can run for months without wearing the eMMC; keep -o on tmpfs
+ * (/run).
+ *
+ *   audio-levels -D hw:2,0 -c 2                    # print one line a second
+ *   audio-levels -q -S /run/audio-levels/levels.sock
+ *   audio-levels -i capture.wav -I 500             # analyse a recording
+ *
+ * This replaces the arecord/sox loop in record-audio.sh; the default
+ * silence threshold (-40 dBFS RMS) matches its 1% RMS amplitude test.
+ *
+ * The hop kernels use NEON on AArch64 for s16 with 1/2/4/8 channels and
+ * s32/float with 1/2/4 channels: each vector lane always holds the same
+ * channel, so lanes are accumulated independently and folded into
+ * channels once per hop. Other layouts use the scalar loop.
+ */
+
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <math.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include <alsa/asoundlib.h>
+
+#if defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+#include <wavfile.h>
+
+#define MAX_CHANNELS        16
+#define MAX_CLIENTS         8
+#define MAX_HOP_FRAMES      65536
+#define DBFS_FLOOR          -120.0
+
+#define DEFAULT_DEVICE      "default"
+#define DEFAULT_RATE        48000
+#define DEFAULT_CHANNELS    2
+#define DEFAULT_WINDOW_MS   1000
+#define DEFAULT_HOP_MS      100
+#define DEFAULT_INTERVAL_MS 1000
+#define DEFAULT_SILENCE     -40.0
+#define DEFAULT_CLIP        0.999
+
+typedef enum {
+    FMT_S16,
+    FMT_S32,
+    FMT_FLOAT
+} sample_fmt_t;
+
+// One hop, normalised to full scale = 1.0
+typedef struct {
+    double sumsq[MAX_CHANNELS];
+    float peak[MAX_CHANNELS];
+    uint32_t clips[MAX_CHANNELS];
+    uint32_t frames;
+} hop_stats_t;
+
+typedef struct {
+    sample_fmt_t fmt;
+    unsigned int channels;
+    unsigned int rate;
+    double clip;                // fraction of full scale
+    double silence_dbfs;
+
+    hop_stats_t *ring;          // last window_hops hops
+    unsigned int window_hops;
+    unsigned int ring_pos;
+    unsigned int ring_fill;
+
+    // Running totals
+    uint64_t frames;
+    uint64_t clips;
+    uint64_t silent_frames;
+    uint64_t silence_run;       // frames in the current silent stretch
+    unsigned int xruns;
+} levels_t;
+
+typedef struct {
+    const char *file;
+    int listen_fd;
+    const char *socket_path;
+    int clients[MAX_CLIENTS];
+    int quiet;
+    char last[4096];
+    size_t last_len;
+} publisher_t;
+
+static volatile sig_atomic_t stop;
+
+static void on_signal(int sig) {
+    (void)sig;
+    stop = 1;
+}
+
+static size_t sample_bytes(sample_fmt_t fmt) {
+    return fmt == FMT_S16 ? 2 : 4;
+}
+
+static const char *fmt_name(sample_fmt_t fmt) {
+    switch (fmt) {
+    case FMT_S16:
+        return "s16";
+    case FMT_S32:
+        return "s32";
+    default:
+        return "float";
+    }
+}
+
+static double to_dbfs(double v) {
+    return v > 0 ? fmax(20.0 * log10(v), DBFS_FLOOR) : DBFS_FLOOR;
+}
+
+/* ---- Hop kernels ---- */
+
+// s16 magnitudes saturate at 32767, so -32768 and 32767 both read as full scale
+static int16_t s16_clip_limit(double clip) {
+    return (int16_t)fmin(ceil(clip * 32768.0), 32767.0);
+}
+
+/*
+ * Per-lane accumulators: sample i of a hop always lands in lane i % lanes,
+ * and with lanes a multiple of the channel count that lane only ever sees
+ * channel i % channels. The scalar loop uses one lane per channel.
+ */
+typedef struct {
+    double sumsq[MAX_CHANNELS];
+    float peak[MAX_CHANNELS];
+    uint32_t clips[MAX_CHANNELS];
+} lanes_t;
+
+static void scalar_tail(lanes_t *acc, const void *buf, sample_fmt_t fmt, size_t from, size_t n,
+                        unsigned int lanes, double clip) {
+    int16_t limit = s16_clip_limit(clip);
+
+    for (size_t i = from; i < n; i++) {
+        unsigned int l = (unsigned int)(i % lanes);
+        double v;
+        double a;
+        int clipped;
+
+        switch (fmt) {
+        case FMT_S16: {
+            int16_t s = ((const int16_t *)buf)[i];
+            int16_t m = s == INT16_MIN ? INT16_MAX : (int16_t)abs(s);
+
+            v = s / 32768.0;
+            a = m / 32768.0;
+            clipped = m >= limit;
+            break;
+        }
+        case FMT_S32:
+            v = ((const int32_t *)buf)[i] / 2147483648.0;
+            a = fabs(v);
+            clipped = a >= clip;
+            break;
+        default:
+            v = ((const float *)buf)[i];
+            a = fabs(v);
+            clipped = a >= clip;
+            break;
+        }
+        acc->sumsq[l] += v * v;
+        if (a > acc->peak[l]) {
+            acc->peak[l] = (float)a;
+        }
+        acc->clips[l] += (uint32_t)clipped;
+    }
+}
+
+#if defined(__aarch64__)
+
+static size_t hop_s16_neon(lanes_t *acc, const int16_t *s, size_t n, double clip) {
+    int16x8_t limit = vdupq_n_s16(s16_clip_limit(clip));
+    int64x2_t sq0 = vdupq_n_s64(0), sq1 = sq0, sq2 = sq0, sq3 = sq0;
+    int16x8_t peak = vdupq_n_s16(0);
+    uint32x4_t clips_lo = vdupq_n_u32(0), clips_hi = clips_lo;
+    size_t i = 0;
+
+    while (i + 8 <= n) {
+        // 16-bit clip counters are widened before they can wrap
+        size_t stop_at = i + 8 * 4096 < n ? i + 8 * 4096 : n;
+        uint16x8_t clips = vdupq_n_u16(0);
+
+        for (; i + 8 <= stop_at; i += 8) {
+            int16x8_t v = vld1q_s16(s + i);
+            int16x8_t a = vqabsq_s16(v);
+            int32x4_t lo = vmull_s16(vget_low_s16(v), vget_low_s16(v));
+            int32x4_t hi = vmull_high_s16(v, v);
+
+            sq0 = vaddw_s32(sq0, vget_low_s32(lo));
+            sq1 = vaddw_high_s32(sq1, lo);
+            sq2 = vaddw_s32(sq2, vget_low_s32(hi));
+            sq3 = vaddw_high_s32(sq3, hi);
+            peak = vmaxq_s16(peak, a);
+            clips = vsubq_u16(clips, vcgeq_s16(a, limit));
+        }
+        clips_lo = vaddw_u16(clips_lo, vget_low_u16(clips));
+        clips_hi = vaddw_high_u16(clips_hi, clips);
+    }
+
+    {
+        int64_t sq[8];
+        int16_t pk[8];
+        uint32_t cl[8];
+
+        vst1q_s64(sq, sq0);
+        vst1q_s64(sq + 2, sq1);
+        vst1q_s64(sq + 4, sq2);
+        vst1q_s64(sq + 6, sq3);
+        vst1q_s16(pk, peak);
+        vst1q_u32(cl, clips_lo);
+        vst1q_u32(cl + 4, clips_hi);
+        for (unsigned int l = 0; l < 8; l++) {
+            acc->sumsq[l] += (double)sq[l] / (32768.0 * 32768.0);
+            acc->peak[l] = fmaxf(acc->peak[l], pk[l] / 32768.0f);
+            acc->clips[l] += cl[l];
+        }
+    }
+    return i;
+}
+
+// s32 is converted to float first; scale is 2^-31 for s32, 1 for float
+static size_t hop_f32_neon(lanes_t *acc, const void *buf, int is_s32, size_t n, double clip) {
+    double scale = is_s32 ? 1.0 / 2147483648.0 : 1.0;
+    float32x4_t limit = vdupq_n_f32((float)(clip / scale));
+    float64x2_t sq0 = vdupq_n_f64(0), sq1 = sq0;
+    float32x4_t peak = vdupq_n_f32(0);
+    uint32x4_t clips = vdupq_n_u32(0);
+    size_t i = 0;
+
+    for (; i + 4 <= n; i += 4) {
+        float32x4_t f = is_s32 ? vcvtq_f32_s32(vld1q_s32((const int32_t *)buf + i))
+                               : vld1q_f32((const float *)buf + i);
+        float32x4_t sq = vmulq_f32(f, f);
+
+        sq0 = vaddq_f64(sq0, vcvt_f64_f32(vget_low_f32(sq)));
+        sq1 = vaddq_f64(sq1, vcvt_high_f64_f32(sq));
+        peak = vmaxq_f32(peak, vabsq_f32(f));
+        clips = vsubq_u32(clips, vcageq_f32(f, limit));
+    }
+
+    {
+        double sq[4];
+        float pk[4];
+        uint32_t cl[4];
+
+        vst1q_f64(sq, sq0);
+        vst1q_f64(sq + 2, sq1);
+        vst1q_f32(pk, peak);
+        vst1q_u32(cl, clips);
+        for (unsigned int l = 0; l < 4; l++) {
+            acc->sumsq[l] += sq[l] * scale * scale;
+            acc->peak[l] = fmaxf(acc->peak[l], (float)(pk[l] * scale));
+            acc->clips[l] += cl[l];
+        }
+    }
+    return i;
+}
+
+#endif /* __aarch64__ */
+
+static void analyse_hop(hop_stats_t *hs, const void *buf, size_t frames, const levels_t *lv) {
+    unsigned int ch = lv->channels;
+    size_t n = frames * ch;
+    unsigned int lanes = ch;
+    size_t done = 0;
+    lanes_t acc;
+
+    memset(&acc, 0, sizeof(acc));
+
+#if defined(__aarch64__)
+    if (lv->fmt == FMT_S16 && 8 % ch == 0) {
+        lanes = 8;
+        done = hop_s16_neon(&acc, buf, n, lv->clip);
+    } else if (lv->fmt != FMT_S16 && 4 % ch == 0) {
+        lanes = 4;
+        done = hop_f32_neon(&acc, buf, lv->fmt == FMT_S32, n, lv->clip);
+    }
+#endif
+    scalar_tail(&acc, buf, lv->fmt, done, n, lanes, lv->clip);
+
+    memset(hs, 0, sizeof(*hs));
+    hs->frames = (uint32_t)frames;
+    for (unsigned int l = 0; l < lanes; l++) {
+        unsigned int c = l % ch;
+
+        hs->sumsq[c] += acc.sumsq[l];
+        hs->peak[c] = fmaxf(hs->peak[c], acc.peak[l]);
+        hs->clips[c] += acc.clips[l];
+    }
+}
+
+/* ---- Window ---- */
+
+static int levels_init(levels_t *lv, unsigned int window_hops) {
+    lv->window_hops = window_hops;
+    lv->ring = calloc(window_hops, sizeof(*lv->ring));
+    return lv->ring != NULL ? 0 : -1;
+}
+
+// Add one hop to the window and the running totals
+static void levels_push(levels_t *lv, const void *buf, size_t frames) {
+    hop_stats_t *hs = &lv->ring[lv->ring_pos];
+    int silent = 1;
+
+    analyse_hop(hs, buf, frames, lv);
+    lv->ring_pos = (lv->ring_pos + 1) % lv->window_hops;
+    if (lv->ring_fill < lv->window_hops) {
+        lv->ring_fill++;
+    }
+
+    for (unsigned int c = 0; c < lv->channels; c++) {
+        lv->clips += hs->clips[c];
+        if (to_dbfs(sqrt(hs->sumsq[c] / (double)frames)) >= lv->silence_dbfs) {
+            silent = 0;
+        }
+    }
+    lv->frames += frames;
+    if (silent) {
+        lv->silent_frames += frames;
+        lv->silence_run += frames;
+    } else {
+        lv->silence_run = 0;
+    }
+}
+
+static size_t levels_json(const levels_t *lv, char *buf, size_t size) {
+    double sumsq[MAX_CHANNELS] = { 0 };
+    float peak[MAX_CHANNELS] = { 0 };
+    uint64_t clips[MAX_CHANNELS] = { 0 };
+    uint64_t frames = 0;
+    int silent = 1;
+    struct timespec ts;
+    struct tm tm;
+    size_t len;
+
+    for (unsigned int h = 0; h < lv->ring_fill; h++) {
+        const hop_stats_t *hs = &lv->ring[h];
+
+        frames += hs->frames;
+        for (unsigned int c = 0; c < lv->channels; c++) {
+            sumsq[c] += hs->sumsq[c];
+            peak[c] = fmaxf(peak[c], hs->peak[c]);
+            clips[c] += hs->clips[c];
+        }
+    }
+
+    clock_gettime(CLOCK_REALTIME, &ts);
+    gmtime_r(&ts.tv_sec, &tm);
+    len = (size_t)snprintf(buf, size, "{\"time\":\"%04d-%02d-%02dT%02d:%02d:%02d.%03ldZ\",\"window_ms\":%llu,\"rms_dbfs\":[",
+                           tm.tm_year + 1900, tm.tm_mon + 1, tm.tm_mday, tm.tm_hour, tm.tm_min, tm.tm_sec,
+                           ts.tv_nsec / 1000000,
+                           (unsigned long long)(frames * 1000 / lv->rate));
+    for (unsigned int c = 0; c < lv->channels && len < size; c++) {
+        double rms = frames > 0 ? to_dbfs(sqrt(sumsq[c] / (double)frames)) : DBFS_FLOOR;
+
+        if (rms >= lv->silence_dbfs) {
+            silent = 0;
+        }
+        len += (size_t)snprintf(buf + len, size - len, "%s%.1f", c ? "," : "", rms);
+    }
+    if (len < size) {
+        len += (size_t)snprintf(buf + len, size - len, "],\"peak_dbfs\":[");
+    }
+    for (unsigned int c = 0; c < lv->channels && len < size; c++) {
+        len += (size_t)snprintf(buf + len, size - len, "%s%.1f", c ? "," : "", to_dbfs(peak[c]));
+    }
+    if (len < size) {
+        len += (size_t)snprintf(buf + len, size - len, "],\"clipped\":[");
+    }
+    for (unsigned int c = 0; c < lv->channels && len < size; c++) {
+        len += (size_t)snprintf(buf + len, size - len, "%s%llu", c ? "," : "",
+                                (unsigned long long)clips[c]);
+    }
+    if (len < size) {
+        len += (size_t)snprintf(buf + len, size - len,
+                                "],\"silent\":%s,\"silence_run_ms\":%llu,\"total_ms\":%llu,"
+                                "\"silent_ms\":%llu,\"clipped_total\":%llu,\"xruns\":%u}\n",
+                                silent ? "true" : "false",
+                                (unsigned long long)(lv->silence_run * 1000 / lv->rate),
+                                (unsigned long long)(lv->frames * 1000 / lv->rate),
+                                (unsigned long long)(lv->silent_frames * 1000 / lv->rate),
+                                (unsigned long long)lv->clips, lv->xruns);
+    }
+    return len < size ? len : 0;
+}
+
+/* ---- Publishing ---- */
+
+static int publisher_listen(publisher_t *pub, const char *path) {
+    struct sockaddr_un addr;
+
+    if (strlen(path) >= sizeof(addr.sun_path)) {
+        fprintf(stderr, "audio-levels: socket path too long\n");
+        return -1;
+    }
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, path);
+
+    pub->listen_fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (pub->listen_fd < 0) {
+        perror("audio-levels: socket");
+        return -1;
+    }
+    unlink(path);
+    if (bind(pub->listen_fd, (struct sockaddr *)&addr, sizeof(addr)) != 0 ||
+        listen(pub->listen_fd, MAX_CLIENTS) != 0) {
+        fprintf(stderr, "audio-levels: %s: %s\n", path, strerror(errno));
+        close(pub->listen_fd);
+        pub->listen_fd = -1;
+        return -1;
+    }
+    pub->socket_path = path;
+    return 0;
+}
+
+static void publisher_drop(publisher_t *pub, unsigned int i) {
+    close(pub->clients[i]);
+    pub->clients[i] = -1;
+}
+
+// New clients get the latest line straight away
+static void publisher_accept(publisher_t *pub) {
+    int fd;
+
+    if (pub->listen_fd < 0) {
+        return;
+    }
+    while ((fd = accept4(pub->listen_fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC)) >= 0) {
+        unsigned int i;
+
+        for (i = 0; i < MAX_CLIENTS && pub->clients[i] >= 0; i++) {
+        }
+        if (i == MAX_CLIENTS) {
+            close(fd);
+            continue;
+        }
+        pub->clients[i] = fd;
+        if (pub->last_len > 0 &&
+            send(fd, pub->last, pub->last_len, MSG_NOSIGNAL) != (ssize_t)pub->last_len) {
+            publisher_drop(pub, i);
+        }
+    }
+}
+
+static void publisher_write_file(const char *path, const char *line, size_t len) {
+    char tmp[4096];
+    int fd;
+
+    // Readers see the old or the new line, never half of one
+    snprintf(tmp, sizeof(tmp), "%s.tmp", path);
+    fd = open(tmp, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        return;
+    }
+    if (write(fd, line, len) != (ssize_t)len) {
+        close(fd);
+        unlink(tmp);
+        return;
+    }
+    close(fd);
+    rename(tmp, path);
+}
+
+static void publish(publisher_t *pub, const levels_t *lv) {
+    publisher_accept(pub);
+    pub->last_len = levels_json(lv, pub->last, sizeof(pub->last));
+    if (pub->last_len == 0) {
+        return;
+    }
+
+    if (!pub->quiet) {
+        fwrite(pub->last, 1, pub->last_len, stdout);
+        fflush(stdout);
+    }
+    if (pub->file != NULL) {
+        publisher_write_file(pub->file, pub->last, pub->last_len);
+    }
+
+    // A client that cannot keep up with one line per interval is dropped
+    for (unsigned int i = 0; i < MAX_CLIENTS; i++) {
+        if (pub->clients[i] >= 0 &&
+            send(pub->clients[i], pub->last, pub->last_len, MSG_NOSIGNAL) != (ssize_t)pub->last_len) {
+            publisher_drop(pub, i);
+        }
+    }
+}
+
+static void publisher_close(publisher_t *pub) {
+    for (unsigned int i = 0; i < MAX_CLIENTS; i++) {
+        if (pub->clients[i] >= 0) {
+            publisher_drop(pub, i);
+        }
+    }
+    if (pub->listen_fd >= 0) {
+        close(pub->listen_fd);
+        unlink(pub->socket_path);
+    }
+}
+
+/* ---- Sources ---- */
+
+static int run_capture(levels_t *lv, publisher_t *pub, const char *device, size_t hop_frames,
+                       unsigned int publish_hops, double duration) {
+    static const snd_pcm_format_t formats[] = {
+        [FMT_S16] = SND_PCM_FORMAT_S16_LE,
+        [FMT_S32] = SND_PCM_FORMAT_S32_LE,
+        [FMT_FLOAT] = SND_PCM_FORMAT_FLOAT_LE,
+    };
+    size_t frame_bytes = lv->channels * sample_bytes(lv->fmt);
+    uint64_t max_frames = (uint64_t)(duration * lv->rate);
+    unsigned int hops = 0;
+    snd_pcm_t *pcm;
+    uint8_t *buf;
+    int err;
+
+    err = snd_pcm_open(&pcm, device, SND_PCM_STREAM_CAPTURE, 0);
+    if (err < 0) {
+        fprintf(stderr, "audio-levels: %s: %s\n", device, snd_strerror(err));
+        return 1;
+    }
+    // Four hops of buffering rides out scheduling hiccups without xruns
+    err = snd_pcm_set_params(pcm, formats[lv->fmt], SND_PCM_ACCESS_RW_INTERLEAVED,
+                             lv->channels, lv->rate, 1,
+                             (unsigned int)(hop_frames * 4 * 1000000ull / lv->rate));
+    if (err < 0) {
+        fprintf(stderr, "audio-levels: %s: cannot capture %u ch %s %u Hz: %s\n",
+                device, lv->channels, fmt_name(lv->fmt), lv->rate, snd_strerror(err));
+        snd_pcm_close(pcm);
+        return 1;
+    }
+
+    buf = malloc(hop_frames * frame_bytes);
+    if (buf == NULL) {
+        snd_pcm_close(pcm);
+        return 1;
+    }
+
+    while (!stop && (max_frames == 0 || lv->frames < max_frames)) {
+        size_t got = 0;
+
+        while (got < hop_frames && !stop) {
+            snd_pcm_sframes_t n = snd_pcm_readi(pcm, buf + got * frame_bytes, hop_frames - got);
+
+            if (n == -EPIPE) {
+                lv->xruns++;
+            }
+            if (n < 0) {
+                n = snd_pcm_recover(pcm, (int)n, 1);
+                if (n < 0) {
+                    fprintf(stderr, "audio-levels: %s: %s\n", device, snd_strerror((int)n));
+                    stop = 1;
+                }
+                continue;
+            }
+            got += (size_t)n;
+        }
+        if (got < hop_frames) {
+            break;
+        }
+
+        levels_push(lv, buf, hop_frames);
+        if (++hops % publish_hops == 0) {
+            publish(pub, lv);
+        } else {
+            publisher_accept(pub);
+        }
+    }
+
+    free(buf);
+    snd_pcm_close(pcm);
+    return 0;
+}
+
+// Offline: the same analysis over a recording, as fast as it can be read
+static int run_file(levels_t *lv, publisher_t *pub, const char *path, unsigned int hop_ms,
+                    unsigned int publish_hops, double duration) {
+    const char *error = NULL;
+    unsigned int hops = 0;
+    uint64_t max_frames;
+    size_t hop_frames = 0;
+    wav_file_t wav;
+
+    if (wav_open(&wav, path, &error) != 0) {
+        fprintf(stderr, "audio-levels: %s: %s\n", path, error);
+        return 1;
+    }
+    if (wav.fmt.encoding == WAV_PCM && wav.fmt.width == 2) {
+        lv->fmt = FMT_S16;
+    } else if (wav.fmt.encoding == WAV_PCM && wav.fmt.width == 4) {
+        lv->fmt = FMT_S32;
+    } else if (wav.fmt.encoding == WAV_FLOAT && wav.fmt.width == 4) {
+        lv->fmt = FMT_FLOAT;
+    } else {
+        fprintf(stderr, "audio-levels: %s: %s is not supported (s16, s32 or float)\n",
+                path, wav_format_name(&wav.fmt));
+        wav_close(&wav);
+        return 1;
+    }
+    if (wav.fmt.channels > MAX_CHANNELS) {
+        fprintf(stderr, "audio-levels: %s: at most %d channels\n", path, MAX_CHANNELS);
+        wav_close(&wav);
+        return 1;
+    }
+    lv->channels = wav.fmt.channels;
+    lv->rate = wav.fmt.rate;
+    hop_frames = (size_t)hop_ms * lv->rate / 1000;
+    max_frames = (uint64_t)(duration * lv->rate);
+    if (hop_frames == 0 || hop_frames > MAX_HOP_FRAMES) {
+        fprintf(stderr, "audio-levels: hop of %zu frames is out of range\n", hop_frames);
+        wav_close(&wav);
+        return 1;
+    }
+
+    for (uint64_t pos = 0; pos + hop_frames <= wav.frames && !stop; pos += hop_frames) {
+        if (max_frames != 0 && lv->frames >= max_frames) {
+            break;
+        }
+        levels_push(lv, wav.data + pos * wav.frame_bytes, hop_frames);
+        wav_release(&wav, pos + hop_frames);
+        if (++hops % publish_hops == 0) {
+            publish(pub, lv);
+        }
+    }
+
+    wav_close(&wav);
+    return 0;
+}
+
+static void print_summary(const levels_t *lv) {
+    double total = (double)lv->frames / lv->rate;
+    double silent = (double)lv->silent_frames / lv->rate;
+
+    fprintf(stderr, "audio-levels: %.1f s analysed, audio %.1f s, silence %.1f s (%.1f%%), "
+            "%llu clipped samples, %u xruns\n",
+            total, total - silent, silent, total > 0 ? silent * 100.0 / total : 0.0,
+            (unsigned long long)lv->clips, lv->xruns);
+}
+
+static void print_usage(const char *prog) {
+    printf("Usage: %s [options]\n", prog);
+    printf("\n");
+    printf("Source:\n");
+    printf("  -D, --device PCM      ALSA capture device (default %s)\n", DEFAULT_DEVICE);
+    printf("  -r, --rate HZ         Sample rate (default %d)\n", DEFAULT_RATE);
+    printf("  -c, --channels N      Channels, 1-%d (default %d)\n", MAX_CHANNELS, DEFAULT_CHANNELS);
+    printf("  -f, --format FMT      s16, s32 or float (default s16)\n");
+    printf("  -i, --input FILE      Analyse a WAV file instead of capturing\n");
+    printf("\n");
+    printf("Analysis:\n");
+    printf("  -H, --hop MS          Analysis step (default %d)\n", DEFAULT_HOP_MS);
+    printf("  -w, --window MS       Sliding window the metrics cover (default %d)\n", DEFAULT_WINDOW_MS);
+    printf("  -s, --silence DBFS    RMS below this on every channel is silence (default %.0f)\n",
+           DEFAULT_SILENCE);
+    printf("  -C, --clip LEVEL      Fraction of full scale counted as clipped (default %.3f)\n",
+           DEFAULT_CLIP);
+    printf("  -t, --duration S      Stop after S seconds of audio (default: run until signalled)\n");
+    printf("\n");
+    printf("Output (one JSON line per interval):\n");
+    printf("  -I, --interval MS     Publish interval (default %d)\n", DEFAULT_INTERVAL_MS);
+    printf("  -S, --socket PATH     Stream to clients of a Unix socket\n");
+    printf("  -o, --output FILE     Replace FILE with the latest line (keep it on tmpfs)\n");
+    printf("  -q, --quiet           Do not print to stdout\n");
+    printf("  -h, --help            Show this help\n");
+}
+
+int main(int argc, char *argv[]) {
+    static const struct option long_opts[] = {
+        { "device", required_argument, NULL, 'D' },
+        { "rate", required_argument, NULL, 'r' },
+        { "channels", required_argument, NULL, 'c' },
+        { "format", required_argument, NULL, 'f' },
+        { "input", required_argument, NULL, 'i' },
+        { "hop", required_argument, NULL, 'H' },
+        { "window", required_argument, NULL, 'w' },
+        { "silence", required_argument, NULL, 's' },
+        { "clip", required_argument, NULL, 'C' },
+        { "duration", required_argument, NULL, 't' },
+        { "interval", required_argument, NULL, 'I' },
+        { "socket", required_argument, NULL, 'S' },
+        { "output", required_argument, NULL, 'o' },
+        { "quiet", no_argument, NULL, 'q' },
+        { "help", no_argument, NULL, 'h' },
+        { NULL, 0, NULL, 0 }
+    };
+    levels_t lv = {
+        .fmt = FMT_S16,
+        .channels = DEFAULT_CHANNELS,
+        .rate = DEFAULT_RATE,
+        .clip = DEFAULT_CLIP,
+        .silence_dbfs = DEFAULT_SILENCE,
+    };
+    publisher_t pub = { .listen_fd = -1 };
+    const char *device = DEFAULT_DEVICE;
+    const char *input = NULL;
+    const char *socket_path = NULL;
+    unsigned int hop_ms = DEFAULT_HOP_MS;
+    unsigned int window_ms = DEFAULT_WINDOW_MS;
+    unsigned int interval_ms = DEFAULT_INTERVAL_MS;
+    unsigned int publish_hops;
+    double duration = 0;
+    struct sigaction sa;
+    size_t hop_frames = 0;
+    int opt;
+    int rc;
+
+    for (unsigned int i = 0; i < MAX_CLIENTS; i++) {
+        pub.clients[i] = -1;
+    }
+
+    while ((opt = getopt_long(argc, argv, "D:r:c:f:i:H:w:s:C:t:I:S:o:qh", long_opts, NULL)) != -1) {
+        switch (opt) {
+        case 'D':
+            device = optarg;
+            break;
+        case 'r':
+            lv.rate = (unsigned int)strtoul(optarg, NULL, 0);
+            break;
+        case 'c':
+            lv.channels = (unsigned int)strtoul(optarg, NULL, 0);
+            break;
+        case 'f':
+            if (strcmp(optarg, "s16") == 0) {
+                lv.fmt = FMT_S16;
+            } else if (strcmp(optarg, "s32") == 0) {
+                lv.fmt = FMT_S32;
+            } else if (strcmp(optarg, "float") == 0) {
+                lv.fmt = FMT_FLOAT;
+            } else {
+                fprintf(stderr, "audio-levels: unknown format '%s'\n", optarg);
+                return 1;
+            }
+            break;
+        case 'i':
+            input = optarg;
+            break;
+        case 'H':
+            hop_ms = (unsigned int)strtoul(optarg, NULL, 0);
+            break;
+        case 'w':
+            window_ms = (unsigned int)strtoul(optarg, NULL, 0);
+            break;
+        case 's':
+            lv.silence_dbfs = strtod(optarg, NULL);
+            break;
+        case 'C':
+            lv.clip = strtod(optarg, NULL);
+            break;
+        case 't':
+            duration = strtod(optarg, NULL);
+            break;
+        case 'I':
+            interval_ms = (unsigned int)strtoul(optarg, NULL, 0);
+            break;
+        case 'S':
+            socket_path = optarg;
+            break;
+        case 'o':
+            pub.file = optarg;
+            break;
+        case 'q':
+            pub.quiet = 1;
+            break;
+        case 'h':
+            print_usage(argv[0]);
+            return 0;
+        default:
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (hop_ms == 0 || window_ms < hop_ms || interval_ms < hop_ms) {
+        fprintf(stderr, "audio-levels: window and interval must be at least one hop\n");
+        return 1;
+    }
+    if (lv.clip <= 0 || lv.clip > 1) {
+        fprintf(stderr, "audio-levels: clip level must be in (0, 1]\n");
+        return 1;
+    }
+    if (input == NULL) {
+        hop_frames = (size_t)hop_ms * lv.rate / 1000;
+        if (lv.channels < 1 || lv.channels > MAX_CHANNELS || lv.rate == 0 ||
+            hop_frames == 0 || hop_frames > MAX_HOP_FRAMES) {
+            fprintf(stderr, "audio-levels: unsupported channels, rate or hop\n");
+            return 1;
+        }
+    }
+
+    // The window and interval are rounded to whole hops
+    publish_hops = interval_ms / hop_ms;
+    if (levels_init(&lv, window_ms / hop_ms) != 0) {
+        fprintf(stderr, "audio-levels: out of memory\n");
+        return 1;
+    }
+    if (socket_path != NULL && publisher_listen(&pub, socket_path) != 0) {
+        free(lv.ring);
+        return 1;
+    }
+
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = on_signal;
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+    signal(SIGPIPE, SIG_IGN);
+
+    if (input != NULL) {
+        rc = run_file(&lv, &pub, input, hop_ms, publish_hops, duration);
+    } else {
+        rc = run_capture(&lv, &pub, device, hop_frames, publish_hops, duration);
+    }
+
+    if (lv.frames > 0) {
+        print_summary(&lv);
+    }
+    publisher_close(&pub);
+    free(lv.ring);
+    return rc;
+}
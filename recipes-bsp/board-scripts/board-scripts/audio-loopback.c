@@ -0,0 +1,1152 @@
+/* SPDX-License-Identifier: MIT */
+/*
+ * audio-loopback - full-duplex DTMF / tone loopback verifier
+ *
+ * Plays a short DTMF sequence (default 182846, the digits of
+ * dtmf-182846.wav) or a list of tones and captures at the same time from
+ * one process, with the two PCMs linked where the driver allows it so
+ * both start on the same frame. Every capture channel and the stimulus
+ * itself then go through a bank of sliding Goertzel detectors, one per
+ * expected frequency, to decode the sequence and measure for each
+ * channel:
+ *
+ *   - the decoded digits, compared with the ones played
+ *   - tone level in dBFS (a full-scale sine is 0 dBFS)
+ *   - SNR: tone energy against everything else in the detector window
+ *   - round-trip latency: tone onsets in the capture minus the same
+ *     onsets in the playback stream, from linked start to capture
+ *
+ * A run takes about a second and ends with PASS/FAIL, replacing the
+ * "record five seconds, then decode or listen" flow of test-audio-hw.sh.
+ *
+ *   audio-loopback                                     # default PCMs, 182846
+ *   audio-loopback -P driver_speaker -C driver_mic -k 0,1 -j
+ *   audio-loopback -i /usr/share/board-scripts/dtmf-182846.wav -C pulse
+ *   audio-loopback -T 1000,3000 -s 30                  # tones instead of DTMF
+ *   audio-loopback -f capture.wav                      # decode a recording
+ *
+ * Onsets are found to a fraction of a detector hop: a tone that fills a
+ * fraction p of the window gives p times its full Goertzel amplitude, so
+ * each partially filled window yields an onset estimate. The detector
+ * bank runs four frequencies per NEON vector on AArch64; -S forces the
+ * scalar loop.
+ */
+
+#define _GNU_SOURCE
+#include <ctype.h>
+#include <errno.h>
+#include <getopt.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <alsa/asoundlib.h>
+
+#if defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+#include <wavfile.h>
+
+#define MAX_CHANNELS        8
+#define MAX_FREQS           16
+#define MAX_SYMBOLS         64
+#define DBFS_FLOOR          -120.0
+
+#define DEFAULT_DEVICE      "default"
+#define DEFAULT_RATE        48000
+#define DEFAULT_CHANNELS    2
+#define DEFAULT_DIGITS      "182846"
+#define DEFAULT_LEVEL       -12.0
+#define DEFAULT_TONE_MS     70
+#define DEFAULT_GAP_MS      50
+#define DEFAULT_LEAD_MS     100
+#define DEFAULT_MAX_LATENCY 300
+#define DEFAULT_MIN_SNR     20.0
+#define DEFAULT_MIN_LEVEL   -50.0
+#define PCM_LATENCY_US      40000
+
+// Detector geometry: 25 ms windows resolve the 73 Hz DTMF row spacing
+#define WINDOW_MS           25
+#define HOPS_PER_WINDOW     5
+#define MIN_RUN_HOPS        3
+#define RAMP_MS             2
+#define DETECT_FLOOR_DBFS   -60.0
+// Each tone of a symbol must be 6 dB above every other frequency
+#define DOMINANCE           2.0f
+
+typedef struct {
+    char name[8];
+    int lo;                     // index into freqs
+    int hi;                     // second tone for DTMF, -1 for a single tone
+} symbol_t;
+
+typedef struct {
+    float freqs[MAX_FREQS];     // padded to a multiple of 4
+    unsigned int n_freqs;
+    unsigned int n_real;
+    symbol_t symbols[MAX_SYMBOLS];
+    unsigned int n_symbols;
+    int expected[MAX_SYMBOLS];
+    unsigned int n_expected;
+    int dtmf;
+} plan_t;
+
+typedef struct {
+    int symbol;
+    size_t first_hop;
+    double onset;               // frames
+    double level_db;
+    double snr_db;
+} segment_t;
+
+typedef struct {
+    segment_t seg[MAX_SYMBOLS];
+    unsigned int n;
+} detection_t;
+
+typedef struct {
+    char decoded[MAX_SYMBOLS * 8];
+    int match;
+    double level_db;
+    double snr_db;
+    int have_latency;
+    double latency_ms;
+    double spread_ms;
+    int pass;
+} channel_result_t;
+
+static const float dtmf_rows[4] = { 697.0f, 770.0f, 852.0f, 941.0f };
+static const float dtmf_cols[4] = { 1209.0f, 1336.0f, 1477.0f, 1633.0f };
+static const char dtmf_keys[4][5] = { "123A", "456B", "789C", "*0#D" };
+
+static int use_scalar;
+static int verbose;
+
+static double to_db(double x) {
+    return x > 0 ? fmax(10.0 * log10(x), DBFS_FLOOR) : DBFS_FLOOR;
+}
+
+/* ---- Plan: what is played and what is expected back ---- */
+
+static int plan_dtmf(plan_t *plan, const char *digits) {
+    memset(plan, 0, sizeof(*plan));
+    plan->dtmf = 1;
+    for (unsigned int i = 0; i < 4; i++) {
+        plan->freqs[i] = dtmf_rows[i];
+        plan->freqs[4 + i] = dtmf_cols[i];
+    }
+    plan->n_freqs = plan->n_real = 8;
+    for (unsigned int r = 0; r < 4; r++) {
+        for (unsigned int c = 0; c < 4; c++) {
+            symbol_t *s = &plan->symbols[plan->n_symbols++];
+
+            s->name[0] = dtmf_keys[r][c];
+            s->lo = (int)r;
+            s->hi = 4 + (int)c;
+        }
+    }
+    for (const char *d = digits; *d; d++) {
+        int found = -1;
+
+        for (unsigned int s = 0; s < plan->n_symbols; s++) {
+            if (plan->symbols[s].name[0] == (char)toupper((unsigned char)*d)) {
+                found = (int)s;
+            }
+        }
+        if (found < 0 || plan->n_expected == MAX_SYMBOLS) {
+            fprintf(stderr, "audio-loopback: '%c' is not a DTMF key (or too many)\n", *d);
+            return -1;
+        }
+        plan->expected[plan->n_expected++] = found;
+    }
+    return plan->n_expected > 0 ? 0 : -1;
+}
+
+static int plan_tones(plan_t *plan, const char *list, unsigned int rate) {
+    char *copy = strdup(list);
+    char *save;
+
+    memset(plan, 0, sizeof(*plan));
+    for (char *t = strtok_r(copy, ",", &save); t != NULL; t = strtok_r(NULL, ",", &save)) {
+        double f = strtod(t, NULL);
+        int found = -1;
+
+        if (f < 50 || f >= rate / 2.0) {
+            fprintf(stderr, "audio-loopback: tone %s Hz is out of range\n", t);
+            free(copy);
+            return -1;
+        }
+        for (unsigned int i = 0; i < plan->n_real; i++) {
+            if (fabs(plan->freqs[i] - f) < 0.5) {
+                found = (int)i;
+            }
+        }
+        if (found < 0) {
+            if (plan->n_real == MAX_FREQS) {
+                fprintf(stderr, "audio-loopback: at most %d different tones\n", MAX_FREQS);
+                free(copy);
+                return -1;
+            }
+            found = (int)plan->n_real;
+            plan->freqs[plan->n_real] = (float)f;
+            snprintf(plan->symbols[found].name, sizeof(plan->symbols[found].name), "%.0f", f);
+            plan->symbols[found].lo = found;
+            plan->symbols[found].hi = -1;
+            plan->n_real++;
+            plan->n_symbols++;
+        }
+        if (plan->n_expected == MAX_SYMBOLS) {
+            break;
+        }
+        plan->expected[plan->n_expected++] = found;
+    }
+    free(copy);
+    // Pad the bank to whole vectors; the padding is never classified
+    plan->n_freqs = (plan->n_real + 3) & ~3u;
+    for (unsigned int i = plan->n_real; i < plan->n_freqs; i++) {
+        plan->freqs[i] = rate / 4.0f;
+    }
+    return plan->n_expected > 0 ? 0 : -1;
+}
+
+static void sequence_name(const plan_t *plan, const int *seq, unsigned int n, char *out, size_t size) {
+    size_t len = 0;
+
+    out[0] = '\0';
+    for (unsigned int i = 0; i < n && len < size; i++) {
+        len += (size_t)snprintf(out + len, size - len, "%s%s", !plan->dtmf && i ? "," : "",
+                                plan->symbols[seq[i]].name);
+    }
+}
+
+// Lead silence, then each symbol as a ramped tone burst followed by a gap
+static float *make_stimulus(const plan_t *plan, unsigned int rate, double level_db,
+                            unsigned int tone_ms, unsigned int gap_ms, size_t *frames) {
+    size_t lead = (size_t)DEFAULT_LEAD_MS * rate / 1000;
+    size_t tone = (size_t)tone_ms * rate / 1000;
+    size_t gap = (size_t)gap_ms * rate / 1000;
+    size_t ramp = (size_t)RAMP_MS * rate / 1000;
+    double peak = pow(10.0, level_db / 20.0);
+    float *x;
+
+    *frames = lead + plan->n_expected * (tone + gap);
+    x = calloc(*frames, sizeof(*x));
+    if (x == NULL) {
+        return NULL;
+    }
+    for (unsigned int i = 0; i < plan->n_expected; i++) {
+        const symbol_t *s = &plan->symbols[plan->expected[i]];
+        float *out = x + lead + i * (tone + gap);
+        double amp = s->hi >= 0 ? peak / 2 : peak;
+
+        for (size_t n = 0; n < tone; n++) {
+            double t = (double)n / rate;
+            double env = 1.0;
+            double v = sin(2 * M_PI * plan->freqs[s->lo] * t);
+
+            if (n < ramp) {
+                env = 0.5 - 0.5 * cos(M_PI * (double)n / ramp);
+            } else if (tone - n <= ramp) {
+                env = 0.5 - 0.5 * cos(M_PI * (double)(tone - n) / ramp);
+            }
+            if (s->hi >= 0) {
+                v += sin(2 * M_PI * plan->freqs[s->hi] * t);
+            }
+            out[n] = (float)(amp * env * v);
+        }
+    }
+    return x;
+}
+
+/* ---- WAV input ---- */
+
+// Channel `ch` of a WAV file as float; s16, s32 and float files
+static float *wav_channel(const wav_file_t *wav, unsigned int ch) {
+    float *x = malloc((wav->frames ? wav->frames : 1) * sizeof(*x));
+
+    if (x == NULL) {
+        return NULL;
+    }
+    for (uint64_t i = 0; i < wav->frames; i++) {
+        const uint8_t *p = wav->data + i * wav->frame_bytes + ch * wav->fmt.width;
+
+        if (wav->fmt.encoding == WAV_FLOAT) {
+            float v;
+
+            memcpy(&v, p, sizeof(v));
+            x[i] = v;
+        } else if (wav->fmt.width == 2) {
+            int16_t v;
+
+            memcpy(&v, p, sizeof(v));
+            x[i] = v / 32768.0f;
+        } else {
+            int32_t v;
+
+            memcpy(&v, p, sizeof(v));
+            x[i] = (float)(v / 2147483648.0);
+        }
+    }
+    return x;
+}
+
+static int wav_supported(const wav_file_t *wav) {
+    return (wav->fmt.encoding == WAV_PCM && (wav->fmt.width == 2 || wav->fmt.width == 4)) ||
+           (wav->fmt.encoding == WAV_FLOAT && wav->fmt.width == 4);
+}
+
+/* ---- Goertzel bank ---- */
+
+/*
+ * Power at every frequency of the bank over x[0..n): the squared
+ * magnitude of the DFT at that (not necessarily integer) bin.
+ */
+static void goertzel_scalar(const float *x, size_t n, const float *coeff, unsigned int nf,
+                            float *power) {
+    for (unsigned int f = 0; f < nf; f++) {
+        float s1 = 0;
+        float s2 = 0;
+
+        for (size_t i = 0; i < n; i++) {
+            float s0 = x[i] + coeff[f] * s1 - s2;
+
+            s2 = s1;
+            s1 = s0;
+        }
+        power[f] = s1 * s1 + s2 * s2 - coeff[f] * s1 * s2;
+    }
+}
+
+#if defined(__aarch64__)
+// Four frequencies per vector, two vectors in flight to hide the FMA latency
+static void goertzel_neon(const float *x, size_t n, const float *coeff, unsigned int nf,
+                          float *power) {
+    unsigned int f = 0;
+
+    for (; f + 8 <= nf; f += 8) {
+        float32x4_t c0 = vld1q_f32(coeff + f);
+        float32x4_t c1 = vld1q_f32(coeff + f + 4);
+        float32x4_t a1 = vdupq_n_f32(0);
+        float32x4_t a2 = vdupq_n_f32(0);
+        float32x4_t b1 = vdupq_n_f32(0);
+        float32x4_t b2 = vdupq_n_f32(0);
+
+        for (size_t i = 0; i < n; i++) {
+            float32x4_t xi = vdupq_n_f32(x[i]);
+            float32x4_t a0 = vfmaq_f32(vsubq_f32(xi, a2), c0, a1);
+            float32x4_t b0 = vfmaq_f32(vsubq_f32(xi, b2), c1, b1);
+
+            a2 = a1;
+            a1 = a0;
+            b2 = b1;
+            b1 = b0;
+        }
+        vst1q_f32(power + f, vsubq_f32(vfmaq_f32(vmulq_f32(a1, a1), a2, a2),
+                                       vmulq_f32(vmulq_f32(c0, a1), a2)));
+        vst1q_f32(power + f + 4, vsubq_f32(vfmaq_f32(vmulq_f32(b1, b1), b2, b2),
+                                           vmulq_f32(vmulq_f32(c1, b1), b2)));
+    }
+    for (; f < nf; f += 4) {
+        float32x4_t c = vld1q_f32(coeff + f);
+        float32x4_t s1 = vdupq_n_f32(0);
+        float32x4_t s2 = vdupq_n_f32(0);
+
+        for (size_t i = 0; i < n; i++) {
+            float32x4_t s0 = vfmaq_f32(vsubq_f32(vdupq_n_f32(x[i]), s2), c, s1);
+
+            s2 = s1;
+            s1 = s0;
+        }
+        vst1q_f32(power + f, vsubq_f32(vfmaq_f32(vmulq_f32(s1, s1), s2, s2),
+                                       vmulq_f32(vmulq_f32(c, s1), s2)));
+    }
+}
+#endif
+
+/* ---- Detection ---- */
+
+static int classify(const plan_t *plan, const float *amp, float floor_amp) {
+    int best = -1;
+    float best_score = 0;
+
+    for (unsigned int s = 0; s < plan->n_symbols; s++) {
+        const symbol_t *sym = &plan->symbols[s];
+        float score = sym->hi >= 0 ? fminf(amp[sym->lo], amp[sym->hi]) : amp[sym->lo];
+        int ok = score >= floor_amp && score > best_score;
+
+        for (unsigned int f = 0; ok && f < plan->n_real; f++) {
+            if ((int)f != sym->lo && (int)f != sym->hi && amp[f] * DOMINANCE > score) {
+                ok = 0;
+            }
+        }
+        if (ok) {
+            best = (int)s;
+            best_score = score;
+        }
+    }
+    return best;
+}
+
+// Sum of the amplitudes of a symbol's tones
+static float member_amp(const plan_t *plan, const float *amp, int symbol) {
+    const symbol_t *s = &plan->symbols[symbol];
+
+    return amp[s->lo] + (s->hi >= 0 ? amp[s->hi] : 0.0f);
+}
+
+/*
+ * Least-squares fit of the symbol's tones (a cosine and a sine each) to
+ * x[0..n). The Goertzel amplitudes are good enough to classify, but the
+ * other tone's sidelobes bias them by a few percent, which would cap the
+ * SNR at about 20 dB; the fit removes the tones exactly. Returns the
+ * fitted energy and stores the sum of the squared amplitudes in *sq.
+ */
+static double fit_tones(const float *x, size_t n, unsigned int rate, const symbol_t *s,
+                        const float *freqs, double *sq) {
+    double g[4][5] = { { 0 } };
+    double coef[4];
+    double w[2];
+    unsigned int k = s->hi >= 0 ? 4 : 2;
+    double energy = 0;
+
+    w[0] = 2 * M_PI * freqs[s->lo] / rate;
+    w[1] = s->hi >= 0 ? 2 * M_PI * freqs[s->hi] / rate : 0;
+    for (size_t i = 0; i < n; i++) {
+        double b[4] = { cos(w[0] * i), sin(w[0] * i), cos(w[1] * i), sin(w[1] * i) };
+
+        for (unsigned int r = 0; r < k; r++) {
+            for (unsigned int c = 0; c < k; c++) {
+                g[r][c] += b[r] * b[c];
+            }
+            g[r][4] += b[r] * x[i];
+        }
+    }
+
+    // Gaussian elimination on the (well conditioned) normal equations
+    for (unsigned int r = 0; r < k; r++) {
+        for (unsigned int q = r + 1; q < k; q++) {
+            double f = g[q][r] / g[r][r];
+
+            for (unsigned int c = r; c < 5; c++) {
+                g[q][c] -= f * g[r][c];
+            }
+        }
+    }
+    for (int r = (int)k - 1; r >= 0; r--) {
+        double v = g[r][4];
+
+        for (unsigned int c = (unsigned int)r + 1; c < k; c++) {
+            v -= g[r][c] * coef[c];
+        }
+        coef[r] = v / g[r][r];
+    }
+
+    *sq = 0;
+    for (unsigned int r = 0; r < k; r++) {
+        *sq += coef[r] * coef[r];
+    }
+    // Fitted energy: coef . (B^T x), from the untouched right-hand side
+    for (size_t i = 0; i < n; i++) {
+        double v = coef[0] * cos(w[0] * i) + coef[1] * sin(w[0] * i);
+
+        if (k == 4) {
+            v += coef[2] * cos(w[1] * i) + coef[3] * sin(w[1] * i);
+        }
+        energy += v * v;
+    }
+    return energy;
+}
+
+static void finish_segment(const plan_t *plan, const float *x, unsigned int rate,
+                           const float *amp, const double *energy, size_t n_hops, size_t win,
+                           size_t hop, int symbol, size_t first, size_t last, detection_t *det) {
+    const symbol_t *s = &plan->symbols[symbol];
+    unsigned int nf = plan->n_freqs;
+    segment_t *seg;
+    float full = 0;
+    double tone_e = 0;
+    double rest_e = 0;
+    double level = 0;
+    unsigned int plateau = 0;
+    double margin = (double)RAMP_MS * rate / 1000 + 1;
+    double onset_sum = 0;
+    double end_sum = 0;
+    unsigned int onsets = 0;
+    unsigned int ends = 0;
+    double onset;
+    double tone_end;
+    size_t mid;
+    size_t from;
+    size_t to;
+
+    if (det->n == MAX_SYMBOLS) {
+        return;
+    }
+    for (size_t h = first; h <= last; h++) {
+        full = fmaxf(full, member_amp(plan, amp + h * nf, symbol));
+    }
+
+    /*
+     * Onset and end from the windows the tone only partly fills: a
+     * window filled to fraction p shows p times the full amplitude.
+     */
+    mid = (first + last) / 2;
+    from = first > HOPS_PER_WINDOW ? first - HOPS_PER_WINDOW : 0;
+    to = last + HOPS_PER_WINDOW < n_hops ? last + HOPS_PER_WINDOW : n_hops - 1;
+    for (size_t h = from; h <= to; h++) {
+        double fill = member_amp(plan, amp + h * nf, symbol) / full;
+
+        if (fill < 0.15 || fill > 0.85) {
+            continue;
+        }
+        if (h < mid) {
+            onset_sum += (double)(h * hop) + (double)win * (1.0 - fill);
+            onsets++;
+        } else {
+            end_sum += (double)(h * hop) + (double)win * fill;
+            ends++;
+        }
+    }
+    onset = onsets ? onset_sum / onsets : (double)(first * hop);
+    tone_end = ends ? end_sum / ends : (double)(last * hop + win);
+
+    // Level and SNR over the windows wholly inside the tone, clear of its ramps
+    for (int pass = 0; pass < 2 && plateau == 0; pass++) {
+        for (size_t h = first; h <= last; h++) {
+            double start = (double)(h * hop);
+            double sq;
+            double e;
+
+            if (pass == 0 ? start < onset + margin || start + win > tone_end - margin
+                          : member_amp(plan, amp + h * nf, symbol) < 0.9f * full) {
+                continue;
+            }
+            e = fit_tones(x + h * hop, win, rate, s, plan->freqs, &sq);
+            level += sq;
+            tone_e += e;
+            rest_e += fmax(energy[h] - e, 0.0);
+            plateau++;
+        }
+    }
+
+    seg = &det->seg[det->n++];
+    seg->symbol = symbol;
+    seg->first_hop = first;
+    seg->onset = onset;
+    seg->level_db = to_db(plateau ? level / plateau : 0.0);
+    seg->snr_db = rest_e > 0 ? to_db(tone_e / rest_e) : -DBFS_FLOOR;
+}
+
+static int detect(const float *x, size_t frames, unsigned int rate, const plan_t *plan,
+                  detection_t *det) {
+    size_t win = (size_t)rate * WINDOW_MS / 1000;
+    size_t hop = win / HOPS_PER_WINDOW;
+    size_t n_hops = frames >= win ? (frames - win) / hop + 1 : 0;
+    unsigned int nf = plan->n_freqs;
+    float floor_amp = (float)pow(10.0, DETECT_FLOOR_DBFS / 20.0);
+    float coeff[MAX_FREQS];
+    float power[MAX_FREQS];
+    float *amp;
+    double *energy;
+    int run_symbol = -1;
+    size_t run_first = 0;
+    size_t last_end = 0;
+
+    det->n = 0;
+    amp = malloc((n_hops ? n_hops : 1) * nf * sizeof(*amp));
+    energy = malloc((n_hops ? n_hops : 1) * sizeof(*energy));
+    if (amp == NULL || energy == NULL) {
+        free(amp);
+        free(energy);
+        return -1;
+    }
+    for (unsigned int f = 0; f < nf; f++) {
+        coeff[f] = (float)(2.0 * cos(2.0 * M_PI * plan->freqs[f] / rate));
+    }
+
+    for (size_t h = 0; h < n_hops; h++) {
+        const float *w = x + h * hop;
+        double e = 0;
+
+#if defined(__aarch64__)
+        if (!use_scalar) {
+            goertzel_neon(w, win, coeff, nf, power);
+        } else
+#endif
+        {
+            goertzel_scalar(w, win, coeff, nf, power);
+        }
+        for (unsigned int f = 0; f < nf; f++) {
+            amp[h * nf + f] = 2.0f * sqrtf(fmaxf(power[f], 0.0f)) / (float)win;
+        }
+        for (size_t i = 0; i < win; i++) {
+            e += (double)w[i] * w[i];
+        }
+        energy[h] = e;
+    }
+
+    // Runs of hops with the same symbol; a dropout of a hop or two inside a
+    // tone (room reflections) does not split it
+    for (size_t h = 0; h <= n_hops; h++) {
+        int symbol = h < n_hops ? classify(plan, amp + h * nf, floor_amp) : -1;
+
+        if (symbol == run_symbol) {
+            continue;
+        }
+        if (run_symbol >= 0 && h - run_first >= MIN_RUN_HOPS) {
+            if (det->n > 0 && det->seg[det->n - 1].symbol == run_symbol &&
+                run_first - last_end <= 2) {
+                det->n--;
+                run_first = det->seg[det->n].first_hop;
+            }
+            finish_segment(plan, x, rate, amp, energy, n_hops, win, hop, run_symbol, run_first,
+                           h - 1, det);
+            last_end = h;
+        }
+        run_symbol = symbol;
+        run_first = h;
+    }
+
+    free(amp);
+    free(energy);
+    return 0;
+}
+
+static int compare_double(const void *a, const void *b) {
+    double x = *(const double *)a;
+    double y = *(const double *)b;
+
+    return (x > y) - (x < y);
+}
+
+static void evaluate(const plan_t *plan, const detection_t *ref, const detection_t *cap,
+                     unsigned int rate, double min_snr, double min_level, double max_latency_ms,
+                     channel_result_t *r) {
+    int decoded[MAX_SYMBOLS];
+    double lat[MAX_SYMBOLS];
+    double level = 0;
+
+    memset(r, 0, sizeof(*r));
+    r->snr_db = -DBFS_FLOOR;
+    for (unsigned int i = 0; i < cap->n; i++) {
+        decoded[i] = cap->seg[i].symbol;
+        level += cap->seg[i].level_db;
+        r->snr_db = fmin(r->snr_db, cap->seg[i].snr_db);
+    }
+    sequence_name(plan, decoded, cap->n, r->decoded, sizeof(r->decoded));
+    r->level_db = cap->n ? level / cap->n : DBFS_FLOOR;
+    if (cap->n == 0) {
+        r->snr_db = DBFS_FLOOR;
+    }
+
+    r->match = cap->n == plan->n_expected;
+    for (unsigned int i = 0; r->match && i < cap->n; i++) {
+        r->match = decoded[i] == plan->expected[i];
+    }
+    if (r->match && ref->n == cap->n) {
+        for (unsigned int i = 0; i < cap->n; i++) {
+            lat[i] = (cap->seg[i].onset - ref->seg[i].onset) * 1000.0 / rate;
+        }
+        qsort(lat, cap->n, sizeof(lat[0]), compare_double);
+        r->have_latency = 1;
+        r->latency_ms = lat[cap->n / 2];
+        r->spread_ms = lat[cap->n - 1] - lat[0];
+    }
+
+    r->pass = r->match && r->snr_db >= min_snr && r->level_db >= min_level &&
+              (!r->have_latency || r->latency_ms <= max_latency_ms);
+}
+
+/* ---- Full duplex ---- */
+
+static int pcm_setup(snd_pcm_t **pcm, const char *device, snd_pcm_stream_t stream,
+                     unsigned int channels, unsigned int rate, snd_pcm_uframes_t *buffer,
+                     snd_pcm_uframes_t *period) {
+    int err = snd_pcm_open(pcm, device, stream, 0);
+
+    if (err < 0) {
+        fprintf(stderr, "audio-loopback: %s: %s\n", device, snd_strerror(err));
+        return -1;
+    }
+    err = snd_pcm_set_params(*pcm, SND_PCM_FORMAT_S16_LE, SND_PCM_ACCESS_RW_INTERLEAVED, channels,
+                             rate, 1, PCM_LATENCY_US);
+    if (err >= 0) {
+        err = snd_pcm_get_params(*pcm, buffer, period);
+    }
+    if (err < 0) {
+        fprintf(stderr, "audio-loopback: %s: cannot %s %u ch %u Hz: %s\n", device,
+                stream == SND_PCM_STREAM_PLAYBACK ? "play" : "capture", channels, rate,
+                snd_strerror(err));
+        snd_pcm_close(*pcm);
+        return -1;
+    }
+    return 0;
+}
+
+/*
+ * Play ref[0..frames) on every playback channel while capturing the same
+ * number of frames. The playback buffer is filled before the capture
+ * starts; with the PCMs linked, filling it starts both on the same
+ * frame, so capture frame i and playback frame i share a start time.
+ */
+static int run_duplex(const char *play_dev, const char *cap_dev, unsigned int rate,
+                      unsigned int play_ch, unsigned int cap_ch, const float *ref, size_t frames,
+                      int16_t *captured, int *linked) {
+    snd_pcm_t *play = NULL;
+    snd_pcm_t *cap = NULL;
+    snd_pcm_uframes_t buffer;
+    snd_pcm_uframes_t period;
+    snd_pcm_uframes_t cap_buffer;
+    snd_pcm_uframes_t cap_period;
+    int16_t *out = NULL;
+    size_t played = 0;
+    size_t got = 0;
+    int rc = -1;
+
+    if (pcm_setup(&play, play_dev, SND_PCM_STREAM_PLAYBACK, play_ch, rate, &buffer, &period) != 0) {
+        return -1;
+    }
+    if (pcm_setup(&cap, cap_dev, SND_PCM_STREAM_CAPTURE, cap_ch, rate, &cap_buffer,
+                  &cap_period) != 0) {
+        snd_pcm_close(play);
+        return -1;
+    }
+    *linked = snd_pcm_link(cap, play) == 0;
+
+    out = malloc(buffer * play_ch * sizeof(*out));
+    if (out == NULL) {
+        goto done;
+    }
+
+    while (got < frames) {
+        snd_pcm_uframes_t chunk = played == 0 || cap_period > buffer ? buffer : cap_period;
+        snd_pcm_sframes_t n;
+
+        if (played < frames + buffer) {
+            for (size_t i = 0; i < chunk; i++) {
+                float v = played + i < frames ? ref[played + i] : 0.0f;
+                int16_t s = (int16_t)lrintf(fmaxf(fminf(v * 32767.0f, 32767.0f), -32768.0f));
+
+                for (unsigned int c = 0; c < play_ch; c++) {
+                    out[i * play_ch + c] = s;
+                }
+            }
+            n = snd_pcm_writei(play, out, chunk);
+            if (n < 0) {
+                fprintf(stderr, "audio-loopback: %s: %s during the test\n", play_dev,
+                        snd_strerror((int)n));
+                goto done;
+            }
+            played += (size_t)n;
+        }
+
+        n = snd_pcm_readi(cap, captured + got * cap_ch,
+                          frames - got < cap_period ? frames - got : cap_period);
+        if (n < 0) {
+            fprintf(stderr, "audio-loopback: %s: %s during the test\n", cap_dev,
+                    snd_strerror((int)n));
+            goto done;
+        }
+        got += (size_t)n;
+    }
+    rc = 0;
+
+done:
+    free(out);
+    if (*linked) {
+        snd_pcm_unlink(cap);
+    }
+    snd_pcm_drop(play);
+    snd_pcm_close(cap);
+    snd_pcm_close(play);
+    return rc;
+}
+
+/* ---- Report ---- */
+
+static void print_json(const plan_t *plan, unsigned int rate, int linked, int live,
+                       const channel_result_t *res, unsigned int channels, int pass) {
+    char expected[MAX_SYMBOLS * 8];
+
+    sequence_name(plan, plan->expected, plan->n_expected, expected, sizeof(expected));
+    printf("{\"pass\":%s,\"expected\":\"%s\",\"rate\":%u,\"linked\":%s,\"channels\":[",
+           pass ? "true" : "false", expected, rate, live && linked ? "true" : "false");
+    for (unsigned int c = 0; c < channels; c++) {
+        const channel_result_t *r = &res[c];
+
+        printf("%s{\"channel\":%u,\"decoded\":\"%s\",\"match\":%s,\"level_dbfs\":%.1f,"
+               "\"snr_db\":%.1f,", c ? "," : "", c, r->decoded, r->match ? "true" : "false",
+               r->level_db, r->snr_db);
+        if (r->have_latency) {
+            printf("\"latency_ms\":%.2f,\"latency_spread_ms\":%.2f,", r->latency_ms, r->spread_ms);
+        } else {
+            printf("\"latency_ms\":null,\"latency_spread_ms\":null,");
+        }
+        printf("\"pass\":%s}", r->pass ? "true" : "false");
+    }
+    printf("]}\n");
+}
+
+static void print_channel(unsigned int c, const channel_result_t *r, int checked) {
+    char latency[48] = "-";
+
+    if (r->have_latency) {
+        snprintf(latency, sizeof(latency), "%.2f ms (spread %.2f)", r->latency_ms, r->spread_ms);
+    }
+    printf("ch%u: %-16s level %6.1f dBFS  SNR %5.1f dB  latency %-24s %s\n", c,
+           r->decoded[0] ? r->decoded : "(nothing)", r->level_db, r->snr_db, latency,
+           !checked ? "(not checked)" : r->pass ? "PASS" : "FAIL");
+}
+
+static void print_usage(const char *prog) {
+    printf("Usage: %s [options]\n", prog);
+    printf("\n");
+    printf("Stimulus:\n");
+    printf("  -d, --digits KEYS     DTMF sequence (default %s)\n", DEFAULT_DIGITS);
+    printf("  -T, --tones HZ,...    Single tones instead of DTMF\n");
+    printf("  -i, --input FILE      Play a WAV file containing that sequence instead\n");
+    printf("  -l, --level DBFS      Generated peak level (default %.0f)\n", DEFAULT_LEVEL);
+    printf("  -t, --tone MS         Generated tone length (default %d)\n", DEFAULT_TONE_MS);
+    printf("  -g, --gap MS          Generated gap length (default %d)\n", DEFAULT_GAP_MS);
+    printf("\n");
+    printf("Audio:\n");
+    printf("  -P, --playback PCM    Playback device (default %s)\n", DEFAULT_DEVICE);
+    printf("  -C, --capture PCM     Capture device (default %s)\n", DEFAULT_DEVICE);
+    printf("  -r, --rate HZ         Sample rate (default %d, or the -i file's)\n", DEFAULT_RATE);
+    printf("  -p, --play-channels N Playback channels, all carry the stimulus (default %d)\n",
+           DEFAULT_CHANNELS);
+    printf("  -c, --channels N      Capture channels, 1-%d (default %d)\n", MAX_CHANNELS,
+           DEFAULT_CHANNELS);
+    printf("  -f, --file FILE       Decode a recording instead; latency is then measured\n");
+    printf("                        from the first frame of the file\n");
+    printf("\n");
+    printf("Pass criteria (per checked channel, plus the decoded sequence):\n");
+    printf("  -k, --check LIST      Capture channels that must pass (default all)\n");
+    printf("  -s, --min-snr DB      Worst tone SNR (default %.0f)\n", DEFAULT_MIN_SNR);
+    printf("  -m, --min-level DBFS  Mean tone level (default %.0f)\n", DEFAULT_MIN_LEVEL);
+    printf("  -L, --max-latency MS  Round trip, also the capture tail (default %d)\n",
+           DEFAULT_MAX_LATENCY);
+    printf("\n");
+    printf("  -j, --json            Print the result as one JSON line\n");
+    printf("  -S, --scalar          Use the scalar detectors\n");
+    printf("  -v, --verbose         Print every detected tone\n");
+    printf("  -h, --help            Show this help\n");
+    printf("\n");
+    printf("Exit status: 0 pass, 1 fail, 2 error.\n");
+}
+
+int main(int argc, char *argv[]) {
+    static const struct option long_opts[] = {
+        { "digits", required_argument, NULL, 'd' },
+        { "tones", required_argument, NULL, 'T' },
+        { "input", required_argument, NULL, 'i' },
+        { "level", required_argument, NULL, 'l' },
+        { "tone", required_argument, NULL, 't' },
+        { "gap", required_argument, NULL, 'g' },
+        { "playback", required_argument, NULL, 'P' },
+        { "capture", required_argument, NULL, 'C' },
+        { "rate", required_argument, NULL, 'r' },
+        { "play-channels", required_argument, NULL, 'p' },
+        { "channels", required_argument, NULL, 'c' },
+        { "file", required_argument, NULL, 'f' },
+        { "check", required_argument, NULL, 'k' },
+        { "min-snr", required_argument, NULL, 's' },
+        { "min-level", required_argument, NULL, 'm' },
+        { "max-latency", required_argument, NULL, 'L' },
+        { "json", no_argument, NULL, 'j' },
+        { "scalar", no_argument, NULL, 'S' },
+        { "verbose", no_argument, NULL, 'v' },
+        { "help", no_argument, NULL, 'h' },
+        { NULL, 0, NULL, 0 }
+    };
+    const char *digits = DEFAULT_DIGITS;
+    const char *tones = NULL;
+    const char *input = NULL;
+    const char *recording = NULL;
+    const char *play_dev = DEFAULT_DEVICE;
+    const char *cap_dev = DEFAULT_DEVICE;
+    const char *check = NULL;
+    double level_db = DEFAULT_LEVEL;
+    double min_snr = DEFAULT_MIN_SNR;
+    double min_level = DEFAULT_MIN_LEVEL;
+    unsigned int max_latency = DEFAULT_MAX_LATENCY;
+    unsigned int tone_ms = DEFAULT_TONE_MS;
+    unsigned int gap_ms = DEFAULT_GAP_MS;
+    unsigned int rate = 0;
+    unsigned int play_ch = DEFAULT_CHANNELS;
+    unsigned int cap_ch = DEFAULT_CHANNELS;
+    int checked[MAX_CHANNELS];
+    int json = 0;
+    int linked = 0;
+    int pass = 1;
+    int rc = 2;
+    plan_t plan;
+    detection_t ref_det;
+    detection_t cap_det;
+    channel_result_t res[MAX_CHANNELS];
+    float *stimulus = NULL;
+    float *ref = NULL;
+    float *chan = NULL;
+    int16_t *captured = NULL;
+    size_t stim_frames = 0;
+    size_t frames = 0;
+    wav_file_t rec;
+    int have_rec = 0;
+    int opt;
+
+    while ((opt = getopt_long(argc, argv, "d:T:i:l:t:g:P:C:r:p:c:f:k:s:m:L:jSvh", long_opts,
+                              NULL)) != -1) {
+        switch (opt) {
+        case 'd':
+            digits = optarg;
+            break;
+        case 'T':
+            tones = optarg;
+            break;
+        case 'i':
+            input = optarg;
+            break;
+        case 'l':
+            level_db = strtod(optarg, NULL);
+            break;
+        case 't':
+            tone_ms = (unsigned int)strtoul(optarg, NULL, 10);
+            break;
+        case 'g':
+            gap_ms = (unsigned int)strtoul(optarg, NULL, 10);
+            break;
+        case 'P':
+            play_dev = optarg;
+            break;
+        case 'C':
+            cap_dev = optarg;
+            break;
+        case 'r':
+            rate = (unsigned int)strtoul(optarg, NULL, 10);
+            break;
+        case 'p':
+            play_ch = (unsigned int)strtoul(optarg, NULL, 10);
+            break;
+        case 'c':
+            cap_ch = (unsigned int)strtoul(optarg, NULL, 10);
+            break;
+        case 'f':
+            recording = optarg;
+            break;
+        case 'k':
+            check = optarg;
+            break;
+        case 's':
+            min_snr = strtod(optarg, NULL);
+            break;
+        case 'm':
+            min_level = strtod(optarg, NULL);
+            break;
+        case 'L':
+            max_latency = (unsigned int)strtoul(optarg, NULL, 10);
+            break;
+        case 'j':
+            json = 1;
+            break;
+        case 'S':
+            use_scalar = 1;
+            break;
+        case 'v':
+            verbose = 1;
+            break;
+        case 'h':
+            print_usage(argv[0]);
+            return 0;
+        default:
+            print_usage(argv[0]);
+            return 2;
+        }
+    }
+    if (play_ch == 0 || cap_ch == 0 || cap_ch > MAX_CHANNELS || tone_ms < 2 * WINDOW_MS ||
+        gap_ms < WINDOW_MS || level_db > 0) {
+        fprintf(stderr, "audio-loopback: need 1-%d channels, tones of at least %d ms, gaps of "
+                "at least %d ms and a level at or below 0 dBFS\n", MAX_CHANNELS, 2 * WINDOW_MS,
+                WINDOW_MS);
+        return 2;
+    }
+
+    if (recording != NULL) {
+        const char *error = NULL;
+
+        if (wav_open(&rec, recording, &error) != 0) {
+            fprintf(stderr, "audio-loopback: %s: %s\n", recording, error);
+            return 2;
+        }
+        have_rec = 1;
+        if (!wav_supported(&rec) || rec.fmt.channels > MAX_CHANNELS) {
+            fprintf(stderr, "audio-loopback: %s: %s with %u channels is not supported\n",
+                    recording, wav_format_name(&rec.fmt), rec.fmt.channels);
+            goto out;
+        }
+        cap_ch = rec.fmt.channels;
+        if (rate == 0) {
+            rate = rec.fmt.rate;
+        }
+    }
+
+    // The stimulus, generated or from -i
+    if (input != NULL) {
+        const char *error = NULL;
+        wav_file_t in;
+
+        if (wav_open(&in, input, &error) != 0) {
+            fprintf(stderr, "audio-loopback: %s: %s\n", input, error);
+            goto out;
+        }
+        if (!wav_supported(&in)) {
+            fprintf(stderr, "audio-loopback: %s: %s is not supported\n", input,
+                    wav_format_name(&in.fmt));
+            wav_close(&in);
+            goto out;
+        }
+        if (rate == 0) {
+            rate = in.fmt.rate;
+        }
+        if (in.fmt.rate != rate) {
+            fprintf(stderr, "audio-loopback: %s is %u Hz, not %u\n", input, in.fmt.rate, rate);
+            wav_close(&in);
+            goto out;
+        }
+        stim_frames = in.frames;
+        stimulus = wav_channel(&in, 0);
+        wav_close(&in);
+    }
+    if (rate == 0) {
+        rate = DEFAULT_RATE;
+    }
+    if ((tones != NULL ? plan_tones(&plan, tones, rate) : plan_dtmf(&plan, digits)) != 0) {
+        goto out;
+    }
+    if (input == NULL) {
+        stimulus = make_stimulus(&plan, rate, level_db, tone_ms, gap_ms, &stim_frames);
+    }
+    if (stimulus == NULL) {
+        goto out;
+    }
+
+    for (unsigned int c = 0; c < MAX_CHANNELS; c++) {
+        checked[c] = check == NULL;
+    }
+    if (check != NULL) {
+        char *copy = strdup(check);
+        char *save;
+
+        for (char *t = strtok_r(copy, ",", &save); t != NULL; t = strtok_r(NULL, ",", &save)) {
+            unsigned long c = strtoul(t, NULL, 10);
+
+            if (c >= cap_ch) {
+                fprintf(stderr, "audio-loopback: channel %lu is not captured\n", c);
+                free(copy);
+                goto out;
+            }
+            checked[c] = 1;
+        }
+        free(copy);
+    }
+
+    // Playback timeline: stimulus, then a tail for the round trip
+    frames = recording != NULL ? rec.frames
+                               : stim_frames + ((size_t)max_latency + WINDOW_MS) * rate / 1000;
+    ref = calloc(frames ? frames : 1, sizeof(*ref));
+    if (ref == NULL) {
+        goto out;
+    }
+    memcpy(ref, stimulus, (stim_frames < frames ? stim_frames : frames) * sizeof(*ref));
+    if (detect(ref, frames, rate, &plan, &ref_det) != 0) {
+        goto out;
+    }
+    if (ref_det.n != plan.n_expected) {
+        fprintf(stderr, "audio-loopback: the stimulus does not decode to the expected "
+                "sequence (%u of %u tones found)\n", ref_det.n, plan.n_expected);
+        goto out;
+    }
+
+    if (recording == NULL) {
+        captured = calloc(frames * cap_ch, sizeof(*captured));
+        if (captured == NULL) {
+            goto out;
+        }
+        if (run_duplex(play_dev, cap_dev, rate, play_ch, cap_ch, ref, frames, captured,
+                       &linked) != 0) {
+            goto out;
+        }
+    }
+
+    if (!json) {
+        char expected[MAX_SYMBOLS * 8];
+
+        sequence_name(&plan, plan.expected, plan.n_expected, expected, sizeof(expected));
+        if (recording != NULL) {
+            printf("audio-loopback: %s in %s, %u Hz, %u channels\n", expected, recording, rate,
+                   cap_ch);
+        } else {
+            printf("audio-loopback: %s, %u Hz, %s -> %s%s\n", expected, rate, play_dev, cap_dev,
+                   linked ? " (linked)" : " (not linked: latency includes start skew)");
+        }
+    }
+
+    chan = malloc(frames * sizeof(*chan));
+    if (chan == NULL) {
+        goto out;
+    }
+    for (unsigned int c = 0; c < cap_ch; c++) {
+        if (recording != NULL) {
+            float *x = wav_channel(&rec, c);
+
+            if (x == NULL) {
+                goto out;
+            }
+            memcpy(chan, x, frames * sizeof(*chan));
+            free(x);
+        } else {
+            for (size_t i = 0; i < frames; i++) {
+                chan[i] = captured[i * cap_ch + c] / 32768.0f;
+            }
+        }
+        if (detect(chan, frames, rate, &plan, &cap_det) != 0) {
+            goto out;
+        }
+        evaluate(&plan, &ref_det, &cap_det, rate, min_snr, min_level, max_latency, &res[c]);
+        if (checked[c] && !res[c].pass) {
+            pass = 0;
+        }
+
+        if (verbose && !json) {
+            for (unsigned int i = 0; i < cap_det.n; i++) {
+                const segment_t *s = &cap_det.seg[i];
+
+                printf("  ch%u %-5s at %8.2f ms  level %6.1f dBFS  SNR %5.1f dB\n", c,
+                       plan.symbols[s->symbol].name, s->onset * 1000.0 / rate, s->level_db,
+                       s->snr_db);
+            }
+        }
+        if (!json) {
+            print_channel(c, &res[c], checked[c]);
+        }
+    }
+
+    if (json) {
+        print_json(&plan, rate, linked, recording == NULL, res, cap_ch, pass);
+    } else {
+        printf("%s\n", pass ? "PASS" : "FAIL");
+    }
+    rc = pass ? 0 : 1;
+
+out:
+    if (have_rec) {
+        wav_close(&rec);
+    }
+    free(chan);
+    free(captured);
+    free(ref);
+    free(stimulus);
+    return rc;
+}
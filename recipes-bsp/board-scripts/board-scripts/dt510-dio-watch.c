@@ -0,0 +1,1115 @@
+/* SPDX-License-Identifier: MIT */
+/*
+ * dt510-dio-watch - event-driven DT510 digital input watcher
+ *
+ * Native replacement for the gpioget loop in dt510-dio-poll-inputs. The
+ * cab buttons on the DI header (DI1 call-request, DI2 emergency, DI3
+ * PTT, DI4 spare) are requested from gpiochip0 with edge detection on
+ * both edges, and the process sleeps in poll() on the line-request fds
+ * until the kernel queues an edge. Every edge carries the timestamp the
+ * GPIO interrupt handler took, so a pulse of any length is seen and
+ * press durations are measured from the edges rather than from when
+ * userspace got round to looking.
+ *
+ * Debouncing is leading-edge: the first edge that changes a line's level
+ * is reported at once, then edges on that line are only counted for the
+ * debounce window, after which the line is read back and a final change
+ * reported if the contacts settled the other way. A clean press costs no
+ * latency; a pulse shorter than the window is reported as a press and a
+ * release with its measured duration. The kernel's own debounce
+ * (debounce-period-us) is not used: gpiolib emulates it on i.MX by
+ * delaying every edge by the full period.
+ *
+ * Debounced changes go out as one JSON line each to stdout (-j) and to
+ * Unix-socket clients (-S); a client gets a state line with every input's
+ * level as soon as it connects. Releases carry the press duration, and
+ * every event the time from the kernel edge to the moment it was written
+ * (latency_us, same clock as ts_ns):
+ *
+ *   {"event":"release","di":2,"line":"emergency","offset":1,"value":0,
+ *    "ts_ns":...,"clock":"monotonic","seqno":12,"latency_us":38.2,
+ *    "duration_ms":412.6,"bounces":3,"dropped":0}
+ *
+ * bounces and dropped count the edges swallowed by the debounce window and
+ * lost to a full kernel event FIFO on that line since its previous event.
+ *
+ * Values are the libgpiod logical level with the DTS line flags, as
+ * gpioget and vix-apps dt510_gpio.py (active_low=False) read them: 1 is
+ * ACTIVE, i.e. pressed. Lines another consumer holds (NDTR owns DI1/DI2,
+ * AVM owns DI3) are reported busy with that consumer and not watched.
+ *
+ *   dt510-dio-watch                             # one state line per change
+ *   dt510-dio-watch --once                      # dt510-dio-poll-inputs --once
+ *   dt510-dio-watch -q -R 60 -S /run/dt510-dio/dio.sock
+ *   dt510-dio-watch -B 500                      # latency on the DO-DI fixture
+ *
+ * -B toggles DO1-DO4 (offsets 6-9) on the production-test loopback
+ * fixture and measures each edge from the DO write to the kernel
+ * timestamp, to the watcher writing it and to a socket client reading it.
+ * It uses the watcher listening on -S if there is one, so it measures the
+ * service as configured; otherwise it starts its own.
+ */
+
+#define _GNU_SOURCE
+#include <errno.h>
+#include <getopt.h>
+#include <poll.h>
+#include <sched.h>
+#include <signal.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+
+#include <gpiod.h>
+
+#define DEFAULT_CHIP        "gpiochip0"
+#define DEFAULT_SOCKET      "/run/dt510-dio/dio.sock"
+#define DEFAULT_DEBOUNCE_MS 20
+#define CONSUMER            "dt510-dio-watch"
+
+#define NUM_INPUTS          4
+#define MAX_CLIENTS         8
+#define EVENT_BUFFER        64
+#define LINE_LEN            512
+
+// -B: how long an edge may take to reach the client before it counts as missed
+#define BENCH_TIMEOUT_MS    250
+#define BENCH_CONNECT_MS    2000
+
+typedef struct {
+    unsigned int di;
+    const char *name;
+    unsigned int offset;
+    unsigned int loopback;      // DO offset wired to this DI on the test fixture
+} input_def_t;
+
+// imx8mm-jaguar-dt510.dts &gpio1 gpio-line-names
+static const input_def_t input_defs[NUM_INPUTS] = {
+    { 1, "call-request", 0, 6 },
+    { 2, "emergency", 1, 7 },
+    { 3, "ptt", 4, 8 },
+    { 4, "dio-input-4", 5, 9 },
+};
+
+typedef struct {
+    const input_def_t *def;
+    struct gpiod_line_request *req;     // NULL when busy or unavailable
+    char consumer[32];
+    int value;                          // debounced level, -1 unknown
+    int edge_value;                     // level of the most recent kernel edge
+    uint64_t edge_ns;
+    uint64_t press_ns;                  // kernel time of the debounced press, 0 if released
+    unsigned long line_seqno;
+    double settle_at;                   // monotonic seconds; 0 when no window is open
+    unsigned int bounces;
+    unsigned int dropped;
+} input_t;
+
+typedef struct {
+    const char *chip_path;
+    input_t in[NUM_INPUTS];
+    struct gpiod_edge_event_buffer *events;
+    enum gpiod_line_clock event_clock;
+    clockid_t clock_id;                 // -1 for HTE: not comparable with a system clock
+    const char *clock_name;
+    unsigned int debounce_ms;
+    int active_low;
+    int json;
+    int quiet;
+    int listen_fd;
+    const char *socket_path;
+    int clients[MAX_CLIENTS];
+} watch_t;
+
+static volatile sig_atomic_t stop;
+static int verbose;
+
+static void on_signal(int sig) {
+    (void)sig;
+    stop = 1;
+}
+
+static double mono_s(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static uint64_t clock_ns(clockid_t id) {
+    struct timespec ts;
+
+    clock_gettime(id, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+/* ---- Lines ---- */
+
+static struct gpiod_chip *chip_open(const char *name) {
+    char path[64];
+    struct gpiod_chip *chip;
+
+    if (strchr(name, '/') != NULL) {
+        snprintf(path, sizeof(path), "%s", name);
+    } else {
+        snprintf(path, sizeof(path), "/dev/%s", name);
+    }
+    chip = gpiod_chip_open(path);
+    if (chip == NULL) {
+        fprintf(stderr, "dt510-dio-watch: %s: %s\n", path, strerror(errno));
+    }
+    return chip;
+}
+
+// One request per line, so a line another process holds costs only that line
+static struct gpiod_line_request *line_request(struct gpiod_chip *chip, unsigned int offset,
+                                               enum gpiod_line_direction dir, int edges,
+                                               enum gpiod_line_clock event_clock, int active_low,
+                                               int value) {
+    struct gpiod_line_settings *settings = gpiod_line_settings_new();
+    struct gpiod_line_config *line_cfg = gpiod_line_config_new();
+    struct gpiod_request_config *req_cfg = gpiod_request_config_new();
+    struct gpiod_line_request *req = NULL;
+    int err = ENOMEM;
+
+    if (settings != NULL && line_cfg != NULL && req_cfg != NULL) {
+        gpiod_line_settings_set_direction(settings, dir);
+        gpiod_line_settings_set_active_low(settings, active_low);
+        if (dir == GPIOD_LINE_DIRECTION_OUTPUT) {
+            gpiod_line_settings_set_output_value(settings, value ? GPIOD_LINE_VALUE_ACTIVE
+                                                                 : GPIOD_LINE_VALUE_INACTIVE);
+        }
+        if (edges) {
+            gpiod_line_settings_set_edge_detection(settings, GPIOD_LINE_EDGE_BOTH);
+            gpiod_line_settings_set_event_clock(settings, event_clock);
+        }
+        gpiod_request_config_set_consumer(req_cfg, CONSUMER);
+        gpiod_request_config_set_event_buffer_size(req_cfg, EVENT_BUFFER);
+        if (gpiod_line_config_add_line_settings(line_cfg, &offset, 1, settings) == 0) {
+            req = gpiod_chip_request_lines(chip, req_cfg, line_cfg);
+        }
+        err = errno;
+    }
+    gpiod_request_config_free(req_cfg);
+    gpiod_line_config_free(line_cfg);
+    gpiod_line_settings_free(settings);
+    errno = err;
+    return req;
+}
+
+static void line_consumer(struct gpiod_chip *chip, unsigned int offset, char *out, size_t size) {
+    struct gpiod_line_info *info = gpiod_chip_get_line_info(chip, offset);
+    const char *consumer = info ? gpiod_line_info_get_consumer(info) : NULL;
+
+    snprintf(out, size, "%s", consumer ? consumer : "unknown");
+    gpiod_line_info_free(info);
+}
+
+static int line_value(struct gpiod_line_request *req, unsigned int offset) {
+    enum gpiod_line_value v = gpiod_line_request_get_value(req, offset);
+
+    return v == GPIOD_LINE_VALUE_ERROR ? -1 : v == GPIOD_LINE_VALUE_ACTIVE;
+}
+
+/* ---- Output ---- */
+
+static const char *value_str(int value) {
+    return value < 0 ? "?" : value ? "1" : "0";
+}
+
+// Same columns as dt510-dio-poll-inputs, so production-test.sh parses either
+static void print_header(const char *chip, const char *source) {
+    printf("# DT510 GPIO inputs (%s offsets", chip);
+    for (unsigned int i = 0; i < NUM_INPUTS; i++) {
+        printf(" %u", input_defs[i].offset);
+    }
+    printf(") — libgpiod %s (0=inactive 1=active); see BSP § Cab buttons\n", source);
+}
+
+static void print_levels(const int *values, const char *suffix) {
+    struct timespec ts;
+    struct tm tm;
+    char stamp[32];
+
+    clock_gettime(CLOCK_REALTIME, &ts);
+    localtime_r(&ts.tv_sec, &tm);
+    strftime(stamp, sizeof(stamp), "%Y-%m-%d %H:%M:%S", &tm);
+    printf("%s.%03ld", stamp, ts.tv_nsec / 1000000);
+    for (unsigned int i = 0; i < NUM_INPUTS; i++) {
+        printf("  DI%u(%s)=%s", input_defs[i].di, input_defs[i].name, value_str(values[i]));
+    }
+    printf("%s\n", suffix);
+    fflush(stdout);
+}
+
+static size_t state_json(const watch_t *w, char *out, size_t size) {
+    size_t len;
+
+    len = (size_t)snprintf(out, size,
+                           "{\"event\":\"state\",\"ts_ns\":%llu,\"clock\":\"%s\",\"debounce_ms\":%u,"
+                           "\"inputs\":[",
+                           (unsigned long long)(w->clock_id >= 0 ? clock_ns(w->clock_id) : 0),
+                           w->clock_name, w->debounce_ms);
+    for (unsigned int i = 0; i < NUM_INPUTS && len < size; i++) {
+        const input_t *in = &w->in[i];
+        const char *v = in->req != NULL && in->value >= 0 ? value_str(in->value) : "null";
+        len += (size_t)snprintf(out + len, size - len,
+                                "%s{\"di\":%u,\"line\":\"%s\",\"offset\":%u,\"value\":%s,"
+                                "\"busy\":%s,\"consumer\":\"%s\"}",
+                                i ? "," : "", in->def->di, in->def->name, in->def->offset, v,
+                                in->req ? "false" : "true", in->req ? CONSUMER : in->consumer);
+    }
+    if (len < size) {
+        len += (size_t)snprintf(out + len, size - len, "]}\n");
+    }
+    return len < size ? len : 0;
+}
+
+/* ---- Socket ---- */
+
+static int watch_listen(watch_t *w, const char *path) {
+    struct sockaddr_un addr;
+
+    if (strlen(path) >= sizeof(addr.sun_path)) {
+        fprintf(stderr, "dt510-dio-watch: socket path too long\n");
+        return -1;
+    }
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, path);
+
+    w->listen_fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (w->listen_fd < 0) {
+        perror("dt510-dio-watch: socket");
+        return -1;
+    }
+    unlink(path);
+    if (bind(w->listen_fd, (struct sockaddr *)&addr, sizeof(addr)) != 0 ||
+        listen(w->listen_fd, MAX_CLIENTS) != 0) {
+        fprintf(stderr, "dt510-dio-watch: %s: %s\n", path, strerror(errno));
+        close(w->listen_fd);
+        w->listen_fd = -1;
+        return -1;
+    }
+    w->socket_path = path;
+    return 0;
+}
+
+static void client_drop(watch_t *w, unsigned int i) {
+    close(w->clients[i]);
+    w->clients[i] = -1;
+}
+
+// New clients get the state of every input straight away
+static void watch_accept(watch_t *w) {
+    char line[LINE_LEN];
+    size_t len;
+    int fd;
+
+    while ((fd = accept4(w->listen_fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC)) >= 0) {
+        unsigned int i;
+
+        for (i = 0; i < MAX_CLIENTS && w->clients[i] >= 0; i++) {
+        }
+        if (i == MAX_CLIENTS) {
+            close(fd);
+            continue;
+        }
+        w->clients[i] = fd;
+        len = state_json(w, line, sizeof(line));
+        if (len == 0 || send(fd, line, len, MSG_NOSIGNAL) != (ssize_t)len) {
+            client_drop(w, i);
+        }
+    }
+}
+
+// Clients have nothing to say; this only notices them hanging up
+static void client_read(watch_t *w, unsigned int i) {
+    char buf[256];
+    ssize_t n;
+
+    while ((n = recv(w->clients[i], buf, sizeof(buf), 0)) > 0) {
+    }
+    if (n == 0 || errno != EAGAIN) {
+        client_drop(w, i);
+    }
+}
+
+/* ---- Events ---- */
+
+static void emit(watch_t *w, input_t *in, int value, uint64_t ts_ns, unsigned long seqno) {
+    char line[LINE_LEN];
+    char latency[24];
+    char duration[32] = "";
+    double held_ms = -1;
+    size_t len;
+
+    in->value = value;
+    if (value && !in->press_ns) {
+        in->press_ns = ts_ns;
+    } else if (!value && in->press_ns) {
+        held_ms = (double)(ts_ns - in->press_ns) / 1e6;
+        snprintf(duration, sizeof(duration), ",\"duration_ms\":%.1f", held_ms);
+        in->press_ns = 0;
+    }
+
+    // Taken last, so it covers everything up to the write below
+    if (w->clock_id >= 0) {
+        snprintf(latency, sizeof(latency), "%.1f", (double)(clock_ns(w->clock_id) - ts_ns) / 1e3);
+    } else {
+        snprintf(latency, sizeof(latency), "null");
+    }
+    len = (size_t)snprintf(line, sizeof(line),
+                           "{\"event\":\"%s\",\"di\":%u,\"line\":\"%s\",\"offset\":%u,\"value\":%d,"
+                           "\"ts_ns\":%llu,\"clock\":\"%s\",\"seqno\":%lu,\"latency_us\":%s%s,"
+                           "\"bounces\":%u,\"dropped\":%u}\n",
+                           value ? "press" : "release", in->def->di, in->def->name, in->def->offset,
+                           value, (unsigned long long)ts_ns, w->clock_name, seqno, latency, duration,
+                           in->bounces, in->dropped);
+    in->bounces = 0;
+    if (len >= sizeof(line)) {
+        return;
+    }
+
+    // A client that cannot take one line is not reading; drop it rather than block
+    for (unsigned int i = 0; i < MAX_CLIENTS; i++) {
+        if (w->clients[i] >= 0 && send(w->clients[i], line, len, MSG_NOSIGNAL) != (ssize_t)len) {
+            client_drop(w, i);
+        }
+    }
+
+    if (w->quiet) {
+        return;
+    }
+    if (w->json) {
+        fwrite(line, 1, len, stdout);
+        fflush(stdout);
+    } else {
+        int values[NUM_INPUTS];
+        char suffix[64];
+
+        for (unsigned int i = 0; i < NUM_INPUTS; i++) {
+            values[i] = w->in[i].req ? w->in[i].value : -1;
+        }
+        if (held_ms >= 0) {
+            snprintf(suffix, sizeof(suffix), "  <- DI%u released after %.3f s", in->def->di,
+                     held_ms / 1e3);
+        } else {
+            snprintf(suffix, sizeof(suffix), "  <- DI%u %s", in->def->di,
+                     value ? "pressed" : "released");
+        }
+        print_levels(values, suffix);
+    }
+}
+
+static void handle_edge(watch_t *w, input_t *in, struct gpiod_edge_event *ev, double now) {
+    int value = gpiod_edge_event_get_event_type(ev) == GPIOD_EDGE_EVENT_RISING_EDGE;
+    uint64_t ts_ns = gpiod_edge_event_get_timestamp_ns(ev);
+    unsigned long seqno = gpiod_edge_event_get_line_seqno(ev);
+
+    // The kernel FIFO overflowed: trust nothing until the line is read back
+    if (in->line_seqno && seqno != in->line_seqno + 1) {
+        in->dropped += (unsigned int)(seqno - in->line_seqno - 1);
+        if (in->settle_at == 0) {
+            in->settle_at = now + w->debounce_ms / 1e3;
+        }
+    }
+    in->line_seqno = seqno;
+    in->edge_value = value;
+    in->edge_ns = ts_ns;
+
+    if (in->settle_at != 0 || value == in->value) {
+        in->bounces++;
+        return;
+    }
+    emit(w, in, value, ts_ns, seqno);
+    if (w->debounce_ms) {
+        in->settle_at = now + w->debounce_ms / 1e3;
+    }
+}
+
+// End of a debounce window: report where the contacts came to rest
+static void settle(watch_t *w, input_t *in, double now) {
+    int value = line_value(in->req, in->def->offset);
+    uint64_t ts_ns;
+
+    in->settle_at = 0;
+    if (value < 0) {
+        value = in->edge_value;
+    }
+    if (value == in->value) {
+        return;
+    }
+    // The last edge is when it got there, unless events were lost on the way
+    ts_ns = in->edge_value == value || w->clock_id < 0 ? in->edge_ns : clock_ns(w->clock_id);
+    emit(w, in, value, ts_ns, in->line_seqno);
+    if (w->debounce_ms) {
+        in->settle_at = now + w->debounce_ms / 1e3;
+    }
+}
+
+static int watch_open(watch_t *w, struct gpiod_chip *chip) {
+    unsigned int watched = 0;
+
+    for (unsigned int i = 0; i < NUM_INPUTS; i++) {
+        input_t *in = &w->in[i];
+
+        in->def = &input_defs[i];
+        in->value = -1;
+        in->req = line_request(chip, in->def->offset, GPIOD_LINE_DIRECTION_INPUT, 1, w->event_clock,
+                               w->active_low, 0);
+        if (in->req == NULL) {
+            if (errno == EBUSY) {
+                line_consumer(chip, in->def->offset, in->consumer, sizeof(in->consumer));
+                fprintf(stderr, "dt510-dio-watch: DI%u %s: busy (held by %s), not watched\n",
+                        in->def->di, in->def->name, in->consumer);
+            } else {
+                snprintf(in->consumer, sizeof(in->consumer), "error");
+                fprintf(stderr, "dt510-dio-watch: DI%u %s: %s\n", in->def->di, in->def->name,
+                        strerror(errno));
+            }
+            continue;
+        }
+        in->value = line_value(in->req, in->def->offset);
+        in->edge_value = in->value;
+        watched++;
+    }
+    if (watched == 0) {
+        fprintf(stderr, "dt510-dio-watch: no DI line could be requested\n");
+        return -1;
+    }
+    w->events = gpiod_edge_event_buffer_new(EVENT_BUFFER);
+    if (w->events == NULL) {
+        fprintf(stderr, "dt510-dio-watch: out of memory\n");
+        return -1;
+    }
+    return 0;
+}
+
+static void watch_close(watch_t *w) {
+    for (unsigned int i = 0; i < NUM_INPUTS; i++) {
+        if (w->in[i].req != NULL) {
+            gpiod_line_request_release(w->in[i].req);
+        }
+    }
+    if (w->events != NULL) {
+        gpiod_edge_event_buffer_free(w->events);
+    }
+    for (unsigned int i = 0; i < MAX_CLIENTS; i++) {
+        if (w->clients[i] >= 0) {
+            client_drop(w, i);
+        }
+    }
+    if (w->listen_fd >= 0) {
+        close(w->listen_fd);
+        unlink(w->socket_path);
+    }
+}
+
+static int run_watch(watch_t *w) {
+    struct pollfd fds[NUM_INPUTS + 1 + MAX_CLIENTS];
+    int owner[NUM_INPUTS + 1 + MAX_CLIENTS];
+
+    if (!w->quiet && !w->json) {
+        int values[NUM_INPUTS];
+
+        print_header(w->chip_path, "edge events");
+        for (unsigned int i = 0; i < NUM_INPUTS; i++) {
+            values[i] = w->in[i].req ? w->in[i].value : -1;
+        }
+        print_levels(values, "");
+    } else if (!w->quiet) {
+        char line[LINE_LEN];
+        size_t len = state_json(w, line, sizeof(line));
+
+        fwrite(line, 1, len, stdout);
+        fflush(stdout);
+    }
+
+    while (!stop) {
+        unsigned int n = 0;
+        double now, next = 0;
+        int timeout = -1;
+
+        // owner: input index, NUM_INPUTS for the listener, NUM_INPUTS + 1 + i for client i
+        for (unsigned int i = 0; i < NUM_INPUTS; i++) {
+            if (w->in[i].req != NULL) {
+                fds[n] = (struct pollfd){ gpiod_line_request_get_fd(w->in[i].req), POLLIN, 0 };
+                owner[n++] = (int)i;
+            }
+            if (w->in[i].settle_at != 0 && (next == 0 || w->in[i].settle_at < next)) {
+                next = w->in[i].settle_at;
+            }
+        }
+        if (w->listen_fd >= 0) {
+            fds[n] = (struct pollfd){ w->listen_fd, POLLIN, 0 };
+            owner[n++] = NUM_INPUTS;
+        }
+        for (unsigned int i = 0; i < MAX_CLIENTS; i++) {
+            if (w->clients[i] >= 0) {
+                fds[n] = (struct pollfd){ w->clients[i], POLLIN, 0 };
+                owner[n++] = NUM_INPUTS + 1 + (int)i;
+            }
+        }
+        if (next != 0) {
+            double wait = next - mono_s();
+
+            timeout = wait > 0 ? (int)(wait * 1e3) + 1 : 0;
+        }
+
+        if (poll(fds, n, timeout) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            perror("dt510-dio-watch: poll");
+            return 1;
+        }
+        now = mono_s();
+
+        for (unsigned int k = 0; k < n; k++) {
+            if (fds[k].revents == 0) {
+                continue;
+            }
+            if (owner[k] < NUM_INPUTS) {
+                input_t *in = &w->in[owner[k]];
+                int got = gpiod_line_request_read_edge_events(in->req, w->events, EVENT_BUFFER);
+
+                if (got < 0) {
+                    fprintf(stderr, "dt510-dio-watch: DI%u %s: %s\n", in->def->di, in->def->name,
+                            strerror(errno));
+                    return 1;
+                }
+                for (int e = 0; e < got; e++) {
+                    handle_edge(w, in, gpiod_edge_event_buffer_get_event(w->events, (unsigned long)e),
+                                now);
+                }
+            } else if (owner[k] == NUM_INPUTS) {
+                watch_accept(w);
+            } else {
+                client_read(w, (unsigned int)(owner[k] - NUM_INPUTS - 1));
+            }
+        }
+
+        for (unsigned int i = 0; i < NUM_INPUTS; i++) {
+            if (w->in[i].settle_at != 0 && now >= w->in[i].settle_at) {
+                settle(w, &w->in[i], now);
+            }
+        }
+    }
+    return 0;
+}
+
+/* ---- --once ---- */
+
+// Momentary read of every line, as the gpioget poll did; nothing is kept requested
+static int run_once(struct gpiod_chip *chip, const char *chip_name, int active_low) {
+    int values[NUM_INPUTS];
+    unsigned int read = 0;
+
+    for (unsigned int i = 0; i < NUM_INPUTS; i++) {
+        struct gpiod_line_request *req = line_request(chip, input_defs[i].offset,
+                                                      GPIOD_LINE_DIRECTION_INPUT, 0,
+                                                      GPIOD_LINE_CLOCK_MONOTONIC, active_low, 0);
+
+        values[i] = -1;
+        if (req == NULL) {
+            if (verbose) {
+                fprintf(stderr, "dt510-dio-watch: DI%u %s: %s\n", input_defs[i].di,
+                        input_defs[i].name, strerror(errno));
+            }
+            continue;
+        }
+        values[i] = line_value(req, input_defs[i].offset);
+        read += values[i] >= 0;
+        gpiod_line_request_release(req);
+    }
+    print_header(chip_name, "one-shot read");
+    print_levels(values, read ? "" : "  (no DI line readable)");
+    return read ? 0 : 1;
+}
+
+/* ---- -B latency benchmark ---- */
+
+typedef struct {
+    int fd;
+    char buf[8192];
+    size_t len;
+} reader_t;
+
+// Next line from the socket into out; 0 on timeout, -1 on hangup
+static int reader_line(reader_t *r, char *out, size_t size, int timeout_ms) {
+    for (;;) {
+        char *nl = memchr(r->buf, '\n', r->len);
+
+        if (nl != NULL) {
+            size_t n = (size_t)(nl - r->buf) + 1;
+
+            snprintf(out, size, "%.*s", (int)(n - 1), r->buf);
+            memmove(r->buf, r->buf + n, r->len - n);
+            r->len -= n;
+            return 1;
+        }
+        if (r->len == sizeof(r->buf)) {
+            r->len = 0;
+        }
+
+        struct pollfd pfd = { r->fd, POLLIN, 0 };
+        int ret = poll(&pfd, 1, timeout_ms);
+        ssize_t got;
+
+        if (ret <= 0) {
+            return ret < 0 && errno != EINTR ? -1 : 0;
+        }
+        got = recv(r->fd, r->buf + r->len, sizeof(r->buf) - r->len, 0);
+        if (got <= 0) {
+            return -1;
+        }
+        r->len += (size_t)got;
+    }
+}
+
+static int json_number(const char *line, const char *key, double *v) {
+    char pattern[32];
+    const char *p;
+
+    snprintf(pattern, sizeof(pattern), "\"%s\":", key);
+    p = strstr(line, pattern);
+    if (p == NULL || p[strlen(pattern)] == 'n') {
+        return -1;
+    }
+    *v = strtod(p + strlen(pattern), NULL);
+    return 0;
+}
+
+static int json_u64(const char *line, const char *key, uint64_t *v) {
+    char pattern[32];
+    const char *p;
+
+    snprintf(pattern, sizeof(pattern), "\"%s\":", key);
+    p = strstr(line, pattern);
+    if (p == NULL) {
+        return -1;
+    }
+    *v = strtoull(p + strlen(pattern), NULL, 10);
+    return 0;
+}
+
+static int connect_socket(const char *path) {
+    struct sockaddr_un addr;
+    int fd;
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    snprintf(addr.sun_path, sizeof(addr.sun_path), "%s", path);
+    fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd >= 0 && connect(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0) {
+        close(fd);
+        fd = -1;
+    }
+    return fd;
+}
+
+static int compare_double(const void *a, const void *b) {
+    double x = *(const double *)a;
+    double y = *(const double *)b;
+
+    return (x > y) - (x < y);
+}
+
+typedef struct {
+    const char *name;
+    const char *key;
+    double *v;
+    unsigned int n;
+} segment_t;
+
+static void segment_stats(segment_t *s, double *lo, double *p50, double *p99, double *hi,
+                          double *mean) {
+    double sum = 0;
+
+    qsort(s->v, s->n, sizeof(double), compare_double);
+    for (unsigned int i = 0; i < s->n; i++) {
+        sum += s->v[i];
+    }
+    *lo = s->v[0];
+    *p50 = s->v[s->n / 2];
+    *p99 = s->v[(unsigned int)((s->n - 1) * 0.99)];
+    *hi = s->v[s->n - 1];
+    *mean = sum / s->n;
+}
+
+static int run_bench(struct gpiod_chip *chip, watch_t *w, unsigned int count, int json) {
+    char line[LINE_LEN];
+    char private_path[64];
+    const char *path = w->socket_path ? w->socket_path : DEFAULT_SOCKET;
+    reader_t r = { .fd = -1 };
+    struct gpiod_line_request *out[NUM_INPUTS] = { NULL };
+    int level[NUM_INPUTS] = { 0 };
+    unsigned int watched[NUM_INPUTS], nw = 0, misses = 0, debounce_ms = 0;
+    clockid_t clock_id;
+    pid_t child = -1;
+    segment_t seg[3] = {
+        { "DO write -> kernel edge", "write_to_edge_us", NULL, 0 },
+        { "kernel edge -> sent", "edge_to_sent_us", NULL, 0 },
+        { "kernel edge -> client", "edge_to_client_us", NULL, 0 },
+    };
+    int ret = 1;
+
+    r.fd = connect_socket(path);
+    if (r.fd < 0) {
+        // No watcher running: start one on a private socket for the run
+        snprintf(private_path, sizeof(private_path), "/tmp/dt510-dio-watch-bench.%d.sock",
+                 (int)getpid());
+        path = private_path;
+        child = fork();
+        if (child == 0) {
+            w->quiet = 1;
+            if (watch_open(w, chip) != 0 || watch_listen(w, path) != 0) {
+                _exit(1);
+            }
+            ret = run_watch(w);
+            watch_close(w);
+            _exit(ret);
+        }
+        for (double until = mono_s() + BENCH_CONNECT_MS / 1e3; r.fd < 0 && mono_s() < until;) {
+            if (waitpid(child, NULL, WNOHANG) == child) {
+                child = -1;
+                break;
+            }
+            usleep(20000);
+            r.fd = connect_socket(path);
+        }
+        if (r.fd < 0) {
+            fprintf(stderr, "dt510-dio-watch: could not start a watcher for the benchmark\n");
+            goto out;
+        }
+    }
+    if (verbose) {
+        fprintf(stderr, "dt510-dio-watch: benchmarking through %s%s\n", path,
+                child > 0 ? " (private watcher)" : "");
+    }
+
+    // The state line says which inputs are watched and on what clock
+    if (reader_line(&r, line, sizeof(line), BENCH_CONNECT_MS) != 1 ||
+        strstr(line, "\"event\":\"state\"") == NULL) {
+        fprintf(stderr, "dt510-dio-watch: %s: no state from the watcher\n", path);
+        goto out;
+    }
+    if (strstr(line, "\"clock\":\"monotonic\"") != NULL) {
+        clock_id = CLOCK_MONOTONIC;
+    } else if (strstr(line, "\"clock\":\"realtime\"") != NULL) {
+        clock_id = CLOCK_REALTIME;
+    } else {
+        fprintf(stderr, "dt510-dio-watch: the watcher's event clock is not a system clock\n");
+        goto out;
+    }
+    {
+        double v;
+
+        if (json_number(line, "debounce_ms", &v) == 0) {
+            debounce_ms = (unsigned int)v;
+        }
+    }
+    for (unsigned int i = 0; i < NUM_INPUTS; i++) {
+        char key[16];
+        const char *p;
+
+        snprintf(key, sizeof(key), "{\"di\":%u,", input_defs[i].di);
+        p = strstr(line, key);
+        p = p ? strstr(p, "\"busy\":") : NULL;
+        if (p == NULL || strncmp(p, "\"busy\":false", strlen("\"busy\":false")) != 0) {
+            continue;
+        }
+        out[i] = line_request(chip, input_defs[i].loopback, GPIOD_LINE_DIRECTION_OUTPUT, 0,
+                              GPIOD_LINE_CLOCK_MONOTONIC, 0, 0);
+        if (out[i] == NULL) {
+            fprintf(stderr, "dt510-dio-watch: DO%u (offset %u): %s\n", input_defs[i].di,
+                    input_defs[i].loopback, strerror(errno));
+            continue;
+        }
+        watched[nw++] = i;
+    }
+    if (nw == 0) {
+        fprintf(stderr, "dt510-dio-watch: no DI line with a free loopback DO to drive\n");
+        goto out;
+    }
+
+    for (unsigned int s = 0; s < 3; s++) {
+        seg[s].v = calloc(count, sizeof(double));
+        if (seg[s].v == NULL) {
+            fprintf(stderr, "dt510-dio-watch: out of memory\n");
+            goto out;
+        }
+    }
+
+    for (unsigned int k = 0; k < count && !stop; k++) {
+        unsigned int i = watched[k % nw];
+        uint64_t t_write, t_recv = 0, ts_ns = 0;
+        double sent_us = 0, di;
+        int got = 0;
+
+        level[i] ^= 1;
+        t_write = clock_ns(clock_id);
+        gpiod_line_request_set_value(out[i], input_defs[i].loopback,
+                                     level[i] ? GPIOD_LINE_VALUE_ACTIVE : GPIOD_LINE_VALUE_INACTIVE);
+        for (double until = mono_s() + BENCH_TIMEOUT_MS / 1e3; !got;) {
+            int wait = (int)((until - mono_s()) * 1e3);
+
+            if (wait < 0 || reader_line(&r, line, sizeof(line), wait) != 1) {
+                break;
+            }
+            t_recv = clock_ns(clock_id);
+            got = strstr(line, "\"event\":\"state\"") == NULL && json_number(line, "di", &di) == 0 &&
+                  (unsigned int)di == input_defs[i].di && json_u64(line, "ts_ns", &ts_ns) == 0;
+        }
+        if (!got) {
+            misses++;
+            if (verbose) {
+                fprintf(stderr, "dt510-dio-watch: DO%u -> DI%u: no edge within %d ms\n",
+                        input_defs[i].di, input_defs[i].di, BENCH_TIMEOUT_MS);
+            }
+        } else {
+            seg[0].v[seg[0].n++] = (double)(int64_t)(ts_ns - t_write) / 1e3;
+            if (json_number(line, "latency_us", &sent_us) == 0) {
+                seg[1].v[seg[1].n++] = sent_us;
+            }
+            seg[2].v[seg[2].n++] = (double)(int64_t)(t_recv - ts_ns) / 1e3;
+        }
+
+        // Let the debounce window close, then drop whatever the bounce produced
+        usleep((debounce_ms + 5) * 1000);
+        while (reader_line(&r, line, sizeof(line), 0) == 1) {
+        }
+    }
+
+    if (json) {
+        printf("{\"edges\":%u,\"missed\":%u,\"inputs\":[", count - misses, misses);
+        for (unsigned int k = 0; k < nw; k++) {
+            printf("%s%u", k ? "," : "", input_defs[watched[k]].di);
+        }
+        printf("]");
+        for (unsigned int s = 0; s < 3; s++) {
+            double lo, p50, p99, hi, mean;
+
+            if (seg[s].n == 0) {
+                printf(",\"%s\":null", seg[s].key);
+                continue;
+            }
+            segment_stats(&seg[s], &lo, &p50, &p99, &hi, &mean);
+            printf(",\"%s\":{\"min\":%.1f,\"p50\":%.1f,\"p99\":%.1f,\"max\":%.1f,\"mean\":%.1f}",
+                   seg[s].key, lo, p50, p99, hi, mean);
+        }
+        printf("}\n");
+    } else {
+        printf("DT510 DI edge latency: %u edges on", count - misses);
+        for (unsigned int k = 0; k < nw; k++) {
+            printf(" DI%u", input_defs[watched[k]].di);
+        }
+        printf(" (DO loopback), %u missed\n", misses);
+        printf("  %-24s %9s %9s %9s %9s %9s  (us)\n", "", "min", "p50", "p99", "max", "mean");
+        for (unsigned int s = 0; s < 3; s++) {
+            double lo, p50, p99, hi, mean;
+
+            if (seg[s].n == 0) {
+                printf("  %-24s %9s\n", seg[s].name, "-");
+                continue;
+            }
+            segment_stats(&seg[s], &lo, &p50, &p99, &hi, &mean);
+            printf("  %-24s %9.1f %9.1f %9.1f %9.1f %9.1f\n", seg[s].name, lo, p50, p99, hi, mean);
+        }
+    }
+    if (misses == count) {
+        fprintf(stderr, "dt510-dio-watch: no edge arrived — is the DO-DI loopback fixture connected?\n");
+    }
+    ret = misses == 0 ? 0 : 1;
+
+out:
+    for (unsigned int i = 0; i < NUM_INPUTS; i++) {
+        if (out[i] != NULL) {
+            gpiod_line_request_set_value(out[i], input_defs[i].loopback, GPIOD_LINE_VALUE_INACTIVE);
+            gpiod_line_request_release(out[i]);
+        }
+    }
+    for (unsigned int s = 0; s < 3; s++) {
+        free(seg[s].v);
+    }
+    if (r.fd >= 0) {
+        close(r.fd);
+    }
+    if (child > 0) {
+        kill(child, SIGTERM);
+        waitpid(child, NULL, 0);
+    }
+    return ret;
+}
+
+static void print_usage(const char *prog) {
+    printf("Usage: %s [options]\n", prog);
+    printf("\n");
+    printf("Watch the DT510 cab button inputs DI1-DI4 with kernel edge events.\n");
+    printf("\n");
+    printf("  -c, --chip NAME         GPIO chip (default %s)\n", DEFAULT_CHIP);
+    printf("  -d, --debounce MS       Debounce window per line, 0 for none (default %d)\n",
+           DEFAULT_DEBOUNCE_MS);
+    printf("  -C, --clock CLOCK       Edge timestamp clock: monotonic, realtime or hte\n");
+    printf("                          (default monotonic; hte needs a timestamp engine)\n");
+    printf("  -a, --active-low        Invert the lines (only without the DTS GPIO_ACTIVE_LOW)\n");
+    printf("  -S, --socket PATH       Stream events to clients of a Unix socket\n");
+    printf("  -j, --json              One JSON line per event on stdout\n");
+    printf("  -q, --quiet             Nothing on stdout\n");
+    printf("  -R, --realtime PRIO     Run SCHED_FIFO at PRIO\n");
+    printf("  -1, --once              Print the levels once and exit, like dt510-dio-poll-inputs\n");
+    printf("  -B, --bench N           Edge latency over N toggles of the DO-DI loopback\n");
+    printf("                          fixture, through the watcher on -S (default\n");
+    printf("                          %s) or a private one\n", DEFAULT_SOCKET);
+    printf("  -v, --verbose           Report unreadable lines (--once) and missed edges (-B)\n");
+    printf("  -h, --help              Show this help\n");
+    printf("\n");
+    printf("Exit: 0 ok, 1 GPIO error or benchmark edges missed, 2 usage\n");
+}
+
+int main(int argc, char *argv[]) {
+    static const struct option long_opts[] = {
+        { "chip", required_argument, NULL, 'c' },
+        { "debounce", required_argument, NULL, 'd' },
+        { "clock", required_argument, NULL, 'C' },
+        { "active-low", no_argument, NULL, 'a' },
+        { "socket", required_argument, NULL, 'S' },
+        { "json", no_argument, NULL, 'j' },
+        { "quiet", no_argument, NULL, 'q' },
+        { "realtime", required_argument, NULL, 'R' },
+        { "once", no_argument, NULL, '1' },
+        { "bench", required_argument, NULL, 'B' },
+        { "verbose", no_argument, NULL, 'v' },
+        { "help", no_argument, NULL, 'h' },
+        { NULL, 0, NULL, 0 }
+    };
+    watch_t w = {
+        .chip_path = DEFAULT_CHIP,
+        .event_clock = GPIOD_LINE_CLOCK_MONOTONIC,
+        .clock_id = CLOCK_MONOTONIC,
+        .clock_name = "monotonic",
+        .debounce_ms = DEFAULT_DEBOUNCE_MS,
+        .listen_fd = -1,
+    };
+    struct gpiod_chip *chip;
+    struct sigaction sa;
+    unsigned int bench = 0;
+    int once = 0;
+    int rt_prio = 0;
+    int opt;
+    int ret;
+
+    for (unsigned int i = 0; i < MAX_CLIENTS; i++) {
+        w.clients[i] = -1;
+    }
+
+    while ((opt = getopt_long(argc, argv, "c:d:C:aS:jqR:1B:vh", long_opts, NULL)) != -1) {
+        switch (opt) {
+        case 'c':
+            w.chip_path = optarg;
+            break;
+        case 'd':
+            w.debounce_ms = (unsigned int)atoi(optarg);
+            break;
+        case 'C':
+            if (strcmp(optarg, "monotonic") == 0) {
+                w.event_clock = GPIOD_LINE_CLOCK_MONOTONIC;
+                w.clock_id = CLOCK_MONOTONIC;
+            } else if (strcmp(optarg, "realtime") == 0) {
+                w.event_clock = GPIOD_LINE_CLOCK_REALTIME;
+                w.clock_id = CLOCK_REALTIME;
+            } else if (strcmp(optarg, "hte") == 0) {
+                w.event_clock = GPIOD_LINE_CLOCK_HTE;
+                w.clock_id = -1;
+            } else {
+                fprintf(stderr, "dt510-dio-watch: unknown clock '%s'\n", optarg);
+                return 2;
+            }
+            w.clock_name = optarg;
+            break;
+        case 'a':
+            w.active_low = 1;
+            break;
+        case 'S':
+            w.socket_path = optarg;
+            break;
+        case 'j':
+            w.json = 1;
+            break;
+        case 'q':
+            w.quiet = 1;
+            break;
+        case 'R':
+            rt_prio = atoi(optarg);
+            break;
+        case '1':
+            once = 1;
+            break;
+        case 'B':
+            bench = (unsigned int)atoi(optarg);
+            if (bench == 0) {
+                fprintf(stderr, "dt510-dio-watch: -B needs a toggle count\n");
+                return 2;
+            }
+            break;
+        case 'v':
+            verbose = 1;
+            break;
+        case 'h':
+            print_usage(argv[0]);
+            return 0;
+        default:
+            print_usage(argv[0]);
+            return 2;
+        }
+    }
+
+    chip = chip_open(w.chip_path);
+    if (chip == NULL) {
+        return 1;
+    }
+    if (once) {
+        ret = run_once(chip, w.chip_path, w.active_low);
+        gpiod_chip_close(chip);
+        return ret;
+    }
+
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = on_signal;
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+
+    if (rt_prio > 0) {
+        struct sched_param sp = { .sched_priority = rt_prio };
+
+        mlockall(MCL_CURRENT | MCL_FUTURE);
+        if (sched_setscheduler(0, SCHED_FIFO, &sp) != 0) {
+            fprintf(stderr, "dt510-dio-watch: SCHED_FIFO %d refused, running unprivileged\n", rt_prio);
+        }
+    }
+
+    if (bench) {
+        ret = run_bench(chip, &w, bench, w.json);
+        gpiod_chip_close(chip);
+        return ret;
+    }
+
+    if (watch_open(&w, chip) != 0 ||
+        (w.socket_path != NULL && watch_listen(&w, w.socket_path) != 0)) {
+        watch_close(&w);
+        gpiod_chip_close(chip);
+        return 1;
+    }
+    ret = run_watch(&w);
+    watch_close(&w);
+    gpiod_chip_close(chip);
+    return ret;
+}
@@ -4,6 +4,8 @@
 # DT510 — TI TAA5412-Q1 smoke checks (Path A pcm6240 or Path B tac5x1x-ti OOT).
 # Prefers ALSA pcm **driver_mic**; falls back to plughw.
 # Exit 0 if I2C + ALSA card look reasonable; non-zero if broken.
+# DT510_AUDIO_LOOPBACK=1 also plays DTMF on driver_speaker and decodes it from
+# driver_mic with audio-loopback (level, SNR and round-trip latency per channel).
 #
 # Related: meta-dynamicdevices-bsp/docs/DT510-TAA5412-DRIVER-MIC-ALSA.md
 
@@ -218,6 +220,16 @@ else
 				err "arecord failed (driver_mic then plughw) — see $ERRF"
 				cat "$ERRF" >&2 || true
 			fi
+			# Opt-in speaker -> mic loopback (needs the acoustic path, so not default)
+			if [ "$ok" -eq 1 ] && [ "${DT510_AUDIO_LOOPBACK:-0}" = 1 ]; then
+				if command -v audio-loopback >/dev/null 2>&1; then
+					echo "--- audio-loopback driver_speaker -> driver_mic ---"
+					audio-loopback -P driver_speaker -C driver_mic -c 2 ||
+						warn "audio-loopback: DTMF loopback failed (level/SNR/latency above)"
+				else
+					warn "DT510_AUDIO_LOOPBACK=1 but audio-loopback is not installed"
+				fi
+			fi
 		else
 			err "Could not parse card index for taa5412-codec"
 		fi
@@ -76,6 +76,9 @@ Usage: $(basename "$0") [-b bus] [-a addr|-A addr8] [-f conf] [--verify] [-n] [-
   --strict-addr  Fail if Michael-format file addr != target (-a/-A)
   -n           Dry run — print commands only
 
+Uses dt510-taa5412-regs (batched I2C_RDWR) when installed, except for
+-m i2c / -m regmap; set TAA5412_REGS_SHELL=1 to force the i2cset path.
+
 Env: TAA5412_I2C_ADDR — 7-bit (0x51) or 8-bit (0xa2) before -a/-A
 
 Config formats:
@@ -120,6 +123,17 @@ case "$MODE" in
 	*) echo "ERR: invalid -m mode: $MODE" >&2; exit 2 ;;
 esac
 
+# Native batched engine (one I2C_RDWR ioctl per page run instead of one
+# i2cset/i2cget process per register). TAA5412_REGS_SHELL=1 keeps this script.
+NATIVE=$(command -v dt510-taa5412-regs || true)
+if [ -n "$NATIVE" ] && [ "$MODE" != "regmap" ] && [ "$MODE" != "i2c" ] && [ -z "${TAA5412_REGS_SHELL:-}" ]; then
+	NATIVE_ARGS=(-b "$BUS" -a "$(printf '0x%02x' "$ADDR")")
+	[ "$VERIFY" -eq 1 ] && NATIVE_ARGS+=(--verify)
+	[ "$STRICT_FILE_ADDR" -eq 1 ] && NATIVE_ARGS+=(--strict-addr)
+	[ "$DRY_RUN" -eq 1 ] && NATIVE_ARGS+=(-n)
+	exec "$NATIVE" "${NATIVE_ARGS[@]}" apply "$CONF"
+fi
+
 hexbyte() {
 	local v="${1#0x}"
 	v="${v#0X}"
@@ -46,6 +46,9 @@ Usage: $(basename "$0") [-b bus] [-a [addr]|--all] [-p page] [-r reg] [--regmap]
 Env: TAA5412_I2C_ADDR — 7-bit or 8-bit before -a/-A
 
 Default (no -p/-r/-a): dump key registers on pages 0 and 1.
+
+Uses dt510-taa5412-regs (batched I2C_RDWR) when installed; set
+TAA5412_REGS_SHELL=1 to force the i2cget path.
 EOF
 }
 
@@ -92,6 +95,22 @@ while [ $# -gt 0 ]; do
 	esac
 done
 
+# Native batched engine: every register below in a handful of I2C_RDWR
+# ioctls. TAA5412_REGS_SHELL=1 keeps this script.
+NATIVE=$(command -v dt510-taa5412-regs || true)
+if [ -n "$NATIVE" ] && [ -z "${TAA5412_REGS_SHELL:-}" ]; then
+	NATIVE_ARGS=(-b "$BUS" -a "$(printf '0x%02x' "$ADDR")")
+	[ "$SHOW_REGMAP" -eq 1 ] && NATIVE_ARGS+=(--regmap)
+	[ -n "$SINGLE_REG" ] && NATIVE_ARGS+=(-r "$SINGLE_REG")
+	NATIVE_ARGS+=(dump)
+	if [ "$PAGE" -ge 0 ] 2>/dev/null; then
+		NATIVE_ARGS+=("$PAGE")
+	elif [ -n "$SINGLE_REG" ]; then
+		NATIVE_ARGS+=(0)
+	fi
+	exec "$NATIVE" "${NATIVE_ARGS[@]}"
+fi
+
 if ! command -v i2cget >/dev/null 2>&1; then
 	echo "ERR: i2cget not found (install i2c-tools)" >&2
 	exit 1
@@ -0,0 +1,960 @@
+/* SPDX-License-Identifier: MIT */
+/*
+ * dt510-taa5412-regs - batched TAA5412-Q1 register dump / apply / diff
+ *
+ * Native engine behind dt510-taa5412-i2c-registers-{dump,apply}.sh. The
+ * scripts run one i2cget/i2cset process per register; this issues
+ * I2C_RDWR ioctls of up to I2C_RDRW_IOCTL_MAX_MSGS messages instead, so a
+ * full two-page dump or an apply with readback takes milliseconds.
+ *
+ * Every ioctl is bracketed: it selects the book/page its accesses need
+ * and finishes by putting back the page the driver had selected. The
+ * adapter lock is held for the whole transfer, so tac5x1x/pcm6240 can
+ * stay bound (like i2cset -f, I2C_RDWR is not refused for a busy
+ * address) without its regmap page cache ever seeing a foreign page.
+ * The driver can change pages between ioctls, so each one also reads the
+ * page select first; if it moved, that page is written back straight
+ * after the transfer and restored by every later one.
+ *
+ * Config formats (same as the apply script):
+ *   page  reg  value  [delay_ms]   # standard table, page decimal
+ *   w <addr> <reg> <val>           # TI PurePath / Michael dump; addr ignored
+ * reg 0x00 selects the page, reg 0x7f on page 0 the book. Regmap debugfs
+ * uses linear addresses, page * 128 + reg, for book 0.
+ *
+ *   dt510-taa5412-regs dump                     # decoded key registers, pages 0-1
+ *   dt510-taa5412-regs -A dump 0 1 2            # every register of pages 0-2
+ *   dt510-taa5412-regs apply taa5412-registers-michael.conf --verify
+ *   dt510-taa5412-regs diff taa5412-registers-michael.conf [--regmap]
+ */
+
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <linux/i2c.h>
+#include <linux/i2c-dev.h>
+
+#define DEFAULT_BUS          1
+#define DEFAULT_ADDR         0x51
+#define DEFAULT_CONF         "/usr/share/board-scripts/taa5412-registers-michael.conf"
+
+#define REG_PAGE             0x00
+#define REG_BOOK             0x7f
+#define PAGE_REGS            128
+#define MAX_PAGES            256
+#define MAX_WRITES           4096
+
+// Messages kept free in every batch for the closing page restore
+#define RESTORE_MSGS         3
+
+typedef struct {
+    uint8_t book;
+    uint8_t page;
+    uint8_t reg;
+    uint8_t val;
+    unsigned int delay_ms;
+    unsigned int line;
+} reg_write_t;
+
+typedef struct {
+    int fd;
+    uint16_t addr;
+    int dry_run;
+    int verbose;
+
+    struct i2c_msg msgs[I2C_RDRW_IOCTL_MAX_MSGS];
+    uint8_t bufs[I2C_RDRW_IOCTL_MAX_MSGS][2];
+    unsigned int n;
+    int book;                   // selected by the queued messages, -1 if none
+    int page;
+    uint8_t driver_page;        // restored at the end of every batch
+    uint8_t batch_page;         // page select read at the start of the last batch
+
+    unsigned int ioctls;
+    unsigned int messages;
+} bus_t;
+
+typedef struct {
+    uint8_t reg;
+    const char *name;
+} reg_name_t;
+
+static const reg_name_t page0_names[] = {
+    { 0x00, "PAGE_SELECT" }, { 0x02, "VREF" }, { 0x13, "INTF4" }, { 0x1a, "PASI0" },
+    { 0x1e, "PASITXCH1" }, { 0x1f, "PASITXCH2" }, { 0x4d, "VREFCFG" },
+    { 0x50, "ADCCH1C0" }, { 0x51, "ADCCH1C1" }, { 0x52, "ADCCH1C2" }, { 0x53, "ADCCH1C3" },
+    { 0x54, "ADCCH1C4" }, { 0x55, "ADCCH2C0" }, { 0x57, "ADCCH2C2" }, { 0x58, "ADCCH2C3" },
+    { 0x59, "ADCCH2C4" }, { 0x5a, "ADCCH3C0" }, { 0x5b, "ADCCH3C2" }, { 0x5c, "ADCCH3C3" },
+    { 0x5d, "ADCCH3C4" }, { 0x5e, "ADCCH4C0" }, { 0x76, "CH_EN" }, { 0x78, "PWR_CFG" },
+    { 0x7f, "BOOK_SELECT" },
+};
+
+static const reg_name_t page1_names[] = {
+    { 0x00, "PAGE_SELECT" }, { 0x73, "MICBIAS/page1" },
+};
+
+static const char *reg_name(unsigned int page, uint8_t reg) {
+    const reg_name_t *names = page == 0 ? page0_names : page1_names;
+    size_t count = page == 0 ? sizeof(page0_names) / sizeof(page0_names[0])
+                             : sizeof(page1_names) / sizeof(page1_names[0]);
+
+    if (page > 1) {
+        return NULL;
+    }
+    for (size_t i = 0; i < count; i++) {
+        if (names[i].reg == reg) {
+            return names[i].name;
+        }
+    }
+    return NULL;
+}
+
+static double now_ms(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e3 + (double)ts.tv_nsec / 1e6;
+}
+
+// 7-bit address, or an 8-bit write/read address as used in TI dumps
+static int parse_addr(const char *text, uint16_t *addr) {
+    char *end;
+    unsigned long n = strtoul(text, &end, 16);
+
+    if (end == text || *end != '\0' || n > 0xff) {
+        return -1;
+    }
+    *addr = (uint16_t)(n >= 0x80 ? n >> 1 : n);
+    return 0;
+}
+
+// Register and value bytes are hex with or without 0x
+static int parse_byte(const char *text, uint8_t *out) {
+    char *end;
+    unsigned long n = strtoul(text, &end, 16);
+
+    if (end == text || *end != '\0' || n > 0xff) {
+        return -1;
+    }
+    *out = (uint8_t)n;
+    return 0;
+}
+
+/* ---- Decoders (as in dt510-taa5412-i2c-registers-dump.sh) ---- */
+
+static void decode_adcch_c0(uint8_t val, const char *label) {
+    static const char *const cfg_s[] = { "Differential", "Single-ended", "SE mux INxP", "SE mux INxM" };
+    static const char *const tol_s[] = { "AC 100mVpp (DT510 AC-coupled target)", "AC/DC 1Vpp",
+                                         "AC/DC rail-rail", "CM tol=3" };
+
+    printf("    %s: %s; %s; %s; imp=%u\n", label, cfg_s[(val >> 6) & 3], tol_s[(val >> 2) & 3],
+           (val & 1) ? "wideband" : "normal", (val >> 4) & 3);
+}
+
+static void decode_reg(uint8_t reg, uint8_t val) {
+    static const char *const fmt_s[] = { "TDM", "I2S", "LJ", "fmt=3" };
+
+    switch (reg) {
+    case 0x02:
+        printf("    VREF: sleep_exit_en=%u active=%u\n", (val >> 7) & 1, val & 1);
+        break;
+    case 0x13:
+        printf("    IN1=%s IN2=%s; PDM_DIN12_sel=%u PDM_DIN34_sel=%u\n",
+               (val >> 7) & 1 ? "PDM" : "Analog", (val >> 6) & 1 ? "PDM" : "Analog",
+               (val >> 2) & 3, val & 3);
+        break;
+    case 0x1a:
+        printf("    PASI0: %s word_len_idx=%u raw=0x%02x\n", fmt_s[(val >> 6) & 3], (val >> 4) & 3, val);
+        break;
+    case 0x1e:
+    case 0x1f:
+        printf("    PASITXCH%u: slot=%u ASI_TX_EN(bit5)=%u\n", reg - 0x1d, val & 0x1f, (val >> 5) & 1);
+        break;
+    case 0x50:
+        decode_adcch_c0(val, "ADC1");
+        break;
+    case 0x55:
+        decode_adcch_c0(val, "ADC2");
+        break;
+    case 0x5a:
+        decode_adcch_c0(val, "ADC3");
+        break;
+    case 0x5e:
+        decode_adcch_c0(val, "ADC4");
+        break;
+    case 0x76:
+        printf("    ADC EN: CH1=%u CH2=%u CH3=%u CH4=%u | DAC EN: CH1=%u CH2=%u CH3=%u CH4=%u\n",
+               (val >> 7) & 1, (val >> 6) & 1, (val >> 5) & 1, (val >> 4) & 1,
+               (val >> 3) & 1, (val >> 2) & 1, (val >> 1) & 1, val & 1);
+        break;
+    case 0x78:
+        printf("    PWR: ADC_PDZ=%u DAC_PDZ=%u MICBIAS=%u UAD=%u VAD=%u UAG=%u\n",
+               (val >> 7) & 1, (val >> 6) & 1, (val >> 5) & 1, (val >> 3) & 1, (val >> 2) & 1,
+               (val >> 1) & 1);
+        break;
+    default:
+        break;
+    }
+}
+
+/* ---- I2C_RDWR batching ---- */
+
+static void bus_queue(bus_t *bus, uint8_t reg, const uint8_t *val, uint8_t *dst) {
+    struct i2c_msg *m = &bus->msgs[bus->n];
+
+    bus->bufs[bus->n][0] = reg;
+    m->addr = bus->addr;
+    m->flags = 0;
+    m->buf = bus->bufs[bus->n];
+    m->len = 1;
+    if (val != NULL) {
+        bus->bufs[bus->n][1] = *val;
+        m->len = 2;
+    }
+    bus->n++;
+
+    if (dst != NULL) {
+        m = &bus->msgs[bus->n++];
+        m->addr = bus->addr;
+        m->flags = I2C_M_RD;
+        m->buf = dst;
+        m->len = 1;
+    }
+}
+
+static void bus_select(bus_t *bus, int book, int page) {
+    uint8_t zero = 0;
+    uint8_t b = (uint8_t)book;
+    uint8_t p = (uint8_t)page;
+
+    if (book != bus->book) {
+        if (bus->page != 0) {
+            bus_queue(bus, REG_PAGE, &zero, NULL);
+        }
+        bus_queue(bus, REG_BOOK, &b, NULL);
+        bus->book = book;
+        bus->page = 0;
+    }
+    if (page != bus->page) {
+        bus_queue(bus, REG_PAGE, &p, NULL);
+        bus->page = page;
+    }
+}
+
+static void bus_dump_batch(const bus_t *bus) {
+    printf("ioctl %u:", bus->ioctls);
+    for (unsigned int i = 0; i < bus->n; i++) {
+        const struct i2c_msg *m = &bus->msgs[i];
+
+        if (m->flags & I2C_M_RD) {
+            printf(" r");
+        } else if (m->len == 2) {
+            printf(" w%02x=%02x", m->buf[0], m->buf[1]);
+        } else {
+            printf(" @%02x", m->buf[0]);
+        }
+    }
+    printf("\n");
+}
+
+static int bus_flush(bus_t *bus) {
+    struct i2c_rdwr_ioctl_data data;
+
+    if (bus->n == 0) {
+        return 0;
+    }
+    // Leave the device on the driver's book/page, inside the same transfer
+    bus_select(bus, 0, bus->driver_page);
+
+    bus->ioctls++;
+    bus->messages += bus->n;
+    if (bus->dry_run || bus->verbose) {
+        bus_dump_batch(bus);
+    }
+
+    data.msgs = bus->msgs;
+    data.nmsgs = bus->n;
+    bus->n = 0;
+    bus->book = -1;
+    bus->page = -1;
+    if (bus->dry_run) {
+        return 0;
+    }
+    if (ioctl(bus->fd, I2C_RDWR, &data) < 0) {
+        fprintf(stderr, "dt510-taa5412-regs: I2C_RDWR (%u messages): %s\n", data.nmsgs,
+                strerror(errno));
+        return -1;
+    }
+
+    // The driver moved pages since the last batch: hand it back the page it chose
+    if (bus->batch_page != bus->driver_page) {
+        uint8_t buf[2] = { REG_PAGE, bus->batch_page };
+        struct i2c_msg m = { .addr = bus->addr, .flags = 0, .len = 2, .buf = buf };
+
+        data.msgs = &m;
+        data.nmsgs = 1;
+        if (bus->verbose) {
+            printf("driver page %u -> %u\n", bus->driver_page, bus->batch_page);
+        }
+        bus->driver_page = bus->batch_page;
+        bus->ioctls++;
+        bus->messages++;
+        if (ioctl(bus->fd, I2C_RDWR, &data) < 0) {
+            fprintf(stderr, "dt510-taa5412-regs: restoring page %u: %s\n", bus->batch_page,
+                    strerror(errno));
+            return -1;
+        }
+    }
+    return 0;
+}
+
+/*
+ * Queue one access on (book, page). val != NULL writes it; dst != NULL
+ * reads into dst, which must stay valid until the next flush.
+ */
+static int bus_access(bus_t *bus, int book, int page, uint8_t reg, const uint8_t *val,
+                      uint8_t *dst) {
+    unsigned int need = (dst != NULL ? 2 : 1) + 3 + RESTORE_MSGS;
+
+    if (bus->n > 0 && bus->n + need > I2C_RDRW_IOCTL_MAX_MSGS) {
+        if (bus_flush(bus) != 0) {
+            return -1;
+        }
+    }
+    if (bus->n == 0) {
+        // Start of a batch: the driver may have moved the page since the
+        // last one, so read it and always select ours (the driver itself
+        // stays in book 0)
+        bus->batch_page = bus->driver_page;
+        if (!bus->dry_run) {
+            bus_queue(bus, REG_PAGE, NULL, &bus->batch_page);
+        }
+        bus->book = 0;
+        bus->page = -1;
+    }
+    bus_select(bus, book, page);
+    bus_queue(bus, reg, val, dst);
+    return 0;
+}
+
+static int bus_open(bus_t *bus, int bus_nr) {
+    char path[32];
+    uint8_t page = 0;
+    struct i2c_msg msgs[2];
+    struct i2c_rdwr_ioctl_data data = { .msgs = msgs, .nmsgs = 2 };
+    uint8_t reg = REG_PAGE;
+
+    bus->book = -1;
+    bus->page = -1;
+    snprintf(path, sizeof(path), "/dev/i2c-%d", bus_nr);
+    bus->fd = open(path, O_RDWR | O_CLOEXEC);
+    if (bus->fd < 0) {
+        if (bus->dry_run) {
+            return 0;
+        }
+        fprintf(stderr, "dt510-taa5412-regs: %s: %s\n", path, strerror(errno));
+        return -1;
+    }
+
+    // Page the driver left selected (book is assumed 0)
+    msgs[0] = (struct i2c_msg){ .addr = bus->addr, .flags = 0, .len = 1, .buf = &reg };
+    msgs[1] = (struct i2c_msg){ .addr = bus->addr, .flags = I2C_M_RD, .len = 1, .buf = &page };
+    if (ioctl(bus->fd, I2C_RDWR, &data) < 0) {
+        if (bus->dry_run) {
+            return 0;
+        }
+        fprintf(stderr, "dt510-taa5412-regs: no TAA5412 at %d-%04x: %s\n", bus_nr, bus->addr,
+                strerror(errno));
+        close(bus->fd);
+        return -1;
+    }
+    bus->driver_page = page;
+    return 0;
+}
+
+/* ---- Config ---- */
+
+typedef struct {
+    reg_write_t *writes;
+    unsigned int count;
+} conf_t;
+
+static int conf_add(conf_t *conf, int book, int page, uint8_t reg, uint8_t val,
+                    unsigned int delay_ms, unsigned int line) {
+    if (conf->count == MAX_WRITES) {
+        fprintf(stderr, "dt510-taa5412-regs: more than %d writes\n", MAX_WRITES);
+        return -1;
+    }
+    conf->writes[conf->count++] = (reg_write_t){
+        .book = (uint8_t)book, .page = (uint8_t)page, .reg = reg, .val = val,
+        .delay_ms = delay_ms, .line = line,
+    };
+    return 0;
+}
+
+/*
+ * Page and book selects in the file become the (book, page) of the
+ * writes that follow them rather than writes of their own; the batcher
+ * re-creates whatever selects it needs.
+ */
+static int conf_load(conf_t *conf, const char *path, uint16_t addr, int strict_addr) {
+    char line[512];
+    unsigned int line_no = 0;
+    int book = 0;
+    int page = -1;
+    int warned = 0;
+    int failed = 0;
+    FILE *f;
+
+    f = fopen(path, "r");
+    if (f == NULL) {
+        fprintf(stderr, "dt510-taa5412-regs: %s: %s\n", path, strerror(errno));
+        return -1;
+    }
+    conf->writes = calloc(MAX_WRITES, sizeof(*conf->writes));
+    conf->count = 0;
+    if (conf->writes == NULL) {
+        fclose(f);
+        return -1;
+    }
+
+    while (fgets(line, sizeof(line), f) != NULL) {
+        char *tok[5] = { NULL };
+        unsigned int ntok = 0;
+        unsigned int delay_ms = 0;
+        uint8_t reg;
+        uint8_t val;
+        char *hash;
+        char *save;
+
+        line_no++;
+        if ((hash = strchr(line, '#')) != NULL) {
+            *hash = '\0';
+        }
+        for (char *t = strtok_r(line, " \t\r\n", &save); t != NULL && ntok < 5;
+             t = strtok_r(NULL, " \t\r\n", &save)) {
+            tok[ntok++] = t;
+        }
+        if (ntok == 0) {
+            continue;
+        }
+
+        if (strcmp(tok[0], "w") == 0) {
+            uint16_t file_addr;
+
+            if (ntok < 4 || parse_addr(tok[1], &file_addr) != 0 ||
+                parse_byte(tok[2], &reg) != 0 || parse_byte(tok[3], &val) != 0) {
+                fprintf(stderr, "%s:%u: Michael format needs: w addr reg val\n", path, line_no);
+                failed = 1;
+                continue;
+            }
+            if (file_addr != addr) {
+                if (strict_addr) {
+                    fprintf(stderr, "%s:%u: file I2C addr 0x%02x != target 0x%02x\n", path,
+                            line_no, file_addr, addr);
+                    failed = 1;
+                    continue;
+                }
+                if (!warned) {
+                    fprintf(stderr, "WARN: Michael-format file addr 0x%02x != target 0x%02x; "
+                            "all writes go to target (-a).\n", file_addr, addr);
+                    warned = 1;
+                }
+            }
+        } else {
+            char *end;
+            long p = strtol(tok[0], &end, 0);
+
+            if (ntok < 3 || *end != '\0' || p < 0 || p >= MAX_PAGES ||
+                parse_byte(tok[1], &reg) != 0 || parse_byte(tok[2], &val) != 0) {
+                fprintf(stderr, "%s:%u: need page reg value (or w addr reg val)\n", path, line_no);
+                failed = 1;
+                continue;
+            }
+            if (ntok > 3) {
+                delay_ms = (unsigned int)strtoul(tok[3], NULL, 10);
+            }
+            page = (int)p;
+        }
+
+        if (reg == REG_PAGE) {
+            page = val;
+            // A page select can still carry a delay
+            if (delay_ms > 0 && conf->count > 0) {
+                conf->writes[conf->count - 1].delay_ms += delay_ms;
+            }
+            continue;
+        }
+        if (page < 0) {
+            fprintf(stderr, "%s:%u: reg 0x%02x before page select (reg 0x00)\n", path, line_no, reg);
+            failed = 1;
+            continue;
+        }
+        if (page == 0 && reg == REG_BOOK) {
+            book = val;
+            continue;
+        }
+        if (conf_add(conf, book, page, reg, val, delay_ms, line_no) != 0) {
+            failed = 1;
+            break;
+        }
+    }
+    fclose(f);
+    return failed ? -1 : 0;
+}
+
+static int write_cmp(const void *a, const void *b) {
+    const reg_write_t *x = a;
+    const reg_write_t *y = b;
+    int kx = (x->book << 16) | (x->page << 8) | x->reg;
+    int ky = (y->book << 16) | (y->page << 8) | y->reg;
+
+    // Ties keep file order so the last write to a register wins
+    return kx != ky ? kx - ky : (int)x->line - (int)y->line;
+}
+
+// Final state the file leaves behind: one entry per register, grouped by book and page
+static unsigned int conf_final_state(const conf_t *conf, reg_write_t *out) {
+    unsigned int n = 0;
+
+    memcpy(out, conf->writes, conf->count * sizeof(*out));
+    qsort(out, conf->count, sizeof(*out), write_cmp);
+    for (unsigned int i = 0; i < conf->count; i++) {
+        if (n > 0 && out[n - 1].book == out[i].book && out[n - 1].page == out[i].page &&
+            out[n - 1].reg == out[i].reg) {
+            out[n - 1] = out[i];
+        } else {
+            out[n++] = out[i];
+        }
+    }
+    return n;
+}
+
+/* ---- Regmap debugfs ---- */
+
+/*
+ * Parse /sys/kernel/debug/regmap/<node>/registers ("0050: a0") into
+ * values[] indexed by linear address. Returns the number of registers
+ * found, or -1.
+ */
+static int regmap_load(int bus_nr, uint16_t addr, int16_t *values, size_t size) {
+    char path[128];
+    char line[64];
+    int found = 0;
+    FILE *f;
+
+    snprintf(path, sizeof(path), "/sys/kernel/debug/regmap/%d-%04x/registers", bus_nr, addr);
+    f = fopen(path, "r");
+    if (f == NULL) {
+        fprintf(stderr, "dt510-taa5412-regs: %s: %s\n", path, strerror(errno));
+        return -1;
+    }
+    for (size_t i = 0; i < size; i++) {
+        values[i] = -1;
+    }
+    while (fgets(line, sizeof(line), f) != NULL) {
+        unsigned int linear;
+        unsigned int val;
+
+        if (sscanf(line, "%x: %x", &linear, &val) == 2 && linear < size && val <= 0xff) {
+            values[linear] = (int16_t)val;
+            found++;
+        }
+    }
+    fclose(f);
+    return found;
+}
+
+/* ---- Commands ---- */
+
+static int driver_bound(int bus_nr, uint16_t addr, char *name, size_t size) {
+    char link[128];
+    char target[256];
+    ssize_t n;
+
+    snprintf(link, sizeof(link), "/sys/bus/i2c/devices/%d-%04x/driver", bus_nr, addr);
+    n = readlink(link, target, sizeof(target) - 1);
+    if (n <= 0) {
+        snprintf(name, size, "none");
+        return 0;
+    }
+    target[n] = '\0';
+    snprintf(name, size, "%s", strrchr(target, '/') ? strrchr(target, '/') + 1 : target);
+    return 1;
+}
+
+/*
+ * Read back the given (book, page, reg) set and compare against the
+ * expected values: from the device through bus, or from regmap debugfs
+ * when regmap is non-NULL. Returns the number of differences, or -1.
+ */
+static int compare_state(bus_t *bus, const int16_t *regmap, const reg_write_t *exp,
+                         unsigned int count) {
+    uint8_t *live = calloc(count ? count : 1, 1);
+    int diffs = 0;
+
+    if (live == NULL) {
+        return -1;
+    }
+    if (regmap == NULL) {
+        for (unsigned int i = 0; i < count; i++) {
+            if (bus_access(bus, exp[i].book, exp[i].page, exp[i].reg, NULL, &live[i]) != 0) {
+                free(live);
+                return -1;
+            }
+        }
+        if (bus_flush(bus) != 0) {
+            free(live);
+            return -1;
+        }
+        if (bus->dry_run) {
+            free(live);
+            return 0;
+        }
+    }
+
+    for (unsigned int i = 0; i < count; i++) {
+        const reg_write_t *e = &exp[i];
+        unsigned int linear = e->page * PAGE_REGS + e->reg;
+        const char *name = e->book == 0 ? reg_name(e->page, e->reg) : NULL;
+        int have;
+
+        if (regmap != NULL) {
+            if (e->book != 0 || regmap[linear] < 0) {
+                printf("  b%u p%u 0x%02x: not in regmap (line %u)\n", e->book, e->page, e->reg,
+                       e->line);
+                continue;
+            }
+            have = regmap[linear];
+        } else {
+            have = live[i];
+        }
+        if (have != e->val) {
+            printf("  DIFF b%u p%u 0x%02x %-12s expected 0x%02x live 0x%02x (line %u)\n", e->book,
+                   e->page, e->reg, name ? name : "", e->val, have, e->line);
+            diffs++;
+        }
+    }
+    free(live);
+    return diffs;
+}
+
+static int cmd_apply(bus_t *bus, const conf_t *conf, int verify) {
+    reg_write_t *final;
+    double t0 = now_ms();
+    double t_write;
+    unsigned int n_final;
+    int diffs = 0;
+
+    for (unsigned int i = 0; i < conf->count; i++) {
+        const reg_write_t *w = &conf->writes[i];
+
+        if (bus->verbose) {
+            printf("write book=%u page=%u reg=0x%02x val=0x%02x linear=0x%04x\n", w->book, w->page,
+                   w->reg, w->val, w->page * PAGE_REGS + w->reg);
+        }
+        if (bus_access(bus, w->book, w->page, w->reg, &w->val, NULL) != 0) {
+            return 1;
+        }
+        // A delay splits the batch: the writes before it must have landed
+        if (w->delay_ms > 0) {
+            if (bus_flush(bus) != 0) {
+                return 1;
+            }
+            if (bus->dry_run) {
+                printf("sleep %ums\n", w->delay_ms);
+            } else {
+                usleep(w->delay_ms * 1000);
+            }
+        }
+    }
+    if (bus_flush(bus) != 0) {
+        return 1;
+    }
+    t_write = now_ms() - t0;
+    printf("applied %u writes in %u ioctls (%u messages), %.2f ms\n", conf->count, bus->ioctls,
+           bus->messages, t_write);
+
+    if (!verify) {
+        return 0;
+    }
+    final = calloc(conf->count ? conf->count : 1, sizeof(*final));
+    if (final == NULL) {
+        return 1;
+    }
+    n_final = conf_final_state(conf, final);
+    t0 = now_ms();
+    diffs = compare_state(bus, NULL, final, n_final);
+    free(final);
+    if (diffs < 0) {
+        return 1;
+    }
+    printf("verified %u registers, %d differ, %.2f ms\n", n_final, diffs, now_ms() - t0);
+    return diffs > 0 ? 1 : 0;
+}
+
+static int cmd_diff(bus_t *bus, const conf_t *conf, int bus_nr, int use_regmap) {
+    static int16_t regmap[MAX_PAGES * PAGE_REGS];
+    reg_write_t *final;
+    unsigned int n_final;
+    double t0 = now_ms();
+    int diffs;
+
+    if (use_regmap && regmap_load(bus_nr, bus->addr, regmap, MAX_PAGES * PAGE_REGS) < 0) {
+        return 1;
+    }
+    final = calloc(conf->count ? conf->count : 1, sizeof(*final));
+    if (final == NULL) {
+        return 1;
+    }
+    n_final = conf_final_state(conf, final);
+    diffs = compare_state(bus, use_regmap ? regmap : NULL, final, n_final);
+    free(final);
+    if (diffs < 0) {
+        return 1;
+    }
+    printf("%u registers compared against %s, %d differ, %.2f ms\n", n_final,
+           use_regmap ? "regmap debugfs" : "the device", diffs, now_ms() - t0);
+    return diffs > 0 ? 1 : 0;
+}
+
+static int cmd_dump(bus_t *bus, int bus_nr, const int *pages, unsigned int n_pages, int all,
+                    int single_reg, int use_regmap) {
+    static uint8_t live[MAX_PAGES][PAGE_REGS];
+    static int16_t regmap[MAX_PAGES * PAGE_REGS];
+    int have_regmap = 0;
+    double t0 = now_ms();
+
+    if (use_regmap) {
+        have_regmap = regmap_load(bus_nr, bus->addr, regmap, MAX_PAGES * PAGE_REGS) > 0;
+    }
+
+    // One pass over every register that will be printed
+    for (unsigned int i = 0; i < n_pages; i++) {
+        for (unsigned int reg = 0; reg < PAGE_REGS; reg++) {
+            int wanted = single_reg >= 0 ? (int)reg == single_reg
+                       : all || reg_name((unsigned int)pages[i], (uint8_t)reg) != NULL;
+
+            if (wanted && bus_access(bus, 0, pages[i], (uint8_t)reg, NULL,
+                                     &live[pages[i]][reg]) != 0) {
+                return 1;
+            }
+        }
+    }
+    if (bus_flush(bus) != 0) {
+        return 1;
+    }
+    if (bus->dry_run) {
+        return 0;
+    }
+
+    for (unsigned int i = 0; i < n_pages; i++) {
+        int page = pages[i];
+
+        if (single_reg < 0) {
+            printf("=== page %d (addr 0x%02x) ===\n", page, bus->addr);
+        }
+        for (unsigned int reg = 0; reg < PAGE_REGS; reg++) {
+            const char *name = reg_name((unsigned int)page, (uint8_t)reg);
+            unsigned int linear = (unsigned int)page * PAGE_REGS + reg;
+            uint8_t val = live[page][reg];
+
+            if (single_reg >= 0 ? (int)reg != single_reg : !all && name == NULL) {
+                continue;
+            }
+            printf("p%-1d 0x%02x 0x%02x", page, reg, val);
+            if (name != NULL) {
+                printf("  %-12s", name);
+            }
+            printf("  linear=0x%04x", linear);
+            if (have_regmap && regmap[linear] >= 0) {
+                printf("  regmap: %02x%s", regmap[linear], regmap[linear] != val ? " (stale)" : "");
+            }
+            printf("\n");
+            if (page == 0) {
+                decode_reg((uint8_t)reg, val);
+            }
+        }
+    }
+    printf("read in %u ioctls (%u messages), %.2f ms\n", bus->ioctls, bus->messages, now_ms() - t0);
+    return 0;
+}
+
+static void print_usage(const char *prog) {
+    printf("Usage: %s [options] COMMAND\n", prog);
+    printf("\n");
+    printf("Commands:\n");
+    printf("  dump [PAGE...]        Decoded key registers (default pages 0 1)\n");
+    printf("  apply [CONF]          Write CONF (default %s)\n", DEFAULT_CONF);
+    printf("  diff [CONF]           Compare the state CONF leaves behind with the live one\n");
+    printf("\n");
+    printf("Options:\n");
+    printf("  -b, --bus N           I2C adapter (default %d, DT510 &i2c2)\n", DEFAULT_BUS);
+    printf("  -a, --addr ADDR       7-bit address, or 8-bit as in TI dumps (default 0x%02x)\n",
+           DEFAULT_ADDR);
+    printf("  -A, --all             dump: every register of each page\n");
+    printf("  -r, --reg REG         dump: a single register (hex)\n");
+    printf("  -R, --regmap          dump: show regmap debugfs values; diff: compare with them\n");
+    printf("  -V, --verify          apply: read the final state back and compare\n");
+    printf("      --strict-addr     Fail if a Michael-format file addr is not the target\n");
+    printf("  -n, --dry-run         Print the I2C_RDWR batches instead of issuing them\n");
+    printf("  -v, --verbose         Print every write and batch\n");
+    printf("  -h, --help            Show this help\n");
+    printf("\n");
+    printf("Env: TAA5412_I2C_ADDR, TAA5412_REGS_CONF\n");
+}
+
+int main(int argc, char *argv[]) {
+    enum { OPT_STRICT_ADDR = 0x100 };
+    static const struct option long_opts[] = {
+        { "bus", required_argument, NULL, 'b' },
+        { "addr", required_argument, NULL, 'a' },
+        { "all", no_argument, NULL, 'A' },
+        { "reg", required_argument, NULL, 'r' },
+        { "regmap", no_argument, NULL, 'R' },
+        { "verify", no_argument, NULL, 'V' },
+        { "strict-addr", no_argument, NULL, OPT_STRICT_ADDR },
+        { "dry-run", no_argument, NULL, 'n' },
+        { "verbose", no_argument, NULL, 'v' },
+        { "help", no_argument, NULL, 'h' },
+        { NULL, 0, NULL, 0 }
+    };
+    bus_t bus = { .fd = -1, .addr = DEFAULT_ADDR };
+    const char *conf_path = getenv("TAA5412_REGS_CONF");
+    const char *env_addr = getenv("TAA5412_I2C_ADDR");
+    const char *command;
+    char driver[256];
+    int bus_nr = DEFAULT_BUS;
+    int all = 0;
+    int single_reg = -1;
+    int use_regmap = 0;
+    int verify = 0;
+    int strict_addr = 0;
+    int ret;
+    int opt;
+
+    if (env_addr != NULL && parse_addr(env_addr, &bus.addr) != 0) {
+        fprintf(stderr, "dt510-taa5412-regs: bad TAA5412_I2C_ADDR '%s'\n", env_addr);
+        return 2;
+    }
+
+    while ((opt = getopt_long(argc, argv, "b:a:Ar:RVnvh", long_opts, NULL)) != -1) {
+        switch (opt) {
+        case 'b':
+            bus_nr = atoi(optarg);
+            break;
+        case 'a':
+            if (parse_addr(optarg, &bus.addr) != 0) {
+                fprintf(stderr, "dt510-taa5412-regs: bad address '%s'\n", optarg);
+                return 2;
+            }
+            break;
+        case 'A':
+            all = 1;
+            break;
+        case 'r': {
+            uint8_t reg;
+
+            if (parse_byte(optarg, &reg) != 0 || reg >= PAGE_REGS) {
+                fprintf(stderr, "dt510-taa5412-regs: bad register '%s'\n", optarg);
+                return 2;
+            }
+            single_reg = reg;
+            break;
+        }
+        case 'R':
+            use_regmap = 1;
+            break;
+        case 'V':
+            verify = 1;
+            break;
+        case OPT_STRICT_ADDR:
+            strict_addr = 1;
+            break;
+        case 'n':
+            bus.dry_run = 1;
+            break;
+        case 'v':
+            bus.verbose = 1;
+            break;
+        case 'h':
+            print_usage(argv[0]);
+            return 0;
+        default:
+            print_usage(argv[0]);
+            return 2;
+        }
+    }
+    if (optind >= argc) {
+        print_usage(argv[0]);
+        return 2;
+    }
+    command = argv[optind++];
+    if (conf_path == NULL) {
+        conf_path = DEFAULT_CONF;
+    }
+
+    if (strcmp(command, "dump") == 0) {
+        int pages[MAX_PAGES];
+        unsigned int n_pages = 0;
+
+        for (; optind < argc && n_pages < MAX_PAGES; optind++) {
+            char *end;
+            long p = strtol(argv[optind], &end, 0);
+
+            if (*end != '\0' || p < 0 || p >= MAX_PAGES) {
+                fprintf(stderr, "dt510-taa5412-regs: bad page '%s'\n", argv[optind]);
+                return 2;
+            }
+            pages[n_pages++] = (int)p;
+        }
+        if (n_pages == 0) {
+            pages[n_pages++] = 0;
+            if (single_reg < 0) {
+                pages[n_pages++] = 1;
+            }
+        }
+        if (bus_open(&bus, bus_nr) != 0) {
+            return 1;
+        }
+        driver_bound(bus_nr, bus.addr, driver, sizeof(driver));
+        printf("TAA5412 register dump bus=%d addr=0x%02x driver=%s\n", bus_nr, bus.addr, driver);
+        ret = cmd_dump(&bus, bus_nr, pages, n_pages, all, single_reg, use_regmap);
+    } else if (strcmp(command, "apply") == 0 || strcmp(command, "diff") == 0) {
+        conf_t conf;
+
+        if (optind < argc) {
+            conf_path = argv[optind++];
+        }
+        if (conf_load(&conf, conf_path, bus.addr, strict_addr) != 0) {
+            free(conf.writes);
+            return 1;
+        }
+        if ((command[0] == 'a' || !use_regmap) && bus_open(&bus, bus_nr) != 0) {
+            free(conf.writes);
+            return 1;
+        }
+        driver_bound(bus_nr, bus.addr, driver, sizeof(driver));
+        printf("%s %s bus=%d addr=0x%02x driver=%s\n", command, conf_path, bus_nr, bus.addr, driver);
+        ret = command[0] == 'a' ? cmd_apply(&bus, &conf, verify)
+                                : cmd_diff(&bus, &conf, bus_nr, use_regmap);
+        free(conf.writes);
+    } else {
+        fprintf(stderr, "dt510-taa5412-regs: unknown command '%s'\n", command);
+        print_usage(argv[0]);
+        return 2;
+    }
+
+    if (bus.fd >= 0) {
+        close(bus.fd);
+    }
+    return ret;
+}
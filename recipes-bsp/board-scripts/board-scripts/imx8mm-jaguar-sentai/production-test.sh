@@ -133,10 +133,10 @@ if [[ "$response" =~ ^([yY][eE][sS]|[yY])$ ]]; then
 	echo -e "\n\nNow recording 5s audio on FIRST microphone channel\n"
 	read -r -p "Press RETURN key to start recording and then start counting up in a clear voice"
 	echo -e "\nStarted recording...\n"
-	su -c "arecord -Dhw:2,0 -c2 -f s16_le -r48000 -d5 test-l-stereo.wav && python3 /usr/share/board-scripts/extract_channel.py test-l-stereo.wav test-l.wav 0 && rm -f test-l-stereo.wav" fio
+	su -c "arecord -Dhw:2,0 -c2 -f s16_le -r48000 -d5 test-l-stereo.wav && /usr/sbin/wav-channels extract test-l-stereo.wav test-l.wav 0 && rm -f test-l-stereo.wav" fio
 	read -r -p "Done recording. Press RETURN key to play back recording"
 	echo -e "\n\nNow playing back recording\n"
-	su -c "python3 /usr/share/board-scripts/mono_to_stereo.py test-l.wav test-l-stereo.wav && aplay -Dhw:1,0 test-l-stereo.wav && rm -f test-l.wav test-l-stereo.wav" fio
+	su -c "/usr/sbin/wav-channels duplicate test-l.wav test-l-stereo.wav && aplay -Dhw:1,0 test-l-stereo.wav && rm -f test-l.wav test-l-stereo.wav" fio
 	read -r -p "Did you hear the audio play back [y/N] " response
 	if [[ ! "$response" =~ ^([yY][eE][sS]|[yY])$ ]]; then
 		echo TEST FAILED
@@ -147,10 +147,10 @@ if [[ "$response" =~ ^([yY][eE][sS]|[yY])$ ]]; then
 	echo -e "\n\nNow recording 5s audio on SECOND microphone channel\n"
 	read -r -p "Press RETURN key to start recording and then start counting up in a clear voice"
 	echo -e "\nStarted recording...\n"
-	su -c "arecord -Dhw:2,0 -c2 -f s16_le -r48000 -d5 test-r-stereo.wav && python3 /usr/share/board-scripts/extract_channel.py test-r-stereo.wav test-r.wav 1 && rm -f test-r-stereo.wav" fio
+	su -c "arecord -Dhw:2,0 -c2 -f s16_le -r48000 -d5 test-r-stereo.wav && /usr/sbin/wav-channels extract test-r-stereo.wav test-r.wav 1 && rm -f test-r-stereo.wav" fio
 	read -r -p "Done recording. Press RETURN key to play back recording"
 	echo -e "\n\nNow playing back recording\n"
-	su -c "python3 /usr/share/board-scripts/mono_to_stereo.py test-r.wav test-r-stereo.wav && aplay -Dhw:1,0 test-r-stereo.wav && rm -f test-r.wav test-r-stereo.wav" fio
+	su -c "/usr/sbin/wav-channels duplicate test-r.wav test-r-stereo.wav && aplay -Dhw:1,0 test-r-stereo.wav && rm -f test-r.wav test-r-stereo.wav" fio
 	read -r -p "Did you hear the audio play back [y/N] " response
 	if [[ ! "$response" =~ ^([yY][eE][sS]|[yY])$ ]]; then
 		echo TEST FAILED
@@ -0,0 +1,1058 @@
+/* SPDX-License-Identifier: MIT */
+/*
+ * pcm-latency - round-trip latency and jitter of the asound.conf PCM chains
+ *
+ * Plays a short chirp through a playback PCM (tannoy_both_mono,
+ * driver_speaker, spk, ...) and finds it again in a capture PCM
+ * (driver_mic, mic, ...) with a matched filter, at a list of period and
+ * buffer sizes. Both streams are timestamped around every read and
+ * write, and snd_pcm_delay() on each side places the chirp at the DAC
+ * and at the ADC to a fraction of a frame, so each size reports:
+ *
+ *   - path: DAC to ADC, i.e. what the plug/rate/route chains, the codecs
+ *     and the air add on top of the ALSA buffers. This is the echo delay
+ *     an AEC must cover.
+ *   - rtt: from the write() carrying the chirp to the read() returning
+ *     it, the latency an application sees at that period/buffer size.
+ *   - jitter: the standard deviation of both over the trials.
+ *
+ * -l lists the PCMs defined in asound.conf and the directions each one
+ * opens in; -A measures every playback PCM there against -C.
+ *
+ * On a host without the codecs, -F FILE stands in for the loopback: the
+ * playback side writes into FILE at the position it will be "heard",
+ * -D ms later, and the capture side reads it back on the same clock. The
+ * file is mapped, so it holds the last few seconds of "air" afterwards.
+ *
+ *   pcm-latency -l                                     # PCMs in /etc/asound.conf
+ *   pcm-latency -P tannoy_both_mono -C driver_mic
+ *   pcm-latency -A -C driver_mic -g 240/960,480/1920,1024/4096 -j
+ *   pcm-latency -F /tmp/pcm-latency.raw -D 7.5         # host run
+ */
+
+#define _GNU_SOURCE
+#include <ctype.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <math.h>
+#include <sched.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#include <alsa/asoundlib.h>
+
+#if defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+#define MAX_CHANNELS        8
+#define MAX_CONFIGS         16
+#define MAX_PCMS            64
+#define NAME_LEN            64
+
+#define DEFAULT_CONF        "/etc/asound.conf"
+#define DEFAULT_DEVICE      "default"
+#define DEFAULT_RATE        48000
+#define DEFAULT_CHANNELS    2
+#define DEFAULT_CONFIGS     "240/960,480/1920,1024/4096"
+#define DEFAULT_TRIALS      10
+#define DEFAULT_MAX_MS      300
+#define DEFAULT_LEVEL       -12.0
+#define DEFAULT_MIN_NCC     0.3
+#define DEFAULT_STANDIN_MS  5.0
+#define CHIRP_MS            10
+#define CHIRP_LOW_HZ        500.0
+#define CHIRP_HIGH_HZ       8000.0
+#define LEAD_MS             200
+#define STANDIN_RING_S      4
+#define STANDIN_NOISE       0.001f
+
+typedef struct {
+    snd_pcm_uframes_t period;
+    snd_pcm_uframes_t buffer;
+} config_t;
+
+// One capture read: where it starts, when it returned, what was still queued
+typedef struct {
+    uint64_t start;
+    double t;
+    long delay;
+    snd_pcm_uframes_t frames;
+} block_t;
+
+// The write carrying the start of one chirp
+typedef struct {
+    double t;
+    double dac;         // when its first frame reaches the DAC
+} mark_t;
+
+typedef struct {
+    unsigned int trials;
+    unsigned int detected;
+    unsigned int xruns;
+    snd_pcm_uframes_t play_period, play_buffer;
+    snd_pcm_uframes_t cap_period, cap_buffer;
+    double path[256];
+    double rtt[256];
+    double queue_ms;
+    double ncc;
+} result_t;
+
+typedef struct {
+    const char *path;
+    double delay_ms;
+    int16_t *ring;
+    size_t size;
+    uint64_t delay;
+    uint64_t written;
+    uint64_t read;
+    snd_pcm_uframes_t buffer;
+    struct timespec start;
+    uint32_t seed;
+} standin_t;
+
+static int verbose;
+static int use_scalar;
+static unsigned int rate = DEFAULT_RATE;
+static unsigned int play_ch = DEFAULT_CHANNELS;
+static unsigned int cap_ch = DEFAULT_CHANNELS;
+static int pick_ch = -1;
+static standin_t standin;
+
+static double now_s(void) {
+    struct timespec t;
+
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (double)t.tv_sec + (double)t.tv_nsec / 1e9;
+}
+
+/* ---- asound.conf ---- */
+
+// Top-level "pcm.NAME" / "pcm.!NAME" definitions, in file order
+static int list_conf_pcms(const char *path, char names[][NAME_LEN], int max, int internal) {
+    FILE *f = fopen(path, "r");
+    char line[512];
+    int n = 0;
+
+    if (!f) {
+        fprintf(stderr, "pcm-latency: %s: %s\n", path, strerror(errno));
+        return -1;
+    }
+    while (fgets(line, sizeof(line), f) && n < max) {
+        char *p = line;
+        size_t len;
+
+        while (*p == ' ' || *p == '\t') {
+            p++;
+        }
+        if (strncmp(p, "pcm.", 4) != 0) {
+            continue;
+        }
+        p += 4;
+        if (*p == '!') {
+            p++;
+        }
+        for (len = 0; isalnum((unsigned char)p[len]) || p[len] == '_' || p[len] == '-'; len++) {
+        }
+        if (len == 0 || len >= NAME_LEN || (p[0] == '_' && !internal)) {
+            continue;
+        }
+        memcpy(names[n], p, len);
+        names[n][len] = '\0';
+        n++;
+    }
+    fclose(f);
+    return n;
+}
+
+// 1 if the PCM opens in this direction onto something other than "null"
+static int opens(const char *name, snd_pcm_stream_t dir, const char **type) {
+    snd_pcm_t *pcm;
+    int err = snd_pcm_open(&pcm, name, dir, SND_PCM_NONBLOCK);
+    int real;
+
+    if (err == -EBUSY) {
+        *type = "busy";
+        return 1;
+    }
+    if (err < 0) {
+        return 0;
+    }
+    real = snd_pcm_type(pcm) != SND_PCM_TYPE_NULL;
+    if (real) {
+        *type = snd_pcm_type_name(snd_pcm_type(pcm));
+    }
+    snd_pcm_close(pcm);
+    return real;
+}
+
+/* ---- Stimulus and matched filter ---- */
+
+static float *make_chirp(size_t *frames, double level_db) {
+    size_t n = (size_t)rate * CHIRP_MS / 1000;
+    double high = fmin(CHIRP_HIGH_HZ, 0.4 * rate);
+    double amp = pow(10.0, level_db / 20.0);
+    float *c = malloc(n * sizeof(*c));
+
+    if (!c) {
+        return NULL;
+    }
+    // Linear sweep under a Hann window: one sharp correlation peak
+    for (size_t i = 0; i < n; i++) {
+        double t = (double)i / rate;
+        double T = (double)n / rate;
+        double phase = 2 * M_PI * (CHIRP_LOW_HZ * t + (high - CHIRP_LOW_HZ) * t * t / (2 * T));
+        double w = 0.5 - 0.5 * cos(2 * M_PI * i / (n - 1));
+
+        c[i] = (float)(amp * w * sin(phase));
+    }
+    *frames = n;
+    return c;
+}
+
+static float dot_scalar(const float *a, const float *b, size_t n) {
+    float s = 0;
+
+    for (size_t i = 0; i < n; i++) {
+        s += a[i] * b[i];
+    }
+    return s;
+}
+
+#if defined(__aarch64__)
+static float dot_neon(const float *a, const float *b, size_t n) {
+    float32x4_t s0 = vdupq_n_f32(0.0f);
+    float32x4_t s1 = vdupq_n_f32(0.0f);
+    size_t i = 0;
+    float s;
+
+    for (; i + 8 <= n; i += 8) {
+        s0 = vfmaq_f32(s0, vld1q_f32(a + i), vld1q_f32(b + i));
+        s1 = vfmaq_f32(s1, vld1q_f32(a + i + 4), vld1q_f32(b + i + 4));
+    }
+    s = vaddvq_f32(vaddq_f32(s0, s1));
+    for (; i < n; i++) {
+        s += a[i] * b[i];
+    }
+    return s;
+}
+#endif
+
+static float dot(const float *a, const float *b, size_t n) {
+#if defined(__aarch64__)
+    if (!use_scalar) {
+        return dot_neon(a, b, n);
+    }
+#endif
+    return dot_scalar(a, b, n);
+}
+
+/*
+ * Normalised cross-correlation of the chirp over x[from, to); returns the
+ * peak |NCC| and its position, refined to a fraction of a frame.
+ */
+static double match(const float *x, size_t from, size_t to, const float *chirp, size_t n,
+                    double *pos) {
+    double ref_e = dot_scalar(chirp, chirp, n);
+    double e = 0;
+    double best = 0;
+    size_t at = from;
+    double *ncc;
+
+    if (to <= from) {
+        return 0;
+    }
+    ncc = malloc((to - from) * sizeof(*ncc));
+    if (!ncc) {
+        return 0;
+    }
+    e = dot_scalar(x + from, x + from, n);
+    for (size_t l = from; l < to; l++) {
+        double c = dot(x + l, chirp, n);
+        double v = e > 1e-12 ? fabs(c) / sqrt(e * ref_e) : 0;
+
+        ncc[l - from] = v;
+        if (v > best) {
+            best = v;
+            at = l;
+        }
+        e += (double)x[l + n] * x[l + n] - (double)x[l] * x[l];
+        if (e < 0) {
+            e = 0;
+        }
+    }
+    *pos = (double)at;
+    if (at > from && at + 1 < to) {
+        double a = ncc[at - from - 1];
+        double b = ncc[at - from];
+        double c = ncc[at - from + 1];
+        double d = a - 2 * b + c;
+
+        if (d < 0) {
+            *pos += 0.5 * (a - c) / d;
+        }
+    }
+    free(ncc);
+    return best;
+}
+
+/* ---- ALSA streams ---- */
+
+static int pcm_setup(snd_pcm_t **pcm, const char *name, snd_pcm_stream_t dir, unsigned int channels,
+                     const config_t *cfg, snd_pcm_uframes_t *period, snd_pcm_uframes_t *buffer) {
+    const char *what = dir == SND_PCM_STREAM_PLAYBACK ? "play" : "capture";
+    snd_pcm_hw_params_t *hw;
+    snd_pcm_sw_params_t *sw;
+    unsigned int r = rate;
+    int err;
+
+    if ((err = snd_pcm_open(pcm, name, dir, 0)) < 0) {
+        fprintf(stderr, "pcm-latency: %s: %s\n", name, snd_strerror(err));
+        return -1;
+    }
+    *period = cfg->period;
+    *buffer = cfg->buffer;
+    snd_pcm_hw_params_alloca(&hw);
+    snd_pcm_sw_params_alloca(&sw);
+    if ((err = snd_pcm_hw_params_any(*pcm, hw)) < 0 ||
+        (err = snd_pcm_hw_params_set_access(*pcm, hw, SND_PCM_ACCESS_RW_INTERLEAVED)) < 0 ||
+        (err = snd_pcm_hw_params_set_format(*pcm, hw, SND_PCM_FORMAT_S16_LE)) < 0 ||
+        (err = snd_pcm_hw_params_set_channels(*pcm, hw, channels)) < 0 ||
+        (err = snd_pcm_hw_params_set_rate_near(*pcm, hw, &r, NULL)) < 0 ||
+        (err = snd_pcm_hw_params_set_period_size_near(*pcm, hw, period, NULL)) < 0 ||
+        (err = snd_pcm_hw_params_set_buffer_size_near(*pcm, hw, buffer)) < 0 ||
+        (err = snd_pcm_hw_params(*pcm, hw)) < 0) {
+        fprintf(stderr, "pcm-latency: %s: cannot %s %u ch %u Hz period %lu buffer %lu: %s\n",
+                name, what, channels, rate, cfg->period, cfg->buffer, snd_strerror(err));
+        snd_pcm_close(*pcm);
+        return -1;
+    }
+    if (r != rate) {
+        fprintf(stderr, "pcm-latency: %s: %u Hz instead of %u\n", name, r, rate);
+        snd_pcm_close(*pcm);
+        return -1;
+    }
+    // Playback starts once the silence prefill has filled the buffer
+    snd_pcm_sw_params_current(*pcm, sw);
+    snd_pcm_sw_params_set_start_threshold(*pcm, sw, dir == SND_PCM_STREAM_PLAYBACK ? *buffer : 1);
+    snd_pcm_sw_params_set_avail_min(*pcm, sw, *period);
+    if ((err = snd_pcm_sw_params(*pcm, sw)) < 0) {
+        fprintf(stderr, "pcm-latency: %s: sw params: %s\n", name, snd_strerror(err));
+        snd_pcm_close(*pcm);
+        return -1;
+    }
+    return 0;
+}
+
+/* ---- File-backed loopback stand-in ---- */
+
+static uint64_t standin_hw(void) {
+    struct timespec t;
+
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (uint64_t)(((double)(t.tv_sec - standin.start.tv_sec) +
+                       (double)(t.tv_nsec - standin.start.tv_nsec) / 1e9) * rate);
+}
+
+static void standin_wait(uint64_t hw) {
+    struct timespec t = standin.start;
+    double s = (double)hw / rate;
+
+    t.tv_sec += (time_t)s;
+    t.tv_nsec += (long)((s - floor(s)) * 1e9);
+    if (t.tv_nsec >= 1000000000L) {
+        t.tv_sec++;
+        t.tv_nsec -= 1000000000L;
+    }
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &t, NULL) == EINTR) {
+    }
+}
+
+static int standin_open(snd_pcm_uframes_t buffer) {
+    int fd = open(standin.path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+
+    if (fd < 0) {
+        fprintf(stderr, "pcm-latency: %s: %s\n", standin.path, strerror(errno));
+        return -1;
+    }
+    standin.size = (size_t)rate * STANDIN_RING_S;
+    if (ftruncate(fd, (off_t)(standin.size * sizeof(int16_t))) < 0) {
+        fprintf(stderr, "pcm-latency: %s: %s\n", standin.path, strerror(errno));
+        close(fd);
+        return -1;
+    }
+    standin.ring = mmap(NULL, standin.size * sizeof(int16_t), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (standin.ring == MAP_FAILED) {
+        fprintf(stderr, "pcm-latency: %s: mmap: %s\n", standin.path, strerror(errno));
+        return -1;
+    }
+    standin.delay = (uint64_t)llround(standin.delay_ms * rate / 1000.0);
+    standin.buffer = buffer;
+    standin.written = 0;
+    standin.read = 0;
+    standin.seed = 1;
+    clock_gettime(CLOCK_MONOTONIC, &standin.start);
+    return 0;
+}
+
+static void standin_close(void) {
+    munmap(standin.ring, standin.size * sizeof(int16_t));
+}
+
+/* ---- Stream wrappers: ALSA, or the stand-in when pcm is NULL ---- */
+
+static snd_pcm_sframes_t play_write(snd_pcm_t *pcm, const int16_t *buf, snd_pcm_uframes_t n,
+                                    unsigned int *xruns) {
+    if (pcm) {
+        snd_pcm_sframes_t w = snd_pcm_writei(pcm, buf, n);
+
+        if (w == -EPIPE || w == -ESTRPIPE) {
+            (*xruns)++;
+            w = snd_pcm_recover(pcm, (int)w, 1);
+            if (w >= 0) {
+                w = snd_pcm_writei(pcm, buf, n);
+            }
+        }
+        return w;
+    }
+    if (standin.written + n > standin_hw() + standin.buffer) {
+        standin_wait(standin.written + n - standin.buffer);
+    }
+    if (standin.written < standin_hw() && standin.written >= standin.buffer) {
+        (*xruns)++;
+        standin.written = standin_hw();
+    }
+    // Frames reach the "air" when the hardware pointer gets to them, plus the path delay
+    for (snd_pcm_uframes_t k = 0; k < n; k++) {
+        standin.ring[(standin.written + k + standin.delay) % standin.size] = buf[k * play_ch];
+    }
+    standin.written += n;
+    return (snd_pcm_sframes_t)n;
+}
+
+static snd_pcm_sframes_t cap_read(snd_pcm_t *pcm, int16_t *buf, snd_pcm_uframes_t n,
+                                  unsigned int *xruns) {
+    uint64_t hw;
+
+    if (pcm) {
+        snd_pcm_sframes_t r = snd_pcm_readi(pcm, buf, n);
+
+        if (r == -EPIPE || r == -ESTRPIPE) {
+            (*xruns)++;
+            r = snd_pcm_recover(pcm, (int)r, 1);
+            if (r >= 0) {
+                r = snd_pcm_readi(pcm, buf, n);
+            }
+        }
+        return r;
+    }
+    hw = standin_hw();
+    if (hw < standin.read + n) {
+        standin_wait(standin.read + n);
+    } else if (hw > standin.read + standin.buffer) {
+        (*xruns)++;
+        standin.read = hw - n;
+    }
+    for (snd_pcm_uframes_t k = 0; k < n; k++) {
+        int16_t *air = &standin.ring[(standin.read + k) % standin.size];
+        float noise;
+
+        standin.seed = standin.seed * 1664525u + 1013904223u;
+        noise = STANDIN_NOISE * 32767.0f * ((float)(standin.seed >> 8) / 16777216.0f - 0.5f);
+        for (unsigned int c = 0; c < cap_ch; c++) {
+            buf[k * cap_ch + c] = (int16_t)lrintf((float)*air / (float)(c + 1) + noise);
+        }
+        *air = 0;
+    }
+    standin.read += n;
+    return (snd_pcm_sframes_t)n;
+}
+
+static long stream_delay(snd_pcm_t *pcm, int playback) {
+    snd_pcm_sframes_t d;
+
+    if (pcm) {
+        return snd_pcm_delay(pcm, &d) == 0 ? (long)d : 0;
+    }
+    return playback ? (long)(standin.written - standin_hw()) : (long)(standin_hw() - standin.read);
+}
+
+static snd_pcm_uframes_t cap_avail(snd_pcm_t *pcm) {
+    if (pcm) {
+        snd_pcm_sframes_t a = snd_pcm_avail(pcm);
+
+        return a > 0 ? (snd_pcm_uframes_t)a : 0;
+    }
+    return (snd_pcm_uframes_t)(standin_hw() - standin.read);
+}
+
+/* ---- One period/buffer size ---- */
+
+static int compare_double(const void *a, const void *b) {
+    double x = *(const double *)a;
+    double y = *(const double *)b;
+
+    return (x > y) - (x < y);
+}
+
+static void stats(const double *v, unsigned int n, double *mean, double *sd, double *lo, double *hi) {
+    double s = 0;
+    double q = 0;
+
+    *lo = *hi = n ? v[0] : 0;
+    for (unsigned int i = 0; i < n; i++) {
+        s += v[i];
+        *lo = fmin(*lo, v[i]);
+        *hi = fmax(*hi, v[i]);
+    }
+    *mean = n ? s / n : 0;
+    for (unsigned int i = 0; i < n; i++) {
+        q += (v[i] - *mean) * (v[i] - *mean);
+    }
+    *sd = n > 1 ? sqrt(q / (n - 1)) : 0;
+}
+
+static int run_config(const char *play_dev, const char *cap_dev, const config_t *cfg,
+                      unsigned int trials, unsigned int max_ms, const float *chirp, size_t chirp_n,
+                      double min_ncc, result_t *res) {
+    snd_pcm_t *play = NULL;
+    snd_pcm_t *cap = NULL;
+    size_t spacing = (size_t)rate * (max_ms + 100) / 1000 + chirp_n;
+    size_t lead = (size_t)rate * LEAD_MS / 1000;
+    size_t total;
+    size_t cap_total;
+    size_t n_blocks = 0;
+    size_t max_blocks;
+    uint64_t play_pos = 0;
+    uint64_t cap_pos = 0;
+    int16_t *pbuf = NULL;
+    int16_t *cbuf = NULL;
+    int16_t *captured = NULL;
+    float *x = NULL;
+    block_t *blocks = NULL;
+    mark_t *marks = NULL;
+    unsigned int n_marks = 0;
+    double queue_sum = 0;
+    int rc = -1;
+
+    memset(res, 0, sizeof(*res));
+    res->trials = trials;
+    if (standin.path) {
+        res->play_period = res->cap_period = cfg->period;
+        res->play_buffer = res->cap_buffer = cfg->buffer;
+        if (standin_open(cfg->buffer) < 0) {
+            return -1;
+        }
+    } else {
+        if (pcm_setup(&play, play_dev, SND_PCM_STREAM_PLAYBACK, play_ch, cfg,
+                      &res->play_period, &res->play_buffer) < 0) {
+            return -1;
+        }
+        if (pcm_setup(&cap, cap_dev, SND_PCM_STREAM_CAPTURE, cap_ch, cfg,
+                      &res->cap_period, &res->cap_buffer) < 0) {
+            snd_pcm_close(play);
+            return -1;
+        }
+    }
+
+    total = res->play_buffer + lead + trials * spacing;
+    cap_total = total + 2 * res->cap_buffer;
+    max_blocks = cap_total / res->cap_period + 8;
+    pbuf = calloc(res->play_period * play_ch, sizeof(*pbuf));
+    cbuf = calloc(res->cap_period * cap_ch, sizeof(*cbuf));
+    captured = calloc((cap_total + res->cap_period) * cap_ch, sizeof(*captured));
+    blocks = calloc(max_blocks, sizeof(*blocks));
+    marks = calloc(trials, sizeof(*marks));
+    x = calloc(cap_total + res->cap_period + chirp_n, sizeof(*x));
+    if (!pbuf || !cbuf || !captured || !blocks || !marks || !x) {
+        fprintf(stderr, "pcm-latency: out of memory\n");
+        goto out;
+    }
+
+    // Silence prefill starts playback, then capture follows
+    while (play_pos < res->play_buffer) {
+        snd_pcm_sframes_t w = play_write(play, pbuf, res->play_period, &res->xruns);
+
+        if (w < 0) {
+            fprintf(stderr, "pcm-latency: %s: %s\n", play_dev, snd_strerror((int)w));
+            goto out;
+        }
+        play_pos += (uint64_t)w;
+    }
+    if (cap) {
+        snd_pcm_start(cap);
+    } else {
+        standin.read = standin_hw();
+    }
+
+    while (play_pos < total || cap_pos < cap_total) {
+        if (play_pos < total) {
+            snd_pcm_uframes_t n = res->play_period;
+            int mark = -1;
+            unsigned int offset = 0;
+            snd_pcm_sframes_t w;
+            long delay;
+            double t;
+
+            for (snd_pcm_uframes_t k = 0; k < n; k++) {
+                uint64_t p = play_pos + k;
+                int16_t s = 0;
+
+                if (p >= res->play_buffer + lead) {
+                    uint64_t rel = p - res->play_buffer - lead;
+                    size_t trial = rel / spacing;
+                    size_t i = rel % spacing;
+
+                    if (trial < trials && i < chirp_n) {
+                        s = (int16_t)lrintf(chirp[i] * 32767.0f);
+                        if (i == 0) {
+                            mark = (int)trial;
+                            offset = (unsigned int)k;
+                        }
+                    }
+                }
+                for (unsigned int c = 0; c < play_ch; c++) {
+                    pbuf[k * play_ch + c] = s;
+                }
+            }
+            delay = stream_delay(play, 1);
+            t = now_s();
+            w = play_write(play, pbuf, n, &res->xruns);
+            if (w < 0) {
+                fprintf(stderr, "pcm-latency: %s: %s\n", play_dev, snd_strerror((int)w));
+                goto out;
+            }
+            if (mark >= 0) {
+                marks[mark].t = t;
+                marks[mark].dac = t + (double)(delay + offset) / rate;
+                queue_sum += (double)(delay + offset) / rate;
+                n_marks = (unsigned int)mark + 1;
+            }
+            play_pos += (uint64_t)w;
+        }
+
+        // One period per write, plus whatever drift has let pile up
+        do {
+            snd_pcm_sframes_t r;
+
+            if (cap_pos >= cap_total || n_blocks == max_blocks) {
+                break;
+            }
+            r = cap_read(cap, cbuf, res->cap_period, &res->xruns);
+            if (r < 0) {
+                fprintf(stderr, "pcm-latency: %s: %s\n", cap_dev, snd_strerror((int)r));
+                goto out;
+            }
+            blocks[n_blocks].t = now_s();
+            blocks[n_blocks].delay = stream_delay(cap, 0);
+            blocks[n_blocks].start = cap_pos;
+            blocks[n_blocks].frames = (snd_pcm_uframes_t)r;
+            n_blocks++;
+            memcpy(captured + cap_pos * cap_ch, cbuf, (size_t)r * cap_ch * sizeof(*cbuf));
+            cap_pos += (uint64_t)r;
+        } while (cap_avail(cap) >= res->cap_period);
+    }
+
+    // Find each chirp near where its DAC time says it should be
+    for (unsigned int m = 0; m < n_marks; m++) {
+        size_t b = 0;
+        double at;
+        double from_f;
+        size_t from;
+        size_t to;
+        double best = 0;
+        double pos = 0;
+        double adc;
+
+        // Capture instant of a block's first frame: read time minus what came after it
+        while (b + 1 < n_blocks &&
+               blocks[b + 1].t - (double)(blocks[b + 1].delay + blocks[b + 1].frames) / rate <= marks[m].dac) {
+            b++;
+        }
+        at = (double)blocks[b].start +
+             (marks[m].dac - (blocks[b].t - (double)(blocks[b].delay + blocks[b].frames) / rate)) * rate;
+        from_f = at - 2.0 * res->cap_period;
+        from = from_f > 0 ? (size_t)from_f : 0;
+        to = (size_t)fmax(0.0, at) + (size_t)rate * max_ms / 1000;
+        if (to + chirp_n > cap_pos) {
+            to = cap_pos > chirp_n ? cap_pos - chirp_n : 0;
+        }
+
+        for (unsigned int c = 0; c < cap_ch; c++) {
+            double p = 0;
+            double v;
+
+            if (pick_ch >= 0 && (int)c != pick_ch) {
+                continue;
+            }
+            for (size_t i = 0; i < cap_pos; i++) {
+                x[i] = captured[i * cap_ch + c] / 32768.0f;
+            }
+            v = match(x, from, to, chirp, chirp_n, &p);
+            if (v > best) {
+                best = v;
+                pos = p;
+            }
+        }
+        if (verbose) {
+            fprintf(stderr, "  trial %u: NCC %.2f at frame %.2f (expected near %.0f)\n", m, best, pos, at);
+        }
+        if (best < min_ncc) {
+            continue;
+        }
+        for (b = 0; b + 1 < n_blocks && blocks[b + 1].start <= (uint64_t)pos; b++) {
+        }
+        adc = blocks[b].t - (double)(blocks[b].delay + blocks[b].frames - (pos - (double)blocks[b].start)) / rate;
+        res->path[res->detected] = (adc - marks[m].dac) * 1e3;
+        res->rtt[res->detected] = (blocks[b].t - marks[m].t) * 1e3;
+        res->ncc += best;
+        res->detected++;
+    }
+    if (res->detected) {
+        res->ncc /= res->detected;
+    }
+    res->queue_ms = n_marks ? queue_sum / n_marks * 1e3 : 0;
+    rc = 0;
+
+out:
+    if (play) {
+        snd_pcm_drop(play);
+        snd_pcm_close(play);
+    }
+    if (cap) {
+        snd_pcm_drop(cap);
+        snd_pcm_close(cap);
+    }
+    if (standin.path) {
+        standin_close();
+    }
+    free(pbuf);
+    free(cbuf);
+    free(captured);
+    free(blocks);
+    free(marks);
+    free(x);
+    return rc;
+}
+
+/* ---- Output ---- */
+
+static void print_result(const char *play_dev, const char *cap_dev, const result_t *r, int json) {
+    double pm, ps, plo, phi, rm, rs, rlo, rhi;
+    double med[256];
+
+    stats(r->path, r->detected, &pm, &ps, &plo, &phi);
+    stats(r->rtt, r->detected, &rm, &rs, &rlo, &rhi);
+    memcpy(med, r->path, r->detected * sizeof(double));
+    qsort(med, r->detected, sizeof(double), compare_double);
+
+    if (json) {
+        printf("{\"playback\":\"%s\",\"capture\":\"%s\",\"rate\":%u,"
+               "\"play_period\":%lu,\"play_buffer\":%lu,\"cap_period\":%lu,\"cap_buffer\":%lu,"
+               "\"trials\":%u,\"detected\":%u,\"xruns\":%u,\"ncc\":%.3f,\"queue_ms\":%.3f,",
+               play_dev, cap_dev, rate, r->play_period, r->play_buffer, r->cap_period, r->cap_buffer,
+               r->trials, r->detected, r->xruns, r->ncc, r->queue_ms);
+        if (r->detected) {
+            printf("\"path_ms\":{\"mean\":%.3f,\"median\":%.3f,\"min\":%.3f,\"max\":%.3f,\"jitter\":%.3f},"
+                   "\"rtt_ms\":{\"mean\":%.3f,\"min\":%.3f,\"max\":%.3f,\"jitter\":%.3f}}\n",
+                   pm, med[r->detected / 2], plo, phi, ps, rm, rlo, rhi, rs);
+        } else {
+            printf("\"path_ms\":null,\"rtt_ms\":null}\n");
+        }
+        return;
+    }
+    printf("  %5lu/%-5lu  %2u/%-2u", r->play_period, r->play_buffer, r->detected, r->trials);
+    if (r->detected) {
+        printf("  path %7.2f ms +-%5.2f (%.2f..%.2f)  rtt %7.2f ms +-%5.2f (%.2f..%.2f)  queue %6.2f ms",
+               pm, ps, plo, phi, rm, rs, rlo, rhi, r->queue_ms);
+    } else {
+        printf("  no chirp found (is %s audible in %s?)", play_dev, cap_dev);
+    }
+    if (r->xruns) {
+        printf("  xruns %u", r->xruns);
+    }
+    if (r->cap_period != r->play_period || r->cap_buffer != r->play_buffer) {
+        printf("  [capture %lu/%lu]", r->cap_period, r->cap_buffer);
+    }
+    printf("\n");
+}
+
+static int parse_configs(const char *list, config_t *cfg) {
+    const char *p = list;
+    int n = 0;
+
+    while (*p && n < MAX_CONFIGS) {
+        char *end;
+        unsigned long period = strtoul(p, &end, 10);
+        unsigned long buffer = 4 * period;
+
+        if (end == p || period == 0) {
+            return -1;
+        }
+        p = end;
+        if (*p == '/') {
+            buffer = strtoul(p + 1, &end, 10);
+            if (end == p + 1 || buffer < 2 * period) {
+                return -1;
+            }
+            p = end;
+        }
+        cfg[n].period = period;
+        cfg[n].buffer = buffer;
+        n++;
+        if (*p == ',') {
+            p++;
+        } else if (*p) {
+            return -1;
+        }
+    }
+    return n;
+}
+
+static void print_usage(const char *prog) {
+    printf("Usage: %s [options]\n", prog);
+    printf("\n");
+    printf("Paths:\n");
+    printf("  -P, --playback PCM    Playback PCM (default %s)\n", DEFAULT_DEVICE);
+    printf("  -C, --capture PCM     Capture PCM (default %s)\n", DEFAULT_DEVICE);
+    printf("  -A, --all             Every playback PCM in the config against -C\n");
+    printf("  -l, --list            List the config's PCMs and the directions they open in\n");
+    printf("  -a, --conf FILE       ALSA config to read PCM names from (default %s)\n", DEFAULT_CONF);
+    printf("  -u, --internal        Include _underscore helper PCMs\n");
+    printf("\n");
+    printf("Measurement:\n");
+    printf("  -g, --sizes LIST      PERIOD[/BUFFER] frames, comma separated (default %s)\n", DEFAULT_CONFIGS);
+    printf("  -n, --trials N        Chirps per size (default %d)\n", DEFAULT_TRIALS);
+    printf("  -L, --max-latency MS  Search window after the DAC time (default %d)\n", DEFAULT_MAX_MS);
+    printf("  -r, --rate HZ         Sample rate (default %d)\n", DEFAULT_RATE);
+    printf("  -p, --play-channels N Playback channels, all carry the chirp (default %d)\n", DEFAULT_CHANNELS);
+    printf("  -c, --channels N      Capture channels (default %d)\n", DEFAULT_CHANNELS);
+    printf("  -k, --channel N       Only look for the chirp in capture channel N\n");
+    printf("  -V, --level DBFS      Chirp peak level (default %.0f)\n", DEFAULT_LEVEL);
+    printf("  -m, --min-ncc X       Correlation needed to count a chirp (default %.1f)\n", DEFAULT_MIN_NCC);
+    printf("  -R, --realtime PRIO   Run the streams from SCHED_FIFO at PRIO\n");
+    printf("\n");
+    printf("Host runs:\n");
+    printf("  -F, --file FILE       File-backed loopback stand-in instead of ALSA\n");
+    printf("  -D, --delay MS        Stand-in DAC to ADC delay (default %.1f)\n", DEFAULT_STANDIN_MS);
+    printf("\n");
+    printf("  -j, --json            One JSON line per size\n");
+    printf("  -S, --scalar          Use the scalar correlator\n");
+    printf("  -v, --verbose         Print every trial\n");
+    printf("  -h, --help            Show this help\n");
+    printf("\n");
+    printf("Exit status: 0 every size found its chirps, 1 some did not, 2 error.\n");
+}
+
+int main(int argc, char *argv[]) {
+    static const struct option long_opts[] = {
+        { "playback", required_argument, NULL, 'P' },
+        { "capture", required_argument, NULL, 'C' },
+        { "all", no_argument, NULL, 'A' },
+        { "list", no_argument, NULL, 'l' },
+        { "conf", required_argument, NULL, 'a' },
+        { "internal", no_argument, NULL, 'u' },
+        { "sizes", required_argument, NULL, 'g' },
+        { "trials", required_argument, NULL, 'n' },
+        { "max-latency", required_argument, NULL, 'L' },
+        { "rate", required_argument, NULL, 'r' },
+        { "play-channels", required_argument, NULL, 'p' },
+        { "channels", required_argument, NULL, 'c' },
+        { "channel", required_argument, NULL, 'k' },
+        { "level", required_argument, NULL, 'V' },
+        { "min-ncc", required_argument, NULL, 'm' },
+        { "realtime", required_argument, NULL, 'R' },
+        { "file", required_argument, NULL, 'F' },
+        { "delay", required_argument, NULL, 'D' },
+        { "json", no_argument, NULL, 'j' },
+        { "scalar", no_argument, NULL, 'S' },
+        { "verbose", no_argument, NULL, 'v' },
+        { "help", no_argument, NULL, 'h' },
+        { NULL, 0, NULL, 0 }
+    };
+    const char *play_dev = DEFAULT_DEVICE;
+    const char *cap_dev = DEFAULT_DEVICE;
+    const char *conf = DEFAULT_CONF;
+    const char *sizes = DEFAULT_CONFIGS;
+    static char names[MAX_PCMS][NAME_LEN];
+    const char *plays[MAX_PCMS];
+    config_t cfg[MAX_CONFIGS];
+    unsigned int trials = DEFAULT_TRIALS;
+    unsigned int max_ms = DEFAULT_MAX_MS;
+    double level_db = DEFAULT_LEVEL;
+    double min_ncc = DEFAULT_MIN_NCC;
+    int all = 0;
+    int list = 0;
+    int internal = 0;
+    int json = 0;
+    int rt_prio = 0;
+    int n_cfg;
+    int n_plays = 0;
+    int missing = 0;
+    int errors = 0;
+    float *chirp;
+    size_t chirp_n;
+    int opt;
+
+    standin.delay_ms = DEFAULT_STANDIN_MS;
+    while ((opt = getopt_long(argc, argv, "P:C:Ala:ug:n:L:r:p:c:k:V:m:R:F:D:jSvh", long_opts,
+                              NULL)) != -1) {
+        switch (opt) {
+        case 'P':
+            play_dev = optarg;
+            break;
+        case 'C':
+            cap_dev = optarg;
+            break;
+        case 'A':
+            all = 1;
+            break;
+        case 'l':
+            list = 1;
+            break;
+        case 'a':
+            conf = optarg;
+            break;
+        case 'u':
+            internal = 1;
+            break;
+        case 'g':
+            sizes = optarg;
+            break;
+        case 'n':
+            trials = (unsigned int)atoi(optarg);
+            break;
+        case 'L':
+            max_ms = (unsigned int)atoi(optarg);
+            break;
+        case 'r':
+            rate = (unsigned int)atoi(optarg);
+            break;
+        case 'p':
+            play_ch = (unsigned int)atoi(optarg);
+            break;
+        case 'c':
+            cap_ch = (unsigned int)atoi(optarg);
+            break;
+        case 'k':
+            pick_ch = atoi(optarg);
+            break;
+        case 'V':
+            level_db = atof(optarg);
+            break;
+        case 'm':
+            min_ncc = atof(optarg);
+            break;
+        case 'R':
+            rt_prio = atoi(optarg);
+            break;
+        case 'F':
+            standin.path = optarg;
+            break;
+        case 'D':
+            standin.delay_ms = atof(optarg);
+            break;
+        case 'j':
+            json = 1;
+            break;
+        case 'S':
+            use_scalar = 1;
+            break;
+        case 'v':
+            verbose = 1;
+            break;
+        case 'h':
+            print_usage(argv[0]);
+            return 0;
+        default:
+            print_usage(argv[0]);
+            return 2;
+        }
+    }
+    if (trials == 0 || trials > 256 || rate < 8000 || play_ch == 0 || play_ch > MAX_CHANNELS ||
+        cap_ch == 0 || cap_ch > MAX_CHANNELS || pick_ch >= (int)cap_ch || standin.delay_ms < 0) {
+        fprintf(stderr, "pcm-latency: bad trials, rate, channels or delay\n");
+        return 2;
+    }
+    if ((n_cfg = parse_configs(sizes, cfg)) <= 0) {
+        fprintf(stderr, "pcm-latency: bad size list '%s' (PERIOD[/BUFFER],...)\n", sizes);
+        return 2;
+    }
+
+    if (list || all) {
+        int n;
+
+        if (standin.path) {
+            fprintf(stderr, "pcm-latency: -l and -A need ALSA, not the -F stand-in\n");
+            return 2;
+        }
+        if ((n = list_conf_pcms(conf, names, MAX_PCMS, internal)) < 0) {
+            return 2;
+        }
+        for (int i = 0; i < n; i++) {
+            const char *ptype = "-";
+            const char *ctype = "-";
+            int p = opens(names[i], SND_PCM_STREAM_PLAYBACK, &ptype);
+            int c = opens(names[i], SND_PCM_STREAM_CAPTURE, &ctype);
+
+            if (list) {
+                printf("%-24s %-9s %-9s %s\n", names[i], p ? "playback" : "", c ? "capture" : "",
+                       p ? ptype : ctype);
+            }
+            if (p) {
+                plays[n_plays++] = names[i];
+            }
+        }
+        if (list) {
+            return 0;
+        }
+    } else {
+        plays[n_plays++] = play_dev;
+    }
+
+    if (rt_prio > 0) {
+        struct sched_param sp = { .sched_priority = rt_prio };
+
+        mlockall(MCL_CURRENT | MCL_FUTURE);
+        if (sched_setscheduler(0, SCHED_FIFO, &sp) != 0) {
+            fprintf(stderr, "pcm-latency: SCHED_FIFO %d: %s\n", rt_prio, strerror(errno));
+        }
+    }
+    if (!(chirp = make_chirp(&chirp_n, level_db))) {
+        fprintf(stderr, "pcm-latency: out of memory\n");
+        return 2;
+    }
+
+    for (int i = 0; i < n_plays; i++) {
+        if (!json) {
+            printf("%s -> %s, %u Hz, %u chirps per size%s\n", plays[i],
+                   standin.path ? standin.path : cap_dev, rate, trials,
+                   standin.path ? " (file stand-in)" : "");
+        }
+        for (int k = 0; k < n_cfg; k++) {
+            result_t res;
+
+            if (run_config(plays[i], cap_dev, &cfg[k], trials, max_ms, chirp, chirp_n, min_ncc, &res) < 0) {
+                errors++;
+                continue;
+            }
+            print_result(plays[i], standin.path ? standin.path : cap_dev, &res, json);
+            fflush(stdout);
+            if (res.detected < res.trials) {
+                missing++;
+            }
+        }
+    }
+    free(chirp);
+    if (errors && !missing && errors == n_plays * n_cfg) {
+        return 2;
+    }
+    return missing || errors ? 1 : 0;
+}
@@ -0,0 +1,842 @@
+/* SPDX-License-Identifier: MIT */
+/*
+ * pcm-monitor - high-rate ALSA PCM and AEC pipeline health monitor
+ *
+ * Samples /proc/asound/card*\/pcm*\/sub*\/status for every open substream
+ * at 200 Hz by default. The status files stay open and are re-read with
+ * pread(), so one tick costs a few syscalls rather than the cat/grep/ps
+ * chains pipeline_monitor.sh forks once a minute. Per substream it tracks:
+ *
+ *   - xruns: the XRUN state, plus restarts between two ticks. An xrun
+ *     that the application recovers from quickly (snd_pcm_recover) can be
+ *     over before the next sample, but it leaves a new trigger_time
+ *     behind.
+ *   - near misses: less than one period queued for playback, or less than
+ *     one period of room left for capture.
+ *   - buffer fill: a histogram in tenths of the buffer, plus the trend in
+ *     frames per second over each report. A steady slope means producer
+ *     and consumer clocks disagree.
+ *   - clock drift: hw_ptr progress against the kernel's own tstamp, in
+ *     ppm of the nominal rate.
+ *
+ * It also follows the AEC process (default: the gst-launch pipeline with
+ * imx_ai_aecnr), reading RSS from /proc/PID/statm, and its own tick
+ * lateness. Events are logged as they happen. Every report interval it
+ * prints a summary and can replace a JSON file holding the histograms.
+ *
+ *   pcm-monitor                                 # report every 10 s
+ *   pcm-monitor -r 500 -i 60 -o /run/pcm-monitor.json -l /var/log/aec-monitor.log
+ *   pcm-monitor -R 10                           # SCHED_FIFO 10, for 1 kHz+ rates
+ */
+
+#define _GNU_SOURCE
+#include <ctype.h>
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <glob.h>
+#include <sched.h>
+#include <signal.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#define MAX_STREAMS          32
+#define FILL_BINS            10
+#define LATE_BINS            6
+#define STATUS_MAX           1024
+
+#define DEFAULT_RATE_HZ      200
+#define DEFAULT_REPORT_S     10
+#define DEFAULT_RSS_MB       100
+#define DEFAULT_PATTERN      "imx_ai_aecnr"
+#define RESCAN_S             2
+
+// Upper bounds of the tick lateness bins, in microseconds
+static const unsigned int late_bin_us[LATE_BINS - 1] = { 100, 500, 1000, 5000, 10000 };
+
+typedef enum {
+    ST_CLOSED = 0,
+    ST_OPEN,            // SETUP / PREPARED / PAUSED / DRAINING / ...
+    ST_RUNNING,
+    ST_XRUN
+} pcm_state_t;
+
+typedef struct {
+    pcm_state_t state;
+    char state_name[16];
+    char trigger[32];
+    double tstamp;
+    long avail;
+    long delay;
+    uint64_t hw_ptr;
+    uint64_t appl_ptr;
+} status_t;
+
+typedef struct {
+    char name[48];              // card0/pcm0p/sub0
+    char hw_params[256];
+    int fd;
+    int playback;
+    int seen;                   // found by the last scan
+
+    // From hw_params while the stream is open
+    long buffer_size;
+    long period_size;
+    unsigned int rate;
+
+    status_t last;
+    int near_miss;              // inside a near-miss episode
+
+    // Since the last report
+    uint64_t samples;
+    double fill_sum;
+    long fill_min;
+    long fill_max;
+    uint32_t fill_hist[FILL_BINS];
+    double trend_n, trend_t, trend_f, trend_tt, trend_tf;
+    uint64_t drift_hw0;
+    double drift_ts0;
+    double ppm;
+
+    // Since start
+    unsigned int xruns;
+    unsigned int restarts;
+    unsigned int near_misses;
+} stream_t;
+
+typedef struct {
+    const char *pattern;
+    pid_t pid;
+    pid_t fixed_pid;
+    int statm_fd;
+    unsigned long rss_kb;
+    unsigned long rss_max_kb;
+    unsigned long rss_start_kb;
+    double start_s;
+    unsigned long threshold_kb;
+    int over;
+} process_t;
+
+static const char *proc_root = "/proc";
+static FILE *log_file;
+static volatile sig_atomic_t stop;
+
+static stream_t streams[MAX_STREAMS];
+static unsigned int n_streams;
+
+static uint64_t ticks;
+static uint64_t missed_ticks;
+static uint32_t late_hist[LATE_BINS];
+static double late_max_us;
+
+static void on_signal(int sig) {
+    (void)sig;
+    stop = 1;
+}
+
+static double mono_s(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static void log_event(const char *fmt, ...) {
+    char when[64];
+    struct timespec ts;
+    struct tm tm;
+    va_list ap;
+
+    clock_gettime(CLOCK_REALTIME, &ts);
+    localtime_r(&ts.tv_sec, &tm);
+    snprintf(when, sizeof(when), "%04d-%02d-%02d %02d:%02d:%02d.%03ld",
+             tm.tm_year + 1900, tm.tm_mon + 1, tm.tm_mday, tm.tm_hour, tm.tm_min, tm.tm_sec,
+             ts.tv_nsec / 1000000);
+
+    printf("%s ", when);
+    va_start(ap, fmt);
+    vprintf(fmt, ap);
+    va_end(ap);
+    printf("\n");
+    fflush(stdout);
+
+    if (log_file != NULL) {
+        fprintf(log_file, "%s ", when);
+        va_start(ap, fmt);
+        vfprintf(log_file, fmt, ap);
+        va_end(ap);
+        fprintf(log_file, "\n");
+        fflush(log_file);
+    }
+}
+
+static ssize_t read_at0(int fd, char *buf, size_t size) {
+    ssize_t n = pread(fd, buf, size - 1, 0);
+
+    buf[n > 0 ? n : 0] = '\0';
+    return n;
+}
+
+// Value after "key:" on its own line, or NULL
+static const char *field(const char *text, const char *key) {
+    size_t len = strlen(key);
+
+    for (const char *p = text; p != NULL && *p; p = strchr(p, '\n'), p = p ? p + 1 : NULL) {
+        if (strncmp(p, key, len) == 0) {
+            const char *v = p + len;
+
+            while (*v == ' ' || *v == '\t') {
+                v++;
+            }
+            if (*v == ':') {
+                v++;
+                while (*v == ' ' || *v == '\t') {
+                    v++;
+                }
+                return v;
+            }
+        }
+    }
+    return NULL;
+}
+
+/* ---- Substreams ---- */
+
+static int parse_status(const char *text, status_t *st) {
+    const char *v;
+
+    memset(st, 0, sizeof(*st));
+    if (strncmp(text, "closed", 6) == 0) {
+        st->state = ST_CLOSED;
+        strcpy(st->state_name, "CLOSED");
+        return 0;
+    }
+
+    v = field(text, "state");
+    if (v == NULL) {
+        return -1;
+    }
+    sscanf(v, "%15s", st->state_name);
+    st->state = strcmp(st->state_name, "RUNNING") == 0 ? ST_RUNNING
+              : strcmp(st->state_name, "XRUN") == 0 ? ST_XRUN : ST_OPEN;
+
+    if ((v = field(text, "trigger_time")) != NULL) {
+        sscanf(v, "%31s", st->trigger);
+    }
+    if ((v = field(text, "tstamp")) != NULL) {
+        st->tstamp = strtod(v, NULL);
+    }
+    if ((v = field(text, "delay")) != NULL) {
+        st->delay = strtol(v, NULL, 10);
+    }
+    if ((v = field(text, "avail")) != NULL) {
+        st->avail = strtol(v, NULL, 10);
+    }
+    if ((v = field(text, "hw_ptr")) != NULL) {
+        st->hw_ptr = strtoull(v, NULL, 10);
+    }
+    if ((v = field(text, "appl_ptr")) != NULL) {
+        st->appl_ptr = strtoull(v, NULL, 10);
+    }
+    return 0;
+}
+
+static void read_hw_params(stream_t *s) {
+    char text[STATUS_MAX];
+    const char *v;
+    int fd;
+
+    s->buffer_size = 0;
+    s->period_size = 0;
+    s->rate = 0;
+
+    fd = open(s->hw_params, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return;
+    }
+    read_at0(fd, text, sizeof(text));
+    close(fd);
+
+    if ((v = field(text, "buffer_size")) != NULL) {
+        s->buffer_size = strtol(v, NULL, 10);
+    }
+    if ((v = field(text, "period_size")) != NULL) {
+        s->period_size = strtol(v, NULL, 10);
+    }
+    if ((v = field(text, "rate")) != NULL) {
+        s->rate = (unsigned int)strtoul(v, NULL, 10);
+    }
+}
+
+static void reset_window(stream_t *s) {
+    s->samples = 0;
+    s->fill_sum = 0;
+    s->fill_min = -1;
+    s->fill_max = -1;
+    memset(s->fill_hist, 0, sizeof(s->fill_hist));
+    s->trend_n = s->trend_t = s->trend_f = s->trend_tt = s->trend_tf = 0;
+    s->drift_hw0 = 0;
+    s->drift_ts0 = 0;
+}
+
+// Substreams come and go with the cards; rescan every few seconds
+static void scan_streams(void) {
+    char pattern[256];
+    glob_t g;
+
+    for (unsigned int i = 0; i < n_streams; i++) {
+        streams[i].seen = 0;
+    }
+
+    snprintf(pattern, sizeof(pattern), "%s/asound/card*/pcm*/sub*/status", proc_root);
+    if (glob(pattern, 0, NULL, &g) == 0) {
+        for (size_t i = 0; i < g.gl_pathc; i++) {
+            const char *path = g.gl_pathv[i];
+            const char *rel = strstr(path, "/asound/") + strlen("/asound/");
+            size_t rel_len = strlen(rel) - strlen("/status");
+            stream_t *s = NULL;
+
+            for (unsigned int j = 0; j < n_streams; j++) {
+                if (strlen(streams[j].name) == rel_len &&
+                    strncmp(streams[j].name, rel, rel_len) == 0) {
+                    s = &streams[j];
+                    break;
+                }
+            }
+            if (s == NULL) {
+                const char *sub;
+
+                if (n_streams == MAX_STREAMS || rel_len >= sizeof(streams[0].name)) {
+                    continue;
+                }
+                s = &streams[n_streams];
+                memset(s, 0, sizeof(*s));
+                s->fd = open(path, O_RDONLY | O_CLOEXEC);
+                if (s->fd < 0) {
+                    continue;
+                }
+                memcpy(s->name, rel, rel_len);
+                snprintf(s->hw_params, sizeof(s->hw_params), "%.*s/hw_params",
+                         (int)(strlen(path) - strlen("/status")), path);
+                // card0/pcm0p/sub0: the letter after the device number
+                sub = strstr(s->name, "/sub");
+                s->playback = sub != NULL && sub[-1] == 'p';
+                reset_window(s);
+                n_streams++;
+            }
+            s->seen = 1;
+        }
+        globfree(&g);
+    }
+
+    // Drop substreams whose card went away
+    for (unsigned int i = 0; i < n_streams;) {
+        if (!streams[i].seen) {
+            log_event("%s: removed", streams[i].name);
+            close(streams[i].fd);
+            streams[i] = streams[--n_streams];
+        } else {
+            i++;
+        }
+    }
+}
+
+// Frames queued for playback, or waiting to be read for capture
+static long stream_fill(const stream_t *s, const status_t *st) {
+    return s->playback ? s->buffer_size - st->avail : st->avail;
+}
+
+static void sample_stream(stream_t *s, double now) {
+    char text[STATUS_MAX];
+    status_t st;
+
+    if (read_at0(s->fd, text, sizeof(text)) <= 0 || parse_status(text, &st) != 0) {
+        return;
+    }
+
+    if (st.state != s->last.state) {
+        if (s->last.state == ST_CLOSED) {
+            read_hw_params(s);
+            log_event("%s: open, %u Hz, buffer %ld, period %ld", s->name, s->rate,
+                      s->buffer_size, s->period_size);
+        }
+        if (st.state == ST_XRUN) {
+            s->xruns++;
+            log_event("%s: XRUN (%s), %u so far", s->name,
+                      s->playback ? "underrun" : "overrun", s->xruns + s->restarts);
+        } else if (st.state == ST_CLOSED) {
+            log_event("%s: closed", s->name);
+        } else if (s->last.state != ST_CLOSED || st.state != ST_OPEN) {
+            log_event("%s: %s", s->name, st.state_name);
+        }
+        if (st.state == ST_RUNNING) {
+            s->drift_hw0 = 0;
+        }
+    } else if (st.state == ST_RUNNING && strcmp(st.trigger, s->last.trigger) != 0) {
+        // Stopped and restarted between two ticks: almost always a recovered xrun
+        s->restarts++;
+        s->drift_hw0 = 0;
+        log_event("%s: restarted between samples (hidden xrun?), %u so far", s->name,
+                  s->xruns + s->restarts);
+    }
+
+    if (st.state == ST_RUNNING && s->buffer_size > 0) {
+        long fill = stream_fill(s, &st);
+        long margin = s->playback ? fill : s->buffer_size - fill;
+        unsigned int bin;
+
+        if (fill < 0) {
+            fill = 0;
+        }
+        if (fill > s->buffer_size) {
+            fill = s->buffer_size;
+        }
+        bin = (unsigned int)(fill * FILL_BINS / (s->buffer_size + 1));
+
+        s->samples++;
+        s->fill_sum += (double)fill;
+        s->fill_hist[bin]++;
+        if (s->fill_min < 0 || fill < s->fill_min) {
+            s->fill_min = fill;
+        }
+        if (fill > s->fill_max) {
+            s->fill_max = fill;
+        }
+        s->trend_n += 1;
+        s->trend_t += now;
+        s->trend_f += (double)fill;
+        s->trend_tt += now * now;
+        s->trend_tf += now * (double)fill;
+
+        if (margin < s->period_size) {
+            if (!s->near_miss) {
+                s->near_miss = 1;
+                s->near_misses++;
+                log_event("%s: %s margin down to %ld frames (period %ld)", s->name,
+                          s->playback ? "underrun" : "overrun", margin, s->period_size);
+            }
+        } else if (margin >= 2 * s->period_size) {
+            s->near_miss = 0;
+        }
+
+        if (s->drift_hw0 == 0 || st.hw_ptr < s->drift_hw0) {
+            s->drift_hw0 = st.hw_ptr;
+            s->drift_ts0 = st.tstamp;
+        } else if (st.tstamp - s->drift_ts0 > 1.0 && s->rate > 0) {
+            s->ppm = ((double)(st.hw_ptr - s->drift_hw0) / (st.tstamp - s->drift_ts0) /
+                      s->rate - 1.0) * 1e6;
+        }
+    }
+
+    s->last = st;
+}
+
+/* ---- AEC process ---- */
+
+static int cmdline_matches(pid_t pid, const char *pattern) {
+    char path[64];
+    char cmd[4096];
+    ssize_t n;
+    int fd;
+
+    snprintf(path, sizeof(path), "%s/%d/cmdline", proc_root, (int)pid);
+    fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return 0;
+    }
+    n = read(fd, cmd, sizeof(cmd) - 1);
+    close(fd);
+    if (n <= 0) {
+        return 0;
+    }
+    for (ssize_t i = 0; i < n; i++) {
+        if (cmd[i] == '\0') {
+            cmd[i] = ' ';
+        }
+    }
+    cmd[n] = '\0';
+    return strstr(cmd, pattern) != NULL;
+}
+
+static pid_t find_process(const char *pattern) {
+    pid_t self = getpid();
+    pid_t found = 0;
+    struct dirent *de;
+    DIR *dir;
+
+    dir = opendir(proc_root);
+    if (dir == NULL) {
+        return 0;
+    }
+    while (found == 0 && (de = readdir(dir)) != NULL) {
+        pid_t pid;
+
+        if (!isdigit((unsigned char)de->d_name[0])) {
+            continue;
+        }
+        pid = (pid_t)atoi(de->d_name);
+        if (pid != self && cmdline_matches(pid, pattern)) {
+            found = pid;
+        }
+    }
+    closedir(dir);
+    return found;
+}
+
+static void sample_process(process_t *p, double now) {
+    char text[128];
+    unsigned long size;
+    unsigned long resident;
+
+    if (p->pid != 0 && (p->statm_fd < 0 || read_at0(p->statm_fd, text, sizeof(text)) <= 0)) {
+        log_event("AEC process %d exited", (int)p->pid);
+        if (p->statm_fd >= 0) {
+            close(p->statm_fd);
+        }
+        p->statm_fd = -1;
+        p->pid = 0;
+    }
+
+    if (p->pid == 0) {
+        char path[64];
+
+        p->pid = p->fixed_pid != 0 ? p->fixed_pid : find_process(p->pattern);
+        if (p->pid == 0) {
+            return;
+        }
+        snprintf(path, sizeof(path), "%s/%d/statm", proc_root, (int)p->pid);
+        p->statm_fd = open(path, O_RDONLY | O_CLOEXEC);
+        if (p->statm_fd < 0 || read_at0(p->statm_fd, text, sizeof(text)) <= 0) {
+            if (p->statm_fd >= 0) {
+                close(p->statm_fd);
+            }
+            p->statm_fd = -1;
+            p->pid = 0;
+            return;
+        }
+        p->rss_start_kb = 0;
+        p->rss_max_kb = 0;
+        p->start_s = now;
+        log_event("AEC process %d found", (int)p->pid);
+    }
+
+    if (sscanf(text, "%lu %lu", &size, &resident) != 2) {
+        return;
+    }
+    p->rss_kb = resident * (unsigned long)sysconf(_SC_PAGESIZE) / 1024;
+    if (p->rss_start_kb == 0) {
+        p->rss_start_kb = p->rss_kb;
+    }
+    if (p->rss_kb > p->rss_max_kb) {
+        p->rss_max_kb = p->rss_kb;
+    }
+    if (p->rss_kb > p->threshold_kb && !p->over) {
+        log_event("AEC process %d RSS %lu kB is over %lu kB", (int)p->pid, p->rss_kb,
+                  p->threshold_kb);
+        p->over = 1;
+    } else if (p->rss_kb <= p->threshold_kb) {
+        p->over = 0;
+    }
+}
+
+/* ---- Reports ---- */
+
+static double fill_trend(const stream_t *s) {
+    double den = s->trend_n * s->trend_tt - s->trend_t * s->trend_t;
+
+    return s->trend_n > 1 && den > 0
+               ? (s->trend_n * s->trend_tf - s->trend_t * s->trend_f) / den : 0.0;
+}
+
+static void print_report(const process_t *p, double rate_hz, double elapsed) {
+    for (unsigned int i = 0; i < n_streams; i++) {
+        stream_t *s = &streams[i];
+        char hist[FILL_BINS * 8 + 1];
+        size_t len = 0;
+
+        if (s->samples == 0) {
+            continue;
+        }
+        for (unsigned int b = 0; b < FILL_BINS; b++) {
+            len += (size_t)snprintf(hist + len, sizeof(hist) - len, " %u",
+                                    (unsigned int)(s->fill_hist[b] * 100 / s->samples));
+        }
+        log_event("%s: fill avg %.0f min %ld max %ld of %ld, trend %+.1f f/s, drift %+.1f ppm, "
+                  "xruns %u, restarts %u, near misses %u; fill%% by tenth:%s",
+                  s->name, s->fill_sum / (double)s->samples, s->fill_min, s->fill_max,
+                  s->buffer_size, fill_trend(s), s->ppm, s->xruns, s->restarts, s->near_misses, hist);
+    }
+
+    if (p->pid != 0) {
+        double hours = (mono_s() - p->start_s) / 3600.0;
+
+        log_event("AEC process %d: RSS %lu kB, max %lu kB, %+.0f kB/h", (int)p->pid, p->rss_kb,
+                  p->rss_max_kb,
+                  hours > 0.01 ? ((double)p->rss_kb - (double)p->rss_start_kb) / hours : 0.0);
+    }
+    log_event("sampling %.0f Hz over %.0f s: %llu ticks, %llu missed, max late %.2f ms",
+              rate_hz, elapsed, (unsigned long long)ticks, (unsigned long long)missed_ticks,
+              late_max_us / 1000.0);
+}
+
+static void write_json(const char *path, const process_t *p, double rate_hz) {
+    char tmp[512];
+    FILE *f;
+
+    snprintf(tmp, sizeof(tmp), "%s.tmp", path);
+    f = fopen(tmp, "w");
+    if (f == NULL) {
+        return;
+    }
+
+    fprintf(f, "{\"rate_hz\":%.0f,\"ticks\":%llu,\"missed_ticks\":%llu,\"late_max_us\":%.0f,"
+            "\"late_hist_us\":{\"bounds\":[", rate_hz, (unsigned long long)ticks,
+            (unsigned long long)missed_ticks, late_max_us);
+    for (unsigned int b = 0; b < LATE_BINS - 1; b++) {
+        fprintf(f, "%s%u", b ? "," : "", late_bin_us[b]);
+    }
+    fprintf(f, "],\"counts\":[");
+    for (unsigned int b = 0; b < LATE_BINS; b++) {
+        fprintf(f, "%s%u", b ? "," : "", late_hist[b]);
+    }
+    fprintf(f, "]},\"streams\":[");
+
+    for (unsigned int i = 0; i < n_streams; i++) {
+        const stream_t *s = &streams[i];
+
+        fprintf(f, "%s{\"name\":\"%s\",\"playback\":%s,\"state\":\"%s\",\"rate\":%u,"
+                "\"buffer_size\":%ld,\"period_size\":%ld,\"samples\":%llu,",
+                i ? "," : "", s->name, s->playback ? "true" : "false", s->last.state_name,
+                s->rate, s->buffer_size, s->period_size, (unsigned long long)s->samples);
+        fprintf(f, "\"fill_avg\":%.1f,\"fill_min\":%ld,\"fill_max\":%ld,\"fill_trend_fps\":%.2f,"
+                "\"drift_ppm\":%.1f,\"xruns\":%u,\"restarts\":%u,\"near_misses\":%u,\"fill_hist\":[",
+                s->samples ? s->fill_sum / (double)s->samples : 0.0, s->fill_min, s->fill_max,
+                fill_trend(s), s->ppm, s->xruns, s->restarts, s->near_misses);
+        for (unsigned int b = 0; b < FILL_BINS; b++) {
+            fprintf(f, "%s%u", b ? "," : "", s->fill_hist[b]);
+        }
+        fprintf(f, "]}");
+    }
+    fprintf(f, "],\"aec\":{\"pid\":%d,\"rss_kb\":%lu,\"rss_max_kb\":%lu}}\n",
+            (int)p->pid, p->rss_kb, p->rss_max_kb);
+
+    if (fclose(f) == 0) {
+        rename(tmp, path);
+    } else {
+        unlink(tmp);
+    }
+}
+
+static void print_usage(const char *prog) {
+    printf("Usage: %s [options]\n", prog);
+    printf("\n");
+    printf("Options:\n");
+    printf("  -r, --rate HZ         Status samples per second (default %d)\n", DEFAULT_RATE_HZ);
+    printf("  -i, --interval S      Report interval (default %d)\n", DEFAULT_REPORT_S);
+    printf("  -p, --pid PID         AEC process to follow\n");
+    printf("  -n, --name PATTERN    Find it by command line instead (default %s)\n", DEFAULT_PATTERN);
+    printf("  -m, --memory MB       RSS warning threshold (default %d)\n", DEFAULT_RSS_MB);
+    printf("  -o, --output FILE     Replace FILE with a JSON report every interval\n");
+    printf("  -l, --log FILE        Append events and reports to FILE as well as stdout\n");
+    printf("  -t, --time S          Stop after S seconds\n");
+    printf("  -R, --realtime PRIO   Sample from SCHED_FIFO at PRIO\n");
+    printf("  -P, --proc DIR        procfs root (default /proc)\n");
+    printf("  -h, --help            Show this help\n");
+}
+
+int main(int argc, char *argv[]) {
+    static const struct option long_opts[] = {
+        { "rate", required_argument, NULL, 'r' },
+        { "interval", required_argument, NULL, 'i' },
+        { "pid", required_argument, NULL, 'p' },
+        { "name", required_argument, NULL, 'n' },
+        { "memory", required_argument, NULL, 'm' },
+        { "output", required_argument, NULL, 'o' },
+        { "log", required_argument, NULL, 'l' },
+        { "time", required_argument, NULL, 't' },
+        { "realtime", required_argument, NULL, 'R' },
+        { "proc", required_argument, NULL, 'P' },
+        { "help", no_argument, NULL, 'h' },
+        { NULL, 0, NULL, 0 }
+    };
+    process_t proc = {
+        .pattern = DEFAULT_PATTERN,
+        .statm_fd = -1,
+        .threshold_kb = DEFAULT_RSS_MB * 1024UL,
+    };
+    double rate_hz = DEFAULT_RATE_HZ;
+    double report_s = DEFAULT_REPORT_S;
+    double run_s = 0;
+    const char *json = NULL;
+    int rt_prio = 0;
+    struct sigaction sa;
+    struct timespec next;
+    uint64_t period_ns;
+    double start;
+    double last_report;
+    double last_rescan;
+    double last_proc = 0;
+    int opt;
+
+    while ((opt = getopt_long(argc, argv, "r:i:p:n:m:o:l:t:R:P:h", long_opts, NULL)) != -1) {
+        switch (opt) {
+        case 'r':
+            rate_hz = strtod(optarg, NULL);
+            break;
+        case 'i':
+            report_s = strtod(optarg, NULL);
+            break;
+        case 'p':
+            proc.fixed_pid = (pid_t)strtol(optarg, NULL, 10);
+            break;
+        case 'n':
+            proc.pattern = optarg;
+            break;
+        case 'm':
+            proc.threshold_kb = strtoul(optarg, NULL, 10) * 1024UL;
+            break;
+        case 'o':
+            json = optarg;
+            break;
+        case 'l':
+            log_file = fopen(optarg, "a");
+            if (log_file == NULL) {
+                fprintf(stderr, "pcm-monitor: %s: %s\n", optarg, strerror(errno));
+                return 1;
+            }
+            break;
+        case 't':
+            run_s = strtod(optarg, NULL);
+            break;
+        case 'R':
+            rt_prio = atoi(optarg);
+            break;
+        case 'P':
+            proc_root = optarg;
+            break;
+        case 'h':
+            print_usage(argv[0]);
+            return 0;
+        default:
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+    if (rate_hz < 1 || rate_hz > 10000 || report_s <= 0) {
+        fprintf(stderr, "pcm-monitor: rate must be 1-10000 Hz and the interval positive\n");
+        return 1;
+    }
+
+    if (rt_prio > 0) {
+        struct sched_param sp = { .sched_priority = rt_prio };
+
+        // Page faults in the sampling loop would show up as lateness
+        mlockall(MCL_CURRENT | MCL_FUTURE);
+        if (sched_setscheduler(0, SCHED_FIFO, &sp) != 0) {
+            fprintf(stderr, "pcm-monitor: SCHED_FIFO %d: %s\n", rt_prio, strerror(errno));
+        }
+    }
+
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = on_signal;
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+
+    scan_streams();
+    log_event("pcm-monitor: %u substreams, sampling at %.0f Hz, reporting every %.0f s",
+              n_streams, rate_hz, report_s);
+
+    period_ns = (uint64_t)(1e9 / rate_hz);
+    start = last_report = last_rescan = mono_s();
+    clock_gettime(CLOCK_MONOTONIC, &next);
+
+    while (!stop) {
+        struct timespec now_ts;
+        double now;
+        double late_us;
+        unsigned int bin;
+
+        next.tv_nsec += (long)period_ns;
+        while (next.tv_nsec >= 1000000000L) {
+            next.tv_nsec -= 1000000000L;
+            next.tv_sec++;
+        }
+        while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL) == EINTR && !stop) {
+        }
+        if (stop) {
+            break;
+        }
+
+        clock_gettime(CLOCK_MONOTONIC, &now_ts);
+        now = (double)now_ts.tv_sec + (double)now_ts.tv_nsec / 1e9;
+        late_us = ((double)(now_ts.tv_sec - next.tv_sec) * 1e9 +
+                   (double)(now_ts.tv_nsec - next.tv_nsec)) / 1000.0;
+        for (bin = 0; bin < LATE_BINS - 1 && late_us >= late_bin_us[bin]; bin++) {
+        }
+        late_hist[bin]++;
+        if (late_us > late_max_us) {
+            late_max_us = late_us;
+        }
+        // Overslept a whole period: skip ahead instead of bursting to catch up
+        if (late_us * 1000.0 >= (double)period_ns) {
+            uint64_t skip = (uint64_t)(late_us * 1000.0) / period_ns;
+
+            missed_ticks += skip;
+            next = now_ts;
+        }
+        ticks++;
+
+        for (unsigned int i = 0; i < n_streams; i++) {
+            sample_stream(&streams[i], now);
+        }
+
+        if (now - last_proc >= 1.0) {
+            sample_process(&proc, now);
+            last_proc = now;
+        }
+        if (now - last_rescan >= RESCAN_S) {
+            scan_streams();
+            last_rescan = now;
+        }
+        if (now - last_report >= report_s) {
+            print_report(&proc, rate_hz, now - last_report);
+            if (json != NULL) {
+                write_json(json, &proc, rate_hz);
+            }
+            for (unsigned int i = 0; i < n_streams; i++) {
+                reset_window(&streams[i]);
+            }
+            ticks = 0;
+            missed_ticks = 0;
+            late_max_us = 0;
+            memset(late_hist, 0, sizeof(late_hist));
+            last_report = now;
+        }
+        if (run_s > 0 && now - start >= run_s) {
+            break;
+        }
+    }
+
+    // Whatever accumulated since the last report
+    if (ticks > 0) {
+        print_report(&proc, rate_hz, mono_s() - last_report);
+        if (json != NULL) {
+            write_json(json, &proc, rate_hz);
+        }
+    }
+
+    for (unsigned int i = 0; i < n_streams; i++) {
+        close(streams[i].fd);
+    }
+    if (log_file != NULL) {
+        fclose(log_file);
+    }
+    return 0;
+}
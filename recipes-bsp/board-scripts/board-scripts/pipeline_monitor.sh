@@ -389,8 +389,10 @@ check_gstreamer_health() {
         # Check current buffer status
         check_buffer_status
         
-        # Check ALSA buffer status
-        check_alsa_buffer_status
+        # Check ALSA buffer status (pcm-monitor samples it continuously)
+        if [ -z "$PCM_MONITOR_PID" ]; then
+            check_alsa_buffer_status
+        fi
     fi
 }
 
@@ -406,8 +408,14 @@ perform_health_check() {
         return 1
     fi
     
-    # Test audio functionality
-    if ! test_audio_capture; then
+    # Test audio functionality. With pcm-monitor running, the live capture
+    # stream is watched directly and a competing arecord would only disturb it.
+    if [ -n "$PCM_MONITOR_PID" ]; then
+        if ! kill -0 "$PCM_MONITOR_PID" 2>/dev/null; then
+            log_message "WARNING: pcm-monitor has exited"
+            PCM_MONITOR_PID=""
+        fi
+    elif ! test_audio_capture; then
         health_status=1
     fi
     
@@ -458,6 +466,17 @@ start_monitoring() {
         fi
     fi
     
+    # Sub-second xruns, buffer drift and RSS are tracked by pcm-monitor at
+    # 200 Hz; its events and reports go to the same log
+    if command -v pcm-monitor >/dev/null 2>&1; then
+        pcm-monitor -i "$MONITOR_INTERVAL" -m $((MEMORY_THRESHOLD / 1024)) \
+            ${PIPELINE_PID:+-p "$PIPELINE_PID"} -l "$LOG_FILE" \
+            -o /tmp/pcm-monitor.json >/dev/null &
+        PCM_MONITOR_PID=$!
+        trap 'kill $PCM_MONITOR_PID 2>/dev/null; exit 0' INT TERM
+        log_message "INFO: Started pcm-monitor (PID $PCM_MONITOR_PID), histograms in /tmp/pcm-monitor.json"
+    fi
+
     # Main monitoring loop
     while true; do
         if ! perform_health_check; then
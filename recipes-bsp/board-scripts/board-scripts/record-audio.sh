@@ -409,6 +409,22 @@ check_keypress() {
     fi
 }
 
+# Analysis-only runs use the native level monitor when it is installed: one
+# capture stream for the whole session, no temporary files. Each line is the
+# JSON level report for the last DURATION seconds (see audio-levels --help).
+if [ "$SAVE_FILES" = false ] && command -v audio-levels >/dev/null 2>&1; then
+    log_message "✓ Using 'audio-levels' (continuous capture, no temporary files)"
+    log_message "Press Ctrl+C to stop"
+    # Ctrl+C stops audio-levels; the loop keeps reading to log its summary
+    trap '' SIGINT
+    audio-levels -D "$AUDIO_DEVICE" -f s16 -c 2 -r 44100 \
+        -w $((DURATION * 1000)) -I $(((DURATION + INTERVAL) * 1000)) 2>&1 |
+        while read -r line; do
+            log_message_with_elapsed "  📊 $line"
+        done
+    exit 0
+fi
+
 # Main recording loop
 while true; do
     # Generate timestamp for filename
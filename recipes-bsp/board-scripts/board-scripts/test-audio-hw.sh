@@ -21,6 +21,15 @@ tries=1
 while [ $tries -le 3 ]
 do
   echo Attempt ${tries}
+  # Full-duplex Goertzel check: sub-second, reports level/SNR/latency per mic
+  if command -v audio-loopback >/dev/null 2>&1; then
+    if audio-loopback -i /usr/share/board-scripts/dtmf-182846.wav -P pulse -C pulse -c 2; then
+      echo SUCCESS
+      exit 0
+    fi
+    tries=$(( $tries + 1 ))
+    continue
+  fi
   rm -f audio-test.wav
   echo Recording audio
   arecord -c 2 -r 8000 -f S16_LE -D pulse audio-test.wav -d 5 &
@@ -0,0 +1,129 @@
+#!/bin/bash
+# SPDX-License-Identifier: MIT
+#
+# Benchmark wav-channels against the extract_channel.py / mono_to_stereo.py
+# scripts it replaces, on a synthetic recording shaped like the production
+# test capture (48 kHz s16 stereo). Each case is run several times and
+# the best wall time kept; outputs are compared byte for byte.
+#
+# Usage: wav-channels-bench.sh [-s seconds] [-r runs] [-k]
+#   -s  recording length (default 60)
+#   -r  runs per case (default 5)
+#   -k  keep the work directory
+
+SECONDS_LEN=60
+RUNS=5
+KEEP=0
+HERE=$(cd "$(dirname "$0")" && pwd)
+PY_DIR=/usr/share/board-scripts
+[ -f "$HERE/extract_channel.py" ] && PY_DIR=$HERE
+WAV_CHANNELS=$(command -v wav-channels || echo "$HERE/wav-channels")
+
+while getopts "s:r:kh" opt; do
+	case $opt in
+	s) SECONDS_LEN=$OPTARG ;;
+	r) RUNS=$OPTARG ;;
+	k) KEEP=1 ;;
+	*)
+		sed -n '3,13s/^# \{0,1\}//p' "$0"
+		exit 1
+		;;
+	esac
+done
+
+if [ ! -x "$WAV_CHANNELS" ]; then
+	echo "ERR: wav-channels not found" >&2
+	exit 1
+fi
+if ! command -v python3 >/dev/null; then
+	echo "ERR: python3 is needed for the reference scripts" >&2
+	exit 1
+fi
+
+WORK=$(mktemp -d /tmp/wav-channels-bench.XXXXXX)
+[ "$KEEP" -eq 1 ] || trap 'rm -rf "$WORK"' EXIT
+
+python3 - "$WORK/stereo.wav" "$SECONDS_LEN" <<'EOF'
+import os, sys, wave
+with wave.open(sys.argv[1], 'wb') as w:
+    w.setnchannels(2)
+    w.setsampwidth(2)
+    w.setframerate(48000)
+    for _ in range(int(sys.argv[2])):
+        w.writeframes(os.urandom(48000 * 4))
+EOF
+
+# Best of RUNS wall-clock times in ms; GNU time adds peak RSS if present
+best_ms() {
+	local best="" t0 t1 ms
+	for _ in $(seq "$RUNS"); do
+		t0=$(date +%s%N)
+		if ! "$@" >/dev/null 2>&1; then
+			echo failed
+			return
+		fi
+		t1=$(date +%s%N)
+		ms=$(((t1 - t0) / 1000000))
+		if [ -z "$best" ] || [ "$ms" -lt "$best" ]; then
+			best=$ms
+		fi
+	done
+	echo "$best"
+}
+
+peak_rss() {
+	if [ -x /usr/bin/time ] && /usr/bin/time -f %M true >/dev/null 2>&1; then
+		/usr/bin/time -f %M "$@" 2>&1 >/dev/null | tail -1
+	else
+		echo "-"
+	fi
+}
+
+report() {
+	local name=$1 py_ms=$2 native_ms=$3 scalar_ms=$4 py_rss=$5 native_rss=$6 same=$7
+	local speedup="-"
+	if [[ "$py_ms" =~ ^[0-9]+$ && "$native_ms" =~ ^[0-9]+$ && "$native_ms" -gt 0 ]]; then
+		speedup="$((py_ms / native_ms))x"
+	fi
+	printf "%-10s %10s %10s %10s %8s %10s %10s  %s\n" \
+		"$name" "$py_ms" "$native_ms" "$scalar_ms" "$speedup" "$py_rss" "$native_rss" "$same"
+}
+
+echo "=== wav-channels vs Python, ${SECONDS_LEN}s 48 kHz s16 stereo, best of $RUNS ==="
+printf "%-10s %10s %10s %10s %8s %10s %10s  %s\n" \
+	case python-ms native-ms scalar-ms speedup py-rss-kB rss-kB output
+cd "$WORK" || exit 1
+
+RC=0
+for ch in 0 1; do
+	py=$(best_ms python3 "$PY_DIR/extract_channel.py" stereo.wav py-$ch.wav "$ch")
+	native=$(best_ms "$WAV_CHANNELS" extract stereo.wav native-$ch.wav "$ch")
+	scalar=$(best_ms "$WAV_CHANNELS" -S extract stereo.wav native-$ch.wav "$ch")
+	same=identical
+	cmp -s py-$ch.wav native-$ch.wav || { same=DIFFERENT; RC=1; }
+	report "extract $ch" "$py" "$native" "$scalar" \
+		"$(peak_rss python3 "$PY_DIR/extract_channel.py" stereo.wav py-$ch.wav "$ch")" \
+		"$(peak_rss "$WAV_CHANNELS" extract stereo.wav native-$ch.wav "$ch")" "$same"
+done
+
+py=$(best_ms python3 "$PY_DIR/mono_to_stereo.py" native-0.wav py-dup.wav)
+native=$(best_ms "$WAV_CHANNELS" duplicate native-0.wav native-dup.wav)
+scalar=$(best_ms "$WAV_CHANNELS" -S duplicate native-0.wav native-dup.wav)
+same=identical
+cmp -s py-dup.wav native-dup.wav || { same=DIFFERENT; RC=1; }
+report duplicate "$py" "$native" "$scalar" \
+	"$(peak_rss python3 "$PY_DIR/mono_to_stereo.py" native-0.wav py-dup.wav)" \
+	"$(peak_rss "$WAV_CHANNELS" duplicate native-0.wav native-dup.wav)" "$same"
+
+# No Python equivalent; shows the remaining kernels
+native=$(best_ms "$WAV_CHANNELS" deinterleave stereo.wav split)
+scalar=$(best_ms "$WAV_CHANNELS" -S deinterleave stereo.wav split)
+report deinterl. - "$native" "$scalar" - "$(peak_rss "$WAV_CHANNELS" deinterleave stereo.wav split)" -
+native=$(best_ms "$WAV_CHANNELS" interleave joined.wav split-ch0.wav split-ch1.wav)
+scalar=$(best_ms "$WAV_CHANNELS" -S interleave joined.wav split-ch0.wav split-ch1.wav)
+same=identical
+cmp -s stereo.wav joined.wav || { same=DIFFERENT; RC=1; }
+report interleave - "$native" "$scalar" - "$(peak_rss "$WAV_CHANNELS" interleave joined.wav split-ch0.wav split-ch1.wav)" "$same"
+
+[ "$KEEP" -eq 1 ] && echo "Work files kept in $WORK"
+exit $RC
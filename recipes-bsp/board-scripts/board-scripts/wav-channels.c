@@ -0,0 +1,769 @@
+/* SPDX-License-Identifier: MIT */
+/*
+ * wav-channels - move channels between WAV files without loading them
+ *
+ *   wav-channels extract in.wav out.wav 1          # one channel as mono
+ *   wav-channels duplicate in.wav out.wav [2]      # mono to N identical channels
+ *   wav-channels remap in.wav out.wav 1,0,-        # reorder, drop or silence channels
+ *   wav-channels deinterleave in.wav capture       # capture-ch0.wav, capture-ch1.wav, ...
+ *   wav-channels interleave out.wav a.wav b.wav    # channels of each input, in order
+ *   wav-channels info in.wav
+ *
+ * extract and duplicate take the same arguments as the extract_channel.py
+ * and mono_to_stereo.py scripts they replace, and produce byte-identical
+ * files for their 16-bit stereo/mono cases. An output of "-" is stdout,
+ * so a recording can be split straight into aplay.
+ *
+ * Every command is a routing of (input, channel) pairs to output channels.
+ * Inputs are mapped (wavfile.h) and processed a block of frames at a
+ * time: each input block is split into one plane per channel, and each
+ * output block is woven back together from the planes it routes. On
+ * AArch64 both steps use the NEON structure loads and stores (LD2-LD4,
+ * ST2-ST4) for 2-4 channels of 8, 16, 32 or 64-bit samples; packed 24-bit
+ * and wider layouts use the portable loops. Memory use is a few blocks
+ * regardless of the file length.
+ */
+
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#if defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+#include <wavfile.h>
+
+#define DEFAULT_BLOCK_FRAMES 4096
+#define MAX_BLOCK_FRAMES     (1u << 20)
+#define MAX_INPUTS           WAV_MAX_CHANNELS
+#define MAX_OUTPUTS          WAV_MAX_CHANNELS
+
+typedef struct {
+    int input;                  // index into job_t.in, -1 for silence
+    unsigned int channel;
+} route_t;
+
+typedef struct {
+    char *path;
+    int fd;
+    wav_format_t fmt;
+    route_t route[WAV_MAX_CHANNELS];
+    uint8_t *buf;
+} output_t;
+
+typedef struct {
+    wav_file_t in[MAX_INPUTS];
+    unsigned int n_in;
+    output_t out[MAX_OUTPUTS];
+    unsigned int n_out;
+} job_t;
+
+static int use_neon = 1;
+
+/* ---- Kernels ---- */
+
+static inline void split_loop(uint8_t *const *planes, const uint8_t *src, unsigned int channels,
+                              unsigned int width, size_t from, size_t frames) {
+    for (size_t i = from; i < frames; i++) {
+        const uint8_t *frame = src + i * channels * width;
+
+        for (unsigned int c = 0; c < channels; c++) {
+            memcpy(planes[c] + i * width, frame + c * width, width);
+        }
+    }
+}
+
+static inline void merge_loop(uint8_t *dst, const uint8_t *const *planes, unsigned int channels,
+                              unsigned int width, size_t from, size_t frames) {
+    for (size_t i = from; i < frames; i++) {
+        uint8_t *frame = dst + i * channels * width;
+
+        for (unsigned int c = 0; c < channels; c++) {
+            memcpy(frame + c * width, planes[c] + i * width, width);
+        }
+    }
+}
+
+// Constant widths let the compiler turn the memcpy into a single move
+static void split_scalar(uint8_t *const *planes, const uint8_t *src, unsigned int channels,
+                         unsigned int width, size_t from, size_t frames) {
+    switch (width) {
+    case 1:
+        split_loop(planes, src, channels, 1, from, frames);
+        break;
+    case 2:
+        split_loop(planes, src, channels, 2, from, frames);
+        break;
+    case 3:
+        split_loop(planes, src, channels, 3, from, frames);
+        break;
+    case 4:
+        split_loop(planes, src, channels, 4, from, frames);
+        break;
+    default:
+        split_loop(planes, src, channels, 8, from, frames);
+        break;
+    }
+}
+
+static void merge_scalar(uint8_t *dst, const uint8_t *const *planes, unsigned int channels,
+                         unsigned int width, size_t from, size_t frames) {
+    switch (width) {
+    case 1:
+        merge_loop(dst, planes, channels, 1, from, frames);
+        break;
+    case 2:
+        merge_loop(dst, planes, channels, 2, from, frames);
+        break;
+    case 3:
+        merge_loop(dst, planes, channels, 3, from, frames);
+        break;
+    case 4:
+        merge_loop(dst, planes, channels, 4, from, frames);
+        break;
+    default:
+        merge_loop(dst, planes, channels, 8, from, frames);
+        break;
+    }
+}
+
+#if defined(__aarch64__)
+
+typedef size_t (*split_fn)(uint8_t *const *planes, const uint8_t *src, size_t frames);
+typedef size_t (*merge_fn)(uint8_t *dst, const uint8_t *const *planes, size_t frames);
+
+/*
+ * One LDn/STn moves a whole vector of n-channel frames; the kernels
+ * return how many frames they handled and the scalar loop does the tail.
+ */
+#define NEON_KERNELS(bits, lanes, n)                                                         \
+static size_t split_u##bits##x##n(uint8_t *const *planes, const uint8_t *src, size_t frames) { \
+    const uint##bits##_t *s = (const uint##bits##_t *)src;                                   \
+    size_t i = 0;                                                                            \
+    for (; i + lanes <= frames; i += lanes) {                                                \
+        uint##bits##x##lanes##x##n##_t v = vld##n##q_u##bits(s + i * n);                     \
+        for (unsigned int c = 0; c < n; c++) {                                               \
+            vst1q_u##bits((uint##bits##_t *)planes[c] + i, v.val[c]);                        \
+        }                                                                                    \
+    }                                                                                        \
+    return i;                                                                                \
+}                                                                                            \
+static size_t merge_u##bits##x##n(uint8_t *dst, const uint8_t *const *planes, size_t frames) { \
+    uint##bits##_t *d = (uint##bits##_t *)dst;                                               \
+    size_t i = 0;                                                                            \
+    for (; i + lanes <= frames; i += lanes) {                                                \
+        uint##bits##x##lanes##x##n##_t v;                                                    \
+        for (unsigned int c = 0; c < n; c++) {                                               \
+            v.val[c] = vld1q_u##bits((const uint##bits##_t *)planes[c] + i);                 \
+        }                                                                                    \
+        vst##n##q_u##bits(d + i * n, v);                                                     \
+    }                                                                                        \
+    return i;                                                                                \
+}
+
+NEON_KERNELS(8, 16, 2)
+NEON_KERNELS(8, 16, 3)
+NEON_KERNELS(8, 16, 4)
+NEON_KERNELS(16, 8, 2)
+NEON_KERNELS(16, 8, 3)
+NEON_KERNELS(16, 8, 4)
+NEON_KERNELS(32, 4, 2)
+NEON_KERNELS(32, 4, 3)
+NEON_KERNELS(32, 4, 4)
+NEON_KERNELS(64, 2, 2)
+NEON_KERNELS(64, 2, 3)
+NEON_KERNELS(64, 2, 4)
+
+// [sample width 1/2/4/8][channels 2-4]
+static const split_fn neon_split[4][3] = {
+    { split_u8x2, split_u8x3, split_u8x4 },
+    { split_u16x2, split_u16x3, split_u16x4 },
+    { split_u32x2, split_u32x3, split_u32x4 },
+    { split_u64x2, split_u64x3, split_u64x4 },
+};
+
+static const merge_fn neon_merge[4][3] = {
+    { merge_u8x2, merge_u8x3, merge_u8x4 },
+    { merge_u16x2, merge_u16x3, merge_u16x4 },
+    { merge_u32x2, merge_u32x3, merge_u32x4 },
+    { merge_u64x2, merge_u64x3, merge_u64x4 },
+};
+
+static int neon_index(unsigned int channels, unsigned int width) {
+    if (!use_neon || channels < 2 || channels > 4) {
+        return -1;
+    }
+    switch (width) {
+    case 1:
+        return 0;
+    case 2:
+        return 1;
+    case 4:
+        return 2;
+    case 8:
+        return 3;
+    default:
+        return -1;      // packed 24-bit has no matching lane size
+    }
+}
+
+#endif /* __aarch64__ */
+
+static void split(uint8_t *const *planes, const uint8_t *src, unsigned int channels,
+                  unsigned int width, size_t frames) {
+    size_t done = 0;
+
+    if (channels == 1) {
+        memcpy(planes[0], src, frames * width);
+        return;
+    }
+#if defined(__aarch64__)
+    int k = neon_index(channels, width);
+
+    if (k >= 0) {
+        done = neon_split[k][channels - 2](planes, src, frames);
+    }
+#endif
+    split_scalar(planes, src, channels, width, done, frames);
+}
+
+static void merge(uint8_t *dst, const uint8_t *const *planes, unsigned int channels,
+                  unsigned int width, size_t frames) {
+    size_t done = 0;
+
+    if (channels == 1) {
+        memcpy(dst, planes[0], frames * width);
+        return;
+    }
+#if defined(__aarch64__)
+    int k = neon_index(channels, width);
+
+    if (k >= 0) {
+        done = neon_merge[k][channels - 2](dst, planes, frames);
+    }
+#endif
+    merge_scalar(dst, planes, channels, width, done, frames);
+}
+
+/* ---- Streaming ---- */
+
+static int write_all(int fd, const uint8_t *buf, size_t len) {
+    while (len > 0) {
+        ssize_t n = write(fd, buf, len);
+
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+        buf += n;
+        len -= (size_t)n;
+    }
+    return 0;
+}
+
+static double now_ms(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1000.0 + (double)ts.tv_nsec / 1e6;
+}
+
+// Truncating an output that is also a mapped input would fault the reader
+static int same_file(const job_t *job, const char *path) {
+    struct stat out_st;
+    struct stat in_st;
+
+    if (stat(path, &out_st) != 0) {
+        return 0;
+    }
+    for (unsigned int i = 0; i < job->n_in; i++) {
+        if (fstat(job->in[i].fd, &in_st) == 0 &&
+            in_st.st_dev == out_st.st_dev && in_st.st_ino == out_st.st_ino) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static void close_outputs(job_t *job, int failed) {
+    for (unsigned int o = 0; o < job->n_out; o++) {
+        output_t *out = &job->out[o];
+
+        if (out->fd > STDOUT_FILENO) {
+            if (close(out->fd) != 0 && !failed) {
+                fprintf(stderr, "wav-channels: %s: %s\n", out->path, strerror(errno));
+            }
+            if (failed) {
+                unlink(out->path);
+            }
+        }
+        out->fd = -1;
+        free(out->buf);
+        out->buf = NULL;
+    }
+}
+
+static int run(job_t *job, size_t block, int verbose) {
+    const wav_format_t *fmt = &job->in[0].fmt;
+    unsigned int width = fmt->width;
+    uint8_t *planes[MAX_INPUTS][WAV_MAX_CHANNELS];
+    uint8_t *plane_mem;
+    uint8_t *silence;
+    size_t plane_bytes = (block * width + 63) & ~(size_t)63;
+    size_t n_planes = 0;
+    uint64_t frames = 0;
+    uint64_t bytes_out = 0;
+    double start = now_ms();
+    int failed = 1;
+
+    for (unsigned int i = 0; i < job->n_in; i++) {
+        n_planes += job->in[i].fmt.channels;
+        if (job->in[i].frames > frames) {
+            frames = job->in[i].frames;
+        }
+    }
+
+    // One allocation holds every input plane plus a plane of silence
+    plane_mem = aligned_alloc(64, (n_planes + 1) * plane_bytes);
+    if (plane_mem == NULL) {
+        fprintf(stderr, "wav-channels: out of memory\n");
+        return 1;
+    }
+    n_planes = 0;
+    for (unsigned int i = 0; i < job->n_in; i++) {
+        for (unsigned int c = 0; c < job->in[i].fmt.channels; c++) {
+            planes[i][c] = plane_mem + n_planes++ * plane_bytes;
+        }
+    }
+    silence = plane_mem + n_planes * plane_bytes;
+    memset(silence, wav_silence(fmt), plane_bytes);
+
+    for (unsigned int o = 0; o < job->n_out; o++) {
+        output_t *out = &job->out[o];
+        uint8_t header[WAV_MAX_HEADER];
+        size_t header_len = wav_header(header, &out->fmt, frames);
+
+        if (header_len == 0) {
+            fprintf(stderr, "wav-channels: %s: output would exceed 4 GiB\n", out->path);
+            goto done;
+        }
+        if (strcmp(out->path, "-") == 0) {
+            out->fd = STDOUT_FILENO;
+        } else if (same_file(job, out->path)) {
+            fprintf(stderr, "wav-channels: %s: output is also an input\n", out->path);
+            goto done;
+        } else {
+            out->fd = open(out->path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        }
+        if (out->fd < 0 || write_all(out->fd, header, header_len) != 0) {
+            fprintf(stderr, "wav-channels: %s: %s\n", out->path, strerror(errno));
+            goto done;
+        }
+        out->buf = malloc(plane_bytes * out->fmt.channels);
+        if (out->buf == NULL) {
+            fprintf(stderr, "wav-channels: out of memory\n");
+            goto done;
+        }
+    }
+
+    for (uint64_t pos = 0; pos < frames; pos += block) {
+        size_t n = frames - pos < block ? (size_t)(frames - pos) : block;
+
+        for (unsigned int i = 0; i < job->n_in; i++) {
+            wav_file_t *in = &job->in[i];
+            size_t avail = pos >= in->frames ? 0
+                         : in->frames - pos < n ? (size_t)(in->frames - pos) : n;
+
+            split(planes[i], in->data + pos * in->frame_bytes, in->fmt.channels, width, avail);
+            // Shorter inputs are padded with silence to the longest one
+            if (avail < n) {
+                for (unsigned int c = 0; c < in->fmt.channels; c++) {
+                    memset(planes[i][c] + avail * width, wav_silence(fmt), (n - avail) * width);
+                }
+            }
+            wav_release(in, pos + n);
+        }
+
+        for (unsigned int o = 0; o < job->n_out; o++) {
+            output_t *out = &job->out[o];
+            const uint8_t *src[WAV_MAX_CHANNELS];
+
+            for (unsigned int c = 0; c < out->fmt.channels; c++) {
+                const route_t *r = &out->route[c];
+
+                src[c] = r->input < 0 ? silence : planes[r->input][r->channel];
+            }
+            merge(out->buf, src, out->fmt.channels, width, n);
+            if (write_all(out->fd, out->buf, n * width * out->fmt.channels) != 0) {
+                fprintf(stderr, "wav-channels: %s: %s\n", out->path, strerror(errno));
+                goto done;
+            }
+        }
+    }
+
+    // RIFF chunks are word aligned
+    for (unsigned int o = 0; o < job->n_out; o++) {
+        uint64_t data_len = frames * width * job->out[o].fmt.channels;
+        static const uint8_t pad;
+
+        bytes_out += data_len;
+        if ((data_len & 1) && write_all(job->out[o].fd, &pad, 1) != 0) {
+            fprintf(stderr, "wav-channels: %s: %s\n", job->out[o].path, strerror(errno));
+            goto done;
+        }
+    }
+    failed = 0;
+
+    if (verbose) {
+        double ms = now_ms() - start;
+
+        fprintf(stderr, "wav-channels: %llu frames %s %u Hz, %u -> %u output(s), %.1f ms, %.1f MB/s%s\n",
+                (unsigned long long)frames, wav_format_name(fmt), fmt->rate,
+                job->n_in, job->n_out, ms, ms > 0 ? (double)bytes_out / ms / 1000.0 : 0.0,
+                use_neon ? "" : " (scalar)");
+    }
+
+done:
+    close_outputs(job, failed);
+    free(plane_mem);
+    return failed;
+}
+
+/* ---- Commands ---- */
+
+static int open_input(job_t *job, const char *path) {
+    const char *error = NULL;
+    wav_file_t *in = &job->in[job->n_in];
+
+    if (job->n_in == MAX_INPUTS) {
+        fprintf(stderr, "wav-channels: too many inputs\n");
+        return -1;
+    }
+    if (wav_open(in, path, &error) != 0) {
+        fprintf(stderr, "wav-channels: %s: %s\n", path, error);
+        return -1;
+    }
+    job->n_in++;
+    return 0;
+}
+
+static output_t *add_output(job_t *job, const char *path, unsigned int channels) {
+    output_t *out = &job->out[job->n_out++];
+
+    out->path = strdup(path);
+    out->fd = -1;
+    out->fmt = job->in[0].fmt;
+    out->fmt.channels = channels;
+    // Speaker positions no longer mean anything once channels move
+    out->fmt.channel_mask = 0;
+    return out;
+}
+
+static int parse_channel(const char *arg, unsigned int channels, unsigned int *channel) {
+    char *end;
+    unsigned long v;
+
+    errno = 0;
+    v = strtoul(arg, &end, 10);
+    if (errno != 0 || end == arg || *end != '\0' || v >= channels) {
+        fprintf(stderr, "wav-channels: channel '%s' out of range (input has %u)\n", arg, channels);
+        return -1;
+    }
+    *channel = (unsigned int)v;
+    return 0;
+}
+
+static int cmd_extract(job_t *job, char **args, int n) {
+    unsigned int channel;
+    output_t *out;
+
+    if (n != 3) {
+        return -1;
+    }
+    if (open_input(job, args[0]) != 0 ||
+        parse_channel(args[2], job->in[0].fmt.channels, &channel) != 0) {
+        return 1;
+    }
+    out = add_output(job, args[1], 1);
+    out->route[0] = (route_t){ 0, channel };
+    return 0;
+}
+
+static int cmd_duplicate(job_t *job, char **args, int n) {
+    unsigned long copies = 2;
+    output_t *out;
+
+    if (n != 2 && n != 3) {
+        return -1;
+    }
+    if (n == 3) {
+        copies = strtoul(args[2], NULL, 10);
+        if (copies < 1 || copies > WAV_MAX_CHANNELS) {
+            fprintf(stderr, "wav-channels: copies must be 1-%d\n", WAV_MAX_CHANNELS);
+            return 1;
+        }
+    }
+    if (open_input(job, args[0]) != 0) {
+        return 1;
+    }
+    if (job->in[0].fmt.channels != 1) {
+        fprintf(stderr, "wav-channels: %s: input must be mono (has %u channels)\n",
+                args[0], job->in[0].fmt.channels);
+        return 1;
+    }
+    out = add_output(job, args[1], (unsigned int)copies);
+    for (unsigned int c = 0; c < copies; c++) {
+        out->route[c] = (route_t){ 0, 0 };
+    }
+    return 0;
+}
+
+static int cmd_remap(job_t *job, char **args, int n) {
+    route_t route[WAV_MAX_CHANNELS];
+    unsigned int channels = 0;
+    char *map;
+    char *save = NULL;
+    output_t *out;
+
+    if (n != 3) {
+        return -1;
+    }
+    if (open_input(job, args[0]) != 0) {
+        return 1;
+    }
+
+    // "1,0" swaps a stereo pair, "0,-" silences the right channel
+    map = strdup(args[2]);
+    for (char *tok = strtok_r(map, ",", &save); tok != NULL; tok = strtok_r(NULL, ",", &save)) {
+        if (channels == WAV_MAX_CHANNELS) {
+            fprintf(stderr, "wav-channels: at most %d output channels\n", WAV_MAX_CHANNELS);
+            free(map);
+            return 1;
+        }
+        if (strcmp(tok, "-") == 0) {
+            route[channels++] = (route_t){ -1, 0 };
+            continue;
+        }
+        route[channels] = (route_t){ 0, 0 };
+        if (parse_channel(tok, job->in[0].fmt.channels, &route[channels].channel) != 0) {
+            free(map);
+            return 1;
+        }
+        channels++;
+    }
+    free(map);
+    if (channels == 0) {
+        fprintf(stderr, "wav-channels: empty channel map\n");
+        return 1;
+    }
+
+    out = add_output(job, args[1], channels);
+    memcpy(out->route, route, channels * sizeof(route[0]));
+    return 0;
+}
+
+static int cmd_deinterleave(job_t *job, char **args, int n) {
+    if (n != 2) {
+        return -1;
+    }
+    if (open_input(job, args[0]) != 0) {
+        return 1;
+    }
+    for (unsigned int c = 0; c < job->in[0].fmt.channels; c++) {
+        char *path;
+        output_t *out;
+
+        if (asprintf(&path, "%s-ch%u.wav", args[1], c) < 0) {
+            return 1;
+        }
+        out = add_output(job, path, 1);
+        out->route[0] = (route_t){ 0, c };
+        free(path);
+    }
+    return 0;
+}
+
+static int cmd_interleave(job_t *job, char **args, int n) {
+    unsigned int channels = 0;
+    output_t *out;
+
+    if (n < 2) {
+        return -1;
+    }
+    for (int i = 1; i < n; i++) {
+        const wav_format_t *first;
+        const wav_format_t *fmt;
+
+        if (open_input(job, args[i]) != 0) {
+            return 1;
+        }
+        first = &job->in[0].fmt;
+        fmt = &job->in[job->n_in - 1].fmt;
+        if (fmt->rate != first->rate || fmt->encoding != first->encoding ||
+            fmt->width != first->width || fmt->bits != first->bits) {
+            fprintf(stderr, "wav-channels: %s: %s %u Hz does not match %s %u Hz\n",
+                    args[i], wav_format_name(fmt), fmt->rate,
+                    wav_format_name(first), first->rate);
+            return 1;
+        }
+        channels += fmt->channels;
+    }
+    if (channels > WAV_MAX_CHANNELS) {
+        fprintf(stderr, "wav-channels: at most %d output channels\n", WAV_MAX_CHANNELS);
+        return 1;
+    }
+
+    out = add_output(job, args[0], channels);
+    channels = 0;
+    for (unsigned int i = 0; i < job->n_in; i++) {
+        for (unsigned int c = 0; c < job->in[i].fmt.channels; c++) {
+            out->route[channels++] = (route_t){ (int)i, c };
+        }
+    }
+    return 0;
+}
+
+static int cmd_info(char **args, int n) {
+    int rc = 0;
+
+    if (n < 1) {
+        return -1;
+    }
+    for (int i = 0; i < n; i++) {
+        wav_file_t wav;
+        const char *error = NULL;
+
+        if (wav_open(&wav, args[i], &error) != 0) {
+            fprintf(stderr, "wav-channels: %s: %s\n", args[i], error);
+            rc = 1;
+            continue;
+        }
+        printf("%s: %u ch, %u Hz, %s (%u valid bits), %llu frames, %.3f s",
+               args[i], wav.fmt.channels, wav.fmt.rate, wav_format_name(&wav.fmt), wav.fmt.bits,
+               (unsigned long long)wav.frames,
+               wav.fmt.rate ? (double)wav.frames / wav.fmt.rate : 0.0);
+        if (wav.fmt.channel_mask != 0) {
+            printf(", mask 0x%x", wav.fmt.channel_mask);
+        }
+        printf("\n");
+        wav_close(&wav);
+    }
+    return rc;
+}
+
+static void print_usage(const char *prog) {
+    printf("Usage: %s [options] <command> ...\n", prog);
+    printf("\n");
+    printf("Commands:\n");
+    printf("  extract IN OUT CHANNEL      Write one channel of IN as a mono file\n");
+    printf("  duplicate IN OUT [COUNT]    Copy mono IN to COUNT channels (default 2)\n");
+    printf("  remap IN OUT MAP            Build OUT from a comma list of IN channels,\n");
+    printf("                              '-' for silence (e.g. 1,0 swaps a pair)\n");
+    printf("  deinterleave IN PREFIX      Write PREFIX-chN.wav for every channel\n");
+    printf("  interleave OUT IN...        Concatenate the channels of each IN\n");
+    printf("  info IN...                  Show the format of each file\n");
+    printf("\n");
+    printf("OUT may be '-' for stdout. 8/16/24/32-bit PCM and 32/64-bit float.\n");
+    printf("\n");
+    printf("Options:\n");
+    printf("  -b, --block FRAMES  Frames per processing block (default %d)\n", DEFAULT_BLOCK_FRAMES);
+    printf("  -S, --scalar        Use the portable kernels instead of NEON\n");
+    printf("  -v, --verbose       Report frames, time and throughput on stderr\n");
+    printf("  -h, --help          Show this help\n");
+}
+
+int main(int argc, char *argv[]) {
+    static const struct option long_opts[] = {
+        { "block", required_argument, NULL, 'b' },
+        { "scalar", no_argument, NULL, 'S' },
+        { "verbose", no_argument, NULL, 'v' },
+        { "help", no_argument, NULL, 'h' },
+        { NULL, 0, NULL, 0 }
+    };
+    static job_t job;
+    unsigned long block = DEFAULT_BLOCK_FRAMES;
+    const char *command;
+    char **args;
+    int verbose = 0;
+    int nargs;
+    int opt;
+    int rc;
+
+    while ((opt = getopt_long(argc, argv, "+b:Svh", long_opts, NULL)) != -1) {
+        switch (opt) {
+        case 'b':
+            block = strtoul(optarg, NULL, 0);
+            if (block < 16 || block > MAX_BLOCK_FRAMES) {
+                fprintf(stderr, "wav-channels: block must be 16-%u frames\n", MAX_BLOCK_FRAMES);
+                return 1;
+            }
+            break;
+        case 'S':
+            use_neon = 0;
+            break;
+        case 'v':
+            verbose = 1;
+            break;
+        case 'h':
+            print_usage(argv[0]);
+            return 0;
+        default:
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+    if (optind >= argc) {
+        print_usage(argv[0]);
+        return 1;
+    }
+    command = argv[optind];
+    args = argv + optind + 1;
+    nargs = argc - optind - 1;
+
+    if (strcmp(command, "extract") == 0) {
+        rc = cmd_extract(&job, args, nargs);
+    } else if (strcmp(command, "duplicate") == 0) {
+        rc = cmd_duplicate(&job, args, nargs);
+    } else if (strcmp(command, "remap") == 0) {
+        rc = cmd_remap(&job, args, nargs);
+    } else if (strcmp(command, "deinterleave") == 0) {
+        rc = cmd_deinterleave(&job, args, nargs);
+    } else if (strcmp(command, "interleave") == 0) {
+        rc = cmd_interleave(&job, args, nargs);
+    } else if (strcmp(command, "info") == 0) {
+        rc = cmd_info(args, nargs);
+        if (rc < 0) {
+            print_usage(argv[0]);
+            rc = 1;
+        }
+        return rc;
+    } else {
+        rc = -1;
+    }
+
+    if (rc < 0) {
+        print_usage(argv[0]);
+        rc = 1;
+    }
+    if (rc == 0) {
+        rc = run(&job, block, verbose);
+    }
+
+    for (unsigned int o = 0; o < job.n_out; o++) {
+        free(job.out[o].path);
+    }
+    for (unsigned int i = 0; i < job.n_in; i++) {
+        wav_close(&job.in[i]);
+    }
+    return rc;
+}
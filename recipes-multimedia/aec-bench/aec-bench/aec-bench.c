@@ -0,0 +1,1024 @@
+/* SPDX-License-Identifier: MIT */
+/*
+ * aec-bench - offline echo canceller benchmark
+ *
+ * Replays a far-end (reference) and near-end (microphone) WAV fixture
+ * through each echo canceller the board can run and reports, per engine:
+ *
+ *   - CPU time per frame (mean, p99, max) and the share of one core
+ *     that real-time operation would take
+ *   - added latency: one frame of buffering plus the engine's internal
+ *     delay, measured with a chirp appended to the microphone signal
+ *     while the far end is silent
+ *   - ERLE, echo return loss enhancement: microphone energy over output
+ *     energy while the far end talks, after a warm-up, with the
+ *     per-500 ms minimum and the time taken to converge
+ *   - with a clean near-end track (-s), the attenuation the near-end
+ *     talker suffers during double talk
+ *
+ * Engines: none (passthrough baseline), webrtc (the WebRTC module
+ * PulseAudio's module-echo-cancel and GStreamer's webrtcdsp use) and
+ * voiceseeker (NXP's nxp-afe plugin), as built in. All run in this one
+ * process on the same frames, so the numbers compare directly; the host
+ * build is fine for ERLE, the target for CPU.
+ *
+ *   aec-bench -G /tmp/fx                            # synthetic fixture
+ *   aec-bench -f /tmp/fx/far.wav -n /tmp/fx/near.wav -s /tmp/fx/clean.wav
+ *   aec-bench -f far.wav -n mic.wav -e webrtc -X webrtc.ns=1 -o /tmp/out
+ *   aec-bench -f far.wav -n mic.wav -d 24 -j
+ *
+ * Fixtures are plain recordings: the reference as sent to the speaker
+ * (loop_capture_far on sentai, the snd-aloop far pair on DT510) and the
+ * microphone capture of the same run, starting on the same frame.
+ */
+
+#define _GNU_SOURCE
+#include <errno.h>
+#include <getopt.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+
+#include "aec-engine.h"
+#include <wavfile.h>
+
+#define MAX_CHANNELS        8
+#define MAX_ENGINES         8
+#define MAX_PARAMS          32
+
+#define DEFAULT_WARMUP_S    2.0
+#define FAR_ACTIVE_DBFS     -50.0       // far-end frames that count for ERLE
+#define NEAR_ACTIVE_DBFS    -50.0       // clean near-end frames that make double talk
+#define BLOCK_MS            500
+#define CONVERGED_DB        3.0         // within this of the final ERLE
+#define DELAY_MAX_MS        500
+
+// Latency probe appended to the fixture
+#define PROBE_LEAD_MS       500
+#define PROBE_MS            10
+#define PROBE_TAIL_MS       500
+#define PROBE_LEVEL_DBFS    -12.0
+#define PROBE_MIN_NCC       0.5
+
+#define GEN_RATE            16000
+#define GEN_SECONDS         20
+
+/* ---- Engines ---- */
+
+typedef struct {
+    unsigned int channels;
+    unsigned int frame;
+} none_state_t;
+
+static void *none_open(const aec_config_t *cfg, unsigned int *frame, const char **error) {
+    none_state_t *st = malloc(sizeof(*st));
+
+    if (st == NULL) {
+        *error = "out of memory";
+        return NULL;
+    }
+    st->channels = cfg->mic_channels;
+    st->frame = *frame = cfg->rate / 100;
+    return st;
+}
+
+static int none_process(void *state, const float *mic, const float *ref, float *out) {
+    const none_state_t *st = state;
+
+    (void)ref;
+    for (unsigned int i = 0; i < st->frame; i++) {
+        out[i] = mic[i * st->channels];
+    }
+    return 0;
+}
+
+static void none_close(void *state) {
+    free(state);
+}
+
+static const aec_engine_t aec_engine_none = {
+    "none", "passthrough of microphone channel 0 (baseline)", none_open, none_process, none_close,
+};
+
+static const aec_engine_t *const engines[] = {
+    &aec_engine_none,
+#ifdef HAVE_WEBRTC
+    &aec_engine_webrtc,
+#endif
+#ifdef HAVE_VOICESEEKER
+    &aec_engine_voiceseeker,
+#endif
+};
+
+#define N_ENGINES (sizeof(engines) / sizeof(engines[0]))
+
+const char *aec_param(const aec_config_t *cfg, const char *key) {
+    size_t n = strlen(key);
+
+    for (const char *const *p = cfg->params; p && *p; p++) {
+        if (strncmp(*p, key, n) == 0 && (*p)[n] == '=') {
+            return *p + n + 1;
+        }
+    }
+    return NULL;
+}
+
+/* ---- Fixture ---- */
+
+typedef struct {
+    unsigned int rate;
+    unsigned int mic_channels;
+    unsigned int ref_channels;
+    size_t frames;              // fixture length, without the probe
+    size_t total;               // with the probe
+    size_t probe_at;            // first frame of the chirp
+    float *mic;                 // interleaved, total frames
+    float *ref;
+    float *clean;               // mono, frames, or NULL
+    float *chirp;
+    size_t chirp_len;
+} fixture_t;
+
+static int wav_supported(const wav_file_t *wav) {
+    return (wav->fmt.encoding == WAV_PCM && (wav->fmt.width == 2 || wav->fmt.width == 4)) ||
+           (wav->fmt.encoding == WAV_FLOAT && wav->fmt.width == 4);
+}
+
+static float wav_sample(const wav_file_t *wav, uint64_t frame, unsigned int ch) {
+    const uint8_t *p = wav->data + frame * wav->frame_bytes + ch * wav->fmt.width;
+
+    if (wav->fmt.encoding == WAV_FLOAT) {
+        float v;
+
+        memcpy(&v, p, sizeof(v));
+        return v;
+    } else if (wav->fmt.width == 2) {
+        int16_t v;
+
+        memcpy(&v, p, sizeof(v));
+        return v / 32768.0f;
+    } else {
+        int32_t v;
+
+        memcpy(&v, p, sizeof(v));
+        return (float)(v / 2147483648.0);
+    }
+}
+
+static int load_wav(wav_file_t *wav, const char *path) {
+    const char *error;
+
+    if (wav_open(wav, path, &error) < 0) {
+        fprintf(stderr, "aec-bench: %s: %s\n", path, error);
+        return -1;
+    }
+    if (!wav_supported(wav) || wav->fmt.channels > MAX_CHANNELS) {
+        fprintf(stderr, "aec-bench: %s: %s with %u channels not supported\n", path,
+                wav_format_name(&wav->fmt), wav->fmt.channels);
+        wav_close(wav);
+        return -1;
+    }
+    return 0;
+}
+
+// Hann-windowed linear chirp, as pcm-latency uses for its matched filter
+static float *make_chirp(unsigned int rate, size_t *len) {
+    size_t n = (size_t)rate * PROBE_MS / 1000;
+    double f0 = 500.0;
+    double f1 = fmin(8000.0, 0.4 * rate);
+    double amp = pow(10.0, PROBE_LEVEL_DBFS / 20.0);
+    float *x = malloc(n * sizeof(*x));
+
+    if (x == NULL) {
+        return NULL;
+    }
+    for (size_t i = 0; i < n; i++) {
+        double t = (double)i / rate;
+        double T = (double)n / rate;
+        double w = 0.5 - 0.5 * cos(2.0 * M_PI * i / (n - 1));
+
+        x[i] = (float)(amp * w * sin(2.0 * M_PI * (f0 * t + 0.5 * (f1 - f0) / T * t * t)));
+    }
+    *len = n;
+    return x;
+}
+
+static int load_fixture(fixture_t *fx, const char *far_path, const char *near_path,
+                        const char *clean_path) {
+    wav_file_t far, near, clean;
+    size_t lead, tail;
+
+    memset(fx, 0, sizeof(*fx));
+    if (load_wav(&far, far_path) < 0) {
+        return -1;
+    }
+    if (load_wav(&near, near_path) < 0) {
+        wav_close(&far);
+        return -1;
+    }
+    if (far.fmt.rate != near.fmt.rate) {
+        fprintf(stderr, "aec-bench: %s is %u Hz but %s is %u Hz\n", far_path, far.fmt.rate,
+                near_path, near.fmt.rate);
+        wav_close(&far);
+        wav_close(&near);
+        return -1;
+    }
+    fx->rate = near.fmt.rate;
+    fx->mic_channels = near.fmt.channels;
+    fx->ref_channels = far.fmt.channels;
+    fx->frames = (size_t)(near.frames < far.frames ? near.frames : far.frames);
+    if (near.frames != far.frames) {
+        fprintf(stderr, "aec-bench: fixtures differ in length, using the first %.2f s\n",
+                (double)fx->frames / fx->rate);
+    }
+
+    fx->chirp = make_chirp(fx->rate, &fx->chirp_len);
+    lead = (size_t)fx->rate * PROBE_LEAD_MS / 1000;
+    tail = (size_t)fx->rate * PROBE_TAIL_MS / 1000;
+    fx->probe_at = fx->frames + lead;
+    fx->total = fx->probe_at + fx->chirp_len + tail;
+    fx->mic = calloc(fx->total * fx->mic_channels, sizeof(float));
+    fx->ref = calloc(fx->total * fx->ref_channels, sizeof(float));
+    if (fx->chirp == NULL || fx->mic == NULL || fx->ref == NULL) {
+        fprintf(stderr, "aec-bench: out of memory\n");
+        wav_close(&far);
+        wav_close(&near);
+        return -1;
+    }
+    for (size_t i = 0; i < fx->frames; i++) {
+        for (unsigned int c = 0; c < fx->mic_channels; c++) {
+            fx->mic[i * fx->mic_channels + c] = wav_sample(&near, i, c);
+        }
+        for (unsigned int c = 0; c < fx->ref_channels; c++) {
+            fx->ref[i * fx->ref_channels + c] = wav_sample(&far, i, c);
+        }
+    }
+    for (size_t i = 0; i < fx->chirp_len; i++) {
+        for (unsigned int c = 0; c < fx->mic_channels; c++) {
+            fx->mic[(fx->probe_at + i) * fx->mic_channels + c] = fx->chirp[i];
+        }
+    }
+    wav_close(&far);
+    wav_close(&near);
+
+    if (clean_path) {
+        if (load_wav(&clean, clean_path) < 0) {
+            return -1;
+        }
+        fx->clean = calloc(fx->frames, sizeof(float));
+        if (fx->clean == NULL) {
+            wav_close(&clean);
+            return -1;
+        }
+        for (size_t i = 0; i < fx->frames && i < clean.frames; i++) {
+            fx->clean[i] = wav_sample(&clean, i, 0);
+        }
+        wav_close(&clean);
+    }
+    return 0;
+}
+
+/*
+ * Bulk far-end to microphone delay: correlate 1 ms energy envelopes
+ * (cheap over the whole fixture), then the samples up to the best
+ * envelope lag.
+ */
+static int estimate_delay(const fixture_t *fx, double *delay_ms) {
+    size_t bin = fx->rate / 1000;
+    size_t nb = fx->frames / bin;
+    int max_lag = DELAY_MAX_MS;
+    double *ef = calloc(nb, sizeof(double));
+    double *em = calloc(nb, sizeof(double));
+    double best = -1, mf = 0, mm = 0;
+    int lag_env = 0;
+    long lo, hi, best_lag = 0;
+    double best_c = -1;
+
+    if (ef == NULL || em == NULL || nb < (size_t)max_lag * 2) {
+        free(ef);
+        free(em);
+        return -1;
+    }
+    for (size_t b = 0; b < nb; b++) {
+        for (size_t i = b * bin; i < (b + 1) * bin; i++) {
+            double f = fx->ref[i * fx->ref_channels];
+            double m = fx->mic[i * fx->mic_channels];
+
+            ef[b] += f * f;
+            em[b] += m * m;
+        }
+        ef[b] = sqrt(ef[b]);
+        em[b] = sqrt(em[b]);
+        mf += ef[b];
+        mm += em[b];
+    }
+    mf /= nb;
+    mm /= nb;
+    for (int lag = 0; lag < max_lag; lag++) {
+        double sxy = 0, sxx = 0, syy = 0;
+
+        for (size_t b = 0; b + lag < nb; b++) {
+            double x = ef[b] - mf;
+            double y = em[b + lag] - mm;
+
+            sxy += x * y;
+            sxx += x * x;
+            syy += y * y;
+        }
+        if (sxx > 0 && syy > 0 && sxy / sqrt(sxx * syy) > best) {
+            best = sxy / sqrt(sxx * syy);
+            lag_env = lag;
+        }
+    }
+    free(ef);
+    free(em);
+    if (best < 0.2) {
+        return -1;
+    }
+
+    /*
+     * Refine to the sample over the first few seconds. A room tail drags
+     * the envelope peak late, so search from well before it.
+     */
+    lo = (long)(lag_env - 20) * (long)bin;
+    hi = (long)(lag_env + 2) * (long)bin;
+    for (long lag = lo < 0 ? 0 : lo; lag <= hi; lag++) {
+        size_t n = fx->frames - (size_t)lag;
+        double sxy = 0, sxx = 0, syy = 0;
+
+        if (n > (size_t)fx->rate * 5) {
+            n = (size_t)fx->rate * 5;
+        }
+        for (size_t i = 0; i < n; i++) {
+            double x = fx->ref[i * fx->ref_channels];
+            double y = fx->mic[(i + lag) * fx->mic_channels];
+
+            sxy += x * y;
+            sxx += x * x;
+            syy += y * y;
+        }
+        if (sxx > 0 && syy > 0 && fabs(sxy) / sqrt(sxx * syy) > best_c) {
+            best_c = fabs(sxy) / sqrt(sxx * syy);
+            best_lag = lag;
+        }
+    }
+    *delay_ms = 1000.0 * best_lag / fx->rate;
+    return 0;
+}
+
+/* ---- Benchmark ---- */
+
+typedef struct {
+    const aec_engine_t *engine;
+    int ok;
+    const char *error;
+    unsigned int frame;
+    double cpu_mean_us;
+    double cpu_p99_us;
+    double cpu_max_us;
+    double load_pct;            // CPU per frame over the frame's duration
+    int have_latency;
+    double lag_ms;              // internal delay found by the probe
+    double latency_ms;          // frame + lag
+    double erle_db;
+    double erle_min_db;
+    double converge_s;
+    int have_dt;
+    double dt_atten_db;
+} result_t;
+
+static int compare_double(const void *a, const void *b) {
+    double x = *(const double *)a;
+    double y = *(const double *)b;
+
+    return x < y ? -1 : x > y;
+}
+
+static double thread_cpu_us(void) {
+    struct timespec t;
+
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &t);
+    return (double)t.tv_sec * 1e6 + (double)t.tv_nsec / 1e3;
+}
+
+// Chirp position in out around the probe, by normalized cross-correlation
+static int find_probe(const fixture_t *fx, const float *out, double *lag) {
+    long from = (long)fx->probe_at - (long)fx->rate * PROBE_LEAD_MS / 2000;
+    long to = (long)(fx->total - fx->chirp_len);
+    double et = 0, best = 0;
+    long best_k = -1;
+    double ncc[3] = { 0, 0, 0 };
+
+    for (size_t i = 0; i < fx->chirp_len; i++) {
+        et += (double)fx->chirp[i] * fx->chirp[i];
+    }
+    for (long k = from; k < to; k++) {
+        double sxy = 0, syy = 0, c;
+
+        for (size_t i = 0; i < fx->chirp_len; i++) {
+            sxy += (double)out[k + i] * fx->chirp[i];
+            syy += (double)out[k + i] * out[k + i];
+        }
+        c = syy > 0 ? sxy / sqrt(et * syy) : 0;
+        if (c > best) {
+            best = c;
+            best_k = k;
+        }
+    }
+    if (best_k < 0 || best < PROBE_MIN_NCC) {
+        return -1;
+    }
+    // Parabolic refinement on the neighbours
+    for (int d = -1; d <= 1; d++) {
+        double sxy = 0, syy = 0;
+
+        for (size_t i = 0; i < fx->chirp_len; i++) {
+            sxy += (double)out[best_k + d + i] * fx->chirp[i];
+            syy += (double)out[best_k + d + i] * out[best_k + d + i];
+        }
+        ncc[d + 1] = syy > 0 ? sxy / sqrt(et * syy) : 0;
+    }
+    *lag = (double)(best_k - (long)fx->probe_at);
+    if (ncc[0] - 2 * ncc[1] + ncc[2] < 0) {
+        *lag += 0.5 * (ncc[0] - ncc[2]) / (ncc[0] - 2 * ncc[1] + ncc[2]);
+    }
+    return 0;
+}
+
+static void measure_erle(const fixture_t *fx, const float *out, long lag, double warmup_s,
+                         int verbose, result_t *r) {
+    size_t block = (size_t)fx->rate * BLOCK_MS / 1000;
+    size_t n_blocks = fx->frames / block;
+    double *erle = calloc(n_blocks ? n_blocks : 1, sizeof(double));
+    int *valid = calloc(n_blocks ? n_blocks : 1, sizeof(int));
+    double far_thr = pow(10.0, FAR_ACTIVE_DBFS / 10.0);
+    double near_thr = pow(10.0, NEAR_ACTIVE_DBFS / 10.0);
+    size_t hop = fx->rate / 100;
+    size_t warm = (size_t)(warmup_s * fx->rate);
+    double mic_e = 0, out_e = 0, dt_mic = 0, dt_out = 0;
+
+    r->erle_db = r->erle_min_db = NAN;
+    r->converge_s = NAN;
+    if (erle == NULL || valid == NULL) {
+        free(erle);
+        free(valid);
+        return;
+    }
+
+    // 10 ms hops classified as echo-only, double talk or neither
+    for (size_t b = 0; b < n_blocks; b++) {
+        double bm = 0, bo = 0;
+        size_t active = 0;
+
+        for (size_t h = b * block; h + hop <= (b + 1) * block; h += hop) {
+            double ef = 0, en = 0, em = 0, eo = 0;
+
+            for (size_t i = h; i < h + hop; i++) {
+                double f = fx->ref[i * fx->ref_channels];
+                double m = fx->mic[i * fx->mic_channels];
+                long j = (long)i + lag;
+                double o = j >= 0 && (size_t)j < fx->total ? out[j] : 0;
+
+                ef += f * f;
+                em += m * m;
+                eo += o * o;
+                if (fx->clean) {
+                    en += (double)fx->clean[i] * fx->clean[i];
+                }
+            }
+            ef /= hop;
+            en /= hop;
+            if (fx->clean && en > near_thr) {
+                if (ef > far_thr && h >= warm) {
+                    dt_mic += em;
+                    dt_out += eo;
+                }
+                continue;
+            }
+            if (ef > far_thr) {
+                bm += em;
+                bo += eo;
+                active++;
+                if (h >= warm) {
+                    mic_e += em;
+                    out_e += eo;
+                }
+            }
+        }
+        if (active * hop * 4 >= block && bo > 0) {
+            erle[b] = 10.0 * log10(bm / bo);
+            valid[b] = 1;
+        }
+        if (verbose && valid[b]) {
+            printf("  %-12s %6.1f s  ERLE %5.1f dB\n", r->engine->name, (double)b * BLOCK_MS / 1000,
+                   erle[b]);
+        }
+    }
+    if (out_e > 0 && mic_e > 0) {
+        r->erle_db = 10.0 * log10(mic_e / out_e);
+        for (size_t b = 0; b < n_blocks; b++) {
+            if (!valid[b]) {
+                continue;
+            }
+            if (b * block >= warm && (isnan(r->erle_min_db) || erle[b] < r->erle_min_db)) {
+                r->erle_min_db = erle[b];
+            }
+            if (isnan(r->converge_s) && erle[b] >= r->erle_db - CONVERGED_DB) {
+                r->converge_s = (double)b * BLOCK_MS / 1000;
+            }
+        }
+    }
+    if (dt_out > 0 && dt_mic > 0) {
+        r->have_dt = 1;
+        r->dt_atten_db = 10.0 * log10(dt_mic / dt_out);
+    }
+    free(erle);
+    free(valid);
+}
+
+static int write_output(const char *dir, const char *name, const float *out, size_t frames,
+                        unsigned int rate) {
+    wav_format_t fmt = { WAV_FLOAT, 1, rate, 4, 32, 0 };
+    uint8_t header[WAV_MAX_HEADER];
+    size_t len = wav_header(header, &fmt, frames);
+    char path[512];
+    FILE *f;
+
+    snprintf(path, sizeof(path), "%s/%s.wav", dir, name);
+    if ((f = fopen(path, "wb")) == NULL) {
+        fprintf(stderr, "aec-bench: %s: %s\n", path, strerror(errno));
+        return -1;
+    }
+    if (fwrite(header, 1, len, f) != len || fwrite(out, sizeof(float), frames, f) != frames) {
+        fprintf(stderr, "aec-bench: %s: %s\n", path, strerror(errno));
+        fclose(f);
+        return -1;
+    }
+    fclose(f);
+    return 0;
+}
+
+// Only the -X entries for this engine: "key=v" for all, "engine.key=v" for one
+static void engine_params(const aec_engine_t *e, char *const *all, unsigned int n,
+                          const char **out) {
+    size_t len = strlen(e->name);
+    unsigned int k = 0;
+
+    for (unsigned int i = 0; i < n; i++) {
+        const char *dot = strchr(all[i], '.');
+        const char *eq = strchr(all[i], '=');
+
+        if (dot == NULL || (eq && eq < dot)) {
+            out[k++] = all[i];
+        } else if ((size_t)(dot - all[i]) == len && strncmp(all[i], e->name, len) == 0) {
+            out[k++] = dot + 1;
+        }
+    }
+    out[k] = NULL;
+}
+
+static void run_engine(const fixture_t *fx, const aec_engine_t *e, const aec_config_t *base,
+                       double warmup_s, const char *out_dir, int verbose, result_t *r) {
+    aec_config_t cfg = *base;
+    size_t n_frames, padded;
+    float *mic = NULL, *ref = NULL, *out = NULL;
+    double *cpu = NULL, sum = 0;
+    void *st;
+    double lag = 0;
+
+    memset(r, 0, sizeof(*r));
+    r->engine = e;
+    if ((st = e->open(&cfg, &r->frame, &r->error)) == NULL) {
+        return;
+    }
+
+    // Whole frames only; the last one is padded with silence
+    n_frames = (fx->total + r->frame - 1) / r->frame;
+    padded = n_frames * r->frame;
+    mic = calloc(padded * fx->mic_channels, sizeof(float));
+    ref = calloc(padded * fx->ref_channels, sizeof(float));
+    out = calloc(padded, sizeof(float));
+    cpu = calloc(n_frames, sizeof(double));
+    if (mic == NULL || ref == NULL || out == NULL || cpu == NULL) {
+        r->error = "out of memory";
+        goto done;
+    }
+    memcpy(mic, fx->mic, fx->total * fx->mic_channels * sizeof(float));
+    memcpy(ref, fx->ref, fx->total * fx->ref_channels * sizeof(float));
+
+    for (size_t f = 0; f < n_frames; f++) {
+        double t0 = thread_cpu_us();
+
+        if (e->process(st, mic + f * r->frame * fx->mic_channels,
+                       ref + f * r->frame * fx->ref_channels, out + f * r->frame) != 0) {
+            r->error = "process() failed";
+            goto done;
+        }
+        cpu[f] = thread_cpu_us() - t0;
+        sum += cpu[f];
+    }
+    r->ok = 1;
+    r->cpu_mean_us = sum / n_frames;
+    qsort(cpu, n_frames, sizeof(double), compare_double);
+    r->cpu_p99_us = cpu[(size_t)(0.99 * (n_frames - 1))];
+    r->cpu_max_us = cpu[n_frames - 1];
+    r->load_pct = r->cpu_mean_us / (1e6 * r->frame / fx->rate) * 100.0;
+
+    if (find_probe(fx, out, &lag) == 0) {
+        r->have_latency = 1;
+        r->lag_ms = 1000.0 * lag / fx->rate;
+        r->latency_ms = 1000.0 * (lag + r->frame) / fx->rate;
+    }
+    measure_erle(fx, out, r->have_latency ? lrint(lag) : 0, warmup_s, verbose, r);
+    if (out_dir) {
+        write_output(out_dir, e->name, out, fx->frames, fx->rate);
+    }
+
+done:
+    e->close(st);
+    free(mic);
+    free(ref);
+    free(out);
+    free(cpu);
+}
+
+static void print_result(const result_t *r) {
+    char lat[32] = "-", erle[48] = "-", dt[16] = "-";
+
+    if (!r->ok) {
+        printf("%-12s unavailable: %s\n", r->engine->name, r->error);
+        return;
+    }
+    if (r->have_latency) {
+        snprintf(lat, sizeof(lat), "%.2f", r->latency_ms);
+    }
+    if (!isnan(r->erle_db)) {
+        snprintf(erle, sizeof(erle), "%.1f / %.1f / %.1f s", r->erle_db, r->erle_min_db,
+                 r->converge_s);
+    }
+    if (r->have_dt) {
+        snprintf(dt, sizeof(dt), "%.1f", r->dt_atten_db);
+    }
+    printf("%-12s %6u %9.1f %9.1f %9.1f %7.2f %10s  %-22s %8s\n", r->engine->name, r->frame,
+           r->cpu_mean_us, r->cpu_p99_us, r->cpu_max_us, r->load_pct, lat, erle, dt);
+}
+
+static void json_num(const char *key, int have, double v, int last) {
+    if (have && !isnan(v)) {
+        printf("\"%s\":%.3f%s", key, v, last ? "" : ",");
+    } else {
+        printf("\"%s\":null%s", key, last ? "" : ",");
+    }
+}
+
+static void print_json(const fixture_t *fx, double delay_ms, const result_t *res, unsigned int n) {
+    printf("{\"rate\":%u,\"mic_channels\":%u,\"ref_channels\":%u,\"seconds\":%.3f,"
+           "\"delay_ms\":%.2f,\"engines\":[", fx->rate, fx->mic_channels, fx->ref_channels,
+           (double)fx->frames / fx->rate, delay_ms);
+    for (unsigned int i = 0; i < n; i++) {
+        const result_t *r = &res[i];
+
+        printf("%s{\"engine\":\"%s\",\"ok\":%s,", i ? "," : "", r->engine->name,
+               r->ok ? "true" : "false");
+        if (!r->ok) {
+            printf("\"error\":\"%s\"}", r->error);
+            continue;
+        }
+        printf("\"frame\":%u,", r->frame);
+        json_num("cpu_mean_us", 1, r->cpu_mean_us, 0);
+        json_num("cpu_p99_us", 1, r->cpu_p99_us, 0);
+        json_num("cpu_max_us", 1, r->cpu_max_us, 0);
+        json_num("load_pct", 1, r->load_pct, 0);
+        json_num("lag_ms", r->have_latency, r->lag_ms, 0);
+        json_num("latency_ms", r->have_latency, r->latency_ms, 0);
+        json_num("erle_db", 1, r->erle_db, 0);
+        json_num("erle_min_db", 1, r->erle_min_db, 0);
+        json_num("converge_s", 1, r->converge_s, 0);
+        json_num("dt_attenuation_db", r->have_dt, r->dt_atten_db, 1);
+        printf("}");
+    }
+    printf("]}\n");
+}
+
+/* ---- Synthetic fixture ---- */
+
+static uint32_t rng_state = 0x2545f491u;
+
+static float noise(void) {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 17;
+    rng_state ^= rng_state << 5;
+    return (float)rng_state / 2147483648.0f - 1.0f;
+}
+
+// Speech-like: tilted noise under a syllable envelope, in phrases
+static void talker(float *x, size_t n, unsigned int rate, double syll_hz, double phrase_s,
+                   double pause_s, double level_dbfs) {
+    double amp = pow(10.0, level_dbfs / 20.0) * 2.5;
+    float lp = 0;
+
+    for (size_t i = 0; i < n; i++) {
+        double t = (double)i / rate;
+        double s = sin(2.0 * M_PI * syll_hz * t);
+        double env = s > 0 ? s * s : 0;
+
+        lp += 0.3f * (noise() - lp);
+        x[i] = fmod(t, phrase_s + pause_s) < phrase_s ? (float)(amp * env * lp) : 0.0f;
+    }
+}
+
+static int write_s16(const char *dir, const char *name, const float *x, size_t frames,
+                     unsigned int channels, unsigned int rate) {
+    wav_format_t fmt = { WAV_PCM, channels, rate, 2, 16, 0 };
+    uint8_t header[WAV_MAX_HEADER];
+    size_t len = wav_header(header, &fmt, frames);
+    char path[512];
+    FILE *f;
+
+    snprintf(path, sizeof(path), "%s/%s", dir, name);
+    if ((f = fopen(path, "wb")) == NULL) {
+        fprintf(stderr, "aec-bench: %s: %s\n", path, strerror(errno));
+        return -1;
+    }
+    fwrite(header, 1, len, f);
+    for (size_t i = 0; i < frames * channels; i++) {
+        long v = lrintf(x[i] * 32768.0f);
+        int16_t s = (int16_t)(v > 32767 ? 32767 : v < -32768 ? -32768 : v);
+
+        fwrite(&s, sizeof(s), 1, f);
+    }
+    if (fclose(f) != 0) {
+        fprintf(stderr, "aec-bench: %s: %s\n", path, strerror(errno));
+        return -1;
+    }
+    printf("%s\n", path);
+    return 0;
+}
+
+/*
+ * far.wav: a talker with pauses; near.wav: its echo through a 100 ms
+ * room (direct path after 8 ms, soft-clipped like a small speaker) plus
+ * a near-end talker for a double-talk stretch and a near-only stretch,
+ * and a -65 dBFS noise floor; clean.wav: that near-end talker alone.
+ */
+static int generate(const char *dir, unsigned int rate, unsigned int channels, unsigned int seconds) {
+    size_t n = (size_t)rate * seconds;
+    size_t taps = (size_t)rate / 10;
+    size_t direct = (size_t)rate * 8 / 1000;
+    float *far = calloc(n, sizeof(float));
+    float *near = calloc(n, sizeof(float));
+    float *clean = calloc(n, sizeof(float));
+    float *echo = calloc(n, sizeof(float));
+    float *mic = calloc(n * channels, sizeof(float));
+    float *h = calloc(taps, sizeof(float));
+    double floor_amp = pow(10.0, -65.0 / 20.0) * sqrt(3.0);
+    int rc = -1;
+
+    if (!far || !near || !clean || !echo || !mic || !h) {
+        fprintf(stderr, "aec-bench: out of memory\n");
+        goto out;
+    }
+    if (mkdir(dir, 0755) < 0 && errno != EEXIST) {
+        fprintf(stderr, "aec-bench: %s: %s\n", dir, strerror(errno));
+        goto out;
+    }
+
+    talker(far, n, rate, 3.7, 2.5, 0.7, -20.0);
+    talker(near, n, rate, 4.3, 1.9, 0.4, -26.0);
+    for (size_t i = 0; i < n; i++) {
+        double t = (double)i / seconds / rate;
+
+        // Double talk over 60-80 % of the fixture, near end alone over 85-95 %
+        if (t >= 0.85 && t < 0.95) {
+            far[i] = 0;
+        }
+        clean[i] = (t >= 0.6 && t < 0.8) || (t >= 0.85 && t < 0.95) ? near[i] : 0.0f;
+    }
+
+    h[direct] = 0.5f;
+    for (size_t k = direct + 1; k < taps; k++) {
+        h[k] = 0.15f * noise() * (float)exp(-6.9 * (double)(k - direct) / (0.15 * rate));
+    }
+    for (size_t i = 0; i < n; i++) {
+        double acc = 0;
+
+        for (size_t k = direct; k < taps && k <= i; k++) {
+            acc += (double)h[k] * far[i - k];
+        }
+        echo[i] = (float)(tanh(1.5 * acc) / 1.5);
+    }
+    for (size_t i = 0; i < n; i++) {
+        for (unsigned int c = 0; c < channels; c++) {
+            float e = i >= c ? echo[i - c] : 0.0f;
+
+            mic[i * channels + c] = e + clean[i] + (float)(floor_amp * noise());
+        }
+    }
+
+    if (write_s16(dir, "far.wav", far, n, 1, rate) == 0 &&
+        write_s16(dir, "near.wav", mic, n, channels, rate) == 0 &&
+        write_s16(dir, "clean.wav", clean, n, 1, rate) == 0) {
+        rc = 0;
+    }
+out:
+    free(far);
+    free(near);
+    free(clean);
+    free(echo);
+    free(mic);
+    free(h);
+    return rc;
+}
+
+static void print_usage(const char *prog) {
+    printf("Usage: %s -f FAR.wav -n NEAR.wav [options]\n", prog);
+    printf("       %s -G DIR [-r HZ] [-c N] [-t S]\n", prog);
+    printf("\n");
+    printf("Fixture:\n");
+    printf("  -f, --far FILE        Far-end reference, as sent to the speaker\n");
+    printf("  -n, --near FILE       Microphone capture of the same run\n");
+    printf("  -s, --clean FILE      Near-end talker alone; excludes double talk from\n");
+    printf("                        ERLE and reports its attenuation\n");
+    printf("  -d, --delay MS        Far-end to microphone delay hint (default: estimated)\n");
+    printf("  -w, --warmup S        Excluded from ERLE while engines adapt (default %.0f)\n",
+           DEFAULT_WARMUP_S);
+    printf("\n");
+    printf("Engines:\n");
+    printf("  -e, --engine NAME     Run only this engine; repeatable (default all)\n");
+    printf("  -X, --param K=V       Engine parameter; ENGINE.K=V for one engine only\n");
+    printf("  -l, --list            List the engines built in\n");
+    printf("  -o, --output DIR      Write each engine's output as DIR/ENGINE.wav\n");
+    printf("\n");
+    printf("Synthetic fixture:\n");
+    printf("  -G, --generate DIR    Write far.wav, near.wav and clean.wav to DIR\n");
+    printf("  -r, --rate HZ         Rate (default %d)\n", GEN_RATE);
+    printf("  -c, --channels N      Microphone channels (default 1)\n");
+    printf("  -t, --seconds S       Length (default %d)\n", GEN_SECONDS);
+    printf("\n");
+    printf("  -j, --json            Print the results as one JSON line\n");
+    printf("  -v, --verbose         Print ERLE per %d ms block\n", BLOCK_MS);
+    printf("  -h, --help            Show this help\n");
+    printf("\n");
+    printf("Exit status: 0 all engines ran, 1 an engine failed, 2 error.\n");
+}
+
+int main(int argc, char *argv[]) {
+    static const struct option long_opts[] = {
+        { "far", required_argument, NULL, 'f' },
+        { "near", required_argument, NULL, 'n' },
+        { "clean", required_argument, NULL, 's' },
+        { "delay", required_argument, NULL, 'd' },
+        { "warmup", required_argument, NULL, 'w' },
+        { "engine", required_argument, NULL, 'e' },
+        { "param", required_argument, NULL, 'X' },
+        { "list", no_argument, NULL, 'l' },
+        { "output", required_argument, NULL, 'o' },
+        { "generate", required_argument, NULL, 'G' },
+        { "rate", required_argument, NULL, 'r' },
+        { "channels", required_argument, NULL, 'c' },
+        { "seconds", required_argument, NULL, 't' },
+        { "json", no_argument, NULL, 'j' },
+        { "verbose", no_argument, NULL, 'v' },
+        { "help", no_argument, NULL, 'h' },
+        { NULL, 0, NULL, 0 }
+    };
+    const char *far_path = NULL, *near_path = NULL, *clean_path = NULL;
+    const char *out_dir = NULL, *gen_dir = NULL;
+    const aec_engine_t *selected[MAX_ENGINES];
+    unsigned int n_selected = 0;
+    char *params[MAX_PARAMS];
+    unsigned int n_params = 0;
+    const char *engine_list[MAX_PARAMS + 1];
+    result_t results[MAX_ENGINES];
+    double delay_ms = -1, warmup_s = DEFAULT_WARMUP_S;
+    unsigned int gen_rate = GEN_RATE, gen_channels = 1, gen_seconds = GEN_SECONDS;
+    int json = 0, verbose = 0, failed = 0;
+    fixture_t fx;
+    aec_config_t cfg;
+    int opt;
+
+    while ((opt = getopt_long(argc, argv, "f:n:s:d:w:e:X:lo:G:r:c:t:jvh", long_opts, NULL)) != -1) {
+        switch (opt) {
+        case 'f':
+            far_path = optarg;
+            break;
+        case 'n':
+            near_path = optarg;
+            break;
+        case 's':
+            clean_path = optarg;
+            break;
+        case 'd':
+            delay_ms = atof(optarg);
+            break;
+        case 'w':
+            warmup_s = atof(optarg);
+            break;
+        case 'e': {
+            unsigned int i;
+
+            for (i = 0; i < N_ENGINES && strcmp(engines[i]->name, optarg) != 0; i++) {
+            }
+            if (i == N_ENGINES) {
+                fprintf(stderr, "aec-bench: no engine '%s' in this build (see -l)\n", optarg);
+                return 2;
+            }
+            if (n_selected < MAX_ENGINES) {
+                selected[n_selected++] = engines[i];
+            }
+            break;
+        }
+        case 'X':
+            if (strchr(optarg, '=') == NULL || n_params == MAX_PARAMS) {
+                fprintf(stderr, "aec-bench: bad or too many -X parameters\n");
+                return 2;
+            }
+            params[n_params++] = optarg;
+            break;
+        case 'l':
+            for (unsigned int i = 0; i < N_ENGINES; i++) {
+                printf("%-12s %s\n", engines[i]->name, engines[i]->description);
+            }
+            return 0;
+        case 'o':
+            out_dir = optarg;
+            break;
+        case 'G':
+            gen_dir = optarg;
+            break;
+        case 'r':
+            gen_rate = (unsigned int)atoi(optarg);
+            break;
+        case 'c':
+            gen_channels = (unsigned int)atoi(optarg);
+            break;
+        case 't':
+            gen_seconds = (unsigned int)atoi(optarg);
+            break;
+        case 'j':
+            json = 1;
+            break;
+        case 'v':
+            verbose = 1;
+            break;
+        case 'h':
+            print_usage(argv[0]);
+            return 0;
+        default:
+            print_usage(argv[0]);
+            return 2;
+        }
+    }
+
+    if (gen_dir) {
+        if (gen_rate < 8000 || gen_channels == 0 || gen_channels > MAX_CHANNELS || gen_seconds < 2) {
+            fprintf(stderr, "aec-bench: bad rate, channels or length\n");
+            return 2;
+        }
+        return generate(gen_dir, gen_rate, gen_channels, gen_seconds) == 0 ? 0 : 2;
+    }
+    if (far_path == NULL || near_path == NULL) {
+        print_usage(argv[0]);
+        return 2;
+    }
+    if (load_fixture(&fx, far_path, near_path, clean_path) < 0) {
+        return 2;
+    }
+    if (delay_ms < 0 && estimate_delay(&fx, &delay_ms) < 0) {
+        fprintf(stderr, "aec-bench: no far-end echo found in %s, delay hint 0\n", near_path);
+        delay_ms = 0;
+    }
+    if (n_selected == 0) {
+        for (unsigned int i = 0; i < N_ENGINES && i < MAX_ENGINES; i++) {
+            selected[n_selected++] = engines[i];
+        }
+    }
+
+    if (!json) {
+        printf("fixture: %.2f s, %u Hz, %u mic / %u ref channels, echo delay %.2f ms\n",
+               (double)fx.frames / fx.rate, fx.rate, fx.mic_channels, fx.ref_channels, delay_ms);
+        printf("%-12s %6s %9s %9s %9s %7s %10s  %-22s %8s\n", "engine", "frame", "cpu us",
+               "p99 us", "max us", "load %", "latency ms", "ERLE dB (min / conv)", "DT att");
+    }
+    for (unsigned int i = 0; i < n_selected; i++) {
+        cfg.rate = fx.rate;
+        cfg.mic_channels = fx.mic_channels;
+        cfg.ref_channels = fx.ref_channels;
+        cfg.delay_ms = (unsigned int)lrint(delay_ms);
+        engine_params(selected[i], params, n_params, engine_list);
+        cfg.params = engine_list;
+        run_engine(&fx, selected[i], &cfg, warmup_s, out_dir, verbose && !json, &results[i]);
+        failed |= !results[i].ok;
+        if (!json) {
+            print_result(&results[i]);
+        }
+    }
+    if (json) {
+        print_json(&fx, delay_ms, results, n_selected);
+    }
+    return failed ? 1 : 0;
+}
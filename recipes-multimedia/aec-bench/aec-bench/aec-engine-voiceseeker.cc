@@ -0,0 +1,137 @@
+/* SPDX-License-Identifier: MIT */
+/*
+ * aec-bench engine: NXP VoiceSeeker (nxp-afe-voiceseeker).
+ *
+ * libvoiceseekerlight.so is a signal-processor plugin for the nxp-afe
+ * daemon: afe dlopen()s it, calls createProcessor() and drives the
+ * returned object with its mic and reference periods. This engine loads
+ * the same library the same way, so the benchmark measures exactly what
+ * afe would run. The interface below mirrors nxp-afe's
+ * SignalProcessorImplementation at the SRCREV pinned in
+ * nxp-afe_git.bb; the library is a proprietary AArch64 blob and is only
+ * found on the target.
+ *
+ * Buffers are 32-bit float interleaved, as afe hands them over; the
+ * output is the single AEC/beamformer channel. -X parameters are passed
+ * to openProcessor() as its configuration map (the Config.ini keys),
+ * except these, which the engine uses itself:
+ *
+ *   lib=PATH     plugin (default /usr/lib/nxp-afe/libvoiceseekerlight.so)
+ *   period=N     frames per call (default 512, afe's period)
+ */
+
+#include <dlfcn.h>
+#include <new>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <unordered_map>
+
+#include "aec-engine.h"
+
+#define DEFAULT_LIB     "/usr/lib/nxp-afe/libvoiceseekerlight.so"
+#define DEFAULT_PERIOD  512
+
+namespace SignalProcessor {
+
+class SignalProcessorImplementation {
+  public:
+    virtual ~SignalProcessorImplementation() {}
+    virtual int openProcessor(const std::unordered_map<std::string, std::string> *configs = nullptr) = 0;
+    virtual int closeProcessor() = 0;
+    virtual int processSignal(const char *nativeMicBuffer, const long int micBufferSize,
+                              const char *nativeRefBuffer, const long int refBufferSize,
+                              char *processed, const long int processedSize) = 0;
+};
+
+} // namespace SignalProcessor
+
+namespace {
+
+typedef SignalProcessor::SignalProcessorImplementation *(*create_fn)();
+
+struct VoiceseekerState {
+    void *lib = nullptr;
+    SignalProcessor::SignalProcessorImplementation *proc = nullptr;
+    std::unordered_map<std::string, std::string> config;
+    unsigned int frame = 0;
+    long mic_bytes = 0;
+    long ref_bytes = 0;
+};
+
+void *voiceseeker_open(const aec_config_t *cfg, unsigned int *frame, const char **error) {
+    const char *lib = aec_param(cfg, "lib");
+    const char *period = aec_param(cfg, "period");
+    VoiceseekerState *st;
+    create_fn create;
+
+    st = new (std::nothrow) VoiceseekerState;
+    if (st == nullptr) {
+        *error = "out of memory";
+        return nullptr;
+    }
+    st->lib = dlopen(lib ? lib : DEFAULT_LIB, RTLD_NOW | RTLD_LOCAL);
+    if (st->lib == nullptr) {
+        *error = "libvoiceseekerlight.so not installed (nxp-afe-voiceseeker)";
+        delete st;
+        return nullptr;
+    }
+    create = reinterpret_cast<create_fn>(dlsym(st->lib, "createProcessor"));
+    if (create == nullptr || (st->proc = create()) == nullptr) {
+        *error = "plugin has no usable createProcessor()";
+        dlclose(st->lib);
+        delete st;
+        return nullptr;
+    }
+
+    for (const char *const *p = cfg->params; p && *p; p++) {
+        const char *eq = strchr(*p, '=');
+
+        if (eq && strncmp(*p, "lib=", 4) != 0 && strncmp(*p, "period=", 7) != 0) {
+            st->config[std::string(*p, eq - *p)] = eq + 1;
+        }
+    }
+    st->config["sample_rate"] = std::to_string(cfg->rate);
+    st->config["mic_channels"] = std::to_string(cfg->mic_channels);
+    st->config["ref_channels"] = std::to_string(cfg->ref_channels);
+    if (st->proc->openProcessor(&st->config) != 0) {
+        *error = "openProcessor() refused the configuration";
+        delete st->proc;
+        dlclose(st->lib);
+        delete st;
+        return nullptr;
+    }
+
+    st->frame = period ? (unsigned int)atoi(period) : DEFAULT_PERIOD;
+    st->mic_bytes = (long)(st->frame * cfg->mic_channels * sizeof(float));
+    st->ref_bytes = (long)(st->frame * cfg->ref_channels * sizeof(float));
+    *frame = st->frame;
+    return st;
+}
+
+int voiceseeker_process(void *state, const float *mic, const float *ref, float *out) {
+    VoiceseekerState *st = static_cast<VoiceseekerState *>(state);
+
+    return st->proc->processSignal(reinterpret_cast<const char *>(mic), st->mic_bytes,
+                                   reinterpret_cast<const char *>(ref), st->ref_bytes,
+                                   reinterpret_cast<char *>(out), (long)(st->frame * sizeof(float)));
+}
+
+void voiceseeker_close(void *state) {
+    VoiceseekerState *st = static_cast<VoiceseekerState *>(state);
+
+    st->proc->closeProcessor();
+    delete st->proc;
+    dlclose(st->lib);
+    delete st;
+}
+
+} // namespace
+
+extern "C" const aec_engine_t aec_engine_voiceseeker = {
+    "voiceseeker",
+    "NXP VoiceSeeker (nxp-afe libvoiceseekerlight)",
+    voiceseeker_open,
+    voiceseeker_process,
+    voiceseeker_close,
+};
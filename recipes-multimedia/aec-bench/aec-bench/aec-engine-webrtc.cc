@@ -0,0 +1,145 @@
+/* SPDX-License-Identifier: MIT */
+/*
+ * aec-bench engine: WebRTC audio processing module.
+ *
+ * The library behind PulseAudio's module-echo-cancel aec_method=webrtc
+ * (load-echo-cancellation-module.pa) and GStreamer's webrtcdsp, at the
+ * webrtc-audio-processing-1 API. 10 ms frames at 16, 32 or 48 kHz.
+ *
+ * Only the echo canceller and high-pass filter run by default, so ERLE
+ * is the canceller's own; module-echo-cancel's other stages are
+ * available as -X parameters:
+ *
+ *   hpf=0|1      high-pass filter (default 1)
+ *   ns=0|1       noise suppression (default 0; module-echo-cancel: 1)
+ *   agc=0|1      adaptive digital gain (default 0; module-echo-cancel: 1)
+ *   mobile=0|1   AECM instead of AEC3 (default 0)
+ */
+
+#include <new>
+#include <stdlib.h>
+#include <vector>
+
+#include <modules/audio_processing/include/audio_processing.h>
+
+#include "aec-engine.h"
+
+namespace {
+
+struct WebrtcState {
+    webrtc::AudioProcessing *apm = nullptr;
+    webrtc::StreamConfig mic_cfg;
+    webrtc::StreamConfig ref_cfg;
+    webrtc::StreamConfig out_cfg;
+    unsigned int frame = 0;
+    unsigned int mic_channels = 0;
+    unsigned int ref_channels = 0;
+    int delay_ms = 0;
+
+    // Planar copies, as the float API takes one pointer per channel
+    std::vector<std::vector<float>> mic;
+    std::vector<std::vector<float>> ref;
+    std::vector<float *> mic_ptr;
+    std::vector<float *> ref_ptr;
+    std::vector<float> out;
+};
+
+bool flag(const aec_config_t *cfg, const char *key, bool def) {
+    const char *v = aec_param(cfg, key);
+
+    return v ? atoi(v) != 0 : def;
+}
+
+void *webrtc_open(const aec_config_t *cfg, unsigned int *frame, const char **error) {
+    WebrtcState *st;
+    webrtc::AudioProcessing::Config config;
+
+    if (cfg->rate != 16000 && cfg->rate != 32000 && cfg->rate != 48000) {
+        *error = "needs 16, 32 or 48 kHz fixtures";
+        return nullptr;
+    }
+    st = new (std::nothrow) WebrtcState;
+    if (st == nullptr) {
+        *error = "out of memory";
+        return nullptr;
+    }
+    st->apm = webrtc::AudioProcessingBuilder().Create();
+    if (st->apm == nullptr) {
+        delete st;
+        *error = "AudioProcessingBuilder failed";
+        return nullptr;
+    }
+    config.echo_canceller.enabled = true;
+    config.echo_canceller.mobile_mode = flag(cfg, "mobile", false);
+    config.high_pass_filter.enabled = flag(cfg, "hpf", true);
+    config.noise_suppression.enabled = flag(cfg, "ns", false);
+    config.gain_controller1.enabled = flag(cfg, "agc", false);
+    config.gain_controller1.mode = webrtc::AudioProcessing::Config::GainController1::kAdaptiveDigital;
+    st->apm->ApplyConfig(config);
+
+    st->frame = cfg->rate / 100;
+    st->mic_channels = cfg->mic_channels;
+    st->ref_channels = cfg->ref_channels;
+    st->delay_ms = (int)cfg->delay_ms;
+    st->mic_cfg = webrtc::StreamConfig(cfg->rate, cfg->mic_channels);
+    st->ref_cfg = webrtc::StreamConfig(cfg->rate, cfg->ref_channels);
+    st->out_cfg = webrtc::StreamConfig(cfg->rate, 1);
+    st->mic.assign(cfg->mic_channels, std::vector<float>(st->frame));
+    st->ref.assign(cfg->ref_channels, std::vector<float>(st->frame));
+    for (auto &c : st->mic) {
+        st->mic_ptr.push_back(c.data());
+    }
+    for (auto &c : st->ref) {
+        st->ref_ptr.push_back(c.data());
+    }
+    st->out.resize(st->frame);
+    *frame = st->frame;
+    return st;
+}
+
+int webrtc_process(void *state, const float *mic, const float *ref, float *out) {
+    WebrtcState *st = static_cast<WebrtcState *>(state);
+    float *out_ptr = st->out.data();
+    int err;
+
+    for (unsigned int i = 0; i < st->frame; i++) {
+        for (unsigned int c = 0; c < st->mic_channels; c++) {
+            st->mic[c][i] = mic[i * st->mic_channels + c];
+        }
+        for (unsigned int c = 0; c < st->ref_channels; c++) {
+            st->ref[c][i] = ref[i * st->ref_channels + c];
+        }
+    }
+    // Render side first, as module-echo-cancel does for every capture block
+    err = st->apm->ProcessReverseStream(st->ref_ptr.data(), st->ref_cfg, st->ref_cfg,
+                                        st->ref_ptr.data());
+    if (err != webrtc::AudioProcessing::kNoError) {
+        return err;
+    }
+    st->apm->set_stream_delay_ms(st->delay_ms);
+    err = st->apm->ProcessStream(st->mic_ptr.data(), st->mic_cfg, st->out_cfg, &out_ptr);
+    if (err != webrtc::AudioProcessing::kNoError) {
+        return err;
+    }
+    for (unsigned int i = 0; i < st->frame; i++) {
+        out[i] = st->out[i];
+    }
+    return 0;
+}
+
+void webrtc_close(void *state) {
+    WebrtcState *st = static_cast<WebrtcState *>(state);
+
+    delete st->apm;
+    delete st;
+}
+
+} // namespace
+
+extern "C" const aec_engine_t aec_engine_webrtc = {
+    "webrtc",
+    "WebRTC AEC3 (PulseAudio module-echo-cancel, webrtcdsp)",
+    webrtc_open,
+    webrtc_process,
+    webrtc_close,
+};
@@ -0,0 +1,52 @@
+/* SPDX-License-Identifier: MIT */
+/*
+ * Echo canceller backends for aec-bench.
+ *
+ * Every engine is driven the same way: open() for a rate and channel
+ * layout, then process() once per frame of the size open() chose, with
+ * the microphone and far-end reference of that frame. Samples are float
+ * in [-1, 1), interleaved; the output is one channel, the signal the
+ * engine would hand to the voice application.
+ *
+ * The C++ engines export these descriptors with C linkage.
+ */
+
+#ifndef AEC_ENGINE_H
+#define AEC_ENGINE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    unsigned int rate;
+    unsigned int mic_channels;
+    unsigned int ref_channels;
+    unsigned int delay_ms;          // far-end to microphone delay of the fixture
+    const char *const *params;      // NULL-terminated "key=value" list from -X
+} aec_config_t;
+
+typedef struct {
+    const char *name;
+    const char *description;
+
+    /*
+     * Returns the engine state, or NULL with *error set. *frame is the
+     * number of frames every process() call takes.
+     */
+    void *(*open)(const aec_config_t *cfg, unsigned int *frame, const char **error);
+    int (*process)(void *state, const float *mic, const float *ref, float *out);
+    void (*close)(void *state);
+} aec_engine_t;
+
+// Value of key in a -X list, or NULL
+const char *aec_param(const aec_config_t *cfg, const char *key);
+
+extern const aec_engine_t aec_engine_webrtc;
+extern const aec_engine_t aec_engine_voiceseeker;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* AEC_ENGINE_H */
@@ -0,0 +1,293 @@
+/* SPDX-License-Identifier: MIT */
+/*
+ * RIFF/WAVE reader and header writer (see wavfile.h)
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "wavfile.h"
+
+#define WAVE_FORMAT_EXTENSIBLE 0xFFFE
+
+// KSDATAFORMAT_SUBTYPE_* GUID, minus the leading format tag
+static const uint8_t subformat_tail[14] = {
+    0x00, 0x00, 0x00, 0x00, 0x10, 0x00, 0x80, 0x00, 0x00, 0xAA, 0x00, 0x38, 0x9B, 0x71
+};
+
+static uint16_t get16(const uint8_t *p) {
+    return (uint16_t)(p[0] | p[1] << 8);
+}
+
+static uint32_t get32(const uint8_t *p) {
+    return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+static uint8_t *put16(uint8_t *p, uint16_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    return p + 2;
+}
+
+static uint8_t *put32(uint8_t *p, uint32_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+    return p + 4;
+}
+
+static uint8_t *put_tag(uint8_t *p, const char *tag) {
+    memcpy(p, tag, 4);
+    return p + 4;
+}
+
+static int parse_fmt(wav_format_t *fmt, const uint8_t *p, uint32_t len, const char **error) {
+    unsigned int tag;
+    unsigned int block_align;
+
+    if (len < 16) {
+        *error = "fmt chunk too short";
+        return -1;
+    }
+
+    tag = get16(p);
+    fmt->channels = get16(p + 2);
+    fmt->rate = get32(p + 4);
+    block_align = get16(p + 12);
+    fmt->bits = get16(p + 14);
+    fmt->channel_mask = 0;
+
+    if (tag == WAVE_FORMAT_EXTENSIBLE) {
+        if (len < 40 || memcmp(p + 26, subformat_tail, sizeof(subformat_tail)) != 0) {
+            *error = "unsupported WAVE_FORMAT_EXTENSIBLE subformat";
+            return -1;
+        }
+        // The container size stays in bits; valid bits may be fewer
+        if (get16(p + 18) != 0) {
+            fmt->bits = get16(p + 18);
+        }
+        fmt->channel_mask = get32(p + 20);
+        tag = get16(p + 24);
+    }
+
+    if (fmt->channels == 0 || fmt->channels > WAV_MAX_CHANNELS) {
+        *error = "unsupported channel count";
+        return -1;
+    }
+    if (block_align == 0 || block_align % fmt->channels != 0) {
+        *error = "block alignment is not a whole number of samples";
+        return -1;
+    }
+    fmt->width = block_align / fmt->channels;
+
+    switch (tag) {
+    case WAV_PCM:
+        fmt->encoding = WAV_PCM;
+        if (fmt->width < 1 || fmt->width > 4) {
+            *error = "unsupported PCM sample width";
+            return -1;
+        }
+        break;
+    case WAV_FLOAT:
+        fmt->encoding = WAV_FLOAT;
+        if (fmt->width != 4 && fmt->width != 8) {
+            *error = "unsupported float sample width";
+            return -1;
+        }
+        break;
+    default:
+        *error = "compressed WAV files are not supported";
+        return -1;
+    }
+
+    if (fmt->bits == 0 || fmt->bits > fmt->width * 8) {
+        fmt->bits = fmt->width * 8;
+    }
+    return 0;
+}
+
+int wav_open(wav_file_t *wav, const char *path, const char **error) {
+    struct stat st;
+    const uint8_t *p;
+    const uint8_t *end;
+    int have_fmt = 0;
+    int err;
+
+    memset(wav, 0, sizeof(*wav));
+    wav->fd = -1;
+
+    wav->fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (wav->fd < 0) {
+        *error = strerror(errno);
+        return -1;
+    }
+    if (fstat(wav->fd, &st) != 0) {
+        *error = strerror(errno);
+        goto fail;
+    }
+    if (!S_ISREG(st.st_mode) || st.st_size < 12) {
+        *error = "not a WAV file";
+        errno = EINVAL;
+        goto fail;
+    }
+
+    wav->map_len = (size_t)st.st_size;
+    wav->map = mmap(NULL, wav->map_len, PROT_READ, MAP_PRIVATE, wav->fd, 0);
+    if (wav->map == MAP_FAILED) {
+        wav->map = NULL;
+        *error = strerror(errno);
+        goto fail;
+    }
+    madvise(wav->map, wav->map_len, MADV_SEQUENTIAL);
+
+    p = wav->map;
+    end = p + wav->map_len;
+    if (memcmp(p, "RIFF", 4) != 0 || memcmp(p + 8, "WAVE", 4) != 0) {
+        *error = memcmp(p, "RIFX", 4) == 0 ? "big-endian WAV files are not supported"
+                                           : "not a RIFF/WAVE file";
+        errno = EINVAL;
+        goto fail;
+    }
+
+    // Walk the chunks up to "data"; anything after it is ignored
+    p += 12;
+    while (end - p >= 8) {
+        uint32_t len = get32(p + 4);
+        const uint8_t *body = p + 8;
+
+        if (memcmp(p, "fmt ", 4) == 0) {
+            if ((uint64_t)(end - body) < len || parse_fmt(&wav->fmt, body, len, error) != 0) {
+                if ((uint64_t)(end - body) < len) {
+                    *error = "truncated fmt chunk";
+                }
+                errno = EINVAL;
+                goto fail;
+            }
+            have_fmt = 1;
+        } else if (memcmp(p, "data", 4) == 0) {
+            uint64_t avail = (uint64_t)(end - body);
+
+            if (!have_fmt) {
+                *error = "data chunk before fmt chunk";
+                errno = EINVAL;
+                goto fail;
+            }
+            wav->frame_bytes = (size_t)wav->fmt.channels * wav->fmt.width;
+            wav->data = body;
+            wav->frames = (len < avail ? len : avail) / wav->frame_bytes;
+            return 0;
+        }
+
+        if ((uint64_t)(end - body) < (uint64_t)len + (len & 1)) {
+            break;
+        }
+        p = body + len + (len & 1);
+    }
+
+    *error = have_fmt ? "no data chunk" : "no fmt chunk";
+    errno = EINVAL;
+
+fail:
+    err = errno;
+    wav_close(wav);
+    errno = err;
+    return -1;
+}
+
+void wav_close(wav_file_t *wav) {
+    if (wav->map != NULL) {
+        munmap(wav->map, wav->map_len);
+        wav->map = NULL;
+    }
+    if (wav->fd >= 0) {
+        close(wav->fd);
+        wav->fd = -1;
+    }
+}
+
+void wav_release(wav_file_t *wav, uint64_t frame) {
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    size_t upto;
+
+    if (wav->map == NULL) {
+        return;
+    }
+    upto = (size_t)(wav->data - (const uint8_t *)wav->map) + (size_t)frame * wav->frame_bytes;
+    upto &= ~(page - 1);
+
+    // Batch the calls; one per megabyte is plenty to bound the footprint
+    if (upto > wav->map_len || upto < wav->released + (1u << 20)) {
+        return;
+    }
+    madvise((uint8_t *)wav->map + wav->released, upto - wav->released, MADV_DONTNEED);
+    wav->released = upto;
+}
+
+size_t wav_header(uint8_t *buf, const wav_format_t *fmt, uint64_t frames) {
+    uint32_t block_align = fmt->channels * fmt->width;
+    uint64_t data_len = frames * block_align;
+    int extensible = fmt->channels > 2 || fmt->bits != fmt->width * 8 || fmt->channel_mask != 0;
+    int fact = !extensible && fmt->encoding != WAV_PCM;
+    uint32_t fmt_len = extensible ? 40 : fact ? 18 : 16;
+    size_t header_len = 12 + 8 + fmt_len + (extensible || fact ? 12 : 0) + 8;
+    uint8_t *p = buf;
+
+    if (data_len + header_len - 8 > UINT32_MAX) {
+        return 0;
+    }
+
+    p = put_tag(p, "RIFF");
+    p = put32(p, (uint32_t)(header_len - 8 + data_len + (data_len & 1)));
+    p = put_tag(p, "WAVE");
+
+    p = put_tag(p, "fmt ");
+    p = put32(p, fmt_len);
+    p = put16(p, extensible ? WAVE_FORMAT_EXTENSIBLE : (uint16_t)fmt->encoding);
+    p = put16(p, (uint16_t)fmt->channels);
+    p = put32(p, fmt->rate);
+    p = put32(p, fmt->rate * block_align);
+    p = put16(p, (uint16_t)block_align);
+    p = put16(p, (uint16_t)(fmt->width * 8));
+    if (extensible) {
+        p = put16(p, 22);
+        p = put16(p, (uint16_t)fmt->bits);
+        p = put32(p, fmt->channel_mask);
+        p = put16(p, (uint16_t)fmt->encoding);
+        memcpy(p, subformat_tail, sizeof(subformat_tail));
+        p += sizeof(subformat_tail);
+    } else if (fact) {
+        p = put16(p, 0);
+    }
+
+    // Non-PCM data is expected to carry its frame count
+    if (extensible || fact) {
+        p = put_tag(p, "fact");
+        p = put32(p, 4);
+        p = put32(p, frames > UINT32_MAX ? UINT32_MAX : (uint32_t)frames);
+    }
+
+    p = put_tag(p, "data");
+    p = put32(p, (uint32_t)data_len);
+    return (size_t)(p - buf);
+}
+
+const char *wav_format_name(const wav_format_t *fmt) {
+    if (fmt->encoding == WAV_FLOAT) {
+        return fmt->width == 8 ? "f64" : "f32";
+    }
+    switch (fmt->width) {
+    case 1:
+        return "u8";
+    case 2:
+        return "s16";
+    case 3:
+        return "s24";
+    default:
+        return fmt->bits == 24 ? "s24_32" : "s32";
+    }
+}
@@ -0,0 +1,80 @@
+/* SPDX-License-Identifier: MIT */
+/*
+ * Minimal RIFF/WAVE reader and header writer for the board audio tools.
+ *
+ * Input files are mapped rather than read, so a tool can walk a
+ * recording of any length while only the block it is working on is
+ * resident (wav_release() drops the pages behind the cursor).
+ *
+ * Handles integer PCM (8/16/24/32-bit, including 24-in-32 containers)
+ * and IEEE float (32/64-bit), in both the plain and the
+ * WAVE_FORMAT_EXTENSIBLE fmt layouts. Little-endian hosts only.
+ */
+
+#ifndef WAVFILE_H
+#define WAVFILE_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define WAV_MAX_CHANNELS   64
+#define WAV_MAX_HEADER     80
+
+typedef enum {
+    WAV_PCM = 1,
+    WAV_FLOAT = 3
+} wav_encoding_t;
+
+typedef struct {
+    wav_encoding_t encoding;
+    unsigned int channels;
+    unsigned int rate;
+    unsigned int width;         // bytes per sample container
+    unsigned int bits;          // valid bits per sample
+    uint32_t channel_mask;      // speaker positions, 0 if unspecified
+} wav_format_t;
+
+typedef struct {
+    wav_format_t fmt;
+    const uint8_t *data;        // first frame
+    uint64_t frames;
+    size_t frame_bytes;
+
+    // Mapping bookkeeping
+    void *map;
+    size_t map_len;
+    size_t released;
+    int fd;
+} wav_file_t;
+
+/*
+ * Map and parse path. Returns 0, or -1 with *error describing the
+ * problem (errno is also set for system errors). A data chunk that
+ * claims more than the file holds, as left by an interrupted arecord,
+ * is clamped to the frames actually present.
+ */
+int wav_open(wav_file_t *wav, const char *path, const char **error);
+void wav_close(wav_file_t *wav);
+
+// Tell the kernel frames before `frame` will not be read again
+void wav_release(wav_file_t *wav, uint64_t frame);
+
+/*
+ * Build a header for `frames` frames of fmt into buf (WAV_MAX_HEADER
+ * bytes). The plain layout is used for mono/stereo full-width samples,
+ * which is what Python's wave module and older players expect; the
+ * extensible layout otherwise. An odd-sized data chunk must be followed
+ * by one pad byte, which the RIFF size already counts. Returns the
+ * header length, or 0 if the data would not fit a 4 GiB RIFF file.
+ */
+size_t wav_header(uint8_t *buf, const wav_format_t *fmt, uint64_t frames);
+
+// Short description such as "s16" or "f32"
+const char *wav_format_name(const wav_format_t *fmt);
+
+// Byte value of digital silence (0x80 for unsigned 8-bit, else 0)
+static inline uint8_t wav_silence(const wav_format_t *fmt) {
+    return fmt->encoding == WAV_PCM && fmt->width == 1 ? 0x80 : 0x00;
+}
+
+#endif /* WAVFILE_H */
@@ -0,0 +1,129 @@
+/*
+ * ele-probe - print the ELE / platform snapshot from libeleprobe
+ *
+ *   ele-probe                  # human-readable summary
+ *   ele-probe --json           # for scripts and ele-foundries-cli.py
+ *   ele-probe --refresh        # probe again instead of using /run
+ *
+ * Copyright (C) 2024 Dynamic Devices Ltd.
+ * Licensed under BSD-3-Clause
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <getopt.h>
+
+#include "eleprobe.h"
+
+static void print_usage(const char *prog) {
+    printf("Usage: %s [options]\n", prog);
+    printf("\n");
+    printf("Options:\n");
+    printf("  -j, --json          Print the snapshot as JSON\n");
+    printf("  -r, --refresh       Probe again and update the cache\n");
+    printf("  -n, --no-mailbox    Do not query the enclave (GET_INFO)\n");
+    printf("  -i, --invalidate    Drop the cached snapshot and exit\n");
+    printf("  -h, --help          Show this help\n");
+}
+
+static const char *mark(int ok) {
+    return ok ? "✅" : "❌";
+}
+
+static void print_summary(const struct ele_probe *p) {
+    unsigned int count = p->firmware_count < ELE_PROBE_MAX_FIRMWARE ? p->firmware_count
+                                                                    : ELE_PROBE_MAX_FIRMWARE;
+
+    printf("%s ELE device node: %s%s%s\n", mark(p->present & ELE_PROBE_HAVE_DEVICE),
+           p->device_path,
+           (p->present & ELE_PROBE_HAVE_SIMULATOR) ? " (ele-sim)" : "",
+           (p->present & ELE_PROBE_HAVE_DEVICE) && !(p->present & ELE_PROBE_HAVE_DEVICE_ACCESS)
+               ? " (no access)" : "");
+    printf("%s ELE sysfs: %s\n", mark(p->present & ELE_PROBE_HAVE_SYSFS), p->sysfs_path);
+    printf("%s ELE mailbox: %s", mark(p->present & ELE_PROBE_HAVE_MAILBOX), p->mailbox_path);
+    if (p->mailbox_driver[0] != '\0') {
+        printf(" (driver %s)", p->mailbox_driver);
+    }
+    printf("\n");
+    printf("%s ELE OCOTP: %s", mark(p->present & ELE_PROBE_HAVE_OCOTP), p->ocotp_path);
+    if (p->present & ELE_PROBE_HAVE_OCOTP) {
+        printf(" (%llu bytes%s)", (unsigned long long)p->ocotp_size,
+               (p->present & ELE_PROBE_HAVE_OCOTP_READABLE) ? "" : ", not readable");
+    }
+    printf("\n");
+    printf("%s ELE device tree symbol\n", mark(p->present & ELE_PROBE_HAVE_DT_SYMBOL));
+
+    if (p->present & ELE_PROBE_HAVE_INFO) {
+        printf("✅ ELE firmware 0x%08x, SoC 0x%04x rev 0x%02x, lifecycle %s (0x%04x)\n",
+               p->fw_version, p->soc_id, p->soc_rev,
+               ele_probe_lifecycle_name(p->lifecycle), p->lifecycle);
+        printf("   UID: %016llx\n", (unsigned long long)p->uid);
+    } else {
+        printf("ℹ️  ELE GET_INFO not available\n");
+    }
+
+    printf("%s ELE firmware directory: %s (%u files)\n",
+           mark(p->present & ELE_PROBE_HAVE_FIRMWARE_DIR), p->firmware_path, p->firmware_count);
+    for (unsigned int i = 0; i < count; i++) {
+        printf("   📦 %s (%llu bytes)\n", p->firmware[i].name,
+               (unsigned long long)p->firmware[i].size);
+    }
+
+    if (p->present & ELE_PROBE_HAVE_RESERVED_MEM) {
+        printf("✅ ELE reserved memory: 0x%08llx-0x%08llx %s\n",
+               (unsigned long long)p->reserved_start, (unsigned long long)p->reserved_end,
+               p->reserved_name);
+    } else {
+        printf("⚠️  ELE reserved memory not found in /proc/iomem\n");
+    }
+}
+
+int main(int argc, char *argv[]) {
+    static const struct option long_opts[] = {
+        { "json", no_argument, NULL, 'j' },
+        { "refresh", no_argument, NULL, 'r' },
+        { "no-mailbox", no_argument, NULL, 'n' },
+        { "invalidate", no_argument, NULL, 'i' },
+        { "help", no_argument, NULL, 'h' },
+        { NULL, 0, NULL, 0 }
+    };
+    struct ele_probe probe;
+    unsigned int flags = 0;
+    int json = 0;
+    int opt;
+
+    while ((opt = getopt_long(argc, argv, "jrnih", long_opts, NULL)) != -1) {
+        switch (opt) {
+        case 'j':
+            json = 1;
+            break;
+        case 'r':
+            flags |= ELE_PROBE_REFRESH;
+            break;
+        case 'n':
+            flags |= ELE_PROBE_NO_MAILBOX;
+            break;
+        case 'i':
+            return ele_probe_invalidate() == 0 ? 0 : 1;
+        case 'h':
+            print_usage(argv[0]);
+            return 0;
+        default:
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (ele_probe_get(&probe, flags) != 0) {
+        fprintf(stderr, "ele-probe: probe failed\n");
+        return 1;
+    }
+
+    if (json) {
+        ele_probe_write_json(&probe, stdout);
+    } else {
+        print_summary(&probe);
+    }
+    return 0;
+}
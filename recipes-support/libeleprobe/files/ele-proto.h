@@ -0,0 +1,66 @@
+/*
+ * ele-proto - EdgeLock Enclave mailbox framing and command ids
+ *
+ * The one copy of the wire constants shared by libeleprobe, the PKCS#11
+ * module and simulator (lmp-ele-foundries) and the test suite. A message
+ * is a one-word header (version, size in words, command, tag) followed by
+ * payload words; responses carry the success/failure indicator in the low
+ * byte of the first payload word.
+ *
+ * The base API commands are NXP's. The HSM service commands and their
+ * payload layouts are the ele-sim protocol, unverified on hardware: real
+ * firmware takes its buffers through SE_IOCTL_SETUP_IOBUF and gives some
+ * of these ids other meanings (0x73 is signature-prepare, not verify).
+ *
+ * Copyright (C) 2024 Dynamic Devices Ltd.
+ * Licensed under BSD-3-Clause
+ */
+
+#ifndef ELE_PROTO_H
+#define ELE_PROTO_H
+
+// Message framing
+#define ELE_MSG_MAX_WORDS       64
+#define ELE_MSG_TAG_CMD         0x17
+#define ELE_MSG_TAG_RSP         0xE1
+#define ELE_BASE_API_VER        0x06
+#define ELE_HSM_API_VER         0x07
+
+#define ELE_RSP_SUCCESS         0xD6
+#define ELE_RSP_FAILURE         0x29
+
+// Base API commands
+#define ELE_CMD_PING            0x01
+#define ELE_CMD_GET_INFO        0xDA
+
+// HSM service commands (ele-sim protocol, see above)
+#define ELE_CMD_KEY_GENERATE    0x42
+#define ELE_CMD_KEY_DELETE      0x4E
+#define ELE_CMD_SIGN_GENERATE   0x72
+#define ELE_CMD_SIGN_VERIFY     0x73
+#define ELE_CMD_RNG_GET_RANDOM  0xCD
+#define ELE_CMD_HASH_ONE_GO     0xCC
+
+// Digest algorithms understood by ELE_CMD_HASH_ONE_GO (PSA algorithm ids)
+#define ELE_HASH_ALGO_SHA256    0x02000009
+#define ELE_HASH_ALGO_SHA384    0x0200000A
+#define ELE_HASH_ALGO_SHA512    0x0200000B
+
+// Key types understood by ELE_CMD_KEY_GENERATE
+#define ELE_KEY_TYPE_ECC_NIST   0x7112
+
+/*
+ * Key lifetimes (PSA values). Volatile keys belong to the key store
+ * session that made them; persistent keys can be used from any session
+ * of the key store until they are deleted.
+ */
+#define ELE_KEY_LIFETIME_VOLATILE   0x00000000
+#define ELE_KEY_LIFETIME_PERSISTENT 0x00000001
+
+// Signature schemes understood by ELE_CMD_SIGN_GENERATE / ELE_CMD_SIGN_VERIFY
+#define ELE_SIG_SCHEME_ECDSA    0x06000600
+
+// ELE_CMD_SIGN_VERIFY result word for a valid signature
+#define ELE_VERIFY_SUCCESS      0x5A3CC3A5
+
+#endif /* ELE_PROTO_H */
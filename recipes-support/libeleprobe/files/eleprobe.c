@@ -0,0 +1,503 @@
+/*
+ * libeleprobe - one-pass EdgeLock Enclave / platform probe
+ *
+ * Each fact is gathered with the fewest system calls that give it: one
+ * stat() per path, one read of the mailbox uevent, one readdir() of the
+ * firmware directory, one read() of /proc/iomem and, unless disabled, a
+ * single GET_INFO round trip to ele-sim. The snapshot is a fixed-size structure
+ * written to the cache with rename(), so readers see either the old or
+ * the new one.
+ *
+ * Copyright (C) 2024 Dynamic Devices Ltd.
+ * Licensed under BSD-3-Clause
+ */
+
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <dirent.h>
+#include <time.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include "ele-proto.h"
+#include "eleprobe.h"
+
+#define ELE_PROBE_MAGIC         0x454C5052      // "ELPR"
+#define ELE_PROBE_IOMEM_MAX     (64 * 1024)
+
+// Seconds a snapshot without a usable device node is reused
+#define ELE_PROBE_ABSENT_MAX_AGE 5
+
+static const struct {
+    uint32_t value;
+    const char *name;
+} ele_probe_lifecycles[] = {
+    { 0x0001, "Fab" },
+    { 0x0002, "NXP open" },
+    { 0x0008, "OEM open" },
+    { 0x0020, "OEM secure world closed" },
+    { 0x0080, "OEM closed" },
+    { 0x0100, "Field return OEM" },
+    { 0x0200, "Field return NXP" },
+    { 0x0400, "OEM locked" },
+    { 0x0800, "Bricked" },
+};
+
+static const char *ele_probe_env(const char *name, const char *fallback) {
+    const char *value = getenv(name);
+
+    return (value != NULL && *value != '\0') ? value : fallback;
+}
+
+static void ele_probe_config(struct ele_probe *probe) {
+    int fd;
+
+    memset(probe, 0, sizeof(*probe));
+    probe->magic = ELE_PROBE_MAGIC;
+    probe->size = sizeof(*probe);
+
+    snprintf(probe->device_path, sizeof(probe->device_path), "%s",
+             ele_probe_env("ELE_DEVICE_PATH", ELE_PROBE_DEVICE_PATH));
+    snprintf(probe->sysfs_path, sizeof(probe->sysfs_path), "%s",
+             ele_probe_env("ELE_SYSFS_PATH", ELE_PROBE_SYSFS_PATH));
+    snprintf(probe->firmware_path, sizeof(probe->firmware_path), "%s",
+             ele_probe_env("ELE_FIRMWARE_PATH", ELE_PROBE_FIRMWARE_PATH));
+    snprintf(probe->mailbox_path, sizeof(probe->mailbox_path), "%s",
+             ele_probe_env("ELE_MAILBOX_PATH", ELE_PROBE_MAILBOX_PATH));
+    snprintf(probe->ocotp_path, sizeof(probe->ocotp_path), "%s",
+             ele_probe_env("ELE_OCOTP_PATH", ELE_PROBE_OCOTP_PATH));
+    probe->euid = (uint32_t)geteuid();
+
+    fd = open("/proc/sys/kernel/random/boot_id", O_RDONLY | O_CLOEXEC);
+    if (fd >= 0) {
+        ssize_t n = read(fd, probe->boot_id, sizeof(probe->boot_id) - 1);
+        close(fd);
+        if (n > 0) {
+            probe->boot_id[strcspn(probe->boot_id, "\n")] = '\0';
+        }
+    }
+}
+
+static const char *ele_probe_cache_path(void) {
+    return ele_probe_env("ELE_PROBE_CACHE", ELE_PROBE_CACHE_PATH);
+}
+
+/* Cache */
+
+static int ele_probe_load(struct ele_probe *probe, const struct ele_probe *config) {
+    int fd = open(ele_probe_cache_path(), O_RDONLY | O_CLOEXEC);
+    ssize_t n;
+
+    if (fd < 0) {
+        return -1;
+    }
+    n = pread(fd, probe, sizeof(*probe), 0);
+    close(fd);
+
+    // Same boot, caller and paths, or the snapshot describes something else
+    if (n != (ssize_t)sizeof(*probe) || probe->magic != ELE_PROBE_MAGIC ||
+        probe->size != sizeof(*probe) || config->boot_id[0] == '\0' ||
+        memcmp(probe->boot_id, config->boot_id, sizeof(probe->boot_id)) != 0 ||
+        memcmp(probe->device_path, config->device_path,
+               offsetof(struct ele_probe, present) - offsetof(struct ele_probe, device_path)) != 0) {
+        return -1;
+    }
+    return 0;
+}
+
+static void ele_probe_store(const struct ele_probe *probe) {
+    const char *path = ele_probe_cache_path();
+    char dir[256], tmp[300];
+    char *slash;
+    int fd;
+
+    snprintf(dir, sizeof(dir), "%s", path);
+    slash = strrchr(dir, '/');
+    if (slash != NULL && slash != dir) {
+        *slash = '\0';
+        mkdir(dir, 0755);
+    }
+
+    snprintf(tmp, sizeof(tmp), "%s.%ld", path, (long)getpid());
+    // Owner only: the snapshot holds what this uid was allowed to see
+    fd = open(tmp, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    if (fd < 0) {
+        return;
+    }
+    if (write(fd, probe, sizeof(*probe)) != (ssize_t)sizeof(*probe) || close(fd) != 0 ||
+        rename(tmp, path) != 0) {
+        unlink(tmp);
+    }
+}
+
+int ele_probe_invalidate(void) {
+    return unlink(ele_probe_cache_path()) == 0 || errno == ENOENT ? 0 : -1;
+}
+
+/* Probes */
+
+static void ele_probe_mailbox_driver(struct ele_probe *probe) {
+    char path[ELE_PROBE_PATH_MAX + 32], buf[512];
+    const char *driver;
+    ssize_t n;
+    int fd;
+
+    snprintf(path, sizeof(path), "%s/driver/uevent", probe->mailbox_path);
+    fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return;
+    }
+    n = read(fd, buf, sizeof(buf) - 1);
+    close(fd);
+    if (n <= 0) {
+        return;
+    }
+    buf[n] = '\0';
+
+    probe->present |= ELE_PROBE_HAVE_MAILBOX_DRIVER;
+    driver = strstr(buf, "DRIVER=");
+    if (driver != NULL) {
+        driver += 7;
+        snprintf(probe->mailbox_driver, sizeof(probe->mailbox_driver), "%.*s",
+                 (int)strcspn(driver, "\n"), driver);
+    }
+}
+
+static int ele_probe_compare_firmware(const void *a, const void *b) {
+    return strcmp(((const struct ele_probe_firmware *)a)->name,
+                  ((const struct ele_probe_firmware *)b)->name);
+}
+
+static void ele_probe_firmware_files(struct ele_probe *probe) {
+    DIR *dir = opendir(probe->firmware_path);
+    struct dirent *de;
+
+    if (dir == NULL) {
+        return;
+    }
+    probe->present |= ELE_PROBE_HAVE_FIRMWARE_DIR;
+
+    while ((de = readdir(dir)) != NULL) {
+        struct stat st;
+
+        if (de->d_name[0] == '.' ||
+            fstatat(dirfd(dir), de->d_name, &st, 0) != 0 || !S_ISREG(st.st_mode)) {
+            continue;
+        }
+        if (probe->firmware_count < ELE_PROBE_MAX_FIRMWARE) {
+            struct ele_probe_firmware *fw = &probe->firmware[probe->firmware_count];
+
+            snprintf(fw->name, sizeof(fw->name), "%.*s", (int)sizeof(fw->name) - 1, de->d_name);
+            fw->size = (uint64_t)st.st_size;
+            fw->mtime = st.st_mtime;
+        }
+        probe->firmware_count++;
+    }
+    closedir(dir);
+
+    qsort(probe->firmware,
+          probe->firmware_count < ELE_PROBE_MAX_FIRMWARE ? probe->firmware_count : ELE_PROBE_MAX_FIRMWARE,
+          sizeof(probe->firmware[0]), ele_probe_compare_firmware);
+}
+
+// Find the ELE carve-out in /proc/iomem (addresses read as 0 without root)
+static void ele_probe_reserved_memory(struct ele_probe *probe) {
+    char *buf = malloc(ELE_PROBE_IOMEM_MAX);
+    size_t len = 0;
+    ssize_t n;
+    int fd;
+
+    if (buf == NULL) {
+        return;
+    }
+    fd = open("/proc/iomem", O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        free(buf);
+        return;
+    }
+    while (len < ELE_PROBE_IOMEM_MAX - 1 &&
+           (n = read(fd, buf + len, ELE_PROBE_IOMEM_MAX - 1 - len)) > 0) {
+        len += (size_t)n;
+    }
+    close(fd);
+    buf[len] = '\0';
+
+    for (char *line = buf, *next; line != NULL && *line != '\0'; line = next) {
+        unsigned long start, end;
+        char name[48];
+
+        next = strchr(line, '\n');
+        if (next != NULL) {
+            *next++ = '\0';
+        }
+        if (sscanf(line, " %lx-%lx : %47[^\n]", &start, &end, name) == 3 &&
+            start <= ELE_RESERVED_MEM_START && end >= ELE_RESERVED_MEM_START &&
+            strstr(name, "ele") != NULL) {
+            probe->present |= ELE_PROBE_HAVE_RESERVED_MEM;
+            probe->reserved_start = start;
+            probe->reserved_end = end;
+            snprintf(probe->reserved_name, sizeof(probe->reserved_name), "%s", name);
+            break;
+        }
+    }
+    free(buf);
+}
+
+static int ele_probe_open_device(const struct ele_probe *probe) {
+    struct sockaddr_un addr;
+    int fd;
+
+    if (!(probe->present & ELE_PROBE_HAVE_SIMULATOR)) {
+        return open(probe->device_path, O_RDWR | O_CLOEXEC);
+    }
+    if (strlen(probe->device_path) >= sizeof(addr.sun_path)) {
+        return -1;
+    }
+
+    fd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        return -1;
+    }
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, probe->device_path);
+    if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// GET_INFO: firmware version, SoC id/revision, lifecycle, 64-bit UID
+static void ele_probe_get_info(struct ele_probe *probe) {
+    uint32_t cmd = ((uint32_t)ELE_MSG_TAG_CMD << 24) | ((uint32_t)ELE_CMD_GET_INFO << 16) |
+                   (1u << 8) | ELE_BASE_API_VER;
+    uint32_t rsp[16];
+    ssize_t n = -1;
+    int fd = ele_probe_open_device(probe);
+
+    if (fd < 0) {
+        return;
+    }
+    if (write(fd, &cmd, sizeof(cmd)) == (ssize_t)sizeof(cmd)) {
+        do {
+            n = read(fd, rsp, sizeof(rsp));
+        } while (n < 0 && errno == EINTR);
+    }
+    close(fd);
+
+    if (n < (ssize_t)(7 * sizeof(uint32_t)) || (rsp[0] >> 24) != ELE_MSG_TAG_RSP ||
+        ((rsp[0] >> 16) & 0xFF) != ELE_CMD_GET_INFO || (rsp[1] & 0xFF) != ELE_RSP_SUCCESS) {
+        return;
+    }
+
+    probe->present |= ELE_PROBE_HAVE_INFO;
+    probe->fw_version = rsp[2];
+    probe->soc_id = rsp[3] & 0xFFFF;
+    probe->soc_rev = rsp[3] >> 16;
+    probe->lifecycle = rsp[4];
+    probe->uid = ((uint64_t)rsp[6] << 32) | rsp[5];
+}
+
+static void ele_probe_collect(struct ele_probe *probe, unsigned int flags) {
+    char path[ELE_PROBE_PATH_MAX + 32];
+    struct stat st;
+
+    probe->taken = (int64_t)time(NULL);
+
+    if (stat(probe->device_path, &st) == 0) {
+        probe->present |= ELE_PROBE_HAVE_DEVICE;
+        probe->device_mode = st.st_mode;
+        if (S_ISSOCK(st.st_mode)) {
+            probe->present |= ELE_PROBE_HAVE_SIMULATOR;
+        }
+        if (access(probe->device_path, R_OK | W_OK) == 0) {
+            probe->present |= ELE_PROBE_HAVE_DEVICE_ACCESS;
+        }
+    }
+    if (stat(probe->sysfs_path, &st) == 0) {
+        probe->present |= ELE_PROBE_HAVE_SYSFS;
+    }
+    if (stat(probe->mailbox_path, &st) == 0) {
+        probe->present |= ELE_PROBE_HAVE_MAILBOX;
+        ele_probe_mailbox_driver(probe);
+    }
+
+    snprintf(path, sizeof(path), "%s/nvmem", probe->ocotp_path);
+    if (stat(path, &st) == 0) {
+        probe->present |= ELE_PROBE_HAVE_OCOTP;
+        probe->ocotp_size = (uint64_t)st.st_size;
+        if (access(path, R_OK) == 0) {
+            probe->present |= ELE_PROBE_HAVE_OCOTP_READABLE;
+        }
+    }
+
+    if (stat(ELE_PROBE_DT_SYMBOL, &st) == 0) {
+        probe->present |= ELE_PROBE_HAVE_DT_SYMBOL;
+    }
+
+    ele_probe_firmware_files(probe);
+    ele_probe_reserved_memory(probe);
+
+    if (!(flags & ELE_PROBE_NO_MAILBOX) && (probe->present & ELE_PROBE_HAVE_DEVICE_ACCESS)) {
+        // The firmware wants GET_INFO through an IOBUF; only ele-sim takes it inline
+        if (probe->present & ELE_PROBE_HAVE_SIMULATOR) {
+            ele_probe_get_info(probe);
+        }
+        probe->present |= ELE_PROBE_INFO_SETTLED;
+    }
+}
+
+/*
+ * A snapshot with a usable device node holds for the whole boot, whether
+ * or not GET_INFO answered, as long as the query was settled (or is not
+ * wanted). One without is only trusted briefly: the driver may still be
+ * probing.
+ */
+static int ele_probe_reusable(const struct ele_probe *probe, unsigned int flags) {
+    int64_t age = (int64_t)time(NULL) - probe->taken;
+
+    if (!(probe->present & ELE_PROBE_HAVE_DEVICE_ACCESS)) {
+        return age >= 0 && age < ELE_PROBE_ABSENT_MAX_AGE;
+    }
+    return (flags & ELE_PROBE_NO_MAILBOX) || (probe->present & ELE_PROBE_INFO_SETTLED);
+}
+
+int ele_probe_get(struct ele_probe *probe, unsigned int flags) {
+    struct ele_probe config;
+
+    if (probe == NULL) {
+        return -1;
+    }
+
+    ele_probe_config(&config);
+    if (!(flags & ELE_PROBE_REFRESH) && ele_probe_load(probe, &config) == 0 &&
+        ele_probe_reusable(probe, flags)) {
+        return 0;
+    }
+
+    *probe = config;
+    ele_probe_collect(probe, flags);
+
+    // A snapshot taken with ELE_PROBE_NO_MAILBOX is still cached; a later
+    // caller that wants the enclave's answer probes again.
+    ele_probe_store(probe);
+    return 0;
+}
+
+const char *ele_probe_lifecycle_name(uint32_t lifecycle) {
+    for (size_t i = 0; i < sizeof(ele_probe_lifecycles) / sizeof(ele_probe_lifecycles[0]); i++) {
+        if (ele_probe_lifecycles[i].value == lifecycle) {
+            return ele_probe_lifecycles[i].name;
+        }
+    }
+    return "unknown";
+}
+
+/* JSON */
+
+static void ele_probe_json_string(FILE *out, const char *s) {
+    fputc('"', out);
+    for (; *s != '\0'; s++) {
+        unsigned char c = (unsigned char)*s;
+
+        if (c == '"' || c == '\\') {
+            fprintf(out, "\\%c", c);
+        } else if (c < 0x20) {
+            fprintf(out, "\\u%04x", c);
+        } else {
+            fputc(c, out);
+        }
+    }
+    fputc('"', out);
+}
+
+static void ele_probe_json_bool(FILE *out, const char *key, int value, int last) {
+    fprintf(out, "\"%s\": %s%s", key, value ? "true" : "false", last ? "" : ", ");
+}
+
+void ele_probe_write_json(const struct ele_probe *p, FILE *out) {
+    uint32_t count = p->firmware_count < ELE_PROBE_MAX_FIRMWARE ? p->firmware_count
+                                                                : ELE_PROBE_MAX_FIRMWARE;
+
+    fprintf(out, "{\n  \"boot_id\": ");
+    ele_probe_json_string(out, p->boot_id);
+    fprintf(out, ",\n  \"taken\": %lld,\n", (long long)p->taken);
+
+    fprintf(out, "  \"device\": {\"path\": ");
+    ele_probe_json_string(out, p->device_path);
+    fprintf(out, ", ");
+    ele_probe_json_bool(out, "present", p->present & ELE_PROBE_HAVE_DEVICE, 0);
+    ele_probe_json_bool(out, "accessible", p->present & ELE_PROBE_HAVE_DEVICE_ACCESS, 0);
+    ele_probe_json_bool(out, "simulator", p->present & ELE_PROBE_HAVE_SIMULATOR, 1);
+    fprintf(out, "},\n");
+
+    fprintf(out, "  \"sysfs\": {\"path\": ");
+    ele_probe_json_string(out, p->sysfs_path);
+    fprintf(out, ", ");
+    ele_probe_json_bool(out, "present", p->present & ELE_PROBE_HAVE_SYSFS, 1);
+    fprintf(out, "},\n");
+
+    fprintf(out, "  \"mailbox\": {\"path\": ");
+    ele_probe_json_string(out, p->mailbox_path);
+    fprintf(out, ", ");
+    ele_probe_json_bool(out, "present", p->present & ELE_PROBE_HAVE_MAILBOX, 0);
+    fprintf(out, "\"driver\": ");
+    if (p->present & ELE_PROBE_HAVE_MAILBOX_DRIVER) {
+        ele_probe_json_string(out, p->mailbox_driver);
+    } else {
+        fprintf(out, "null");
+    }
+    fprintf(out, "},\n");
+
+    fprintf(out, "  \"ocotp\": {\"path\": ");
+    ele_probe_json_string(out, p->ocotp_path);
+    fprintf(out, ", ");
+    ele_probe_json_bool(out, "present", p->present & ELE_PROBE_HAVE_OCOTP, 0);
+    ele_probe_json_bool(out, "readable", p->present & ELE_PROBE_HAVE_OCOTP_READABLE, 0);
+    fprintf(out, "\"size\": %llu},\n", (unsigned long long)p->ocotp_size);
+
+    fprintf(out, "  ");
+    ele_probe_json_bool(out, "device_tree", p->present & ELE_PROBE_HAVE_DT_SYMBOL, 1);
+    fprintf(out, ",\n");
+
+    if (p->present & ELE_PROBE_HAVE_INFO) {
+        fprintf(out, "  \"info\": {\"fw_version\": \"0x%08x\", \"soc_id\": \"0x%04x\", "
+                "\"soc_rev\": \"0x%02x\", \"lifecycle\": \"0x%04x\", \"lifecycle_name\": ",
+                p->fw_version, p->soc_id, p->soc_rev, p->lifecycle);
+        ele_probe_json_string(out, ele_probe_lifecycle_name(p->lifecycle));
+        fprintf(out, ", \"uid\": \"%016llx\"},\n", (unsigned long long)p->uid);
+    } else {
+        fprintf(out, "  \"info\": null,\n");
+    }
+
+    fprintf(out, "  \"firmware\": {\"path\": ");
+    ele_probe_json_string(out, p->firmware_path);
+    fprintf(out, ", ");
+    ele_probe_json_bool(out, "present", p->present & ELE_PROBE_HAVE_FIRMWARE_DIR, 0);
+    fprintf(out, "\"count\": %u, \"files\": [", p->firmware_count);
+    for (uint32_t i = 0; i < count; i++) {
+        fprintf(out, "%s{\"name\": ", i ? ", " : "");
+        ele_probe_json_string(out, p->firmware[i].name);
+        fprintf(out, ", \"size\": %llu, \"mtime\": %lld}",
+                (unsigned long long)p->firmware[i].size, (long long)p->firmware[i].mtime);
+    }
+    fprintf(out, "]},\n");
+
+    fprintf(out, "  \"reserved_memory\": ");
+    if (p->present & ELE_PROBE_HAVE_RESERVED_MEM) {
+        fprintf(out, "{\"start\": \"0x%08llx\", \"end\": \"0x%08llx\", \"name\": ",
+                (unsigned long long)p->reserved_start, (unsigned long long)p->reserved_end);
+        ele_probe_json_string(out, p->reserved_name);
+        fprintf(out, "}\n");
+    } else {
+        fprintf(out, "null\n");
+    }
+    fprintf(out, "}\n");
+}
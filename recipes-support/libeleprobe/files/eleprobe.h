@@ -0,0 +1,123 @@
+/*
+ * libeleprobe - one-pass EdgeLock Enclave / platform probe
+ *
+ * Collects the ELE state the test and development tools report (device
+ * node, sysfs, mailbox driver, OCOTP, device tree, firmware files,
+ * reserved memory, and the enclave's own GET_INFO answer) in a single
+ * pass, and caches the snapshot in /run so that later tools answer
+ * without touching sysfs or the enclave again.
+ *
+ * The cache is keyed by the kernel boot id, the effective uid (device
+ * access, OCOTP readability and the /proc/iomem addresses depend on it)
+ * and the probed paths, which follow the same environment overrides as
+ * the tools (ELE_DEVICE_PATH, ELE_SYSFS_PATH, ELE_FIRMWARE_PATH,
+ * ELE_MAILBOX_PATH, ELE_OCOTP_PATH). The file is readable by its owner
+ * only; ELE_PROBE_CACHE moves it, e.g. somewhere an unprivileged tool can
+ * write. A snapshot that found no usable device node is only reused for a
+ * few seconds, so a driver that binds late is still seen.
+ *
+ * GET_INFO is only sent to the ele-sim socket. The firmware takes it
+ * through an IOBUF the inline request does not provide, so on hardware
+ * the INFO fields stay empty.
+ *
+ * Copyright (C) 2024 Dynamic Devices Ltd.
+ * Licensed under BSD-3-Clause
+ */
+
+#ifndef ELEPROBE_H
+#define ELEPROBE_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+#define ELE_PROBE_CACHE_PATH        "/run/eleprobe/snapshot"
+
+#define ELE_PROBE_DEVICE_PATH       "/dev/ele_mu"
+#define ELE_PROBE_SYSFS_PATH        "/sys/class/misc/ele_mu"
+#define ELE_PROBE_FIRMWARE_PATH     "/lib/firmware/imx/ele"
+#define ELE_PROBE_MAILBOX_PATH      "/sys/bus/platform/devices/44230000.mailbox"
+#define ELE_PROBE_OCOTP_PATH        "/sys/bus/nvmem/devices/ELE-OCOTP0"
+#define ELE_PROBE_DT_SYMBOL         "/proc/device-tree/__symbols__/s4muap"
+
+#define ELE_RESERVED_MEM_START      0x90000000UL
+#define ELE_RESERVED_MEM_SIZE       0x100000UL
+
+#define ELE_PROBE_MAX_FIRMWARE      8
+#define ELE_PROBE_PATH_MAX          128
+
+// ele_probe_get() flags
+#define ELE_PROBE_REFRESH           0x1     // ignore the cache and probe again
+#define ELE_PROBE_NO_MAILBOX        0x2     // do not send GET_INFO to the enclave
+
+// Facts found, in struct ele_probe.present
+#define ELE_PROBE_HAVE_DEVICE           0x0001  // device node exists
+#define ELE_PROBE_HAVE_DEVICE_ACCESS    0x0002  // device node is read/writable
+#define ELE_PROBE_HAVE_SIMULATOR        0x0004  // device is an ele-sim socket
+#define ELE_PROBE_HAVE_SYSFS            0x0008
+#define ELE_PROBE_HAVE_MAILBOX          0x0010  // mailbox platform device
+#define ELE_PROBE_HAVE_MAILBOX_DRIVER   0x0020  // ... with a bound driver
+#define ELE_PROBE_HAVE_OCOTP            0x0040
+#define ELE_PROBE_HAVE_OCOTP_READABLE   0x0080
+#define ELE_PROBE_HAVE_DT_SYMBOL        0x0100
+#define ELE_PROBE_HAVE_FIRMWARE_DIR     0x0200
+#define ELE_PROBE_HAVE_RESERVED_MEM     0x0400  // ELE region listed in /proc/iomem
+#define ELE_PROBE_HAVE_INFO             0x0800  // enclave answered GET_INFO
+#define ELE_PROBE_INFO_SETTLED          0x1000  // GET_INFO answered, refused or not applicable
+
+struct ele_probe_firmware {
+    char name[64];
+    uint64_t size;
+    int64_t mtime;
+};
+
+// Snapshot; plain data so it can be cached as is
+struct ele_probe {
+    uint32_t magic;
+    uint32_t size;
+    char boot_id[40];
+    int64_t taken;                  // CLOCK_REALTIME seconds
+
+    char device_path[ELE_PROBE_PATH_MAX];
+    char sysfs_path[ELE_PROBE_PATH_MAX];
+    char firmware_path[ELE_PROBE_PATH_MAX];
+    char mailbox_path[ELE_PROBE_PATH_MAX];
+    char ocotp_path[ELE_PROBE_PATH_MAX];
+    uint32_t euid;                  // caller the snapshot was taken for
+
+    uint32_t present;
+    uint32_t device_mode;
+    char mailbox_driver[32];
+    uint64_t ocotp_size;
+
+    // GET_INFO
+    uint32_t fw_version;
+    uint16_t soc_id;
+    uint16_t soc_rev;
+    uint32_t lifecycle;
+    uint64_t uid;
+
+    uint32_t firmware_count;        // may exceed ELE_PROBE_MAX_FIRMWARE
+    struct ele_probe_firmware firmware[ELE_PROBE_MAX_FIRMWARE];
+
+    uint64_t reserved_start;
+    uint64_t reserved_end;
+    char reserved_name[48];
+};
+
+/*
+ * Fill *probe from the cache, or probe the platform and refresh the cache
+ * (best effort: unprivileged callers may not be able to write it). Returns
+ * 0, or -1 if the probe itself failed.
+ */
+int ele_probe_get(struct ele_probe *probe, unsigned int flags);
+
+// Remove the cached snapshot
+int ele_probe_invalidate(void);
+
+// Name of an ELE lifecycle value, e.g. "OEM open"
+const char *ele_probe_lifecycle_name(uint32_t lifecycle);
+
+// Write the snapshot as a JSON object
+void ele_probe_write_json(const struct ele_probe *probe, FILE *out);
+
+#endif /* ELEPROBE_H */
@@ -0,0 +1,181 @@
+/*
+ * Transport backends for the ELE mailbox queue
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <pthread.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include "ele-backend.h"
+#ifdef ELE_WITH_SIM
+#include "ele-sim.h"
+#endif
+
+// Device backend: one file descriptor per context
+
+static int ele_device_open(const ele_backend_t *be) {
+    int fd;
+
+    // An ele-sim daemon listens on a socket in place of the device node
+    if (be->sim_protocol) {
+        struct sockaddr_un addr;
+
+        if (strlen(be->target) >= sizeof(addr.sun_path)) {
+            return -ENAMETOOLONG;
+        }
+        fd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+        if (fd < 0) {
+            return -errno;
+        }
+        memset(&addr, 0, sizeof(addr));
+        addr.sun_family = AF_UNIX;
+        strcpy(addr.sun_path, be->target);
+        if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0) {
+            int err = errno;
+            close(fd);
+            return -err;
+        }
+        return fd;
+    }
+
+    fd = open(be->target, O_RDWR | O_CLOEXEC);
+    return fd < 0 ? -errno : fd;
+}
+
+static void ele_device_close(const ele_backend_t *be, int ctx) {
+    (void)be;
+    close(ctx);
+}
+
+static ssize_t ele_device_exchange(const ele_backend_t *be, int ctx,
+                                   const void *cmd, size_t cmd_len,
+                                   void *rsp, size_t rsp_size) {
+    const uint8_t *out = cmd;
+    ssize_t n;
+
+    (void)be;
+
+    while (cmd_len > 0) {
+        n = write(ctx, out, cmd_len);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -errno;
+        }
+        out += n;
+        cmd_len -= (size_t)n;
+    }
+
+    do {
+        n = read(ctx, rsp, rsp_size);
+    } while (n < 0 && errno == EINTR);
+
+    if (n == 0) {
+        return -ECONNRESET;    // simulator went away
+    }
+    return n < 0 ? -errno : n;
+}
+
+#ifdef ELE_WITH_SIM
+
+// Only an ele-sim daemon socket speaks the simulator's protocol
+static int ele_device_is_sim(const char *path) {
+    struct stat st;
+
+    return stat(path, &st) == 0 && S_ISSOCK(st.st_mode);
+}
+
+// Simulator backend: contexts are just counted, the model is shared
+
+static pthread_mutex_t ele_sim_ref_lock = PTHREAD_MUTEX_INITIALIZER;
+static unsigned int ele_sim_refs;
+
+static int ele_sim_open(const ele_backend_t *be) {
+    int rv = 0;
+
+    pthread_mutex_lock(&ele_sim_ref_lock);
+    if (ele_sim_refs == 0 && ele_sim_init(be->target) != 0) {
+        rv = -EINVAL;
+    } else {
+        rv = (int)ele_sim_refs++;
+    }
+    pthread_mutex_unlock(&ele_sim_ref_lock);
+
+    return rv;
+}
+
+static void ele_sim_close(const ele_backend_t *be, int ctx) {
+    (void)be;
+    (void)ctx;
+
+    pthread_mutex_lock(&ele_sim_ref_lock);
+    if (ele_sim_refs > 0 && --ele_sim_refs == 0) {
+        ele_sim_shutdown();
+    }
+    pthread_mutex_unlock(&ele_sim_ref_lock);
+}
+
+static ssize_t ele_sim_exchange(const ele_backend_t *be, int ctx,
+                                const void *cmd, size_t cmd_len,
+                                void *rsp, size_t rsp_size) {
+    size_t words;
+
+    (void)be;
+    (void)ctx;
+
+    if (cmd_len % sizeof(uint32_t) != 0) {
+        return -EINVAL;
+    }
+
+    words = ele_sim_process(cmd, cmd_len / sizeof(uint32_t), rsp, rsp_size / sizeof(uint32_t));
+    return words == 0 ? -EINVAL : (ssize_t)(words * sizeof(uint32_t));
+}
+
+#endif /* ELE_WITH_SIM */
+
+int ele_backend_select(ele_backend_t *be, const char *default_device) {
+    const char *backend = getenv("ELE_PKCS11_BACKEND");
+    const char *device = getenv("ELE_DEVICE_PATH");
+
+    memset(be, 0, sizeof(*be));
+
+    if (backend == NULL || *backend == '\0' || strcmp(backend, "device") == 0) {
+        be->name = "device";
+        be->open = ele_device_open;
+        be->close = ele_device_close;
+        be->exchange = ele_device_exchange;
+        snprintf(be->target, sizeof(be->target), "%s",
+                 (device != NULL && *device != '\0') ? device : default_device);
+#ifdef ELE_WITH_SIM
+        be->sim_protocol = ele_device_is_sim(be->target);
+#endif
+        return 0;
+    }
+
+    if (strncmp(backend, "sim", 3) == 0 && (backend[3] == '\0' || backend[3] == ':')) {
+#ifndef ELE_WITH_SIM
+        fprintf(stderr, "ELE PKCS#11: Simulator backend not built in (ELE_WITH_SIM)\n");
+        return -1;
+#else
+        be->name = "sim";
+        be->open = ele_sim_open;
+        be->close = ele_sim_close;
+        be->exchange = ele_sim_exchange;
+        be->sim_protocol = 1;
+        snprintf(be->target, sizeof(be->target), "%s", backend[3] == ':' ? backend + 4 : "");
+        return 0;
+#endif
+    }
+
+    fprintf(stderr, "ELE PKCS#11: Unknown backend '%s'\n", backend);
+    return -1;
+}
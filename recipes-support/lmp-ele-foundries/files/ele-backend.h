@@ -0,0 +1,53 @@
+/*
+ * Transport backends for the ELE mailbox queue
+ *
+ * A backend opens device contexts and performs one command/response
+ * exchange on a context. Two are provided:
+ *
+ *   device  the ele_mu character device, or an ele-sim daemon when the
+ *           path names a Unix socket (SOCK_SEQPACKET keeps the device's
+ *           one-message-per-read framing)
+ *   sim     the ELE simulator (ele-sim.c) running inside this process
+ *
+ * The simulator, and the device backend's ele-sim socket support, are
+ * only compiled in with -DELE_WITH_SIM (PACKAGECONFIG "sim"), so a
+ * production module cannot be switched to keys held in host memory.
+ *
+ * The backend is chosen with ELE_PKCS11_BACKEND ("device" or
+ * "sim[:config]"); ELE_DEVICE_PATH overrides the device path.
+ *
+ * The request layouts built on top of this (ele-mailbox.h) are the
+ * simulator's own and are not NXP's firmware protocol, so only a
+ * backend with sim_protocol set is ever sent HSM requests.
+ */
+
+#ifndef ELE_BACKEND_H
+#define ELE_BACKEND_H
+
+#include <stddef.h>
+#include <sys/types.h>
+
+#define ELE_BACKEND_TARGET_MAX  256
+
+typedef struct ele_backend {
+    const char *name;
+    char target[ELE_BACKEND_TARGET_MAX];    // device path or simulator config
+    int sim_protocol;                       // the other end is ele-sim, not ELE firmware
+
+    // Returns a context handle >= 0, or -errno
+    int (*open)(const struct ele_backend *be);
+    void (*close)(const struct ele_backend *be, int ctx);
+
+    // Send cmd and receive one response; returns response bytes or -errno
+    ssize_t (*exchange)(const struct ele_backend *be, int ctx,
+                        const void *cmd, size_t cmd_len,
+                        void *rsp, size_t rsp_size);
+} ele_backend_t;
+
+/*
+ * Fill in the backend selected by the environment, defaulting to the
+ * device at default_device. Returns 0, or -1 for an unknown backend.
+ */
+int ele_backend_select(ele_backend_t *be, const char *default_device);
+
+#endif /* ELE_BACKEND_H */
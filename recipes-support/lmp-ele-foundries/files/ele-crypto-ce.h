@@ -0,0 +1,21 @@
+/*
+ * ARMv8 Cryptography Extensions backend for ele-crypto.c
+ *
+ * SHA-256 using the SHA256H instruction family. Built only for AArch64
+ * (the functions report "unavailable" elsewhere) and only used when the
+ * kernel advertises the SHA2 hwcap.
+ */
+
+#ifndef ELE_CRYPTO_CE_H
+#define ELE_CRYPTO_CE_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Non-zero if the CPU and this build support the instructions
+int ele_ce_available(void);
+
+// SHA-256 of a whole message; returns 0, or -1 if unavailable
+int ele_ce_sha256(const uint8_t *data, size_t len, uint8_t digest[32]);
+
+#endif /* ELE_CRYPTO_CE_H */
@@ -0,0 +1,166 @@
+/*
+ * ele-crypto - calibrate the ELE crypto backend profile (see ele-crypto.h)
+ *
+ * Times AES-GCM, SHA-2 and ECDSA verification on the enclave, the ARMv8
+ * crypto instructions and OpenSSL at each message size class, and saves
+ * the fastest backend per algorithm and size as this board's profile:
+ *
+ *   ele-crypto calibrate             # measure and save the profile
+ *   ele-crypto -b 5000 -n calibrate  # longer run, print only
+ *   ele-crypto show                  # the profile in use
+ *
+ * Copyright (C) 2024 Dynamic Devices Ltd.
+ * Licensed under BSD-3-Clause
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <getopt.h>
+
+#include "ele-backend.h"
+#include "ele-crypto.h"
+#include "ele-mailbox.h"
+
+#define DEFAULT_DEVICE_PATH "/dev/ele_mu"
+#define DEFAULT_BUDGET_MS   3000
+
+static void print_usage(const char *prog) {
+    printf("Usage: %s [options] [calibrate|show]\n", prog);
+    printf("\n");
+    printf("Commands:\n");
+    printf("  calibrate           Time every backend and save the fastest choices\n");
+    printf("  show                Show the profile in use (default)\n");
+    printf("\n");
+    printf("Options:\n");
+    printf("  -b, --budget MS     Total measurement time (default %d)\n", DEFAULT_BUDGET_MS);
+    printf("  -o, --output FILE   Profile to write (default ELE_CRYPTO_PROFILE, else\n");
+    printf("                      %s)\n", ELE_CRYPTO_PROFILE_PATH);
+    printf("  -n, --dry-run       Print the results without saving them\n");
+    printf("  -h, --help          Show this help\n");
+}
+
+static void print_timing(const ele_crypto_timing_t *t) {
+    printf("%-11s %9s", "algorithm", "bytes");
+    for (unsigned int be = 0; be < ELE_CRYPTO_BACKEND_COUNT; be++) {
+        printf(" %11s", ele_crypto_backend_name(be));
+    }
+    printf("   (us per operation, * = chosen)\n");
+
+    for (unsigned int a = 0; a < ELE_CRYPTO_ALG_COUNT; a++) {
+        // Verification is measured once, on the digest
+        unsigned int classes = a == ELE_CRYPTO_ECDSA_P256 || a == ELE_CRYPTO_ECDSA_P384
+                                   ? 1 : ELE_CRYPTO_SIZE_CLASSES;
+
+        for (unsigned int c = 0; c < classes; c++) {
+            size_t len = ele_crypto_size_class[c];
+            ele_crypto_backend_t chosen = ele_crypto_select(a, classes == 1 ? 32 : len);
+
+            printf("%-11s %9zu", ele_crypto_alg_name(a), classes == 1 ? (size_t)32 : len);
+            for (unsigned int be = 0; be < ELE_CRYPTO_BACKEND_COUNT; be++) {
+                uint64_t ns = t->ns[a][c][be];
+
+                if (ns == 0) {
+                    printf(" %11s", "-");
+                } else {
+                    printf(" %10.1f%c", (double)ns / 1000.0, be == chosen ? '*' : ' ');
+                }
+            }
+            printf("\n");
+        }
+    }
+}
+
+static int calibrate(unsigned int budget_ms, const char *output, int dry_run) {
+    static ele_crypto_timing_t timing;
+    ele_backend_t backend;
+    int mailbox;
+    int failures;
+
+    // Without the enclave the CPU backends are still worth calibrating
+    mailbox = ele_backend_select(&backend, DEFAULT_DEVICE_PATH) == 0 &&
+              ele_mbox_init(&backend, 1) == 0;
+    if (!mailbox) {
+        fprintf(stderr, "ele-crypto: cannot open the ELE (%s), calibrating CPU backends only\n",
+                backend.target);
+    }
+
+    failures = ele_crypto_calibrate(budget_ms, stderr, &timing);
+    if (mailbox) {
+        ele_mbox_shutdown();
+    }
+    if (failures < 0) {
+        fprintf(stderr, "ele-crypto: calibration could not start\n");
+        return 1;
+    }
+
+    print_timing(&timing);
+    printf("\n");
+    ele_crypto_print_profile(stdout);
+
+    if (!dry_run) {
+        if (ele_crypto_save_profile(output) != 0) {
+            fprintf(stderr, "ele-crypto: cannot write the profile\n");
+            return 1;
+        }
+        printf("\nProfile saved to %s\n",
+               output != NULL ? output
+                              : (getenv("ELE_CRYPTO_PROFILE") && *getenv("ELE_CRYPTO_PROFILE")
+                                     ? getenv("ELE_CRYPTO_PROFILE") : ELE_CRYPTO_PROFILE_PATH));
+    }
+
+    // A backend that disagreed with OpenSSL is a finding, not just a slow path
+    return failures > 0 ? 2 : 0;
+}
+
+int main(int argc, char *argv[]) {
+    static const struct option long_opts[] = {
+        { "budget", required_argument, NULL, 'b' },
+        { "output", required_argument, NULL, 'o' },
+        { "dry-run", no_argument, NULL, 'n' },
+        { "help", no_argument, NULL, 'h' },
+        { NULL, 0, NULL, 0 }
+    };
+    unsigned int budget_ms = DEFAULT_BUDGET_MS;
+    const char *output = NULL;
+    const char *command = "show";
+    int dry_run = 0;
+    int opt;
+
+    while ((opt = getopt_long(argc, argv, "b:o:nh", long_opts, NULL)) != -1) {
+        switch (opt) {
+        case 'b':
+            budget_ms = (unsigned int)strtoul(optarg, NULL, 0);
+            break;
+        case 'o':
+            output = optarg;
+            break;
+        case 'n':
+            dry_run = 1;
+            break;
+        case 'h':
+            print_usage(argv[0]);
+            return 0;
+        default:
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+    if (optind < argc) {
+        command = argv[optind];
+    }
+
+    if (strcmp(command, "calibrate") == 0) {
+        return calibrate(budget_ms, output, dry_run);
+    }
+    if (strcmp(command, "show") == 0) {
+        if (ele_crypto_init() != 0) {
+            printf("No saved profile, every operation uses OpenSSL\n");
+        }
+        ele_crypto_print_profile(stdout);
+        return 0;
+    }
+
+    print_usage(argv[0]);
+    return 1;
+}
@@ -0,0 +1,747 @@
+/*
+ * Crypto service dispatch for the ELE PKCS#11 module and tools
+ *
+ * The active choice is a small table of backend per algorithm and size
+ * class. It starts out all OpenSSL, is replaced by the saved profile on
+ * ele_crypto_init(), and by fresh measurements on ele_crypto_calibrate().
+ * A choice that cannot serve a particular request (mailbox not running,
+ * message too long to go inline, no CPU support) falls back to OpenSSL,
+ * so a profile copied from another board is never worse than none.
+ *
+ * Profile file, one choice per line:
+ *
+ *   # algorithm  size-class  backend
+ *   sha256 64 armv8-ce
+ *   sha256 244 ele
+ *
+ * Calibration first checks each backend against OpenSSL on every size
+ * class it claims, and only backends that agree are timed. Each timing is
+ * the median of single-operation samples, which keeps a stray preemption
+ * or a busy mailbox from deciding the table.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <time.h>
+
+#include <openssl/evp.h>
+#include <openssl/ec.h>
+#include <openssl/core_names.h>
+#include <openssl/param_build.h>
+#include <openssl/rand.h>
+
+#include "ele-crypto.h"
+#include "ele-crypto-ce.h"
+#include "ele-mailbox.h"
+
+// Samples per calibration cell: at least the minimum, at most the maximum
+#define ELE_CRYPTO_MIN_SAMPLES  5
+#define ELE_CRYPTO_MAX_SAMPLES  255
+
+const size_t ele_crypto_size_class[ELE_CRYPTO_SIZE_CLASSES] = {
+    16, 64, 128, ELE_HASH_MAX_INLINE, 1024, 4096, 16384, 65536
+};
+
+static const char *const ele_crypto_alg_names[ELE_CRYPTO_ALG_COUNT] = {
+    [ELE_CRYPTO_AES_GCM] = "aes-gcm",
+    [ELE_CRYPTO_SHA256] = "sha256",
+    [ELE_CRYPTO_SHA384] = "sha384",
+    [ELE_CRYPTO_SHA512] = "sha512",
+    [ELE_CRYPTO_ECDSA_P256] = "ecdsa-p256",
+    [ELE_CRYPTO_ECDSA_P384] = "ecdsa-p384",
+};
+
+static const char *const ele_crypto_backend_names[ELE_CRYPTO_BACKEND_COUNT] = {
+    [ELE_CRYPTO_BACKEND_ELE] = "ele",
+    [ELE_CRYPTO_BACKEND_CE] = "armv8-ce",
+    [ELE_CRYPTO_BACKEND_OPENSSL] = "openssl",
+};
+
+static uint8_t ele_crypto_choice[ELE_CRYPTO_ALG_COUNT][ELE_CRYPTO_SIZE_CLASSES];
+static pthread_once_t ele_crypto_once = PTHREAD_ONCE_INIT;
+static int ele_crypto_loaded = -1;
+
+const char *ele_crypto_alg_name(ele_crypto_alg_t alg) {
+    return (unsigned int)alg < ELE_CRYPTO_ALG_COUNT ? ele_crypto_alg_names[alg] : "unknown";
+}
+
+const char *ele_crypto_backend_name(ele_crypto_backend_t backend) {
+    return (unsigned int)backend < ELE_CRYPTO_BACKEND_COUNT ? ele_crypto_backend_names[backend]
+                                                            : "unknown";
+}
+
+static int ele_crypto_is_ecdsa(ele_crypto_alg_t alg) {
+    return alg == ELE_CRYPTO_ECDSA_P256 || alg == ELE_CRYPTO_ECDSA_P384;
+}
+
+static size_t ele_crypto_coord_len(ele_crypto_alg_t alg) {
+    return alg == ELE_CRYPTO_ECDSA_P256 ? 32 : 48;
+}
+
+static unsigned int ele_crypto_class_of(size_t len) {
+    for (unsigned int c = 0; c < ELE_CRYPTO_SIZE_CLASSES; c++) {
+        if (len <= ele_crypto_size_class[c]) {
+            return c;
+        }
+    }
+    return ELE_CRYPTO_SIZE_CLASSES - 1;
+}
+
+static const char *ele_crypto_profile_path(void) {
+    const char *path = getenv("ELE_CRYPTO_PROFILE");
+
+    return path != NULL && *path != '\0' ? path : ELE_CRYPTO_PROFILE_PATH;
+}
+
+// Profile loading
+
+static int ele_crypto_lookup(const char *name, const char *const *names, unsigned int count) {
+    for (unsigned int i = 0; i < count; i++) {
+        if (strcmp(name, names[i]) == 0) {
+            return (int)i;
+        }
+    }
+    return -1;
+}
+
+static int ele_crypto_load_profile(const char *path) {
+    uint8_t choice[ELE_CRYPTO_ALG_COUNT][ELE_CRYPTO_SIZE_CLASSES];
+    char line[128];
+    FILE *f;
+    int ok = 1;
+
+    memset(choice, ELE_CRYPTO_BACKEND_OPENSSL, sizeof(choice));
+
+    f = fopen(path, "r");
+    if (f == NULL) {
+        return -1;
+    }
+
+    while (ok && fgets(line, sizeof(line), f) != NULL) {
+        char alg_name[32];
+        char backend_name[32];
+        unsigned long size;
+        int alg, backend;
+
+        if (line[0] == '#' || line[0] == '\n') {
+            continue;
+        }
+        if (sscanf(line, "%31s %lu %31s", alg_name, &size, backend_name) != 3) {
+            ok = 0;
+            break;
+        }
+
+        alg = ele_crypto_lookup(alg_name, ele_crypto_alg_names, ELE_CRYPTO_ALG_COUNT);
+        backend = ele_crypto_lookup(backend_name, ele_crypto_backend_names,
+                                    ELE_CRYPTO_BACKEND_COUNT);
+        if (alg < 0 || backend < 0) {
+            ok = 0;
+            break;
+        }
+        choice[alg][ele_crypto_class_of(size)] = (uint8_t)backend;
+    }
+    fclose(f);
+
+    if (!ok) {
+        return -1;
+    }
+    memcpy(ele_crypto_choice, choice, sizeof(choice));
+    return 0;
+}
+
+static void ele_crypto_load_once(void) {
+    memset(ele_crypto_choice, ELE_CRYPTO_BACKEND_OPENSSL, sizeof(ele_crypto_choice));
+    ele_crypto_loaded = ele_crypto_load_profile(ele_crypto_profile_path());
+}
+
+int ele_crypto_init(void) {
+    pthread_once(&ele_crypto_once, ele_crypto_load_once);
+    return ele_crypto_loaded;
+}
+
+int ele_crypto_save_profile(const char *path) {
+    char tmp_path[512];
+    FILE *f;
+    int ok;
+
+    if (path == NULL) {
+        path = ele_crypto_profile_path();
+    }
+    snprintf(tmp_path, sizeof(tmp_path), "%s.tmp.%d", path, (int)getpid());
+
+    f = fopen(tmp_path, "w");
+    if (f == NULL) {
+        return -1;
+    }
+
+    fprintf(f, "# ELE crypto backend profile, written by ele-crypto calibrate\n");
+    fprintf(f, "# algorithm  size-class  backend\n");
+    for (unsigned int a = 0; a < ELE_CRYPTO_ALG_COUNT; a++) {
+        for (unsigned int c = 0; c < ELE_CRYPTO_SIZE_CLASSES; c++) {
+            fprintf(f, "%s %zu %s\n", ele_crypto_alg_names[a], ele_crypto_size_class[c],
+                    ele_crypto_backend_names[ele_crypto_choice[a][c]]);
+        }
+    }
+
+    ok = !ferror(f);
+    if (fclose(f) != 0 || !ok || rename(tmp_path, path) != 0) {
+        unlink(tmp_path);
+        return -1;
+    }
+    return 0;
+}
+
+void ele_crypto_print_profile(FILE *out) {
+    fprintf(out, "%-11s", "algorithm");
+    for (unsigned int c = 0; c < ELE_CRYPTO_SIZE_CLASSES; c++) {
+        fprintf(out, " %9zu", ele_crypto_size_class[c]);
+    }
+    fprintf(out, "\n");
+
+    for (unsigned int a = 0; a < ELE_CRYPTO_ALG_COUNT; a++) {
+        fprintf(out, "%-11s", ele_crypto_alg_names[a]);
+        for (unsigned int c = 0; c < ELE_CRYPTO_SIZE_CLASSES; c++) {
+            fprintf(out, " %9s", ele_crypto_backend_names[ele_crypto_choice[a][c]]);
+        }
+        fprintf(out, "\n");
+    }
+}
+
+// Backend capabilities
+
+int ele_crypto_backend_supports(ele_crypto_backend_t backend, ele_crypto_alg_t alg, size_t len) {
+    switch (backend) {
+    case ELE_CRYPTO_BACKEND_ELE:
+        if (ele_mbox_depth() == 0) {
+            return 0;
+        }
+        // The enclave's AEAD service only works on keys it holds itself
+        if (alg == ELE_CRYPTO_AES_GCM) {
+            return 0;
+        }
+        if (ele_crypto_is_ecdsa(alg)) {
+            // Header, four parameter words, key, signature and digest inline
+            size_t coord = ele_crypto_coord_len(alg);
+            return 5 + 2 * (2 * coord / 4) + (len + 3) / 4 <= ELE_MSG_MAX_WORDS;
+        }
+        return len <= ELE_HASH_MAX_INLINE;
+    case ELE_CRYPTO_BACKEND_CE:
+        return alg == ELE_CRYPTO_SHA256 && ele_ce_available();
+    case ELE_CRYPTO_BACKEND_OPENSSL:
+        return (unsigned int)alg < ELE_CRYPTO_ALG_COUNT;
+    default:
+        return 0;
+    }
+}
+
+ele_crypto_backend_t ele_crypto_select(ele_crypto_alg_t alg, size_t len) {
+    ele_crypto_backend_t backend;
+
+    ele_crypto_init();
+    backend = (ele_crypto_backend_t)ele_crypto_choice[alg][ele_crypto_class_of(len)];
+    return ele_crypto_backend_supports(backend, alg, len) ? backend : ELE_CRYPTO_BACKEND_OPENSSL;
+}
+
+// Digests
+
+static const EVP_MD *ele_crypto_md(ele_crypto_alg_t alg) {
+    switch (alg) {
+    case ELE_CRYPTO_SHA256: return EVP_sha256();
+    case ELE_CRYPTO_SHA384: return EVP_sha384();
+    case ELE_CRYPTO_SHA512: return EVP_sha512();
+    default: return NULL;
+    }
+}
+
+static uint32_t ele_crypto_hash_algo(ele_crypto_alg_t alg) {
+    switch (alg) {
+    case ELE_CRYPTO_SHA384: return ELE_HASH_ALGO_SHA384;
+    case ELE_CRYPTO_SHA512: return ELE_HASH_ALGO_SHA512;
+    default: return ELE_HASH_ALGO_SHA256;
+    }
+}
+
+int ele_crypto_digest_on(ele_crypto_backend_t backend, ele_crypto_alg_t alg,
+                         const uint8_t *data, size_t len,
+                         uint8_t *digest, size_t *digest_len) {
+    const EVP_MD *md = ele_crypto_md(alg);
+    unsigned int out_len = 0;
+
+    if (md == NULL || *digest_len < (size_t)EVP_MD_get_size(md) ||
+        !ele_crypto_backend_supports(backend, alg, len)) {
+        return -1;
+    }
+
+    switch (backend) {
+    case ELE_CRYPTO_BACKEND_ELE:
+        return ele_hsm_hash(ele_crypto_hash_algo(alg), data, len, digest, digest_len);
+    case ELE_CRYPTO_BACKEND_CE:
+        if (ele_ce_sha256(data, len, digest) != 0) {
+            return -1;
+        }
+        *digest_len = 32;
+        return 0;
+    default:
+        if (EVP_Digest(data, len, digest, &out_len, md, NULL) != 1) {
+            return -1;
+        }
+        *digest_len = out_len;
+        return 0;
+    }
+}
+
+int ele_crypto_digest(ele_crypto_alg_t alg, const uint8_t *data, size_t len,
+                      uint8_t *digest, size_t *digest_len) {
+    return ele_crypto_digest_on(ele_crypto_select(alg, len), alg, data, len, digest, digest_len);
+}
+
+// AES-GCM
+
+static int ele_crypto_gcm_openssl(int encrypt, const uint8_t *key, size_t key_len,
+                                  const uint8_t *iv, const uint8_t *aad, size_t aad_len,
+                                  const uint8_t *in, size_t len, uint8_t *out, uint8_t *tag) {
+    const EVP_CIPHER *cipher;
+    EVP_CIPHER_CTX *ctx;
+    int n;
+    int ok;
+
+    switch (key_len) {
+    case 16: cipher = EVP_aes_128_gcm(); break;
+    case 24: cipher = EVP_aes_192_gcm(); break;
+    case 32: cipher = EVP_aes_256_gcm(); break;
+    default: return -1;
+    }
+
+    ctx = EVP_CIPHER_CTX_new();
+    if (ctx == NULL) {
+        return -1;
+    }
+
+    ok = EVP_CipherInit_ex(ctx, cipher, NULL, key, iv, encrypt) == 1 &&
+         (aad_len == 0 || EVP_CipherUpdate(ctx, NULL, &n, aad, (int)aad_len) == 1) &&
+         (len == 0 || EVP_CipherUpdate(ctx, out, &n, in, (int)len) == 1);
+    if (ok && !encrypt) {
+        ok = EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_GCM_SET_TAG, ELE_CRYPTO_GCM_TAG_LEN, tag) == 1;
+    }
+    ok = ok && EVP_CipherFinal_ex(ctx, out + len, &n) == 1;
+    if (ok && encrypt) {
+        ok = EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_GCM_GET_TAG, ELE_CRYPTO_GCM_TAG_LEN, tag) == 1;
+    }
+
+    EVP_CIPHER_CTX_free(ctx);
+    if (!ok && !encrypt) {
+        memset(out, 0, len);
+    }
+    return ok ? 0 : -1;
+}
+
+int ele_crypto_gcm_on(ele_crypto_backend_t backend, int encrypt,
+                      const uint8_t *key, size_t key_len, const uint8_t *iv,
+                      const uint8_t *aad, size_t aad_len,
+                      const uint8_t *in, size_t len, uint8_t *out, uint8_t *tag) {
+    if (len > INT32_MAX || aad_len > INT32_MAX ||
+        !ele_crypto_backend_supports(backend, ELE_CRYPTO_AES_GCM, len)) {
+        return -1;
+    }
+
+    return ele_crypto_gcm_openssl(encrypt, key, key_len, iv, aad, aad_len, in, len, out, tag);
+}
+
+int ele_crypto_gcm_encrypt(const uint8_t *key, size_t key_len, const uint8_t *iv,
+                           const uint8_t *aad, size_t aad_len,
+                           const uint8_t *in, size_t len, uint8_t *out, uint8_t *tag) {
+    return ele_crypto_gcm_on(ele_crypto_select(ELE_CRYPTO_AES_GCM, len), 1,
+                             key, key_len, iv, aad, aad_len, in, len, out, tag);
+}
+
+int ele_crypto_gcm_decrypt(const uint8_t *key, size_t key_len, const uint8_t *iv,
+                           const uint8_t *aad, size_t aad_len,
+                           const uint8_t *in, size_t len, uint8_t *out, const uint8_t *tag) {
+    uint8_t expected[ELE_CRYPTO_GCM_TAG_LEN];
+
+    memcpy(expected, tag, sizeof(expected));
+    return ele_crypto_gcm_on(ele_crypto_select(ELE_CRYPTO_AES_GCM, len), 0,
+                             key, key_len, iv, aad, aad_len, in, len, out, expected);
+}
+
+// ECDSA verification
+
+static EVP_PKEY *ele_crypto_public_key(ele_crypto_alg_t alg, const uint8_t *xy, size_t len) {
+    uint8_t point[1 + 2 * 48];
+    OSSL_PARAM_BLD *bld;
+    OSSL_PARAM *params = NULL;
+    EVP_PKEY_CTX *ctx = NULL;
+    EVP_PKEY *pkey = NULL;
+
+    point[0] = 0x04;
+    memcpy(point + 1, xy, len);
+
+    bld = OSSL_PARAM_BLD_new();
+    if (bld != NULL &&
+        OSSL_PARAM_BLD_push_utf8_string(bld, OSSL_PKEY_PARAM_GROUP_NAME,
+                                        alg == ELE_CRYPTO_ECDSA_P256 ? "P-256" : "P-384", 0) &&
+        OSSL_PARAM_BLD_push_octet_string(bld, OSSL_PKEY_PARAM_PUB_KEY, point, len + 1)) {
+        params = OSSL_PARAM_BLD_to_param(bld);
+    }
+    if (params != NULL) {
+        ctx = EVP_PKEY_CTX_new_from_name(NULL, "EC", NULL);
+    }
+    if (ctx == NULL || EVP_PKEY_fromdata_init(ctx) <= 0 ||
+        EVP_PKEY_fromdata(ctx, &pkey, EVP_PKEY_PUBLIC_KEY, params) <= 0) {
+        pkey = NULL;
+    }
+
+    EVP_PKEY_CTX_free(ctx);
+    OSSL_PARAM_free(params);
+    OSSL_PARAM_BLD_free(bld);
+    return pkey;
+}
+
+static int ele_crypto_verify_openssl(ele_crypto_alg_t alg, const uint8_t *pub, size_t pub_len,
+                                     const uint8_t *digest, size_t digest_len,
+                                     const uint8_t *sig, size_t sig_len) {
+    EVP_PKEY *pkey = ele_crypto_public_key(alg, pub, pub_len);
+    EVP_PKEY_CTX *ctx;
+    ECDSA_SIG *ecsig;
+    BIGNUM *r, *s;
+    uint8_t *der = NULL;
+    int der_len;
+    int rv;
+
+    if (pkey == NULL) {
+        return -1;
+    }
+
+    // Raw r || s to the DER ECDSA-Sig-Value OpenSSL verifies
+    ecsig = ECDSA_SIG_new();
+    r = BN_bin2bn(sig, (int)sig_len / 2, NULL);
+    s = BN_bin2bn(sig + sig_len / 2, (int)sig_len / 2, NULL);
+    if (ecsig == NULL || r == NULL || s == NULL || !ECDSA_SIG_set0(ecsig, r, s)) {
+        BN_free(r);
+        BN_free(s);
+        ECDSA_SIG_free(ecsig);
+        EVP_PKEY_free(pkey);
+        return -1;
+    }
+    der_len = i2d_ECDSA_SIG(ecsig, &der);
+    ECDSA_SIG_free(ecsig);
+
+    ctx = EVP_PKEY_CTX_new(pkey, NULL);
+    if (der_len <= 0 || ctx == NULL || EVP_PKEY_verify_init(ctx) <= 0) {
+        rv = -1;
+    } else {
+        rv = EVP_PKEY_verify(ctx, der, (size_t)der_len, digest, digest_len) == 1;
+    }
+
+    EVP_PKEY_CTX_free(ctx);
+    EVP_PKEY_free(pkey);
+    OPENSSL_free(der);
+    return rv;
+}
+
+int ele_crypto_ecdsa_verify_on(ele_crypto_backend_t backend, ele_crypto_alg_t alg,
+                               const uint8_t *pub, size_t pub_len,
+                               const uint8_t *digest, size_t digest_len,
+                               const uint8_t *sig, size_t sig_len) {
+    size_t coord;
+
+    if (!ele_crypto_is_ecdsa(alg) || digest_len == 0 || digest_len > ELE_CRYPTO_MAX_DIGEST ||
+        !ele_crypto_backend_supports(backend, alg, digest_len)) {
+        return -1;
+    }
+    coord = ele_crypto_coord_len(alg);
+    if (pub_len != 2 * coord || sig_len != 2 * coord) {
+        return -1;
+    }
+
+    if (backend == ELE_CRYPTO_BACKEND_ELE) {
+        return ele_hsm_verify_digest(pub, pub_len, digest, digest_len, sig, sig_len);
+    }
+    return ele_crypto_verify_openssl(alg, pub, pub_len, digest, digest_len, sig, sig_len);
+}
+
+int ele_crypto_ecdsa_verify(ele_crypto_alg_t alg, const uint8_t *pub, size_t pub_len,
+                            const uint8_t *digest, size_t digest_len,
+                            const uint8_t *sig, size_t sig_len) {
+    if (!ele_crypto_is_ecdsa(alg)) {
+        return -1;
+    }
+    return ele_crypto_ecdsa_verify_on(ele_crypto_select(alg, digest_len), alg, pub, pub_len,
+                                      digest, digest_len, sig, sig_len);
+}
+
+// Calibration
+
+typedef struct {
+    const uint8_t *data;        // largest size class of random bytes
+    uint8_t *out;
+    uint8_t key[32];
+    uint8_t iv[ELE_CRYPTO_GCM_IV_LEN];
+    uint8_t aad[16];
+
+    // Per curve: key pair, digest and its signature from OpenSSL
+    uint8_t pub[2][2 * 48];
+    uint8_t digest[2][32];
+    uint8_t sig[2][2 * 48];
+} ele_crypto_bench_t;
+
+static uint64_t ele_crypto_now_ns(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+// Sign the bench digest with a fresh OpenSSL key, exported as the ELE sees it
+static int ele_crypto_bench_keypair(ele_crypto_bench_t *b, unsigned int i, ele_crypto_alg_t alg) {
+    size_t coord = ele_crypto_coord_len(alg);
+    uint8_t point[1 + 2 * 48];
+    uint8_t der[160];
+    size_t point_len = 0;
+    size_t der_len = sizeof(der);
+    const unsigned char *q = der;
+    const BIGNUM *r, *s;
+    ECDSA_SIG *sig;
+    EVP_PKEY_CTX *ctx;
+    EVP_PKEY *pkey;
+    int ok;
+
+    pkey = EVP_PKEY_Q_keygen(NULL, NULL, "EC", alg == ELE_CRYPTO_ECDSA_P256 ? "P-256" : "P-384");
+    if (pkey == NULL) {
+        return -1;
+    }
+
+    ctx = EVP_PKEY_CTX_new(pkey, NULL);
+    ok = EVP_PKEY_get_octet_string_param(pkey, OSSL_PKEY_PARAM_PUB_KEY,
+                                         point, sizeof(point), &point_len) &&
+         point_len == 1 + 2 * coord &&
+         ctx != NULL && EVP_PKEY_sign_init(ctx) > 0 &&
+         EVP_PKEY_sign(ctx, der, &der_len, b->digest[i], sizeof(b->digest[i])) > 0;
+    EVP_PKEY_CTX_free(ctx);
+    EVP_PKEY_free(pkey);
+    if (!ok || (sig = d2i_ECDSA_SIG(NULL, &q, (long)der_len)) == NULL) {
+        return -1;
+    }
+
+    memcpy(b->pub[i], point + 1, 2 * coord);
+    ECDSA_SIG_get0(sig, &r, &s);
+    ok = BN_bn2binpad(r, b->sig[i], (int)coord) == (int)coord &&
+         BN_bn2binpad(s, b->sig[i] + coord, (int)coord) == (int)coord;
+    ECDSA_SIG_free(sig);
+    return ok ? 0 : -1;
+}
+
+// One operation of alg over len bytes; returns the result for checking
+static int ele_crypto_bench_op(ele_crypto_bench_t *b, ele_crypto_backend_t backend,
+                               ele_crypto_alg_t alg, size_t len, uint8_t *result,
+                               size_t *result_len) {
+    if (alg == ELE_CRYPTO_AES_GCM) {
+        uint8_t tag[ELE_CRYPTO_GCM_TAG_LEN];
+
+        if (ele_crypto_gcm_on(backend, 1, b->key, sizeof(b->key), b->iv, b->aad,
+                              sizeof(b->aad), b->data, len, b->out, tag) != 0) {
+            return -1;
+        }
+        // The tag covers the ciphertext; the check also decrypts it
+        memcpy(result, tag, sizeof(tag));
+        *result_len = sizeof(tag);
+        return 0;
+    }
+
+    if (ele_crypto_is_ecdsa(alg)) {
+        unsigned int i = alg == ELE_CRYPTO_ECDSA_P256 ? 0 : 1;
+        size_t coord = ele_crypto_coord_len(alg);
+        int rv = ele_crypto_ecdsa_verify_on(backend, alg, b->pub[i], 2 * coord,
+                                            b->digest[i], sizeof(b->digest[i]),
+                                            b->sig[i], 2 * coord);
+
+        result[0] = (uint8_t)rv;
+        *result_len = 1;
+        return rv == 1 ? 0 : -1;
+    }
+
+    *result_len = ELE_CRYPTO_MAX_DIGEST;
+    return ele_crypto_digest_on(backend, alg, b->data, len, result, result_len);
+}
+
+// Agreement with OpenSSL on a size class; ECDSA also has to reject a bad signature
+static int ele_crypto_bench_check(ele_crypto_bench_t *b, ele_crypto_backend_t backend,
+                                  ele_crypto_alg_t alg, size_t len) {
+    uint8_t want[ELE_CRYPTO_MAX_DIGEST];
+    uint8_t got[ELE_CRYPTO_MAX_DIGEST];
+    size_t want_len, got_len;
+
+    if (ele_crypto_bench_op(b, ELE_CRYPTO_BACKEND_OPENSSL, alg, len, want, &want_len) != 0 ||
+        ele_crypto_bench_op(b, backend, alg, len, got, &got_len) != 0 ||
+        want_len != got_len || memcmp(want, got, want_len) != 0) {
+        return -1;
+    }
+
+    if (ele_crypto_is_ecdsa(alg)) {
+        unsigned int i = alg == ELE_CRYPTO_ECDSA_P256 ? 0 : 1;
+        size_t coord = ele_crypto_coord_len(alg);
+        int rv;
+
+        b->digest[i][0] ^= 0x01;
+        rv = ele_crypto_ecdsa_verify_on(backend, alg, b->pub[i], 2 * coord,
+                                        b->digest[i], sizeof(b->digest[i]),
+                                        b->sig[i], 2 * coord);
+        b->digest[i][0] ^= 0x01;
+        return rv == 0 ? 0 : -1;
+    }
+
+    if (alg == ELE_CRYPTO_AES_GCM) {
+        uint8_t tag[ELE_CRYPTO_GCM_TAG_LEN];
+        uint8_t *plain = malloc(len + 16);
+        int ok;
+
+        // Round trip, and a corrupted tag has to be refused
+        memcpy(tag, want, sizeof(tag));
+        ok = plain != NULL &&
+             ele_crypto_gcm_on(backend, 0, b->key, sizeof(b->key), b->iv, b->aad,
+                               sizeof(b->aad), b->out, len, plain, tag) == 0 &&
+             memcmp(plain, b->data, len) == 0;
+        tag[0] ^= 0x01;
+        ok = ok && ele_crypto_gcm_on(backend, 0, b->key, sizeof(b->key), b->iv, b->aad,
+                                     sizeof(b->aad), b->out, len, plain, tag) != 0;
+        free(plain);
+        return ok ? 0 : -1;
+    }
+
+    return 0;
+}
+
+static int ele_crypto_compare_u64(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t *)a;
+    uint64_t y = *(const uint64_t *)b;
+
+    return x < y ? -1 : x > y;
+}
+
+// Median single-operation time within a time budget
+static uint64_t ele_crypto_bench_time(ele_crypto_bench_t *b, ele_crypto_backend_t backend,
+                                      ele_crypto_alg_t alg, size_t len, uint64_t budget_ns) {
+    uint64_t samples[ELE_CRYPTO_MAX_SAMPLES];
+    uint8_t result[ELE_CRYPTO_MAX_DIGEST];
+    size_t result_len;
+    uint64_t start = ele_crypto_now_ns();
+    unsigned int n = 0;
+
+    // One untimed run warms caches and the mailbox path
+    if (ele_crypto_bench_op(b, backend, alg, len, result, &result_len) != 0) {
+        return 0;
+    }
+
+    while (n < ELE_CRYPTO_MAX_SAMPLES &&
+           (n < ELE_CRYPTO_MIN_SAMPLES || ele_crypto_now_ns() - start < budget_ns)) {
+        uint64_t t0 = ele_crypto_now_ns();
+
+        if (ele_crypto_bench_op(b, backend, alg, len, result, &result_len) != 0) {
+            return 0;
+        }
+        samples[n++] = ele_crypto_now_ns() - t0;
+    }
+
+    qsort(samples, n, sizeof(samples[0]), ele_crypto_compare_u64);
+    return samples[n / 2] > 0 ? samples[n / 2] : 1;
+}
+
+int ele_crypto_calibrate(unsigned int budget_ms, FILE *log, ele_crypto_timing_t *timing) {
+    static ele_crypto_timing_t scratch;
+    size_t max_len = ele_crypto_size_class[ELE_CRYPTO_SIZE_CLASSES - 1];
+    ele_crypto_timing_t *t = timing != NULL ? timing : &scratch;
+    uint8_t choice[ELE_CRYPTO_ALG_COUNT][ELE_CRYPTO_SIZE_CLASSES];
+    int usable[ELE_CRYPTO_ALG_COUNT][ELE_CRYPTO_BACKEND_COUNT];
+    ele_crypto_bench_t bench;
+    uint8_t *data = malloc(max_len);
+    unsigned int cells = 0;
+    uint64_t cell_ns;
+    int failures = 0;
+
+    ele_crypto_init();
+    memset(t, 0, sizeof(*t));
+    memset(&bench, 0, sizeof(bench));
+    bench.out = malloc(max_len + 16);
+    if (data == NULL || bench.out == NULL ||
+        RAND_bytes(data, (int)max_len) != 1 ||
+        RAND_bytes(bench.key, sizeof(bench.key)) != 1 ||
+        RAND_bytes(bench.iv, sizeof(bench.iv)) != 1 ||
+        RAND_bytes(bench.aad, sizeof(bench.aad)) != 1 ||
+        RAND_bytes(&bench.digest[0][0], sizeof(bench.digest)) != 1 ||
+        ele_crypto_bench_keypair(&bench, 0, ELE_CRYPTO_ECDSA_P256) != 0 ||
+        ele_crypto_bench_keypair(&bench, 1, ELE_CRYPTO_ECDSA_P384) != 0) {
+        free(data);
+        free(bench.out);
+        return -1;
+    }
+    bench.data = data;
+
+    // Known-answer check of every backend before any of it is timed
+    for (unsigned int a = 0; a < ELE_CRYPTO_ALG_COUNT; a++) {
+        for (unsigned int be = 0; be < ELE_CRYPTO_BACKEND_COUNT; be++) {
+            usable[a][be] = 0;
+            for (unsigned int c = 0; c < ELE_CRYPTO_SIZE_CLASSES; c++) {
+                size_t len = ele_crypto_is_ecdsa(a) ? sizeof(bench.digest[0])
+                                                    : ele_crypto_size_class[c];
+
+                if (!ele_crypto_backend_supports(be, a, len)) {
+                    continue;
+                }
+                if (ele_crypto_bench_check(&bench, be, a, len) != 0) {
+                    if (log != NULL) {
+                        fprintf(log, "%s on %s failed the check at %zu bytes, not used\n",
+                                ele_crypto_alg_names[a], ele_crypto_backend_names[be], len);
+                    }
+                    usable[a][be] = 0;
+                    failures++;
+                    break;
+                }
+                usable[a][be] = 1;
+                cells++;
+                if (ele_crypto_is_ecdsa(a)) {
+                    break;
+                }
+            }
+        }
+    }
+
+    cell_ns = (uint64_t)budget_ms * 1000000ULL / (cells ? cells : 1);
+
+    for (unsigned int a = 0; a < ELE_CRYPTO_ALG_COUNT; a++) {
+        for (unsigned int c = 0; c < ELE_CRYPTO_SIZE_CLASSES; c++) {
+            size_t len = ele_crypto_is_ecdsa(a) ? sizeof(bench.digest[0])
+                                                : ele_crypto_size_class[c];
+            uint64_t best = 0;
+
+            choice[a][c] = ELE_CRYPTO_BACKEND_OPENSSL;
+            for (unsigned int be = 0; be < ELE_CRYPTO_BACKEND_COUNT; be++) {
+                uint64_t ns;
+
+                if (!usable[a][be] || !ele_crypto_backend_supports(be, a, len)) {
+                    continue;
+                }
+                // Verification cost does not depend on the size class
+                ns = ele_crypto_is_ecdsa(a) && c > 0
+                         ? t->ns[a][0][be]
+                         : ele_crypto_bench_time(&bench, be, a, len, cell_ns);
+                t->ns[a][c][be] = ns;
+                if (ns != 0 && (best == 0 || ns < best)) {
+                    best = ns;
+                    choice[a][c] = (uint8_t)be;
+                }
+            }
+        }
+        if (log != NULL) {
+            fprintf(log, "calibrated %s\n", ele_crypto_alg_names[a]);
+        }
+    }
+
+    memcpy(ele_crypto_choice, choice, sizeof(choice));
+    free(data);
+    free(bench.out);
+    explicit_bzero(&bench, sizeof(bench));
+    return failures;
+}
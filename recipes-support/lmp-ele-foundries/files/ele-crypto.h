@@ -0,0 +1,126 @@
+/*
+ * Crypto service dispatch for the ELE PKCS#11 module and tools
+ *
+ * AES-GCM, SHA-2 and ECDSA verification are each offered by up to three
+ * backends:
+ *
+ *   ele       the enclave, through the mailbox queue (ele-mailbox.c)
+ *   armv8-ce  the Cortex-A55 AES/SHA-2 instructions (ele-crypto-ce.c)
+ *   openssl   OpenSSL's EVP interface
+ *
+ * Which one is fastest depends on the message size: a mailbox round trip
+ * costs more than hashing a short message on the CPU, while long
+ * messages amortise it. The choice is taken from a profile that
+ * ele_crypto_calibrate() measures on the board itself and saves to
+ * ELE_CRYPTO_PROFILE_PATH (ELE_CRYPTO_PROFILE overrides the path).
+ * Without a profile every operation goes to OpenSSL.
+ *
+ * The ele backend needs the mailbox queue to be running (ele_mbox_init);
+ * the others are always available.
+ */
+
+#ifndef ELE_CRYPTO_H
+#define ELE_CRYPTO_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stddef.h>
+
+#define ELE_CRYPTO_PROFILE_PATH "/var/lib/ele-pkcs11/crypto-profile"
+
+#define ELE_CRYPTO_GCM_IV_LEN   12
+#define ELE_CRYPTO_GCM_TAG_LEN  16
+#define ELE_CRYPTO_MAX_DIGEST   64
+
+typedef enum {
+    ELE_CRYPTO_AES_GCM = 0,     // encrypt and decrypt, 128/192/256-bit keys
+    ELE_CRYPTO_SHA256,
+    ELE_CRYPTO_SHA384,
+    ELE_CRYPTO_SHA512,
+    ELE_CRYPTO_ECDSA_P256,      // verify
+    ELE_CRYPTO_ECDSA_P384,      // verify
+    ELE_CRYPTO_ALG_COUNT
+} ele_crypto_alg_t;
+
+typedef enum {
+    ELE_CRYPTO_BACKEND_ELE = 0,
+    ELE_CRYPTO_BACKEND_CE,
+    ELE_CRYPTO_BACKEND_OPENSSL,
+    ELE_CRYPTO_BACKEND_COUNT
+} ele_crypto_backend_t;
+
+/*
+ * Message size classes the profile distinguishes. A message uses the
+ * first class at least as large as itself, or the last one.
+ */
+#define ELE_CRYPTO_SIZE_CLASSES 8
+extern const size_t ele_crypto_size_class[ELE_CRYPTO_SIZE_CLASSES];
+
+// Calibration timing per class, in ns per operation (0: not measured)
+typedef struct {
+    uint64_t ns[ELE_CRYPTO_ALG_COUNT][ELE_CRYPTO_SIZE_CLASSES][ELE_CRYPTO_BACKEND_COUNT];
+} ele_crypto_timing_t;
+
+const char *ele_crypto_alg_name(ele_crypto_alg_t alg);
+const char *ele_crypto_backend_name(ele_crypto_backend_t backend);
+
+/*
+ * Load the saved profile. Safe to call repeatedly; returns 0 if a profile
+ * was loaded, -1 if the OpenSSL defaults are in use.
+ */
+int ele_crypto_init(void);
+
+// Whether a backend can run alg on a message of len bytes here and now
+int ele_crypto_backend_supports(ele_crypto_backend_t backend, ele_crypto_alg_t alg, size_t len);
+
+// Backend the dispatcher picks for alg on a message of len bytes
+ele_crypto_backend_t ele_crypto_select(ele_crypto_alg_t alg, size_t len);
+
+/*
+ * Operations. ele_crypto_*() dispatch through the profile; the _on()
+ * forms force a backend and fail if it cannot serve the request.
+ * Digest and GCM calls return 0 on success, -1 on error; GCM decryption
+ * also returns -1 when the tag does not match. Verification returns 1 for
+ * a valid signature, 0 for an invalid one and -1 on error.
+ *
+ * ECDSA public keys are X || Y, signatures raw r || s.
+ */
+int ele_crypto_digest(ele_crypto_alg_t alg, const uint8_t *data, size_t len,
+                      uint8_t *digest, size_t *digest_len);
+int ele_crypto_digest_on(ele_crypto_backend_t backend, ele_crypto_alg_t alg,
+                         const uint8_t *data, size_t len,
+                         uint8_t *digest, size_t *digest_len);
+
+int ele_crypto_gcm_encrypt(const uint8_t *key, size_t key_len, const uint8_t *iv,
+                           const uint8_t *aad, size_t aad_len,
+                           const uint8_t *in, size_t len, uint8_t *out, uint8_t *tag);
+int ele_crypto_gcm_decrypt(const uint8_t *key, size_t key_len, const uint8_t *iv,
+                           const uint8_t *aad, size_t aad_len,
+                           const uint8_t *in, size_t len, uint8_t *out, const uint8_t *tag);
+int ele_crypto_gcm_on(ele_crypto_backend_t backend, int encrypt,
+                      const uint8_t *key, size_t key_len, const uint8_t *iv,
+                      const uint8_t *aad, size_t aad_len,
+                      const uint8_t *in, size_t len, uint8_t *out, uint8_t *tag);
+
+int ele_crypto_ecdsa_verify(ele_crypto_alg_t alg, const uint8_t *pub, size_t pub_len,
+                            const uint8_t *digest, size_t digest_len,
+                            const uint8_t *sig, size_t sig_len);
+int ele_crypto_ecdsa_verify_on(ele_crypto_backend_t backend, ele_crypto_alg_t alg,
+                               const uint8_t *pub, size_t pub_len,
+                               const uint8_t *digest, size_t digest_len,
+                               const uint8_t *sig, size_t sig_len);
+
+/*
+ * Check every available backend against OpenSSL, time each algorithm and
+ * size class on each backend that passed for about budget_ms in total,
+ * and make the fastest the active choice. Progress goes to log if not
+ * NULL; timing (if not NULL) receives the measurements. Returns the
+ * number of backend/algorithm pairs that failed the check.
+ */
+int ele_crypto_calibrate(unsigned int budget_ms, FILE *log, ele_crypto_timing_t *timing);
+
+// Save / print the active choice table
+int ele_crypto_save_profile(const char *path);
+void ele_crypto_print_profile(FILE *out);
+
+#endif /* ELE_CRYPTO_H */
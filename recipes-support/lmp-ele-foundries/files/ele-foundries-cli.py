@@ -10,26 +10,49 @@ import argparse
 import subprocess
 from pathlib import Path
 
+def probe_ele():
+    """Return the libeleprobe snapshot (cached in /run), or None"""
+    try:
+        result = subprocess.run(["ele-probe", "--json"], capture_output=True,
+                                text=True, timeout=10)
+    except (OSError, subprocess.TimeoutExpired):
+        return None
+    if result.returncode != 0:
+        return None
+    try:
+        return json.loads(result.stdout)
+    except ValueError:
+        return None
+
 def check_ele_status():
     """Check EdgeLock Enclave status"""
     print("🔐 EdgeLock Enclave Status:")
     
+    probe = probe_ele()
+    if probe is None:
+        print("  ❌ ele-probe unavailable (libeleprobe not installed)")
+        return False
+    
     # Check ELE device
-    if os.path.exists("/dev/ele_mu"):
-        print("  ✅ ELE device: /dev/ele_mu (present)")
+    device = probe["device"]
+    if device["present"]:
+        print(f"  ✅ ELE device: {device['path']} (present)")
     else:
-        print("  ❌ ELE device: /dev/ele_mu (missing)")
+        print(f"  ❌ ELE device: {device['path']} (missing)")
         return False
     
+    info = probe.get("info")
+    if info:
+        print(f"  ✅ ELE firmware {info['fw_version']}, lifecycle {info['lifecycle_name']}")
+    
     # Check ELE firmware
-    firmware_dir = "/lib/firmware/imx/ele"
-    if os.path.exists(firmware_dir):
-        print(f"  ✅ ELE firmware: {firmware_dir} (present)")
-        firmware_files = list(Path(firmware_dir).glob("*"))
-        for fw in firmware_files:
-            print(f"    📦 {fw.name}")
+    firmware = probe["firmware"]
+    if firmware["present"]:
+        print(f"  ✅ ELE firmware: {firmware['path']} (present)")
+        for fw in firmware["files"]:
+            print(f"    📦 {fw['name']}")
     else:
-        print(f"  ❌ ELE firmware: {firmware_dir} (missing)")
+        print(f"  ❌ ELE firmware: {firmware['path']} (missing)")
     
     return True
 
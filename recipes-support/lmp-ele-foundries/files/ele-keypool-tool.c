@@ -0,0 +1,137 @@
+/*
+ * ele-keypool - pre-generate ELE key pairs for the PKCS#11 module
+ *
+ * Fills the shared key pool (see ele-keypool.h) so that a later
+ * C_GenerateKeyPair, e.g. from lmp-device-register during first-boot
+ * registration, is served without waiting for the enclave. Meant to be
+ * run early at boot at idle priority while the network comes up:
+ *
+ *   ele-keypool fill                 # targets from ELE_PKCS11_KEYPOOL, if any
+ *   ele-keypool -c p256=4 fill
+ *   ele-keypool status
+ *
+ * Copyright (C) 2024 Dynamic Devices Ltd.
+ * Licensed under BSD-3-Clause
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <getopt.h>
+#include <time.h>
+
+#include "ele-backend.h"
+#include "ele-keypool.h"
+#include "ele-mailbox.h"
+
+#define DEFAULT_DEVICE_PATH "/dev/ele_mu"
+
+static const char *const curve_names[ELE_CURVE_COUNT] = {
+    [ELE_CURVE_P256] = "P-256",
+    [ELE_CURVE_P384] = "P-384",
+};
+
+static void print_usage(const char *prog) {
+    printf("Usage: %s [options] [fill|status]\n", prog);
+    printf("\n");
+    printf("Commands:\n");
+    printf("  fill                Generate keys until the pool holds the targets (default)\n");
+    printf("  status              Show the pooled keys per curve\n");
+    printf("\n");
+    printf("Options:\n");
+    printf("  -c, --config SPEC   Pool targets, e.g. p256=4,p384=1\n");
+    printf("                      (default ELE_PKCS11_KEYPOOL; empty disables the pool)\n");
+    printf("  -h, --help          Show this help\n");
+}
+
+static int show_status(const unsigned int targets[ELE_CURVE_COUNT]) {
+    unsigned int counts[ELE_CURVE_COUNT];
+
+    if (ele_keypool_count(counts) != 0) {
+        fprintf(stderr, "ele-keypool: cannot read the key pool\n");
+        return 1;
+    }
+    for (unsigned int c = 0; c < ELE_CURVE_COUNT; c++) {
+        printf("%-6s %2u pooled, target %u\n", curve_names[c], counts[c], targets[c]);
+    }
+    return 0;
+}
+
+static int fill(const unsigned int targets[ELE_CURVE_COUNT]) {
+    ele_backend_t backend;
+    struct timespec t0, t1;
+    unsigned int total = 0;
+    int added;
+
+    for (unsigned int c = 0; c < ELE_CURVE_COUNT; c++) {
+        total += targets[c];
+    }
+    // The boot service runs whether or not a pool is configured
+    if (total == 0) {
+        printf("Key pool disabled (no targets in ELE_PKCS11_KEYPOOL)\n");
+        return 0;
+    }
+
+    if (ele_backend_select(&backend, DEFAULT_DEVICE_PATH) != 0 ||
+        ele_mbox_init(&backend, 1) != 0) {
+        fprintf(stderr, "ele-keypool: cannot open the ELE (%s)\n", backend.target);
+        return 1;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    added = ele_keypool_fill(targets);
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    ele_mbox_shutdown();
+
+    if (added < 0) {
+        fprintf(stderr, "ele-keypool: key generation failed\n");
+        return 1;
+    }
+
+    printf("Added %d key pair(s) in %.1f ms\n", added,
+           (t1.tv_sec - t0.tv_sec) * 1e3 + (t1.tv_nsec - t0.tv_nsec) / 1e6);
+    return show_status(targets);
+}
+
+int main(int argc, char *argv[]) {
+    static const struct option long_opts[] = {
+        { "config", required_argument, NULL, 'c' },
+        { "help", no_argument, NULL, 'h' },
+        { NULL, 0, NULL, 0 }
+    };
+    unsigned int targets[ELE_CURVE_COUNT];
+    const char *spec = getenv("ELE_PKCS11_KEYPOOL");
+    const char *command = "fill";
+    int opt;
+
+    while ((opt = getopt_long(argc, argv, "c:h", long_opts, NULL)) != -1) {
+        switch (opt) {
+        case 'c':
+            spec = optarg;
+            break;
+        case 'h':
+            print_usage(argv[0]);
+            return 0;
+        default:
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+    if (optind < argc) {
+        command = argv[optind];
+    }
+
+    if (ele_keypool_parse(spec, targets) != 0) {
+        return 1;
+    }
+
+    if (strcmp(command, "fill") == 0) {
+        return fill(targets);
+    }
+    if (strcmp(command, "status") == 0) {
+        return show_status(targets);
+    }
+
+    print_usage(argv[0]);
+    return 1;
+}
@@ -0,0 +1,454 @@
+/*
+ * Pre-generated key pair pool for the ELE PKCS#11 module
+ *
+ * The pool file is a header { magic "ELEKPOL1", version, count } followed
+ * by fixed-size records { key id, curve, public key }. Every change is
+ * made under an flock() on "<pool>.lock" and published with rename(), as
+ * for the object cache. A key is removed from the file before it is
+ * handed out, so if the update cannot be written the key is not used
+ * and the caller generates a fresh one.
+ *
+ * Pooled keys are made persistent: they are generated by whichever
+ * process fills the pool and used by another one. A key that does not
+ * make it into the pool is deleted from the enclave again.
+ *
+ * Keys are generated outside the lock; only the short read-modify-write
+ * of the file is serialized between processes.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <pthread.h>
+#include <time.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+
+#include "ele-keypool.h"
+#include "ele-mailbox.h"
+#include "ele-objects.h"
+
+#define ELE_KEYPOOL_MAGIC       "ELEKPOL1"
+#define ELE_KEYPOOL_VERSION     1
+#define ELE_KEYPOOL_RECORDS     (ELE_KEYPOOL_MAX_KEYS * ELE_CURVE_COUNT)
+
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t count;
+} ele_keypool_header_t;
+
+typedef struct {
+    uint32_t key_id;
+    uint32_t curve;
+    uint32_t pub_len;
+    uint32_t reserved;
+    uint8_t pub[(ELE_MAX_PUBKEY_LEN + 7) & ~7];
+} ele_keypool_record_t;
+
+typedef struct {
+    ele_keypool_header_t hdr;
+    ele_keypool_record_t rec[ELE_KEYPOOL_RECORDS];
+} ele_keypool_file_t;
+
+static struct {
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+    pthread_once_t path_once;
+    char path[256];
+    unsigned int targets[ELE_CURVE_COUNT];
+    int wanted;
+    int stop;
+    int threaded;
+    pthread_t thread;
+} ele_keypool = {
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+    .wake = PTHREAD_COND_INITIALIZER,
+    .path_once = PTHREAD_ONCE_INIT,
+};
+
+static pthread_once_t ele_keypool_atfork_once = PTHREAD_ONCE_INIT;
+
+static void ele_keypool_atfork_prepare(void) {
+    pthread_mutex_lock(&ele_keypool.lock);
+}
+
+static void ele_keypool_atfork_parent(void) {
+    pthread_mutex_unlock(&ele_keypool.lock);
+}
+
+// The refill thread stays with the parent
+static void ele_keypool_atfork_child(void) {
+    ele_keypool.threaded = 0;
+    ele_keypool.stop = 0;
+    pthread_cond_init(&ele_keypool.wake, NULL);
+    pthread_mutex_unlock(&ele_keypool.lock);
+}
+
+static void ele_keypool_register_atfork(void) {
+    pthread_atfork(ele_keypool_atfork_prepare, ele_keypool_atfork_parent,
+                   ele_keypool_atfork_child);
+}
+
+static const char *const ele_keypool_curve_names[ELE_CURVE_COUNT] = {
+    [ELE_CURVE_P256] = "p256",
+    [ELE_CURVE_P384] = "p384",
+};
+
+static void ele_keypool_path_init(void) {
+    const char *env = getenv("ELE_PKCS11_KEYPOOL_FILE");
+
+    snprintf(ele_keypool.path, sizeof(ele_keypool.path), "%s",
+             (env != NULL && *env != '\0') ? env : ELE_KEYPOOL_PATH);
+}
+
+static const char *ele_keypool_path(void) {
+    pthread_once(&ele_keypool.path_once, ele_keypool_path_init);
+    return ele_keypool.path;
+}
+
+int ele_keypool_parse(const char *spec, unsigned int targets[ELE_CURVE_COUNT]) {
+    char buf[128];
+    char *save = NULL;
+
+    memset(targets, 0, ELE_CURVE_COUNT * sizeof(targets[0]));
+    if (spec == NULL || *spec == '\0') {
+        return 0;
+    }
+
+    snprintf(buf, sizeof(buf), "%s", spec);
+    for (char *tok = strtok_r(buf, ",", &save); tok; tok = strtok_r(NULL, ",", &save)) {
+        char *eq = strchr(tok, '=');
+        unsigned int curve = ELE_CURVE_P256;
+        unsigned long n;
+
+        if (eq != NULL) {
+            *eq = '\0';
+            for (curve = 0; curve < ELE_CURVE_COUNT; curve++) {
+                if (strcmp(tok, ele_keypool_curve_names[curve]) == 0) {
+                    break;
+                }
+            }
+            if (curve == ELE_CURVE_COUNT) {
+                fprintf(stderr, "ELE PKCS#11: Unknown key pool curve '%s'\n", tok);
+                return -1;
+            }
+            tok = eq + 1;
+        }
+
+        n = strtoul(tok, NULL, 10);
+        targets[curve] = n > ELE_KEYPOOL_MAX_KEYS ? ELE_KEYPOOL_MAX_KEYS : (unsigned int)n;
+    }
+
+    return 0;
+}
+
+/* Pool file */
+
+// Read the pool; a missing or malformed file reads as empty
+static void ele_keypool_load(ele_keypool_file_t *pool) {
+    int fd = open(ele_keypool_path(), O_RDONLY | O_CLOEXEC);
+    ssize_t n = -1;
+
+    memset(&pool->hdr, 0, sizeof(pool->hdr));
+    if (fd >= 0) {
+        n = pread(fd, pool, sizeof(*pool), 0);
+        close(fd);
+    }
+
+    if (n < (ssize_t)sizeof(pool->hdr) ||
+        memcmp(pool->hdr.magic, ELE_KEYPOOL_MAGIC, sizeof(pool->hdr.magic)) != 0 ||
+        pool->hdr.version != ELE_KEYPOOL_VERSION || pool->hdr.count > ELE_KEYPOOL_RECORDS ||
+        (size_t)n < sizeof(pool->hdr) + pool->hdr.count * sizeof(pool->rec[0])) {
+        pool->hdr.count = 0;
+    }
+}
+
+static int ele_keypool_store(ele_keypool_file_t *pool) {
+    char tmp_path[sizeof(ele_keypool.path) + 32];
+    size_t len = sizeof(pool->hdr) + pool->hdr.count * sizeof(pool->rec[0]);
+    int ok;
+    int fd;
+
+    memcpy(pool->hdr.magic, ELE_KEYPOOL_MAGIC, sizeof(pool->hdr.magic));
+    pool->hdr.version = ELE_KEYPOOL_VERSION;
+
+    snprintf(tmp_path, sizeof(tmp_path), "%s.tmp.%d", ele_keypool_path(), (int)getpid());
+    fd = open(tmp_path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    if (fd < 0) {
+        return -1;
+    }
+
+    ok = write(fd, pool, len) == (ssize_t)len && fsync(fd) == 0;
+    if (close(fd) != 0 || !ok || rename(tmp_path, ele_keypool_path()) != 0) {
+        unlink(tmp_path);
+        return -1;
+    }
+    return 0;
+}
+
+static int ele_keypool_lock(void) {
+    char dir[sizeof(ele_keypool.path)];
+    char lock_path[sizeof(ele_keypool.path) + 8];
+    char *slash;
+    int fd;
+
+    snprintf(dir, sizeof(dir), "%s", ele_keypool_path());
+    slash = strrchr(dir, '/');
+    if (slash != NULL && slash != dir) {
+        *slash = '\0';
+        mkdir(dir, 0700);
+    }
+
+    snprintf(lock_path, sizeof(lock_path), "%s.lock", ele_keypool_path());
+    fd = open(lock_path, O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+    if (fd >= 0 && flock(fd, LOCK_EX) != 0) {
+        close(fd);
+        fd = -1;
+    }
+    return fd;
+}
+
+static void ele_keypool_unlock(int fd) {
+    close(fd);    // releases the flock
+}
+
+static unsigned int ele_keypool_count_curve(const ele_keypool_file_t *pool, unsigned int curve) {
+    unsigned int n = 0;
+
+    for (uint32_t i = 0; i < pool->hdr.count; i++) {
+        n += pool->rec[i].curve == curve;
+    }
+    return n;
+}
+
+int ele_keypool_take(unsigned int curve, uint32_t *key_id, uint8_t *pub, size_t *pub_len) {
+    ele_keypool_file_t pool;
+    struct stat st;
+    int rv = -1;
+    int lock_fd;
+
+    // Common case when no pool is provisioned: one stat(), no lock
+    if (stat(ele_keypool_path(), &st) != 0 || st.st_size <= (off_t)sizeof(ele_keypool_header_t)) {
+        return -1;
+    }
+
+    lock_fd = ele_keypool_lock();
+    if (lock_fd < 0) {
+        return -1;
+    }
+
+    ele_keypool_load(&pool);
+    for (uint32_t i = pool.hdr.count; i-- > 0; ) {
+        ele_keypool_record_t rec = pool.rec[i];
+
+        if (rec.curve != curve || rec.pub_len > *pub_len) {
+            continue;
+        }
+
+        pool.rec[i] = pool.rec[pool.hdr.count - 1];
+        pool.hdr.count--;
+        if (ele_keypool_store(&pool) == 0) {
+            *key_id = rec.key_id;
+            memcpy(pub, rec.pub, rec.pub_len);
+            *pub_len = rec.pub_len;
+            rv = 0;
+        }
+        break;
+    }
+
+    ele_keypool_unlock(lock_fd);
+
+    // Let the refill thread replace what was taken
+    pthread_mutex_lock(&ele_keypool.lock);
+    ele_keypool.wanted = 1;
+    pthread_cond_signal(&ele_keypool.wake);
+    pthread_mutex_unlock(&ele_keypool.lock);
+
+    return rv;
+}
+
+int ele_keypool_count(unsigned int counts[ELE_CURVE_COUNT]) {
+    ele_keypool_file_t pool;
+    int lock_fd = ele_keypool_lock();
+
+    if (lock_fd < 0) {
+        return -1;
+    }
+    ele_keypool_load(&pool);
+    ele_keypool_unlock(lock_fd);
+
+    for (unsigned int c = 0; c < ELE_CURVE_COUNT; c++) {
+        counts[c] = ele_keypool_count_curve(&pool, c);
+    }
+    return 0;
+}
+
+/*
+ * Generate one key for the first curve below its target. Returns 1 if a
+ * key was added, 0 if the pool is full, -1 on error.
+ */
+static int ele_keypool_fill_one(const unsigned int targets[ELE_CURVE_COUNT]) {
+    ele_keypool_record_t rec;
+    ele_keypool_file_t pool;
+    unsigned int counts[ELE_CURVE_COUNT];
+    size_t pub_len = ELE_MAX_PUBKEY_LEN;
+    int lock_fd;
+    int rv;
+
+    if (ele_keypool_count(counts) != 0) {
+        return -1;
+    }
+
+    memset(&rec, 0, sizeof(rec));
+    for (rec.curve = 0; rec.curve < ELE_CURVE_COUNT; rec.curve++) {
+        if (counts[rec.curve] < targets[rec.curve]) {
+            break;
+        }
+    }
+    if (rec.curve == ELE_CURVE_COUNT) {
+        return 0;
+    }
+
+    if (ele_hsm_generate_key(ele_curve_bits(rec.curve), ELE_KEY_LIFETIME_PERSISTENT,
+                             &rec.key_id, rec.pub, &pub_len) != 0) {
+        return -1;
+    }
+    rec.pub_len = (uint32_t)pub_len;
+
+    lock_fd = ele_keypool_lock();
+    if (lock_fd < 0) {
+        ele_hsm_delete_key(rec.key_id);
+        return -1;
+    }
+    ele_keypool_load(&pool);
+    // Another filler may have got there first; the surplus key is dropped
+    if (ele_keypool_count_curve(&pool, rec.curve) >= targets[rec.curve] ||
+        pool.hdr.count >= ELE_KEYPOOL_RECORDS) {
+        rv = 0;
+    } else {
+        pool.rec[pool.hdr.count++] = rec;
+        rv = ele_keypool_store(&pool) == 0 ? 1 : -1;
+    }
+    ele_keypool_unlock(lock_fd);
+
+    // A persistent key nobody will take would occupy the key store for good
+    if (rv != 1 && ele_hsm_delete_key(rec.key_id) != 0) {
+        fprintf(stderr, "ELE PKCS#11: Cannot delete surplus pool key 0x%08x\n", rec.key_id);
+    }
+
+    return rv;
+}
+
+int ele_keypool_fill(const unsigned int targets[ELE_CURVE_COUNT]) {
+    int added = 0;
+    int rv;
+
+    while ((rv = ele_keypool_fill_one(targets)) > 0) {
+        added++;
+    }
+
+    return rv < 0 ? -1 : added;
+}
+
+/* Background refill */
+
+// Sleep for the idle period; returns 1 if no other mailbox request was submitted meanwhile
+static int ele_keypool_wait_idle(void) {
+    unsigned long before = ele_mbox_submitted();
+    struct timespec ts;
+    int stop;
+
+    clock_gettime(CLOCK_REALTIME, &ts);
+    ts.tv_nsec += ELE_KEYPOOL_IDLE_MS * 1000000L;
+    if (ts.tv_nsec >= 1000000000L) {
+        ts.tv_sec++;
+        ts.tv_nsec -= 1000000000L;
+    }
+
+    pthread_mutex_lock(&ele_keypool.lock);
+    if (!ele_keypool.stop) {
+        pthread_cond_timedwait(&ele_keypool.wake, &ele_keypool.lock, &ts);
+    }
+    stop = ele_keypool.stop;
+    pthread_mutex_unlock(&ele_keypool.lock);
+
+    return !stop && ele_mbox_submitted() == before;
+}
+
+static void *ele_keypool_thread(void *arg) {
+    (void)arg;
+
+    for (;;) {
+        int rv;
+
+        pthread_mutex_lock(&ele_keypool.lock);
+        while (!ele_keypool.stop && !ele_keypool.wanted) {
+            pthread_cond_wait(&ele_keypool.wake, &ele_keypool.lock);
+        }
+        if (ele_keypool.stop) {
+            pthread_mutex_unlock(&ele_keypool.lock);
+            break;
+        }
+        pthread_mutex_unlock(&ele_keypool.lock);
+
+        // Only use the enclave when the application is not
+        if (!ele_keypool_wait_idle()) {
+            continue;
+        }
+
+        rv = ele_keypool_fill_one(ele_keypool.targets);
+        if (rv == 0) {
+            pthread_mutex_lock(&ele_keypool.lock);
+            ele_keypool.wanted = 0;
+            pthread_mutex_unlock(&ele_keypool.lock);
+        } else if (rv < 0) {
+            // Do not spin against a failing enclave or a read-only pool
+            sleep(1);
+        }
+    }
+
+    return NULL;
+}
+
+int ele_keypool_init(int allow_threads) {
+    unsigned int total = 0;
+
+    pthread_once(&ele_keypool_atfork_once, ele_keypool_register_atfork);
+
+    if (ele_keypool_parse(getenv("ELE_PKCS11_KEYPOOL"), ele_keypool.targets) != 0) {
+        memset(ele_keypool.targets, 0, sizeof(ele_keypool.targets));
+    }
+    for (unsigned int c = 0; c < ELE_CURVE_COUNT; c++) {
+        total += ele_keypool.targets[c];
+    }
+
+    pthread_mutex_lock(&ele_keypool.lock);
+    ele_keypool.stop = 0;
+    ele_keypool.wanted = 1;
+    ele_keypool.threaded = 0;
+    pthread_mutex_unlock(&ele_keypool.lock);
+
+    if (total > 0 && allow_threads && ele_mbox_depth() > 0 &&
+        pthread_create(&ele_keypool.thread, NULL, ele_keypool_thread, NULL) == 0) {
+        ele_keypool.threaded = 1;
+    }
+
+    return 0;
+}
+
+void ele_keypool_shutdown(void) {
+    if (!ele_keypool.threaded) {
+        return;
+    }
+
+    pthread_mutex_lock(&ele_keypool.lock);
+    ele_keypool.stop = 1;
+    pthread_cond_signal(&ele_keypool.wake);
+    pthread_mutex_unlock(&ele_keypool.lock);
+    pthread_join(ele_keypool.thread, NULL);
+    ele_keypool.threaded = 0;
+}
@@ -0,0 +1,62 @@
+/*
+ * Pre-generated key pair pool for the ELE PKCS#11 module
+ *
+ * ELE key generation is the slowest enclave operation and sits on the
+ * critical path of first-boot registration. Key pairs can instead be
+ * generated while the board is otherwise idle and parked in a pool;
+ * C_GenerateKeyPair then takes one from the pool and only falls back to
+ * generating inline when the pool is empty.
+ *
+ * The pool is a file shared by all processes, so the ele-keypool tool
+ * (run early at boot) fills it for a registration client started later.
+ * Every key is handed out at most once.
+ *
+ * ELE_PKCS11_KEYPOOL sets the pool targets, e.g. "p256=4,p384=1" (a bare
+ * number means P-256 keys). When it is set and the application allows
+ * threads, the module also tops the pool up in the background whenever
+ * the mailbox has been idle for ELE_KEYPOOL_IDLE_MS. ELE_PKCS11_KEYPOOL_FILE
+ * overrides the pool file location.
+ */
+
+#ifndef ELE_KEYPOOL_H
+#define ELE_KEYPOOL_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "ele-pkcs11.h"
+
+#define ELE_KEYPOOL_PATH        "/var/lib/ele-pkcs11/keypool"
+
+// Keys of one curve the pool holds at most
+#define ELE_KEYPOOL_MAX_KEYS    16
+
+// Mailbox quiet time before the refill thread generates a key
+#define ELE_KEYPOOL_IDLE_MS     50
+
+/*
+ * Parse "p256=N,p384=M" (or "N") into per-curve targets. Returns 0, or
+ * -1 for an unknown curve name.
+ */
+int ele_keypool_parse(const char *spec, unsigned int targets[ELE_CURVE_COUNT]);
+
+/*
+ * Read ELE_PKCS11_KEYPOOL and start the refill thread if targets are set
+ * and allow_threads is non-zero.
+ */
+int ele_keypool_init(int allow_threads);
+void ele_keypool_shutdown(void);
+
+// Take a pooled key pair of the given curve; returns 0, or -1 if none
+int ele_keypool_take(unsigned int curve, uint32_t *key_id, uint8_t *pub, size_t *pub_len);
+
+/*
+ * Generate keys from the calling thread until the pool holds the targets.
+ * Returns the number of keys added, or -1 if the enclave failed.
+ */
+int ele_keypool_fill(const unsigned int targets[ELE_CURVE_COUNT]);
+
+// Keys currently pooled per curve; returns 0, or -1 if the pool is unreadable
+int ele_keypool_count(unsigned int counts[ELE_CURVE_COUNT]);
+
+#endif /* ELE_KEYPOOL_H */
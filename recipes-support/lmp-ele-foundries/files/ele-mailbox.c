@@ -0,0 +1,522 @@
+/*
+ * ELE mailbox command queue for the i.MX93 EdgeLock Enclave PKCS#11 module
+ *
+ * Every open() of the ELE device creates a separate device context in
+ * the kernel driver (the backend layer in ele-backend.c may stand an
+ * ele-sim daemon or the in-process simulator in for the device). One
+ * worker thread owns each context; callers push requests onto a shared
+ * FIFO and sleep on their own condition variable.
+ * A worker takes one request per wake-up and hands the next one to an
+ * idle worker, so with N contexts up to N commands are outstanding in the
+ * driver at once rather than queueing behind each other on one context.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+
+#include "ele-mailbox.h"
+#include "ele-trace.h"
+
+static struct {
+    pthread_mutex_t lock;
+    pthread_cond_t work;
+    ele_request_t *head;
+    ele_request_t *tail;
+    int stop;
+    int threaded;
+    unsigned int depth;
+    unsigned long submitted;
+    ele_backend_t backend;
+    int fds[ELE_QUEUE_MAX_DEPTH];
+    pthread_t workers[ELE_QUEUE_MAX_DEPTH];
+} ele_queue = {
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+    .work = PTHREAD_COND_INITIALIZER,
+};
+
+static pthread_once_t ele_queue_atfork_once = PTHREAD_ONCE_INIT;
+
+// Hold the queue lock across fork() so the child's copy is consistent
+static void ele_queue_atfork_prepare(void) {
+    pthread_mutex_lock(&ele_queue.lock);
+}
+
+static void ele_queue_atfork_parent(void) {
+    pthread_mutex_unlock(&ele_queue.lock);
+}
+
+/*
+ * The workers and the requests they serve stay with the parent. The
+ * child gets an empty queue with no contexts (the inherited descriptors
+ * are close-on-exec and left alone), so its requests fail with -ENODEV
+ * until it runs ele_mbox_init() again.
+ */
+static void ele_queue_atfork_child(void) {
+    ele_queue.head = NULL;
+    ele_queue.tail = NULL;
+    ele_queue.stop = 0;
+    ele_queue.threaded = 0;
+    ele_queue.depth = 0;
+    pthread_cond_init(&ele_queue.work, NULL);
+    pthread_mutex_unlock(&ele_queue.lock);
+}
+
+static void ele_queue_register_atfork(void) {
+    pthread_atfork(ele_queue_atfork_prepare, ele_queue_atfork_parent, ele_queue_atfork_child);
+}
+
+static unsigned int ele_queue_requested_depth(void) {
+    const char *env = getenv("ELE_PKCS11_QUEUE_DEPTH");
+    long depth = ELE_QUEUE_DEFAULT_DEPTH;
+
+    if (env != NULL && *env != '\0') {
+        depth = strtol(env, NULL, 10);
+    }
+
+    if (depth < 1) {
+        depth = 1;
+    } else if (depth > ELE_QUEUE_MAX_DEPTH) {
+        depth = ELE_QUEUE_MAX_DEPTH;
+    }
+
+    return (unsigned int)depth;
+}
+
+// One blocking command/response exchange on a device context
+static int ele_transact(int fd, ele_request_t *req) {
+    uint64_t t0 = (ele_trace_flags & ELE_TRACE_TIMED) ? ele_trace_now() : 0;
+    ssize_t n = ele_queue.backend.exchange(&ele_queue.backend, fd,
+                                           req->cmd, req->cmd_words * sizeof(uint32_t),
+                                           req->rsp, sizeof(req->rsp));
+
+    // Enclave time as seen by this context, keyed by ELE command
+    if (ele_trace_flags & ELE_TRACE_TIMED) {
+        ele_trace_record(ELE_TRACE_FN_MAILBOX, n < 0 ? (unsigned long)-n : 0,
+                         (req->cmd[0] >> 16) & 0xFF, t0);
+    }
+
+    if (n < 0) {
+        return (int)n;
+    }
+
+    if ((size_t)n < 2 * sizeof(uint32_t)) {
+        return -EIO;
+    }
+
+    req->rsp_words = (size_t)n / sizeof(uint32_t);
+
+    // Header: tag in the top byte, command in the next one
+    if ((req->rsp[0] >> 24) != ELE_MSG_TAG_RSP ||
+        ((req->rsp[0] >> 16) & 0xFF) != ((req->cmd[0] >> 16) & 0xFF)) {
+        return -EPROTO;
+    }
+
+    return 0;
+}
+
+static void ele_request_complete(ele_request_t *req, int status) {
+    pthread_mutex_lock(&ele_queue.lock);
+    req->status = status;
+    req->done = 1;
+    pthread_cond_signal(&req->cond);
+    pthread_mutex_unlock(&ele_queue.lock);
+}
+
+static void *ele_queue_worker(void *arg) {
+    int fd = ele_queue.fds[(uintptr_t)arg];
+
+    for (;;) {
+        ele_request_t *req;
+
+        pthread_mutex_lock(&ele_queue.lock);
+        while (ele_queue.head == NULL && !ele_queue.stop) {
+            pthread_cond_wait(&ele_queue.work, &ele_queue.lock);
+        }
+
+        if (ele_queue.head == NULL && ele_queue.stop) {
+            pthread_mutex_unlock(&ele_queue.lock);
+            break;
+        }
+
+        // Take one request; anything behind it goes to the next idle context
+        req = ele_queue.head;
+        ele_queue.head = req->next;
+        if (ele_queue.head == NULL) {
+            ele_queue.tail = NULL;
+        } else {
+            pthread_cond_signal(&ele_queue.work);
+        }
+        pthread_mutex_unlock(&ele_queue.lock);
+
+        ele_request_complete(req, ele_transact(fd, req));
+    }
+
+    return NULL;
+}
+
+static void ele_mbox_close_all(void) {
+    for (unsigned int i = 0; i < ele_queue.depth; i++) {
+        ele_queue.backend.close(&ele_queue.backend, ele_queue.fds[i]);
+        ele_queue.fds[i] = -1;
+    }
+    ele_queue.depth = 0;
+}
+
+int ele_mbox_init(const ele_backend_t *backend, int allow_threads) {
+    unsigned int wanted = allow_threads ? ele_queue_requested_depth() : 1;
+
+    pthread_once(&ele_queue_atfork_once, ele_queue_register_atfork);
+
+    ele_queue.head = NULL;
+    ele_queue.tail = NULL;
+    ele_queue.stop = 0;
+    ele_queue.depth = 0;
+    ele_queue.threaded = 0;
+    ele_queue.backend = *backend;
+
+    // Real firmware does not speak the ele-sim protocol (see ele-mailbox.h)
+    if (!backend->sim_protocol) {
+        int fd = backend->open(backend);
+
+        if (fd < 0) {
+            fprintf(stderr, "ELE PKCS#11: Failed to open ELE %s %s: %s\n",
+                    backend->name, backend->target, strerror(-fd));
+            return -1;
+        }
+        backend->close(backend, fd);
+        fprintf(stderr, "ELE PKCS#11: %s is ELE firmware; enclave keys, signing and "
+                "random numbers are only implemented for ele-sim\n", backend->target);
+        return 0;
+    }
+
+    // The driver limits device contexts; use as many as it grants
+    for (unsigned int i = 0; i < wanted; i++) {
+        int fd = backend->open(backend);
+        if (fd < 0) {
+            if (i == 0) {
+                fprintf(stderr, "ELE PKCS#11: Failed to open ELE %s %s: %s\n",
+                        backend->name, backend->target, strerror(-fd));
+                return -1;
+            }
+            break;
+        }
+        ele_queue.fds[ele_queue.depth++] = fd;
+    }
+
+    if (!allow_threads) {
+        return 0;
+    }
+
+    for (unsigned int i = 0; i < ele_queue.depth; i++) {
+        if (pthread_create(&ele_queue.workers[i], NULL, ele_queue_worker,
+                           (void *)(uintptr_t)i) != 0) {
+            // Keep the workers that did start; close the unused contexts
+            for (unsigned int j = i; j < ele_queue.depth; j++) {
+                backend->close(backend, ele_queue.fds[j]);
+                ele_queue.fds[j] = -1;
+            }
+            ele_queue.depth = i;
+            break;
+        }
+    }
+
+    if (ele_queue.depth == 0) {
+        // No worker could start: reopen one context for synchronous use
+        int fd = backend->open(backend);
+        if (fd < 0) {
+            return -1;
+        }
+        ele_queue.fds[ele_queue.depth++] = fd;
+        return 0;
+    }
+
+    ele_queue.threaded = 1;
+    return 0;
+}
+
+void ele_mbox_shutdown(void) {
+    if (ele_queue.threaded) {
+        pthread_mutex_lock(&ele_queue.lock);
+        ele_queue.stop = 1;
+        pthread_cond_broadcast(&ele_queue.work);
+        pthread_mutex_unlock(&ele_queue.lock);
+
+        for (unsigned int i = 0; i < ele_queue.depth; i++) {
+            pthread_join(ele_queue.workers[i], NULL);
+        }
+        ele_queue.threaded = 0;
+    }
+
+    ele_mbox_close_all();
+}
+
+unsigned int ele_mbox_depth(void) {
+    return ele_queue.depth;
+}
+
+unsigned long ele_mbox_submitted(void) {
+    return __atomic_load_n(&ele_queue.submitted, __ATOMIC_RELAXED);
+}
+
+size_t ele_request_init(ele_request_t *req, uint8_t version, uint8_t command, size_t payload_words) {
+    memset(req->cmd, 0, sizeof(req->cmd));
+    req->cmd_words = 1 + payload_words;
+    req->rsp_words = 0;
+    req->cmd[0] = ((uint32_t)ELE_MSG_TAG_CMD << 24) |
+                  ((uint32_t)command << 16) |
+                  ((uint32_t)req->cmd_words << 8) |
+                  version;
+    return 1;
+}
+
+int ele_mbox_submit(ele_request_t *req) {
+    if (req->cmd_words == 0 || req->cmd_words > ELE_MSG_MAX_WORDS) {
+        return -EINVAL;
+    }
+
+    req->done = 0;
+    req->status = 0;
+    req->next = NULL;
+    __atomic_fetch_add(&ele_queue.submitted, 1, __ATOMIC_RELAXED);
+
+    if (!ele_queue.threaded) {
+        // Synchronous path: serialize callers on the single context
+        pthread_mutex_lock(&ele_queue.lock);
+        req->status = ele_queue.depth ? ele_transact(ele_queue.fds[0], req) : -ENODEV;
+        req->done = 1;
+        pthread_mutex_unlock(&ele_queue.lock);
+        return 0;
+    }
+
+    pthread_cond_init(&req->cond, NULL);
+
+    pthread_mutex_lock(&ele_queue.lock);
+    if (ele_queue.stop) {
+        pthread_mutex_unlock(&ele_queue.lock);
+        pthread_cond_destroy(&req->cond);
+        return -ESHUTDOWN;
+    }
+    if (ele_queue.tail != NULL) {
+        ele_queue.tail->next = req;
+    } else {
+        ele_queue.head = req;
+    }
+    ele_queue.tail = req;
+    pthread_cond_signal(&ele_queue.work);
+    pthread_mutex_unlock(&ele_queue.lock);
+
+    return 0;
+}
+
+int ele_mbox_wait(ele_request_t *req) {
+    int rv;
+
+    if (!ele_queue.threaded) {
+        return req->status;
+    }
+
+    pthread_mutex_lock(&ele_queue.lock);
+    while (!req->done) {
+        pthread_cond_wait(&req->cond, &ele_queue.lock);
+    }
+    rv = req->status;
+    pthread_mutex_unlock(&ele_queue.lock);
+
+    pthread_cond_destroy(&req->cond);
+    return rv;
+}
+
+int ele_mbox_call(ele_request_t *req) {
+    int rv = ele_mbox_submit(req);
+
+    return rv != 0 ? rv : ele_mbox_wait(req);
+}
+
+int ele_response_ok(const ele_request_t *req) {
+    return req->rsp_words >= 2 && (req->rsp[1] & 0xFF) == ELE_RSP_SUCCESS;
+}
+
+int ele_hsm_generate_key(unsigned int curve_bits, uint32_t lifetime, uint32_t *key_id,
+                         uint8_t *pub, size_t *pub_len) {
+    ele_request_t req;
+    size_t p = ele_request_init(&req, ELE_HSM_API_VER, ELE_CMD_KEY_GENERATE, 3);
+    size_t len;
+
+    req.cmd[p] = ELE_KEY_TYPE_ECC_NIST;
+    req.cmd[p + 1] = curve_bits;
+    req.cmd[p + 2] = lifetime;
+
+    if (ele_mbox_call(&req) != 0 || !ele_response_ok(&req) || req.rsp_words < 4) {
+        return -1;
+    }
+
+    // Response: status, key id, public key length, public key bytes
+    len = req.rsp[3];
+    if (len > ELE_MAX_PUBKEY_LEN || len > *pub_len ||
+        4 + (len + 3) / 4 > req.rsp_words) {
+        return -1;
+    }
+
+    *key_id = req.rsp[2];
+    memcpy(pub, &req.rsp[4], len);
+    *pub_len = len;
+    return 0;
+}
+
+int ele_hsm_delete_key(uint32_t key_id) {
+    ele_request_t req;
+    size_t p = ele_request_init(&req, ELE_HSM_API_VER, ELE_CMD_KEY_DELETE, 1);
+
+    req.cmd[p] = key_id;
+    return ele_mbox_call(&req) == 0 && ele_response_ok(&req) ? 0 : -1;
+}
+
+int ele_hsm_sign_digest(uint32_t key_id, const uint8_t *digest, size_t digest_len,
+                        uint8_t *sig, size_t *sig_len) {
+    ele_request_t req;
+    size_t p;
+    size_t len;
+
+    if (digest_len > 64) {
+        return -1;
+    }
+
+    // Payload: key id, scheme, digest length, digest bytes
+    p = ele_request_init(&req, ELE_HSM_API_VER, ELE_CMD_SIGN_GENERATE,
+                         3 + (digest_len + 3) / 4);
+    req.cmd[p] = key_id;
+    req.cmd[p + 1] = ELE_SIG_SCHEME_ECDSA;
+    req.cmd[p + 2] = (uint32_t)digest_len;
+    memcpy(&req.cmd[p + 3], digest, digest_len);
+
+    if (ele_mbox_call(&req) != 0 || !ele_response_ok(&req) || req.rsp_words < 3) {
+        return -1;
+    }
+
+    // Response: status, signature length, raw r||s bytes
+    len = req.rsp[2];
+    if (len > ELE_MAX_SIGNATURE_LEN || len > *sig_len ||
+        3 + (len + 3) / 4 > req.rsp_words) {
+        return -1;
+    }
+
+    memcpy(sig, &req.rsp[3], len);
+    *sig_len = len;
+    return 0;
+}
+
+int ele_hsm_get_random(uint8_t *buf, size_t len) {
+    ele_request_t req[ELE_QUEUE_BATCH];
+    int rv = 0;
+
+    /*
+     * Split into mailbox-sized chunks and keep up to ELE_QUEUE_BATCH of
+     * them in flight, so a large fill uses every device context.
+     */
+    while (len > 0 && rv == 0) {
+        unsigned int count = 0;
+        size_t chunk_len[ELE_QUEUE_BATCH];
+
+        for (; count < ELE_QUEUE_BATCH && len > 0; count++) {
+            size_t n = len < ELE_RNG_MAX_CHUNK ? len : ELE_RNG_MAX_CHUNK;
+            size_t p = ele_request_init(&req[count], ELE_HSM_API_VER, ELE_CMD_RNG_GET_RANDOM, 1);
+
+            req[count].cmd[p] = (uint32_t)n;
+            chunk_len[count] = n;
+            len -= n;
+
+            if (ele_mbox_submit(&req[count]) != 0) {
+                rv = -1;
+                break;
+            }
+        }
+
+        // Response: status, length, random bytes
+        for (unsigned int i = 0; i < count; i++) {
+            if (ele_mbox_wait(&req[i]) != 0 || !ele_response_ok(&req[i]) ||
+                req[i].rsp_words < 3 + (chunk_len[i] + 3) / 4 ||
+                req[i].rsp[2] != chunk_len[i]) {
+                rv = -1;
+                continue;
+            }
+            memcpy(buf, &req[i].rsp[3], chunk_len[i]);
+            buf += chunk_len[i];
+        }
+    }
+
+    // Random bytes must not linger in request buffers on the stack
+    explicit_bzero(req, sizeof(req));
+    return rv;
+}
+
+int ele_hsm_hash(uint32_t algo, const uint8_t *data, size_t len,
+                 uint8_t *digest, size_t *digest_len) {
+    ele_request_t req;
+    size_t p;
+    size_t n;
+
+    if (len > ELE_HASH_MAX_INLINE) {
+        return -1;
+    }
+
+    // Payload: algorithm, input length, input bytes
+    p = ele_request_init(&req, ELE_HSM_API_VER, ELE_CMD_HASH_ONE_GO, 2 + (len + 3) / 4);
+    req.cmd[p] = algo;
+    req.cmd[p + 1] = (uint32_t)len;
+    if (len > 0) {
+        memcpy(&req.cmd[p + 2], data, len);
+    }
+
+    if (ele_mbox_call(&req) != 0 || !ele_response_ok(&req) || req.rsp_words < 3) {
+        return -1;
+    }
+
+    // Response: status, digest length, digest bytes
+    n = req.rsp[2];
+    if (n > *digest_len || 3 + (n + 3) / 4 > req.rsp_words) {
+        return -1;
+    }
+
+    memcpy(digest, &req.rsp[3], n);
+    *digest_len = n;
+    return 0;
+}
+
+int ele_hsm_verify_digest(const uint8_t *pub, size_t pub_len,
+                          const uint8_t *digest, size_t digest_len,
+                          const uint8_t *sig, size_t sig_len) {
+    ele_request_t req;
+    size_t pub_words = (pub_len + 3) / 4;
+    size_t sig_words = (sig_len + 3) / 4;
+    size_t digest_words = (digest_len + 3) / 4;
+    size_t p;
+
+    if (pub_len > ELE_MAX_PUBKEY_LEN || sig_len > ELE_MAX_SIGNATURE_LEN || digest_len > 64 ||
+        1 + 4 + pub_words + sig_words + digest_words > ELE_MSG_MAX_WORDS) {
+        return -1;
+    }
+
+    // Payload: scheme, lengths, then public key, signature and digest, each word aligned
+    p = ele_request_init(&req, ELE_HSM_API_VER, ELE_CMD_SIGN_VERIFY,
+                         4 + pub_words + sig_words + digest_words);
+    req.cmd[p] = ELE_SIG_SCHEME_ECDSA;
+    req.cmd[p + 1] = (uint32_t)pub_len;
+    req.cmd[p + 2] = (uint32_t)sig_len;
+    req.cmd[p + 3] = (uint32_t)digest_len;
+    p += 4;
+    memcpy(&req.cmd[p], pub, pub_len);
+    p += pub_words;
+    memcpy(&req.cmd[p], sig, sig_len);
+    p += sig_words;
+    memcpy(&req.cmd[p], digest, digest_len);
+
+    // Response: status, verification result
+    if (ele_mbox_call(&req) != 0 || !ele_response_ok(&req) || req.rsp_words < 3) {
+        return -1;
+    }
+
+    return req.rsp[2] == ELE_VERIFY_SUCCESS;
+}
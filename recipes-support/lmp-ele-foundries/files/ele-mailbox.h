@@ -0,0 +1,118 @@
+/*
+ * ELE mailbox command queue for the i.MX93 EdgeLock Enclave PKCS#11 module
+ *
+ * Messages follow the ELE mailbox framing; the framing and command
+ * constants come from ele-proto.h (libeleprobe), shared with the test
+ * suite and the probe.
+ *
+ * Requests are submitted to a queue served by one worker per ELE device
+ * context, so several commands can be outstanding in the kernel driver
+ * at once instead of every caller doing its own blocking round trip.
+ *
+ * SIMULATOR ONLY, UNVERIFIED ON HARDWARE: the HSM commands and payload
+ * layouts in ele-proto.h are the ele-sim protocol, not NXP's. Real firmware needs
+ * a session, a key store and a key management service to be opened
+ * first, takes its buffers through SE_IOCTL_SETUP_IOBUF rather than
+ * inline, and assigns some of these command ids other meanings (0x73 is
+ * signature-prepare, not verify). A production HSM path has to go through
+ * NXP's secure_enclave library (libele_hsm); until it does, ele_mbox_init()
+ * opens no contexts on a real ELE device and every ele_hsm_*() call fails.
+ */
+
+#ifndef ELE_MAILBOX_H
+#define ELE_MAILBOX_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <pthread.h>
+
+#include <ele-proto.h>
+
+#include "ele-backend.h"
+
+// Largest public key / signature carried inline (P-521 sized)
+#define ELE_MAX_PUBKEY_LEN      133
+#define ELE_MAX_SIGNATURE_LEN   132
+
+// Random bytes returned per ELE_CMD_RNG_GET_RANDOM request
+#define ELE_RNG_MAX_CHUNK       240
+
+// Largest input ELE_CMD_HASH_ONE_GO carries inline (header, algorithm, length)
+#define ELE_HASH_MAX_INLINE     ((ELE_MSG_MAX_WORDS - 3) * 4)
+
+// Default number of device contexts (and so requests in flight)
+#define ELE_QUEUE_DEFAULT_DEPTH 4
+#define ELE_QUEUE_MAX_DEPTH     16
+
+// Requests ele_hsm_get_random() keeps in flight at once
+#define ELE_QUEUE_BATCH         8
+
+typedef struct ele_request {
+    uint32_t cmd[ELE_MSG_MAX_WORDS];
+    size_t cmd_words;
+    uint32_t rsp[ELE_MSG_MAX_WORDS];
+    size_t rsp_words;
+
+    // Completion, owned by the queue
+    int status;
+    int done;
+    pthread_cond_t cond;
+    struct ele_request *next;
+} ele_request_t;
+
+/*
+ * Open the ELE device contexts through the backend and start the queue
+ * workers. With allow_threads == 0 (CKF_LIBRARY_CANT_CREATE_OS_THREADS) a
+ * single context is opened and requests run synchronously in the caller.
+ * A backend without sim_protocol is only checked for presence: no
+ * context is kept and ele_mbox_depth() stays 0.
+ */
+int ele_mbox_init(const ele_backend_t *backend, int allow_threads);
+void ele_mbox_shutdown(void);
+
+// Number of device contexts actually opened (0: no HSM requests possible)
+unsigned int ele_mbox_depth(void);
+
+// Requests submitted so far, for spotting an idle mailbox
+unsigned long ele_mbox_submitted(void);
+
+/*
+ * Prepare a request: header plus payload words. Returns the index of the
+ * first payload word for the caller to fill.
+ */
+size_t ele_request_init(ele_request_t *req, uint8_t version, uint8_t command, size_t payload_words);
+
+// Submit and wait for completion; returns 0 on transport success
+int ele_mbox_call(ele_request_t *req);
+
+/*
+ * Split form of ele_mbox_call() for keeping several requests of one
+ * caller in flight: every successful submit must be waited for.
+ */
+int ele_mbox_submit(ele_request_t *req);
+int ele_mbox_wait(ele_request_t *req);
+
+// Response status word check (after a successful ele_mbox_call)
+int ele_response_ok(const ele_request_t *req);
+
+// High-level HSM operations built on the queue
+int ele_hsm_generate_key(unsigned int curve_bits, uint32_t lifetime, uint32_t *key_id,
+                         uint8_t *pub, size_t *pub_len);
+int ele_hsm_delete_key(uint32_t key_id);
+int ele_hsm_sign_digest(uint32_t key_id, const uint8_t *digest, size_t digest_len,
+                        uint8_t *sig, size_t *sig_len);
+int ele_hsm_get_random(uint8_t *buf, size_t len);
+
+// One-shot digest of at most ELE_HASH_MAX_INLINE bytes
+int ele_hsm_hash(uint32_t algo, const uint8_t *data, size_t len,
+                 uint8_t *digest, size_t *digest_len);
+
+/*
+ * Verify a raw r || s ECDSA signature over a digest with a caller-supplied
+ * public key (X || Y). Returns 1 if valid, 0 if not, -1 on a mailbox error.
+ */
+int ele_hsm_verify_digest(const uint8_t *pub, size_t pub_len,
+                          const uint8_t *digest, size_t digest_len,
+                          const uint8_t *sig, size_t sig_len);
+
+#endif /* ELE_MAILBOX_H */
@@ -0,0 +1,1148 @@
+/*
+ * Object store for the ELE PKCS#11 module
+ *
+ * Objects live in a handle-indexed array (handle = slot + 1) and are also
+ * chained into three hash indexes keyed by CKA_ID, CKA_LABEL and
+ * CKA_CLASS. C_FindObjectsInit walks only the bucket of the most
+ * selective attribute in the template, then checks the rest of the
+ * template against each candidate.
+ *
+ * Token objects are persisted in a cache file of fixed-layout records:
+ *
+ *   header  { magic "ELEOBJC1", version, record count }
+ *   record  { length, class, uid, key id, curve, id/label/value lengths }
+ *           followed by id, label and value bytes, padded to 8 bytes
+ *
+ * At start-up the file is mapped read-only and cached objects point
+ * straight into the mapping. Updates are applied under an flock() to the
+ * on-disk state (not this process's view) and published with rename(), so
+ * concurrent processes do not lose each other's records and the existing
+ * mapping stays valid. The file is written and synced after the store
+ * lock is dropped; writers take a ticket under the lock so their updates
+ * still reach the disk in the order they were applied in memory. When a
+ * stat() on the find path shows the file changed, records another process
+ * added are copied in and cached objects whose records are gone dropped.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <pthread.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/random.h>
+#include <sys/stat.h>
+#include <time.h>
+
+#include "ele-mailbox.h"
+#include "ele-objects.h"
+
+#define ELE_CACHE_MAGIC         "ELEOBJC1"
+#define ELE_CACHE_VERSION       1
+#define ELE_INDEX_BUCKETS       128
+
+enum { ELE_INDEX_ID, ELE_INDEX_LABEL, ELE_INDEX_CLASS, ELE_INDEX_COUNT };
+
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t count;
+} ele_cache_header_t;
+
+typedef struct {
+    uint32_t record_len;
+    uint32_t cls;
+    uint64_t uid;
+    uint32_t key_id;
+    uint32_t curve;
+    uint32_t id_len;
+    uint32_t label_len;
+    uint32_t value_len;
+    uint32_t reserved;
+} ele_cache_record_t;
+
+typedef struct ele_object {
+    CK_OBJECT_HANDLE handle;
+    uint64_t uid;                    // cache record identity
+    CK_OBJECT_CLASS cls;
+    CK_BBOOL token;
+    CK_SESSION_HANDLE session;       // owner of session objects
+    uint32_t key_id;                 // enclave key (key objects)
+    unsigned int curve;
+    CK_BYTE id[ELE_OBJECT_MAX_ID];
+    CK_ULONG id_len;
+    char label[ELE_OBJECT_MAX_LABEL];
+    CK_ULONG label_len;
+    const CK_BYTE *value;            // DER EC point or certificate
+    CK_ULONG value_len;
+    CK_BYTE *value_owned;            // heap copy, NULL if value is in a cache map
+    unsigned int load_gen;           // last cache load that saw this record
+    struct ele_object *next[ELE_INDEX_COUNT];
+} ele_object_t;
+
+static struct {
+    pthread_rwlock_t lock;
+    ele_object_t **objects;
+    CK_ULONG capacity;
+    ele_object_t *index[ELE_INDEX_COUNT][ELE_INDEX_BUCKETS];
+    char cache_path[256];
+    struct stat cache_stat;          // identity of the last loaded file
+    void *map;                       // start-up mapping of the cache file
+    size_t map_len;
+    unsigned int load_gen;           // stamp of the load in progress
+    pthread_mutex_t write_lock;      // guards the two tickets below
+    pthread_cond_t write_turn;
+    uint64_t write_next;             // next ticket (also under the store lock)
+    uint64_t write_done;             // tickets written to disk
+} ele_store = {
+    .lock = PTHREAD_RWLOCK_INITIALIZER,
+    .write_lock = PTHREAD_MUTEX_INITIALIZER,
+    .write_turn = PTHREAD_COND_INITIALIZER,
+};
+
+// A cache file update, captured under the store lock and written after it
+typedef struct {
+    uint64_t ticket;
+    char *records;                   // serialized records to append
+    size_t records_len;
+    unsigned int add_count;
+    uint64_t remove_uid;
+} ele_cache_change_t;
+
+// DER-encoded named curve OIDs used for CKA_EC_PARAMS
+static const CK_BYTE ele_oid_p256[] = { 0x06, 0x08, 0x2A, 0x86, 0x48, 0xCE, 0x3D, 0x03, 0x01, 0x07 };
+static const CK_BYTE ele_oid_p384[] = { 0x06, 0x05, 0x2B, 0x81, 0x04, 0x00, 0x22 };
+
+unsigned int ele_curve_bits(unsigned int curve) {
+    return curve == ELE_CURVE_P384 ? 384 : 256;
+}
+
+const CK_BYTE *ele_curve_oid(unsigned int curve, CK_ULONG *len) {
+    if (curve == ELE_CURVE_P384) {
+        *len = sizeof(ele_oid_p384);
+        return ele_oid_p384;
+    }
+    *len = sizeof(ele_oid_p256);
+    return ele_oid_p256;
+}
+
+// FNV-1a
+static unsigned int ele_hash(const void *data, size_t len) {
+    const uint8_t *p = data;
+    uint32_t h = 2166136261u;
+
+    while (len--) {
+        h ^= *p++;
+        h *= 16777619u;
+    }
+
+    return h % ELE_INDEX_BUCKETS;
+}
+
+static unsigned int ele_object_bucket(const ele_object_t *obj, int index) {
+    switch (index) {
+        case ELE_INDEX_ID: return ele_hash(obj->id, obj->id_len);
+        case ELE_INDEX_LABEL: return ele_hash(obj->label, obj->label_len);
+        default: return ele_hash(&obj->cls, sizeof(obj->cls));
+    }
+}
+
+static void ele_index_insert(ele_object_t *obj) {
+    for (int i = 0; i < ELE_INDEX_COUNT; i++) {
+        unsigned int b = ele_object_bucket(obj, i);
+        obj->next[i] = ele_store.index[i][b];
+        ele_store.index[i][b] = obj;
+    }
+}
+
+static void ele_index_remove(ele_object_t *obj) {
+    for (int i = 0; i < ELE_INDEX_COUNT; i++) {
+        ele_object_t **pp = &ele_store.index[i][ele_object_bucket(obj, i)];
+        while (*pp != NULL && *pp != obj) {
+            pp = &(*pp)->next[i];
+        }
+        if (*pp == obj) {
+            *pp = obj->next[i];
+        }
+    }
+}
+
+// Place an object in the handle table and the indexes (write lock held)
+static CK_RV ele_store_insert(ele_object_t *obj) {
+    CK_ULONG slot;
+
+    for (slot = 0; slot < ele_store.capacity; slot++) {
+        if (ele_store.objects[slot] == NULL) {
+            break;
+        }
+    }
+
+    if (slot == ele_store.capacity) {
+        CK_ULONG capacity = ele_store.capacity ? ele_store.capacity * 2 : 32;
+        ele_object_t **objects = realloc(ele_store.objects, capacity * sizeof(*objects));
+        if (objects == NULL) {
+            return CKR_HOST_MEMORY;
+        }
+        memset(objects + ele_store.capacity, 0,
+               (capacity - ele_store.capacity) * sizeof(*objects));
+        ele_store.objects = objects;
+        ele_store.capacity = capacity;
+    }
+
+    obj->handle = slot + 1;
+    ele_store.objects[slot] = obj;
+    ele_index_insert(obj);
+    return CKR_OK;
+}
+
+static void ele_object_free(ele_object_t *obj) {
+    free(obj->value_owned);
+    free(obj);
+}
+
+static void ele_store_remove(ele_object_t *obj) {
+    ele_index_remove(obj);
+    ele_store.objects[obj->handle - 1] = NULL;
+    ele_object_free(obj);
+}
+
+static ele_object_t *ele_store_lookup(CK_OBJECT_HANDLE handle) {
+    if (handle == 0 || handle > ele_store.capacity) {
+        return NULL;
+    }
+    return ele_store.objects[handle - 1];
+}
+
+// A record's CKA_ID never changes, so its object is in that ID bucket
+static ele_object_t *ele_store_find_uid(uint64_t uid, const CK_BYTE *id, size_t id_len) {
+    ele_object_t *obj = ele_store.index[ELE_INDEX_ID][ele_hash(id, id_len)];
+
+    while (obj != NULL && obj->uid != uid) {
+        obj = obj->next[ELE_INDEX_ID];
+    }
+    return obj;
+}
+
+static uint64_t ele_new_uid(void) {
+    static uint64_t counter;
+    uint64_t uid;
+
+    if (getrandom(&uid, sizeof(uid), 0) != sizeof(uid)) {
+        uid = ((uint64_t)getpid() << 32) ^ (uint64_t)time(NULL) ^ ++counter;
+    }
+
+    return uid ? uid : 1;
+}
+
+/* Persistent cache */
+
+static size_t ele_record_size(size_t id_len, size_t label_len, size_t value_len) {
+    return (sizeof(ele_cache_record_t) + id_len + label_len + value_len + 7) & ~(size_t)7;
+}
+
+/*
+ * Walk the records of a mapped cache image; calls fn for each valid one
+ * and stops at the first malformed record. Returns 0 if every record the
+ * header announces was walked, -1 otherwise.
+ */
+static int ele_cache_walk(const uint8_t *data, size_t len,
+                           void (*fn)(const ele_cache_record_t *rec, void *arg), void *arg) {
+    const ele_cache_header_t *hdr = (const ele_cache_header_t *)data;
+    size_t off = sizeof(*hdr);
+
+    if (len < sizeof(*hdr) || memcmp(hdr->magic, ELE_CACHE_MAGIC, sizeof(hdr->magic)) != 0 ||
+        hdr->version != ELE_CACHE_VERSION) {
+        return -1;
+    }
+
+    for (uint32_t i = 0; i < hdr->count; i++) {
+        const ele_cache_record_t *rec = (const ele_cache_record_t *)(data + off);
+
+        if (len - off < sizeof(*rec) ||
+            rec->id_len > ELE_OBJECT_MAX_ID || rec->label_len > ELE_OBJECT_MAX_LABEL ||
+            rec->value_len > len ||
+            rec->record_len != ele_record_size(rec->id_len, rec->label_len, rec->value_len) ||
+            rec->record_len > len - off) {
+            return -1;
+        }
+
+        fn(rec, arg);
+        off += rec->record_len;
+    }
+    return 0;
+}
+
+static void ele_cache_load_record(const ele_cache_record_t *rec, void *arg) {
+    const uint8_t *data = (const uint8_t *)(rec + 1);
+    int copy_value = arg != NULL;
+    ele_object_t *obj;
+
+    obj = ele_store_find_uid(rec->uid, data, rec->id_len);
+    if (obj != NULL) {
+        obj->load_gen = ele_store.load_gen;
+        return;
+    }
+
+    obj = calloc(1, sizeof(*obj));
+    if (obj == NULL) {
+        return;
+    }
+
+    obj->uid = rec->uid;
+    obj->cls = rec->cls;
+    obj->token = CK_TRUE;
+    obj->key_id = rec->key_id;
+    obj->curve = rec->curve;
+    obj->id_len = rec->id_len;
+    memcpy(obj->id, data, rec->id_len);
+    obj->label_len = rec->label_len;
+    memcpy(obj->label, data + rec->id_len, rec->label_len);
+    obj->value = data + rec->id_len + rec->label_len;
+    obj->value_len = rec->value_len;
+    obj->load_gen = ele_store.load_gen;
+
+    // Values from a transient image must outlive it
+    if (copy_value && obj->value_len > 0) {
+        obj->value_owned = malloc(obj->value_len);
+        if (obj->value_owned == NULL) {
+            free(obj);
+            return;
+        }
+        memcpy(obj->value_owned, obj->value, obj->value_len);
+        obj->value = obj->value_owned;
+    }
+
+    if (ele_store_insert(obj) != CKR_OK) {
+        ele_object_free(obj);
+    }
+}
+
+static int ele_cache_same_file(const struct stat *a, const struct stat *b) {
+    return a->st_ino == b->st_ino && a->st_dev == b->st_dev && a->st_size == b->st_size &&
+           a->st_mtim.tv_sec == b->st_mtim.tv_sec && a->st_mtim.tv_nsec == b->st_mtim.tv_nsec;
+}
+
+// Drop token objects the last complete load did not see (write lock held)
+static void ele_cache_prune(void) {
+    for (CK_ULONG i = 0; i < ele_store.capacity; i++) {
+        ele_object_t *obj = ele_store.objects[i];
+
+        if (obj != NULL && obj->token && obj->load_gen != ele_store.load_gen) {
+            ele_store_remove(obj);
+        }
+    }
+}
+
+/*
+ * Load the cache file if it changed since the last load (write lock
+ * held). The first load keeps the mapping and references it in place;
+ * later loads add unknown records, copying their values, and drop
+ * objects whose records are gone.
+ */
+static void ele_cache_refresh(void) {
+    struct stat st;
+    void *addr;
+    int complete;
+    int busy;
+    int fd;
+
+    // The file does not have our in-flight updates yet; the next find retries
+    pthread_mutex_lock(&ele_store.write_lock);
+    busy = ele_store.write_next != ele_store.write_done;
+    pthread_mutex_unlock(&ele_store.write_lock);
+    if (busy) {
+        return;
+    }
+
+    fd = open(ele_store.cache_path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return;
+    }
+
+    if (fstat(fd, &st) != 0 || ele_cache_same_file(&st, &ele_store.cache_stat) ||
+        st.st_size < (off_t)sizeof(ele_cache_header_t)) {
+        close(fd);
+        return;
+    }
+
+    addr = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (addr == MAP_FAILED) {
+        return;
+    }
+
+    ele_store.cache_stat = st;
+    ele_store.load_gen++;
+
+    if (ele_store.map == NULL) {
+        ele_store.map = addr;
+        ele_store.map_len = (size_t)st.st_size;
+        complete = ele_cache_walk(addr, (size_t)st.st_size, ele_cache_load_record, NULL) == 0;
+    } else {
+        complete = ele_cache_walk(addr, (size_t)st.st_size, ele_cache_load_record, &ele_store) == 0;
+        munmap(addr, (size_t)st.st_size);
+    }
+
+    // A truncated image says nothing about the records after the damage
+    if (complete) {
+        ele_cache_prune();
+    }
+}
+
+// Cheap check used before taking the write lock on the find path
+static int ele_cache_stale(void) {
+    struct stat st;
+    int stale;
+
+    if (stat(ele_store.cache_path, &st) != 0) {
+        return 0;
+    }
+
+    pthread_rwlock_rdlock(&ele_store.lock);
+    stale = !ele_cache_same_file(&st, &ele_store.cache_stat);
+    pthread_rwlock_unlock(&ele_store.lock);
+
+    return stale;
+}
+
+typedef struct {
+    FILE *out;
+    uint64_t remove_uid;
+    uint32_t count;
+} ele_cache_copy_t;
+
+static int ele_cache_write_record(FILE *out, const ele_object_t *obj) {
+    static const uint8_t pad[8];
+    ele_cache_record_t rec;
+    size_t raw;
+
+    memset(&rec, 0, sizeof(rec));
+    rec.record_len = (uint32_t)ele_record_size(obj->id_len, obj->label_len, obj->value_len);
+    rec.cls = (uint32_t)obj->cls;
+    rec.uid = obj->uid;
+    rec.key_id = obj->key_id;
+    rec.curve = obj->curve;
+    rec.id_len = (uint32_t)obj->id_len;
+    rec.label_len = (uint32_t)obj->label_len;
+    rec.value_len = (uint32_t)obj->value_len;
+    raw = sizeof(rec) + obj->id_len + obj->label_len + obj->value_len;
+
+    if (fwrite(&rec, sizeof(rec), 1, out) != 1 ||
+        fwrite(obj->id, 1, obj->id_len, out) != obj->id_len ||
+        fwrite(obj->label, 1, obj->label_len, out) != obj->label_len ||
+        fwrite(obj->value, 1, obj->value_len, out) != obj->value_len ||
+        fwrite(pad, 1, rec.record_len - raw, out) != rec.record_len - raw) {
+        return -1;
+    }
+
+    return 0;
+}
+
+static void ele_cache_copy_record(const ele_cache_record_t *rec, void *arg) {
+    ele_cache_copy_t *copy = arg;
+
+    if (rec->uid == copy->remove_uid) {
+        return;
+    }
+
+    if (fwrite(rec, rec->record_len, 1, copy->out) == 1) {
+        copy->count++;
+    }
+}
+
+static void ele_cache_make_dir(const char *path) {
+    char dir[sizeof(ele_store.cache_path)];
+    char *slash;
+
+    snprintf(dir, sizeof(dir), "%s", path);
+    slash = strrchr(dir, '/');
+    if (slash != NULL && slash != dir) {
+        *slash = '\0';
+        mkdir(dir, 0700);
+    }
+}
+
+/*
+ * Capture a cache change under the store write lock: serialize the added
+ * objects and take a write ticket. Every successful prepare must be
+ * followed by ele_cache_commit() once the lock is dropped.
+ */
+static int ele_cache_prepare(ele_cache_change_t *chg, ele_object_t *const *add,
+                             unsigned int add_count, uint64_t remove_uid) {
+    memset(chg, 0, sizeof(*chg));
+    chg->add_count = add_count;
+    chg->remove_uid = remove_uid;
+
+    if (add_count > 0) {
+        FILE *out = open_memstream(&chg->records, &chg->records_len);
+        int ok = out != NULL;
+
+        for (unsigned int i = 0; ok && i < add_count; i++) {
+            ok = ele_cache_write_record(out, add[i]) == 0;
+        }
+        if (out != NULL && fclose(out) != 0) {
+            ok = 0;
+        }
+        if (!ok) {
+            fprintf(stderr, "ELE PKCS#11: Failed to update object cache %s\n", ele_store.cache_path);
+            free(chg->records);
+            return -1;
+        }
+    }
+
+    pthread_mutex_lock(&ele_store.write_lock);
+    chg->ticket = ele_store.write_next++;
+    pthread_mutex_unlock(&ele_store.write_lock);
+    return 0;
+}
+
+/*
+ * Apply a prepared change to the on-disk cache (store lock not held):
+ * copy the current records except remove_uid, append the added ones, and
+ * atomically replace the file.
+ */
+static void ele_cache_write(const ele_cache_change_t *chg) {
+    char lock_path[sizeof(ele_store.cache_path) + 8];
+    char tmp_path[sizeof(ele_store.cache_path) + 32];
+    ele_cache_header_t hdr;
+    ele_cache_copy_t copy;
+    uint8_t *current = NULL;
+    struct stat st;
+    int lock_fd;
+    int fd;
+
+    ele_cache_make_dir(ele_store.cache_path);
+
+    snprintf(lock_path, sizeof(lock_path), "%s.lock", ele_store.cache_path);
+    lock_fd = open(lock_path, O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+    if (lock_fd < 0 || flock(lock_fd, LOCK_EX) != 0) {
+        fprintf(stderr, "ELE PKCS#11: Cannot lock object cache: %s\n", strerror(errno));
+        if (lock_fd >= 0) {
+            close(lock_fd);
+        }
+        return;
+    }
+
+    // Current on-disk state, which may include other processes' records
+    fd = open(ele_store.cache_path, O_RDONLY | O_CLOEXEC);
+    if (fd >= 0) {
+        if (fstat(fd, &st) == 0 && st.st_size > 0) {
+            current = malloc((size_t)st.st_size);
+            if (current != NULL && pread(fd, current, (size_t)st.st_size, 0) != st.st_size) {
+                free(current);
+                current = NULL;
+            }
+        }
+        close(fd);
+    }
+
+    snprintf(tmp_path, sizeof(tmp_path), "%s.tmp.%d", ele_store.cache_path, (int)getpid());
+    copy.out = fopen(tmp_path, "wb");
+    copy.remove_uid = chg->remove_uid;
+    copy.count = 0;
+
+    if (copy.out != NULL) {
+        int ok;
+
+        memset(&hdr, 0, sizeof(hdr));
+        memcpy(hdr.magic, ELE_CACHE_MAGIC, sizeof(hdr.magic));
+        hdr.version = ELE_CACHE_VERSION;
+        ok = fwrite(&hdr, sizeof(hdr), 1, copy.out) == 1;
+
+        if (current != NULL) {
+            ele_cache_walk(current, (size_t)st.st_size, ele_cache_copy_record, &copy);
+        }
+
+        if (ok && chg->records_len > 0) {
+            ok = fwrite(chg->records, chg->records_len, 1, copy.out) == 1;
+            copy.count += chg->add_count;
+        }
+
+        // Patch the record count now that it is known
+        hdr.count = copy.count;
+        ok = ok && fseek(copy.out, 0, SEEK_SET) == 0 &&
+             fwrite(&hdr, sizeof(hdr), 1, copy.out) == 1 &&
+             fflush(copy.out) == 0 && fsync(fileno(copy.out)) == 0;
+
+        if (fclose(copy.out) != 0 || !ok || rename(tmp_path, ele_store.cache_path) != 0) {
+            fprintf(stderr, "ELE PKCS#11: Failed to update object cache %s\n", ele_store.cache_path);
+            unlink(tmp_path);
+        }
+    }
+
+    free(current);
+    flock(lock_fd, LOCK_UN);
+    close(lock_fd);
+}
+
+// Write a prepared change once every earlier ticket has been written
+static void ele_cache_commit(ele_cache_change_t *chg) {
+    pthread_mutex_lock(&ele_store.write_lock);
+    while (ele_store.write_done != chg->ticket) {
+        pthread_cond_wait(&ele_store.write_turn, &ele_store.write_lock);
+    }
+    pthread_mutex_unlock(&ele_store.write_lock);
+
+    ele_cache_write(chg);
+    free(chg->records);
+
+    pthread_mutex_lock(&ele_store.write_lock);
+    ele_store.write_done++;
+    pthread_cond_broadcast(&ele_store.write_turn);
+    pthread_mutex_unlock(&ele_store.write_lock);
+}
+
+/* Attribute access */
+
+typedef union {
+    CK_ULONG ul;
+    CK_BBOOL b;
+} ele_attr_scratch_t;
+
+/*
+ * Resolve one attribute of an object to a value pointer and length.
+ * Booleans and ULONGs are materialized in the caller's scratch space.
+ */
+static CK_RV ele_object_attr(const ele_object_t *obj, CK_ATTRIBUTE_TYPE type,
+                             ele_attr_scratch_t *tmp, const void **val, CK_ULONG *len) {
+    int is_key = obj->cls == CKO_PUBLIC_KEY || obj->cls == CKO_PRIVATE_KEY;
+    int is_priv = obj->cls == CKO_PRIVATE_KEY;
+
+    *len = sizeof(CK_BBOOL);
+    *val = &tmp->b;
+
+    switch (type) {
+        case CKA_CLASS:
+            tmp->ul = obj->cls;
+            *val = &tmp->ul;
+            *len = sizeof(CK_ULONG);
+            return CKR_OK;
+        case CKA_TOKEN:
+            tmp->b = obj->token;
+            return CKR_OK;
+        case CKA_PRIVATE:
+            tmp->b = is_priv ? CK_TRUE : CK_FALSE;
+            return CKR_OK;
+        case CKA_ID:
+            *val = obj->id;
+            *len = obj->id_len;
+            return CKR_OK;
+        case CKA_LABEL:
+            *val = obj->label;
+            *len = obj->label_len;
+            return CKR_OK;
+        default:
+            break;
+    }
+
+    if (obj->cls == CKO_CERTIFICATE) {
+        switch (type) {
+            case CKA_CERTIFICATE_TYPE:
+                tmp->ul = CKC_X_509;
+                *val = &tmp->ul;
+                *len = sizeof(CK_ULONG);
+                return CKR_OK;
+            case CKA_VALUE:
+                *val = obj->value;
+                *len = obj->value_len;
+                return CKR_OK;
+            default:
+                return CKR_ATTRIBUTE_TYPE_INVALID;
+        }
+    }
+
+    if (!is_key) {
+        return CKR_ATTRIBUTE_TYPE_INVALID;
+    }
+
+    switch (type) {
+        case CKA_KEY_TYPE:
+            tmp->ul = CKK_EC;
+            *val = &tmp->ul;
+            *len = sizeof(CK_ULONG);
+            return CKR_OK;
+        case CKA_EC_PARAMS:
+            *val = ele_curve_oid(obj->curve, len);
+            return CKR_OK;
+        case CKA_LOCAL:
+            tmp->b = CK_TRUE;
+            return CKR_OK;
+        case CKA_EC_POINT:
+            if (is_priv) {
+                return CKR_ATTRIBUTE_TYPE_INVALID;
+            }
+            *val = obj->value;
+            *len = obj->value_len;
+            return CKR_OK;
+        case CKA_VERIFY:
+            tmp->b = is_priv ? CK_FALSE : CK_TRUE;
+            return CKR_OK;
+        case CKA_SIGN:
+        case CKA_SENSITIVE:
+        case CKA_ALWAYS_SENSITIVE:
+        case CKA_NEVER_EXTRACTABLE:
+            tmp->b = is_priv ? CK_TRUE : CK_FALSE;
+            return CKR_OK;
+        case CKA_EXTRACTABLE:
+            tmp->b = CK_FALSE;
+            return CKR_OK;
+        case CKA_VALUE:
+            return is_priv ? CKR_ATTRIBUTE_SENSITIVE : CKR_ATTRIBUTE_TYPE_INVALID;
+        default:
+            return CKR_ATTRIBUTE_TYPE_INVALID;
+    }
+}
+
+static int ele_object_matches(const ele_object_t *obj, const CK_ATTRIBUTE *tmpl, CK_ULONG count) {
+    for (CK_ULONG i = 0; i < count; i++) {
+        ele_attr_scratch_t tmp;
+        const void *val;
+        CK_ULONG len;
+
+        if (ele_object_attr(obj, tmpl[i].type, &tmp, &val, &len) != CKR_OK ||
+            len != tmpl[i].ulValueLen ||
+            (len > 0 && memcmp(val, tmpl[i].pValue, len) != 0)) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/* Public interface */
+
+CK_RV ele_objects_init(void) {
+    const char *path = getenv("ELE_PKCS11_CACHE");
+
+    pthread_rwlock_wrlock(&ele_store.lock);
+
+    snprintf(ele_store.cache_path, sizeof(ele_store.cache_path), "%s",
+             path != NULL && *path != '\0' ? path : ELE_OBJECTS_CACHE_PATH);
+    memset(&ele_store.cache_stat, 0, sizeof(ele_store.cache_stat));
+    ele_cache_refresh();
+
+    pthread_rwlock_unlock(&ele_store.lock);
+    return CKR_OK;
+}
+
+void ele_objects_shutdown(void) {
+    pthread_rwlock_wrlock(&ele_store.lock);
+
+    for (CK_ULONG i = 0; i < ele_store.capacity; i++) {
+        if (ele_store.objects[i] != NULL) {
+            ele_object_free(ele_store.objects[i]);
+        }
+    }
+    free(ele_store.objects);
+    ele_store.objects = NULL;
+    ele_store.capacity = 0;
+    memset(ele_store.index, 0, sizeof(ele_store.index));
+
+    if (ele_store.map != NULL) {
+        munmap(ele_store.map, ele_store.map_len);
+        ele_store.map = NULL;
+        ele_store.map_len = 0;
+    }
+
+    pthread_rwlock_unlock(&ele_store.lock);
+}
+
+CK_RV ele_objects_parse_attrs(CK_ATTRIBUTE *tmpl, CK_ULONG count, ele_object_attrs_t *attrs) {
+    memset(attrs, 0, sizeof(*attrs));
+
+    for (CK_ULONG i = 0; i < count; i++) {
+        switch (tmpl[i].type) {
+            case CKA_ID:
+                if (tmpl[i].ulValueLen > ELE_OBJECT_MAX_ID) {
+                    return CKR_ATTRIBUTE_VALUE_INVALID;
+                }
+                memcpy(attrs->id, tmpl[i].pValue, tmpl[i].ulValueLen);
+                attrs->id_len = tmpl[i].ulValueLen;
+                break;
+            case CKA_LABEL:
+                if (tmpl[i].ulValueLen > ELE_OBJECT_MAX_LABEL) {
+                    return CKR_ATTRIBUTE_VALUE_INVALID;
+                }
+                memcpy(attrs->label, tmpl[i].pValue, tmpl[i].ulValueLen);
+                attrs->label_len = tmpl[i].ulValueLen;
+                break;
+            case CKA_TOKEN:
+                if (tmpl[i].ulValueLen != sizeof(CK_BBOOL)) {
+                    return CKR_ATTRIBUTE_VALUE_INVALID;
+                }
+                attrs->token = *(CK_BBOOL *)tmpl[i].pValue ? CK_TRUE : CK_FALSE;
+                break;
+            default:
+                break;
+        }
+    }
+
+    return CKR_OK;
+}
+
+static ele_object_t *ele_object_new(CK_OBJECT_CLASS cls, const ele_object_attrs_t *attrs,
+                                    CK_SESSION_HANDLE session) {
+    ele_object_t *obj = calloc(1, sizeof(*obj));
+
+    if (obj == NULL) {
+        return NULL;
+    }
+
+    obj->uid = ele_new_uid();
+    obj->cls = cls;
+    obj->token = attrs->token;
+    obj->session = attrs->token ? 0 : session;
+    memcpy(obj->id, attrs->id, attrs->id_len);
+    obj->id_len = attrs->id_len;
+    memcpy(obj->label, attrs->label, attrs->label_len);
+    obj->label_len = attrs->label_len;
+    return obj;
+}
+
+CK_RV ele_objects_add_keypair(uint32_t key_id, unsigned int curve,
+                              const uint8_t *pub, size_t pub_len,
+                              const ele_object_attrs_t *pub_attrs,
+                              const ele_object_attrs_t *priv_attrs,
+                              CK_SESSION_HANDLE session,
+                              CK_OBJECT_HANDLE *hPublic, CK_OBJECT_HANDLE *hPrivate) {
+    ele_object_t *pub_obj = ele_object_new(CKO_PUBLIC_KEY, pub_attrs, session);
+    ele_object_t *priv_obj = ele_object_new(CKO_PRIVATE_KEY, priv_attrs, session);
+    ele_cache_change_t chg;
+    int persisting = 0;
+    CK_BYTE *point;
+    CK_RV rv;
+
+    if (pub_obj == NULL || priv_obj == NULL || pub_len + 1 > 127) {
+        free(pub_obj);
+        free(priv_obj);
+        return pub_len + 1 > 127 ? CKR_GENERAL_ERROR : CKR_HOST_MEMORY;
+    }
+
+    // CKA_EC_POINT: DER OCTET STRING holding the uncompressed point
+    point = malloc(pub_len + 3);
+    if (point == NULL) {
+        free(pub_obj);
+        free(priv_obj);
+        return CKR_HOST_MEMORY;
+    }
+    point[0] = 0x04;
+    point[1] = (CK_BYTE)(pub_len + 1);
+    point[2] = 0x04;
+    memcpy(point + 3, pub, pub_len);
+
+    pub_obj->key_id = priv_obj->key_id = key_id;
+    pub_obj->curve = priv_obj->curve = curve;
+    pub_obj->value = pub_obj->value_owned = point;
+    pub_obj->value_len = pub_len + 3;
+
+    pthread_rwlock_wrlock(&ele_store.lock);
+
+    rv = ele_store_insert(pub_obj);
+    if (rv == CKR_OK) {
+        rv = ele_store_insert(priv_obj);
+        if (rv != CKR_OK) {
+            ele_store_remove(pub_obj);
+            pub_obj = NULL;
+        }
+    }
+
+    if (rv != CKR_OK) {
+        pthread_rwlock_unlock(&ele_store.lock);
+        if (pub_obj != NULL) {
+            ele_object_free(pub_obj);
+        }
+        free(priv_obj);
+        return rv;
+    }
+
+    if (pub_obj->token || priv_obj->token) {
+        ele_object_t *persist[2];
+        unsigned int n = 0;
+
+        if (pub_obj->token) {
+            persist[n++] = pub_obj;
+        }
+        if (priv_obj->token) {
+            persist[n++] = priv_obj;
+        }
+        persisting = ele_cache_prepare(&chg, persist, n, 0) == 0;
+    }
+
+    *hPublic = pub_obj->handle;
+    *hPrivate = priv_obj->handle;
+
+    pthread_rwlock_unlock(&ele_store.lock);
+
+    if (persisting) {
+        ele_cache_commit(&chg);
+    }
+    return CKR_OK;
+}
+
+CK_RV ele_objects_create(CK_ATTRIBUTE *tmpl, CK_ULONG count,
+                         CK_SESSION_HANDLE session, CK_OBJECT_HANDLE *handle) {
+    ele_object_attrs_t attrs;
+    ele_cache_change_t chg;
+    CK_ATTRIBUTE *value = NULL;
+    ele_object_t *obj;
+    int persisting = 0;
+    int is_cert = 0;
+    CK_RV rv;
+
+    rv = ele_objects_parse_attrs(tmpl, count, &attrs);
+    if (rv != CKR_OK) {
+        return rv;
+    }
+
+    for (CK_ULONG i = 0; i < count; i++) {
+        if (tmpl[i].type == CKA_CLASS) {
+            if (tmpl[i].ulValueLen != sizeof(CK_OBJECT_CLASS)) {
+                return CKR_ATTRIBUTE_VALUE_INVALID;
+            }
+            is_cert = *(CK_OBJECT_CLASS *)tmpl[i].pValue == CKO_CERTIFICATE;
+        } else if (tmpl[i].type == CKA_VALUE) {
+            value = &tmpl[i];
+        }
+    }
+
+    // Keys only come from the enclave; certificates can be imported
+    if (!is_cert) {
+        return CKR_TEMPLATE_INCONSISTENT;
+    }
+
+    if (value == NULL || value->pValue == NULL || value->ulValueLen == 0) {
+        return CKR_TEMPLATE_INCOMPLETE;
+    }
+
+    obj = ele_object_new(CKO_CERTIFICATE, &attrs, session);
+    if (obj == NULL) {
+        return CKR_HOST_MEMORY;
+    }
+
+    obj->value_owned = malloc(value->ulValueLen);
+    if (obj->value_owned == NULL) {
+        free(obj);
+        return CKR_HOST_MEMORY;
+    }
+    memcpy(obj->value_owned, value->pValue, value->ulValueLen);
+    obj->value = obj->value_owned;
+    obj->value_len = value->ulValueLen;
+
+    pthread_rwlock_wrlock(&ele_store.lock);
+    rv = ele_store_insert(obj);
+    if (rv == CKR_OK) {
+        if (obj->token) {
+            persisting = ele_cache_prepare(&chg, &obj, 1, 0) == 0;
+        }
+        *handle = obj->handle;
+    }
+    pthread_rwlock_unlock(&ele_store.lock);
+
+    if (rv != CKR_OK) {
+        ele_object_free(obj);
+    }
+    if (persisting) {
+        ele_cache_commit(&chg);
+    }
+    return rv;
+}
+
+// Free the enclave key behind a destroyed private key object
+static void ele_object_delete_key(uint32_t key_id) {
+    if (ele_hsm_delete_key(key_id) != 0) {
+        fprintf(stderr, "ELE PKCS#11: Cannot delete enclave key 0x%08x\n", key_id);
+    }
+}
+
+CK_RV ele_objects_destroy(CK_OBJECT_HANDLE handle) {
+    ele_cache_change_t chg;
+    ele_object_t *obj;
+    int persisting = 0;
+    int delete_key;
+    uint32_t key_id;
+
+    pthread_rwlock_wrlock(&ele_store.lock);
+
+    obj = ele_store_lookup(handle);
+    if (obj == NULL) {
+        pthread_rwlock_unlock(&ele_store.lock);
+        return CKR_OBJECT_HANDLE_INVALID;
+    }
+
+    if (obj->token) {
+        persisting = ele_cache_prepare(&chg, NULL, 0, obj->uid) == 0;
+    }
+    // The private key object owns the enclave key; its public half does not
+    delete_key = obj->cls == CKO_PRIVATE_KEY;
+    key_id = obj->key_id;
+    ele_store_remove(obj);
+
+    pthread_rwlock_unlock(&ele_store.lock);
+
+    if (persisting) {
+        ele_cache_commit(&chg);
+    }
+    if (delete_key) {
+        ele_object_delete_key(key_id);
+    }
+    return CKR_OK;
+}
+
+void ele_objects_close_session(CK_SESSION_HANDLE session) {
+    uint32_t *key_ids = NULL;
+    size_t keys = 0, key_slots = 0;
+
+    pthread_rwlock_wrlock(&ele_store.lock);
+
+    for (CK_ULONG i = 0; i < ele_store.capacity; i++) {
+        ele_object_t *obj = ele_store.objects[i];
+        if (obj == NULL || obj->token || obj->session != session) {
+            continue;
+        }
+        if (obj->cls == CKO_PRIVATE_KEY) {
+            if (keys == key_slots) {
+                size_t slots = key_slots ? 2 * key_slots : 8;
+                uint32_t *grown = realloc(key_ids, slots * sizeof(*key_ids));
+
+                // Out of memory: delete this key now, under the lock
+                if (grown == NULL) {
+                    ele_object_delete_key(obj->key_id);
+                    ele_store_remove(obj);
+                    continue;
+                }
+                key_ids = grown;
+                key_slots = slots;
+            }
+            key_ids[keys++] = obj->key_id;
+        }
+        ele_store_remove(obj);
+    }
+
+    pthread_rwlock_unlock(&ele_store.lock);
+
+    // Enclave round trips happen after the store is unlocked
+    for (size_t i = 0; i < keys; i++) {
+        ele_object_delete_key(key_ids[i]);
+    }
+    free(key_ids);
+}
+
+CK_RV ele_objects_get_private_key(CK_OBJECT_HANDLE handle, uint32_t *key_id, unsigned int *curve) {
+    ele_object_t *obj;
+    CK_RV rv = CKR_KEY_HANDLE_INVALID;
+
+    pthread_rwlock_rdlock(&ele_store.lock);
+
+    obj = ele_store_lookup(handle);
+    if (obj != NULL && obj->cls == CKO_PRIVATE_KEY && obj->curve < ELE_CURVE_COUNT) {
+        *key_id = obj->key_id;
+        *curve = obj->curve;
+        rv = CKR_OK;
+    }
+
+    pthread_rwlock_unlock(&ele_store.lock);
+    return rv;
+}
+
+CK_RV ele_objects_get_attributes(CK_OBJECT_HANDLE handle, CK_ATTRIBUTE *tmpl, CK_ULONG count) {
+    ele_object_t *obj;
+    CK_RV rv = CKR_OK;
+
+    pthread_rwlock_rdlock(&ele_store.lock);
+
+    obj = ele_store_lookup(handle);
+    if (obj == NULL) {
+        pthread_rwlock_unlock(&ele_store.lock);
+        return CKR_OBJECT_HANDLE_INVALID;
+    }
+
+    // Every attribute is processed; the last failure is reported
+    for (CK_ULONG i = 0; i < count; i++) {
+        ele_attr_scratch_t tmp;
+        const void *val;
+        CK_ULONG len;
+        CK_RV attr_rv = ele_object_attr(obj, tmpl[i].type, &tmp, &val, &len);
+
+        if (attr_rv != CKR_OK) {
+            tmpl[i].ulValueLen = CK_UNAVAILABLE_INFORMATION;
+            rv = attr_rv;
+        } else if (tmpl[i].pValue == NULL) {
+            tmpl[i].ulValueLen = len;
+        } else if (tmpl[i].ulValueLen < len) {
+            tmpl[i].ulValueLen = CK_UNAVAILABLE_INFORMATION;
+            rv = CKR_BUFFER_TOO_SMALL;
+        } else {
+            memcpy(tmpl[i].pValue, val, len);
+            tmpl[i].ulValueLen = len;
+        }
+    }
+
+    pthread_rwlock_unlock(&ele_store.lock);
+    return rv;
+}
+
+CK_RV ele_objects_find(CK_ATTRIBUTE *tmpl, CK_ULONG count,
+                       CK_OBJECT_HANDLE **handles, CK_ULONG *found) {
+    CK_OBJECT_HANDLE *result = NULL;
+    CK_ULONG n = 0;
+    int index = -1;
+    unsigned int bucket = 0;
+
+    for (CK_ULONG i = 0; i < count; i++) {
+        if (tmpl[i].pValue == NULL && tmpl[i].ulValueLen > 0) {
+            return CKR_ARGUMENTS_BAD;
+        }
+    }
+
+    // Pick up records other processes added since we last looked
+    if (ele_cache_stale()) {
+        pthread_rwlock_wrlock(&ele_store.lock);
+        ele_cache_refresh();
+        pthread_rwlock_unlock(&ele_store.lock);
+    }
+
+    // Most selective indexed attribute in the template
+    for (CK_ULONG i = 0; i < count; i++) {
+        if (tmpl[i].type == CKA_ID && (index < 0 || index > ELE_INDEX_ID)) {
+            index = ELE_INDEX_ID;
+            bucket = ele_hash(tmpl[i].pValue, tmpl[i].ulValueLen);
+        } else if (tmpl[i].type == CKA_LABEL && (index < 0 || index > ELE_INDEX_LABEL)) {
+            index = ELE_INDEX_LABEL;
+            bucket = ele_hash(tmpl[i].pValue, tmpl[i].ulValueLen);
+        } else if (tmpl[i].type == CKA_CLASS && index < 0 &&
+                   tmpl[i].ulValueLen == sizeof(CK_OBJECT_CLASS)) {
+            index = ELE_INDEX_CLASS;
+            bucket = ele_hash(tmpl[i].pValue, sizeof(CK_OBJECT_CLASS));
+        }
+    }
+
+    pthread_rwlock_rdlock(&ele_store.lock);
+
+    result = malloc((ele_store.capacity ? ele_store.capacity : 1) * sizeof(*result));
+    if (result == NULL) {
+        pthread_rwlock_unlock(&ele_store.lock);
+        return CKR_HOST_MEMORY;
+    }
+
+    if (index >= 0) {
+        for (ele_object_t *obj = ele_store.index[index][bucket]; obj != NULL; obj = obj->next[index]) {
+            if (ele_object_matches(obj, tmpl, count)) {
+                result[n++] = obj->handle;
+            }
+        }
+    } else {
+        for (CK_ULONG i = 0; i < ele_store.capacity; i++) {
+            if (ele_store.objects[i] != NULL && ele_object_matches(ele_store.objects[i], tmpl, count)) {
+                result[n++] = ele_store.objects[i]->handle;
+            }
+        }
+    }
+
+    pthread_rwlock_unlock(&ele_store.lock);
+
+    *handles = result;
+    *found = n;
+    return CKR_OK;
+}
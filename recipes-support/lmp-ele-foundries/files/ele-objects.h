@@ -0,0 +1,81 @@
+/*
+ * Object store for the ELE PKCS#11 module
+ *
+ * Objects (EC key pairs held in the enclave, certificates) are kept in
+ * memory with hash indexes on CKA_ID, CKA_LABEL and CKA_CLASS so
+ * C_FindObjects resolves a template without scanning every object or
+ * asking the enclave. Token objects are also written to a cache file
+ * that the next process maps at start-up, so key lookups after a fresh
+ * start need no ELE round trips either.
+ */
+
+#ifndef ELE_OBJECTS_H
+#define ELE_OBJECTS_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "ele-pkcs11.h"
+
+// Default location of the persistent object cache
+#define ELE_OBJECTS_CACHE_PATH "/var/lib/ele-pkcs11/objects.cache"
+
+#define ELE_OBJECT_MAX_ID       64
+#define ELE_OBJECT_MAX_LABEL    64
+
+// Key size and DER OID for a curve
+unsigned int ele_curve_bits(unsigned int curve);
+const CK_BYTE *ele_curve_oid(unsigned int curve, CK_ULONG *len);
+
+/*
+ * Load the cache file (ELE_PKCS11_CACHE overrides the default path).
+ * A missing or corrupt cache simply starts an empty store.
+ */
+CK_RV ele_objects_init(void);
+void ele_objects_shutdown(void);
+
+// Common CKA_ID/CKA_LABEL/CKA_TOKEN attributes taken from a template
+typedef struct {
+    CK_BYTE id[ELE_OBJECT_MAX_ID];
+    CK_ULONG id_len;
+    char label[ELE_OBJECT_MAX_LABEL];
+    CK_ULONG label_len;
+    CK_BBOOL token;
+} ele_object_attrs_t;
+
+CK_RV ele_objects_parse_attrs(CK_ATTRIBUTE *tmpl, CK_ULONG count, ele_object_attrs_t *attrs);
+
+/*
+ * Register a key pair generated in the enclave. session is the owning
+ * session handle for session objects (ignored for token objects).
+ */
+CK_RV ele_objects_add_keypair(uint32_t key_id, unsigned int curve,
+                              const uint8_t *pub, size_t pub_len,
+                              const ele_object_attrs_t *pub_attrs,
+                              const ele_object_attrs_t *priv_attrs,
+                              CK_SESSION_HANDLE session,
+                              CK_OBJECT_HANDLE *hPublic, CK_OBJECT_HANDLE *hPrivate);
+
+// C_CreateObject (certificates only)
+CK_RV ele_objects_create(CK_ATTRIBUTE *tmpl, CK_ULONG count,
+                         CK_SESSION_HANDLE session, CK_OBJECT_HANDLE *handle);
+
+// Destroying a private key object also deletes its key from the enclave
+CK_RV ele_objects_destroy(CK_OBJECT_HANDLE handle);
+
+// Drop all session objects owned by a closing session, and their enclave keys
+void ele_objects_close_session(CK_SESSION_HANDLE session);
+
+// Resolve a private key handle to its enclave key
+CK_RV ele_objects_get_private_key(CK_OBJECT_HANDLE handle, uint32_t *key_id, unsigned int *curve);
+
+CK_RV ele_objects_get_attributes(CK_OBJECT_HANDLE handle, CK_ATTRIBUTE *tmpl, CK_ULONG count);
+
+/*
+ * Snapshot the handles matching a template into a malloc()ed array,
+ * consumed by C_FindObjects and freed by C_FindObjectsFinal.
+ */
+CK_RV ele_objects_find(CK_ATTRIBUTE *tmpl, CK_ULONG count,
+                       CK_OBJECT_HANDLE **handles, CK_ULONG *found);
+
+#endif /* ELE_OBJECTS_H */
@@ -1,12 +1,37 @@
 /*
  * ELE PKCS#11 Module Implementation for i.MX93 EdgeLock Enclave
  * 
- * This is a basic implementation that interfaces with the EdgeLock Enclave
- * to provide PKCS#11 cryptographic operations for Foundries.io integration.
+ * This is the PKCS#11 token that aktualizr-lite and the Foundries.io
+ * registration use to reach the EdgeLock Enclave. It implements the subset
+ * of PKCS#11 those clients need: sessions, token and session objects,
+ * EC key generation, ECDSA signing, digests and random numbers.
  * 
- * NOTE: This is a simplified implementation for demonstration purposes.
- * A production implementation would require full PKCS#11 compliance
- * and comprehensive error handling.
+ * Enclave requests currently use the ele-sim protocol only (see
+ * ele-mailbox.h); on real ELE firmware the key generation, signing and
+ * random number paths report CKR_FUNCTION_NOT_SUPPORTED until they are
+ * built on NXP's secure_enclave library.
+ * 
+ * Hashing mechanisms (CKM_ECDSA_SHA*) digest the data on the host through
+ * OpenSSL's EVP interface, which uses the ARMv8 SHA-2 instructions when the
+ * CPU has them, and only the final digest crosses the ELE mailbox. The
+ * multi-part C_SignUpdate path keeps memory use constant for large images.
+ * 
+ * C_Digest hands whole messages to the crypto dispatcher (ele-crypto.c),
+ * which picks the enclave, the ARMv8 instructions or OpenSSL per message
+ * size from the board's calibrated profile. Multi-part digests stream
+ * through OpenSSL, since their final size is not known up front.
+ * 
+ * Threading model: sessions live in a fixed table guarded by a global
+ * lock, and each session carries its own lock and operation state, so
+ * independent sessions only contend on the short table lookup. Access to
+ * the ELE device goes through the mailbox command queue (ele-mailbox.c),
+ * which keeps several requests in flight across device contexts.
+ * Locking primitives come from C_Initialize (application callbacks or
+ * native pthread mutexes when CKF_OS_LOCKING_OK is set).
+ * 
+ * Worker threads do not survive fork(). pthread_atfork() handlers leave
+ * a child with an empty mailbox queue and random pool, so it can reach
+ * the enclave again only after calling C_Finalize and C_Initialize.
  */
 
 #include <stdio.h>
@@ -16,92 +41,351 @@
 #include <fcntl.h>
 #include <sys/ioctl.h>
 #include <errno.h>
+#include <pthread.h>
 
-// PKCS#11 definitions (simplified)
-#define CK_PTR *
-#define CK_DEFINE_FUNCTION(returnType, name) returnType name
-#define CK_DECLARE_FUNCTION(returnType, name) returnType name
-#define CK_DECLARE_FUNCTION_POINTER(returnType, name) returnType (* name)
-#define CK_CALLBACK_FUNCTION(returnType, name) returnType (* name)
-
-typedef unsigned long CK_ULONG;
-typedef unsigned long CK_RV;
-typedef unsigned char CK_BYTE;
-typedef CK_BYTE CK_PTR CK_BYTE_PTR;
-typedef CK_ULONG CK_PTR CK_ULONG_PTR;
-typedef void CK_PTR CK_VOID_PTR;
-
-// PKCS#11 return values
-#define CKR_OK                          0x00000000UL
-#define CKR_GENERAL_ERROR               0x00000005UL
-#define CKR_FUNCTION_NOT_SUPPORTED      0x00000054UL
-#define CKR_ARGUMENTS_BAD               0x00000007UL
-#define CKR_DEVICE_ERROR                0x00000030UL
-#define CKR_CRYPTOKI_NOT_INITIALIZED    0x00000190UL
-#define CKR_CRYPTOKI_ALREADY_INITIALIZED 0x00000191UL
-
-// ELE device path
+#include <openssl/evp.h>
+
+#include "ele-pkcs11.h"
+#include "ele-backend.h"
+#include "ele-crypto.h"
+#include "ele-keypool.h"
+#include "ele-mailbox.h"
+#include "ele-objects.h"
+#include "ele-rng.h"
+#include "ele-trace.h"
+
+// Default ELE device path (ELE_DEVICE_PATH in the environment overrides it)
 #define ELE_DEVICE_PATH "/dev/ele_mu"
 
+// Session table size (must be a power of two, see ele_session_index())
+#define ELE_MAX_SESSIONS 64
+
+// Module identification reported by C_GetInfo / C_GetTokenInfo
+#define ELE_MANUFACTURER_ID     "NXP Semiconductors"
+#define ELE_LIBRARY_DESCRIPTION "ELE PKCS#11 module"
+#define ELE_SLOT_DESCRIPTION    "i.MX93 EdgeLock Enclave"
+#define ELE_TOKEN_LABEL         "ELE"
+#define ELE_TOKEN_MODEL         "i.MX93 ELE"
+#define ELE_LIBRARY_VERSION_MAJOR 1
+#define ELE_LIBRARY_VERSION_MINOR 0
+
+// Locking callbacks selected by C_Initialize (all NULL when the
+// application promised single-threaded access)
+typedef struct {
+    CK_CREATEMUTEX create;
+    CK_DESTROYMUTEX destroy;
+    CK_LOCKMUTEX lock;
+    CK_UNLOCKMUTEX unlock;
+} ele_locking_t;
+
+// Active cryptographic operation of a session
+typedef enum {
+    ELE_OP_NONE = 0,
+    ELE_OP_SIGN,
+    ELE_OP_DIGEST
+} ele_op_t;
+
+typedef enum {
+    ELE_SESSION_FREE = 0,
+    ELE_SESSION_OPEN,
+    ELE_SESSION_CLOSING
+} ele_session_state_t;
+
+typedef struct {
+    ele_session_state_t state;
+    CK_SESSION_HANDLE handle;
+    CK_SLOT_ID slot;
+    CK_FLAGS flags;
+    void *lock;
+    
+    // Per-session operation state
+    ele_op_t op;
+    CK_MECHANISM_TYPE op_mechanism;
+    uint32_t op_key_id;      // enclave key of the signing key
+    unsigned int op_curve;
+    EVP_MD_CTX *op_md;       // host-side digest for CKM_ECDSA_SHA* and C_DigestUpdate
+    int op_multipart;        // C_*Update seen, one-shot C_Sign/C_Digest not allowed
+    
+    // Object search state (independent of the crypto operation)
+    int find_active;
+    CK_OBJECT_HANDLE *find_handles;
+    CK_ULONG find_count;
+    CK_ULONG find_pos;
+} ele_session_t;
+
 // Global state
 static int ele_initialized = 0;
-static int ele_fd = -1;
+static ele_locking_t ele_locking;
+static void *ele_global_lock = NULL;   // session table and open counts
+static ele_session_t ele_sessions[ELE_MAX_SESSIONS];
+static CK_ULONG ele_session_generation = 0;
+
+// Tracing is configured once, by whichever of C_GetFunctionList or
+// C_Initialize the application calls first
+static pthread_once_t ele_trace_once = PTHREAD_ONCE_INIT;
+static void ele_trace_init(void);
+
+// Native locking used for CKF_OS_LOCKING_OK
+static CK_RV ele_os_create_mutex(CK_VOID_PTR_PTR ppMutex) {
+    pthread_mutex_t *m;
+    
+    if (ppMutex == NULL) {
+        return CKR_ARGUMENTS_BAD;
+    }
+    
+    m = malloc(sizeof(*m));
+    if (m == NULL) {
+        return CKR_HOST_MEMORY;
+    }
+    
+    if (pthread_mutex_init(m, NULL) != 0) {
+        free(m);
+        return CKR_GENERAL_ERROR;
+    }
+    
+    *ppMutex = m;
+    return CKR_OK;
+}
+
+static CK_RV ele_os_destroy_mutex(CK_VOID_PTR pMutex) {
+    if (pMutex == NULL) {
+        return CKR_MUTEX_BAD;
+    }
+    
+    pthread_mutex_destroy(pMutex);
+    free(pMutex);
+    return CKR_OK;
+}
+
+static CK_RV ele_os_lock_mutex(CK_VOID_PTR pMutex) {
+    if (pMutex == NULL) {
+        return CKR_MUTEX_BAD;
+    }
+    
+    return pthread_mutex_lock(pMutex) == 0 ? CKR_OK : CKR_CANT_LOCK;
+}
+
+static CK_RV ele_os_unlock_mutex(CK_VOID_PTR pMutex) {
+    if (pMutex == NULL) {
+        return CKR_MUTEX_BAD;
+    }
+    
+    return pthread_mutex_unlock(pMutex) == 0 ? CKR_OK : CKR_MUTEX_NOT_LOCKED;
+}
+
+// Lock helpers; no-ops when no locking was negotiated
+static CK_RV ele_mutex_create(void **mutex) {
+    *mutex = NULL;
+    return ele_locking.create ? ele_locking.create(mutex) : CKR_OK;
+}
+
+static void ele_mutex_destroy(void **mutex) {
+    if (ele_locking.destroy && *mutex) {
+        ele_locking.destroy(*mutex);
+    }
+    *mutex = NULL;
+}
+
+static CK_RV ele_mutex_lock(void *mutex) {
+    return ele_locking.lock && mutex ? ele_locking.lock(mutex) : CKR_OK;
+}
+
+static void ele_mutex_unlock(void *mutex) {
+    if (ele_locking.unlock && mutex) {
+        ele_locking.unlock(mutex);
+    }
+}
+
+static CK_RV ele_setup_locking(CK_C_INITIALIZE_ARGS *args) {
+    memset(&ele_locking, 0, sizeof(ele_locking));
+    
+    if (args == NULL) {
+        return CKR_OK;
+    }
+    
+    if (args->pReserved != NULL) {
+        return CKR_ARGUMENTS_BAD;
+    }
+    
+    // Either all four callbacks are supplied or none of them
+    int have_callbacks = args->CreateMutex != NULL;
+    if ((args->DestroyMutex != NULL) != have_callbacks ||
+        (args->LockMutex != NULL) != have_callbacks ||
+        (args->UnlockMutex != NULL) != have_callbacks) {
+        return CKR_ARGUMENTS_BAD;
+    }
+    
+    if (args->flags & CKF_OS_LOCKING_OK) {
+        // Prefer native locking whenever the application allows it
+        ele_locking.create = ele_os_create_mutex;
+        ele_locking.destroy = ele_os_destroy_mutex;
+        ele_locking.lock = ele_os_lock_mutex;
+        ele_locking.unlock = ele_os_unlock_mutex;
+    } else if (have_callbacks) {
+        ele_locking.create = args->CreateMutex;
+        ele_locking.destroy = args->DestroyMutex;
+        ele_locking.lock = args->LockMutex;
+        ele_locking.unlock = args->UnlockMutex;
+    }
+    
+    return CKR_OK;
+}
 
-// ELE-specific functions
-static int ele_open_device(void) {
-    if (ele_fd >= 0) {
-        return 0; // Already open
+// Session table
+static unsigned int ele_session_index(CK_SESSION_HANDLE handle) {
+    return (unsigned int)(handle & (ELE_MAX_SESSIONS - 1));
+}
+
+static void ele_session_reset_op(ele_session_t *session) {
+    session->op = ELE_OP_NONE;
+    session->op_mechanism = 0;
+    session->op_key_id = 0;
+    session->op_curve = 0;
+    session->op_multipart = 0;
+    if (session->op_md != NULL) {
+        EVP_MD_CTX_free(session->op_md);
+        session->op_md = NULL;
+    }
+}
+
+static void ele_session_reset_find(ele_session_t *session) {
+    free(session->find_handles);
+    session->find_handles = NULL;
+    session->find_count = 0;
+    session->find_pos = 0;
+    session->find_active = 0;
+}
+
+/*
+ * Look up an open session and return it with its own lock held. The
+ * global lock is only held for the table lookup, so operations on
+ * different sessions run concurrently.
+ */
+static CK_RV ele_session_acquire(CK_SESSION_HANDLE handle, ele_session_t **out) {
+    ele_session_t *session;
+    CK_RV rv;
+    
+    if (!ele_initialized) {
+        return CKR_CRYPTOKI_NOT_INITIALIZED;
+    }
+    
+    rv = ele_mutex_lock(ele_global_lock);
+    if (rv != CKR_OK) {
+        return rv;
+    }
+    
+    session = &ele_sessions[ele_session_index(handle)];
+    if (handle == 0 || session->state != ELE_SESSION_OPEN || session->handle != handle) {
+        ele_mutex_unlock(ele_global_lock);
+        return CKR_SESSION_HANDLE_INVALID;
     }
     
-    ele_fd = open(ELE_DEVICE_PATH, O_RDWR);
-    if (ele_fd < 0) {
-        fprintf(stderr, "ELE PKCS#11: Failed to open ELE device: %s\n", strerror(errno));
-        return -1;
+    rv = ele_mutex_lock(session->lock);
+    ele_mutex_unlock(ele_global_lock);
+    if (rv != CKR_OK) {
+        return rv;
     }
     
-    return 0;
+    *out = session;
+    return CKR_OK;
+}
+
+static void ele_session_release(ele_session_t *session) {
+    ele_mutex_unlock(session->lock);
+}
+
+/*
+ * Close one session: mark it CLOSING so no new lookups succeed, wait for
+ * any in-flight operation by taking the session lock, then free the slot
+ * and the session's objects. Called with the global lock held; the lock
+ * is dropped while waiting.
+ */
+static void ele_session_close_locked(ele_session_t *session) {
+    session->state = ELE_SESSION_CLOSING;
+    ele_mutex_unlock(ele_global_lock);
+    
+    ele_mutex_lock(session->lock);
+    ele_session_reset_op(session);
+    ele_session_reset_find(session);
+    ele_mutex_unlock(session->lock);
+    
+    ele_objects_close_session(session->handle);
+    
+    ele_mutex_lock(ele_global_lock);
+    session->handle = 0;
+    session->state = ELE_SESSION_FREE;
 }
 
-static void ele_close_device(void) {
-    if (ele_fd >= 0) {
-        close(ele_fd);
-        ele_fd = -1;
+static void ele_sessions_destroy(void) {
+    for (unsigned int i = 0; i < ELE_MAX_SESSIONS; i++) {
+        ele_mutex_destroy(&ele_sessions[i].lock);
     }
+    memset(ele_sessions, 0, sizeof(ele_sessions));
 }
 
-static int ele_test_communication(void) {
-    // Basic test to verify ELE device is responsive
-    // In a real implementation, this would send a test command to ELE
+static CK_RV ele_sessions_create(void) {
+    memset(ele_sessions, 0, sizeof(ele_sessions));
     
-    if (ele_fd < 0) {
-        return -1;
+    for (unsigned int i = 0; i < ELE_MAX_SESSIONS; i++) {
+        CK_RV rv = ele_mutex_create(&ele_sessions[i].lock);
+        if (rv != CKR_OK) {
+            ele_sessions_destroy();
+            return rv;
+        }
     }
     
-    // TODO: Implement actual ELE communication test
-    // For now, just verify the device is accessible
-    return 0;
+    return CKR_OK;
 }
 
 // PKCS#11 Function implementations
 
 CK_DEFINE_FUNCTION(CK_RV, C_Initialize)(CK_VOID_PTR pInitArgs) {
+    CK_C_INITIALIZE_ARGS *args;
+    ele_backend_t backend;
+    int allow_threads;
+    CK_RV rv;
+    
     if (ele_initialized) {
         return CKR_CRYPTOKI_ALREADY_INITIALIZED;
     }
     
-    printf("ELE PKCS#11: Initializing EdgeLock Enclave interface\n");
+    pthread_once(&ele_trace_once, ele_trace_init);
+    ELE_LOG("Initializing EdgeLock Enclave interface");
     
-    if (ele_open_device() != 0) {
-        return CKR_DEVICE_ERROR;
+    rv = ele_setup_locking((CK_C_INITIALIZE_ARGS *)pInitArgs);
+    if (rv != CKR_OK) {
+        return rv;
+    }
+    
+    rv = ele_mutex_create(&ele_global_lock);
+    if (rv == CKR_OK) {
+        rv = ele_sessions_create();
+    }
+    if (rv != CKR_OK) {
+        ele_mutex_destroy(&ele_global_lock);
+        return rv;
     }
     
-    if (ele_test_communication() != 0) {
-        ele_close_device();
+    // Worker threads are only started if the application allows them
+    args = (CK_C_INITIALIZE_ARGS *)pInitArgs;
+    allow_threads = !(args && (args->flags & CKF_LIBRARY_CANT_CREATE_OS_THREADS));
+    
+    if (ele_backend_select(&backend, ELE_DEVICE_PATH) != 0 ||
+        ele_mbox_init(&backend, allow_threads) != 0) {
+        ele_sessions_destroy();
+        ele_mutex_destroy(&ele_global_lock);
         return CKR_DEVICE_ERROR;
     }
     
+    // Cached token objects resolve without enclave round trips
+    ele_objects_init();
+    ele_crypto_init();
+    ele_rng_init(allow_threads);
+    ele_keypool_init(allow_threads);
+    ele_trace_start();
+    
     ele_initialized = 1;
-    printf("ELE PKCS#11: Initialization successful\n");
+    ELE_LOG("Initialization successful");
     return CKR_OK;
 }
 
@@ -110,16 +394,45 @@ CK_DEFINE_FUNCTION(CK_RV, C_Finalize)(CK_VOID_PTR pReserved) {
         return CKR_CRYPTOKI_NOT_INITIALIZED;
     }
     
-    printf("ELE PKCS#11: Finalizing EdgeLock Enclave interface\n");
+    if (pReserved != NULL) {
+        return CKR_ARGUMENTS_BAD;
+    }
+    
+    ELE_LOG("Finalizing EdgeLock Enclave interface");
     
-    ele_close_device();
+    ele_mutex_lock(ele_global_lock);
+    for (unsigned int i = 0; i < ELE_MAX_SESSIONS; i++) {
+        if (ele_sessions[i].state == ELE_SESSION_OPEN) {
+            ele_session_close_locked(&ele_sessions[i]);
+        }
+    }
     ele_initialized = 0;
+    ele_mutex_unlock(ele_global_lock);
+    
+    ele_keypool_shutdown();
+    ele_rng_shutdown();
+    ele_mbox_shutdown();
+    ele_objects_shutdown();
+    ele_sessions_destroy();
+    ele_mutex_destroy(&ele_global_lock);
+    memset(&ele_locking, 0, sizeof(ele_locking));
+    
+    ele_trace_dump();
+    ele_trace_stop();
     
     return CKR_OK;
 }
 
-CK_DEFINE_FUNCTION(CK_RV, C_GetInfo)(void *pInfo) {
-    printf("ELE PKCS#11: C_GetInfo called\n");
+// Copy a string into a fixed-width, blank padded PKCS#11 info field
+static void ele_pad_string(CK_UTF8CHAR *field, size_t width, const char *value) {
+    size_t len = strlen(value);
+    
+    memset(field, ' ', width);
+    memcpy(field, value, len < width ? len : width);
+}
+
+CK_DEFINE_FUNCTION(CK_RV, C_GetInfo)(CK_INFO *pInfo) {
+    ELE_LOG("C_GetInfo called");
     
     if (!ele_initialized) {
         return CKR_CRYPTOKI_NOT_INITIALIZED;
@@ -129,15 +442,22 @@ CK_DEFINE_FUNCTION(CK_RV, C_GetInfo)(void *pInfo) {
         return CKR_ARGUMENTS_BAD;
     }
     
-    // TODO: Fill in PKCS#11 info structure
-    // For now, just indicate success
+    memset(pInfo, 0, sizeof(*pInfo));
+    pInfo->cryptokiVersion.major = 2;
+    pInfo->cryptokiVersion.minor = 40;
+    ele_pad_string(pInfo->manufacturerID, sizeof(pInfo->manufacturerID), ELE_MANUFACTURER_ID);
+    ele_pad_string(pInfo->libraryDescription, sizeof(pInfo->libraryDescription),
+                   ELE_LIBRARY_DESCRIPTION);
+    pInfo->libraryVersion.major = ELE_LIBRARY_VERSION_MAJOR;
+    pInfo->libraryVersion.minor = ELE_LIBRARY_VERSION_MINOR;
+    
     return CKR_OK;
 }
 
-CK_DEFINE_FUNCTION(CK_RV, C_GetSlotList)(CK_BYTE tokenPresent, 
+CK_DEFINE_FUNCTION(CK_RV, C_GetSlotList)(CK_BBOOL tokenPresent, 
                                         CK_ULONG_PTR pSlotList, 
                                         CK_ULONG_PTR pulCount) {
-    printf("ELE PKCS#11: C_GetSlotList called\n");
+    ELE_LOG("C_GetSlotList called");
     
     if (!ele_initialized) {
         return CKR_CRYPTOKI_NOT_INITIALIZED;
@@ -164,12 +484,176 @@ CK_DEFINE_FUNCTION(CK_RV, C_GetSlotList)(CK_BYTE tokenPresent,
     return CKR_OK;
 }
 
+CK_DEFINE_FUNCTION(CK_RV, C_GetSlotInfo)(CK_SLOT_ID slotID, CK_SLOT_INFO *pInfo) {
+    if (!ele_initialized) {
+        return CKR_CRYPTOKI_NOT_INITIALIZED;
+    }
+    
+    if (pInfo == NULL) {
+        return CKR_ARGUMENTS_BAD;
+    }
+    
+    if (slotID != 0) {
+        return CKR_SLOT_ID_INVALID;
+    }
+    
+    memset(pInfo, 0, sizeof(*pInfo));
+    ele_pad_string(pInfo->slotDescription, sizeof(pInfo->slotDescription), ELE_SLOT_DESCRIPTION);
+    ele_pad_string(pInfo->manufacturerID, sizeof(pInfo->manufacturerID), ELE_MANUFACTURER_ID);
+    pInfo->flags = CKF_TOKEN_PRESENT | CKF_HW_SLOT;
+    
+    return CKR_OK;
+}
+
+CK_DEFINE_FUNCTION(CK_RV, C_GetTokenInfo)(CK_SLOT_ID slotID, CK_TOKEN_INFO *pInfo) {
+    CK_ULONG sessions = 0;
+    CK_ULONG rw_sessions = 0;
+    CK_RV rv;
+    
+    if (!ele_initialized) {
+        return CKR_CRYPTOKI_NOT_INITIALIZED;
+    }
+    
+    if (pInfo == NULL) {
+        return CKR_ARGUMENTS_BAD;
+    }
+    
+    if (slotID != 0) {
+        return CKR_SLOT_ID_INVALID;
+    }
+    
+    rv = ele_mutex_lock(ele_global_lock);
+    if (rv != CKR_OK) {
+        return rv;
+    }
+    for (unsigned int i = 0; i < ELE_MAX_SESSIONS; i++) {
+        if (ele_sessions[i].state == ELE_SESSION_OPEN) {
+            sessions++;
+            if (ele_sessions[i].flags & CKF_RW_SESSION) {
+                rw_sessions++;
+            }
+        }
+    }
+    ele_mutex_unlock(ele_global_lock);
+    
+    memset(pInfo, 0, sizeof(*pInfo));
+    ele_pad_string(pInfo->label, sizeof(pInfo->label), ELE_TOKEN_LABEL);
+    ele_pad_string(pInfo->manufacturerID, sizeof(pInfo->manufacturerID), ELE_MANUFACTURER_ID);
+    ele_pad_string(pInfo->model, sizeof(pInfo->model), ELE_TOKEN_MODEL);
+    ele_pad_string(pInfo->serialNumber, sizeof(pInfo->serialNumber), "0");
+    
+    // The ELE has no PIN model: keys are bound to the device, not to a user
+    pInfo->flags = CKF_TOKEN_INITIALIZED;
+    if (ele_mbox_depth() > 0) {
+        pInfo->flags |= CKF_RNG;
+    }
+    pInfo->ulMaxSessionCount = ELE_MAX_SESSIONS;
+    pInfo->ulSessionCount = sessions;
+    pInfo->ulMaxRwSessionCount = ELE_MAX_SESSIONS;
+    pInfo->ulRwSessionCount = rw_sessions;
+    pInfo->ulMaxPinLen = 0;
+    pInfo->ulMinPinLen = 0;
+    pInfo->ulTotalPublicMemory = CK_UNAVAILABLE_INFORMATION;
+    pInfo->ulFreePublicMemory = CK_UNAVAILABLE_INFORMATION;
+    pInfo->ulTotalPrivateMemory = CK_UNAVAILABLE_INFORMATION;
+    pInfo->ulFreePrivateMemory = CK_UNAVAILABLE_INFORMATION;
+    
+    return CKR_OK;
+}
+
+// Mechanisms offered by the token, in C_GetMechanismList order
+static const struct {
+    CK_MECHANISM_TYPE type;
+    CK_FLAGS flags;
+} ele_mechanisms[] = {
+    { CKM_EC_KEY_PAIR_GEN, CKF_HW | CKF_GENERATE_KEY_PAIR },
+    { CKM_ECDSA,           CKF_HW | CKF_SIGN },
+    { CKM_ECDSA_SHA256,    CKF_HW | CKF_SIGN },
+    { CKM_ECDSA_SHA384,    CKF_HW | CKF_SIGN },
+    { CKM_ECDSA_SHA512,    CKF_HW | CKF_SIGN },
+    { CKM_SHA256,          CKF_DIGEST },
+    { CKM_SHA384,          CKF_DIGEST },
+    { CKM_SHA512,          CKF_DIGEST },
+};
+
+#define ELE_MECHANISM_COUNT (sizeof(ele_mechanisms) / sizeof(ele_mechanisms[0]))
+
+CK_DEFINE_FUNCTION(CK_RV, C_GetMechanismList)(CK_SLOT_ID slotID,
+                                             CK_MECHANISM_TYPE_PTR pMechanismList,
+                                             CK_ULONG_PTR pulCount) {
+    if (!ele_initialized) {
+        return CKR_CRYPTOKI_NOT_INITIALIZED;
+    }
+    
+    if (pulCount == NULL) {
+        return CKR_ARGUMENTS_BAD;
+    }
+    
+    if (slotID != 0) {
+        return CKR_SLOT_ID_INVALID;
+    }
+    
+    if (pMechanismList == NULL) {
+        *pulCount = ELE_MECHANISM_COUNT;
+        return CKR_OK;
+    }
+    
+    if (*pulCount < ELE_MECHANISM_COUNT) {
+        *pulCount = ELE_MECHANISM_COUNT;
+        return CKR_BUFFER_TOO_SMALL;
+    }
+    
+    for (size_t i = 0; i < ELE_MECHANISM_COUNT; i++) {
+        pMechanismList[i] = ele_mechanisms[i].type;
+    }
+    *pulCount = ELE_MECHANISM_COUNT;
+    
+    return CKR_OK;
+}
+
+CK_DEFINE_FUNCTION(CK_RV, C_GetMechanismInfo)(CK_SLOT_ID slotID,
+                                             CK_MECHANISM_TYPE type,
+                                             CK_MECHANISM_INFO *pInfo) {
+    if (!ele_initialized) {
+        return CKR_CRYPTOKI_NOT_INITIALIZED;
+    }
+    
+    if (pInfo == NULL) {
+        return CKR_ARGUMENTS_BAD;
+    }
+    
+    if (slotID != 0) {
+        return CKR_SLOT_ID_INVALID;
+    }
+    
+    for (size_t i = 0; i < ELE_MECHANISM_COUNT; i++) {
+        if (ele_mechanisms[i].type == type && (ele_mechanisms[i].flags & CKF_DIGEST)) {
+            pInfo->ulMinKeySize = 0;
+            pInfo->ulMaxKeySize = 0;
+            pInfo->flags = ele_mechanisms[i].flags;
+            return CKR_OK;
+        }
+        if (ele_mechanisms[i].type == type) {
+            pInfo->ulMinKeySize = ele_curve_bits(ELE_CURVE_P256);
+            pInfo->ulMaxKeySize = ele_curve_bits(ELE_CURVE_COUNT - 1);
+            pInfo->flags = ele_mechanisms[i].flags |
+                           CKF_EC_F_P | CKF_EC_NAMEDCURVE | CKF_EC_UNCOMPRESS;
+            return CKR_OK;
+        }
+    }
+    
+    return CKR_MECHANISM_INVALID;
+}
+
 CK_DEFINE_FUNCTION(CK_RV, C_OpenSession)(CK_ULONG slotID,
                                         CK_ULONG flags,
                                         CK_VOID_PTR pApplication,
-                                        void *Notify,
+                                        CK_NOTIFY Notify,
                                         CK_ULONG_PTR phSession) {
-    printf("ELE PKCS#11: C_OpenSession called for slot %lu\n", slotID);
+    ele_session_t *session = NULL;
+    CK_RV rv;
+    
+    ELE_LOG("C_OpenSession called for slot %lu", slotID);
     
     if (!ele_initialized) {
         return CKR_CRYPTOKI_NOT_INITIALIZED;
@@ -180,82 +664,1344 @@ CK_DEFINE_FUNCTION(CK_RV, C_OpenSession)(CK_ULONG slotID,
     }
     
     if (slotID != 0) {
-        return CKR_ARGUMENTS_BAD;
+        return CKR_SLOT_ID_INVALID;
+    }
+    
+    if (!(flags & CKF_SERIAL_SESSION)) {
+        return CKR_SESSION_PARALLEL_NOT_SUPPORTED;
+    }
+    
+    rv = ele_mutex_lock(ele_global_lock);
+    if (rv != CKR_OK) {
+        return rv;
+    }
+    
+    for (unsigned int i = 0; i < ELE_MAX_SESSIONS; i++) {
+        if (ele_sessions[i].state == ELE_SESSION_FREE) {
+            session = &ele_sessions[i];
+            break;
+        }
+    }
+    
+    if (session == NULL) {
+        ele_mutex_unlock(ele_global_lock);
+        return CKR_SESSION_COUNT;
+    }
+    
+    // Handle = generation counter above the table index, never zero and
+    // not reused immediately after a close
+    ele_session_generation++;
+    session->handle = (ele_session_generation * ELE_MAX_SESSIONS) |
+                      (CK_SESSION_HANDLE)(session - ele_sessions);
+    if (session->handle == 0) {
+        ele_session_generation++;
+        session->handle = ele_session_generation * ELE_MAX_SESSIONS;
     }
+    session->state = ELE_SESSION_OPEN;
+    session->slot = slotID;
+    session->flags = flags;
+    ele_session_reset_op(session);
+    *phSession = session->handle;
     
-    // Return a dummy session handle
-    *phSession = 1;
+    ele_mutex_unlock(ele_global_lock);
     
     return CKR_OK;
 }
 
 CK_DEFINE_FUNCTION(CK_RV, C_CloseSession)(CK_ULONG hSession) {
-    printf("ELE PKCS#11: C_CloseSession called for session %lu\n", hSession);
+    ele_session_t *session;
+    CK_RV rv;
+    
+    ELE_LOG("C_CloseSession called for session %lu", hSession);
     
     if (!ele_initialized) {
         return CKR_CRYPTOKI_NOT_INITIALIZED;
     }
     
+    rv = ele_mutex_lock(ele_global_lock);
+    if (rv != CKR_OK) {
+        return rv;
+    }
+    
+    session = &ele_sessions[ele_session_index(hSession)];
+    if (hSession == 0 || session->state != ELE_SESSION_OPEN || session->handle != hSession) {
+        ele_mutex_unlock(ele_global_lock);
+        return CKR_SESSION_HANDLE_INVALID;
+    }
+    
+    ele_session_close_locked(session);
+    ele_mutex_unlock(ele_global_lock);
+    
     return CKR_OK;
 }
 
-// Key management functions (stubs for now)
-CK_DEFINE_FUNCTION(CK_RV, C_GenerateKeyPair)(CK_ULONG hSession,
-                                            void *pMechanism,
-                                            void *pPublicKeyTemplate,
-                                            CK_ULONG ulPublicKeyAttributeCount,
-                                            void *pPrivateKeyTemplate,
-                                            CK_ULONG ulPrivateKeyAttributeCount,
-                                            CK_ULONG_PTR phPublicKey,
-                                            CK_ULONG_PTR phPrivateKey) {
-    printf("ELE PKCS#11: C_GenerateKeyPair called\n");
+CK_DEFINE_FUNCTION(CK_RV, C_CloseAllSessions)(CK_ULONG slotID) {
+    CK_RV rv;
     
     if (!ele_initialized) {
         return CKR_CRYPTOKI_NOT_INITIALIZED;
     }
     
-    // TODO: Implement actual key generation using ELE
-    // For now, return dummy key handles
-    if (phPublicKey) *phPublicKey = 100;
-    if (phPrivateKey) *phPrivateKey = 101;
+    if (slotID != 0) {
+        return CKR_SLOT_ID_INVALID;
+    }
+    
+    rv = ele_mutex_lock(ele_global_lock);
+    if (rv != CKR_OK) {
+        return rv;
+    }
+    
+    for (unsigned int i = 0; i < ELE_MAX_SESSIONS; i++) {
+        if (ele_sessions[i].state == ELE_SESSION_OPEN && ele_sessions[i].slot == slotID) {
+            ele_session_close_locked(&ele_sessions[i]);
+        }
+    }
     
+    ele_mutex_unlock(ele_global_lock);
     return CKR_OK;
 }
 
-CK_DEFINE_FUNCTION(CK_RV, C_Sign)(CK_ULONG hSession,
-                                 CK_BYTE_PTR pData,
-                                 CK_ULONG ulDataLen,
-                                 CK_BYTE_PTR pSignature,
-                                 CK_ULONG_PTR pulSignatureLen) {
-    printf("ELE PKCS#11: C_Sign called\n");
+CK_DEFINE_FUNCTION(CK_RV, C_GetSessionInfo)(CK_ULONG hSession, CK_SESSION_INFO *pInfo) {
+    ele_session_t *session;
+    CK_RV rv;
     
-    if (!ele_initialized) {
-        return CKR_CRYPTOKI_NOT_INITIALIZED;
+    if (pInfo == NULL) {
+        return CKR_ARGUMENTS_BAD;
     }
     
-    // TODO: Implement actual signing using ELE
-    return CKR_FUNCTION_NOT_SUPPORTED;
+    rv = ele_session_acquire(hSession, &session);
+    if (rv != CKR_OK) {
+        return rv;
+    }
+    
+    pInfo->slotID = session->slot;
+    pInfo->state = (session->flags & CKF_RW_SESSION) ? CKS_RW_PUBLIC_SESSION : CKS_RO_PUBLIC_SESSION;
+    pInfo->flags = session->flags;
+    pInfo->ulDeviceError = 0;
+    
+    ele_session_release(session);
+    return CKR_OK;
 }
 
-// Additional PKCS#11 functions would be implemented here...
+/*
+ * The token reports no CKF_LOGIN_REQUIRED, but many consumers log in
+ * unconditionally; accept that so they work unchanged.
+ */
+CK_DEFINE_FUNCTION(CK_RV, C_Login)(CK_ULONG hSession,
+                                  CK_USER_TYPE userType,
+                                  CK_UTF8CHAR_PTR pPin,
+                                  CK_ULONG ulPinLen) {
+    ele_session_t *session;
+    CK_RV rv;
+    
+    if (userType != CKU_SO && userType != CKU_USER && userType != CKU_CONTEXT_SPECIFIC) {
+        return CKR_USER_TYPE_INVALID;
+    }
+    
+    rv = ele_session_acquire(hSession, &session);
+    if (rv != CKR_OK) {
+        return rv;
+    }
+    ele_session_release(session);
+    
+    return CKR_OK;
+}
 
-// Function list structure
-static void *function_list[] = {
-    NULL, // C_Initialize is handled specially
-    NULL, // C_Finalize is handled specially
-    // ... other function pointers would go here
-};
+CK_DEFINE_FUNCTION(CK_RV, C_Logout)(CK_ULONG hSession) {
+    ele_session_t *session;
+    CK_RV rv;
+    
+    rv = ele_session_acquire(hSession, &session);
+    if (rv != CKR_OK) {
+        return rv;
+    }
+    ele_session_release(session);
+    
+    return CKR_OK;
+}
 
-// Entry point for PKCS#11 module
-CK_DEFINE_FUNCTION(CK_RV, C_GetFunctionList)(void **ppFunctionList) {
-    printf("ELE PKCS#11: C_GetFunctionList called\n");
+// Key management functions
+static CK_RV ele_curve_from_template(CK_ATTRIBUTE *tmpl, CK_ULONG count, unsigned int *curve) {
+    for (CK_ULONG i = 0; i < count; i++) {
+        if (tmpl[i].type != CKA_EC_PARAMS) {
+            continue;
+        }
+        
+        for (unsigned int c = 0; c < ELE_CURVE_COUNT; c++) {
+            CK_ULONG oid_len;
+            const CK_BYTE *oid = ele_curve_oid(c, &oid_len);
+            
+            if (tmpl[i].ulValueLen == oid_len && memcmp(tmpl[i].pValue, oid, oid_len) == 0) {
+                *curve = c;
+                return CKR_OK;
+            }
+        }
+        
+        return CKR_DOMAIN_PARAMS_INVALID;
+    }
+    
+    return CKR_TEMPLATE_INCOMPLETE;
+}
+
+CK_DEFINE_FUNCTION(CK_RV, C_GenerateKeyPair)(CK_ULONG hSession,
+                                            CK_MECHANISM *pMechanism,
+                                            CK_ATTRIBUTE *pPublicKeyTemplate,
+                                            CK_ULONG ulPublicKeyAttributeCount,
+                                            CK_ATTRIBUTE *pPrivateKeyTemplate,
+                                            CK_ULONG ulPrivateKeyAttributeCount,
+                                            CK_ULONG_PTR phPublicKey,
+                                            CK_ULONG_PTR phPrivateKey) {
+    ele_session_t *session;
+    ele_object_attrs_t pub_attrs, priv_attrs;
+    uint8_t pub[ELE_MAX_PUBKEY_LEN];
+    size_t pub_len = sizeof(pub);
+    uint32_t key_id;
+    unsigned int curve;
+    CK_RV rv;
+    
+    ELE_LOG("C_GenerateKeyPair called");
+    
+    if (pMechanism == NULL || phPublicKey == NULL || phPrivateKey == NULL ||
+        (pPublicKeyTemplate == NULL && ulPublicKeyAttributeCount > 0) ||
+        (pPrivateKeyTemplate == NULL && ulPrivateKeyAttributeCount > 0)) {
+        return CKR_ARGUMENTS_BAD;
+    }
+    
+    if (pMechanism->mechanism != CKM_EC_KEY_PAIR_GEN) {
+        return CKR_MECHANISM_INVALID;
+    }
+    
+    // No HSM path on real ELE firmware yet (see ele-mailbox.h)
+    if (ele_mbox_depth() == 0) {
+        return CKR_FUNCTION_NOT_SUPPORTED;
+    }
+    
+    rv = ele_curve_from_template(pPublicKeyTemplate, ulPublicKeyAttributeCount, &curve);
+    if (rv == CKR_OK) {
+        rv = ele_objects_parse_attrs(pPublicKeyTemplate, ulPublicKeyAttributeCount, &pub_attrs);
+    }
+    if (rv == CKR_OK) {
+        rv = ele_objects_parse_attrs(pPrivateKeyTemplate, ulPrivateKeyAttributeCount, &priv_attrs);
+    }
+    if (rv != CKR_OK) {
+        return rv;
+    }
+    
+    rv = ele_session_acquire(hSession, &session);
+    if (rv != CKR_OK) {
+        return rv;
+    }
+    
+    // The session lock is not needed across the enclave round trip
+    ele_session_release(session);
+    
+    /*
+     * A key pre-generated while the board was idle saves the enclave
+     * keygen. Pooled keys are persistent, so only token keys use them; a
+     * session key has to be volatile and go away with its session.
+     */
+    if ((!priv_attrs.token || ele_keypool_take(curve, &key_id, pub, &pub_len) != 0) &&
+        ele_hsm_generate_key(ele_curve_bits(curve),
+                             priv_attrs.token ? ELE_KEY_LIFETIME_PERSISTENT : ELE_KEY_LIFETIME_VOLATILE,
+                             &key_id, pub, &pub_len) != 0) {
+        return CKR_DEVICE_ERROR;
+    }
+    
+    rv = ele_objects_add_keypair(key_id, curve, pub, pub_len, &pub_attrs, &priv_attrs,
+                                 hSession, phPublicKey, phPrivateKey);
+    if (rv != CKR_OK) {
+        // No object owns the key, so nothing else would ever delete it
+        ele_hsm_delete_key(key_id);
+    }
+    return rv;
+}
+
+// Host-side digest for the hashing ECDSA mechanisms, NULL for CKM_ECDSA
+static const EVP_MD *ele_sign_digest_md(CK_MECHANISM_TYPE mechanism) {
+    switch (mechanism) {
+        case CKM_ECDSA_SHA256: return EVP_sha256();
+        case CKM_ECDSA_SHA384: return EVP_sha384();
+        case CKM_ECDSA_SHA512: return EVP_sha512();
+        default: return NULL;
+    }
+}
+
+/*
+ * Finish a sign operation: feed the last data chunk into the host digest
+ * (or take it as the digest for CKM_ECDSA) and have the enclave sign it.
+ * Called with the session locked; always releases it. Length queries and
+ * short buffers keep the operation active as PKCS#11 requires.
+ */
+static CK_RV ele_sign_finish(ele_session_t *session,
+                             CK_BYTE_PTR pData,
+                             CK_ULONG ulDataLen,
+                             CK_BYTE_PTR pSignature,
+                             CK_ULONG_PTR pulSignatureLen) {
+    CK_BYTE digest[EVP_MAX_MD_SIZE];
+    unsigned int digest_len = 0;
+    uint32_t key_id = session->op_key_id;
+    size_t sig_len = 2 * ((ele_curve_bits(session->op_curve) + 7) / 8);
+    
+    if (pSignature == NULL) {
+        *pulSignatureLen = sig_len;
+        ele_session_release(session);
+        return CKR_OK;
+    }
+    
+    if (*pulSignatureLen < sig_len) {
+        *pulSignatureLen = sig_len;
+        ele_session_release(session);
+        return CKR_BUFFER_TOO_SMALL;
+    }
+    
+    if (session->op_md != NULL) {
+        if ((ulDataLen > 0 && EVP_DigestUpdate(session->op_md, pData, ulDataLen) != 1) ||
+            EVP_DigestFinal_ex(session->op_md, digest, &digest_len) != 1) {
+            ele_session_reset_op(session);
+            ele_session_release(session);
+            return CKR_GENERAL_ERROR;
+        }
+    } else {
+        if (ulDataLen == 0 || ulDataLen > sizeof(digest)) {
+            ele_session_reset_op(session);
+            ele_session_release(session);
+            return CKR_DATA_LEN_RANGE;
+        }
+        memcpy(digest, pData, ulDataLen);
+        digest_len = (unsigned int)ulDataLen;
+    }
+    
+    /*
+     * The operation ends here, so the session lock is dropped before the
+     * request is queued rather than held across the enclave round trip.
+     */
+    ele_session_reset_op(session);
+    ele_session_release(session);
+    
+    if (ele_hsm_sign_digest(key_id, digest, digest_len,
+                            pSignature, &sig_len) != 0) {
+        return CKR_DEVICE_ERROR;
+    }
+    
+    *pulSignatureLen = sig_len;
+    return CKR_OK;
+}
+
+CK_DEFINE_FUNCTION(CK_RV, C_SignInit)(CK_ULONG hSession,
+                                     CK_MECHANISM *pMechanism,
+                                     CK_OBJECT_HANDLE hKey) {
+    ele_session_t *session;
+    const EVP_MD *md;
+    uint32_t key_id;
+    unsigned int curve;
+    CK_RV rv;
+    
+    if (pMechanism == NULL) {
+        return CKR_ARGUMENTS_BAD;
+    }
+    
+    md = ele_sign_digest_md(pMechanism->mechanism);
+    if (md == NULL && pMechanism->mechanism != CKM_ECDSA) {
+        return CKR_MECHANISM_INVALID;
+    }
+    
+    if (ele_mbox_depth() == 0) {
+        return CKR_FUNCTION_NOT_SUPPORTED;
+    }
+    
+    rv = ele_objects_get_private_key(hKey, &key_id, &curve);
+    if (rv != CKR_OK) {
+        return rv;
+    }
+    
+    rv = ele_session_acquire(hSession, &session);
+    if (rv != CKR_OK) {
+        return rv;
+    }
+    
+    if (session->op != ELE_OP_NONE) {
+        ele_session_release(session);
+        return CKR_OPERATION_ACTIVE;
+    }
+    
+    if (md != NULL) {
+        session->op_md = EVP_MD_CTX_new();
+        if (session->op_md == NULL) {
+            ele_session_release(session);
+            return CKR_HOST_MEMORY;
+        }
+        if (EVP_DigestInit_ex(session->op_md, md, NULL) != 1) {
+            ele_session_reset_op(session);
+            ele_session_release(session);
+            return CKR_GENERAL_ERROR;
+        }
+    }
+    
+    session->op = ELE_OP_SIGN;
+    session->op_mechanism = pMechanism->mechanism;
+    session->op_key_id = key_id;
+    session->op_curve = curve;
+    
+    ele_session_release(session);
+    return CKR_OK;
+}
+
+CK_DEFINE_FUNCTION(CK_RV, C_Sign)(CK_ULONG hSession,
+                                 CK_BYTE_PTR pData,
+                                 CK_ULONG ulDataLen,
+                                 CK_BYTE_PTR pSignature,
+                                 CK_ULONG_PTR pulSignatureLen) {
+    ele_session_t *session;
+    CK_RV rv;
+    
+    ELE_LOG("C_Sign called");
+    
+    if (pulSignatureLen == NULL || (pData == NULL && ulDataLen > 0)) {
+        return CKR_ARGUMENTS_BAD;
+    }
+    
+    rv = ele_session_acquire(hSession, &session);
+    if (rv != CKR_OK) {
+        return rv;
+    }
+    
+    if (session->op != ELE_OP_SIGN) {
+        ele_session_release(session);
+        return CKR_OPERATION_NOT_INITIALIZED;
+    }
+    
+    if (session->op_multipart) {
+        ele_session_release(session);
+        return CKR_OPERATION_ACTIVE;
+    }
+    
+    return ele_sign_finish(session, pData, ulDataLen, pSignature, pulSignatureLen);
+}
+
+CK_DEFINE_FUNCTION(CK_RV, C_SignUpdate)(CK_ULONG hSession,
+                                       CK_BYTE_PTR pPart,
+                                       CK_ULONG ulPartLen) {
+    ele_session_t *session;
+    CK_RV rv;
+    
+    if (pPart == NULL && ulPartLen > 0) {
+        return CKR_ARGUMENTS_BAD;
+    }
+    
+    rv = ele_session_acquire(hSession, &session);
+    if (rv != CKR_OK) {
+        return rv;
+    }
+    
+    if (session->op != ELE_OP_SIGN) {
+        ele_session_release(session);
+        return CKR_OPERATION_NOT_INITIALIZED;
+    }
+    
+    // Raw CKM_ECDSA takes a finished digest and is single-part only
+    if (session->op_md == NULL) {
+        ele_session_reset_op(session);
+        ele_session_release(session);
+        return CKR_FUNCTION_NOT_SUPPORTED;
+    }
+    
+    // Hashing happens here, under this session's lock only
+    if (ulPartLen > 0 && EVP_DigestUpdate(session->op_md, pPart, ulPartLen) != 1) {
+        ele_session_reset_op(session);
+        ele_session_release(session);
+        return CKR_GENERAL_ERROR;
+    }
+    
+    session->op_multipart = 1;
+    ele_session_release(session);
+    return CKR_OK;
+}
+
+CK_DEFINE_FUNCTION(CK_RV, C_SignFinal)(CK_ULONG hSession,
+                                      CK_BYTE_PTR pSignature,
+                                      CK_ULONG_PTR pulSignatureLen) {
+    ele_session_t *session;
+    CK_RV rv;
+    
+    if (pulSignatureLen == NULL) {
+        return CKR_ARGUMENTS_BAD;
+    }
+    
+    rv = ele_session_acquire(hSession, &session);
+    if (rv != CKR_OK) {
+        return rv;
+    }
+    
+    if (session->op != ELE_OP_SIGN) {
+        ele_session_release(session);
+        return CKR_OPERATION_NOT_INITIALIZED;
+    }
+    
+    if (session->op_md == NULL) {
+        ele_session_reset_op(session);
+        ele_session_release(session);
+        return CKR_FUNCTION_NOT_SUPPORTED;
+    }
+    
+    return ele_sign_finish(session, NULL, 0, pSignature, pulSignatureLen);
+}
+
+// Object management functions
+CK_DEFINE_FUNCTION(CK_RV, C_CreateObject)(CK_ULONG hSession,
+                                         CK_ATTRIBUTE *pTemplate,
+                                         CK_ULONG ulCount,
+                                         CK_OBJECT_HANDLE_PTR phObject) {
+    ele_session_t *session;
+    CK_RV rv;
+    
+    if ((pTemplate == NULL && ulCount > 0) || phObject == NULL) {
+        return CKR_ARGUMENTS_BAD;
+    }
+    
+    rv = ele_session_acquire(hSession, &session);
+    if (rv != CKR_OK) {
+        return rv;
+    }
+    ele_session_release(session);
+    
+    return ele_objects_create(pTemplate, ulCount, hSession, phObject);
+}
+
+CK_DEFINE_FUNCTION(CK_RV, C_DestroyObject)(CK_ULONG hSession,
+                                          CK_OBJECT_HANDLE hObject) {
+    ele_session_t *session;
+    CK_RV rv;
+    
+    rv = ele_session_acquire(hSession, &session);
+    if (rv != CKR_OK) {
+        return rv;
+    }
+    ele_session_release(session);
+    
+    return ele_objects_destroy(hObject);
+}
+
+CK_DEFINE_FUNCTION(CK_RV, C_GetAttributeValue)(CK_ULONG hSession,
+                                              CK_OBJECT_HANDLE hObject,
+                                              CK_ATTRIBUTE *pTemplate,
+                                              CK_ULONG ulCount) {
+    ele_session_t *session;
+    CK_RV rv;
+    
+    if (pTemplate == NULL && ulCount > 0) {
+        return CKR_ARGUMENTS_BAD;
+    }
+    
+    rv = ele_session_acquire(hSession, &session);
+    if (rv != CKR_OK) {
+        return rv;
+    }
+    ele_session_release(session);
+    
+    return ele_objects_get_attributes(hObject, pTemplate, ulCount);
+}
+
+CK_DEFINE_FUNCTION(CK_RV, C_FindObjectsInit)(CK_ULONG hSession,
+                                            CK_ATTRIBUTE *pTemplate,
+                                            CK_ULONG ulCount) {
+    ele_session_t *session;
+    CK_RV rv;
+    
+    if (pTemplate == NULL && ulCount > 0) {
+        return CKR_ARGUMENTS_BAD;
+    }
+    
+    rv = ele_session_acquire(hSession, &session);
+    if (rv != CKR_OK) {
+        return rv;
+    }
+    
+    if (session->find_active) {
+        ele_session_release(session);
+        return CKR_OPERATION_ACTIVE;
+    }
+    
+    // Matches are resolved once here; C_FindObjects just pages through them
+    rv = ele_objects_find(pTemplate, ulCount, &session->find_handles, &session->find_count);
+    if (rv == CKR_OK) {
+        session->find_pos = 0;
+        session->find_active = 1;
+    }
+    
+    ele_session_release(session);
+    return rv;
+}
+
+CK_DEFINE_FUNCTION(CK_RV, C_FindObjects)(CK_ULONG hSession,
+                                        CK_OBJECT_HANDLE_PTR phObject,
+                                        CK_ULONG ulMaxObjectCount,
+                                        CK_ULONG_PTR pulObjectCount) {
+    ele_session_t *session;
+    CK_ULONG n;
+    CK_RV rv;
+    
+    if ((phObject == NULL && ulMaxObjectCount > 0) || pulObjectCount == NULL) {
+        return CKR_ARGUMENTS_BAD;
+    }
+    
+    rv = ele_session_acquire(hSession, &session);
+    if (rv != CKR_OK) {
+        return rv;
+    }
+    
+    if (!session->find_active) {
+        ele_session_release(session);
+        return CKR_OPERATION_NOT_INITIALIZED;
+    }
+    
+    n = session->find_count - session->find_pos;
+    if (n > ulMaxObjectCount) {
+        n = ulMaxObjectCount;
+    }
+    if (n > 0) {
+        memcpy(phObject, session->find_handles + session->find_pos, n * sizeof(*phObject));
+    }
+    session->find_pos += n;
+    *pulObjectCount = n;
+    
+    ele_session_release(session);
+    return CKR_OK;
+}
+
+CK_DEFINE_FUNCTION(CK_RV, C_FindObjectsFinal)(CK_ULONG hSession) {
+    ele_session_t *session;
+    CK_RV rv;
+    
+    rv = ele_session_acquire(hSession, &session);
+    if (rv != CKR_OK) {
+        return rv;
+    }
+    
+    if (!session->find_active) {
+        ele_session_release(session);
+        return CKR_OPERATION_NOT_INITIALIZED;
+    }
+    
+    ele_session_reset_find(session);
+    ele_session_release(session);
+    return CKR_OK;
+}
+
+// Random number generation
+CK_DEFINE_FUNCTION(CK_RV, C_SeedRandom)(CK_ULONG hSession,
+                                       CK_BYTE_PTR pSeed,
+                                       CK_ULONG ulSeedLen) {
+    ele_session_t *session;
+    CK_RV rv;
+    
+    rv = ele_session_acquire(hSession, &session);
+    if (rv != CKR_OK) {
+        return rv;
+    }
+    ele_session_release(session);
+    
+    // All entropy comes from the ELE TRNG, which cannot be seeded
+    return CKR_RANDOM_SEED_NOT_SUPPORTED;
+}
+
+CK_DEFINE_FUNCTION(CK_RV, C_GenerateRandom)(CK_ULONG hSession,
+                                           CK_BYTE_PTR pRandomData,
+                                           CK_ULONG ulRandomLen) {
+    ele_session_t *session;
+    CK_RV rv;
+    
+    if (pRandomData == NULL && ulRandomLen > 0) {
+        return CKR_ARGUMENTS_BAD;
+    }
+    
+    rv = ele_session_acquire(hSession, &session);
+    if (rv != CKR_OK) {
+        return rv;
+    }
+    ele_session_release(session);
+    
+    if (ele_mbox_depth() == 0) {
+        return CKR_RANDOM_NO_RNG;
+    }
+    
+    if (ele_rng_generate(pRandomData, ulRandomLen) != 0) {
+        return CKR_DEVICE_ERROR;
+    }
+    
+    return CKR_OK;
+}
+
+// Legacy parallel-function management (always CKR_FUNCTION_NOT_PARALLEL)
+CK_DEFINE_FUNCTION(CK_RV, C_GetFunctionStatus)(CK_SESSION_HANDLE hSession) {
+    if (!ele_initialized) {
+        return CKR_CRYPTOKI_NOT_INITIALIZED;
+    }
+    return CKR_FUNCTION_NOT_PARALLEL;
+}
+
+CK_DEFINE_FUNCTION(CK_RV, C_CancelFunction)(CK_SESSION_HANDLE hSession) {
+    if (!ele_initialized) {
+        return CKR_CRYPTOKI_NOT_INITIALIZED;
+    }
+    return CKR_FUNCTION_NOT_PARALLEL;
+}
+
+// The single ELE slot is never inserted or removed
+CK_DEFINE_FUNCTION(CK_RV, C_WaitForSlotEvent)(CK_FLAGS flags,
+                                             CK_SLOT_ID_PTR pSlot,
+                                             CK_VOID_PTR pReserved) {
+    if (!ele_initialized) {
+        return CKR_CRYPTOKI_NOT_INITIALIZED;
+    }
+    if (flags & CKF_DONT_BLOCK) {
+        return CKR_NO_EVENT;
+    }
+    return CKR_FUNCTION_NOT_SUPPORTED;
+}
+
+// Functions not supported by the ELE token
+CK_DEFINE_FUNCTION(CK_RV, C_InitToken)(CK_SLOT_ID slotID,
+                                       CK_UTF8CHAR_PTR pPin,
+                                       CK_ULONG ulPinLen,
+                                       CK_UTF8CHAR_PTR pLabel) {
+    return CKR_FUNCTION_NOT_SUPPORTED;
+}
+
+CK_DEFINE_FUNCTION(CK_RV, C_InitPIN)(CK_SESSION_HANDLE hSession,
+                                     CK_UTF8CHAR_PTR pPin,
+                                     CK_ULONG ulPinLen) {
+    return CKR_FUNCTION_NOT_SUPPORTED;
+}
+
+CK_DEFINE_FUNCTION(CK_RV, C_SetPIN)(CK_SESSION_HANDLE hSession,
+                                    CK_UTF8CHAR_PTR pOldPin,
+                                    CK_ULONG ulOldLen,
+                                    CK_UTF8CHAR_PTR pNewPin,
+                                    CK_ULONG ulNewLen) {
+    return CKR_FUNCTION_NOT_SUPPORTED;
+}
+
+CK_DEFINE_FUNCTION(CK_RV, C_GetOperationState)(CK_SESSION_HANDLE hSession,
+                                               CK_BYTE_PTR pOperationState,
+                                               CK_ULONG_PTR pulOperationStateLen) {
+    return CKR_FUNCTION_NOT_SUPPORTED;
+}
+
+CK_DEFINE_FUNCTION(CK_RV, C_SetOperationState)(CK_SESSION_HANDLE hSession,
+                                               CK_BYTE_PTR pOperationState,
+                                               CK_ULONG ulOperationStateLen,
+                                               CK_OBJECT_HANDLE hEncryptionKey,
+                                               CK_OBJECT_HANDLE hAuthenticationKey) {
+    return CKR_FUNCTION_NOT_SUPPORTED;
+}
+
+CK_DEFINE_FUNCTION(CK_RV, C_CopyObject)(CK_SESSION_HANDLE hSession,
+                                        CK_OBJECT_HANDLE hObject,
+                                        CK_ATTRIBUTE_PTR pTemplate,
+                                        CK_ULONG ulCount,
+                                        CK_OBJECT_HANDLE_PTR phNewObject) {
+    return CKR_FUNCTION_NOT_SUPPORTED;
+}
+
+CK_DEFINE_FUNCTION(CK_RV, C_GetObjectSize)(CK_SESSION_HANDLE hSession,
+                                           CK_OBJECT_HANDLE hObject,
+                                           CK_ULONG_PTR pulSize) {
+    return CKR_FUNCTION_NOT_SUPPORTED;
+}
+
+CK_DEFINE_FUNCTION(CK_RV, C_SetAttributeValue)(CK_SESSION_HANDLE hSession,
+                                               CK_OBJECT_HANDLE hObject,
+                                               CK_ATTRIBUTE_PTR pTemplate,
+                                               CK_ULONG ulCount) {
+    return CKR_FUNCTION_NOT_SUPPORTED;
+}
+
+CK_DEFINE_FUNCTION(CK_RV, C_EncryptInit)(CK_SESSION_HANDLE hSession,
+                                         CK_MECHANISM_PTR pMechanism,
+                                         CK_OBJECT_HANDLE hKey) {
+    return CKR_FUNCTION_NOT_SUPPORTED;
+}
+
+CK_DEFINE_FUNCTION(CK_RV, C_Encrypt)(CK_SESSION_HANDLE hSession,
+                                     CK_BYTE_PTR pData,
+                                     CK_ULONG ulDataLen,
+                                     CK_BYTE_PTR pEncryptedData,
+                                     CK_ULONG_PTR pulEncryptedDataLen) {
+    return CKR_FUNCTION_NOT_SUPPORTED;
+}
+
+CK_DEFINE_FUNCTION(CK_RV, C_EncryptUpdate)(CK_SESSION_HANDLE hSession,
+                                           CK_BYTE_PTR pPart,
+                                           CK_ULONG ulPartLen,
+                                           CK_BYTE_PTR pEncryptedPart,
+                                           CK_ULONG_PTR pulEncryptedPartLen) {
+    return CKR_FUNCTION_NOT_SUPPORTED;
+}
+
+CK_DEFINE_FUNCTION(CK_RV, C_EncryptFinal)(CK_SESSION_HANDLE hSession,
+                                          CK_BYTE_PTR pLastEncryptedPart,
+                                          CK_ULONG_PTR pulLastEncryptedPartLen) {
+    return CKR_FUNCTION_NOT_SUPPORTED;
+}
+
+CK_DEFINE_FUNCTION(CK_RV, C_DecryptInit)(CK_SESSION_HANDLE hSession,
+                                         CK_MECHANISM_PTR pMechanism,
+                                         CK_OBJECT_HANDLE hKey) {
+    return CKR_FUNCTION_NOT_SUPPORTED;
+}
+
+CK_DEFINE_FUNCTION(CK_RV, C_Decrypt)(CK_SESSION_HANDLE hSession,
+                                     CK_BYTE_PTR pEncryptedData,
+                                     CK_ULONG ulEncryptedDataLen,
+                                     CK_BYTE_PTR pData,
+                                     CK_ULONG_PTR pulDataLen) {
+    return CKR_FUNCTION_NOT_SUPPORTED;
+}
+
+CK_DEFINE_FUNCTION(CK_RV, C_DecryptUpdate)(CK_SESSION_HANDLE hSession,
+                                           CK_BYTE_PTR pEncryptedPart,
+                                           CK_ULONG ulEncryptedPartLen,
+                                           CK_BYTE_PTR pPart,
+                                           CK_ULONG_PTR pulPartLen) {
+    return CKR_FUNCTION_NOT_SUPPORTED;
+}
+
+CK_DEFINE_FUNCTION(CK_RV, C_DecryptFinal)(CK_SESSION_HANDLE hSession,
+                                          CK_BYTE_PTR pLastPart,
+                                          CK_ULONG_PTR pulLastPartLen) {
+    return CKR_FUNCTION_NOT_SUPPORTED;
+}
+
+// Digest mechanisms and their dispatcher algorithm
+static int ele_digest_alg(CK_MECHANISM_TYPE mechanism, ele_crypto_alg_t *alg, const EVP_MD **md) {
+    switch (mechanism) {
+        case CKM_SHA256: *alg = ELE_CRYPTO_SHA256; *md = EVP_sha256(); return 0;
+        case CKM_SHA384: *alg = ELE_CRYPTO_SHA384; *md = EVP_sha384(); return 0;
+        case CKM_SHA512: *alg = ELE_CRYPTO_SHA512; *md = EVP_sha512(); return 0;
+        default: return -1;
+    }
+}
+
+/*
+ * Length query and buffer check shared by C_Digest and C_DigestFinal.
+ * Returns CKR_OK with *done == 0 when the caller should produce the
+ * digest; otherwise the session is released and the result returned.
+ */
+static CK_RV ele_digest_check_output(ele_session_t *session,
+                                     CK_BYTE_PTR pDigest,
+                                     CK_ULONG_PTR pulDigestLen,
+                                     int *done) {
+    ele_crypto_alg_t alg;
+    const EVP_MD *md;
+    CK_ULONG len;
+    
+    *done = 1;
+    if (ele_digest_alg(session->op_mechanism, &alg, &md) != 0) {
+        ele_session_reset_op(session);
+        ele_session_release(session);
+        return CKR_MECHANISM_INVALID;
+    }
+    len = (CK_ULONG)EVP_MD_get_size(md);
+    
+    if (pDigest == NULL) {
+        *pulDigestLen = len;
+        ele_session_release(session);
+        return CKR_OK;
+    }
+    
+    if (*pulDigestLen < len) {
+        *pulDigestLen = len;
+        ele_session_release(session);
+        return CKR_BUFFER_TOO_SMALL;
+    }
+    
+    *done = 0;
+    return CKR_OK;
+}
+
+CK_DEFINE_FUNCTION(CK_RV, C_DigestInit)(CK_SESSION_HANDLE hSession,
+                                        CK_MECHANISM_PTR pMechanism) {
+    ele_session_t *session;
+    ele_crypto_alg_t alg;
+    const EVP_MD *md;
+    CK_RV rv;
+    
+    if (pMechanism == NULL) {
+        return CKR_ARGUMENTS_BAD;
+    }
+    
+    if (ele_digest_alg(pMechanism->mechanism, &alg, &md) != 0) {
+        return CKR_MECHANISM_INVALID;
+    }
+    
+    rv = ele_session_acquire(hSession, &session);
+    if (rv != CKR_OK) {
+        return rv;
+    }
+    
+    if (session->op != ELE_OP_NONE) {
+        ele_session_release(session);
+        return CKR_OPERATION_ACTIVE;
+    }
+    
+    // The streaming context is only created if C_DigestUpdate is used
+    session->op = ELE_OP_DIGEST;
+    session->op_mechanism = pMechanism->mechanism;
+    
+    ele_session_release(session);
+    return CKR_OK;
+}
+
+CK_DEFINE_FUNCTION(CK_RV, C_Digest)(CK_SESSION_HANDLE hSession,
+                                    CK_BYTE_PTR pData,
+                                    CK_ULONG ulDataLen,
+                                    CK_BYTE_PTR pDigest,
+                                    CK_ULONG_PTR pulDigestLen) {
+    ele_session_t *session;
+    ele_crypto_alg_t alg;
+    const EVP_MD *md;
+    size_t digest_len = ELE_CRYPTO_MAX_DIGEST;
+    int done;
+    CK_RV rv;
+    
+    if (pulDigestLen == NULL || (pData == NULL && ulDataLen > 0)) {
+        return CKR_ARGUMENTS_BAD;
+    }
+    
+    rv = ele_session_acquire(hSession, &session);
+    if (rv != CKR_OK) {
+        return rv;
+    }
+    
+    if (session->op != ELE_OP_DIGEST) {
+        ele_session_release(session);
+        return CKR_OPERATION_NOT_INITIALIZED;
+    }
+    
+    if (session->op_multipart) {
+        ele_session_release(session);
+        return CKR_OPERATION_ACTIVE;
+    }
+    
+    rv = ele_digest_check_output(session, pDigest, pulDigestLen, &done);
+    if (done) {
+        return rv;
+    }
+    
+    // As for signing, the enclave round trip happens without the session lock
+    rv = ele_digest_alg(session->op_mechanism, &alg, &md) == 0 ? CKR_OK : CKR_MECHANISM_INVALID;
+    ele_session_reset_op(session);
+    ele_session_release(session);
+    if (rv != CKR_OK) {
+        return rv;
+    }
+    
+    if (ele_crypto_digest(alg, pData, ulDataLen, pDigest, &digest_len) != 0) {
+        return CKR_DEVICE_ERROR;
+    }
+    
+    *pulDigestLen = digest_len;
+    return CKR_OK;
+}
+
+CK_DEFINE_FUNCTION(CK_RV, C_DigestUpdate)(CK_SESSION_HANDLE hSession,
+                                          CK_BYTE_PTR pPart,
+                                          CK_ULONG ulPartLen) {
+    ele_session_t *session;
+    ele_crypto_alg_t alg;
+    const EVP_MD *md;
+    CK_RV rv;
+    
+    if (pPart == NULL && ulPartLen > 0) {
+        return CKR_ARGUMENTS_BAD;
+    }
+    
+    rv = ele_session_acquire(hSession, &session);
+    if (rv != CKR_OK) {
+        return rv;
+    }
+    
+    if (session->op != ELE_OP_DIGEST) {
+        ele_session_release(session);
+        return CKR_OPERATION_NOT_INITIALIZED;
+    }
+    
+    if (session->op_md == NULL) {
+        if (ele_digest_alg(session->op_mechanism, &alg, &md) != 0) {
+            ele_session_reset_op(session);
+            ele_session_release(session);
+            return CKR_MECHANISM_INVALID;
+        }
+        session->op_md = EVP_MD_CTX_new();
+        if (session->op_md == NULL || EVP_DigestInit_ex(session->op_md, md, NULL) != 1) {
+            ele_session_reset_op(session);
+            ele_session_release(session);
+            return CKR_HOST_MEMORY;
+        }
+    }
+    
+    if (ulPartLen > 0 && EVP_DigestUpdate(session->op_md, pPart, ulPartLen) != 1) {
+        ele_session_reset_op(session);
+        ele_session_release(session);
+        return CKR_GENERAL_ERROR;
+    }
+    
+    session->op_multipart = 1;
+    ele_session_release(session);
+    return CKR_OK;
+}
+
+CK_DEFINE_FUNCTION(CK_RV, C_DigestKey)(CK_SESSION_HANDLE hSession,
+                                       CK_OBJECT_HANDLE hKey) {
+    return CKR_FUNCTION_NOT_SUPPORTED;
+}
+
+CK_DEFINE_FUNCTION(CK_RV, C_DigestFinal)(CK_SESSION_HANDLE hSession,
+                                         CK_BYTE_PTR pDigest,
+                                         CK_ULONG_PTR pulDigestLen) {
+    ele_session_t *session;
+    unsigned int digest_len = 0;
+    int done;
+    CK_RV rv;
+    
+    if (pulDigestLen == NULL) {
+        return CKR_ARGUMENTS_BAD;
+    }
+    
+    rv = ele_session_acquire(hSession, &session);
+    if (rv != CKR_OK) {
+        return rv;
+    }
+    
+    if (session->op != ELE_OP_DIGEST) {
+        ele_session_release(session);
+        return CKR_OPERATION_NOT_INITIALIZED;
+    }
+    
+    rv = ele_digest_check_output(session, pDigest, pulDigestLen, &done);
+    if (done) {
+        return rv;
+    }
+    
+    // C_DigestFinal straight after C_DigestInit digests the empty message
+    if (session->op_md == NULL) {
+        ele_crypto_alg_t alg;
+        const EVP_MD *md;
+        size_t len = ELE_CRYPTO_MAX_DIGEST;
+        
+        rv = ele_digest_alg(session->op_mechanism, &alg, &md) == 0 ? CKR_OK : CKR_MECHANISM_INVALID;
+        ele_session_reset_op(session);
+        ele_session_release(session);
+        if (rv != CKR_OK) {
+            return rv;
+        }
+        if (ele_crypto_digest(alg, NULL, 0, pDigest, &len) != 0) {
+            return CKR_DEVICE_ERROR;
+        }
+        *pulDigestLen = len;
+        return CKR_OK;
+    }
+    
+    rv = EVP_DigestFinal_ex(session->op_md, pDigest, &digest_len) == 1 ? CKR_OK : CKR_GENERAL_ERROR;
+    ele_session_reset_op(session);
+    ele_session_release(session);
+    if (rv == CKR_OK) {
+        *pulDigestLen = digest_len;
+    }
+    return rv;
+}
+
+CK_DEFINE_FUNCTION(CK_RV, C_SignRecoverInit)(CK_SESSION_HANDLE hSession,
+                                             CK_MECHANISM_PTR pMechanism,
+                                             CK_OBJECT_HANDLE hKey) {
+    return CKR_FUNCTION_NOT_SUPPORTED;
+}
+
+CK_DEFINE_FUNCTION(CK_RV, C_SignRecover)(CK_SESSION_HANDLE hSession,
+                                         CK_BYTE_PTR pData,
+                                         CK_ULONG ulDataLen,
+                                         CK_BYTE_PTR pSignature,
+                                         CK_ULONG_PTR pulSignatureLen) {
+    return CKR_FUNCTION_NOT_SUPPORTED;
+}
+
+CK_DEFINE_FUNCTION(CK_RV, C_VerifyInit)(CK_SESSION_HANDLE hSession,
+                                        CK_MECHANISM_PTR pMechanism,
+                                        CK_OBJECT_HANDLE hKey) {
+    return CKR_FUNCTION_NOT_SUPPORTED;
+}
+
+CK_DEFINE_FUNCTION(CK_RV, C_Verify)(CK_SESSION_HANDLE hSession,
+                                    CK_BYTE_PTR pData,
+                                    CK_ULONG ulDataLen,
+                                    CK_BYTE_PTR pSignature,
+                                    CK_ULONG ulSignatureLen) {
+    return CKR_FUNCTION_NOT_SUPPORTED;
+}
+
+CK_DEFINE_FUNCTION(CK_RV, C_VerifyUpdate)(CK_SESSION_HANDLE hSession,
+                                          CK_BYTE_PTR pPart,
+                                          CK_ULONG ulPartLen) {
+    return CKR_FUNCTION_NOT_SUPPORTED;
+}
+
+CK_DEFINE_FUNCTION(CK_RV, C_VerifyFinal)(CK_SESSION_HANDLE hSession,
+                                         CK_BYTE_PTR pSignature,
+                                         CK_ULONG ulSignatureLen) {
+    return CKR_FUNCTION_NOT_SUPPORTED;
+}
+
+CK_DEFINE_FUNCTION(CK_RV, C_VerifyRecoverInit)(CK_SESSION_HANDLE hSession,
+                                               CK_MECHANISM_PTR pMechanism,
+                                               CK_OBJECT_HANDLE hKey) {
+    return CKR_FUNCTION_NOT_SUPPORTED;
+}
+
+CK_DEFINE_FUNCTION(CK_RV, C_VerifyRecover)(CK_SESSION_HANDLE hSession,
+                                           CK_BYTE_PTR pSignature,
+                                           CK_ULONG ulSignatureLen,
+                                           CK_BYTE_PTR pData,
+                                           CK_ULONG_PTR pulDataLen) {
+    return CKR_FUNCTION_NOT_SUPPORTED;
+}
+
+CK_DEFINE_FUNCTION(CK_RV, C_DigestEncryptUpdate)(CK_SESSION_HANDLE hSession,
+                                                 CK_BYTE_PTR pPart,
+                                                 CK_ULONG ulPartLen,
+                                                 CK_BYTE_PTR pEncryptedPart,
+                                                 CK_ULONG_PTR pulEncryptedPartLen) {
+    return CKR_FUNCTION_NOT_SUPPORTED;
+}
+
+CK_DEFINE_FUNCTION(CK_RV, C_DecryptDigestUpdate)(CK_SESSION_HANDLE hSession,
+                                                 CK_BYTE_PTR pEncryptedPart,
+                                                 CK_ULONG ulEncryptedPartLen,
+                                                 CK_BYTE_PTR pPart,
+                                                 CK_ULONG_PTR pulPartLen) {
+    return CKR_FUNCTION_NOT_SUPPORTED;
+}
+
+CK_DEFINE_FUNCTION(CK_RV, C_SignEncryptUpdate)(CK_SESSION_HANDLE hSession,
+                                               CK_BYTE_PTR pPart,
+                                               CK_ULONG ulPartLen,
+                                               CK_BYTE_PTR pEncryptedPart,
+                                               CK_ULONG_PTR pulEncryptedPartLen) {
+    return CKR_FUNCTION_NOT_SUPPORTED;
+}
+
+CK_DEFINE_FUNCTION(CK_RV, C_DecryptVerifyUpdate)(CK_SESSION_HANDLE hSession,
+                                                 CK_BYTE_PTR pEncryptedPart,
+                                                 CK_ULONG ulEncryptedPartLen,
+                                                 CK_BYTE_PTR pPart,
+                                                 CK_ULONG_PTR pulPartLen) {
+    return CKR_FUNCTION_NOT_SUPPORTED;
+}
+
+CK_DEFINE_FUNCTION(CK_RV, C_GenerateKey)(CK_SESSION_HANDLE hSession,
+                                         CK_MECHANISM_PTR pMechanism,
+                                         CK_ATTRIBUTE_PTR pTemplate,
+                                         CK_ULONG ulCount,
+                                         CK_OBJECT_HANDLE_PTR phKey) {
+    return CKR_FUNCTION_NOT_SUPPORTED;
+}
+
+CK_DEFINE_FUNCTION(CK_RV, C_WrapKey)(CK_SESSION_HANDLE hSession,
+                                     CK_MECHANISM_PTR pMechanism,
+                                     CK_OBJECT_HANDLE hWrappingKey,
+                                     CK_OBJECT_HANDLE hKey,
+                                     CK_BYTE_PTR pWrappedKey,
+                                     CK_ULONG_PTR pulWrappedKeyLen) {
+    return CKR_FUNCTION_NOT_SUPPORTED;
+}
+
+CK_DEFINE_FUNCTION(CK_RV, C_UnwrapKey)(CK_SESSION_HANDLE hSession,
+                                       CK_MECHANISM_PTR pMechanism,
+                                       CK_OBJECT_HANDLE hUnwrappingKey,
+                                       CK_BYTE_PTR pWrappedKey,
+                                       CK_ULONG ulWrappedKeyLen,
+                                       CK_ATTRIBUTE_PTR pTemplate,
+                                       CK_ULONG ulAttributeCount,
+                                       CK_OBJECT_HANDLE_PTR phKey) {
+    return CKR_FUNCTION_NOT_SUPPORTED;
+}
+
+CK_DEFINE_FUNCTION(CK_RV, C_DeriveKey)(CK_SESSION_HANDLE hSession,
+                                       CK_MECHANISM_PTR pMechanism,
+                                       CK_OBJECT_HANDLE hBaseKey,
+                                       CK_ATTRIBUTE_PTR pTemplate,
+                                       CK_ULONG ulAttributeCount,
+                                       CK_OBJECT_HANDLE_PTR phKey) {
+    return CKR_FUNCTION_NOT_SUPPORTED;
+}
+
+CK_DEFINE_FUNCTION(CK_RV, C_GetFunctionList)(CK_FUNCTION_LIST_PTR_PTR ppFunctionList);
+
+// Function list in specification order; designated initializers tie each entry to its member
+static CK_FUNCTION_LIST ele_function_list = {
+    .version = { 2, 40 },
+    .C_Initialize = C_Initialize,
+    .C_Finalize = C_Finalize,
+    .C_GetInfo = C_GetInfo,
+    .C_GetFunctionList = C_GetFunctionList,
+    .C_GetSlotList = C_GetSlotList,
+    .C_GetSlotInfo = C_GetSlotInfo,
+    .C_GetTokenInfo = C_GetTokenInfo,
+    .C_GetMechanismList = C_GetMechanismList,
+    .C_GetMechanismInfo = C_GetMechanismInfo,
+    .C_InitToken = C_InitToken,
+    .C_InitPIN = C_InitPIN,
+    .C_SetPIN = C_SetPIN,
+    .C_OpenSession = C_OpenSession,
+    .C_CloseSession = C_CloseSession,
+    .C_CloseAllSessions = C_CloseAllSessions,
+    .C_GetSessionInfo = C_GetSessionInfo,
+    .C_GetOperationState = C_GetOperationState,
+    .C_SetOperationState = C_SetOperationState,
+    .C_Login = C_Login,
+    .C_Logout = C_Logout,
+    .C_CreateObject = C_CreateObject,
+    .C_CopyObject = C_CopyObject,
+    .C_DestroyObject = C_DestroyObject,
+    .C_GetObjectSize = C_GetObjectSize,
+    .C_GetAttributeValue = C_GetAttributeValue,
+    .C_SetAttributeValue = C_SetAttributeValue,
+    .C_FindObjectsInit = C_FindObjectsInit,
+    .C_FindObjects = C_FindObjects,
+    .C_FindObjectsFinal = C_FindObjectsFinal,
+    .C_EncryptInit = C_EncryptInit,
+    .C_Encrypt = C_Encrypt,
+    .C_EncryptUpdate = C_EncryptUpdate,
+    .C_EncryptFinal = C_EncryptFinal,
+    .C_DecryptInit = C_DecryptInit,
+    .C_Decrypt = C_Decrypt,
+    .C_DecryptUpdate = C_DecryptUpdate,
+    .C_DecryptFinal = C_DecryptFinal,
+    .C_DigestInit = C_DigestInit,
+    .C_Digest = C_Digest,
+    .C_DigestUpdate = C_DigestUpdate,
+    .C_DigestKey = C_DigestKey,
+    .C_DigestFinal = C_DigestFinal,
+    .C_SignInit = C_SignInit,
+    .C_Sign = C_Sign,
+    .C_SignUpdate = C_SignUpdate,
+    .C_SignFinal = C_SignFinal,
+    .C_SignRecoverInit = C_SignRecoverInit,
+    .C_SignRecover = C_SignRecover,
+    .C_VerifyInit = C_VerifyInit,
+    .C_Verify = C_Verify,
+    .C_VerifyUpdate = C_VerifyUpdate,
+    .C_VerifyFinal = C_VerifyFinal,
+    .C_VerifyRecoverInit = C_VerifyRecoverInit,
+    .C_VerifyRecover = C_VerifyRecover,
+    .C_DigestEncryptUpdate = C_DigestEncryptUpdate,
+    .C_DecryptDigestUpdate = C_DecryptDigestUpdate,
+    .C_SignEncryptUpdate = C_SignEncryptUpdate,
+    .C_DecryptVerifyUpdate = C_DecryptVerifyUpdate,
+    .C_GenerateKey = C_GenerateKey,
+    .C_GenerateKeyPair = C_GenerateKeyPair,
+    .C_WrapKey = C_WrapKey,
+    .C_UnwrapKey = C_UnwrapKey,
+    .C_DeriveKey = C_DeriveKey,
+    .C_SeedRandom = C_SeedRandom,
+    .C_GenerateRandom = C_GenerateRandom,
+    .C_GetFunctionStatus = C_GetFunctionStatus,
+    .C_CancelFunction = C_CancelFunction,
+    .C_WaitForSlotEvent = C_WaitForSlotEvent,
+};
+
+/*
+ * Traced entry points: with ELE_PKCS11_TRACE=stats or ring the application
+ * gets a function list whose implemented entries time the call and record
+ * it (arg = first handle parameter). Entries that only return
+ * CKR_FUNCTION_NOT_SUPPORTED are not worth timing and stay direct.
+ */
+#define ELE_TRACED_FUNCTIONS(X) \
+    X(C_Initialize, (CK_VOID_PTR a), (a), 0) \
+    X(C_Finalize, (CK_VOID_PTR a), (a), 0) \
+    X(C_GetInfo, (CK_INFO *a), (a), 0) \
+    X(C_GetSlotList, (CK_BBOOL a, CK_SLOT_ID_PTR b, CK_ULONG_PTR c), (a, b, c), 0) \
+    X(C_GetSlotInfo, (CK_SLOT_ID a, CK_SLOT_INFO *b), (a, b), a) \
+    X(C_GetTokenInfo, (CK_SLOT_ID a, CK_TOKEN_INFO *b), (a, b), a) \
+    X(C_GetMechanismList, (CK_SLOT_ID a, CK_MECHANISM_TYPE_PTR b, CK_ULONG_PTR c), (a, b, c), a) \
+    X(C_GetMechanismInfo, (CK_SLOT_ID a, CK_MECHANISM_TYPE b, CK_MECHANISM_INFO *c), (a, b, c), b) \
+    X(C_OpenSession, (CK_SLOT_ID a, CK_FLAGS b, CK_VOID_PTR c, CK_NOTIFY d, CK_SESSION_HANDLE_PTR e), \
+      (a, b, c, d, e), a) \
+    X(C_CloseSession, (CK_SESSION_HANDLE a), (a), a) \
+    X(C_CloseAllSessions, (CK_SLOT_ID a), (a), a) \
+    X(C_GetSessionInfo, (CK_SESSION_HANDLE a, CK_SESSION_INFO *b), (a, b), a) \
+    X(C_Login, (CK_SESSION_HANDLE a, CK_USER_TYPE b, CK_UTF8CHAR_PTR c, CK_ULONG d), (a, b, c, d), a) \
+    X(C_Logout, (CK_SESSION_HANDLE a), (a), a) \
+    X(C_CreateObject, (CK_SESSION_HANDLE a, CK_ATTRIBUTE_PTR b, CK_ULONG c, CK_OBJECT_HANDLE_PTR d), \
+      (a, b, c, d), a) \
+    X(C_DestroyObject, (CK_SESSION_HANDLE a, CK_OBJECT_HANDLE b), (a, b), b) \
+    X(C_GetAttributeValue, (CK_SESSION_HANDLE a, CK_OBJECT_HANDLE b, CK_ATTRIBUTE_PTR c, CK_ULONG d), \
+      (a, b, c, d), b) \
+    X(C_FindObjectsInit, (CK_SESSION_HANDLE a, CK_ATTRIBUTE_PTR b, CK_ULONG c), (a, b, c), a) \
+    X(C_FindObjects, (CK_SESSION_HANDLE a, CK_OBJECT_HANDLE_PTR b, CK_ULONG c, CK_ULONG_PTR d), \
+      (a, b, c, d), a) \
+    X(C_FindObjectsFinal, (CK_SESSION_HANDLE a), (a), a) \
+    X(C_SignInit, (CK_SESSION_HANDLE a, CK_MECHANISM_PTR b, CK_OBJECT_HANDLE c), (a, b, c), c) \
+    X(C_Sign, (CK_SESSION_HANDLE a, CK_BYTE_PTR b, CK_ULONG c, CK_BYTE_PTR d, CK_ULONG_PTR e), \
+      (a, b, c, d, e), a) \
+    X(C_SignUpdate, (CK_SESSION_HANDLE a, CK_BYTE_PTR b, CK_ULONG c), (a, b, c), a) \
+    X(C_SignFinal, (CK_SESSION_HANDLE a, CK_BYTE_PTR b, CK_ULONG_PTR c), (a, b, c), a) \
+    X(C_DigestInit, (CK_SESSION_HANDLE a, CK_MECHANISM_PTR b), (a, b), a) \
+    X(C_Digest, (CK_SESSION_HANDLE a, CK_BYTE_PTR b, CK_ULONG c, CK_BYTE_PTR d, CK_ULONG_PTR e), \
+      (a, b, c, d, e), a) \
+    X(C_DigestUpdate, (CK_SESSION_HANDLE a, CK_BYTE_PTR b, CK_ULONG c), (a, b, c), a) \
+    X(C_DigestFinal, (CK_SESSION_HANDLE a, CK_BYTE_PTR b, CK_ULONG_PTR c), (a, b, c), a) \
+    X(C_GenerateKeyPair, (CK_SESSION_HANDLE a, CK_MECHANISM_PTR b, CK_ATTRIBUTE_PTR c, CK_ULONG d, \
+                          CK_ATTRIBUTE_PTR e, CK_ULONG f, CK_OBJECT_HANDLE_PTR g, CK_OBJECT_HANDLE_PTR h), \
+      (a, b, c, d, e, f, g, h), a) \
+    X(C_GenerateRandom, (CK_SESSION_HANDLE a, CK_BYTE_PTR b, CK_ULONG c), (a, b, c), c)
+
+enum {
+    ELE_FN_MAILBOX = ELE_TRACE_FN_MAILBOX,
+#define X(name, params, args, arg) ELE_FN_##name,
+    ELE_TRACED_FUNCTIONS(X)
+#undef X
+    ELE_FN_COUNT
+};
+
+static const char *const ele_trace_names[ELE_FN_COUNT] = {
+    [ELE_FN_MAILBOX] = "mailbox",
+#define X(name, params, args, arg) [ELE_FN_##name] = #name,
+    ELE_TRACED_FUNCTIONS(X)
+#undef X
+};
+
+#define X(name, params, args, arg) \
+    static CK_RV ele_traced_##name params { \
+        uint64_t t0 = ele_trace_now(); \
+        CK_RV rv = name args; \
+        ele_trace_record(ELE_FN_##name, rv, (uint64_t)(arg), t0); \
+        return rv; \
+    }
+ELE_TRACED_FUNCTIONS(X)
+#undef X
+
+static CK_FUNCTION_LIST ele_traced_function_list;
+
+static void ele_trace_init(void) {
+    ele_trace_setup(ele_trace_names, ELE_FN_COUNT);
+    
+    ele_traced_function_list = ele_function_list;
+#define X(name, params, args, arg) ele_traced_function_list.name = ele_traced_##name;
+    ELE_TRACED_FUNCTIONS(X)
+#undef X
+}
+
+// Entry point for PKCS#11 module
+CK_DEFINE_FUNCTION(CK_RV, C_GetFunctionList)(CK_FUNCTION_LIST_PTR_PTR ppFunctionList) {
+    pthread_once(&ele_trace_once, ele_trace_init);
+    
+    ELE_LOG("C_GetFunctionList called");
     
     if (ppFunctionList == NULL) {
         return CKR_ARGUMENTS_BAD;
     }
     
-    // In a real implementation, this would return a complete function list
-    *ppFunctionList = function_list;
+    *ppFunctionList = (ele_trace_flags & ELE_TRACE_TIMED) ? &ele_traced_function_list : &ele_function_list;
     
     return CKR_OK;
 }
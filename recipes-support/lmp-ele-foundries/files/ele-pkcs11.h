@@ -0,0 +1,423 @@
+/*
+ * PKCS#11 definitions shared by the ELE PKCS#11 module sources
+ *
+ * Only the subset of the Cryptoki v2.40 interface used by the module and
+ * pkcs11-bench is declared here; values and layouts match the OASIS
+ * headers, so the function list can be handed to any Cryptoki consumer.
+ */
+
+#ifndef ELE_PKCS11_H
+#define ELE_PKCS11_H
+
+// PKCS#11 definitions (simplified)
+#define CK_PTR *
+#define CK_DEFINE_FUNCTION(returnType, name) returnType name
+#define CK_DECLARE_FUNCTION(returnType, name) returnType name
+#define CK_DECLARE_FUNCTION_POINTER(returnType, name) returnType (* name)
+#define CK_CALLBACK_FUNCTION(returnType, name) returnType (* name)
+
+typedef unsigned long CK_ULONG;
+typedef unsigned long CK_RV;
+typedef unsigned char CK_BYTE;
+typedef CK_BYTE CK_CHAR;
+typedef CK_BYTE CK_UTF8CHAR;
+typedef CK_UTF8CHAR CK_PTR CK_UTF8CHAR_PTR;
+typedef CK_BYTE CK_PTR CK_BYTE_PTR;
+typedef CK_ULONG CK_PTR CK_ULONG_PTR;
+typedef void CK_PTR CK_VOID_PTR;
+typedef CK_VOID_PTR CK_PTR CK_VOID_PTR_PTR;
+typedef CK_ULONG CK_FLAGS;
+typedef CK_ULONG CK_SLOT_ID;
+typedef CK_ULONG CK_SESSION_HANDLE;
+typedef CK_ULONG CK_OBJECT_HANDLE;
+typedef CK_ULONG CK_MECHANISM_TYPE;
+typedef CK_ULONG CK_STATE;
+typedef CK_BYTE CK_BBOOL;
+typedef CK_ULONG CK_OBJECT_CLASS;
+typedef CK_ULONG CK_KEY_TYPE;
+typedef CK_ULONG CK_CERTIFICATE_TYPE;
+typedef CK_ULONG CK_USER_TYPE;
+typedef CK_ULONG CK_NOTIFICATION;
+typedef CK_OBJECT_HANDLE CK_PTR CK_OBJECT_HANDLE_PTR;
+typedef CK_SLOT_ID CK_PTR CK_SLOT_ID_PTR;
+typedef CK_SESSION_HANDLE CK_PTR CK_SESSION_HANDLE_PTR;
+typedef CK_MECHANISM_TYPE CK_PTR CK_MECHANISM_TYPE_PTR;
+
+typedef struct CK_VERSION {
+    CK_BYTE major;
+    CK_BYTE minor;
+} CK_VERSION;
+
+typedef struct CK_INFO {
+    CK_VERSION cryptokiVersion;
+    CK_UTF8CHAR manufacturerID[32];
+    CK_FLAGS flags;
+    CK_UTF8CHAR libraryDescription[32];
+    CK_VERSION libraryVersion;
+} CK_INFO;
+
+typedef struct CK_SLOT_INFO {
+    CK_UTF8CHAR slotDescription[64];
+    CK_UTF8CHAR manufacturerID[32];
+    CK_FLAGS flags;
+    CK_VERSION hardwareVersion;
+    CK_VERSION firmwareVersion;
+} CK_SLOT_INFO;
+
+typedef struct CK_TOKEN_INFO {
+    CK_UTF8CHAR label[32];
+    CK_UTF8CHAR manufacturerID[32];
+    CK_UTF8CHAR model[16];
+    CK_CHAR serialNumber[16];
+    CK_FLAGS flags;
+    CK_ULONG ulMaxSessionCount;
+    CK_ULONG ulSessionCount;
+    CK_ULONG ulMaxRwSessionCount;
+    CK_ULONG ulRwSessionCount;
+    CK_ULONG ulMaxPinLen;
+    CK_ULONG ulMinPinLen;
+    CK_ULONG ulTotalPublicMemory;
+    CK_ULONG ulFreePublicMemory;
+    CK_ULONG ulTotalPrivateMemory;
+    CK_ULONG ulFreePrivateMemory;
+    CK_VERSION hardwareVersion;
+    CK_VERSION firmwareVersion;
+    CK_CHAR utcTime[16];
+} CK_TOKEN_INFO;
+
+typedef struct CK_MECHANISM_INFO {
+    CK_ULONG ulMinKeySize;
+    CK_ULONG ulMaxKeySize;
+    CK_FLAGS flags;
+} CK_MECHANISM_INFO;
+
+typedef CK_CALLBACK_FUNCTION(CK_RV, CK_NOTIFY)(CK_SESSION_HANDLE hSession,
+                                               CK_NOTIFICATION event,
+                                               CK_VOID_PTR pApplication);
+
+typedef CK_CALLBACK_FUNCTION(CK_RV, CK_CREATEMUTEX)(CK_VOID_PTR_PTR ppMutex);
+typedef CK_CALLBACK_FUNCTION(CK_RV, CK_DESTROYMUTEX)(CK_VOID_PTR pMutex);
+typedef CK_CALLBACK_FUNCTION(CK_RV, CK_LOCKMUTEX)(CK_VOID_PTR pMutex);
+typedef CK_CALLBACK_FUNCTION(CK_RV, CK_UNLOCKMUTEX)(CK_VOID_PTR pMutex);
+
+typedef struct CK_C_INITIALIZE_ARGS {
+    CK_CREATEMUTEX CreateMutex;
+    CK_DESTROYMUTEX DestroyMutex;
+    CK_LOCKMUTEX LockMutex;
+    CK_UNLOCKMUTEX UnlockMutex;
+    CK_FLAGS flags;
+    CK_VOID_PTR pReserved;
+} CK_C_INITIALIZE_ARGS;
+
+typedef struct CK_SESSION_INFO {
+    CK_SLOT_ID slotID;
+    CK_STATE state;
+    CK_FLAGS flags;
+    CK_ULONG ulDeviceError;
+} CK_SESSION_INFO;
+
+typedef CK_ULONG CK_ATTRIBUTE_TYPE;
+
+typedef struct CK_ATTRIBUTE {
+    CK_ATTRIBUTE_TYPE type;
+    CK_VOID_PTR pValue;
+    CK_ULONG ulValueLen;
+} CK_ATTRIBUTE;
+
+typedef struct CK_MECHANISM {
+    CK_MECHANISM_TYPE mechanism;
+    CK_VOID_PTR pParameter;
+    CK_ULONG ulParameterLen;
+} CK_MECHANISM;
+
+typedef CK_ATTRIBUTE CK_PTR CK_ATTRIBUTE_PTR;
+typedef CK_MECHANISM CK_PTR CK_MECHANISM_PTR;
+
+/*
+ * Cryptoki function list. Member order is fixed by the specification:
+ * consumers index into it, so entries must never be added, removed or
+ * reordered.
+ */
+typedef struct CK_FUNCTION_LIST CK_FUNCTION_LIST;
+typedef CK_FUNCTION_LIST CK_PTR CK_FUNCTION_LIST_PTR;
+typedef CK_FUNCTION_LIST_PTR CK_PTR CK_FUNCTION_LIST_PTR_PTR;
+
+struct CK_FUNCTION_LIST {
+    CK_VERSION version;
+    CK_DECLARE_FUNCTION_POINTER(CK_RV, C_Initialize)(CK_VOID_PTR pInitArgs);
+    CK_DECLARE_FUNCTION_POINTER(CK_RV, C_Finalize)(CK_VOID_PTR pReserved);
+    CK_DECLARE_FUNCTION_POINTER(CK_RV, C_GetInfo)(CK_INFO CK_PTR pInfo);
+    CK_DECLARE_FUNCTION_POINTER(CK_RV, C_GetFunctionList)(CK_FUNCTION_LIST_PTR_PTR ppFunctionList);
+    CK_DECLARE_FUNCTION_POINTER(CK_RV, C_GetSlotList)(CK_BBOOL tokenPresent, CK_SLOT_ID_PTR pSlotList,
+                                                      CK_ULONG_PTR pulCount);
+    CK_DECLARE_FUNCTION_POINTER(CK_RV, C_GetSlotInfo)(CK_SLOT_ID slotID, CK_SLOT_INFO CK_PTR pInfo);
+    CK_DECLARE_FUNCTION_POINTER(CK_RV, C_GetTokenInfo)(CK_SLOT_ID slotID, CK_TOKEN_INFO CK_PTR pInfo);
+    CK_DECLARE_FUNCTION_POINTER(CK_RV, C_GetMechanismList)(CK_SLOT_ID slotID,
+                                                           CK_MECHANISM_TYPE_PTR pMechanismList,
+                                                           CK_ULONG_PTR pulCount);
+    CK_DECLARE_FUNCTION_POINTER(CK_RV, C_GetMechanismInfo)(CK_SLOT_ID slotID, CK_MECHANISM_TYPE type,
+                                                           CK_MECHANISM_INFO CK_PTR pInfo);
+    CK_DECLARE_FUNCTION_POINTER(CK_RV, C_InitToken)(CK_SLOT_ID slotID, CK_UTF8CHAR_PTR pPin,
+                                                    CK_ULONG ulPinLen, CK_UTF8CHAR_PTR pLabel);
+    CK_DECLARE_FUNCTION_POINTER(CK_RV, C_InitPIN)(CK_SESSION_HANDLE hSession, CK_UTF8CHAR_PTR pPin,
+                                                  CK_ULONG ulPinLen);
+    CK_DECLARE_FUNCTION_POINTER(CK_RV, C_SetPIN)(CK_SESSION_HANDLE hSession, CK_UTF8CHAR_PTR pOldPin,
+                                                 CK_ULONG ulOldLen, CK_UTF8CHAR_PTR pNewPin,
+                                                 CK_ULONG ulNewLen);
+    CK_DECLARE_FUNCTION_POINTER(CK_RV, C_OpenSession)(CK_SLOT_ID slotID, CK_FLAGS flags,
+                                                      CK_VOID_PTR pApplication, CK_NOTIFY Notify,
+                                                      CK_SESSION_HANDLE_PTR phSession);
+    CK_DECLARE_FUNCTION_POINTER(CK_RV, C_CloseSession)(CK_SESSION_HANDLE hSession);
+    CK_DECLARE_FUNCTION_POINTER(CK_RV, C_CloseAllSessions)(CK_SLOT_ID slotID);
+    CK_DECLARE_FUNCTION_POINTER(CK_RV, C_GetSessionInfo)(CK_SESSION_HANDLE hSession,
+                                                         CK_SESSION_INFO CK_PTR pInfo);
+    CK_DECLARE_FUNCTION_POINTER(CK_RV, C_GetOperationState)(CK_SESSION_HANDLE hSession,
+                                                            CK_BYTE_PTR pOperationState,
+                                                            CK_ULONG_PTR pulOperationStateLen);
+    CK_DECLARE_FUNCTION_POINTER(CK_RV, C_SetOperationState)(CK_SESSION_HANDLE hSession,
+                                                            CK_BYTE_PTR pOperationState,
+                                                            CK_ULONG ulOperationStateLen,
+                                                            CK_OBJECT_HANDLE hEncryptionKey,
+                                                            CK_OBJECT_HANDLE hAuthenticationKey);
+    CK_DECLARE_FUNCTION_POINTER(CK_RV, C_Login)(CK_SESSION_HANDLE hSession, CK_USER_TYPE userType,
+                                                CK_UTF8CHAR_PTR pPin, CK_ULONG ulPinLen);
+    CK_DECLARE_FUNCTION_POINTER(CK_RV, C_Logout)(CK_SESSION_HANDLE hSession);
+    CK_DECLARE_FUNCTION_POINTER(CK_RV, C_CreateObject)(CK_SESSION_HANDLE hSession,
+                                                       CK_ATTRIBUTE_PTR pTemplate, CK_ULONG ulCount,
+                                                       CK_OBJECT_HANDLE_PTR phObject);
+    CK_DECLARE_FUNCTION_POINTER(CK_RV, C_CopyObject)(CK_SESSION_HANDLE hSession, CK_OBJECT_HANDLE hObject,
+                                                     CK_ATTRIBUTE_PTR pTemplate, CK_ULONG ulCount,
+                                                     CK_OBJECT_HANDLE_PTR phNewObject);
+    CK_DECLARE_FUNCTION_POINTER(CK_RV, C_DestroyObject)(CK_SESSION_HANDLE hSession,
+                                                        CK_OBJECT_HANDLE hObject);
+    CK_DECLARE_FUNCTION_POINTER(CK_RV, C_GetObjectSize)(CK_SESSION_HANDLE hSession,
+                                                        CK_OBJECT_HANDLE hObject, CK_ULONG_PTR pulSize);
+    CK_DECLARE_FUNCTION_POINTER(CK_RV, C_GetAttributeValue)(CK_SESSION_HANDLE hSession,
+                                                            CK_OBJECT_HANDLE hObject,
+                                                            CK_ATTRIBUTE_PTR pTemplate, CK_ULONG ulCount);
+    CK_DECLARE_FUNCTION_POINTER(CK_RV, C_SetAttributeValue)(CK_SESSION_HANDLE hSession,
+                                                            CK_OBJECT_HANDLE hObject,
+                                                            CK_ATTRIBUTE_PTR pTemplate, CK_ULONG ulCount);
+    CK_DECLARE_FUNCTION_POINTER(CK_RV, C_FindObjectsInit)(CK_SESSION_HANDLE hSession,
+                                                          CK_ATTRIBUTE_PTR pTemplate, CK_ULONG ulCount);
+    CK_DECLARE_FUNCTION_POINTER(CK_RV, C_FindObjects)(CK_SESSION_HANDLE hSession,
+                                                      CK_OBJECT_HANDLE_PTR phObject,
+                                                      CK_ULONG ulMaxObjectCount,
+                                                      CK_ULONG_PTR pulObjectCount);
+    CK_DECLARE_FUNCTION_POINTER(CK_RV, C_FindObjectsFinal)(CK_SESSION_HANDLE hSession);
+    CK_DECLARE_FUNCTION_POINTER(CK_RV, C_EncryptInit)(CK_SESSION_HANDLE hSession,
+                                                      CK_MECHANISM_PTR pMechanism, CK_OBJECT_HANDLE hKey);
+    CK_DECLARE_FUNCTION_POINTER(CK_RV, C_Encrypt)(CK_SESSION_HANDLE hSession, CK_BYTE_PTR pData,
+                                                  CK_ULONG ulDataLen, CK_BYTE_PTR pEncryptedData,
+                                                  CK_ULONG_PTR pulEncryptedDataLen);
+    CK_DECLARE_FUNCTION_POINTER(CK_RV, C_EncryptUpdate)(CK_SESSION_HANDLE hSession, CK_BYTE_PTR pPart,
+                                                        CK_ULONG ulPartLen, CK_BYTE_PTR pEncryptedPart,
+                                                        CK_ULONG_PTR pulEncryptedPartLen);
+    CK_DECLARE_FUNCTION_POINTER(CK_RV, C_EncryptFinal)(CK_SESSION_HANDLE hSession,
+                                                       CK_BYTE_PTR pLastEncryptedPart,
+                                                       CK_ULONG_PTR pulLastEncryptedPartLen);
+    CK_DECLARE_FUNCTION_POINTER(CK_RV, C_DecryptInit)(CK_SESSION_HANDLE hSession,
+                                                      CK_MECHANISM_PTR pMechanism, CK_OBJECT_HANDLE hKey);
+    CK_DECLARE_FUNCTION_POINTER(CK_RV, C_Decrypt)(CK_SESSION_HANDLE hSession, CK_BYTE_PTR pEncryptedData,
+                                                  CK_ULONG ulEncryptedDataLen, CK_BYTE_PTR pData,
+                                                  CK_ULONG_PTR pulDataLen);
+    CK_DECLARE_FUNCTION_POINTER(CK_RV, C_DecryptUpdate)(CK_SESSION_HANDLE hSession,
+                                                        CK_BYTE_PTR pEncryptedPart,
+                                                        CK_ULONG ulEncryptedPartLen, CK_BYTE_PTR pPart,
+                                                        CK_ULONG_PTR pulPartLen);
+    CK_DECLARE_FUNCTION_POINTER(CK_RV, C_DecryptFinal)(CK_SESSION_HANDLE hSession, CK_BYTE_PTR pLastPart,
+                                                       CK_ULONG_PTR pulLastPartLen);
+    CK_DECLARE_FUNCTION_POINTER(CK_RV, C_DigestInit)(CK_SESSION_HANDLE hSession,
+                                                     CK_MECHANISM_PTR pMechanism);
+    CK_DECLARE_FUNCTION_POINTER(CK_RV, C_Digest)(CK_SESSION_HANDLE hSession, CK_BYTE_PTR pData,
+                                                 CK_ULONG ulDataLen, CK_BYTE_PTR pDigest,
+                                                 CK_ULONG_PTR pulDigestLen);
+    CK_DECLARE_FUNCTION_POINTER(CK_RV, C_DigestUpdate)(CK_SESSION_HANDLE hSession, CK_BYTE_PTR pPart,
+                                                       CK_ULONG ulPartLen);
+    CK_DECLARE_FUNCTION_POINTER(CK_RV, C_DigestKey)(CK_SESSION_HANDLE hSession, CK_OBJECT_HANDLE hKey);
+    CK_DECLARE_FUNCTION_POINTER(CK_RV, C_DigestFinal)(CK_SESSION_HANDLE hSession, CK_BYTE_PTR pDigest,
+                                                      CK_ULONG_PTR pulDigestLen);
+    CK_DECLARE_FUNCTION_POINTER(CK_RV, C_SignInit)(CK_SESSION_HANDLE hSession,
+                                                   CK_MECHANISM_PTR pMechanism, CK_OBJECT_HANDLE hKey);
+    CK_DECLARE_FUNCTION_POINTER(CK_RV, C_Sign)(CK_SESSION_HANDLE hSession, CK_BYTE_PTR pData,
+                                               CK_ULONG ulDataLen, CK_BYTE_PTR pSignature,
+                                               CK_ULONG_PTR pulSignatureLen);
+    CK_DECLARE_FUNCTION_POINTER(CK_RV, C_SignUpdate)(CK_SESSION_HANDLE hSession, CK_BYTE_PTR pPart,
+                                                     CK_ULONG ulPartLen);
+    CK_DECLARE_FUNCTION_POINTER(CK_RV, C_SignFinal)(CK_SESSION_HANDLE hSession, CK_BYTE_PTR pSignature,
+                                                    CK_ULONG_PTR pulSignatureLen);
+    CK_DECLARE_FUNCTION_POINTER(CK_RV, C_SignRecoverInit)(CK_SESSION_HANDLE hSession,
+                                                          CK_MECHANISM_PTR pMechanism,
+                                                          CK_OBJECT_HANDLE hKey);
+    CK_DECLARE_FUNCTION_POINTER(CK_RV, C_SignRecover)(CK_SESSION_HANDLE hSession, CK_BYTE_PTR pData,
+                                                      CK_ULONG ulDataLen, CK_BYTE_PTR pSignature,
+                                                      CK_ULONG_PTR pulSignatureLen);
+    CK_DECLARE_FUNCTION_POINTER(CK_RV, C_VerifyInit)(CK_SESSION_HANDLE hSession,
+                                                     CK_MECHANISM_PTR pMechanism, CK_OBJECT_HANDLE hKey);
+    CK_DECLARE_FUNCTION_POINTER(CK_RV, C_Verify)(CK_SESSION_HANDLE hSession, CK_BYTE_PTR pData,
+                                                 CK_ULONG ulDataLen, CK_BYTE_PTR pSignature,
+                                                 CK_ULONG ulSignatureLen);
+    CK_DECLARE_FUNCTION_POINTER(CK_RV, C_VerifyUpdate)(CK_SESSION_HANDLE hSession, CK_BYTE_PTR pPart,
+                                                       CK_ULONG ulPartLen);
+    CK_DECLARE_FUNCTION_POINTER(CK_RV, C_VerifyFinal)(CK_SESSION_HANDLE hSession, CK_BYTE_PTR pSignature,
+                                                      CK_ULONG ulSignatureLen);
+    CK_DECLARE_FUNCTION_POINTER(CK_RV, C_VerifyRecoverInit)(CK_SESSION_HANDLE hSession,
+                                                            CK_MECHANISM_PTR pMechanism,
+                                                            CK_OBJECT_HANDLE hKey);
+    CK_DECLARE_FUNCTION_POINTER(CK_RV, C_VerifyRecover)(CK_SESSION_HANDLE hSession, CK_BYTE_PTR pSignature,
+                                                        CK_ULONG ulSignatureLen, CK_BYTE_PTR pData,
+                                                        CK_ULONG_PTR pulDataLen);
+    CK_DECLARE_FUNCTION_POINTER(CK_RV, C_DigestEncryptUpdate)(CK_SESSION_HANDLE hSession, CK_BYTE_PTR pPart,
+                                                              CK_ULONG ulPartLen,
+                                                              CK_BYTE_PTR pEncryptedPart,
+                                                              CK_ULONG_PTR pulEncryptedPartLen);
+    CK_DECLARE_FUNCTION_POINTER(CK_RV, C_DecryptDigestUpdate)(CK_SESSION_HANDLE hSession,
+                                                              CK_BYTE_PTR pEncryptedPart,
+                                                              CK_ULONG ulEncryptedPartLen,
+                                                              CK_BYTE_PTR pPart, CK_ULONG_PTR pulPartLen);
+    CK_DECLARE_FUNCTION_POINTER(CK_RV, C_SignEncryptUpdate)(CK_SESSION_HANDLE hSession, CK_BYTE_PTR pPart,
+                                                            CK_ULONG ulPartLen, CK_BYTE_PTR pEncryptedPart,
+                                                            CK_ULONG_PTR pulEncryptedPartLen);
+    CK_DECLARE_FUNCTION_POINTER(CK_RV, C_DecryptVerifyUpdate)(CK_SESSION_HANDLE hSession,
+                                                              CK_BYTE_PTR pEncryptedPart,
+                                                              CK_ULONG ulEncryptedPartLen,
+                                                              CK_BYTE_PTR pPart, CK_ULONG_PTR pulPartLen);
+    CK_DECLARE_FUNCTION_POINTER(CK_RV, C_GenerateKey)(CK_SESSION_HANDLE hSession,
+                                                      CK_MECHANISM_PTR pMechanism,
+                                                      CK_ATTRIBUTE_PTR pTemplate, CK_ULONG ulCount,
+                                                      CK_OBJECT_HANDLE_PTR phKey);
+    CK_DECLARE_FUNCTION_POINTER(CK_RV, C_GenerateKeyPair)(CK_SESSION_HANDLE hSession,
+                                                          CK_MECHANISM_PTR pMechanism,
+                                                          CK_ATTRIBUTE_PTR pPublicKeyTemplate,
+                                                          CK_ULONG ulPublicKeyAttributeCount,
+                                                          CK_ATTRIBUTE_PTR pPrivateKeyTemplate,
+                                                          CK_ULONG ulPrivateKeyAttributeCount,
+                                                          CK_OBJECT_HANDLE_PTR phPublicKey,
+                                                          CK_OBJECT_HANDLE_PTR phPrivateKey);
+    CK_DECLARE_FUNCTION_POINTER(CK_RV, C_WrapKey)(CK_SESSION_HANDLE hSession, CK_MECHANISM_PTR pMechanism,
+                                                  CK_OBJECT_HANDLE hWrappingKey, CK_OBJECT_HANDLE hKey,
+                                                  CK_BYTE_PTR pWrappedKey, CK_ULONG_PTR pulWrappedKeyLen);
+    CK_DECLARE_FUNCTION_POINTER(CK_RV, C_UnwrapKey)(CK_SESSION_HANDLE hSession, CK_MECHANISM_PTR pMechanism,
+                                                    CK_OBJECT_HANDLE hUnwrappingKey, CK_BYTE_PTR pWrappedKey,
+                                                    CK_ULONG ulWrappedKeyLen, CK_ATTRIBUTE_PTR pTemplate,
+                                                    CK_ULONG ulAttributeCount, CK_OBJECT_HANDLE_PTR phKey);
+    CK_DECLARE_FUNCTION_POINTER(CK_RV, C_DeriveKey)(CK_SESSION_HANDLE hSession, CK_MECHANISM_PTR pMechanism,
+                                                    CK_OBJECT_HANDLE hBaseKey, CK_ATTRIBUTE_PTR pTemplate,
+                                                    CK_ULONG ulAttributeCount, CK_OBJECT_HANDLE_PTR phKey);
+    CK_DECLARE_FUNCTION_POINTER(CK_RV, C_SeedRandom)(CK_SESSION_HANDLE hSession, CK_BYTE_PTR pSeed,
+                                                     CK_ULONG ulSeedLen);
+    CK_DECLARE_FUNCTION_POINTER(CK_RV, C_GenerateRandom)(CK_SESSION_HANDLE hSession,
+                                                         CK_BYTE_PTR pRandomData, CK_ULONG ulRandomLen);
+    CK_DECLARE_FUNCTION_POINTER(CK_RV, C_GetFunctionStatus)(CK_SESSION_HANDLE hSession);
+    CK_DECLARE_FUNCTION_POINTER(CK_RV, C_CancelFunction)(CK_SESSION_HANDLE hSession);
+    CK_DECLARE_FUNCTION_POINTER(CK_RV, C_WaitForSlotEvent)(CK_FLAGS flags, CK_SLOT_ID_PTR pSlot,
+                                                           CK_VOID_PTR pReserved);
+};
+
+// PKCS#11 return values
+#define CKR_OK                          0x00000000UL
+#define CKR_HOST_MEMORY                 0x00000002UL
+#define CKR_SLOT_ID_INVALID             0x00000003UL
+#define CKR_GENERAL_ERROR               0x00000005UL
+#define CKR_FUNCTION_FAILED             0x00000006UL
+#define CKR_ARGUMENTS_BAD               0x00000007UL
+#define CKR_NO_EVENT                    0x00000008UL
+#define CKR_CANT_LOCK                   0x0000000AUL
+#define CKR_ATTRIBUTE_SENSITIVE         0x00000011UL
+#define CKR_ATTRIBUTE_TYPE_INVALID      0x00000012UL
+#define CKR_ATTRIBUTE_VALUE_INVALID     0x00000013UL
+#define CKR_DATA_LEN_RANGE              0x00000021UL
+#define CKR_DEVICE_ERROR                0x00000030UL
+#define CKR_FUNCTION_NOT_PARALLEL       0x00000051UL
+#define CKR_FUNCTION_NOT_SUPPORTED      0x00000054UL
+#define CKR_KEY_HANDLE_INVALID          0x00000060UL
+#define CKR_MECHANISM_INVALID           0x00000070UL
+#define CKR_OBJECT_HANDLE_INVALID       0x00000082UL
+#define CKR_OPERATION_ACTIVE            0x00000090UL
+#define CKR_OPERATION_NOT_INITIALIZED   0x00000091UL
+#define CKR_SESSION_COUNT               0x000000B1UL
+#define CKR_SESSION_HANDLE_INVALID      0x000000B3UL
+#define CKR_SESSION_PARALLEL_NOT_SUPPORTED 0x000000B4UL
+#define CKR_TOKEN_WRITE_PROTECTED       0x000000E2UL
+#define CKR_USER_ALREADY_LOGGED_IN      0x00000100UL
+#define CKR_USER_NOT_LOGGED_IN          0x00000101UL
+#define CKR_USER_TYPE_INVALID           0x00000103UL
+#define CKR_TEMPLATE_INCOMPLETE         0x000000D0UL
+#define CKR_TEMPLATE_INCONSISTENT       0x000000D1UL
+#define CKR_RANDOM_SEED_NOT_SUPPORTED   0x00000120UL
+#define CKR_RANDOM_NO_RNG               0x00000121UL
+#define CKR_DOMAIN_PARAMS_INVALID       0x00000130UL
+#define CKR_BUFFER_TOO_SMALL            0x00000150UL
+#define CKR_CRYPTOKI_NOT_INITIALIZED    0x00000190UL
+#define CKR_CRYPTOKI_ALREADY_INITIALIZED 0x00000191UL
+#define CKR_MUTEX_BAD                   0x000001A0UL
+#define CKR_MUTEX_NOT_LOCKED            0x000001A1UL
+
+// PKCS#11 flags and states
+#define CKF_LIBRARY_CANT_CREATE_OS_THREADS 0x00000001UL
+#define CKF_OS_LOCKING_OK               0x00000002UL
+#define CKF_RW_SESSION                  0x00000002UL
+#define CKF_SERIAL_SESSION              0x00000004UL
+#define CKF_DONT_BLOCK                  0x00000001UL
+#define CKS_RO_PUBLIC_SESSION           0UL
+#define CKS_RW_PUBLIC_SESSION           2UL
+
+// Slot, token and mechanism info flags
+#define CKF_TOKEN_PRESENT               0x00000001UL
+#define CKF_HW_SLOT                     0x00000004UL
+#define CKF_RNG                         0x00000001UL
+#define CKF_TOKEN_INITIALIZED           0x00000400UL
+#define CKF_HW                          0x00000001UL
+#define CKF_DIGEST                      0x00000400UL
+#define CKF_SIGN                        0x00000800UL
+#define CKF_GENERATE_KEY_PAIR           0x00010000UL
+#define CKF_EC_F_P                      0x00100000UL
+#define CKF_EC_NAMEDCURVE               0x00800000UL
+#define CKF_EC_UNCOMPRESS               0x01000000UL
+
+#define CKU_SO                          0UL
+#define CKU_USER                        1UL
+#define CKU_CONTEXT_SPECIFIC            2UL
+
+// Mechanisms and attributes
+#define CKM_SHA256                      0x00000250UL
+#define CKM_SHA384                      0x00000260UL
+#define CKM_SHA512                      0x00000270UL
+#define CKM_EC_KEY_PAIR_GEN             0x00001040UL
+#define CKM_ECDSA                       0x00001041UL
+#define CKM_ECDSA_SHA256                0x00001044UL
+#define CKM_ECDSA_SHA384                0x00001045UL
+#define CKM_ECDSA_SHA512                0x00001046UL
+
+#define CK_TRUE                         1
+#define CK_FALSE                        0
+#define CK_UNAVAILABLE_INFORMATION      (~0UL)
+
+#define CKO_CERTIFICATE                 0x00000001UL
+#define CKO_PUBLIC_KEY                  0x00000002UL
+#define CKO_PRIVATE_KEY                 0x00000003UL
+#define CKK_EC                          0x00000003UL
+#define CKC_X_509                       0x00000000UL
+
+#define CKA_CLASS                       0x00000000UL
+#define CKA_TOKEN                       0x00000001UL
+#define CKA_PRIVATE                     0x00000002UL
+#define CKA_LABEL                       0x00000003UL
+#define CKA_VALUE                       0x00000011UL
+#define CKA_CERTIFICATE_TYPE            0x00000080UL
+#define CKA_KEY_TYPE                    0x00000100UL
+#define CKA_ID                          0x00000102UL
+#define CKA_SENSITIVE                   0x00000103UL
+#define CKA_SIGN                        0x00000108UL
+#define CKA_VERIFY                      0x0000010AUL
+#define CKA_EXTRACTABLE                 0x00000162UL
+#define CKA_LOCAL                       0x00000163UL
+#define CKA_NEVER_EXTRACTABLE           0x00000164UL
+#define CKA_ALWAYS_SENSITIVE            0x00000165UL
+#define CKA_EC_PARAMS                   0x00000180UL
+#define CKA_EC_POINT                    0x00000181UL
+
+// Curves supported by the ELE key store
+enum { ELE_CURVE_P256 = 0, ELE_CURVE_P384 = 1, ELE_CURVE_COUNT };
+
+#endif /* ELE_PKCS11_H */
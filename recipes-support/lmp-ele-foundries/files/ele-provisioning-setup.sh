@@ -176,8 +176,13 @@ fi
 # Initialize ELE if needed
 echo "ELE device found, initialization complete"
 
-# TODO: Add actual ELE provisioning logic here
-# - Generate device keypair in ELE
+# Pre-generate device key pairs while the rest of provisioning runs;
+# the PKCS#11 module hands them out to C_GenerateKeyPair
+if command -v ele-keypool >/dev/null 2>&1; then
+    nice -n 19 ele-keypool fill || echo "WARNING: ELE key pre-generation failed"
+fi
+
+# TODO: Add remaining ELE provisioning logic here
 # - Create device certificate
 # - Store credentials securely
 
@@ -187,6 +192,11 @@ EOF
     chmod +x "/usr/bin/ele-provisioning-setup"
     
     systemctl daemon-reload
+    
+    # Keep the key pool filled at boot until the device is registered
+    if systemctl cat ele-keypool.service >/dev/null 2>&1; then
+        systemctl enable ele-keypool.service || warn "Could not enable ele-keypool.service"
+    fi
     success "ELE provisioning service created"
 }
 
@@ -0,0 +1,208 @@
+/*
+ * Buffered ELE TRNG pool for the ELE PKCS#11 module
+ *
+ * Unconsumed bytes sit at the front of the pool buffer; readers take from
+ * the end and wipe what they took, so no byte is ever handed out twice.
+ * When the level drops below ELE_RNG_LOW_WATERMARK the refill thread tops
+ * the pool up with one batched ELE_CMD_RNG_GET_RANDOM fill, which keeps
+ * several mailbox requests in flight. The ELE is fetched into a private
+ * buffer outside the pool lock so readers are never blocked behind it.
+ *
+ * A forked child must not reuse its parent's bytes and has no refill
+ * thread, so a pthread_atfork() handler wipes the pool in the child.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include "ele-rng.h"
+#include "ele-mailbox.h"
+
+static struct {
+    pthread_mutex_t lock;
+    pthread_cond_t low;
+    uint8_t buf[ELE_RNG_POOL_SIZE];
+    size_t avail;
+    int threaded;
+    int stop;
+    int refilling;
+    pthread_t thread;
+} ele_rng = {
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+    .low = PTHREAD_COND_INITIALIZER,
+};
+
+static pthread_once_t ele_rng_atfork_once = PTHREAD_ONCE_INIT;
+
+// Hold the pool lock across fork() so the child's copy is consistent
+static void ele_rng_atfork_prepare(void) {
+    pthread_mutex_lock(&ele_rng.lock);
+}
+
+static void ele_rng_atfork_parent(void) {
+    pthread_mutex_unlock(&ele_rng.lock);
+}
+
+// The child starts with an empty pool and no refill thread
+static void ele_rng_atfork_child(void) {
+    explicit_bzero(ele_rng.buf, sizeof(ele_rng.buf));
+    ele_rng.avail = 0;
+    ele_rng.threaded = 0;
+    ele_rng.refilling = 0;
+    ele_rng.stop = 0;
+    pthread_cond_init(&ele_rng.low, NULL);
+    pthread_mutex_unlock(&ele_rng.lock);
+}
+
+static void ele_rng_register_atfork(void) {
+    pthread_atfork(ele_rng_atfork_prepare, ele_rng_atfork_parent, ele_rng_atfork_child);
+}
+
+/*
+ * Fetch a batch from the ELE and append it to the pool. Only one caller
+ * fetches at a time: whoever finds a refill already running, or the pool
+ * back above the low watermark, returns without touching the ELE.
+ */
+static int ele_rng_refill(void) {
+    uint8_t batch[ELE_RNG_POOL_SIZE];
+    size_t want;
+    int rv;
+
+    pthread_mutex_lock(&ele_rng.lock);
+    if (ele_rng.refilling || ele_rng.avail >= ELE_RNG_LOW_WATERMARK) {
+        pthread_mutex_unlock(&ele_rng.lock);
+        return 0;
+    }
+    want = ELE_RNG_POOL_SIZE - ele_rng.avail;
+    ele_rng.refilling = 1;
+    pthread_mutex_unlock(&ele_rng.lock);
+
+    rv = ele_hsm_get_random(batch, want);
+
+    pthread_mutex_lock(&ele_rng.lock);
+    ele_rng.refilling = 0;
+    if (rv == 0) {
+        // Readers only drain while we fetch, so the batch always fits
+        memcpy(ele_rng.buf + ele_rng.avail, batch, want);
+        ele_rng.avail += want;
+    } else if (ele_rng.avail < ELE_RNG_LOW_WATERMARK && ele_rng.threaded) {
+        pthread_cond_signal(&ele_rng.low);
+    }
+    pthread_mutex_unlock(&ele_rng.lock);
+
+    explicit_bzero(batch, sizeof(batch));
+    return rv;
+}
+
+static void *ele_rng_thread(void *arg) {
+    (void)arg;
+
+    for (;;) {
+        pthread_mutex_lock(&ele_rng.lock);
+        while (!ele_rng.stop &&
+               (ele_rng.avail >= ELE_RNG_LOW_WATERMARK || ele_rng.refilling)) {
+            pthread_cond_wait(&ele_rng.low, &ele_rng.lock);
+        }
+        if (ele_rng.stop) {
+            pthread_mutex_unlock(&ele_rng.lock);
+            break;
+        }
+        pthread_mutex_unlock(&ele_rng.lock);
+
+        if (ele_rng_refill() != 0) {
+            // Do not spin against a failing enclave; callers fall back to direct reads
+            usleep(100000);
+        }
+    }
+
+    return NULL;
+}
+
+int ele_rng_init(int allow_threads) {
+    pthread_once(&ele_rng_atfork_once, ele_rng_register_atfork);
+
+    pthread_mutex_lock(&ele_rng.lock);
+    explicit_bzero(ele_rng.buf, sizeof(ele_rng.buf));
+    ele_rng.avail = 0;
+    ele_rng.stop = 0;
+    ele_rng.threaded = 0;
+    ele_rng.refilling = 0;
+    pthread_mutex_unlock(&ele_rng.lock);
+
+    if (allow_threads && pthread_create(&ele_rng.thread, NULL, ele_rng_thread, NULL) == 0) {
+        ele_rng.threaded = 1;
+    }
+
+    return 0;
+}
+
+void ele_rng_shutdown(void) {
+    if (ele_rng.threaded) {
+        pthread_mutex_lock(&ele_rng.lock);
+        ele_rng.stop = 1;
+        pthread_cond_signal(&ele_rng.low);
+        pthread_mutex_unlock(&ele_rng.lock);
+        pthread_join(ele_rng.thread, NULL);
+        ele_rng.threaded = 0;
+    }
+
+    pthread_mutex_lock(&ele_rng.lock);
+    explicit_bzero(ele_rng.buf, sizeof(ele_rng.buf));
+    ele_rng.avail = 0;
+    pthread_mutex_unlock(&ele_rng.lock);
+}
+
+// Take len bytes from the pool if it holds enough (lock held)
+static int ele_rng_take_locked(uint8_t *buf, size_t len) {
+    if (ele_rng.avail < len) {
+        return -1;
+    }
+
+    ele_rng.avail -= len;
+    memcpy(buf, ele_rng.buf + ele_rng.avail, len);
+    explicit_bzero(ele_rng.buf + ele_rng.avail, len);
+
+    if (ele_rng.avail < ELE_RNG_LOW_WATERMARK && ele_rng.threaded && !ele_rng.refilling) {
+        pthread_cond_signal(&ele_rng.low);
+    }
+
+    return 0;
+}
+
+int ele_rng_generate(uint8_t *buf, size_t len) {
+    int rv;
+
+    if (len == 0) {
+        return 0;
+    }
+
+    if (len > ELE_RNG_DIRECT_THRESHOLD) {
+        return ele_hsm_get_random(buf, len);
+    }
+
+    pthread_mutex_lock(&ele_rng.lock);
+    rv = ele_rng_take_locked(buf, len);
+    pthread_mutex_unlock(&ele_rng.lock);
+
+    if (rv == 0) {
+        return 0;
+    }
+
+    /*
+     * Pool ran dry (start-up, burst, or no refill thread): refill it from
+     * this thread, then retry once before falling back to a direct read.
+     */
+    if (ele_rng_refill() == 0) {
+        pthread_mutex_lock(&ele_rng.lock);
+        rv = ele_rng_take_locked(buf, len);
+        pthread_mutex_unlock(&ele_rng.lock);
+        if (rv == 0) {
+            return 0;
+        }
+    }
+
+    return ele_hsm_get_random(buf, len);
+}
@@ -0,0 +1,32 @@
+/*
+ * Buffered ELE TRNG pool for the ELE PKCS#11 module
+ *
+ * All random bytes come from the ELE TRNG. They are fetched in large
+ * batches into a per-process pool so the many small C_GenerateRandom
+ * calls of a TLS handshake are served from memory instead of each
+ * costing a mailbox round trip.
+ */
+
+#ifndef ELE_RNG_H
+#define ELE_RNG_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Pool size and the level that triggers a background refill
+#define ELE_RNG_POOL_SIZE       4096
+#define ELE_RNG_LOW_WATERMARK   1024
+
+// Requests larger than this bypass the pool
+#define ELE_RNG_DIRECT_THRESHOLD (ELE_RNG_POOL_SIZE / 2)
+
+/*
+ * Start the pool. With allow_threads == 0 there is no refill thread and
+ * the pool is refilled synchronously by the caller that finds it short.
+ */
+int ele_rng_init(int allow_threads);
+void ele_rng_shutdown(void);
+
+int ele_rng_generate(uint8_t *buf, size_t len);
+
+#endif /* ELE_RNG_H */
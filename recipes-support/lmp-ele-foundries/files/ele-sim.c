@@ -0,0 +1,821 @@
+/*
+ * Software model of the i.MX93 EdgeLock Enclave mailbox
+ *
+ * Commands are decoded from the same frames the ELE PKCS#11 module puts
+ * on /dev/ele_mu and answered with the response layouts that
+ * ele-mailbox.c parses. Latency is injected while the command holds one
+ * of `depth` execution slots, so queueing behaves like the enclave: with
+ * depth=1 concurrent callers serialise exactly as they do on hardware.
+ *
+ * Volatile key ids increase monotonically. The key store holds at most
+ * `keys` keys (ELE_SIM_MAX_KEYS by default); once it is full, key
+ * generation fails until keys are deleted, as on the enclave, so a
+ * client that leaks keys runs into it instead of having them recycled.
+ * An id that is already in use is never stored a second time.
+ *
+ * With store=DIR, persistent keys are also written to DIR/key-<id>.pem
+ * and loaded from there when an id is not in memory, so every process
+ * using the in-process simulator with the same DIR shares them, as
+ * sessions of one enclave key store do. Their ids are drawn at random
+ * from the upper half of the id space to stay unique between processes.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <time.h>
+#include <pthread.h>
+#include <sys/stat.h>
+
+#include <openssl/evp.h>
+#include <openssl/ec.h>
+#include <openssl/core_names.h>
+#include <openssl/param_build.h>
+#include <openssl/pem.h>
+#include <openssl/rand.h>
+
+#include "ele-sim.h"
+#include "ele-mailbox.h"
+
+// Failure indications returned in the status word above ELE_RSP_FAILURE
+#define ELE_SIM_ERR_UNKNOWN_CMD 0x01
+#define ELE_SIM_ERR_BAD_PARAM   0x02
+#define ELE_SIM_ERR_BAD_KEY     0x03
+#define ELE_SIM_ERR_CRYPTO      0x04
+#define ELE_SIM_ERR_STORE_FULL  0x05
+
+// Ids of keys kept in the store directory
+#define ELE_SIM_PERSISTENT_ID   0x80000000u
+
+typedef struct {
+    uint32_t id;
+    EVP_PKEY *pkey;
+    unsigned int bits;
+} ele_sim_key_t;
+
+static struct {
+    pthread_mutex_t lock;
+    pthread_cond_t slot_free;
+    int initialized;
+
+    // Execution model
+    unsigned int depth;
+    unsigned int busy;
+    unsigned int latency_us[256];
+    unsigned int jitter_us;
+
+    // Key store
+    pthread_rwlock_t keys_lock;
+    ele_sim_key_t keys[ELE_SIM_MAX_KEYS];
+    unsigned int key_count;
+    unsigned int key_capacity;
+    uint32_t next_key_id;
+    char store_dir[256];             // persistent keys, "" to keep them in memory
+
+    // Statistics, per command id
+    unsigned long count[256];
+    unsigned long failures[256];
+    uint64_t service_ns[256];
+} ele_sim = {
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+    .slot_free = PTHREAD_COND_INITIALIZER,
+    .keys_lock = PTHREAD_RWLOCK_INITIALIZER,
+};
+
+static const struct {
+    const char *name;
+    uint8_t cmd;
+    unsigned int latency_us;
+} ele_sim_commands[] = {
+    { "ping",   ELE_CMD_PING,           ELE_SIM_LAT_PING },
+    { "info",   ELE_CMD_GET_INFO,       ELE_SIM_LAT_GET_INFO },
+    { "keygen", ELE_CMD_KEY_GENERATE,   ELE_SIM_LAT_KEYGEN },
+    { "sign",   ELE_CMD_SIGN_GENERATE,  ELE_SIM_LAT_SIGN },
+    { "verify", ELE_CMD_SIGN_VERIFY,    ELE_SIM_LAT_VERIFY },
+    { "rng",    ELE_CMD_RNG_GET_RANDOM, ELE_SIM_LAT_RNG },
+    { "hash",   ELE_CMD_HASH_ONE_GO,    ELE_SIM_LAT_HASH },
+    { "delete", ELE_CMD_KEY_DELETE,     ELE_SIM_LAT_DELETE },
+};
+
+#define ELE_SIM_COMMAND_COUNT (sizeof(ele_sim_commands) / sizeof(ele_sim_commands[0]))
+
+static uint64_t ele_sim_now_ns(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static int ele_sim_set(const char *key, const char *value) {
+    char *end;
+    unsigned long v;
+
+    if (strcasecmp(key, "store") == 0) {
+        snprintf(ele_sim.store_dir, sizeof(ele_sim.store_dir), "%s", value);
+        return 0;
+    }
+
+    v = strtoul(value, &end, 0);
+    if (*value == '\0' || *end != '\0') {
+        return -1;
+    }
+
+    if (strcasecmp(key, "depth") == 0) {
+        ele_sim.depth = v ? (unsigned int)v : 1;
+        return 0;
+    }
+    if (strcasecmp(key, "keys") == 0) {
+        if (v == 0 || v > ELE_SIM_MAX_KEYS) {
+            return -1;
+        }
+        ele_sim.key_capacity = (unsigned int)v;
+        return 0;
+    }
+    if (strcasecmp(key, "jitter") == 0) {
+        ele_sim.jitter_us = (unsigned int)v;
+        return 0;
+    }
+    if (strcasecmp(key, "default") == 0) {
+        // Only commands without a named setting of their own
+        for (unsigned int i = 0; i < 256; i++) {
+            int named = 0;
+            for (size_t j = 0; j < ELE_SIM_COMMAND_COUNT; j++) {
+                named |= ele_sim_commands[j].cmd == i;
+            }
+            if (!named) {
+                ele_sim.latency_us[i] = (unsigned int)v;
+            }
+        }
+        return 0;
+    }
+    for (size_t i = 0; i < ELE_SIM_COMMAND_COUNT; i++) {
+        if (strcasecmp(key, ele_sim_commands[i].name) == 0) {
+            ele_sim.latency_us[ele_sim_commands[i].cmd] = (unsigned int)v;
+            return 0;
+        }
+    }
+    if (strncasecmp(key, "0x", 2) == 0) {
+        unsigned long cmd = strtoul(key, &end, 16);
+        if (*end == '\0' && cmd < 256) {
+            ele_sim.latency_us[cmd] = (unsigned int)v;
+            return 0;
+        }
+    }
+
+    return -1;
+}
+
+static int ele_sim_parse(const char *spec) {
+    char *copy;
+    char *save = NULL;
+    int rv = 0;
+
+    if (spec == NULL || *spec == '\0') {
+        return 0;
+    }
+
+    copy = strdup(spec);
+    if (copy == NULL) {
+        return -1;
+    }
+
+    for (char *tok = strtok_r(copy, ",", &save); tok; tok = strtok_r(NULL, ",", &save)) {
+        char *eq = strchr(tok, '=');
+
+        if (eq == NULL) {
+            rv = -1;
+            break;
+        }
+        *eq = '\0';
+        if (ele_sim_set(tok, eq + 1) != 0) {
+            fprintf(stderr, "ELE sim: invalid setting '%s=%s'\n", tok, eq + 1);
+            rv = -1;
+            break;
+        }
+    }
+
+    free(copy);
+    return rv;
+}
+
+int ele_sim_init(const char *spec) {
+    pthread_mutex_lock(&ele_sim.lock);
+    if (ele_sim.initialized) {
+        pthread_mutex_unlock(&ele_sim.lock);
+        return 0;
+    }
+
+    ele_sim.depth = ELE_SIM_DEFAULT_DEPTH;
+    ele_sim.busy = 0;
+    ele_sim.jitter_us = 0;
+    for (unsigned int i = 0; i < 256; i++) {
+        ele_sim.latency_us[i] = ELE_SIM_LAT_DEFAULT;
+    }
+    for (size_t i = 0; i < ELE_SIM_COMMAND_COUNT; i++) {
+        ele_sim.latency_us[ele_sim_commands[i].cmd] = ele_sim_commands[i].latency_us;
+    }
+    memset(ele_sim.count, 0, sizeof(ele_sim.count));
+    memset(ele_sim.failures, 0, sizeof(ele_sim.failures));
+    memset(ele_sim.service_ns, 0, sizeof(ele_sim.service_ns));
+    ele_sim.next_key_id = 1;
+    ele_sim.key_capacity = ELE_SIM_MAX_KEYS;
+    ele_sim.store_dir[0] = '\0';
+
+    if (spec == NULL || *spec == '\0') {
+        spec = getenv("ELE_SIM_CONFIG");
+    }
+    if (ele_sim_parse(spec) != 0) {
+        pthread_mutex_unlock(&ele_sim.lock);
+        return -1;
+    }
+
+    ele_sim.initialized = 1;
+    pthread_mutex_unlock(&ele_sim.lock);
+    return 0;
+}
+
+void ele_sim_shutdown(void) {
+    pthread_rwlock_wrlock(&ele_sim.keys_lock);
+    for (unsigned int i = 0; i < ELE_SIM_MAX_KEYS; i++) {
+        EVP_PKEY_free(ele_sim.keys[i].pkey);
+        ele_sim.keys[i].pkey = NULL;
+        ele_sim.keys[i].id = 0;
+    }
+    ele_sim.key_count = 0;
+    pthread_rwlock_unlock(&ele_sim.keys_lock);
+
+    pthread_mutex_lock(&ele_sim.lock);
+    ele_sim.initialized = 0;
+    pthread_mutex_unlock(&ele_sim.lock);
+}
+
+// Hold an execution slot for the command's latency
+static void ele_sim_execute_delay(uint8_t cmd) {
+    static __thread unsigned int seed;
+    unsigned int delay_us;
+    struct timespec ts;
+
+    pthread_mutex_lock(&ele_sim.lock);
+    while (ele_sim.busy >= ele_sim.depth) {
+        pthread_cond_wait(&ele_sim.slot_free, &ele_sim.lock);
+    }
+    ele_sim.busy++;
+    delay_us = ele_sim.latency_us[cmd];
+    if (ele_sim.jitter_us > 0) {
+        if (seed == 0) {
+            seed = (unsigned int)ele_sim_now_ns() | 1;
+        }
+        delay_us += (unsigned int)rand_r(&seed) % (ele_sim.jitter_us + 1);
+    }
+    pthread_mutex_unlock(&ele_sim.lock);
+
+    ts.tv_sec = delay_us / 1000000;
+    ts.tv_nsec = (long)(delay_us % 1000000) * 1000;
+    while (clock_nanosleep(CLOCK_MONOTONIC, 0, &ts, &ts) != 0) {
+    }
+
+    pthread_mutex_lock(&ele_sim.lock);
+    ele_sim.busy--;
+    pthread_cond_signal(&ele_sim.slot_free);
+    pthread_mutex_unlock(&ele_sim.lock);
+}
+
+static const char *ele_sim_curve_name(unsigned int bits) {
+    switch (bits) {
+    case 256: return "P-256";
+    case 384: return "P-384";
+    case 521: return "P-521";
+    default:  return NULL;
+    }
+}
+
+static void ele_sim_key_path(char *path, size_t len, uint32_t id) {
+    snprintf(path, len, "%s/key-%08x.pem", ele_sim.store_dir, id);
+}
+
+// The slot holding key id, or NULL (keys_lock held)
+static ele_sim_key_t *ele_sim_key_find(uint32_t id) {
+    for (unsigned int i = 0; i < ELE_SIM_MAX_KEYS; i++) {
+        if (ele_sim.keys[i].pkey != NULL && ele_sim.keys[i].id == id) {
+            return &ele_sim.keys[i];
+        }
+    }
+    return NULL;
+}
+
+/*
+ * Store a key under id (keys_lock held). Returns 0, or -1 if the id is
+ * already in use or the store is full; the caller keeps pkey then.
+ */
+static int ele_sim_key_insert(uint32_t id, EVP_PKEY *pkey, unsigned int bits) {
+    if (id == 0 || ele_sim.key_count >= ele_sim.key_capacity || ele_sim_key_find(id) != NULL) {
+        return -1;
+    }
+
+    for (unsigned int i = 0; i < ELE_SIM_MAX_KEYS; i++) {
+        ele_sim_key_t *slot = &ele_sim.keys[i];
+
+        if (slot->pkey == NULL) {
+            slot->pkey = pkey;
+            slot->id = id;
+            slot->bits = bits;
+            ele_sim.key_count++;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+// Write a persistent key under a fresh id; returns the id, or 0 on failure
+static uint32_t ele_sim_key_save(EVP_PKEY *pkey) {
+    char path[sizeof(ele_sim.store_dir) + 32];
+
+    mkdir(ele_sim.store_dir, 0700);
+    for (int attempt = 0; attempt < 16; attempt++) {
+        uint32_t id;
+        FILE *f;
+        int ok;
+        int fd;
+
+        if (RAND_bytes((unsigned char *)&id, sizeof(id)) != 1) {
+            return 0;
+        }
+        id |= ELE_SIM_PERSISTENT_ID;
+        ele_sim_key_path(path, sizeof(path), id);
+
+        // O_EXCL is what keeps ids unique between processes
+        fd = open(path, O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0600);
+        if (fd < 0) {
+            if (errno == EEXIST) {
+                continue;
+            }
+            return 0;
+        }
+        f = fdopen(fd, "w");
+        if (f == NULL) {
+            close(fd);
+            unlink(path);
+            return 0;
+        }
+        ok = PEM_write_PrivateKey(f, pkey, NULL, NULL, 0, NULL, NULL) == 1;
+        if (fclose(f) != 0 || !ok) {
+            unlink(path);
+            return 0;
+        }
+        return id;
+    }
+    return 0;
+}
+
+// Bring a persistent key another process saved into memory
+static void ele_sim_key_load(uint32_t id) {
+    char path[sizeof(ele_sim.store_dir) + 32];
+    EVP_PKEY *pkey;
+    FILE *f;
+
+    if (ele_sim.store_dir[0] == '\0' || !(id & ELE_SIM_PERSISTENT_ID)) {
+        return;
+    }
+
+    ele_sim_key_path(path, sizeof(path), id);
+    f = fopen(path, "re");
+    if (f == NULL) {
+        return;
+    }
+    pkey = PEM_read_PrivateKey(f, NULL, NULL, NULL);
+    fclose(f);
+    if (pkey == NULL) {
+        return;
+    }
+
+    // Another thread may have loaded it first, or the store is full
+    pthread_rwlock_wrlock(&ele_sim.keys_lock);
+    if (ele_sim_key_insert(id, pkey, (unsigned int)EVP_PKEY_get_bits(pkey)) != 0) {
+        EVP_PKEY_free(pkey);
+    }
+    pthread_rwlock_unlock(&ele_sim.keys_lock);
+}
+
+// Response payload after the status word; returns words used or -error
+static int ele_sim_key_generate(const uint32_t *p, size_t n, uint32_t *out, size_t max) {
+    uint8_t point[1 + ELE_MAX_PUBKEY_LEN];
+    size_t point_len = 0;
+    const char *curve;
+    EVP_PKEY *pkey;
+    uint32_t id = 0;
+    int rv;
+
+    // The lifetime word is optional and defaults to volatile
+    if (n < 2 || p[0] != ELE_KEY_TYPE_ECC_NIST || (curve = ele_sim_curve_name(p[1])) == NULL ||
+        (n > 2 && p[2] != ELE_KEY_LIFETIME_VOLATILE && p[2] != ELE_KEY_LIFETIME_PERSISTENT)) {
+        return -ELE_SIM_ERR_BAD_PARAM;
+    }
+
+    pkey = EVP_PKEY_Q_keygen(NULL, NULL, "EC", curve);
+    if (pkey == NULL) {
+        return -ELE_SIM_ERR_CRYPTO;
+    }
+
+    // Uncompressed point 04 || X || Y; the ELE reports X || Y
+    if (!EVP_PKEY_get_octet_string_param(pkey, OSSL_PKEY_PARAM_PUB_KEY,
+                                         point, sizeof(point), &point_len) ||
+        point_len < 2 || point[0] != 0x04 || 2 + (point_len - 1 + 3) / 4 > max) {
+        EVP_PKEY_free(pkey);
+        return -ELE_SIM_ERR_CRYPTO;
+    }
+
+    pthread_rwlock_rdlock(&ele_sim.keys_lock);
+    rv = ele_sim.key_count >= ele_sim.key_capacity ? -ELE_SIM_ERR_STORE_FULL : 0;
+    pthread_rwlock_unlock(&ele_sim.keys_lock);
+    if (rv != 0) {
+        EVP_PKEY_free(pkey);
+        return rv;
+    }
+
+    if (n > 2 && p[2] == ELE_KEY_LIFETIME_PERSISTENT && ele_sim.store_dir[0] != '\0') {
+        id = ele_sim_key_save(pkey);
+        if (id == 0) {
+            EVP_PKEY_free(pkey);
+            return -ELE_SIM_ERR_CRYPTO;
+        }
+    }
+
+    pthread_rwlock_wrlock(&ele_sim.keys_lock);
+    if (id == 0) {
+        // Skip ids still held by keys from before the counter wrapped
+        do {
+            id = ele_sim.next_key_id++;
+            if (ele_sim.next_key_id == ELE_SIM_PERSISTENT_ID) {
+                ele_sim.next_key_id = 1;
+            }
+        } while (ele_sim_key_find(id) != NULL);
+    }
+    rv = ele_sim_key_insert(id, pkey, p[1]);
+    pthread_rwlock_unlock(&ele_sim.keys_lock);
+
+    // Filled up by a concurrent keygen since the check above
+    if (rv != 0) {
+        if (id & ELE_SIM_PERSISTENT_ID) {
+            char path[sizeof(ele_sim.store_dir) + 32];
+
+            ele_sim_key_path(path, sizeof(path), id);
+            unlink(path);
+        }
+        EVP_PKEY_free(pkey);
+        return -ELE_SIM_ERR_STORE_FULL;
+    }
+
+    out[0] = id;
+    out[1] = (uint32_t)(point_len - 1);
+    memcpy(&out[2], point + 1, point_len - 1);
+    return (int)(2 + (point_len - 1 + 3) / 4);
+}
+
+static int ele_sim_sign(const uint32_t *p, size_t n, uint32_t *out, size_t max) {
+    uint8_t der[160];
+    size_t der_len = sizeof(der);
+    const unsigned char *q = der;
+    const BIGNUM *r, *s;
+    ECDSA_SIG *sig;
+    EVP_PKEY_CTX *ctx;
+    EVP_PKEY *pkey = NULL;
+    unsigned int coord = 0;
+    size_t digest_len;
+    ele_sim_key_t *slot;
+    int ok;
+
+    if (n < 3 || p[1] != ELE_SIG_SCHEME_ECDSA) {
+        return -ELE_SIM_ERR_BAD_PARAM;
+    }
+    digest_len = p[2];
+    if (digest_len == 0 || digest_len > 64 || 3 + (digest_len + 3) / 4 > n) {
+        return -ELE_SIM_ERR_BAD_PARAM;
+    }
+
+    for (int attempt = 0; attempt < 2 && pkey == NULL && p[0] != 0; attempt++) {
+        if (attempt > 0) {
+            ele_sim_key_load(p[0]);
+        }
+        pthread_rwlock_rdlock(&ele_sim.keys_lock);
+        slot = ele_sim_key_find(p[0]);
+        if (slot != NULL) {
+            pkey = slot->pkey;
+            EVP_PKEY_up_ref(pkey);
+            coord = (slot->bits + 7) / 8;
+        }
+        pthread_rwlock_unlock(&ele_sim.keys_lock);
+    }
+
+    if (pkey == NULL) {
+        return -ELE_SIM_ERR_BAD_KEY;
+    }
+    if (2 + (2 * coord + 3) / 4 > max) {
+        EVP_PKEY_free(pkey);
+        return -ELE_SIM_ERR_BAD_PARAM;
+    }
+
+    ctx = EVP_PKEY_CTX_new(pkey, NULL);
+    ok = ctx != NULL &&
+         EVP_PKEY_sign_init(ctx) > 0 &&
+         EVP_PKEY_sign(ctx, der, &der_len, (const uint8_t *)&p[3], digest_len) > 0;
+    EVP_PKEY_CTX_free(ctx);
+    EVP_PKEY_free(pkey);
+    if (!ok) {
+        return -ELE_SIM_ERR_CRYPTO;
+    }
+
+    // DER ECDSA-Sig-Value to the raw r || s the ELE returns
+    sig = d2i_ECDSA_SIG(NULL, &q, (long)der_len);
+    if (sig == NULL) {
+        return -ELE_SIM_ERR_CRYPTO;
+    }
+    ECDSA_SIG_get0(sig, &r, &s);
+    out[0] = 2 * coord;
+    ok = BN_bn2binpad(r, (uint8_t *)&out[1], (int)coord) == (int)coord &&
+         BN_bn2binpad(s, (uint8_t *)&out[1] + coord, (int)coord) == (int)coord;
+    ECDSA_SIG_free(sig);
+
+    return ok ? (int)(1 + (2 * coord + 3) / 4) : -ELE_SIM_ERR_CRYPTO;
+}
+
+// Public key from the X || Y coordinates the ELE exchanges
+static EVP_PKEY *ele_sim_public_key(const uint8_t *xy, size_t len) {
+    uint8_t point[1 + ELE_MAX_PUBKEY_LEN];
+    const char *curve = ele_sim_curve_name(len == 132 ? 521 : (unsigned int)len * 4);
+    OSSL_PARAM_BLD *bld;
+    OSSL_PARAM *params = NULL;
+    EVP_PKEY_CTX *ctx = NULL;
+    EVP_PKEY *pkey = NULL;
+
+    if (curve == NULL || len > ELE_MAX_PUBKEY_LEN) {
+        return NULL;
+    }
+    point[0] = 0x04;
+    memcpy(point + 1, xy, len);
+
+    bld = OSSL_PARAM_BLD_new();
+    if (bld != NULL &&
+        OSSL_PARAM_BLD_push_utf8_string(bld, OSSL_PKEY_PARAM_GROUP_NAME, curve, 0) &&
+        OSSL_PARAM_BLD_push_octet_string(bld, OSSL_PKEY_PARAM_PUB_KEY, point, len + 1)) {
+        params = OSSL_PARAM_BLD_to_param(bld);
+    }
+    if (params != NULL) {
+        ctx = EVP_PKEY_CTX_new_from_name(NULL, "EC", NULL);
+    }
+    if (ctx == NULL || EVP_PKEY_fromdata_init(ctx) <= 0 ||
+        EVP_PKEY_fromdata(ctx, &pkey, EVP_PKEY_PUBLIC_KEY, params) <= 0) {
+        pkey = NULL;
+    }
+
+    EVP_PKEY_CTX_free(ctx);
+    OSSL_PARAM_free(params);
+    OSSL_PARAM_BLD_free(bld);
+    return pkey;
+}
+
+static int ele_sim_verify(const uint32_t *p, size_t n, uint32_t *out, size_t max) {
+    size_t pub_len, sig_len, digest_len;
+    const uint8_t *pub, *sig, *digest;
+    uint8_t *der = NULL;
+    ECDSA_SIG *ecsig;
+    BIGNUM *r, *s;
+    EVP_PKEY *pkey;
+    EVP_PKEY_CTX *ctx;
+    int der_len;
+    int ok;
+
+    // Payload: scheme, key/signature/digest lengths, then the word-aligned data
+    if (n < 4 || p[0] != ELE_SIG_SCHEME_ECDSA || max < 1) {
+        return -ELE_SIM_ERR_BAD_PARAM;
+    }
+    pub_len = p[1];
+    sig_len = p[2];
+    digest_len = p[3];
+    if (pub_len == 0 || pub_len > ELE_MAX_PUBKEY_LEN || sig_len != pub_len ||
+        digest_len == 0 || digest_len > 64 ||
+        4 + (pub_len + 3) / 4 + (sig_len + 3) / 4 + (digest_len + 3) / 4 > n) {
+        return -ELE_SIM_ERR_BAD_PARAM;
+    }
+    pub = (const uint8_t *)&p[4];
+    sig = (const uint8_t *)&p[4 + (pub_len + 3) / 4];
+    digest = (const uint8_t *)&p[4 + (pub_len + 3) / 4 + (sig_len + 3) / 4];
+
+    pkey = ele_sim_public_key(pub, pub_len);
+    if (pkey == NULL) {
+        return -ELE_SIM_ERR_BAD_KEY;
+    }
+
+    // Raw r || s to the DER ECDSA-Sig-Value OpenSSL verifies
+    ecsig = ECDSA_SIG_new();
+    r = BN_bin2bn(sig, (int)sig_len / 2, NULL);
+    s = BN_bin2bn(sig + sig_len / 2, (int)sig_len / 2, NULL);
+    if (ecsig == NULL || r == NULL || s == NULL || !ECDSA_SIG_set0(ecsig, r, s)) {
+        BN_free(r);
+        BN_free(s);
+        ECDSA_SIG_free(ecsig);
+        EVP_PKEY_free(pkey);
+        return -ELE_SIM_ERR_CRYPTO;
+    }
+    der_len = i2d_ECDSA_SIG(ecsig, &der);
+    ECDSA_SIG_free(ecsig);
+
+    ctx = EVP_PKEY_CTX_new(pkey, NULL);
+    ok = der_len > 0 && ctx != NULL && EVP_PKEY_verify_init(ctx) > 0 &&
+         EVP_PKEY_verify(ctx, der, (size_t)der_len, digest, digest_len) == 1;
+    EVP_PKEY_CTX_free(ctx);
+    EVP_PKEY_free(pkey);
+    OPENSSL_free(der);
+
+    out[0] = ok ? ELE_VERIFY_SUCCESS : 0;
+    return 1;
+}
+
+static int ele_sim_get_random(const uint32_t *p, size_t n, uint32_t *out, size_t max) {
+    size_t len;
+
+    if (n < 1) {
+        return -ELE_SIM_ERR_BAD_PARAM;
+    }
+    len = p[0];
+    if (len == 0 || len > ELE_RNG_MAX_CHUNK || 1 + (len + 3) / 4 > max) {
+        return -ELE_SIM_ERR_BAD_PARAM;
+    }
+
+    if (RAND_bytes((uint8_t *)&out[1], (int)len) != 1) {
+        return -ELE_SIM_ERR_CRYPTO;
+    }
+    out[0] = (uint32_t)len;
+    return (int)(1 + (len + 3) / 4);
+}
+
+static int ele_sim_hash(const uint32_t *p, size_t n, uint32_t *out, size_t max) {
+    const EVP_MD *md;
+    unsigned int digest_len = 0;
+    size_t len;
+
+    // Payload: algorithm, input length, input bytes
+    if (n < 2) {
+        return -ELE_SIM_ERR_BAD_PARAM;
+    }
+    switch (p[0]) {
+    case ELE_HASH_ALGO_SHA256: md = EVP_sha256(); break;
+    case ELE_HASH_ALGO_SHA384: md = EVP_sha384(); break;
+    case ELE_HASH_ALGO_SHA512: md = EVP_sha512(); break;
+    default: return -ELE_SIM_ERR_BAD_PARAM;
+    }
+    len = p[1];
+    if (2 + (len + 3) / 4 > n || 1 + (size_t)(EVP_MD_get_size(md) + 3) / 4 > max) {
+        return -ELE_SIM_ERR_BAD_PARAM;
+    }
+
+    if (EVP_Digest(&p[2], len, (uint8_t *)&out[1], &digest_len, md, NULL) != 1) {
+        return -ELE_SIM_ERR_CRYPTO;
+    }
+    out[0] = digest_len;
+    return (int)(1 + (digest_len + 3) / 4);
+}
+
+static int ele_sim_key_delete(const uint32_t *p, size_t n) {
+    char path[sizeof(ele_sim.store_dir) + 32];
+    ele_sim_key_t *slot;
+    int found = 0;
+
+    if (n < 1 || p[0] == 0) {
+        return -ELE_SIM_ERR_BAD_PARAM;
+    }
+
+    pthread_rwlock_wrlock(&ele_sim.keys_lock);
+    slot = ele_sim_key_find(p[0]);
+    if (slot != NULL) {
+        EVP_PKEY_free(slot->pkey);
+        slot->pkey = NULL;
+        slot->id = 0;
+        ele_sim.key_count--;
+        found = 1;
+    }
+    pthread_rwlock_unlock(&ele_sim.keys_lock);
+
+    if (ele_sim.store_dir[0] != '\0' && (p[0] & ELE_SIM_PERSISTENT_ID)) {
+        ele_sim_key_path(path, sizeof(path), p[0]);
+        found |= unlink(path) == 0;
+    }
+
+    return found ? 0 : -ELE_SIM_ERR_BAD_KEY;
+}
+
+static int ele_sim_get_info(uint32_t *out, size_t max) {
+    if (max < 7) {
+        return -ELE_SIM_ERR_BAD_PARAM;
+    }
+
+    // Firmware version, SoC id/revision, lifecycle, 64-bit UID
+    out[0] = ELE_SIM_FW_VERSION;
+    out[1] = ELE_SIM_SOC_ID | ((uint32_t)ELE_SIM_SOC_REV << 16);
+    out[2] = ELE_SIM_LIFECYCLE;
+    out[3] = 0x51AB0001;
+    out[4] = 0x00E1E000;
+    return 5;
+}
+
+size_t ele_sim_process(const uint32_t *cmd, size_t cmd_words,
+                       uint32_t *rsp, size_t rsp_max_words) {
+    uint64_t start = ele_sim_now_ns();
+    uint8_t command;
+    uint8_t version;
+    size_t words;
+    int used;
+
+    if (cmd_words < 1 || rsp_max_words < 2 || (cmd[0] >> 24) != ELE_MSG_TAG_CMD) {
+        return 0;
+    }
+    command = (cmd[0] >> 16) & 0xFF;
+    version = cmd[0] & 0xFF;
+    words = (cmd[0] >> 8) & 0xFF;
+    if (words < 1 || words > cmd_words) {
+        return 0;
+    }
+
+    ele_sim_execute_delay(command);
+
+    switch (command) {
+    case ELE_CMD_PING:
+        used = 0;
+        break;
+    case ELE_CMD_GET_INFO:
+        used = ele_sim_get_info(&rsp[2], rsp_max_words - 2);
+        break;
+    case ELE_CMD_KEY_GENERATE:
+        used = ele_sim_key_generate(&cmd[1], words - 1, &rsp[2], rsp_max_words - 2);
+        break;
+    case ELE_CMD_KEY_DELETE:
+        used = ele_sim_key_delete(&cmd[1], words - 1);
+        break;
+    case ELE_CMD_SIGN_GENERATE:
+        used = ele_sim_sign(&cmd[1], words - 1, &rsp[2], rsp_max_words - 2);
+        break;
+    case ELE_CMD_SIGN_VERIFY:
+        used = ele_sim_verify(&cmd[1], words - 1, &rsp[2], rsp_max_words - 2);
+        break;
+    case ELE_CMD_RNG_GET_RANDOM:
+        used = ele_sim_get_random(&cmd[1], words - 1, &rsp[2], rsp_max_words - 2);
+        break;
+    case ELE_CMD_HASH_ONE_GO:
+        used = ele_sim_hash(&cmd[1], words - 1, &rsp[2], rsp_max_words - 2);
+        break;
+    default:
+        used = -ELE_SIM_ERR_UNKNOWN_CMD;
+        break;
+    }
+
+    if (used < 0) {
+        rsp[1] = ((uint32_t)(-used) << 8) | ELE_RSP_FAILURE;
+        used = 0;
+    } else {
+        rsp[1] = ELE_RSP_SUCCESS;
+    }
+
+    words = 2 + (size_t)used;
+    rsp[0] = ((uint32_t)ELE_MSG_TAG_RSP << 24) |
+             ((uint32_t)command << 16) |
+             ((uint32_t)words << 8) |
+             version;
+
+    pthread_mutex_lock(&ele_sim.lock);
+    ele_sim.count[command]++;
+    if ((rsp[1] & 0xFF) != ELE_RSP_SUCCESS) {
+        ele_sim.failures[command]++;
+    }
+    ele_sim.service_ns[command] += ele_sim_now_ns() - start;
+    pthread_mutex_unlock(&ele_sim.lock);
+
+    return words;
+}
+
+void ele_sim_dump_stats(FILE *f) {
+    pthread_mutex_lock(&ele_sim.lock);
+    fprintf(f, "%-8s %10s %10s %12s\n", "command", "count", "failures", "mean us");
+    for (unsigned int i = 0; i < 256; i++) {
+        const char *name = NULL;
+        char raw[8];
+
+        if (ele_sim.count[i] == 0) {
+            continue;
+        }
+        for (size_t j = 0; j < ELE_SIM_COMMAND_COUNT; j++) {
+            if (ele_sim_commands[j].cmd == i) {
+                name = ele_sim_commands[j].name;
+            }
+        }
+        if (name == NULL) {
+            snprintf(raw, sizeof(raw), "0x%02x", i);
+            name = raw;
+        }
+        fprintf(f, "%-8s %10lu %10lu %12.1f\n", name, ele_sim.count[i], ele_sim.failures[i],
+                (double)ele_sim.service_ns[i] / 1000.0 / (double)ele_sim.count[i]);
+    }
+    pthread_mutex_unlock(&ele_sim.lock);
+}
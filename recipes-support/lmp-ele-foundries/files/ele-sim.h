@@ -0,0 +1,76 @@
+/*
+ * Software model of the i.MX93 EdgeLock Enclave mailbox
+ *
+ * Answers the commands used by the ELE PKCS#11 module and the test suites
+ * (ping, get-info, EC key generation, ECDSA signing and verification,
+ * TRNG, one-shot hash) with real OpenSSL crypto, so signatures verify and
+ * keys round-trip. Every command is held for a
+ * configurable latency in one of a configurable number of execution
+ * slots, which lets the PKCS#11 queue and the test suites be load-tested
+ * and profiled on a build host before any board time is spent.
+ *
+ * Used in-process by the "sim" backend (ele-backend.c) and by the
+ * ele-sim daemon, which serves it on a Unix socket.
+ */
+
+#ifndef ELE_SIM_H
+#define ELE_SIM_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stddef.h>
+
+// Keys the simulated key store holds at once (the keys= setting may lower it)
+#define ELE_SIM_MAX_KEYS        1024
+
+// Default execution slots: the real enclave runs one command at a time
+#define ELE_SIM_DEFAULT_DEPTH   1
+
+// Default latencies in microseconds, roughly what an i.MX93 A1 measures
+#define ELE_SIM_LAT_DEFAULT     100
+#define ELE_SIM_LAT_PING        60
+#define ELE_SIM_LAT_GET_INFO    150
+#define ELE_SIM_LAT_KEYGEN      25000
+#define ELE_SIM_LAT_SIGN        4000
+#define ELE_SIM_LAT_VERIFY      5500
+#define ELE_SIM_LAT_RNG         250
+#define ELE_SIM_LAT_HASH        120
+#define ELE_SIM_LAT_DELETE      300
+
+// Values reported by ELE_CMD_GET_INFO
+#define ELE_SIM_SOC_ID          0x9300
+#define ELE_SIM_SOC_REV         0xA1
+#define ELE_SIM_LIFECYCLE       0x0008    // OEM open
+#define ELE_SIM_FW_VERSION      0x00000901
+
+/*
+ * Start the simulator. spec is a comma separated list of key=value
+ * settings, e.g. "depth=2,sign=1500,keygen=20000,jitter=50"; NULL or ""
+ * uses the ELE_SIM_CONFIG environment variable, then the defaults.
+ *
+ *   depth=N       commands executed concurrently
+ *   keys=N        key store capacity, at most ELE_SIM_MAX_KEYS
+ *   jitter=US     uniform random extra latency added to every command
+ *   default=US    latency of commands without their own setting
+ *   ping, info, keygen, sign, verify, rng, hash, delete = US
+ *                 per-command latency
+ *   0xNN=US       latency of raw command id NN
+ *   store=DIR     directory shared by processes for persistent keys
+ *
+ * Returns 0, or -1 if the spec could not be parsed.
+ */
+int ele_sim_init(const char *spec);
+void ele_sim_shutdown(void);
+
+/*
+ * Execute one mailbox message. Returns the number of response words
+ * written to rsp (at least two: header and status), or 0 if cmd is not a
+ * valid command frame.
+ */
+size_t ele_sim_process(const uint32_t *cmd, size_t cmd_words,
+                       uint32_t *rsp, size_t rsp_max_words);
+
+// Print per-command counts and mean service time
+void ele_sim_dump_stats(FILE *f);
+
+#endif /* ELE_SIM_H */
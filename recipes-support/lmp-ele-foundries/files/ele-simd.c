@@ -0,0 +1,357 @@
+/*
+ * ele-sim - serve the ELE simulator on a Unix socket
+ *
+ * Every connection behaves like one open() of /dev/ele_mu: the client
+ * writes a command frame and reads one response frame. SOCK_SEQPACKET
+ * keeps message boundaries, so the ELE PKCS#11 module and the test
+ * suites talk to the socket with their normal read()/write() code when
+ * ELE_DEVICE_PATH points at it.
+ *
+ * With --root the daemon also lays out a fake sysfs/firmware tree and
+ * prints the ELE_*_PATH exports that point the test suites at it:
+ *
+ *   eval "$(ele-sim --root /tmp/ele --daemon --config sign=1500)"
+ *   enhanced-ele-test all
+ *   pkcs11-bench -t 1,4
+ *
+ * SIGUSR1 prints per-command statistics; SIGINT/SIGTERM print them and
+ * exit.
+ *
+ * Copyright (C) 2024 Dynamic Devices Ltd.
+ * Licensed under BSD-3-Clause
+ */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <limits.h>
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include "ele-sim.h"
+#include "ele-mailbox.h"
+
+#define DEFAULT_SOCKET_PATH "/run/ele-sim/ele_mu"
+
+// Size of the simulated ELE-OCOTP0 nvmem image
+#define ELE_SIM_OCOTP_SIZE  2048
+
+static volatile sig_atomic_t stop_requested;
+static volatile sig_atomic_t stats_requested;
+static int verbose;
+
+static void on_signal(int sig) {
+    if (sig == SIGUSR1) {
+        stats_requested = 1;
+    } else {
+        stop_requested = 1;
+    }
+}
+
+static void *client_main(void *arg) {
+    int fd = (int)(intptr_t)arg;
+    uint32_t cmd[ELE_MSG_MAX_WORDS];
+    uint32_t rsp[ELE_MSG_MAX_WORDS];
+
+    for (;;) {
+        ssize_t n = recv(fd, cmd, sizeof(cmd), 0);
+        size_t words;
+
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            break;
+        }
+
+        words = ele_sim_process(cmd, (size_t)n / sizeof(uint32_t), rsp, ELE_MSG_MAX_WORDS);
+        if (words == 0) {
+            // Not a command frame: drop the context
+            if (verbose) {
+                fprintf(stderr, "ele-sim: dropping malformed %zd byte message\n", n);
+            }
+            break;
+        }
+        if (send(fd, rsp, words * sizeof(uint32_t), MSG_NOSIGNAL) < 0) {
+            break;
+        }
+    }
+
+    close(fd);
+    return NULL;
+}
+
+static int make_dirs(const char *path) {
+    char buf[PATH_MAX];
+
+    if (snprintf(buf, sizeof(buf), "%s", path) >= (int)sizeof(buf)) {
+        return -1;
+    }
+    for (char *p = buf + 1; *p; p++) {
+        if (*p == '/') {
+            *p = '\0';
+            if (mkdir(buf, 0755) != 0 && errno != EEXIST) {
+                return -1;
+            }
+            *p = '/';
+        }
+    }
+    return (mkdir(buf, 0755) != 0 && errno != EEXIST) ? -1 : 0;
+}
+
+static int write_file(const char *dir, const char *name, const void *data, size_t len) {
+    char path[PATH_MAX];
+    FILE *f;
+    int rv;
+
+    if (make_dirs(dir) != 0) {
+        return -1;
+    }
+    snprintf(path, sizeof(path), "%s/%s", dir, name);
+    f = fopen(path, "w");
+    if (f == NULL) {
+        return -1;
+    }
+    rv = fwrite(data, 1, len, f) == len ? 0 : -1;
+    if (fclose(f) != 0) {
+        rv = -1;
+    }
+    return rv;
+}
+
+// Fake sysfs / firmware layout the test suites probe
+static int create_root(const char *root) {
+    static uint8_t ocotp[ELE_SIM_OCOTP_SIZE];
+    char dir[PATH_MAX];
+
+    snprintf(dir, sizeof(dir), "%s/dev", root);
+    if (make_dirs(dir) != 0) {
+        return -1;
+    }
+    snprintf(dir, sizeof(dir), "%s/sys/class/misc/ele_mu", root);
+    if (write_file(dir, "dev", "10:125\n", 7) != 0) {
+        return -1;
+    }
+    snprintf(dir, sizeof(dir), "%s/sys/bus/platform/devices/44230000.mailbox/driver", root);
+    if (write_file(dir, "uevent", "DRIVER=imx_mu\n", 14) != 0) {
+        return -1;
+    }
+    snprintf(dir, sizeof(dir), "%s/sys/bus/nvmem/devices/ELE-OCOTP0", root);
+    if (write_file(dir, "nvmem", ocotp, sizeof(ocotp)) != 0) {
+        return -1;
+    }
+    snprintf(dir, sizeof(dir), "%s/lib/firmware/imx/ele", root);
+    if (write_file(dir, "mx93a1-ahab-container.img", "", 0) != 0) {
+        return -1;
+    }
+    return 0;
+}
+
+static void print_exports(const char *root, const char *socket_path) {
+    printf("export ELE_DEVICE_PATH=%s\n", socket_path);
+    if (root != NULL) {
+        printf("export ELE_SYSFS_PATH=%s/sys/class/misc/ele_mu\n", root);
+        printf("export ELE_MAILBOX_PATH=%s/sys/bus/platform/devices/44230000.mailbox\n", root);
+        printf("export ELE_OCOTP_PATH=%s/sys/bus/nvmem/devices/ELE-OCOTP0\n", root);
+        printf("export ELE_FIRMWARE_PATH=%s/lib/firmware/imx/ele\n", root);
+    }
+    fflush(stdout);
+}
+
+static int listen_socket(const char *path) {
+    struct sockaddr_un addr;
+    char dir[PATH_MAX];
+    char *slash;
+    int fd;
+
+    if (strlen(path) >= sizeof(addr.sun_path)) {
+        fprintf(stderr, "ele-sim: socket path too long: %s\n", path);
+        return -1;
+    }
+
+    snprintf(dir, sizeof(dir), "%s", path);
+    slash = strrchr(dir, '/');
+    if (slash != NULL && slash != dir) {
+        *slash = '\0';
+        make_dirs(dir);
+    }
+
+    fd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        perror("ele-sim: socket");
+        return -1;
+    }
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, path);
+    unlink(path);
+
+    if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0 || listen(fd, 64) != 0) {
+        fprintf(stderr, "ele-sim: cannot listen on %s: %s\n", path, strerror(errno));
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static void print_usage(const char *prog) {
+    printf("Usage: %s [options]\n", prog);
+    printf("\n");
+    printf("Options:\n");
+    printf("  -s, --socket PATH   Listen socket (default %s, or ROOT/dev/ele_mu)\n",
+           DEFAULT_SOCKET_PATH);
+    printf("  -r, --root DIR      Create a fake sysfs/firmware tree under DIR\n");
+    printf("  -c, --config SPEC   Simulator settings, e.g. depth=2,sign=1500,jitter=50\n");
+    printf("                      (latencies in microseconds; default from ELE_SIM_CONFIG)\n");
+    printf("  -d, --daemon        Detach once listening; print the environment exports\n");
+    printf("  -v, --verbose       Log connections\n");
+    printf("  -h, --help          Show this help\n");
+}
+
+int main(int argc, char *argv[]) {
+    static const struct option long_opts[] = {
+        { "socket", required_argument, NULL, 's' },
+        { "root", required_argument, NULL, 'r' },
+        { "config", required_argument, NULL, 'c' },
+        { "daemon", no_argument, NULL, 'd' },
+        { "verbose", no_argument, NULL, 'v' },
+        { "help", no_argument, NULL, 'h' },
+        { NULL, 0, NULL, 0 }
+    };
+    char socket_buf[PATH_MAX];
+    const char *socket_path = NULL;
+    const char *root = NULL;
+    const char *config = NULL;
+    int daemonize = 0;
+    struct sigaction sa;
+    int listen_fd;
+    int opt;
+
+    while ((opt = getopt_long(argc, argv, "s:r:c:dvh", long_opts, NULL)) != -1) {
+        switch (opt) {
+        case 's':
+            socket_path = optarg;
+            break;
+        case 'r':
+            root = optarg;
+            break;
+        case 'c':
+            config = optarg;
+            break;
+        case 'd':
+            daemonize = 1;
+            break;
+        case 'v':
+            verbose = 1;
+            break;
+        case 'h':
+            print_usage(argv[0]);
+            return 0;
+        default:
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (root != NULL) {
+        if (create_root(root) != 0) {
+            fprintf(stderr, "ele-sim: cannot create tree under %s: %s\n", root, strerror(errno));
+            return 1;
+        }
+        if (socket_path == NULL) {
+            snprintf(socket_buf, sizeof(socket_buf), "%s/dev/ele_mu", root);
+            socket_path = socket_buf;
+        }
+    }
+    if (socket_path == NULL) {
+        socket_path = DEFAULT_SOCKET_PATH;
+    }
+
+    if (ele_sim_init(config) != 0) {
+        return 1;
+    }
+
+    listen_fd = listen_socket(socket_path);
+    if (listen_fd < 0) {
+        return 1;
+    }
+
+    if (daemonize) {
+        pid_t pid = fork();
+
+        if (pid < 0) {
+            perror("ele-sim: fork");
+            return 1;
+        }
+        if (pid > 0) {
+            print_exports(root, socket_path);
+            return 0;
+        }
+        setsid();
+        int null_fd = open("/dev/null", O_RDWR);
+        if (null_fd >= 0) {
+            dup2(null_fd, STDIN_FILENO);
+            dup2(null_fd, STDOUT_FILENO);
+            if (!verbose) {
+                dup2(null_fd, STDERR_FILENO);
+            }
+            close(null_fd);
+        }
+    } else {
+        print_exports(root, socket_path);
+    }
+
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = on_signal;
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+    sigaction(SIGUSR1, &sa, NULL);
+    signal(SIGPIPE, SIG_IGN);
+
+    while (!stop_requested) {
+        struct pollfd pfd = { .fd = listen_fd, .events = POLLIN };
+        pthread_attr_t attr;
+        pthread_t thread;
+        int client;
+
+        if (stats_requested) {
+            stats_requested = 0;
+            ele_sim_dump_stats(stderr);
+        }
+
+        if (poll(&pfd, 1, -1) <= 0) {
+            continue;
+        }
+
+        client = accept4(listen_fd, NULL, NULL, SOCK_CLOEXEC);
+        if (client < 0) {
+            continue;
+        }
+        if (verbose) {
+            fprintf(stderr, "ele-sim: new device context (fd %d)\n", client);
+        }
+
+        pthread_attr_init(&attr);
+        pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+        if (pthread_create(&thread, &attr, client_main, (void *)(intptr_t)client) != 0) {
+            close(client);
+        }
+        pthread_attr_destroy(&attr);
+    }
+
+    ele_sim_dump_stats(stderr);
+    close(listen_fd);
+    unlink(socket_path);
+    return 0;
+}
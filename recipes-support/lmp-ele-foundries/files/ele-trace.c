@@ -0,0 +1,470 @@
+/*
+ * Tracing and per-call latency statistics for the ELE PKCS#11 module
+ *
+ * Rings are claimed by a thread on its first traced call and released
+ * (not freed) when the thread exits, so their number is bounded by the
+ * peak thread count and the dump never walks freed memory. The signal
+ * handler and the thread-exit destructor only exist between C_Initialize
+ * and C_Finalize, so nothing refers into the module after dlclose(). A dump that
+ * races a writer may show a torn last event; that is accepted in
+ * exchange for a writer path without locks.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <errno.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <pthread.h>
+#include <sys/syscall.h>
+
+#include "ele-trace.h"
+
+typedef struct {
+    uint64_t ts_ns;
+    uint64_t dur_ns;
+    uint64_t arg;
+    uint32_t fn;
+    uint32_t rv;
+} ele_trace_event_t;
+
+typedef struct ele_trace_ring {
+    struct ele_trace_ring *next;
+    int in_use;
+    pid_t tid;
+    uint64_t head;
+    ele_trace_event_t ev[ELE_TRACE_RING_SIZE];
+} ele_trace_ring_t;
+
+typedef struct {
+    uint64_t calls;
+    uint64_t errors;
+    uint64_t total_ns;
+    uint64_t max_ns;
+    uint64_t hist[ELE_TRACE_BUCKETS];
+} ele_trace_stats_t;
+
+unsigned int ele_trace_flags;
+
+static pthread_once_t ele_trace_once = PTHREAD_ONCE_INIT;
+static const char *const *ele_trace_names;
+static unsigned int ele_trace_name_count;
+static char ele_trace_path[256];
+static ele_trace_stats_t ele_trace_stats[ELE_TRACE_MAX_FUNCTIONS];
+static ele_trace_ring_t *ele_trace_rings;
+static pthread_key_t ele_trace_ring_key;
+static int ele_trace_key_live;
+static int ele_trace_signo;
+static int ele_trace_sig_live;
+static struct sigaction ele_trace_sig_saved;
+static __thread ele_trace_ring_t *ele_trace_my_ring;
+static int ele_trace_dumping;
+
+static void ele_trace_ring_release(void *arg) {
+    ele_trace_ring_t *ring = arg;
+
+    __atomic_store_n(&ring->in_use, 0, __ATOMIC_RELEASE);
+}
+
+static ele_trace_ring_t *ele_trace_ring_get(void) {
+    ele_trace_ring_t *ring = ele_trace_my_ring;
+
+    if (__builtin_expect(ring != NULL, 1)) {
+        return ring;
+    }
+
+    // Reuse a ring left behind by an exited thread
+    for (ring = __atomic_load_n(&ele_trace_rings, __ATOMIC_ACQUIRE); ring; ring = ring->next) {
+        int expected = 0;
+        if (__atomic_compare_exchange_n(&ring->in_use, &expected, 1, 0,
+                                        __ATOMIC_ACQ_REL, __ATOMIC_RELAXED)) {
+            break;
+        }
+    }
+
+    if (ring == NULL) {
+        ring = calloc(1, sizeof(*ring));
+        if (ring == NULL) {
+            return NULL;
+        }
+        ring->in_use = 1;
+        ring->next = __atomic_load_n(&ele_trace_rings, __ATOMIC_RELAXED);
+        while (!__atomic_compare_exchange_n(&ele_trace_rings, &ring->next, ring, 1,
+                                            __ATOMIC_RELEASE, __ATOMIC_RELAXED)) {
+        }
+    }
+
+    ring->tid = (pid_t)syscall(SYS_gettid);
+    ele_trace_my_ring = ring;
+    if (ele_trace_key_live) {
+        pthread_setspecific(ele_trace_ring_key, ring);
+    }
+    return ring;
+}
+
+static unsigned int ele_trace_bucket(uint64_t ns) {
+    unsigned int b = ns ? 64 - (unsigned int)__builtin_clzll(ns) : 0;
+
+    return b < ELE_TRACE_BUCKETS ? b : ELE_TRACE_BUCKETS - 1;
+}
+
+void ele_trace_record(unsigned int fn, unsigned long rv, uint64_t arg, uint64_t start_ns) {
+    uint64_t now = ele_trace_now();
+    uint64_t dur = now - start_ns;
+
+    if (fn >= ELE_TRACE_MAX_FUNCTIONS) {
+        return;
+    }
+
+    if (ele_trace_flags & ELE_TRACE_STATS) {
+        ele_trace_stats_t *st = &ele_trace_stats[fn];
+        uint64_t max = __atomic_load_n(&st->max_ns, __ATOMIC_RELAXED);
+
+        __atomic_fetch_add(&st->calls, 1, __ATOMIC_RELAXED);
+        if (rv != 0) {
+            __atomic_fetch_add(&st->errors, 1, __ATOMIC_RELAXED);
+        }
+        __atomic_fetch_add(&st->total_ns, dur, __ATOMIC_RELAXED);
+        __atomic_fetch_add(&st->hist[ele_trace_bucket(dur)], 1, __ATOMIC_RELAXED);
+        while (dur > max && !__atomic_compare_exchange_n(&st->max_ns, &max, dur, 1,
+                                                         __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+        }
+    }
+
+    if (ele_trace_flags & ELE_TRACE_RING) {
+        ele_trace_ring_t *ring = ele_trace_ring_get();
+
+        if (ring != NULL) {
+            uint64_t head = ring->head;
+            ele_trace_event_t *ev = &ring->ev[head & (ELE_TRACE_RING_SIZE - 1)];
+
+            ev->ts_ns = start_ns;
+            ev->dur_ns = dur;
+            ev->arg = arg;
+            ev->fn = fn;
+            ev->rv = (uint32_t)rv;
+            __atomic_store_n(&ring->head, head + 1, __ATOMIC_RELEASE);
+        }
+    }
+}
+
+void ele_trace_log(const char *fmt, ...) {
+    va_list ap;
+
+    va_start(ap, fmt);
+    fputs("ELE PKCS#11: ", stderr);
+    vfprintf(stderr, fmt, ap);
+    fputc('\n', stderr);
+    va_end(ap);
+}
+
+// Minimal formatter: the dump must stay async-signal-safe (no stdio)
+
+typedef struct {
+    int fd;
+    size_t len;
+    char buf[4096];
+} ele_trace_out_t;
+
+static void out_flush(ele_trace_out_t *o) {
+    size_t off = 0;
+
+    while (off < o->len) {
+        ssize_t n = write(o->fd, o->buf + off, o->len - off);
+        if (n <= 0) {
+            break;
+        }
+        off += (size_t)n;
+    }
+    o->len = 0;
+}
+
+static void out_str(ele_trace_out_t *o, const char *s) {
+    while (*s) {
+        if (o->len == sizeof(o->buf)) {
+            out_flush(o);
+        }
+        o->buf[o->len++] = *s++;
+    }
+}
+
+// Unsigned value right-aligned in width columns (0 = no padding)
+static void out_u64(ele_trace_out_t *o, uint64_t v, int width) {
+    char tmp[24];
+    int i = (int)sizeof(tmp) - 1;
+
+    tmp[i] = '\0';
+    do {
+        tmp[--i] = (char)('0' + v % 10);
+        v /= 10;
+    } while (v && i > 0);
+    while ((int)sizeof(tmp) - 1 - i < width && i > 0) {
+        tmp[--i] = ' ';
+    }
+    out_str(o, &tmp[i]);
+}
+
+static void out_hex(ele_trace_out_t *o, uint64_t v) {
+    char tmp[19];
+    int i = (int)sizeof(tmp) - 1;
+
+    tmp[i] = '\0';
+    do {
+        tmp[--i] = "0123456789abcdef"[v & 0xF];
+        v >>= 4;
+    } while (v && i > 2);
+    tmp[--i] = 'x';
+    tmp[--i] = '0';
+    out_str(o, &tmp[i]);
+}
+
+static void out_name(ele_trace_out_t *o, unsigned int fn, int width) {
+    const char *name = (fn < ele_trace_name_count && ele_trace_names[fn]) ? ele_trace_names[fn] : "?";
+    int len = (int)strlen(name);
+
+    out_str(o, name);
+    while (len++ < width) {
+        out_str(o, " ");
+    }
+}
+
+// Upper bound (us) of the bucket holding the given fraction of calls
+static uint64_t ele_trace_percentile_us(const ele_trace_stats_t *st, uint64_t calls, unsigned int permille) {
+    uint64_t target = (calls * permille + 999) / 1000;
+    uint64_t seen = 0;
+
+    for (unsigned int b = 0; b < ELE_TRACE_BUCKETS; b++) {
+        seen += __atomic_load_n(&st->hist[b], __ATOMIC_RELAXED);
+        if (seen >= target) {
+            return ((1ULL << b) + 999) / 1000;
+        }
+    }
+    return 0;
+}
+
+void ele_trace_dump(void) {
+    static ele_trace_out_t out;
+    static char tmp[sizeof(ele_trace_path) + 4];
+    ele_trace_out_t *o = &out;
+    size_t len;
+
+    if (ele_trace_flags == 0 || __atomic_exchange_n(&ele_trace_dumping, 1, __ATOMIC_ACQUIRE)) {
+        return;
+    }
+
+    /*
+     * Write a new file and rename it over the dump: O_EXCL | O_NOFOLLOW
+     * never follows a planted symlink, and rename() replaces the link
+     * itself rather than its target.
+     */
+    len = strlen(ele_trace_path);
+    memcpy(tmp, ele_trace_path, len);
+    memcpy(tmp + len, ".tmp", 5);
+    unlink(tmp);
+
+    o->len = 0;
+    o->fd = open(tmp, O_WRONLY | O_CREAT | O_EXCL | O_NOFOLLOW | O_CLOEXEC, 0600);
+    if (o->fd < 0) {
+        __atomic_store_n(&ele_trace_dumping, 0, __ATOMIC_RELEASE);
+        return;
+    }
+
+    out_str(o, "# ELE PKCS#11 trace, pid ");
+    out_u64(o, (uint64_t)getpid(), 0);
+    out_str(o, "\n");
+
+    if (ele_trace_flags & ELE_TRACE_STATS) {
+        out_str(o, "\n# function                   calls   errors    total_us   mean_us    max_us  p50<=us  p99<=us p999<=us\n");
+        for (unsigned int fn = 0; fn < ELE_TRACE_MAX_FUNCTIONS; fn++) {
+            const ele_trace_stats_t *st = &ele_trace_stats[fn];
+            uint64_t calls = __atomic_load_n(&st->calls, __ATOMIC_RELAXED);
+            uint64_t total = __atomic_load_n(&st->total_ns, __ATOMIC_RELAXED);
+
+            if (calls == 0) {
+                continue;
+            }
+            out_name(o, fn, 24);
+            out_u64(o, calls, 10);
+            out_u64(o, __atomic_load_n(&st->errors, __ATOMIC_RELAXED), 9);
+            out_u64(o, total / 1000, 12);
+            out_u64(o, total / calls / 1000, 10);
+            out_u64(o, __atomic_load_n(&st->max_ns, __ATOMIC_RELAXED) / 1000, 10);
+            out_u64(o, ele_trace_percentile_us(st, calls, 500), 9);
+            out_u64(o, ele_trace_percentile_us(st, calls, 990), 9);
+            out_u64(o, ele_trace_percentile_us(st, calls, 999), 9);
+            out_str(o, "\n");
+        }
+
+        // Raw histograms: "<ns upper bound>:<count>" for non-empty buckets
+        out_str(o, "\n# histograms (bucket upper bound in ns : calls)\n");
+        for (unsigned int fn = 0; fn < ELE_TRACE_MAX_FUNCTIONS; fn++) {
+            const ele_trace_stats_t *st = &ele_trace_stats[fn];
+
+            if (__atomic_load_n(&st->calls, __ATOMIC_RELAXED) == 0) {
+                continue;
+            }
+            out_name(o, fn, 0);
+            for (unsigned int b = 0; b < ELE_TRACE_BUCKETS; b++) {
+                uint64_t n = __atomic_load_n(&st->hist[b], __ATOMIC_RELAXED);
+                if (n) {
+                    out_str(o, " ");
+                    out_u64(o, 1ULL << b, 0);
+                    out_str(o, ":");
+                    out_u64(o, n, 0);
+                }
+            }
+            out_str(o, "\n");
+        }
+    }
+
+    if (ele_trace_flags & ELE_TRACE_RING) {
+        out_str(o, "\n# ring events: tid start_ns duration_ns function rv arg\n");
+        for (ele_trace_ring_t *ring = __atomic_load_n(&ele_trace_rings, __ATOMIC_ACQUIRE);
+             ring; ring = ring->next) {
+            uint64_t head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+            uint64_t first = head > ELE_TRACE_RING_SIZE ? head - ELE_TRACE_RING_SIZE : 0;
+
+            for (uint64_t i = first; i < head; i++) {
+                const ele_trace_event_t *ev = &ring->ev[i & (ELE_TRACE_RING_SIZE - 1)];
+
+                out_u64(o, (uint64_t)ring->tid, 0);
+                out_str(o, " ");
+                out_u64(o, ev->ts_ns, 0);
+                out_str(o, " ");
+                out_u64(o, ev->dur_ns, 0);
+                out_str(o, " ");
+                out_name(o, ev->fn, 0);
+                out_str(o, " ");
+                out_hex(o, ev->rv);
+                out_str(o, " ");
+                out_hex(o, ev->arg);
+                out_str(o, "\n");
+            }
+        }
+    }
+
+    out_flush(o);
+    close(o->fd);
+    if (rename(tmp, ele_trace_path) != 0) {
+        unlink(tmp);
+    }
+    __atomic_store_n(&ele_trace_dumping, 0, __ATOMIC_RELEASE);
+}
+
+static void ele_trace_signal(int sig) {
+    int saved_errno = errno;
+
+    (void)sig;
+    ele_trace_dump();
+    errno = saved_errno;
+}
+
+static unsigned int ele_trace_parse(const char *spec) {
+    unsigned int flags = 0;
+    char buf[64];
+    char *save = NULL;
+
+    if (spec == NULL || *spec == '\0' || strcmp(spec, "0") == 0) {
+        return 0;
+    }
+
+    snprintf(buf, sizeof(buf), "%s", spec);
+    for (char *tok = strtok_r(buf, ",", &save); tok; tok = strtok_r(NULL, ",", &save)) {
+        if (strcmp(tok, "stats") == 0 || strcmp(tok, "1") == 0) {
+            flags |= ELE_TRACE_STATS;
+        } else if (strcmp(tok, "ring") == 0) {
+            flags |= ELE_TRACE_RING;
+        } else if (strcmp(tok, "log") == 0) {
+            flags |= ELE_TRACE_LOG;
+        } else if (strcmp(tok, "all") == 0) {
+            flags |= ELE_TRACE_STATS | ELE_TRACE_RING | ELE_TRACE_LOG;
+        }
+    }
+
+    return flags;
+}
+
+static void ele_trace_init_once(void) {
+    const char *path = getenv("ELE_PKCS11_TRACE_FILE");
+    const char *dir = getenv("XDG_RUNTIME_DIR");
+    const char *sig_env = getenv("ELE_PKCS11_TRACE_SIGNAL");
+
+    ele_trace_flags = ele_trace_parse(getenv("ELE_PKCS11_TRACE"));
+    if (!(ele_trace_flags & ELE_TRACE_TIMED)) {
+        return;
+    }
+
+    /*
+     * Prefer a directory only the user can write. A non-root process
+     * without a runtime directory cannot write /run and falls back to
+     * /tmp, which is safe because dumps never follow or reuse a link.
+     */
+    if (path != NULL && *path != '\0') {
+        snprintf(ele_trace_path, sizeof(ele_trace_path), "%s", path);
+    } else {
+        if (dir == NULL || *dir != '/') {
+            dir = access(ELE_TRACE_DEFAULT_DIR, W_OK) == 0 ? ELE_TRACE_DEFAULT_DIR
+                                                          : ELE_TRACE_FALLBACK_DIR;
+        }
+        snprintf(ele_trace_path, sizeof(ele_trace_path), "%s/%s.%d",
+                 dir, ELE_TRACE_DEFAULT_FILE, (int)getpid());
+    }
+
+    ele_trace_signo = SIGUSR2;
+    if (sig_env != NULL && *sig_env != '\0') {
+        ele_trace_signo = atoi(sig_env);
+    }
+}
+
+void ele_trace_setup(const char *const *names, unsigned int count) {
+    ele_trace_names = names;
+    ele_trace_name_count = count;
+    pthread_once(&ele_trace_once, ele_trace_init_once);
+}
+
+void ele_trace_start(void) {
+    struct sigaction old;
+
+    if (!(ele_trace_flags & ELE_TRACE_TIMED)) {
+        return;
+    }
+
+    if (!ele_trace_key_live && pthread_key_create(&ele_trace_ring_key, ele_trace_ring_release) == 0) {
+        ele_trace_key_live = 1;
+    }
+
+    // Never take a signal the application already handles
+    if (!ele_trace_sig_live && ele_trace_signo > 0 &&
+        sigaction(ele_trace_signo, NULL, &old) == 0 && old.sa_handler == SIG_DFL) {
+        struct sigaction sa;
+
+        memset(&sa, 0, sizeof(sa));
+        sa.sa_handler = ele_trace_signal;
+        sa.sa_flags = SA_RESTART;
+        sigemptyset(&sa.sa_mask);
+        if (sigaction(ele_trace_signo, &sa, &ele_trace_sig_saved) == 0) {
+            ele_trace_sig_live = 1;
+        }
+    }
+}
+
+void ele_trace_stop(void) {
+    struct sigaction cur;
+
+    // Put the old disposition back unless the application replaced ours since
+    if (ele_trace_sig_live) {
+        if (sigaction(ele_trace_signo, NULL, &cur) == 0 && cur.sa_handler == ele_trace_signal) {
+            sigaction(ele_trace_signo, &ele_trace_sig_saved, NULL);
+        }
+        ele_trace_sig_live = 0;
+    }
+
+    // No destructor may point into the module once it can be unloaded
+    if (ele_trace_key_live) {
+        pthread_key_delete(ele_trace_ring_key);
+        ele_trace_key_live = 0;
+    }
+}
@@ -0,0 +1,87 @@
+/*
+ * Tracing and per-call latency statistics for the ELE PKCS#11 module
+ *
+ * Controlled by ELE_PKCS11_TRACE, a comma separated list of:
+ *
+ *   stats   per-function call/error counts and log2 latency histograms
+ *   ring    per-thread ring buffer of the most recent calls
+ *   log     informational messages on stderr
+ *   all     everything above ("1" is accepted for "stats")
+ *
+ * With tracing off, C_GetFunctionList hands out the plain function list
+ * and the only cost left is a predicted branch in ELE_LOG. With stats or
+ * ring enabled it hands out a list of wrappers that time each call.
+ * Counters are updated with relaxed atomics and each ring has a single
+ * writer, so no lock is taken on the traced path.
+ *
+ * The collected data is written to ELE_PKCS11_TRACE_FILE on C_Finalize and
+ * whenever the process receives ELE_PKCS11_TRACE_SIGNAL (default SIGUSR2),
+ * so a long-running client can be inspected without stopping it. The
+ * default file is ele-pkcs11-trace.<pid> in $XDG_RUNTIME_DIR, or in /run
+ * when that is unset and writable (root), or else in /tmp.
+ */
+
+#ifndef ELE_TRACE_H
+#define ELE_TRACE_H
+
+#include <stdint.h>
+#include <time.h>
+
+#define ELE_TRACE_STATS         0x1
+#define ELE_TRACE_RING          0x2
+#define ELE_TRACE_LOG           0x4
+
+// Events kept per thread (power of two)
+#define ELE_TRACE_RING_SIZE     1024
+
+// log2(ns) latency buckets: bucket b holds [2^(b-1), 2^b) ns
+#define ELE_TRACE_BUCKETS       40
+
+#define ELE_TRACE_DEFAULT_DIR   "/run"
+#define ELE_TRACE_FALLBACK_DIR  "/tmp"
+#define ELE_TRACE_DEFAULT_FILE  "ele-pkcs11-trace"
+
+// Function id 0 is the mailbox exchange (arg = ELE command id)
+#define ELE_TRACE_FN_MAILBOX    0
+#define ELE_TRACE_MAX_FUNCTIONS 80
+
+extern unsigned int ele_trace_flags;
+
+/*
+ * Read the environment once and register the function names, indexed by
+ * function id (names[0] describes the mailbox). Safe to call repeatedly.
+ */
+void ele_trace_setup(const char *const *names, unsigned int count);
+
+/*
+ * Install the dump signal handler and the ring release destructor
+ * (C_Initialize), and remove both again (C_Finalize) so neither is left
+ * pointing into an unloaded module.
+ */
+void ele_trace_start(void);
+void ele_trace_stop(void);
+
+// Write the statistics and rings to the trace file (async-signal-safe)
+void ele_trace_dump(void);
+
+void ele_trace_record(unsigned int fn, unsigned long rv, uint64_t arg, uint64_t start_ns);
+
+void ele_trace_log(const char *fmt, ...) __attribute__((format(printf, 1, 2)));
+
+static inline uint64_t ele_trace_now(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+#define ELE_TRACE_TIMED (ELE_TRACE_STATS | ELE_TRACE_RING)
+
+#define ELE_LOG(...) \
+    do { \
+        if (__builtin_expect(ele_trace_flags & ELE_TRACE_LOG, 0)) { \
+            ele_trace_log(__VA_ARGS__); \
+        } \
+    } while (0)
+
+#endif /* ELE_TRACE_H */
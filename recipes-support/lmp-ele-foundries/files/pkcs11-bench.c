@@ -0,0 +1,587 @@
+/*
+ * pkcs11-bench - throughput and latency harness for PKCS#11 modules
+ *
+ * Loads any Cryptoki module with dlopen(), so the ELE module can be
+ * compared against SE050 (libsss_pkcs11) or SoftHSM on the same board.
+ * Each selected operation is run for a fixed duration at every requested
+ * thread count; every thread owns its own session and records the latency
+ * of each call. The report gives ops/sec and p50/p99/p99.9/max latency.
+ *
+ * Operations:
+ *   sign    C_SignInit + C_Sign (CKM_ECDSA over a 32-byte digest)
+ *   keygen  C_GenerateKeyPair (EC P-256 session keys, destroyed untimed)
+ *   random  C_GenerateRandom
+ *   find    C_FindObjectsInit / C_FindObjects / C_FindObjectsFinal
+ *
+ * Copyright (C) 2024 Dynamic Devices Ltd.
+ * Licensed under BSD-3-Clause
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <getopt.h>
+#include <dlfcn.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "ele-pkcs11.h"
+
+#define DEFAULT_MODULE      "/usr/lib/pkcs11/ele-pkcs11.so"
+#define DEFAULT_DURATION    5
+#define DEFAULT_WARMUP      10
+#define DEFAULT_RANDOM_SIZE 32
+#define MAX_THREAD_COUNTS   16
+#define MAX_THREADS         256
+
+/* DER encoded OID of prime256v1 (CKA_EC_PARAMS) */
+static const CK_BYTE p256_params[] = {
+    0x06, 0x08, 0x2a, 0x86, 0x48, 0xce, 0x3d, 0x03, 0x01, 0x07
+};
+
+typedef enum {
+    OP_SIGN = 0,
+    OP_KEYGEN,
+    OP_RANDOM,
+    OP_FIND,
+    OP_COUNT
+} bench_op_t;
+
+static const char *op_names[OP_COUNT] = { "sign", "keygen", "random", "find" };
+
+/* Command line configuration */
+static struct {
+    const char *module;
+    const char *pin;
+    CK_SLOT_ID slot;
+    int slot_set;
+    int ops[OP_COUNT];
+    unsigned int threads[MAX_THREAD_COUNTS];
+    unsigned int thread_counts;
+    unsigned int duration;
+    unsigned int warmup;
+    CK_ULONG random_size;
+    int csv;
+} cfg;
+
+static CK_FUNCTION_LIST_PTR p11;
+
+/* Per-thread state; latencies are nanoseconds */
+typedef struct {
+    pthread_t thread;
+    bench_op_t op;
+    CK_SESSION_HANDLE session;
+    CK_OBJECT_HANDLE key;
+    CK_OBJECT_HANDLE gen_pub;
+    CK_OBJECT_HANDLE gen_priv;
+    int gen_pending;
+    uint64_t *lat;
+    size_t count;
+    size_t cap;
+    unsigned long errors;
+    CK_RV last_error;
+    int setup_failed;
+} worker_t;
+
+static pthread_barrier_t start_barrier;
+static volatile int stop_flag;
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static int record(worker_t *w, uint64_t ns) {
+    if (w->count == w->cap) {
+        size_t cap = w->cap ? w->cap * 2 : 4096;
+        uint64_t *lat = realloc(w->lat, cap * sizeof(*lat));
+
+        if (lat == NULL) {
+            return -1;
+        }
+        w->lat = lat;
+        w->cap = cap;
+    }
+    w->lat[w->count++] = ns;
+    return 0;
+}
+
+static CK_RV generate_keypair(CK_SESSION_HANDLE session, CK_OBJECT_HANDLE *pub, CK_OBJECT_HANDLE *priv) {
+    CK_MECHANISM mech = { CKM_EC_KEY_PAIR_GEN, NULL, 0 };
+    CK_BBOOL ck_true = CK_TRUE;
+    CK_BBOOL ck_false = CK_FALSE;
+    CK_ATTRIBUTE pub_tmpl[] = {
+        { CKA_EC_PARAMS, (CK_VOID_PTR)p256_params, sizeof(p256_params) },
+        { CKA_TOKEN, &ck_false, sizeof(ck_false) },
+        { CKA_VERIFY, &ck_true, sizeof(ck_true) },
+    };
+    CK_ATTRIBUTE priv_tmpl[] = {
+        { CKA_TOKEN, &ck_false, sizeof(ck_false) },
+        { CKA_SIGN, &ck_true, sizeof(ck_true) },
+        { CKA_SENSITIVE, &ck_true, sizeof(ck_true) },
+    };
+
+    return p11->C_GenerateKeyPair(session, &mech,
+                                  pub_tmpl, sizeof(pub_tmpl) / sizeof(pub_tmpl[0]),
+                                  priv_tmpl, sizeof(priv_tmpl) / sizeof(priv_tmpl[0]),
+                                  pub, priv);
+}
+
+/* One timed operation; returns the PKCS#11 result */
+static CK_RV run_once(worker_t *w, CK_BYTE *buf, size_t buf_len) {
+    CK_RV rv;
+
+    switch (w->op) {
+    case OP_SIGN: {
+        CK_MECHANISM mech = { CKM_ECDSA, NULL, 0 };
+        CK_BYTE digest[32];
+        CK_ULONG sig_len = buf_len;
+
+        memset(digest, 0xA5, sizeof(digest));
+        rv = p11->C_SignInit(w->session, &mech, w->key);
+        if (rv == CKR_OK) {
+            rv = p11->C_Sign(w->session, digest, sizeof(digest), buf, &sig_len);
+        }
+        return rv;
+    }
+    case OP_KEYGEN:
+        /* The pair is destroyed by keygen_cleanup(), outside the timed region */
+        rv = generate_keypair(w->session, &w->gen_pub, &w->gen_priv);
+        w->gen_pending = (rv == CKR_OK);
+        return rv;
+    case OP_RANDOM:
+        return p11->C_GenerateRandom(w->session, buf, cfg.random_size);
+    case OP_FIND: {
+        CK_OBJECT_CLASS cls = CKO_PRIVATE_KEY;
+        CK_ATTRIBUTE tmpl[] = { { CKA_CLASS, &cls, sizeof(cls) } };
+        CK_OBJECT_HANDLE found[16];
+        CK_ULONG n;
+
+        rv = p11->C_FindObjectsInit(w->session, tmpl, 1);
+        if (rv != CKR_OK) {
+            return rv;
+        }
+        do {
+            rv = p11->C_FindObjects(w->session, found, 16, &n);
+        } while (rv == CKR_OK && n == 16);
+        if (rv != CKR_OK) {
+            p11->C_FindObjectsFinal(w->session);
+            return rv;
+        }
+        return p11->C_FindObjectsFinal(w->session);
+    }
+    default:
+        return CKR_FUNCTION_NOT_SUPPORTED;
+    }
+}
+
+static void keygen_cleanup(worker_t *w) {
+    if (!w->gen_pending) {
+        return;
+    }
+    p11->C_DestroyObject(w->session, w->gen_pub);
+    p11->C_DestroyObject(w->session, w->gen_priv);
+    w->gen_pending = 0;
+}
+
+static void *worker_main(void *arg) {
+    worker_t *w = arg;
+    size_t buf_len = cfg.random_size > 512 ? cfg.random_size : 512;
+    CK_BYTE *buf = calloc(1, buf_len);
+    CK_OBJECT_HANDLE pub;
+    CK_RV rv;
+
+    rv = p11->C_OpenSession(cfg.slot, CKF_SERIAL_SESSION | CKF_RW_SESSION, NULL, NULL, &w->session);
+    if (rv == CKR_OK && cfg.pin) {
+        rv = p11->C_Login(w->session, CKU_USER, (CK_UTF8CHAR_PTR)cfg.pin, strlen(cfg.pin));
+        if (rv == CKR_USER_ALREADY_LOGGED_IN) {
+            rv = CKR_OK;
+        }
+    }
+    /* Signing and find need a key of this thread's own */
+    if (rv == CKR_OK && (w->op == OP_SIGN || w->op == OP_FIND)) {
+        rv = generate_keypair(w->session, &pub, &w->key);
+    }
+    if (rv != CKR_OK || buf == NULL) {
+        w->setup_failed = 1;
+        w->last_error = rv;
+    }
+
+    /* Untimed warm-up so first-use costs do not land in the percentiles */
+    for (unsigned int i = 0; !w->setup_failed && i < cfg.warmup; i++) {
+        run_once(w, buf, buf_len);
+        keygen_cleanup(w);
+    }
+
+    pthread_barrier_wait(&start_barrier);
+
+    while (!w->setup_failed && !stop_flag) {
+        uint64_t t0 = now_ns();
+
+        rv = run_once(w, buf, buf_len);
+        if (rv == CKR_OK) {
+            if (record(w, now_ns() - t0) != 0) {
+                break;
+            }
+        } else {
+            w->errors++;
+            w->last_error = rv;
+        }
+        keygen_cleanup(w);
+    }
+
+    if (w->session) {
+        p11->C_CloseSession(w->session);
+    }
+    free(buf);
+    return NULL;
+}
+
+static int cmp_u64(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t *)a;
+    uint64_t y = *(const uint64_t *)b;
+
+    return (x > y) - (x < y);
+}
+
+static double percentile_us(const uint64_t *sorted, size_t n, double p) {
+    size_t idx;
+
+    if (n == 0) {
+        return 0.0;
+    }
+    idx = (size_t)(p * (double)n + 0.999999);
+    if (idx == 0) {
+        idx = 1;
+    }
+    if (idx > n) {
+        idx = n;
+    }
+    return (double)sorted[idx - 1] / 1000.0;
+}
+
+static int run_bench(bench_op_t op, unsigned int nthreads) {
+    worker_t *workers = calloc(nthreads, sizeof(*workers));
+    uint64_t *all = NULL;
+    size_t total = 0;
+    unsigned long errors = 0;
+    CK_RV last_error = CKR_OK;
+    int setup_failed = 0;
+    uint64_t t0, elapsed;
+
+    if (workers == NULL) {
+        return -1;
+    }
+
+    stop_flag = 0;
+    pthread_barrier_init(&start_barrier, NULL, nthreads + 1);
+
+    for (unsigned int i = 0; i < nthreads; i++) {
+        workers[i].op = op;
+        if (pthread_create(&workers[i].thread, NULL, worker_main, &workers[i]) != 0) {
+            fprintf(stderr, "pthread_create failed: %s\n", strerror(errno));
+            exit(1);
+        }
+    }
+
+    pthread_barrier_wait(&start_barrier);
+    t0 = now_ns();
+    sleep(cfg.duration);
+    stop_flag = 1;
+
+    for (unsigned int i = 0; i < nthreads; i++) {
+        pthread_join(workers[i].thread, NULL);
+    }
+    elapsed = now_ns() - t0;
+    pthread_barrier_destroy(&start_barrier);
+
+    for (unsigned int i = 0; i < nthreads; i++) {
+        total += workers[i].count;
+        errors += workers[i].errors;
+        if (workers[i].last_error != CKR_OK) {
+            last_error = workers[i].last_error;
+        }
+        setup_failed |= workers[i].setup_failed;
+    }
+
+    all = malloc((total ? total : 1) * sizeof(*all));
+    if (all == NULL) {
+        fprintf(stderr, "Out of memory collecting %zu samples\n", total);
+        exit(1);
+    }
+    total = 0;
+    for (unsigned int i = 0; i < nthreads; i++) {
+        memcpy(all + total, workers[i].lat, workers[i].count * sizeof(*all));
+        total += workers[i].count;
+        free(workers[i].lat);
+    }
+    qsort(all, total, sizeof(*all), cmp_u64);
+
+    double secs = (double)elapsed / 1e9;
+    double rate = secs > 0 ? (double)total / secs : 0.0;
+    double p50 = percentile_us(all, total, 0.50);
+    double p99 = percentile_us(all, total, 0.99);
+    double p999 = percentile_us(all, total, 0.999);
+    double max = total ? (double)all[total - 1] / 1000.0 : 0.0;
+
+    if (cfg.csv) {
+        printf("%s,%u,%zu,%lu,%.1f,%.1f,%.1f,%.1f,%.1f\n",
+               op_names[op], nthreads, total, errors, rate, p50, p99, p999, max);
+    } else {
+        printf("%-8s %7u %10zu %8lu %11.1f %10.1f %10.1f %10.1f %10.1f",
+               op_names[op], nthreads, total, errors, rate, p50, p99, p999, max);
+        if (setup_failed || errors) {
+            printf("  (%s0x%08lx)", setup_failed ? "setup failed, " : "last error ", last_error);
+        }
+        printf("\n");
+    }
+
+    free(all);
+    free(workers);
+    return setup_failed ? -1 : 0;
+}
+
+static int parse_ops(const char *list) {
+    char *copy = strdup(list);
+    char *save = NULL;
+
+    memset(cfg.ops, 0, sizeof(cfg.ops));
+    for (char *tok = strtok_r(copy, ",", &save); tok; tok = strtok_r(NULL, ",", &save)) {
+        int found = 0;
+
+        if (strcmp(tok, "all") == 0) {
+            for (int i = 0; i < OP_COUNT; i++) {
+                cfg.ops[i] = 1;
+            }
+            continue;
+        }
+        for (int i = 0; i < OP_COUNT; i++) {
+            if (strcmp(tok, op_names[i]) == 0) {
+                cfg.ops[i] = 1;
+                found = 1;
+            }
+        }
+        if (!found) {
+            fprintf(stderr, "Unknown operation: %s\n", tok);
+            free(copy);
+            return -1;
+        }
+    }
+    free(copy);
+    return 0;
+}
+
+static int parse_threads(const char *list) {
+    char *copy = strdup(list);
+    char *save = NULL;
+
+    cfg.thread_counts = 0;
+    for (char *tok = strtok_r(copy, ",", &save); tok; tok = strtok_r(NULL, ",", &save)) {
+        long n = strtol(tok, NULL, 0);
+
+        if (n < 1 || n > MAX_THREADS || cfg.thread_counts == MAX_THREAD_COUNTS) {
+            fprintf(stderr, "Invalid thread count: %s\n", tok);
+            free(copy);
+            return -1;
+        }
+        cfg.threads[cfg.thread_counts++] = (unsigned int)n;
+    }
+    free(copy);
+    return cfg.thread_counts ? 0 : -1;
+}
+
+static void print_usage(const char *prog) {
+    printf("Usage: %s [options]\n", prog);
+    printf("\n");
+    printf("Options:\n");
+    printf("  -m, --module PATH      PKCS#11 module (default %s)\n", DEFAULT_MODULE);
+    printf("  -s, --slot ID          Slot to use (default: first slot with a token)\n");
+    printf("  -p, --pin PIN          Log in as CKU_USER with PIN (SoftHSM, SE050)\n");
+    printf("  -o, --ops LIST         Comma separated: sign,keygen,random,find,all (default all)\n");
+    printf("  -t, --threads LIST     Comma separated thread counts (default 1)\n");
+    printf("  -d, --duration SEC     Seconds per operation and thread count (default %d)\n",
+           DEFAULT_DURATION);
+    printf("  -w, --warmup N         Untimed operations per thread first (default %d)\n",
+           DEFAULT_WARMUP);
+    printf("  -r, --random-size N    Bytes per C_GenerateRandom (default %d)\n",
+           DEFAULT_RANDOM_SIZE);
+    printf("  -c, --csv              Machine readable output\n");
+    printf("  -h, --help             Show this help\n");
+    printf("\n");
+    printf("Examples:\n");
+    printf("  %s -t 1,2,4 -o sign,random\n", prog);
+    printf("  %s -m /usr/lib/softhsm/libsofthsm2.so -p 1234 -t 1,4 --csv\n", prog);
+}
+
+static CK_RV select_slot(void) {
+    CK_SLOT_ID slots[16];
+    CK_ULONG count = 16;
+    CK_RV rv;
+
+    if (cfg.slot_set) {
+        return CKR_OK;
+    }
+    rv = p11->C_GetSlotList(CK_TRUE, slots, &count);
+    if (rv != CKR_OK) {
+        return rv;
+    }
+    if (count == 0) {
+        return CKR_SLOT_ID_INVALID;
+    }
+    cfg.slot = slots[0];
+    return CKR_OK;
+}
+
+static void print_module_info(void) {
+    CK_INFO info;
+    CK_TOKEN_INFO token;
+
+    if (p11->C_GetInfo(&info) == CKR_OK) {
+        fprintf(stderr, "Module:  %.32s %u.%u (Cryptoki %u.%u)\n",
+                info.libraryDescription, info.libraryVersion.major, info.libraryVersion.minor,
+                info.cryptokiVersion.major, info.cryptokiVersion.minor);
+    }
+    if (p11->C_GetTokenInfo(cfg.slot, &token) == CKR_OK) {
+        fprintf(stderr, "Token:   %.32s (%.16s) in slot %lu\n", token.label, token.model, cfg.slot);
+    }
+    fprintf(stderr, "Run:     %u s per point, %u warm-up ops per thread\n\n", cfg.duration, cfg.warmup);
+}
+
+int main(int argc, char *argv[]) {
+    static const struct option long_opts[] = {
+        { "module", required_argument, NULL, 'm' },
+        { "slot", required_argument, NULL, 's' },
+        { "pin", required_argument, NULL, 'p' },
+        { "ops", required_argument, NULL, 'o' },
+        { "threads", required_argument, NULL, 't' },
+        { "duration", required_argument, NULL, 'd' },
+        { "warmup", required_argument, NULL, 'w' },
+        { "random-size", required_argument, NULL, 'r' },
+        { "csv", no_argument, NULL, 'c' },
+        { "help", no_argument, NULL, 'h' },
+        { NULL, 0, NULL, 0 }
+    };
+    CK_RV (*get_function_list)(CK_FUNCTION_LIST_PTR_PTR);
+    CK_C_INITIALIZE_ARGS init_args;
+    void *module;
+    int failed = 0;
+    int opt;
+    CK_RV rv;
+
+    cfg.module = DEFAULT_MODULE;
+    cfg.duration = DEFAULT_DURATION;
+    cfg.warmup = DEFAULT_WARMUP;
+    cfg.random_size = DEFAULT_RANDOM_SIZE;
+    cfg.threads[0] = 1;
+    cfg.thread_counts = 1;
+    for (int i = 0; i < OP_COUNT; i++) {
+        cfg.ops[i] = 1;
+    }
+
+    while ((opt = getopt_long(argc, argv, "m:s:p:o:t:d:w:r:ch", long_opts, NULL)) != -1) {
+        switch (opt) {
+        case 'm':
+            cfg.module = optarg;
+            break;
+        case 's':
+            cfg.slot = strtoul(optarg, NULL, 0);
+            cfg.slot_set = 1;
+            break;
+        case 'p':
+            cfg.pin = optarg;
+            break;
+        case 'o':
+            if (parse_ops(optarg) != 0) {
+                return 1;
+            }
+            break;
+        case 't':
+            if (parse_threads(optarg) != 0) {
+                return 1;
+            }
+            break;
+        case 'd':
+            cfg.duration = (unsigned int)strtoul(optarg, NULL, 0);
+            break;
+        case 'w':
+            cfg.warmup = (unsigned int)strtoul(optarg, NULL, 0);
+            break;
+        case 'r':
+            cfg.random_size = strtoul(optarg, NULL, 0);
+            break;
+        case 'c':
+            cfg.csv = 1;
+            break;
+        case 'h':
+            print_usage(argv[0]);
+            return 0;
+        default:
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (cfg.duration == 0 || cfg.random_size == 0) {
+        fprintf(stderr, "Duration and random size must be non-zero\n");
+        return 1;
+    }
+
+    module = dlopen(cfg.module, RTLD_NOW | RTLD_LOCAL);
+    if (module == NULL) {
+        fprintf(stderr, "Cannot load %s: %s\n", cfg.module, dlerror());
+        return 1;
+    }
+
+    get_function_list = (CK_RV (*)(CK_FUNCTION_LIST_PTR_PTR))dlsym(module, "C_GetFunctionList");
+    if (get_function_list == NULL || get_function_list(&p11) != CKR_OK || p11 == NULL) {
+        fprintf(stderr, "%s: no usable C_GetFunctionList\n", cfg.module);
+        return 1;
+    }
+
+    memset(&init_args, 0, sizeof(init_args));
+    init_args.flags = CKF_OS_LOCKING_OK;
+    rv = p11->C_Initialize(&init_args);
+    if (rv != CKR_OK) {
+        fprintf(stderr, "C_Initialize failed: 0x%08lx\n", rv);
+        return 1;
+    }
+
+    rv = select_slot();
+    if (rv != CKR_OK) {
+        fprintf(stderr, "No usable slot: 0x%08lx\n", rv);
+        p11->C_Finalize(NULL);
+        return 1;
+    }
+
+    print_module_info();
+
+    if (cfg.csv) {
+        printf("op,threads,ops,errors,ops_per_sec,p50_us,p99_us,p999_us,max_us\n");
+    } else {
+        printf("%-8s %7s %10s %8s %11s %10s %10s %10s %10s\n",
+               "op", "threads", "ops", "errors", "ops/sec", "p50 us", "p99 us", "p99.9 us", "max us");
+    }
+    fflush(stdout);
+
+    for (int op = 0; op < OP_COUNT; op++) {
+        if (!cfg.ops[op]) {
+            continue;
+        }
+        for (unsigned int i = 0; i < cfg.thread_counts; i++) {
+            if (run_bench((bench_op_t)op, cfg.threads[i]) != 0) {
+                failed = 1;
+            }
+            fflush(stdout);
+        }
+    }
+
+    p11->C_Finalize(NULL);
+    dlclose(module);
+
+    return failed;
+}
@@ -31,41 +31,41 @@ echo ""
 
 firmware_found=0
 
-for fw_file in "$ELE_FIRMWARE_DIR"/*; do
-    if [ -f "$fw_file" ]; then
-        firmware_found=1
-        filename=$(basename "$fw_file")
-        size=$(stat -c%s "$fw_file")
-        size_kb=$((size / 1024))
-        modified=$(stat -c%y "$fw_file" | cut -d'.' -f1)
-        permissions=$(stat -c%A "$fw_file")
-        hash=$(sha256sum "$fw_file" | cut -d' ' -f1)
-        
-        echo "  📄 $filename"
-        echo "      Size: $size bytes (${size_kb} KB)"
-        echo "      Modified: $modified"
-        echo "      Permissions: $permissions"
-        echo "      SHA256: $hash"
-        
-        # Try to identify firmware type
-        case "$filename" in
-            *mx93a1*)
-                echo "      Type: i.MX93 A1 revision firmware"
-                ;;
-            *mx93a0*)
-                echo "      Type: i.MX93 A0 revision firmware"
-                ;;
-            *ahab*)
-                echo "      Type: Advanced High Assurance Boot (AHAB) container"
-                ;;
-            *)
-                echo "      Type: Unknown ELE firmware"
-                ;;
-        esac
-        
-        echo ""
-    fi
-done
+# One stat and one sha256sum for all files rather than four processes per file
+declare -A hashes
+while read -r hash path; do
+    hashes["$path"]="$hash"
+done < <(find "$ELE_FIRMWARE_DIR" -maxdepth 1 -type f -exec sha256sum {} + 2>/dev/null)
+
+while IFS='|' read -r fw_file size modified permissions; do
+    firmware_found=1
+    filename=$(basename "$fw_file")
+    size_kb=$((size / 1024))
+    
+    echo "  📄 $filename"
+    echo "      Size: $size bytes (${size_kb} KB)"
+    echo "      Modified: ${modified%%.*}"
+    echo "      Permissions: $permissions"
+    echo "      SHA256: ${hashes[$fw_file]}"
+    
+    # Try to identify firmware type
+    case "$filename" in
+        *mx93a1*)
+            echo "      Type: i.MX93 A1 revision firmware"
+            ;;
+        *mx93a0*)
+            echo "      Type: i.MX93 A0 revision firmware"
+            ;;
+        *ahab*)
+            echo "      Type: Advanced High Assurance Boot (AHAB) container"
+            ;;
+        *)
+            echo "      Type: Unknown ELE firmware"
+            ;;
+    esac
+    
+    echo ""
+done < <(find "$ELE_FIRMWARE_DIR" -maxdepth 1 -type f -exec stat -c '%n|%s|%y|%A' {} + 2>/dev/null | sort)
 
 if [ $firmware_found -eq 0 ]; then
     echo "  ⚠️  No firmware files found in $ELE_FIRMWARE_DIR"
@@ -90,16 +90,10 @@ echo ""
 echo "⚙️  ELE Operational Status:"
 echo ""
 
-if [ -e "/dev/ele_mu" ]; then
-    echo "  ✅ ELE device node present: /dev/ele_mu"
-else
-    echo "  ❌ ELE device node missing: /dev/ele_mu"
-fi
-
-if [ -d "/sys/class/misc/ele_mu" ]; then
-    echo "  ✅ ELE sysfs interface present"
+if command -v ele-probe >/dev/null 2>&1; then
+    ele-probe --no-mailbox | grep -E "device node|sysfs" | sed 's/^/  /'
 else
-    echo "  ❌ ELE sysfs interface missing"
+    echo "  ❌ ele-probe not installed (libeleprobe)"
 fi
 
 # Check for ELE-related kernel modules
@@ -4,45 +4,19 @@
 
 set -e
 
-ELE_DEVICE="/dev/ele_mu"
-ELE_SYSFS="/sys/class/misc/ele_mu"
-ELE_FIRMWARE_DIR="/lib/firmware/imx/ele"
-
 echo "🔐 EdgeLock Enclave (ELE) Status Report"
 echo "======================================="
 echo "Platform: i.MX93 Jaguar E-Ink"
 echo "Date: $(date)"
 echo ""
 
-# Check ELE Device Node
-echo "📋 Device Node Status:"
-if [ -e "$ELE_DEVICE" ]; then
-    echo "  ✅ ELE device node: $ELE_DEVICE (present)"
-    ls -la "$ELE_DEVICE"
-else
-    echo "  ❌ ELE device node: $ELE_DEVICE (missing)"
-fi
-echo ""
-
-# Check ELE Sysfs Interface
-echo "📁 Sysfs Interface:"
-if [ -d "$ELE_SYSFS" ]; then
-    echo "  ✅ ELE sysfs: $ELE_SYSFS (present)"
-    echo "  📄 Available attributes:"
-    ls -la "$ELE_SYSFS/" 2>/dev/null | grep -v "^total" | sed 's/^/    /'
-else
-    echo "  ❌ ELE sysfs: $ELE_SYSFS (missing)"
-fi
-echo ""
-
-# Check ELE Firmware
-echo "💾 Firmware Status:"
-if [ -d "$ELE_FIRMWARE_DIR" ]; then
-    echo "  ✅ Firmware directory: $ELE_FIRMWARE_DIR (present)"
-    echo "  📦 Available firmware files:"
-    ls -la "$ELE_FIRMWARE_DIR/" 2>/dev/null | grep -v "^total" | sed 's/^/    /'
+# Device node, sysfs, mailbox, OCOTP, firmware and reserved memory come
+# from one libeleprobe snapshot (cached in /run) instead of a probe each
+echo "📋 ELE Platform Snapshot:"
+if command -v ele-probe >/dev/null 2>&1; then
+    ele-probe | sed 's/^/  /'
 else
-    echo "  ❌ Firmware directory: $ELE_FIRMWARE_DIR (missing)"
+    echo "  ❌ ele-probe not installed (libeleprobe)"
 fi
 echo ""
 
@@ -20,11 +20,24 @@
 #include <sys/ioctl.h>
 #include <errno.h>
 #include <stdint.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <sys/resource.h>
+#include <signal.h>
+#include <poll.h>
+#include <time.h>
+#include <getopt.h>
+#include <pthread.h>
+#include <eleprobe.h>
+#include <ele-proto.h>    /* mailbox framing and command ids */
 
-/* ELE Device Paths */
+/* ELE Device Path (overridable through the environment, e.g. by ele-sim);
+ * the other platform paths are resolved by libeleprobe */
 #define ELE_DEVICE_PATH "/dev/ele_mu"
-#define ELE_FIRMWARE_PATH "/lib/firmware/imx/ele"
-#define ELE_SYSFS_PATH "/sys/class/misc/ele_mu"
+
+static const char *ele_device_path = ELE_DEVICE_PATH;
 
 /* Test Results */
 typedef enum {
@@ -33,11 +46,18 @@ typedef enum {
     TEST_SKIP = 2
 } test_result_t;
 
+/* Test flags */
+#define TEST_EXCLUSIVE 0x1    /* must not run alongside other tests */
+#define TEST_OPT_IN 0x2       /* disruptive: runs only when named or ELE_TEST_OPT_IN=1 */
+
 /* Test Structure */
 typedef struct {
     const char *name;
     const char *description;
     test_result_t (*test_func)(void);
+    unsigned int flags;
+    void (*save_state)(void);       /* run by the parent before the test */
+    void (*restore_state)(void);    /* run by the parent once the test is reaped */
 } ele_test_t;
 
 /* Forward Declarations */
@@ -49,6 +69,8 @@ static test_result_t test_ele_secure_boot_status(void);
 static test_result_t test_ele_key_management(void);
 static test_result_t test_ele_crypto_services(void);
 static test_result_t test_ele_power_management(void);
+static void pm_save_state(void);
+static void pm_restore_state(void);
 static test_result_t test_ele_lifecycle_state(void);
 static test_result_t test_ele_otp_operations(void);
 
@@ -57,57 +79,73 @@ static const ele_test_t ele_tests[] = {
     {
         "device_presence",
         "Verify ELE device node exists and is accessible",
-        test_ele_device_presence
+        test_ele_device_presence,
+        0
     },
     {
         "firmware_presence", 
         "Verify ELE firmware files are present",
-        test_ele_firmware_presence
+        test_ele_firmware_presence,
+        0
     },
     {
         "sysfs_interface",
         "Verify ELE sysfs interface is functional",
-        test_ele_sysfs_interface
+        test_ele_sysfs_interface,
+        0
     },
     {
         "basic_communication",
         "Test basic communication with ELE subsystem",
-        test_ele_basic_communication
+        test_ele_basic_communication,
+        0
     },
     {
         "secure_boot_status",
         "Verify secure boot configuration and status",
-        test_ele_secure_boot_status
+        test_ele_secure_boot_status,
+        0
     },
     {
         "key_management",
         "Test key generation and management operations",
-        test_ele_key_management
+        test_ele_key_management,
+        0
     },
     {
         "crypto_services",
         "Test cryptographic service functionality",
-        test_ele_crypto_services
+        test_ele_crypto_services,
+        0
     },
     {
         "power_management",
         "Test ELE power management integration",
-        test_ele_power_management
+        test_ele_power_management,
+        TEST_EXCLUSIVE | TEST_OPT_IN,
+        pm_save_state,
+        pm_restore_state
     },
     {
         "lifecycle_state",
         "Verify device lifecycle state management",
-        test_ele_lifecycle_state
+        test_ele_lifecycle_state,
+        0
     },
     {
         "otp_operations",
         "Test One-Time Programmable (OTP) operations",
-        test_ele_otp_operations
+        test_ele_otp_operations,
+        0
     }
 };
 
 #define NUM_TESTS (sizeof(ele_tests) / sizeof(ele_tests[0]))
 
+/* Parallel runner defaults */
+#define DEFAULT_TEST_TIMEOUT 30          /* seconds per test */
+#define MAX_TEST_OUTPUT (64 * 1024)      /* captured output kept per test */
+
 /* Utility Functions */
 static void print_test_header(const char *name, const char *description) {
     printf("\n=== %s ===\n", name);
@@ -134,29 +172,140 @@ static int file_exists(const char *path) {
     return access(path, F_OK) == 0;
 }
 
-static int file_readable(const char *path) {
-    return access(path, R_OK) == 0;
+static const char *env_path(const char *name, const char *fallback) {
+    const char *value = getenv(name);
+    return (value != NULL && *value != '\0') ? value : fallback;
+}
+
+/* Opt-in tests join "all" and a bare "run" only when ELE_TEST_OPT_IN=1 */
+static int test_selected_by_default(const ele_test_t *test) {
+    const char *opt_in = getenv("ELE_TEST_OPT_IN");
+    
+    return !(test->flags & TEST_OPT_IN) || (opt_in != NULL && strcmp(opt_in, "1") == 0);
+}
+
+static test_result_t run_test_with_state(const ele_test_t *test) {
+    test_result_t result;
+    
+    if (test->save_state != NULL) {
+        test->save_state();
+    }
+    result = test->test_func();
+    if (test->restore_state != NULL) {
+        test->restore_state();
+    }
+    return result;
+}
+
+static void init_paths(void) {
+    ele_device_path = env_path("ELE_DEVICE_PATH", ELE_DEVICE_PATH);
+}
+
+/*
+ * Platform snapshot from libeleprobe, taken fresh once per run (the tests
+ * check the live state) and left in the /run cache for the other tools
+ */
+static const struct ele_probe *platform(void) {
+    static struct ele_probe probe;
+    static int probed;
+    
+    if (!probed) {
+        ele_probe_get(&probe, ELE_PROBE_REFRESH);
+        probed = 1;
+    }
+    return &probe;
+}
+
+/* Open a device context; an ele-sim daemon serves a socket in place of the node */
+static int ele_open_device(void) {
+    struct sockaddr_un addr;
+    struct stat st;
+    int fd;
+    
+    if (stat(ele_device_path, &st) != 0 || !S_ISSOCK(st.st_mode)) {
+        return open(ele_device_path, O_RDWR);
+    }
+    
+    if (strlen(ele_device_path) >= sizeof(addr.sun_path)) {
+        errno = ENAMETOOLONG;
+        return -1;
+    }
+    
+    fd = socket(AF_UNIX, SOCK_SEQPACKET, 0);
+    if (fd < 0) {
+        return -1;
+    }
+    
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, ele_device_path);
+    if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0) {
+        int err = errno;
+        close(fd);
+        errno = err;
+        return -1;
+    }
+    
+    return fd;
+}
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static int compare_u64(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+    return x < y ? -1 : x > y;
+}
+
+static uint32_t ele_header(uint8_t version, uint8_t command, size_t words) {
+    return ((uint32_t)ELE_MSG_TAG_CMD << 24) | ((uint32_t)command << 16) |
+           ((uint32_t)words << 8) | version;
+}
+
+/* Send one command and check the response header and status */
+static int ele_exchange(int fd, const uint32_t *cmd, size_t words, uint32_t *rsp) {
+    ssize_t n;
+    
+    if (write(fd, cmd, words * sizeof(uint32_t)) != (ssize_t)(words * sizeof(uint32_t))) {
+        return -1;
+    }
+    do {
+        n = read(fd, rsp, ELE_MSG_MAX_WORDS * sizeof(uint32_t));
+    } while (n < 0 && errno == EINTR);
+    
+    if (n < (ssize_t)(2 * sizeof(uint32_t)) || (rsp[0] >> 24) != ELE_MSG_TAG_RSP ||
+        ((rsp[0] >> 16) & 0xFF) != ((cmd[0] >> 16) & 0xFF)) {
+        return -1;
+    }
+    return (rsp[1] & 0xFF) == ELE_RSP_SUCCESS ? 0 : -1;
 }
 
 /* Test Implementations */
 static test_result_t test_ele_device_presence(void) {
-    if (!file_exists(ELE_DEVICE_PATH)) {
-        printf("Device node %s not found\n", ELE_DEVICE_PATH);
+    const struct ele_probe *p = platform();
+    
+    if (!(p->present & ELE_PROBE_HAVE_DEVICE)) {
+        printf("Device node %s not found\n", p->device_path);
         return TEST_FAIL;
     }
     
-    if (!file_readable(ELE_DEVICE_PATH)) {
-        printf("Device node %s not readable\n", ELE_DEVICE_PATH);
+    if (!(p->present & ELE_PROBE_HAVE_DEVICE_ACCESS)) {
+        printf("Device node %s not accessible\n", p->device_path);
         return TEST_FAIL;
     }
     
-    printf("Device node %s present and accessible\n", ELE_DEVICE_PATH);
+    printf("Device node %s present and accessible\n", p->device_path);
     return TEST_PASS;
 }
 
 static test_result_t test_ele_firmware_presence(void) {
-    if (!file_exists(ELE_FIRMWARE_PATH)) {
-        printf("Firmware directory %s not found\n", ELE_FIRMWARE_PATH);
+    const struct ele_probe *p = platform();
+    
+    if (!(p->present & ELE_PROBE_HAVE_FIRMWARE_DIR)) {
+        printf("Firmware directory %s not found\n", p->firmware_path);
         return TEST_FAIL;
     }
     
@@ -168,16 +317,16 @@ static test_result_t test_ele_firmware_presence(void) {
     
     int found_firmware = 0;
     for (size_t i = 0; i < sizeof(firmware_files) / sizeof(firmware_files[0]); i++) {
-        char full_path[256];
-        snprintf(full_path, sizeof(full_path), "%s/%s", ELE_FIRMWARE_PATH, firmware_files[i]);
-        if (file_exists(full_path)) {
-            printf("Found firmware: %s\n", firmware_files[i]);
-            found_firmware = 1;
+        for (uint32_t f = 0; f < p->firmware_count && f < ELE_PROBE_MAX_FIRMWARE; f++) {
+            if (strcmp(p->firmware[f].name, firmware_files[i]) == 0) {
+                printf("Found firmware: %s\n", firmware_files[i]);
+                found_firmware = 1;
+            }
         }
     }
     
     if (!found_firmware) {
-        printf("No ELE firmware files found in %s\n", ELE_FIRMWARE_PATH);
+        printf("No ELE firmware files found in %s\n", p->firmware_path);
         return TEST_FAIL;
     }
     
@@ -185,27 +334,51 @@ static test_result_t test_ele_firmware_presence(void) {
 }
 
 static test_result_t test_ele_sysfs_interface(void) {
-    if (!file_exists(ELE_SYSFS_PATH)) {
-        printf("ELE sysfs interface not found at %s\n", ELE_SYSFS_PATH);
+    const struct ele_probe *p = platform();
+    
+    if (!(p->present & ELE_PROBE_HAVE_SYSFS)) {
+        printf("ELE sysfs interface not found at %s\n", p->sysfs_path);
         return TEST_FAIL;
     }
     
-    printf("ELE sysfs interface present at %s\n", ELE_SYSFS_PATH);
+    printf("ELE sysfs interface present at %s\n", p->sysfs_path);
     return TEST_PASS;
 }
 
 static test_result_t test_ele_basic_communication(void) {
-    int fd = open(ELE_DEVICE_PATH, O_RDWR);
+    uint32_t cmd = ((uint32_t)ELE_MSG_TAG_CMD << 24) | ((uint32_t)ELE_CMD_PING << 16) |
+                   (1u << 8) | ELE_BASE_API_VER;
+    uint32_t rsp[16];
+    ssize_t n;
+    
+    int fd = ele_open_device();
     if (fd < 0) {
         printf("Failed to open ELE device: %s\n", strerror(errno));
         return TEST_FAIL;
     }
     
-    /* Basic device communication test would go here */
-    /* This is a placeholder for actual ELE API calls */
-    printf("Basic device communication successful\n");
+    /* ELE ping: header-only command, response carries the status word */
+    if (write(fd, &cmd, sizeof(cmd)) != (ssize_t)sizeof(cmd)) {
+        printf("ELE ping write failed: %s\n", strerror(errno));
+        close(fd);
+        return TEST_FAIL;
+    }
     
+    n = read(fd, rsp, sizeof(rsp));
     close(fd);
+    
+    if (n < (ssize_t)(2 * sizeof(uint32_t)) || (rsp[0] >> 24) != ELE_MSG_TAG_RSP ||
+        ((rsp[0] >> 16) & 0xFF) != ELE_CMD_PING) {
+        printf("ELE ping: no valid response (%zd bytes)\n", n);
+        return TEST_FAIL;
+    }
+    
+    if ((rsp[1] & 0xFF) != ELE_RSP_SUCCESS) {
+        printf("ELE ping failed: status 0x%08x\n", rsp[1]);
+        return TEST_FAIL;
+    }
+    
+    printf("Basic device communication successful (ELE ping)\n");
     return TEST_PASS;
 }
 
@@ -221,16 +394,475 @@ static test_result_t test_ele_key_management(void) {
     return TEST_SKIP;
 }
 
+/*
+ * Known-answer tests of the enclave's own crypto services: one-shot SHA-2
+ * of the FIPS 180-2 "abc" message and ECDSA P-256 verification of a fixed
+ * signature, which must also be rejected once the digest is altered. Each
+ * command is timed; which of ELE, the CPU instructions or OpenSSL serves a
+ * given size in production is decided by "ele-crypto calibrate".
+ */
+#define CRYPTO_TIMING_RUNS 9
+
+static const uint8_t kat_sha256_abc[32] = {
+    0xba, 0x78, 0x16, 0xbf, 0x8f, 0x01, 0xcf, 0xea,
+    0x41, 0x41, 0x40, 0xde, 0x5d, 0xae, 0x22, 0x23,
+    0xb0, 0x03, 0x61, 0xa3, 0x96, 0x17, 0x7a, 0x9c,
+    0xb4, 0x10, 0xff, 0x61, 0xf2, 0x00, 0x15, 0xad,
+};
+
+static const uint8_t kat_sha384_abc[48] = {
+    0xcb, 0x00, 0x75, 0x3f, 0x45, 0xa3, 0x5e, 0x8b,
+    0xb5, 0xa0, 0x3d, 0x69, 0x9a, 0xc6, 0x50, 0x07,
+    0x27, 0x2c, 0x32, 0xab, 0x0e, 0xde, 0xd1, 0x63,
+    0x1a, 0x8b, 0x60, 0x5a, 0x43, 0xff, 0x5b, 0xed,
+    0x80, 0x86, 0x07, 0x2b, 0xa1, 0xe7, 0xcc, 0x23,
+    0x58, 0xba, 0xec, 0xa1, 0x34, 0xc8, 0x25, 0xa7,
+};
+
+static const uint8_t kat_sha512_abc[64] = {
+    0xdd, 0xaf, 0x35, 0xa1, 0x93, 0x61, 0x7a, 0xba,
+    0xcc, 0x41, 0x73, 0x49, 0xae, 0x20, 0x41, 0x31,
+    0x12, 0xe6, 0xfa, 0x4e, 0x89, 0xa9, 0x7e, 0xa2,
+    0x0a, 0x9e, 0xee, 0xe6, 0x4b, 0x55, 0xd3, 0x9a,
+    0x21, 0x92, 0x99, 0x2a, 0x27, 0x4f, 0xc1, 0xa8,
+    0x36, 0xba, 0x3c, 0x23, 0xa3, 0xfe, 0xeb, 0xbd,
+    0x45, 0x4d, 0x44, 0x23, 0x64, 0x3c, 0xe8, 0x0e,
+    0x2a, 0x9a, 0xc9, 0x4f, 0xa5, 0x4c, 0xa4, 0x9f,
+};
+
+/* P-256 public key (X || Y) and its signature (r || s) over SHA-256("abc") */
+static const uint8_t kat_p256_pub[64] = {
+    0x05, 0x6a, 0x33, 0x11, 0xa7, 0x32, 0x80, 0x6a,
+    0x4e, 0x44, 0x29, 0x91, 0xa4, 0x09, 0x8e, 0x0b,
+    0x7d, 0x56, 0xe9, 0x09, 0x6a, 0x17, 0x7e, 0xb4,
+    0xdb, 0xe8, 0xe9, 0xc5, 0xc3, 0xf5, 0xf4, 0x78,
+    0xab, 0xbb, 0x0c, 0xd3, 0xbe, 0x86, 0xdc, 0x57,
+    0xcd, 0xf1, 0x2d, 0x13, 0x90, 0x07, 0xdb, 0xb7,
+    0x0f, 0x26, 0x9d, 0xca, 0x30, 0x88, 0x8b, 0x2e,
+    0xc3, 0xcf, 0xcd, 0xdb, 0xfc, 0xaa, 0x34, 0xd9,
+};
+
+static const uint8_t kat_p256_sig[64] = {
+    0x73, 0x94, 0x11, 0xcf, 0x97, 0xbb, 0x1c, 0xdf,
+    0x57, 0xce, 0xaf, 0x28, 0x31, 0xe7, 0x1a, 0x40,
+    0x82, 0x88, 0x71, 0xd3, 0x42, 0x90, 0xd7, 0x40,
+    0xac, 0xc0, 0x32, 0x38, 0x69, 0x87, 0x04, 0x27,
+    0x7a, 0x61, 0x61, 0xf1, 0xfa, 0xb7, 0x38, 0xe6,
+    0x39, 0x7c, 0x87, 0x9d, 0x8c, 0xb9, 0x6e, 0x63,
+    0x1a, 0xbc, 0x1c, 0x72, 0x09, 0x8c, 0x4b, 0x3c,
+    0xff, 0x21, 0x3a, 0xd9, 0x19, 0x44, 0xb4, 0xae,
+};
+
+/* Run one command CRYPTO_TIMING_RUNS times; median latency in *median_us */
+static int crypto_timed_exchange(int fd, const uint32_t *cmd, size_t words, uint32_t *rsp,
+                                 double *median_us) {
+    uint64_t samples[CRYPTO_TIMING_RUNS];
+    
+    for (int i = 0; i < CRYPTO_TIMING_RUNS; i++) {
+        uint64_t t0 = now_ns();
+        if (ele_exchange(fd, cmd, words, rsp) != 0) {
+            return -1;
+        }
+        samples[i] = now_ns() - t0;
+    }
+    
+    qsort(samples, CRYPTO_TIMING_RUNS, sizeof(samples[0]), compare_u64);
+    *median_us = samples[CRYPTO_TIMING_RUNS / 2] / 1000.0;
+    return 0;
+}
+
+/* ECDSA verification request: scheme, lengths, key, signature, digest */
+static size_t crypto_build_verify(uint32_t *msg, const uint8_t *digest) {
+    size_t words = 5 + 16 + 16 + 8;
+    
+    memset(msg, 0, words * sizeof(uint32_t));
+    msg[0] = ele_header(ELE_HSM_API_VER, ELE_CMD_SIGN_VERIFY, words);
+    msg[1] = ELE_SIG_SCHEME_ECDSA;
+    msg[2] = sizeof(kat_p256_pub);
+    msg[3] = sizeof(kat_p256_sig);
+    msg[4] = 32;
+    memcpy(&msg[5], kat_p256_pub, sizeof(kat_p256_pub));
+    memcpy(&msg[21], kat_p256_sig, sizeof(kat_p256_sig));
+    memcpy(&msg[37], digest, 32);
+    return words;
+}
+
 static test_result_t test_ele_crypto_services(void) {
-    /* Test encryption, decryption, signing, verification */
-    printf("Cryptographic services - implementation needed\n");
-    return TEST_SKIP;
+    static const struct {
+        const char *name;
+        uint32_t algo;
+        const uint8_t *expected;
+        size_t len;
+    } kats[] = {
+        { "SHA-256", ELE_HASH_ALGO_SHA256, kat_sha256_abc, sizeof(kat_sha256_abc) },
+        { "SHA-384", ELE_HASH_ALGO_SHA384, kat_sha384_abc, sizeof(kat_sha384_abc) },
+        { "SHA-512", ELE_HASH_ALGO_SHA512, kat_sha512_abc, sizeof(kat_sha512_abc) },
+    };
+    uint32_t cmd[ELE_MSG_MAX_WORDS];
+    uint32_t rsp[ELE_MSG_MAX_WORDS];
+    uint8_t digest[32];
+    test_result_t result = TEST_PASS;
+    double us;
+    size_t words;
+    
+    int fd = ele_open_device();
+    if (fd < 0) {
+        printf("Failed to open ELE device: %s\n", strerror(errno));
+        return TEST_FAIL;
+    }
+    
+    for (size_t i = 0; i < sizeof(kats) / sizeof(kats[0]); i++) {
+        cmd[0] = ele_header(ELE_HSM_API_VER, ELE_CMD_HASH_ONE_GO, 4);
+        cmd[1] = kats[i].algo;
+        cmd[2] = 3;
+        cmd[3] = 0;
+        memcpy(&cmd[3], "abc", 3);
+        
+        if (crypto_timed_exchange(fd, cmd, 4, rsp, &us) != 0) {
+            printf("❌ %s: ELE hash command failed\n", kats[i].name);
+            result = TEST_FAIL;
+            continue;
+        }
+        if (rsp[2] != kats[i].len || memcmp(&rsp[3], kats[i].expected, kats[i].len) != 0) {
+            printf("❌ %s(\"abc\"): wrong digest from ELE\n", kats[i].name);
+            result = TEST_FAIL;
+            continue;
+        }
+        printf("✅ %s(\"abc\") matches FIPS 180-2 (%.1f us)\n", kats[i].name, us);
+    }
+    
+    memcpy(digest, kat_sha256_abc, sizeof(digest));
+    words = crypto_build_verify(cmd, digest);
+    if (crypto_timed_exchange(fd, cmd, words, rsp, &us) != 0) {
+        printf("❌ ECDSA P-256 verify: ELE command failed\n");
+        result = TEST_FAIL;
+    } else if (rsp[2] != ELE_VERIFY_SUCCESS) {
+        printf("❌ ECDSA P-256 verify: valid signature rejected (0x%08x)\n", rsp[2]);
+        result = TEST_FAIL;
+    } else {
+        printf("✅ ECDSA P-256 verify accepts the reference signature (%.1f us)\n", us);
+    }
+    
+    digest[0] ^= 0x01;
+    words = crypto_build_verify(cmd, digest);
+    if (ele_exchange(fd, cmd, words, rsp) != 0) {
+        printf("❌ ECDSA P-256 verify: ELE command failed\n");
+        result = TEST_FAIL;
+    } else if (rsp[2] == ELE_VERIFY_SUCCESS) {
+        printf("❌ ECDSA P-256 verify accepted a signature over a different digest\n");
+        result = TEST_FAIL;
+    } else {
+        printf("✅ ECDSA P-256 verify rejects an altered digest\n");
+    }
+    
+    close(fd);
+    
+    /* Caller-keyed AES-GCM has no ELE service; it runs on the CPU */
+    printf("ℹ️  AES-GCM is served by the CPU backends (see ele-crypto calibrate)\n");
+    return result;
+}
+
+/*
+ * Suspend/resume cycle. The board is suspended through systemd, so the
+ * eink-suspend/eink-resume services run as in the field, and woken by an
+ * RTC alarm. The kernel's PM debug output (pm_print_times and
+ * pm_debug_messages, enabled for the cycle) gives the device resume phase
+ * times and the ELE driver's own resume callbacks; after the thaw the test
+ * pings the enclave until it answers.
+ *
+ * The test suspends the whole board, so it is opt-in. The PM debug switches
+ * and the wake alarm are saved and restored by the parent, which still runs
+ * after a timeout has killed the test mid-cycle.
+ */
+#define PM_RTC_WAKEALARM "/sys/class/rtc/rtc0/wakealarm"
+#define PM_STATE "/sys/power/state"
+#define PM_PRINT_TIMES "/sys/power/pm_print_times"
+#define PM_DEBUG_MESSAGES "/sys/power/pm_debug_messages"
+#define PM_DEFAULT_SLEEP_SECONDS 5
+#define PM_READY_TIMEOUT_MS 5000
+#define PM_STEADY_PINGS 16
+
+/* Kernel device names of the ELE driver and its messaging unit */
+static const char *const pm_ele_devices[] = {
+    "se-fw", "se_fw", "secure-enclave", "ele_mu", "s4muap", "47520000.mailbox",
+};
+
+typedef struct {
+    double phase_ms[3];            /* noirq, early, resume */
+    double ele_us;
+    int ele_callbacks;
+} pm_resume_log_t;
+
+static int write_sysfs(const char *path, const char *value) {
+    int fd = open(path, O_WRONLY);
+    ssize_t n;
+    
+    if (fd < 0) {
+        return -1;
+    }
+    n = write(fd, value, strlen(value));
+    close(fd);
+    return n == (ssize_t)strlen(value) ? 0 : -1;
+}
+
+static int read_sysfs(const char *path, char *buf, size_t size) {
+    int fd = open(path, O_RDONLY);
+    ssize_t n;
+    
+    if (fd < 0) {
+        return -1;
+    }
+    n = read(fd, buf, size - 1);
+    close(fd);
+    if (n < 0) {
+        return -1;
+    }
+    buf[n] = '\0';
+    buf[strcspn(buf, "\n")] = '\0';
+    return 0;
+}
+
+/* Time spent suspended: CLOCK_BOOTTIME keeps counting, CLOCK_MONOTONIC stops */
+static int64_t suspended_ns(void) {
+    struct timespec boot, mono;
+    
+    clock_gettime(CLOCK_BOOTTIME, &boot);
+    clock_gettime(CLOCK_MONOTONIC, &mono);
+    return (int64_t)(boot.tv_sec - mono.tv_sec) * 1000000000ll + (boot.tv_nsec - mono.tv_nsec);
+}
+
+static int ele_ping(int fd) {
+    uint32_t cmd = ele_header(ELE_BASE_API_VER, ELE_CMD_PING, 1);
+    uint32_t rsp[ELE_MSG_MAX_WORDS];
+    
+    return ele_exchange(fd, &cmd, 1, rsp);
+}
+
+/* Parse the kmsg records logged since the fd was positioned */
+static void parse_resume_log(int kmsg, pm_resume_log_t *log) {
+    static const char *const phases[3] = { "noirq resume of devices", "early resume of devices",
+                                           "PM: resume of devices" };
+    char rec[2048];
+    ssize_t n;
+    
+    memset(log, 0, sizeof(*log));
+    while ((n = read(kmsg, rec, sizeof(rec) - 1)) != 0) {
+        const char *msg, *after;
+        double value;
+        
+        if (n < 0) {
+            if (errno == EPIPE || errno == EINTR) {
+                continue;          /* overwritten records */
+            }
+            break;
+        }
+        rec[n] = '\0';
+        msg = strchr(rec, ';');
+        if (msg == NULL) {
+            continue;
+        }
+        msg++;
+        
+        /* "PM: early resume of devices complete after 1.234 msecs" */
+        for (int i = 0; i < 3; i++) {
+            if (strstr(msg, phases[i]) != NULL && (after = strstr(msg, " after ")) != NULL &&
+                sscanf(after, " after %lf", &value) == 1) {
+                log->phase_ms[i] = value;
+            }
+        }
+        
+        /* "<driver> <device>: <callback> returned 0 after 812 usecs" */
+        after = strstr(msg, " returned ");
+        if (after != NULL && strstr(msg, "resume") != NULL) {
+            const char *colon = strchr(msg, ':');
+            int ours = 0;
+            
+            for (size_t i = 0; colon != NULL && colon < after &&
+                               i < sizeof(pm_ele_devices) / sizeof(pm_ele_devices[0]); i++) {
+                const char *hit = strstr(msg, pm_ele_devices[i]);
+                ours |= hit != NULL && hit < colon;
+            }
+            if (ours && (after = strstr(after, " after ")) != NULL &&
+                sscanf(after, " after %lf", &value) == 1) {
+                log->ele_us += value;
+                log->ele_callbacks++;
+            }
+        }
+    }
+}
+
+/* PM state as found before the test, restored once it is reaped */
+static char pm_saved_times[8], pm_saved_debug[8];
+static int pm_saved;
+
+static void pm_save_state(void) {
+    pm_saved = read_sysfs(PM_PRINT_TIMES, pm_saved_times, sizeof(pm_saved_times)) == 0 &&
+               read_sysfs(PM_DEBUG_MESSAGES, pm_saved_debug, sizeof(pm_saved_debug)) == 0;
+}
+
+static void pm_restore_state(void) {
+    if (!pm_saved) {
+        return;
+    }
+    write_sysfs(PM_RTC_WAKEALARM, "0");
+    write_sysfs(PM_PRINT_TIMES, pm_saved_times);
+    write_sysfs(PM_DEBUG_MESSAGES, pm_saved_debug);
+    pm_saved = 0;
 }
 
 static test_result_t test_ele_power_management(void) {
-    /* Test ELE behavior during power state transitions */
-    printf("Power management integration - implementation needed\n");
-    return TEST_SKIP;
+    char buf[256];
+    const char *sleep_env = getenv("ELE_PM_SUSPEND_SECONDS");
+    int sleep_s = sleep_env != NULL ? atoi(sleep_env) : PM_DEFAULT_SLEEP_SECONDS;
+    uint64_t steady_ns = UINT64_MAX, thaw_ns, ready_ns = 0, t0;
+    int64_t before, slept;
+    pm_resume_log_t log;
+    struct stat st;
+    pid_t child;
+    int fd, kmsg, status = 0, systemd;
+    double kernel_ms, ready_ms, reinit_ms, total_ms;
+    test_result_t result = TEST_PASS;
+    
+    /* Suspending the board is only meaningful against the real enclave */
+    if (stat(ele_device_path, &st) != 0 || S_ISSOCK(st.st_mode)) {
+        printf("ELE device is not a hardware node, suspend cycle skipped\n");
+        return TEST_SKIP;
+    }
+    if (geteuid() != 0) {
+        printf("Suspend cycle needs root\n");
+        return TEST_SKIP;
+    }
+    if (read_sysfs(PM_STATE, buf, sizeof(buf)) != 0 || strstr(buf, "mem") == NULL ||
+        !file_exists(PM_RTC_WAKEALARM)) {
+        printf("Suspend to RAM or RTC wake alarm not available\n");
+        return TEST_SKIP;
+    }
+    if (sleep_s < 1) {
+        sleep_s = PM_DEFAULT_SLEEP_SECONDS;
+    }
+    
+    fd = ele_open_device();
+    if (fd < 0) {
+        printf("Failed to open ELE device: %s\n", strerror(errno));
+        return TEST_FAIL;
+    }
+    
+    /* Steady-state round trip, to separate re-initialization from mailbox time */
+    for (int i = 0; i < PM_STEADY_PINGS; i++) {
+        t0 = now_ns();
+        if (ele_ping(fd) != 0) {
+            printf("ELE ping failed before suspend\n");
+            close(fd);
+            return TEST_FAIL;
+        }
+        if (now_ns() - t0 < steady_ns) {
+            steady_ns = now_ns() - t0;
+        }
+    }
+    
+    kmsg = open("/dev/kmsg", O_RDONLY | O_NONBLOCK);
+    if (kmsg >= 0) {
+        lseek(kmsg, 0, SEEK_END);
+    }
+    write_sysfs(PM_PRINT_TIMES, "1");
+    write_sysfs(PM_DEBUG_MESSAGES, "1");
+    
+    snprintf(buf, sizeof(buf), "+%d", sleep_s);
+    if (write_sysfs(PM_RTC_WAKEALARM, "0") != 0 || write_sysfs(PM_RTC_WAKEALARM, buf) != 0) {
+        printf("Cannot arm RTC wake alarm: %s\n", strerror(errno));
+        result = TEST_FAIL;
+        goto out;
+    }
+    
+    /* Suspend from a child: the parent stays runnable and notices the thaw */
+    systemd = file_exists("/run/systemd/system");
+    printf("Suspending for %d s via %s\n", sleep_s, systemd ? "systemctl suspend" : PM_STATE);
+    fflush(stdout);
+    before = suspended_ns();
+    child = fork();
+    if (child == 0) {
+        if (systemd) {
+            execlp("systemctl", "systemctl", "suspend", (char *)NULL);
+            _exit(127);
+        }
+        _exit(write_sysfs(PM_STATE, "mem") == 0 ? 0 : 1);
+    }
+    if (child < 0) {
+        printf("fork failed: %s\n", strerror(errno));
+        result = TEST_FAIL;
+        goto out;
+    }
+    
+    t0 = now_ns();
+    while (suspended_ns() - before < 500000000ll) {
+        struct timespec tick = { 0, 1000000 };
+        
+        if (now_ns() - t0 > (uint64_t)(sleep_s + 30) * 1000000000ull) {
+            break;
+        }
+        nanosleep(&tick, NULL);
+    }
+    thaw_ns = now_ns();
+    slept = suspended_ns() - before;
+    if (slept < 500000000ll) {
+        waitpid(child, &status, 0);
+        printf("System did not suspend (suspend command exit status %d)\n",
+               WIFEXITED(status) ? WEXITSTATUS(status) : -1);
+        result = TEST_FAIL;
+        goto out;
+    }
+    
+    /* Enclave ready: the first ping that round-trips after the thaw */
+    while (now_ns() - thaw_ns < PM_READY_TIMEOUT_MS * 1000000ull) {
+        if (ele_ping(fd) == 0) {
+            ready_ns = now_ns();
+            break;
+        }
+        struct timespec retry = { 0, 1000000 };
+        
+        close(fd);
+        nanosleep(&retry, NULL);
+        fd = ele_open_device();
+    }
+    waitpid(child, &status, 0);
+    
+    if (ready_ns == 0) {
+        printf("ELE did not answer within %d ms of resume\n", PM_READY_TIMEOUT_MS);
+        result = TEST_FAIL;
+        goto out;
+    }
+    
+    if (kmsg >= 0) {
+        parse_resume_log(kmsg, &log);
+    } else {
+        memset(&log, 0, sizeof(log));
+    }
+    
+    kernel_ms = log.phase_ms[0] + log.phase_ms[1] + log.phase_ms[2];
+    ready_ms = (ready_ns - thaw_ns) / 1e6;
+    reinit_ms = log.ele_us / 1e3 + (ready_ms - steady_ns / 1e6 > 0 ? ready_ms - steady_ns / 1e6 : 0);
+    total_ms = kernel_ms + ready_ms;
+    
+    printf("Slept %.3f s (RTC wake)\n", slept / 1e9);
+    printf("Kernel device resume: %.3f ms (noirq %.3f, early %.3f, resume %.3f)\n",
+           kernel_ms, log.phase_ms[0], log.phase_ms[1], log.phase_ms[2]);
+    printf("ELE driver resume callbacks: %.3f ms (%d)\n", log.ele_us / 1e3, log.ele_callbacks);
+    printf("Thaw to first ELE response: %.3f ms (steady-state ping %.3f ms)\n",
+           ready_ms, steady_ns / 1e6);
+    printf("Resume to ELE ready: %.3f ms, enclave re-init %.3f ms (%.0f%%), everything else %.3f ms\n",
+           total_ms, reinit_ms, total_ms > 0 ? reinit_ms * 100.0 / total_ms : 0.0, total_ms - reinit_ms);
+    if (kmsg < 0 || kernel_ms == 0) {
+        printf("Kernel resume phases unavailable (no /dev/kmsg or CONFIG_PM_DEBUG)\n");
+    }
+    
+out:
+    if (kmsg >= 0) {
+        close(kmsg);
+    }
+    if (fd >= 0) {
+        close(fd);
+    }
+    return result;
 }
 
 static test_result_t test_ele_lifecycle_state(void) {
@@ -247,16 +879,21 @@ static test_result_t test_ele_otp_operations(void) {
 
 /* Main Test Runner */
 static void run_all_tests(void) {
-    int passed = 0, failed = 0, skipped = 0;
+    int passed = 0, failed = 0, skipped = 0, total = 0;
     
     printf("🔐 EdgeLock Enclave (ELE) Test Suite for i.MX93 Jaguar E-Ink\n");
     printf("================================================================\n");
     
     for (size_t i = 0; i < NUM_TESTS; i++) {
+        if (!test_selected_by_default(&ele_tests[i])) {
+            printf("\n=== %s ===\nNot run: opt-in (name it or set ELE_TEST_OPT_IN=1)\n", ele_tests[i].name);
+            continue;
+        }
         print_test_header(ele_tests[i].name, ele_tests[i].description);
         
-        test_result_t result = ele_tests[i].test_func();
+        test_result_t result = run_test_with_state(&ele_tests[i]);
         print_test_result(result);
+        total++;
         
         switch (result) {
             case TEST_PASS: passed++; break;
@@ -270,7 +907,7 @@ static void run_all_tests(void) {
     printf("  ✅ PASSED: %d\n", passed);
     printf("  ❌ FAILED: %d\n", failed);
     printf("  ⏭️  SKIPPED: %d\n", skipped);
-    printf("  📊 TOTAL: %zu\n", NUM_TESTS);
+    printf("  📊 TOTAL: %d\n", total);
     
     if (failed > 0) {
         printf("\n⚠️  Some tests failed. Check ELE configuration and drivers.\n");
@@ -285,7 +922,7 @@ static void run_single_test(const char *test_name) {
     for (size_t i = 0; i < NUM_TESTS; i++) {
         if (strcmp(ele_tests[i].name, test_name) == 0) {
             print_test_header(ele_tests[i].name, ele_tests[i].description);
-            test_result_t result = ele_tests[i].test_func();
+            test_result_t result = run_test_with_state(&ele_tests[i]);
             print_test_result(result);
             exit(result == TEST_PASS ? EXIT_SUCCESS : EXIT_FAILURE);
         }
@@ -298,13 +935,923 @@ static void run_single_test(const char *test_name) {
     exit(EXIT_FAILURE);
 }
 
+/* Parallel Runner */
+
+/* State of one forked test */
+typedef struct {
+    const ele_test_t *test;
+    pid_t pid;
+    int out_fd;
+    char *output;
+    size_t output_len;
+    struct timespec start;
+    double wall_ms;
+    double cpu_ms;
+    const char *status;    /* pass, fail, skip, timeout, crash */
+    int exit_signal;
+    int timed_out;
+    int finished;
+    int reported;
+} test_run_t;
+
+static double elapsed_ms(const struct timespec *from, const struct timespec *to) {
+    return (to->tv_sec - from->tv_sec) * 1e3 + (to->tv_nsec - from->tv_nsec) / 1e6;
+}
+
+static test_result_t run_test_in_child(const ele_test_t *test) {
+    printf("=== %s ===\n", test->name);
+    printf("Description: %s\n", test->description);
+    return test->test_func();
+}
+
+static int start_test(test_run_t *run) {
+    int pipefd[2];
+    
+    if (pipe(pipefd) != 0) {
+        return -1;
+    }
+    
+    if (run->test->save_state != NULL) {
+        run->test->save_state();
+    }
+    fflush(stdout);
+    fflush(stderr);
+    clock_gettime(CLOCK_MONOTONIC, &run->start);
+    
+    run->pid = fork();
+    if (run->pid < 0) {
+        close(pipefd[0]);
+        close(pipefd[1]);
+        if (run->test->restore_state != NULL) {
+            run->test->restore_state();
+        }
+        return -1;
+    }
+    
+    if (run->pid == 0) {
+        /* Own process group, so a timeout also kills anything the test spawned */
+        setpgid(0, 0);
+        close(pipefd[0]);
+        dup2(pipefd[1], STDOUT_FILENO);
+        dup2(pipefd[1], STDERR_FILENO);
+        close(pipefd[1]);
+        setvbuf(stdout, NULL, _IOLBF, 0);
+        test_result_t result = run_test_in_child(run->test);
+        fflush(stdout);
+        _exit(result);
+    }
+    
+    setpgid(run->pid, run->pid);
+    close(pipefd[1]);
+    fcntl(pipefd[0], F_SETFL, fcntl(pipefd[0], F_GETFL) | O_NONBLOCK);
+    run->out_fd = pipefd[0];
+    return 0;
+}
+
+/* Append whatever the test has written so far; returns 1 at end of output */
+static int drain_output(test_run_t *run) {
+    char buf[4096];
+    
+    for (;;) {
+        ssize_t n = read(run->out_fd, buf, sizeof(buf));
+        
+        if (n > 0) {
+            size_t keep = (size_t)n;
+            
+            if (run->output_len + keep > MAX_TEST_OUTPUT) {
+                keep = MAX_TEST_OUTPUT - run->output_len;
+            }
+            if (keep > 0) {
+                char *grown = realloc(run->output, run->output_len + keep + 1);
+                if (grown != NULL) {
+                    run->output = grown;
+                    memcpy(run->output + run->output_len, buf, keep);
+                    run->output_len += keep;
+                    run->output[run->output_len] = '\0';
+                }
+            }
+            continue;
+        }
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        return n == 0;
+    }
+}
+
+static void finish_test(test_run_t *run, int wstatus, const struct rusage *ru) {
+    struct timespec now;
+    
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    if (run->out_fd >= 0) {
+        drain_output(run);
+        close(run->out_fd);
+        run->out_fd = -1;
+    }
+    
+    /* The test and everything it spawned are gone: undo what it changed */
+    if (run->test->restore_state != NULL) {
+        run->test->restore_state();
+    }
+    
+    run->wall_ms = elapsed_ms(&run->start, &now);
+    run->cpu_ms = (ru->ru_utime.tv_sec + ru->ru_stime.tv_sec) * 1e3 +
+                  (ru->ru_utime.tv_usec + ru->ru_stime.tv_usec) / 1e3;
+    
+    if (run->timed_out) {
+        run->status = "timeout";
+    } else if (WIFSIGNALED(wstatus)) {
+        run->status = "crash";
+        run->exit_signal = WTERMSIG(wstatus);
+    } else if (WEXITSTATUS(wstatus) == TEST_PASS) {
+        run->status = "pass";
+    } else if (WEXITSTATUS(wstatus) == TEST_SKIP) {
+        run->status = "skip";
+    } else {
+        run->status = "fail";
+    }
+    run->finished = 1;
+}
+
+static void print_run_result(const test_run_t *run) {
+    const char *mark = strcmp(run->status, "pass") == 0 ? "✅" :
+                       strcmp(run->status, "skip") == 0 ? "⏭️" :
+                       strcmp(run->status, "timeout") == 0 ? "⏱️" : "❌";
+    
+    printf("  %s %-7s %-22s %9.1f ms wall %9.1f ms cpu\n",
+           mark, run->status, run->test->name, run->wall_ms, run->cpu_ms);
+    
+    /* Show the output of anything that did not pass or skip */
+    if (strcmp(run->status, "pass") != 0 && strcmp(run->status, "skip") != 0) {
+        if (run->exit_signal) {
+            printf("      killed by signal %d (%s)\n", run->exit_signal, strsignal(run->exit_signal));
+        }
+        if (run->output != NULL) {
+            const char *line = run->output;
+            while (*line) {
+                const char *end = strchr(line, '\n');
+                int len = end ? (int)(end - line) : (int)strlen(line);
+                printf("      | %.*s\n", len, line);
+                line += len + (end != NULL);
+            }
+        }
+    }
+    fflush(stdout);
+}
+
+static void write_escaped(FILE *f, const char *s, int xml) {
+    for (; s != NULL && *s; s++) {
+        unsigned char c = (unsigned char)*s;
+        
+        if (xml) {
+            switch (c) {
+                case '<': fputs("&lt;", f); break;
+                case '>': fputs("&gt;", f); break;
+                case '&': fputs("&amp;", f); break;
+                case '"': fputs("&quot;", f); break;
+                default:
+                    if (c < 0x20 && c != '\n' && c != '\t') {
+                        fputc('?', f);
+                    } else {
+                        fputc(c, f);
+                    }
+            }
+        } else {
+            switch (c) {
+                case '"': fputs("\\\"", f); break;
+                case '\\': fputs("\\\\", f); break;
+                case '\n': fputs("\\n", f); break;
+                case '\t': fputs("\\t", f); break;
+                default:
+                    if (c < 0x20) {
+                        fprintf(f, "\\u%04x", c);
+                    } else {
+                        fputc(c, f);
+                    }
+            }
+        }
+    }
+}
+
+static int write_json_report(const char *path, const test_run_t *runs, size_t count,
+                             int jobs, double wall_ms, const int totals[4]) {
+    FILE *f = fopen(path, "w");
+    
+    if (f == NULL) {
+        fprintf(stderr, "Cannot write %s: %s\n", path, strerror(errno));
+        return -1;
+    }
+    
+    fprintf(f, "{\n  \"suite\": \"enhanced-ele-test\",\n  \"jobs\": %d,\n  \"wall_ms\": %.1f,\n", jobs, wall_ms);
+    fprintf(f, "  \"passed\": %d,\n  \"failed\": %d,\n  \"skipped\": %d,\n  \"timed_out\": %d,\n",
+            totals[0], totals[1], totals[2], totals[3]);
+    fprintf(f, "  \"tests\": [\n");
+    for (size_t i = 0; i < count; i++) {
+        fprintf(f, "    {\"name\": \"%s\", \"result\": \"%s\", \"wall_ms\": %.1f, \"cpu_ms\": %.1f, \"output\": \"",
+                runs[i].test->name, runs[i].status, runs[i].wall_ms, runs[i].cpu_ms);
+        write_escaped(f, runs[i].output, 0);
+        fprintf(f, "\"}%s\n", i + 1 < count ? "," : "");
+    }
+    fprintf(f, "  ]\n}\n");
+    
+    return fclose(f) == 0 ? 0 : -1;
+}
+
+static int write_junit_report(const char *path, const test_run_t *runs, size_t count,
+                              double wall_ms, const int totals[4]) {
+    FILE *f = fopen(path, "w");
+    
+    if (f == NULL) {
+        fprintf(stderr, "Cannot write %s: %s\n", path, strerror(errno));
+        return -1;
+    }
+    
+    fprintf(f, "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n");
+    fprintf(f, "<testsuite name=\"enhanced-ele-test\" tests=\"%zu\" failures=\"%d\" errors=\"%d\" skipped=\"%d\" time=\"%.3f\">\n",
+            count, totals[1], totals[3], totals[2], wall_ms / 1e3);
+    for (size_t i = 0; i < count; i++) {
+        const test_run_t *run = &runs[i];
+        
+        fprintf(f, "  <testcase classname=\"ele\" name=\"%s\" time=\"%.3f\">\n",
+                run->test->name, run->wall_ms / 1e3);
+        if (strcmp(run->status, "fail") == 0 || strcmp(run->status, "crash") == 0) {
+            fprintf(f, "    <failure message=\"%s\"/>\n",
+                    run->exit_signal ? strsignal(run->exit_signal) : "test failed");
+        } else if (strcmp(run->status, "timeout") == 0) {
+            fprintf(f, "    <error message=\"timed out\"/>\n");
+        } else if (strcmp(run->status, "skip") == 0) {
+            fprintf(f, "    <skipped/>\n");
+        }
+        fprintf(f, "    <system-out>");
+        write_escaped(f, run->output, 1);
+        fprintf(f, "</system-out>\n  </testcase>\n");
+    }
+    fprintf(f, "</testsuite>\n");
+    
+    return fclose(f) == 0 ? 0 : -1;
+}
+
+static const ele_test_t *find_test(const char *name) {
+    for (size_t i = 0; i < NUM_TESTS; i++) {
+        if (strcmp(ele_tests[i].name, name) == 0) {
+            return &ele_tests[i];
+        }
+    }
+    return NULL;
+}
+
+/*
+ * Fork each selected test with its output captured, up to jobs at once.
+ * TEST_EXCLUSIVE tests run on their own once nothing else is running.
+ */
+static void run_parallel(int argc, char *argv[]) {
+    static const struct option long_opts[] = {
+        { "jobs", required_argument, NULL, 'j' },
+        { "timeout", required_argument, NULL, 't' },
+        { "json", required_argument, NULL, 'J' },
+        { "junit", required_argument, NULL, 'X' },
+        { NULL, 0, NULL, 0 }
+    };
+    test_run_t runs[NUM_TESTS];
+    size_t count = 0;
+    const char *json_path = NULL, *junit_path = NULL;
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    int jobs = cpus > 0 ? (int)cpus : 1;
+    int timeout_s = DEFAULT_TEST_TIMEOUT;
+    int totals[4] = { 0, 0, 0, 0 };    /* passed, failed, skipped, timed out */
+    struct timespec suite_start, suite_end;
+    int opt;
+    
+    optind = 1;
+    while ((opt = getopt_long(argc, argv, "j:t:", long_opts, NULL)) != -1) {
+        switch (opt) {
+            case 'j': jobs = atoi(optarg); break;
+            case 't': timeout_s = atoi(optarg); break;
+            case 'J': json_path = optarg; break;
+            case 'X': junit_path = optarg; break;
+            default: exit(EXIT_FAILURE);
+        }
+    }
+    if (jobs < 1) {
+        jobs = 1;
+    }
+    
+    memset(runs, 0, sizeof(runs));
+    if (optind >= argc) {
+        for (size_t i = 0; i < NUM_TESTS; i++) {
+            if (test_selected_by_default(&ele_tests[i])) {
+                runs[count++].test = &ele_tests[i];
+            }
+        }
+    } else {
+        for (int i = optind; i < argc && count < NUM_TESTS; i++) {
+            const ele_test_t *test = find_test(argv[i]);
+            if (test == NULL) {
+                fprintf(stderr, "Test '%s' not found (see --list)\n", argv[i]);
+                exit(EXIT_FAILURE);
+            }
+            runs[count++].test = test;
+        }
+    }
+    
+    if ((size_t)jobs > count) {
+        jobs = (int)count;
+    }
+    
+    printf("🔐 EdgeLock Enclave (ELE) Test Suite for i.MX93 Jaguar E-Ink\n");
+    printf("================================================================\n");
+    printf("Running %zu tests, %d in parallel, %d s timeout each\n\n", count, jobs, timeout_s);
+    
+    /* Probe before forking so every test shares one snapshot */
+    platform();
+    clock_gettime(CLOCK_MONOTONIC, &suite_start);
+    
+    for (;;) {
+        struct pollfd pfds[NUM_TESTS];
+        test_run_t *polled[NUM_TESTS];
+        int running = 0, exclusive_running = 0, npoll = 0;
+        struct timespec now;
+        int wait_ms = 1000;
+        
+        for (size_t i = 0; i < count; i++) {
+            if (runs[i].pid > 0 && !runs[i].finished) {
+                running++;
+                exclusive_running |= (runs[i].test->flags & TEST_EXCLUSIVE) != 0;
+            }
+        }
+        
+        /* Start whatever may start now, in table order */
+        for (size_t i = 0; i < count && running < jobs && !exclusive_running; i++) {
+            test_run_t *run = &runs[i];
+            
+            if (run->pid != 0 || ((run->test->flags & TEST_EXCLUSIVE) && running > 0)) {
+                continue;
+            }
+            if (start_test(run) != 0) {
+                run->pid = -1;
+                run->status = "fail";
+                run->finished = 1;
+                run->output = strdup("could not start test process\n");
+                continue;
+            }
+            running++;
+            exclusive_running |= (run->test->flags & TEST_EXCLUSIVE) != 0;
+        }
+        
+        if (running == 0) {
+            break;
+        }
+        
+        /* Wait for output, exits or the nearest deadline */
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        for (size_t i = 0; i < count; i++) {
+            test_run_t *run = &runs[i];
+            
+            if (run->pid <= 0 || run->finished) {
+                continue;
+            }
+            int left = (int)(timeout_s * 1000.0 - elapsed_ms(&run->start, &now));
+            if (left <= 0 && !run->timed_out) {
+                run->timed_out = 1;
+                kill(-run->pid, SIGKILL);
+            }
+            if (left < wait_ms) {
+                wait_ms = left > 0 ? left : 0;
+            }
+            if (run->out_fd >= 0) {
+                pfds[npoll].fd = run->out_fd;
+                pfds[npoll].events = POLLIN;
+                polled[npoll++] = run;
+            } else {
+                wait_ms = 1;    /* output closed: the exit is moments away */
+            }
+        }
+        
+        /* Exits are noticed through EOF on the pipe, but cap the wait anyway */
+        if (wait_ms > 100) {
+            wait_ms = 100;
+        }
+        if (poll(pfds, npoll, wait_ms) > 0) {
+            for (int i = 0; i < npoll; i++) {
+                if (pfds[i].revents && drain_output(polled[i])) {
+                    close(polled[i]->out_fd);
+                    polled[i]->out_fd = -1;    /* EOF: the test is exiting */
+                }
+            }
+        }
+        
+        for (size_t i = 0; i < count; i++) {
+            test_run_t *run = &runs[i];
+            struct rusage ru;
+            int wstatus;
+            
+            if (run->pid <= 0 || run->finished) {
+                continue;
+            }
+            if (wait4(run->pid, &wstatus, WNOHANG, &ru) == run->pid) {
+                finish_test(run, wstatus, &ru);
+            }
+        }
+        
+        /* Report tests in completion order */
+        for (size_t i = 0; i < count; i++) {
+            if (runs[i].finished && !runs[i].reported) {
+                print_run_result(&runs[i]);
+                runs[i].reported = 1;
+            }
+        }
+    }
+    
+    clock_gettime(CLOCK_MONOTONIC, &suite_end);
+    double wall_ms = elapsed_ms(&suite_start, &suite_end);
+    double serial_ms = 0;
+    
+    for (size_t i = 0; i < count; i++) {
+        if (!runs[i].reported) {
+            print_run_result(&runs[i]);
+        }
+        serial_ms += runs[i].wall_ms;
+        if (strcmp(runs[i].status, "pass") == 0) {
+            totals[0]++;
+        } else if (strcmp(runs[i].status, "skip") == 0) {
+            totals[2]++;
+        } else if (strcmp(runs[i].status, "timeout") == 0) {
+            totals[3]++;
+        } else {
+            totals[1]++;
+        }
+    }
+    
+    printf("\n================================================================\n");
+    printf("Test Summary:\n");
+    printf("  ✅ PASSED: %d\n", totals[0]);
+    printf("  ❌ FAILED: %d\n", totals[1]);
+    printf("  ⏱️  TIMED OUT: %d\n", totals[3]);
+    printf("  ⏭️  SKIPPED: %d\n", totals[2]);
+    printf("  📊 TOTAL: %zu in %.1f ms (%.1f ms if run serially)\n", count, wall_ms, serial_ms);
+    
+    if (json_path != NULL) {
+        write_json_report(json_path, runs, count, jobs, wall_ms, totals);
+    }
+    if (junit_path != NULL) {
+        write_junit_report(junit_path, runs, count, wall_ms, totals);
+    }
+    
+    for (size_t i = 0; i < count; i++) {
+        free(runs[i].output);
+    }
+    
+    exit(totals[1] + totals[3] > 0 ? EXIT_FAILURE : EXIT_SUCCESS);
+}
+
+/* Mailbox Stress */
+
+#define STRESS_DEFAULT_THREADS 4
+#define STRESS_DEFAULT_SECONDS 5
+#define STRESS_DEFAULT_TOLERANCE 25    /* percent allowed over the baseline */
+#define STRESS_RNG_BYTES 32
+#define STRESS_HASH_BYTES 64
+#define STRESS_MAX_OPS 3
+
+/* One mailbox command the stress mode can issue */
+typedef struct {
+    const char *name;
+    size_t (*build)(uint32_t *msg);
+} stress_op_t;
+
+static size_t stress_build_get_info(uint32_t *msg) {
+    msg[0] = ele_header(ELE_BASE_API_VER, ELE_CMD_GET_INFO, 1);
+    return 1;
+}
+
+static size_t stress_build_rng(uint32_t *msg) {
+    msg[0] = ele_header(ELE_HSM_API_VER, ELE_CMD_RNG_GET_RANDOM, 2);
+    msg[1] = STRESS_RNG_BYTES;
+    return 2;
+}
+
+static size_t stress_build_hash(uint32_t *msg) {
+    size_t words = 3 + STRESS_HASH_BYTES / 4;
+    
+    msg[0] = ele_header(ELE_HSM_API_VER, ELE_CMD_HASH_ONE_GO, words);
+    msg[1] = ELE_HASH_ALGO_SHA256;
+    msg[2] = STRESS_HASH_BYTES;
+    memset(&msg[3], 0xA5, STRESS_HASH_BYTES);
+    return words;
+}
+
+static const stress_op_t stress_ops[STRESS_MAX_OPS] = {
+    { "get_info", stress_build_get_info },
+    { "rng", stress_build_rng },
+    { "hash", stress_build_hash },
+};
+
+/* Per-thread latency samples of one operation, in nanoseconds */
+typedef struct {
+    uint64_t *ns;
+    size_t count;
+    size_t capacity;
+    unsigned long errors;
+} stress_samples_t;
+
+typedef struct {
+    pthread_t thread;
+    int index;
+    stress_samples_t samples[STRESS_MAX_OPS];
+    char error[128];
+} stress_worker_t;
+
+static struct {
+    unsigned int ops_mask;
+    long max_ops;                  /* 0: run for the duration */
+    long issued;
+    volatile int stop;
+    pthread_barrier_t barrier;
+} stress;
+
+static void stress_record(stress_samples_t *s, uint64_t ns) {
+    if (s->count == s->capacity) {
+        size_t capacity = s->capacity ? s->capacity * 2 : 4096;
+        uint64_t *grown = realloc(s->ns, capacity * sizeof(*grown));
+        if (grown == NULL) {
+            return;
+        }
+        s->ns = grown;
+        s->capacity = capacity;
+    }
+    s->ns[s->count++] = ns;
+}
+
+static void *stress_worker(void *arg) {
+    stress_worker_t *w = arg;
+    uint32_t cmd[STRESS_MAX_OPS][ELE_MSG_MAX_WORDS];
+    size_t words[STRESS_MAX_OPS];
+    uint32_t rsp[ELE_MSG_MAX_WORDS];
+    int fd = ele_open_device();
+    
+    if (fd < 0) {
+        snprintf(w->error, sizeof(w->error), "cannot open %s: %s", ele_device_path, strerror(errno));
+    }
+    for (int op = 0; op < STRESS_MAX_OPS; op++) {
+        words[op] = stress_ops[op].build(cmd[op]);
+    }
+    
+    pthread_barrier_wait(&stress.barrier);
+    if (fd < 0) {
+        return NULL;
+    }
+    
+    /* Threads start on different operations so every op sees contention */
+    for (int op = w->index % STRESS_MAX_OPS; !stress.stop; op = (op + 1) % STRESS_MAX_OPS) {
+        uint64_t t0;
+        int rv;
+        
+        if (!(stress.ops_mask & (1u << op))) {
+            continue;
+        }
+        if (stress.max_ops > 0 && __atomic_fetch_add(&stress.issued, 1, __ATOMIC_RELAXED) >= stress.max_ops) {
+            break;
+        }
+        
+        t0 = now_ns();
+        rv = ele_exchange(fd, cmd[op], words[op], rsp);
+        if (rv == 0) {
+            stress_record(&w->samples[op], now_ns() - t0);
+        } else {
+            w->samples[op].errors++;
+        }
+    }
+    
+    close(fd);
+    return NULL;
+}
+
+/* Merged, sorted results of one operation */
+typedef struct {
+    size_t count;
+    unsigned long errors;
+    double ops_per_sec;
+    double p50_us, p99_us, max_us;
+} stress_result_t;
+
+static double percentile_us(const uint64_t *sorted, size_t count, double pct) {
+    size_t idx;
+    
+    if (count == 0) {
+        return 0;
+    }
+    idx = (size_t)(pct / 100.0 * (double)(count - 1) + 0.5);
+    return sorted[idx] / 1e3;
+}
+
+/* Baseline file: one "op p50_us p99_us ops_per_sec" line per operation */
+static int load_baseline(const char *path, stress_result_t base[STRESS_MAX_OPS], int have[STRESS_MAX_OPS]) {
+    FILE *f = fopen(path, "r");
+    char line[256];
+    
+    if (f == NULL) {
+        fprintf(stderr, "Cannot read baseline %s: %s\n", path, strerror(errno));
+        return -1;
+    }
+    memset(have, 0, STRESS_MAX_OPS * sizeof(have[0]));
+    while (fgets(line, sizeof(line), f) != NULL) {
+        char name[32];
+        stress_result_t r;
+        
+        memset(&r, 0, sizeof(r));
+        if (line[0] == '#' || sscanf(line, "%31s %lf %lf %lf", name, &r.p50_us, &r.p99_us, &r.ops_per_sec) != 4) {
+            continue;
+        }
+        for (int op = 0; op < STRESS_MAX_OPS; op++) {
+            if (strcmp(name, stress_ops[op].name) == 0) {
+                base[op] = r;
+                have[op] = 1;
+            }
+        }
+    }
+    fclose(f);
+    return 0;
+}
+
+static int save_baseline(const char *path, const stress_result_t res[STRESS_MAX_OPS], int threads) {
+    FILE *f = fopen(path, "w");
+    
+    if (f == NULL) {
+        fprintf(stderr, "Cannot write baseline %s: %s\n", path, strerror(errno));
+        return -1;
+    }
+    fprintf(f, "# enhanced-ele-test stress baseline, %d threads\n", threads);
+    fprintf(f, "# op p50_us p99_us ops_per_sec\n");
+    for (int op = 0; op < STRESS_MAX_OPS; op++) {
+        if (stress.ops_mask & (1u << op)) {
+            fprintf(f, "%s %.1f %.1f %.1f\n", stress_ops[op].name,
+                    res[op].p50_us, res[op].p99_us, res[op].ops_per_sec);
+        }
+    }
+    return fclose(f) == 0 ? 0 : -1;
+}
+
+static void stress_usage(void) {
+    printf("Usage: enhanced-ele-test stress [options]\n");
+    printf("\nDrive ELE mailbox commands from several threads and report latency.\n");
+    printf("\nOptions:\n");
+    printf("  -t, --threads N        Threads, each with its own device context (default %d)\n", STRESS_DEFAULT_THREADS);
+    printf("  -d, --duration S       Run time in seconds (default %d)\n", STRESS_DEFAULT_SECONDS);
+    printf("  -n, --count N          Stop after N operations instead\n");
+    printf("  -o, --ops LIST         get_info,rng,hash (default all)\n");
+    printf("  --max-p50 US           Fail if any operation's p50 exceeds US\n");
+    printf("  --max-p99 US           Fail if any operation's p99 exceeds US\n");
+    printf("  --max-errors N         Errors tolerated (default 0)\n");
+    printf("  --baseline FILE        Fail on regression against a saved baseline\n");
+    printf("  --tolerance PCT        Allowed regression vs baseline (default %d%%)\n", STRESS_DEFAULT_TOLERANCE);
+    printf("  --save-baseline FILE   Save this run's results as a baseline\n");
+    printf("  --json FILE            Write a JSON report\n");
+}
+
+static void run_stress(int argc, char *argv[]) {
+    static const struct option long_opts[] = {
+        { "threads", required_argument, NULL, 't' },
+        { "duration", required_argument, NULL, 'd' },
+        { "count", required_argument, NULL, 'n' },
+        { "ops", required_argument, NULL, 'o' },
+        { "max-p50", required_argument, NULL, 'P' },
+        { "max-p99", required_argument, NULL, 'Q' },
+        { "max-errors", required_argument, NULL, 'E' },
+        { "baseline", required_argument, NULL, 'B' },
+        { "tolerance", required_argument, NULL, 'T' },
+        { "save-baseline", required_argument, NULL, 'S' },
+        { "json", required_argument, NULL, 'J' },
+        { "help", no_argument, NULL, 'h' },
+        { NULL, 0, NULL, 0 }
+    };
+    int threads = STRESS_DEFAULT_THREADS;
+    int duration = STRESS_DEFAULT_SECONDS;
+    double max_p50 = 0, max_p99 = 0, tolerance = STRESS_DEFAULT_TOLERANCE;
+    unsigned long max_errors = 0, errors = 0;
+    const char *baseline_path = NULL, *save_path = NULL, *json_path = NULL;
+    stress_result_t res[STRESS_MAX_OPS], base[STRESS_MAX_OPS];
+    int have_base[STRESS_MAX_OPS];
+    stress_worker_t *workers;
+    uint64_t start, elapsed;
+    int failures = 0;
+    int opt;
+    
+    memset(&stress, 0, sizeof(stress));
+    stress.ops_mask = (1u << STRESS_MAX_OPS) - 1;
+    
+    optind = 1;
+    while ((opt = getopt_long(argc, argv, "t:d:n:o:h", long_opts, NULL)) != -1) {
+        switch (opt) {
+            case 't': threads = atoi(optarg); break;
+            case 'd': duration = atoi(optarg); break;
+            case 'n': stress.max_ops = atol(optarg); break;
+            case 'P': max_p50 = atof(optarg); break;
+            case 'Q': max_p99 = atof(optarg); break;
+            case 'E': max_errors = strtoul(optarg, NULL, 10); break;
+            case 'B': baseline_path = optarg; break;
+            case 'T': tolerance = atof(optarg); break;
+            case 'S': save_path = optarg; break;
+            case 'J': json_path = optarg; break;
+            case 'o': {
+                char list[128], *save = NULL;
+                
+                stress.ops_mask = 0;
+                snprintf(list, sizeof(list), "%s", optarg);
+                for (char *tok = strtok_r(list, ",", &save); tok; tok = strtok_r(NULL, ",", &save)) {
+                    int op;
+                    for (op = 0; op < STRESS_MAX_OPS && strcmp(tok, stress_ops[op].name) != 0; op++) {
+                    }
+                    if (op == STRESS_MAX_OPS) {
+                        fprintf(stderr, "Unknown operation '%s'\n", tok);
+                        exit(EXIT_FAILURE);
+                    }
+                    stress.ops_mask |= 1u << op;
+                }
+                break;
+            }
+            case 'h': stress_usage(); exit(EXIT_SUCCESS);
+            default: stress_usage(); exit(EXIT_FAILURE);
+        }
+    }
+    if (threads < 1 || (duration < 1 && stress.max_ops <= 0) || stress.ops_mask == 0) {
+        stress_usage();
+        exit(EXIT_FAILURE);
+    }
+    if (baseline_path != NULL && load_baseline(baseline_path, base, have_base) != 0) {
+        exit(EXIT_FAILURE);
+    }
+    
+    printf("🔐 ELE Mailbox Stress Test\n");
+    printf("================================================================\n");
+    printf("Device: %s, %d threads, ", ele_device_path, threads);
+    if (stress.max_ops > 0) {
+        printf("%ld operations\n\n", stress.max_ops);
+    } else {
+        printf("%d s\n\n", duration);
+    }
+    
+    workers = calloc((size_t)threads, sizeof(*workers));
+    if (workers == NULL) {
+        exit(EXIT_FAILURE);
+    }
+    pthread_barrier_init(&stress.barrier, NULL, (unsigned int)threads + 1);
+    for (int i = 0; i < threads; i++) {
+        workers[i].index = i;
+        if (pthread_create(&workers[i].thread, NULL, stress_worker, &workers[i]) != 0) {
+            fprintf(stderr, "Cannot start thread %d\n", i);
+            exit(EXIT_FAILURE);
+        }
+    }
+    
+    pthread_barrier_wait(&stress.barrier);
+    start = now_ns();
+    if (stress.max_ops <= 0) {
+        sleep((unsigned int)duration);
+        stress.stop = 1;
+    }
+    for (int i = 0; i < threads; i++) {
+        pthread_join(workers[i].thread, NULL);
+        if (workers[i].error[0] != '\0') {
+            printf("❌ Thread %d: %s\n", i, workers[i].error);
+            failures++;
+        }
+    }
+    elapsed = now_ns() - start;
+    pthread_barrier_destroy(&stress.barrier);
+    
+    printf("%-10s %10s %8s %12s %10s %10s %10s\n", "op", "ops", "errors", "ops/sec", "p50 us", "p99 us", "max us");
+    for (int op = 0; op < STRESS_MAX_OPS; op++) {
+        uint64_t *all;
+        size_t n = 0;
+        
+        memset(&res[op], 0, sizeof(res[op]));
+        if (!(stress.ops_mask & (1u << op))) {
+            continue;
+        }
+        for (int i = 0; i < threads; i++) {
+            n += workers[i].samples[op].count;
+            res[op].errors += workers[i].samples[op].errors;
+        }
+        all = malloc((n ? n : 1) * sizeof(*all));
+        if (all == NULL) {
+            exit(EXIT_FAILURE);
+        }
+        n = 0;
+        for (int i = 0; i < threads; i++) {
+            memcpy(all + n, workers[i].samples[op].ns, workers[i].samples[op].count * sizeof(*all));
+            n += workers[i].samples[op].count;
+            free(workers[i].samples[op].ns);
+        }
+        qsort(all, n, sizeof(*all), compare_u64);
+        
+        res[op].count = n;
+        res[op].ops_per_sec = n / (elapsed / 1e9);
+        res[op].p50_us = percentile_us(all, n, 50);
+        res[op].p99_us = percentile_us(all, n, 99);
+        res[op].max_us = n ? all[n - 1] / 1e3 : 0;
+        errors += res[op].errors;
+        free(all);
+        
+        printf("%-10s %10zu %8lu %12.1f %10.1f %10.1f %10.1f\n", stress_ops[op].name, res[op].count,
+               res[op].errors, res[op].ops_per_sec, res[op].p50_us, res[op].p99_us, res[op].max_us);
+    }
+    free(workers);
+    
+    /* Regression checks */
+    printf("\n");
+    if (errors > max_errors) {
+        printf("❌ %lu mailbox errors (allowed %lu)\n", errors, max_errors);
+        failures++;
+    }
+    for (int op = 0; op < STRESS_MAX_OPS; op++) {
+        const char *name = stress_ops[op].name;
+        double limit = 1.0 + tolerance / 100.0;
+        
+        if (!(stress.ops_mask & (1u << op))) {
+            continue;
+        }
+        if (res[op].count == 0) {
+            printf("❌ %s: no successful operations\n", name);
+            failures++;
+            continue;
+        }
+        if (max_p50 > 0 && res[op].p50_us > max_p50) {
+            printf("❌ %s: p50 %.1f us exceeds %.1f us\n", name, res[op].p50_us, max_p50);
+            failures++;
+        }
+        if (max_p99 > 0 && res[op].p99_us > max_p99) {
+            printf("❌ %s: p99 %.1f us exceeds %.1f us\n", name, res[op].p99_us, max_p99);
+            failures++;
+        }
+        if (baseline_path != NULL && have_base[op]) {
+            if (res[op].p50_us > base[op].p50_us * limit) {
+                printf("❌ %s: p50 %.1f us vs baseline %.1f us (+%.0f%%)\n", name, res[op].p50_us,
+                       base[op].p50_us, (res[op].p50_us / base[op].p50_us - 1) * 100);
+                failures++;
+            }
+            if (res[op].p99_us > base[op].p99_us * limit) {
+                printf("❌ %s: p99 %.1f us vs baseline %.1f us (+%.0f%%)\n", name, res[op].p99_us,
+                       base[op].p99_us, (res[op].p99_us / base[op].p99_us - 1) * 100);
+                failures++;
+            }
+            if (res[op].ops_per_sec < base[op].ops_per_sec / limit) {
+                printf("❌ %s: %.1f ops/sec vs baseline %.1f\n", name, res[op].ops_per_sec,
+                       base[op].ops_per_sec);
+                failures++;
+            }
+        }
+    }
+    
+    if (save_path != NULL && failures == 0) {
+        save_baseline(save_path, res, threads);
+    }
+    
+    if (json_path != NULL) {
+        FILE *f = fopen(json_path, "w");
+        if (f != NULL) {
+            int first = 1;
+            fprintf(f, "{\n  \"threads\": %d,\n  \"seconds\": %.3f,\n  \"failures\": %d,\n  \"ops\": [\n",
+                    threads, elapsed / 1e9, failures);
+            for (int op = 0; op < STRESS_MAX_OPS; op++) {
+                if (!(stress.ops_mask & (1u << op))) {
+                    continue;
+                }
+                fprintf(f, "%s    {\"op\": \"%s\", \"count\": %zu, \"errors\": %lu, \"ops_per_sec\": %.1f, "
+                        "\"p50_us\": %.1f, \"p99_us\": %.1f, \"max_us\": %.1f}",
+                        first ? "" : ",\n", stress_ops[op].name, res[op].count, res[op].errors,
+                        res[op].ops_per_sec, res[op].p50_us, res[op].p99_us, res[op].max_us);
+                first = 0;
+            }
+            fprintf(f, "\n  ]\n}\n");
+            fclose(f);
+        } else {
+            fprintf(stderr, "Cannot write %s: %s\n", json_path, strerror(errno));
+        }
+    }
+    
+    if (failures > 0) {
+        printf("⚠️  Stress test failed (%d checks)\n", failures);
+        exit(EXIT_FAILURE);
+    }
+    printf("🎉 Stress test passed\n");
+    exit(EXIT_SUCCESS);
+}
+
 static void print_usage(const char *prog_name) {
     printf("Usage: %s [OPTIONS]\n", prog_name);
     printf("\nOptions:\n");
-    printf("  all                Run all tests\n");
+    printf("  all                Run all tests except opt-in ones\n");
+    printf("  run [RUN_OPTIONS] [test...]\n");
+    printf("                     Run tests in parallel, one process each\n");
     printf("  <test_name>        Run specific test\n");
     printf("  --list             List available tests\n");
+    printf("  stress [options]   Mailbox throughput/latency stress (stress --help)\n");
     printf("  --help             Show this help\n");
+    printf("\nRun Options:\n");
+    printf("  -j, --jobs N       Tests run at once (default: online CPUs)\n");
+    printf("  -t, --timeout S    Per-test timeout in seconds (default: %d)\n", DEFAULT_TEST_TIMEOUT);
+    printf("  --json FILE        Write a JSON report\n");
+    printf("  --junit FILE       Write a JUnit XML report\n");
     printf("\nAvailable Tests:\n");
     for (size_t i = 0; i < NUM_TESTS; i++) {
         printf("  %-20s %s\n", ele_tests[i].name, ele_tests[i].description);
@@ -312,6 +1859,8 @@ static void print_usage(const char *prog_name) {
 }
 
 int main(int argc, char *argv[]) {
+    init_paths();
+    
     if (argc < 2) {
         print_usage(argv[0]);
         return EXIT_FAILURE;
@@ -332,6 +1881,10 @@ int main(int argc, char *argv[]) {
     
     if (strcmp(argv[1], "all") == 0) {
         run_all_tests();
+    } else if (strcmp(argv[1], "run") == 0) {
+        run_parallel(argc - 1, argv + 1);
+    } else if (strcmp(argv[1], "stress") == 0) {
+        run_stress(argc - 1, argv + 1);
     } else {
         run_single_test(argv[1]);
     }
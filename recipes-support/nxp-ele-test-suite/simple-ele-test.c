@@ -1,21 +1,50 @@
 /*
  * Simple EdgeLock Enclave Test Utility for i.MX93
  * This provides basic ELE testing when the full NXP test suite isn't available
+ *
+ * Platform facts come from libeleprobe, so paths follow the same
+ * environment overrides (ELE_MAILBOX_PATH, ELE_OCOTP_PATH, ...) as the
+ * other ELE tools and repeated runs are answered from the /run cache.
  */
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <strings.h>
 #include <unistd.h>
 #include <fcntl.h>
-#include <sys/stat.h>
-#include <sys/types.h>
-#include <errno.h>
+#include <time.h>
+#include <eleprobe.h>
 
-#define ELE_MAILBOX_PATH "/sys/bus/platform/devices/44230000.mailbox"
-#define ELE_OCOTP_PATH "/sys/bus/nvmem/devices/ELE-OCOTP0"
-#define ELE_RESERVED_MEM_START 0x90000000UL
-#define ELE_RESERVED_MEM_SIZE 0x100000UL
+// i.MX93 OCOTP: 32-bit fuse words, 8 per bank, exposed as one nvmem image
+#define IMX93_FUSE_WORDS_PER_BANK 8
+#define IMX93_OCOTP_MAX_WORDS 1024
+
+/*
+ * Fuse words decoded by the ocotp mode: X(name, bank, word, count, decoder,
+ * description). The lookup table, the name list used for golden maps and
+ * the decoders are all generated from this one list.
+ */
+#define IMX93_FUSES(X) \
+    X(lifecycle,  1, 3, 1, decode_lifecycle, "Lifecycle") \
+    X(boot_cfg0,  3, 0, 1, decode_hex,       "Boot configuration 0") \
+    X(boot_cfg1,  3, 1, 1, decode_hex,       "Boot configuration 1") \
+    X(srk_hash,  16, 0, 8, decode_hex,       "SRK hash") \
+    X(mac1,      39, 3, 2, decode_mac1,      "ENET MAC address 1") \
+    X(mac2,      39, 4, 2, decode_mac2,      "ENET MAC address 2")
+
+typedef void (*fuse_decoder_t)(const unsigned int *w, unsigned int count, char *out, size_t size);
+
+struct fuse_field {
+    const char *name;
+    const char *description;
+    unsigned int index;
+    unsigned int count;
+    fuse_decoder_t decode;
+};
+
+// One platform snapshot per run, shared with the other ELE tools via /run
+static struct ele_probe probe;
 
 void print_usage(const char *prog_name) {
     printf("Simple ELE Test Utility for i.MX93\n");
@@ -24,69 +53,61 @@ void print_usage(const char *prog_name) {
     printf("  info     - Display ELE hardware information\n");
     printf("  status   - Check ELE status and availability\n");
     printf("  mailbox  - Test ELE mailbox communication\n");
-    printf("  ocotp    - Test ELE OCOTP access\n");
+    printf("  ocotp    - Test ELE OCOTP access and decode the fuses\n");
+    printf("             [--diff GOLDEN] compare against a golden fuse map\n");
+    printf("             [--save FILE]   write the current fuses as a golden map\n");
     printf("  memory   - Check ELE reserved memory\n");
     printf("  all      - Run all tests\n");
     printf("  help     - Show this help message\n");
 }
 
 int check_ele_hardware() {
-    struct stat st;
     int score = 0;
     
     printf("=== ELE Hardware Detection ===\n");
     
     // Check ELE mailbox
-    if (stat(ELE_MAILBOX_PATH, &st) == 0) {
-        printf("✅ ELE Mailbox found: %s\n", ELE_MAILBOX_PATH);
+    if (probe.present & ELE_PROBE_HAVE_MAILBOX) {
+        printf("✅ ELE Mailbox found: %s\n", probe.mailbox_path);
         score++;
     } else {
-        printf("❌ ELE Mailbox not found: %s\n", ELE_MAILBOX_PATH);
+        printf("❌ ELE Mailbox not found: %s\n", probe.mailbox_path);
     }
     
     // Check ELE OCOTP
-    if (stat(ELE_OCOTP_PATH, &st) == 0) {
-        printf("✅ ELE OCOTP found: %s\n", ELE_OCOTP_PATH);
+    if (probe.present & ELE_PROBE_HAVE_OCOTP) {
+        printf("✅ ELE OCOTP found: %s\n", probe.ocotp_path);
         score++;
     } else {
-        printf("❌ ELE OCOTP not found: %s\n", ELE_OCOTP_PATH);
+        printf("❌ ELE OCOTP not found: %s\n", probe.ocotp_path);
     }
     
     // Check for ELE in device tree
-    if (stat("/proc/device-tree/__symbols__/s4muap", &st) == 0) {
+    if (probe.present & ELE_PROBE_HAVE_DT_SYMBOL) {
         printf("✅ ELE device tree symbol found\n");
         score++;
     } else {
         printf("❌ ELE device tree symbol not found\n");
     }
     
+    // Enclave identity, when it answered GET_INFO
+    if (probe.present & ELE_PROBE_HAVE_INFO) {
+        printf("ℹ️  ELE firmware 0x%08x, lifecycle %s\n", probe.fw_version,
+               ele_probe_lifecycle_name(probe.lifecycle));
+    }
+    
     printf("\nELE Hardware Score: %d/3\n", score);
     return score;
 }
 
 int test_ele_mailbox() {
-    char path[256];
-    FILE *file;
-    
     printf("\n=== ELE Mailbox Test ===\n");
     
     // Check mailbox driver
-    snprintf(path, sizeof(path), "%s/driver", ELE_MAILBOX_PATH);
-    if (access(path, R_OK) == 0) {
+    if (probe.present & ELE_PROBE_HAVE_MAILBOX_DRIVER) {
         printf("✅ ELE Mailbox driver accessible\n");
-        
-        // Try to read driver name
-        snprintf(path, sizeof(path), "%s/driver/uevent", ELE_MAILBOX_PATH);
-        file = fopen(path, "r");
-        if (file) {
-            char line[256];
-            while (fgets(line, sizeof(line), file)) {
-                if (strstr(line, "DRIVER=")) {
-                    printf("   Driver: %s", line + 7);
-                    break;
-                }
-            }
-            fclose(file);
+        if (probe.mailbox_driver[0] != '\0') {
+            printf("   Driver: %s\n", probe.mailbox_driver);
         }
     } else {
         printf("❌ ELE Mailbox driver not accessible\n");
@@ -97,19 +118,15 @@ int test_ele_mailbox() {
 }
 
 int test_ele_ocotp() {
-    char path[256];
-    struct stat st;
-    
     printf("\n=== ELE OCOTP Test ===\n");
     
     // Check OCOTP device
-    snprintf(path, sizeof(path), "%s/nvmem", ELE_OCOTP_PATH);
-    if (stat(path, &st) == 0) {
+    if (probe.present & ELE_PROBE_HAVE_OCOTP) {
         printf("✅ ELE OCOTP device accessible\n");
-        printf("   Size: %ld bytes\n", st.st_size);
+        printf("   Size: %llu bytes\n", (unsigned long long)probe.ocotp_size);
         
         // Check if readable
-        if (access(path, R_OK) == 0) {
+        if (probe.present & ELE_PROBE_HAVE_OCOTP_READABLE) {
             printf("✅ ELE OCOTP readable\n");
         } else {
             printf("⚠️  ELE OCOTP not readable (may require root)\n");
@@ -122,6 +139,197 @@ int test_ele_ocotp() {
     return 1;
 }
 
+// Decoders: turn fuse words into the string shown and compared with golden maps
+static void decode_hex(const unsigned int *w, unsigned int count, char *out, size_t size) {
+    size_t used = 0;
+    
+    for (unsigned int i = 0; i < count && used + 9 < size; i++) {
+        used += snprintf(out + used, size - used, "%08x", w[i]);
+    }
+}
+
+/*
+ * Lifecycle is one-hot in the low bits, named as in U-Boot's imx9 AHAB
+ * status; names are single words so they round-trip through golden maps.
+ * Anything else (no bit, several bits) is shown raw.
+ */
+#define IMX93_LIFECYCLE_MASK 0x7FF
+
+static const char *const imx93_lifecycles[] = {
+    "blank", "fab-default", "fab", "nxp-provisioned", "oem-open", "oem-secure-world-closed",
+    "oem-closed", "field-return-oem", "field-return-nxp", "oem-locked", "bricked",
+};
+
+static void decode_lifecycle(const unsigned int *w, unsigned int count, char *out, size_t size) {
+    unsigned int lc = w[0] & IMX93_LIFECYCLE_MASK;
+    
+    (void)count;
+    for (size_t i = 0; i < sizeof(imx93_lifecycles) / sizeof(imx93_lifecycles[0]); i++) {
+        if (lc == 1u << i) {
+            snprintf(out, size, "%s", imx93_lifecycles[i]);
+            return;
+        }
+    }
+    snprintf(out, size, "%08x", w[0]);
+}
+
+// ENET MAC addresses share the middle word, as in U-Boot's imx9 fuse layout
+static void decode_mac1(const unsigned int *w, unsigned int count, char *out, size_t size) {
+    (void)count;
+    snprintf(out, size, "%02x:%02x:%02x:%02x:%02x:%02x",
+             (w[1] >> 8) & 0xFF, w[1] & 0xFF, w[0] >> 24,
+             (w[0] >> 16) & 0xFF, (w[0] >> 8) & 0xFF, w[0] & 0xFF);
+}
+
+static void decode_mac2(const unsigned int *w, unsigned int count, char *out, size_t size) {
+    (void)count;
+    snprintf(out, size, "%02x:%02x:%02x:%02x:%02x:%02x",
+             w[1] >> 24, (w[1] >> 16) & 0xFF, (w[1] >> 8) & 0xFF, w[1] & 0xFF,
+             w[0] >> 24, (w[0] >> 16) & 0xFF);
+}
+
+#define FUSE_FIELD(name, bank, word, count, decoder, description) \
+    { #name, description, (bank) * IMX93_FUSE_WORDS_PER_BANK + (word), count, decoder },
+
+static const struct fuse_field fuse_fields[] = {
+    IMX93_FUSES(FUSE_FIELD)
+};
+
+#define NUM_FUSE_FIELDS (sizeof(fuse_fields) / sizeof(fuse_fields[0]))
+
+// The whole nvmem image in one pread; returns the number of words read
+static int read_ocotp_image(unsigned int *words, double *elapsed_us) {
+    char path[ELE_PROBE_PATH_MAX + 8];
+    struct timespec t0, t1;
+    ssize_t n;
+    int fd;
+    
+    snprintf(path, sizeof(path), "%s/nvmem", probe.ocotp_path);
+    fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return -1;
+    }
+    
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    n = pread(fd, words, IMX93_OCOTP_MAX_WORDS * sizeof(words[0]), 0);
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    close(fd);
+    
+    *elapsed_us = (t1.tv_sec - t0.tv_sec) * 1e6 + (t1.tv_nsec - t0.tv_nsec) / 1e3;
+    return n < 0 ? -1 : (int)(n / sizeof(words[0]));
+}
+
+// Decoded value of a field, or of a raw "wordN" entry; 0 if it is in the image
+static int fuse_value(const char *name, const unsigned int *words, int nwords,
+                      char *out, size_t size) {
+    unsigned int index;
+    
+    for (size_t i = 0; i < NUM_FUSE_FIELDS; i++) {
+        const struct fuse_field *f = &fuse_fields[i];
+        
+        if (strcmp(name, f->name) == 0) {
+            if (f->index + f->count > (unsigned int)nwords) {
+                return -1;
+            }
+            f->decode(&words[f->index], f->count, out, size);
+            return 0;
+        }
+    }
+    
+    if (sscanf(name, "word%u", &index) == 1 && index < (unsigned int)nwords) {
+        snprintf(out, size, "%08x", words[index]);
+        return 0;
+    }
+    return -1;
+}
+
+/*
+ * Decode the known fuse words. With golden_path, compare against a golden
+ * fuse map ("name value" lines, as written by --save; "wordN value" for
+ * raw words) and fail on any difference.
+ */
+int ocotp_fuses(const char *golden_path, const char *save_path) {
+    static unsigned int words[IMX93_OCOTP_MAX_WORDS];
+    char value[80];
+    double elapsed_us;
+    int nwords;
+    
+    printf("\n=== ELE OCOTP Fuses ===\n");
+    
+    nwords = read_ocotp_image(words, &elapsed_us);
+    if (nwords < 0) {
+        printf("❌ Cannot read %s/nvmem (may require root)\n", probe.ocotp_path);
+        return golden_path == NULL && save_path == NULL;
+    }
+    printf("Read %d fuse words in %.1f us\n", nwords, elapsed_us);
+    
+    for (size_t i = 0; i < NUM_FUSE_FIELDS; i++) {
+        const struct fuse_field *f = &fuse_fields[i];
+        
+        if (fuse_value(f->name, words, nwords, value, sizeof(value)) != 0) {
+            printf("   %-22s (bank %u word %u) not in image\n", f->description,
+                   f->index / IMX93_FUSE_WORDS_PER_BANK, f->index % IMX93_FUSE_WORDS_PER_BANK);
+            continue;
+        }
+        printf("   %-22s %s", f->description, value);
+        if (strcmp(f->name, "lifecycle") == 0 && (probe.present & ELE_PROBE_HAVE_INFO)) {
+            printf(" (ELE reports %s)", ele_probe_lifecycle_name(probe.lifecycle));
+        }
+        printf("\n");
+    }
+    
+    if (save_path != NULL) {
+        FILE *out = fopen(save_path, "w");
+        if (out == NULL) {
+            printf("❌ Cannot write %s\n", save_path);
+            return 0;
+        }
+        fprintf(out, "# i.MX93 golden fuse map: name value\n");
+        for (size_t i = 0; i < NUM_FUSE_FIELDS; i++) {
+            if (fuse_value(fuse_fields[i].name, words, nwords, value, sizeof(value)) == 0) {
+                fprintf(out, "%s %s\n", fuse_fields[i].name, value);
+            }
+        }
+        fclose(out);
+        printf("✅ Golden fuse map written to %s\n", save_path);
+    }
+    
+    if (golden_path != NULL) {
+        FILE *in = fopen(golden_path, "r");
+        char line[256];
+        int checked = 0, mismatches = 0;
+        
+        if (in == NULL) {
+            printf("❌ Cannot read golden fuse map %s\n", golden_path);
+            return 0;
+        }
+        while (fgets(line, sizeof(line), in)) {
+            char name[64], expected[80];
+            
+            if (line[0] == '#' || sscanf(line, "%63s %79s", name, expected) != 2) {
+                continue;
+            }
+            checked++;
+            if (fuse_value(name, words, nwords, value, sizeof(value)) != 0) {
+                printf("❌ %s: unknown or outside the image\n", name);
+                mismatches++;
+            } else if (strcasecmp(value, expected) != 0) {
+                printf("❌ %s: %s, expected %s\n", name, value, expected);
+                mismatches++;
+            }
+        }
+        fclose(in);
+        
+        if (mismatches > 0) {
+            printf("❌ %d of %d fuse entries differ from %s\n", mismatches, checked, golden_path);
+            return 0;
+        }
+        printf("✅ All %d fuse entries match %s\n", checked, golden_path);
+    }
+    
+    return 1;
+}
+
 int test_ele_memory() {
     printf("\n=== ELE Memory Test ===\n");
     printf("ELE Reserved Memory: 0x%08lx - 0x%08lx (%lu KB)\n", 
@@ -130,22 +338,12 @@ int test_ele_memory() {
            ELE_RESERVED_MEM_SIZE / 1024);
     
     // Check if memory region is mentioned in /proc/iomem
-    FILE *iomem = fopen("/proc/iomem", "r");
-    if (iomem) {
-        char line[256];
-        int found = 0;
-        while (fgets(line, sizeof(line), iomem)) {
-            if (strstr(line, "90000000") && strstr(line, "ele")) {
-                printf("✅ ELE memory region found in /proc/iomem:\n   %s", line);
-                found = 1;
-                break;
-            }
-        }
-        fclose(iomem);
-        
-        if (!found) {
-            printf("⚠️  ELE memory region not explicitly found in /proc/iomem\n");
-        }
+    if (probe.present & ELE_PROBE_HAVE_RESERVED_MEM) {
+        printf("✅ ELE memory region found in /proc/iomem:\n   %08llx-%08llx : %s\n",
+               (unsigned long long)probe.reserved_start,
+               (unsigned long long)probe.reserved_end, probe.reserved_name);
+    } else {
+        printf("⚠️  ELE memory region not explicitly found in /proc/iomem\n");
     }
     
     return 1;
@@ -169,6 +367,9 @@ void show_ele_status() {
 }
 
 int main(int argc, char *argv[]) {
+    const char *golden_path = NULL, *save_path = NULL;
+    int ok = 1;
+    
     if (argc < 2) {
         print_usage(argv[0]);
         return 1;
@@ -176,6 +377,28 @@ int main(int argc, char *argv[]) {
     
     const char *command = argv[1];
     
+    for (int i = 2; i < argc; i += 2) {
+        if (strcmp(argv[i], "--diff") != 0 && strcmp(argv[i], "--save") != 0) {
+            fprintf(stderr, "Unknown option: %s\n", argv[i]);
+            print_usage(argv[0]);
+            return 1;
+        }
+        if (i + 1 >= argc) {
+            fprintf(stderr, "%s needs a file\n", argv[i]);
+            return 1;
+        }
+        if (strcmp(argv[i], "--diff") == 0) {
+            golden_path = argv[i + 1];
+        } else {
+            save_path = argv[i + 1];
+        }
+    }
+    
+    if (ele_probe_get(&probe, 0) != 0) {
+        fprintf(stderr, "ELE platform probe failed\n");
+        return 1;
+    }
+    
     printf("Simple ELE Test Utility for i.MX93\n");
     printf("===================================\n");
     
@@ -192,7 +415,9 @@ int main(int argc, char *argv[]) {
     }
     
     if (strcmp(command, "ocotp") == 0 || strcmp(command, "all") == 0) {
-        test_ele_ocotp();
+        if (test_ele_ocotp()) {
+            ok = ocotp_fuses(golden_path, save_path);
+        }
     }
     
     if (strcmp(command, "memory") == 0 || strcmp(command, "all") == 0) {
@@ -203,5 +428,5 @@ int main(int argc, char *argv[]) {
         print_usage(argv[0]);
     }
     
-    return 0;
+    return ok ? 0 : 1;
 }
@@ -177,6 +177,13 @@ show_status() {
     aplay -l 2>/dev/null || echo "  No playback devices"
     echo ""
     arecord -l 2>/dev/null || echo "  No capture devices"
+
+    echo ""
+    if pidof usb-audio-bridge >/dev/null 2>&1; then
+        echo "Codec bridge: RUNNING (journalctl -u usb-audio-bridge for latency/drift)"
+    else
+        echo "Codec bridge: NOT RUNNING (systemctl start usb-audio-bridge)"
+    fi
 }
 
 # Main script logic
@@ -0,0 +1,853 @@
+/* SPDX-License-Identifier: MIT */
+/*
+ * usb-audio-bridge - UAC2 gadget <-> board codec bridge with drift compensation
+ *
+ * Moves audio between the configfs UAC2 gadget set up by
+ * setup-usb-audio-gadget and the board codecs, in both directions:
+ *
+ *   downlink: gadget capture (host playback) -> codec playback
+ *   uplink:   codec capture -> gadget playback (host capture)
+ *
+ * Each direction runs in its own thread with mmap access on both PCMs:
+ * the resampler reads straight out of the source's DMA area and writes
+ * straight into the sink's, so there is no copy besides the
+ * interpolation itself (alsaloop and GStreamer pipelines go through two
+ * or three intermediate buffers).
+ *
+ * USB SOF and the codec crystal never agree exactly, so a fixed ratio
+ * slowly drains or floods the sink. The bridge keeps the sink filled to
+ * the target latency instead: the smoothed fill error drives a PI loop
+ * whose integral is the measured clock drift in ppm, and the ratio of a
+ * 4-tap Catmull-Rom fractional resampler (NEON on AArch64) follows it.
+ * The same resampler converts between different nominal rates.
+ *
+ * When the host stops streaming the gadget side stalls; the direction
+ * goes idle, keeps draining its source, and retries every second.
+ * Each direction reports latency (min/mean/max), drift, xruns and CPU
+ * time every -i seconds.
+ *
+ *   usb-audio-bridge                                  # generic asound.conf names
+ *   usb-audio-bridge -O plughw:tas2563audio -I plughw:micfilaudio -U hw:UAC2Gadget -u hw:UAC2Gadget
+ *   usb-audio-bridge -O driver_speaker -I driver_mic -o down -l 10
+ *   usb-audio-bridge -R 50 -i 5 -v
+ */
+
+#define _GNU_SOURCE
+#include <errno.h>
+#include <getopt.h>
+#include <math.h>
+#include <pthread.h>
+#include <sched.h>
+#include <signal.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#include <alsa/asoundlib.h>
+
+#if defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+#define MAX_CHANNELS        8
+#define TAPS                4
+
+#define DEFAULT_USB_CAPTURE  "usb_gadget_mic"
+#define DEFAULT_USB_PLAYBACK "usb_gadget_speaker"
+#define DEFAULT_CODEC_PLAY   "spk"
+#define DEFAULT_CODEC_CAP    "mic"
+#define DEFAULT_RATE         48000
+#define DEFAULT_CHANNELS     2
+#define DEFAULT_PERIOD_US    2000
+#define DEFAULT_LATENCY_MS   8
+#define DEFAULT_REPORT_S     10
+
+#define WAIT_MS              100
+#define STALL_MS             500
+#define RETRY_MS             1000
+#define FILL_TAU_S           0.5        // fill smoothing
+#define KP_PPM_PER_FRAME     10.0
+#define KI_PPM_PER_FRAME_S   1.0
+#define MAX_PPM              2000.0
+
+typedef struct {
+    const char *name;
+    snd_pcm_t *pcm;
+    snd_pcm_stream_t stream;
+    unsigned int channels;
+    unsigned int rate;
+    snd_pcm_uframes_t period;
+    snd_pcm_uframes_t buffer;
+} end_t;
+
+typedef enum {
+    ST_RUNNING = 0,
+    ST_IDLE
+} state_t;
+
+typedef struct {
+    const char *label;
+    end_t src;
+    end_t sink;
+    snd_pcm_uframes_t target;           // sink fill to hold, frames
+
+    // Resampler: next output sits at pos input frames from the current chunk
+    double pos;
+    double step_nominal;
+    int16_t tail[(TAPS - 1) * MAX_CHANNELS];
+
+    // Drift loop
+    double fill_avg;
+    double integ;                       // ppm, the clock drift estimate
+    double ppm;                         // applied correction
+    double t_loop;
+
+    // Progress and state
+    state_t state;
+    int streaming;                      // "streaming" logged since the last idle
+    double t_in;                        // last time the source delivered
+    double t_out;                       // last time the sink consumed
+    double t_idle;
+    uint64_t written;                   // frames committed to the sink since start
+    uint64_t consumed;
+
+    // Interval counters
+    double t_report;
+    double cpu_report;
+    uint64_t frames_in;
+    uint64_t frames_out;
+    unsigned int xruns;
+    unsigned int stalls;
+    double lat_sum;
+    double lat_min;
+    double lat_max;
+    unsigned int lat_n;
+
+    pthread_t thread;
+} bridge_t;
+
+static volatile sig_atomic_t stop;
+static int verbose;
+static int use_scalar;
+static unsigned int report_s = DEFAULT_REPORT_S;
+
+static void on_signal(int sig) {
+    (void)sig;
+    stop = 1;
+}
+
+static double now_s(void) {
+    struct timespec t;
+
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (double)t.tv_sec + (double)t.tv_nsec / 1e9;
+}
+
+static double thread_cpu_s(void) {
+    struct timespec t;
+
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &t);
+    return (double)t.tv_sec + (double)t.tv_nsec / 1e9;
+}
+
+/* ---- PCM setup ---- */
+
+static int end_open(end_t *e, unsigned int period_us, unsigned int buffer_us) {
+    const char *what = e->stream == SND_PCM_STREAM_PLAYBACK ? "play" : "capture";
+    snd_pcm_hw_params_t *hw;
+    snd_pcm_sw_params_t *sw;
+    unsigned int r = e->rate;
+    int err;
+
+    if ((err = snd_pcm_open(&e->pcm, e->name, e->stream, 0)) < 0) {
+        fprintf(stderr, "usb-audio-bridge: %s: %s\n", e->name, snd_strerror(err));
+        return -1;
+    }
+    snd_pcm_hw_params_alloca(&hw);
+    snd_pcm_sw_params_alloca(&sw);
+    if ((err = snd_pcm_hw_params_any(e->pcm, hw)) < 0 ||
+        (err = snd_pcm_hw_params_set_access(e->pcm, hw, SND_PCM_ACCESS_MMAP_INTERLEAVED)) < 0 ||
+        (err = snd_pcm_hw_params_set_format(e->pcm, hw, SND_PCM_FORMAT_S16_LE)) < 0 ||
+        (err = snd_pcm_hw_params_set_channels(e->pcm, hw, e->channels)) < 0 ||
+        (err = snd_pcm_hw_params_set_rate_near(e->pcm, hw, &r, NULL)) < 0 ||
+        (err = snd_pcm_hw_params_set_period_time_near(e->pcm, hw, &period_us, NULL)) < 0 ||
+        (err = snd_pcm_hw_params_set_buffer_time_near(e->pcm, hw, &buffer_us, NULL)) < 0 ||
+        (err = snd_pcm_hw_params(e->pcm, hw)) < 0) {
+        fprintf(stderr, "usb-audio-bridge: %s: cannot %s mmap S16_LE %u ch %u Hz: %s\n",
+                e->name, what, e->channels, e->rate, snd_strerror(err));
+        snd_pcm_close(e->pcm);
+        e->pcm = NULL;
+        return -1;
+    }
+    if (r != e->rate) {
+        fprintf(stderr, "usb-audio-bridge: %s: %u Hz instead of %u, resampling from that\n",
+                e->name, r, e->rate);
+        e->rate = r;
+    }
+    snd_pcm_hw_params_get_period_size(hw, &e->period, NULL);
+    snd_pcm_hw_params_get_buffer_size(hw, &e->buffer);
+
+    // Started explicitly; wake once a period is ready
+    snd_pcm_sw_params_current(e->pcm, sw);
+    snd_pcm_sw_params_set_start_threshold(e->pcm, sw, e->buffer * 2);
+    snd_pcm_sw_params_set_avail_min(e->pcm, sw, e->period);
+    if ((err = snd_pcm_sw_params(e->pcm, sw)) < 0) {
+        fprintf(stderr, "usb-audio-bridge: %s: sw params: %s\n", e->name, snd_strerror(err));
+        snd_pcm_close(e->pcm);
+        e->pcm = NULL;
+        return -1;
+    }
+    return 0;
+}
+
+// First sample of frame `offset` in an interleaved mmap area
+static int16_t *area_frame(const snd_pcm_channel_area_t *areas, snd_pcm_uframes_t offset) {
+    return (int16_t *)((char *)areas[0].addr + (areas[0].first + offset * areas[0].step) / 8);
+}
+
+/* ---- Sink cursor: resampler output goes straight into the mmap area ---- */
+
+typedef struct {
+    end_t *end;
+    int16_t *at;
+    snd_pcm_uframes_t offset;
+    snd_pcm_uframes_t frames;           // contiguous frames granted
+    snd_pcm_uframes_t used;
+    snd_pcm_uframes_t total;
+    int err;
+} cursor_t;
+
+static int cursor_commit(cursor_t *c) {
+    snd_pcm_uframes_t used = c->used;
+    snd_pcm_sframes_t r;
+
+    if (c->frames == 0) {
+        return 0;
+    }
+    r = snd_pcm_mmap_commit(c->end->pcm, c->offset, used);
+    c->total += used;
+    c->frames = c->used = 0;
+    if (r < 0 || (snd_pcm_uframes_t)r != used) {
+        return r < 0 ? (int)r : -EPIPE;
+    }
+    return 0;
+}
+
+// Room for one more frame, committing and re-mapping at the wrap
+static int16_t *cursor_next(cursor_t *c) {
+    if (c->used == c->frames) {
+        const snd_pcm_channel_area_t *areas;
+        snd_pcm_uframes_t frames = c->end->buffer;
+        int err;
+
+        if ((err = cursor_commit(c)) < 0 ||
+            (err = snd_pcm_mmap_begin(c->end->pcm, &areas, &c->offset, &frames)) < 0) {
+            c->err = err;
+            return NULL;
+        }
+        if (frames == 0) {
+            c->err = -EAGAIN;
+            return NULL;
+        }
+        c->frames = frames;
+        c->at = area_frame(areas, c->offset);
+    }
+    c->used++;
+    c->at += c->end->channels;
+    return c->at - c->end->channels;
+}
+
+/* ---- Resampler ---- */
+
+// Catmull-Rom weights for taps x[i-1..i+2] at fraction mu, as ((A mu + B) mu + C) mu + D
+static const float cr_a[TAPS] = { -0.5f, 1.5f, -1.5f, 0.5f };
+static const float cr_b[TAPS] = { 1.0f, -2.5f, 2.0f, -0.5f };
+static const float cr_c[TAPS] = { -0.5f, 0.0f, 0.5f, 0.0f };
+static const float cr_d[TAPS] = { 0.0f, 1.0f, 0.0f, 0.0f };
+
+static void interp_scalar(const int16_t *x, unsigned int ch, float mu, float *out) {
+    float w[TAPS];
+
+    for (int k = 0; k < TAPS; k++) {
+        w[k] = ((cr_a[k] * mu + cr_b[k]) * mu + cr_c[k]) * mu + cr_d[k];
+    }
+    for (unsigned int c = 0; c < ch; c++) {
+        out[c] = w[0] * x[c] + w[1] * x[ch + c] + w[2] * x[2 * ch + c] + w[3] * x[3 * ch + c];
+    }
+}
+
+#if defined(__aarch64__)
+// Stereo and mono: one deinterleaving load of the four tap frames, weights by FMA
+static void interp_neon(const int16_t *x, unsigned int ch, float mu, float *out) {
+    float32x4_t m = vdupq_n_f32(mu);
+    float32x4_t w = vfmaq_f32(vld1q_f32(cr_b), vld1q_f32(cr_a), m);
+
+    w = vfmaq_f32(vld1q_f32(cr_c), w, m);
+    w = vfmaq_f32(vld1q_f32(cr_d), w, m);
+    if (ch == 2) {
+        int16x4x2_t f = vld2_s16(x);
+
+        out[0] = vaddvq_f32(vmulq_f32(vcvtq_f32_s32(vmovl_s16(f.val[0])), w));
+        out[1] = vaddvq_f32(vmulq_f32(vcvtq_f32_s32(vmovl_s16(f.val[1])), w));
+    } else {
+        out[0] = vaddvq_f32(vmulq_f32(vcvtq_f32_s32(vmovl_s16(vld1_s16(x))), w));
+    }
+}
+#endif
+
+static void interp(const int16_t *x, unsigned int ch, float mu, float *out) {
+#if defined(__aarch64__)
+    if (!use_scalar && ch <= 2) {
+        interp_neon(x, ch, mu, out);
+        return;
+    }
+#endif
+    interp_scalar(x, ch, mu, out);
+}
+
+static int16_t sat16(float v) {
+    long s = lrintf(v);
+
+    return (int16_t)(s > 32767 ? 32767 : s < -32768 ? -32768 : s);
+}
+
+/*
+ * Resample n contiguous source frames into the sink. Tap windows that
+ * reach back into the previous chunk are read from a six-frame join of
+ * its tail and this chunk's head; all others are read in place.
+ */
+static int resample(bridge_t *b, const int16_t *in, snd_pcm_uframes_t n, cursor_t *cur) {
+    unsigned int ich = b->src.channels;
+    unsigned int och = b->sink.channels;
+    double step = b->step_nominal * (1.0 + b->ppm * 1e-6);
+    int16_t join[(2 * TAPS - 2) * MAX_CHANNELS];
+    snd_pcm_uframes_t head = n < TAPS - 1 ? n : TAPS - 1;
+    float v[MAX_CHANNELS];
+
+    memcpy(join, b->tail, (TAPS - 1) * ich * sizeof(int16_t));
+    memcpy(join + (TAPS - 1) * ich, in, head * ich * sizeof(int16_t));
+
+    for (;;) {
+        long i = (long)floor(b->pos);
+        float mu = (float)(b->pos - (double)i);
+        int16_t *o;
+
+        if (i + 2 >= (long)n) {
+            break;
+        }
+        interp(i >= 1 ? in + (i - 1) * ich : join + (i + 2) * ich, ich, mu, v);
+        if (!(o = cursor_next(cur))) {
+            return cur->err;
+        }
+        if (och == 1 && ich >= 2) {
+            o[0] = sat16(0.5f * (v[0] + v[1]));
+        } else {
+            for (unsigned int c = 0; c < och; c++) {
+                o[c] = sat16(v[c % ich]);
+            }
+        }
+        b->pos += step;
+    }
+    b->pos -= (double)n;
+
+    // Keep the last three frames of the virtual input for the next chunk
+    if (n >= TAPS - 1) {
+        memcpy(b->tail, in + (n - (TAPS - 1)) * ich, (TAPS - 1) * ich * sizeof(int16_t));
+    } else {
+        memmove(b->tail, b->tail + n * ich, (TAPS - 1 - n) * ich * sizeof(int16_t));
+        memcpy(b->tail + (TAPS - 1 - n) * ich, in, n * ich * sizeof(int16_t));
+    }
+    return 0;
+}
+
+/* ---- One direction ---- */
+
+static void bridge_log(const bridge_t *b, const char *fmt, ...) __attribute__((format(printf, 2, 3)));
+
+static void bridge_log(const bridge_t *b, const char *fmt, ...) {
+    char msg[256];
+    va_list ap;
+
+    va_start(ap, fmt);
+    vsnprintf(msg, sizeof(msg), fmt, ap);
+    va_end(ap);
+    printf("%s: %s\n", b->label, msg);
+    fflush(stdout);
+}
+
+// (Re)start both PCMs with the sink prefilled to the target
+static int bridge_start(bridge_t *b) {
+    const snd_pcm_channel_area_t *areas;
+    snd_pcm_uframes_t offset;
+    snd_pcm_uframes_t frames;
+    snd_pcm_uframes_t left = b->target;
+    int err;
+
+    snd_pcm_drop(b->sink.pcm);
+    snd_pcm_drop(b->src.pcm);
+    if ((err = snd_pcm_prepare(b->sink.pcm)) < 0 || (err = snd_pcm_prepare(b->src.pcm)) < 0) {
+        return err;
+    }
+    while (left) {
+        frames = left;
+        if ((err = snd_pcm_mmap_begin(b->sink.pcm, &areas, &offset, &frames)) < 0) {
+            return err;
+        }
+        snd_pcm_areas_silence(areas, offset, b->sink.channels, frames, SND_PCM_FORMAT_S16_LE);
+        if ((err = (int)snd_pcm_mmap_commit(b->sink.pcm, offset, frames)) < 0) {
+            return err;
+        }
+        left -= frames;
+    }
+    if ((err = snd_pcm_start(b->sink.pcm)) < 0 || (err = snd_pcm_start(b->src.pcm)) < 0) {
+        return err;
+    }
+    memset(b->tail, 0, sizeof(b->tail));
+    b->pos = 0;
+    b->fill_avg = (double)b->target;
+    b->written = b->target;
+    b->consumed = 0;
+    b->t_loop = now_s();
+    b->state = ST_RUNNING;
+    return 0;
+}
+
+static void go_idle(bridge_t *b, const char *why) {
+    if (b->streaming) {
+        bridge_log(b, "idle: %s", why);
+    }
+    snd_pcm_drop(b->sink.pcm);
+    b->state = ST_IDLE;
+    b->streaming = 0;
+    b->t_idle = now_s();
+    b->stalls++;
+}
+
+// Drop whatever the source has while the sink is down
+static void drain_source(bridge_t *b) {
+    snd_pcm_sframes_t avail = snd_pcm_avail_update(b->src.pcm);
+
+    if (avail < 0) {
+        snd_pcm_prepare(b->src.pcm);
+        snd_pcm_start(b->src.pcm);
+        return;
+    }
+    if (avail > 0) {
+        b->t_in = now_s();
+    }
+    while (avail > 0) {
+        const snd_pcm_channel_area_t *areas;
+        snd_pcm_uframes_t offset;
+        snd_pcm_uframes_t frames = (snd_pcm_uframes_t)avail;
+
+        if (snd_pcm_mmap_begin(b->src.pcm, &areas, &offset, &frames) < 0 || frames == 0) {
+            return;
+        }
+        snd_pcm_mmap_commit(b->src.pcm, offset, frames);
+        avail -= (snd_pcm_sframes_t)frames;
+    }
+}
+
+// Move what the source has into the sink; negative on an xrun
+static int pump(bridge_t *b) {
+    snd_pcm_sframes_t src_avail = snd_pcm_avail_update(b->src.pcm);
+    snd_pcm_sframes_t sink_avail = snd_pcm_avail_update(b->sink.pcm);
+    double step = b->step_nominal * (1.0 + b->ppm * 1e-6);
+    double t = now_s();
+    cursor_t cur = { .end = &b->sink };
+    snd_pcm_uframes_t max_in;
+    snd_pcm_uframes_t left;
+    uint64_t consumed;
+    double fill;
+    double e;
+    double dt;
+    int err;
+
+    if (src_avail < 0) {
+        return (int)src_avail;
+    }
+    if (sink_avail < 0) {
+        return (int)sink_avail;
+    }
+
+    // Sink progress: what it has played out of what we wrote
+    consumed = b->written - (b->sink.buffer - (snd_pcm_uframes_t)sink_avail);
+    if (consumed != b->consumed) {
+        b->consumed = consumed;
+        b->t_out = t;
+    }
+
+    // n inputs make at most n / step + 1 outputs
+    max_in = sink_avail > 2 ? (snd_pcm_uframes_t)((double)(sink_avail - 2) * step) : 0;
+    left = (snd_pcm_uframes_t)src_avail < max_in ? (snd_pcm_uframes_t)src_avail : max_in;
+    if (left) {
+        b->t_in = t;
+    }
+    while (left) {
+        const snd_pcm_channel_area_t *areas;
+        snd_pcm_uframes_t offset;
+        snd_pcm_uframes_t frames = left;
+        snd_pcm_sframes_t r;
+
+        if ((err = snd_pcm_mmap_begin(b->src.pcm, &areas, &offset, &frames)) < 0) {
+            return err;
+        }
+        if (frames == 0) {
+            break;
+        }
+        if ((err = resample(b, area_frame(areas, offset), frames, &cur)) < 0) {
+            return err;
+        }
+        r = snd_pcm_mmap_commit(b->src.pcm, offset, frames);
+        if (r < 0 || (snd_pcm_uframes_t)r != frames) {
+            return r < 0 ? (int)r : -EPIPE;
+        }
+        b->frames_in += frames;
+        left -= frames;
+    }
+    if ((err = cursor_commit(&cur)) < 0) {
+        return err;
+    }
+    b->written += cur.total;
+    b->frames_out += cur.total;
+
+    // Drift loop on the sink fill, counting source backlog in sink frames
+    if ((src_avail = snd_pcm_avail_update(b->src.pcm)) < 0 ||
+        (sink_avail = snd_pcm_avail_update(b->sink.pcm)) < 0) {
+        return src_avail < 0 ? (int)src_avail : (int)sink_avail;
+    }
+    fill = (double)(b->sink.buffer - (snd_pcm_uframes_t)sink_avail) + (double)src_avail / b->step_nominal;
+    dt = t - b->t_loop;
+    b->t_loop = t;
+    b->fill_avg += (fill - b->fill_avg) * (1.0 - exp(-dt / FILL_TAU_S));
+    e = b->fill_avg - (double)b->target;
+    b->integ = fmax(-MAX_PPM, fmin(MAX_PPM, b->integ + KI_PPM_PER_FRAME_S * e * dt));
+    b->ppm = fmax(-MAX_PPM, fmin(MAX_PPM, b->integ + KP_PPM_PER_FRAME * e));
+
+    // Source to sink latency: backlog, resampler taps, sink queue
+    {
+        double lat = ((double)src_avail + TAPS / 2) / b->src.rate +
+                     (double)(b->sink.buffer - (snd_pcm_uframes_t)sink_avail) / b->sink.rate;
+
+        b->lat_sum += lat;
+        b->lat_min = b->lat_n ? fmin(b->lat_min, lat) : lat;
+        b->lat_max = b->lat_n ? fmax(b->lat_max, lat) : lat;
+        b->lat_n++;
+    }
+    if (!b->streaming && b->consumed > b->target && b->frames_in) {
+        b->streaming = 1;
+        bridge_log(b, "streaming %s -> %s (%u -> %u Hz, periods %lu/%lu, target %lu frames)",
+                   b->src.name, b->sink.name, b->src.rate, b->sink.rate, b->src.period,
+                   b->sink.period, b->target);
+    }
+    return 0;
+}
+
+static void report(bridge_t *b) {
+    double t = now_s();
+    double cpu = thread_cpu_s();
+    double span = t - b->t_report;
+
+    if (span < report_s) {
+        return;
+    }
+    if (b->state == ST_RUNNING && b->lat_n) {
+        bridge_log(b, "latency %.2f/%.2f/%.2f ms  drift %+.1f ppm  fill %.1f/%lu  "
+                   "in %.0f/s out %.0f/s  xruns %u  cpu %.2f%%",
+                   b->lat_min * 1e3, b->lat_sum / b->lat_n * 1e3, b->lat_max * 1e3, b->integ,
+                   b->fill_avg, b->target, b->frames_in / span, b->frames_out / span, b->xruns,
+                   (cpu - b->cpu_report) / span * 100.0);
+    } else if (verbose) {
+        bridge_log(b, "idle  xruns %u  stalls %u", b->xruns, b->stalls);
+    }
+    b->t_report = t;
+    b->cpu_report = cpu;
+    b->frames_in = b->frames_out = 0;
+    b->lat_sum = 0;
+    b->lat_n = 0;
+}
+
+static void *run_bridge(void *arg) {
+    bridge_t *b = arg;
+    int err;
+
+    b->t_report = b->t_in = b->t_out = now_s();
+    b->cpu_report = thread_cpu_s();
+    if ((err = bridge_start(b)) < 0) {
+        bridge_log(b, "start: %s", snd_strerror(err));
+        go_idle(b, "start failed");
+    }
+    while (!stop) {
+        double t;
+
+        err = snd_pcm_wait(b->src.pcm, WAIT_MS);
+        t = now_s();
+        if (b->state == ST_IDLE) {
+            drain_source(b);
+            if (t - b->t_idle >= RETRY_MS / 1e3 && t - b->t_in < STALL_MS / 1e3) {
+                b->t_out = t;
+                if ((err = bridge_start(b)) < 0) {
+                    go_idle(b, snd_strerror(err));
+                }
+            }
+            report(b);
+            continue;
+        }
+        if (err >= 0) {
+            err = pump(b);
+        }
+        if (t - b->t_in >= STALL_MS / 1e3) {
+            go_idle(b, "source stalled (host not streaming?)");
+        } else if (t - b->t_out >= STALL_MS / 1e3) {
+            go_idle(b, "sink stalled (host not capturing?)");
+        } else if (err < 0) {
+            // A source quiet for longer than the sink queue is a stall in the making, not an xrun
+            if (t - b->t_in < (double)b->target / b->sink.rate) {
+                b->xruns++;
+                if (verbose) {
+                    bridge_log(b, "xrun (%s), restarting", snd_strerror(err));
+                }
+            }
+            if ((err = bridge_start(b)) < 0) {
+                go_idle(b, snd_strerror(err));
+            }
+            continue;
+        }
+        report(b);
+    }
+    snd_pcm_drop(b->sink.pcm);
+    snd_pcm_drop(b->src.pcm);
+    return NULL;
+}
+
+static int bridge_open(bridge_t *b, unsigned int period_us, unsigned int latency_ms) {
+    unsigned int buffer_us = period_us * 4;
+
+    // Sink buffer must hold the target with room for a source period either way
+    if (buffer_us < latency_ms * 2000) {
+        buffer_us = latency_ms * 2000;
+    }
+    if (end_open(&b->src, period_us, buffer_us) < 0) {
+        return -1;
+    }
+    if (end_open(&b->sink, period_us, buffer_us) < 0) {
+        snd_pcm_close(b->src.pcm);
+        return -1;
+    }
+    b->target = (snd_pcm_uframes_t)latency_ms * b->sink.rate / 1000;
+    if (b->target < b->sink.period * 2) {
+        b->target = b->sink.period * 2;
+    }
+    if (b->target > b->sink.buffer - b->sink.period) {
+        b->target = b->sink.buffer - b->sink.period;
+    }
+    b->step_nominal = (double)b->src.rate / b->sink.rate;
+    if (verbose) {
+        bridge_log(b, "%s (%u ch, period %lu, buffer %lu) -> %s (%u ch, period %lu, buffer %lu)",
+                   b->src.name, b->src.channels, b->src.period, b->src.buffer, b->sink.name,
+                   b->sink.channels, b->sink.period, b->sink.buffer);
+    }
+    return 0;
+}
+
+static void print_usage(const char *prog) {
+    printf("Usage: %s [options]\n", prog);
+    printf("\n");
+    printf("Devices (defaults are the sentai asound.conf names):\n");
+    printf("  -U, --usb-capture PCM   Gadget capture, host -> board (default %s)\n", DEFAULT_USB_CAPTURE);
+    printf("  -u, --usb-playback PCM  Gadget playback, board -> host (default %s)\n", DEFAULT_USB_PLAYBACK);
+    printf("  -O, --codec-out PCM     Codec playback (default %s)\n", DEFAULT_CODEC_PLAY);
+    printf("  -I, --codec-in PCM      Codec capture (default %s)\n", DEFAULT_CODEC_CAP);
+    printf("  -o, --only DIR          Only bridge 'down' (host -> codec) or 'up' (codec -> host)\n");
+    printf("\n");
+    printf("Format:\n");
+    printf("  -r, --usb-rate HZ       Gadget rate, as c_srate/p_srate (default %d)\n", DEFAULT_RATE);
+    printf("  -c, --usb-channels N    Gadget channels (default %d)\n", DEFAULT_CHANNELS);
+    printf("  -s, --codec-rate HZ     Codec rate (default %d)\n", DEFAULT_RATE);
+    printf("  -C, --codec-channels N  Codec playback channels; 1 mixes stereo down (default %d)\n", DEFAULT_CHANNELS);
+    printf("  -m, --mic-channels N    Codec capture channels (default %d)\n", DEFAULT_CHANNELS);
+    printf("\n");
+    printf("Timing:\n");
+    printf("  -p, --period US         Period time on every PCM (default %d)\n", DEFAULT_PERIOD_US);
+    printf("  -l, --latency MS        Sink fill the drift loop holds (default %d)\n", DEFAULT_LATENCY_MS);
+    printf("  -R, --realtime PRIO     Run both directions SCHED_FIFO at PRIO\n");
+    printf("  -i, --interval S        Report interval (default %d)\n", DEFAULT_REPORT_S);
+    printf("\n");
+    printf("  -S, --scalar            Use the scalar resampler\n");
+    printf("  -v, --verbose           Report setup, xruns and idle intervals too\n");
+    printf("  -h, --help              Show this help\n");
+}
+
+int main(int argc, char *argv[]) {
+    static const struct option long_opts[] = {
+        { "usb-capture", required_argument, NULL, 'U' },
+        { "usb-playback", required_argument, NULL, 'u' },
+        { "codec-out", required_argument, NULL, 'O' },
+        { "codec-in", required_argument, NULL, 'I' },
+        { "only", required_argument, NULL, 'o' },
+        { "usb-rate", required_argument, NULL, 'r' },
+        { "usb-channels", required_argument, NULL, 'c' },
+        { "codec-rate", required_argument, NULL, 's' },
+        { "codec-channels", required_argument, NULL, 'C' },
+        { "mic-channels", required_argument, NULL, 'm' },
+        { "period", required_argument, NULL, 'p' },
+        { "latency", required_argument, NULL, 'l' },
+        { "realtime", required_argument, NULL, 'R' },
+        { "interval", required_argument, NULL, 'i' },
+        { "scalar", no_argument, NULL, 'S' },
+        { "verbose", no_argument, NULL, 'v' },
+        { "help", no_argument, NULL, 'h' },
+        { NULL, 0, NULL, 0 }
+    };
+    bridge_t down = { .label = "downlink" };
+    bridge_t up = { .label = "uplink" };
+    bridge_t *run[2];
+    int n_run = 0;
+    const char *only = NULL;
+    unsigned int usb_rate = DEFAULT_RATE;
+    unsigned int usb_ch = DEFAULT_CHANNELS;
+    unsigned int codec_rate = DEFAULT_RATE;
+    unsigned int codec_ch = DEFAULT_CHANNELS;
+    unsigned int mic_ch = DEFAULT_CHANNELS;
+    unsigned int period_us = DEFAULT_PERIOD_US;
+    unsigned int latency_ms = DEFAULT_LATENCY_MS;
+    int rt_prio = 0;
+    struct sigaction sa;
+    int opt;
+
+    down.src.name = DEFAULT_USB_CAPTURE;
+    down.sink.name = DEFAULT_CODEC_PLAY;
+    up.src.name = DEFAULT_CODEC_CAP;
+    up.sink.name = DEFAULT_USB_PLAYBACK;
+
+    while ((opt = getopt_long(argc, argv, "U:u:O:I:o:r:c:s:C:m:p:l:R:i:Svh", long_opts, NULL)) != -1) {
+        switch (opt) {
+        case 'U':
+            down.src.name = optarg;
+            break;
+        case 'u':
+            up.sink.name = optarg;
+            break;
+        case 'O':
+            down.sink.name = optarg;
+            break;
+        case 'I':
+            up.src.name = optarg;
+            break;
+        case 'o':
+            only = optarg;
+            break;
+        case 'r':
+            usb_rate = (unsigned int)atoi(optarg);
+            break;
+        case 'c':
+            usb_ch = (unsigned int)atoi(optarg);
+            break;
+        case 's':
+            codec_rate = (unsigned int)atoi(optarg);
+            break;
+        case 'C':
+            codec_ch = (unsigned int)atoi(optarg);
+            break;
+        case 'm':
+            mic_ch = (unsigned int)atoi(optarg);
+            break;
+        case 'p':
+            period_us = (unsigned int)atoi(optarg);
+            break;
+        case 'l':
+            latency_ms = (unsigned int)atoi(optarg);
+            break;
+        case 'R':
+            rt_prio = atoi(optarg);
+            break;
+        case 'i':
+            report_s = (unsigned int)atoi(optarg);
+            break;
+        case 'S':
+            use_scalar = 1;
+            break;
+        case 'v':
+            verbose = 1;
+            break;
+        case 'h':
+            print_usage(argv[0]);
+            return 0;
+        default:
+            print_usage(argv[0]);
+            return 2;
+        }
+    }
+    if (only && strcmp(only, "down") != 0 && strcmp(only, "up") != 0) {
+        fprintf(stderr, "usb-audio-bridge: --only takes 'down' or 'up'\n");
+        return 2;
+    }
+    if (!usb_ch || usb_ch > MAX_CHANNELS || !codec_ch || codec_ch > MAX_CHANNELS ||
+        !mic_ch || mic_ch > MAX_CHANNELS || usb_rate < 8000 || codec_rate < 8000 ||
+        period_us < 500 || latency_ms == 0 || report_s == 0) {
+        fprintf(stderr, "usb-audio-bridge: bad channels, rate, period, latency or interval\n");
+        return 2;
+    }
+
+    down.src = (end_t){ down.src.name, NULL, SND_PCM_STREAM_CAPTURE, usb_ch, usb_rate, 0, 0 };
+    down.sink = (end_t){ down.sink.name, NULL, SND_PCM_STREAM_PLAYBACK, codec_ch, codec_rate, 0, 0 };
+    up.src = (end_t){ up.src.name, NULL, SND_PCM_STREAM_CAPTURE, mic_ch, codec_rate, 0, 0 };
+    up.sink = (end_t){ up.sink.name, NULL, SND_PCM_STREAM_PLAYBACK, usb_ch, usb_rate, 0, 0 };
+
+    if ((!only || strcmp(only, "down") == 0) && bridge_open(&down, period_us, latency_ms) == 0) {
+        run[n_run++] = &down;
+    }
+    if ((!only || strcmp(only, "up") == 0) && bridge_open(&up, period_us, latency_ms) == 0) {
+        run[n_run++] = &up;
+    }
+    if (n_run == 0) {
+        return 1;
+    }
+
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = on_signal;
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+
+    if (rt_prio > 0) {
+        mlockall(MCL_CURRENT | MCL_FUTURE);
+    }
+    for (int i = 0; i < n_run; i++) {
+        pthread_attr_t attr;
+        struct sched_param sp = { .sched_priority = rt_prio };
+
+        pthread_attr_init(&attr);
+        if (rt_prio > 0) {
+            pthread_attr_setinheritsched(&attr, PTHREAD_EXPLICIT_SCHED);
+            pthread_attr_setschedpolicy(&attr, SCHED_FIFO);
+            pthread_attr_setschedparam(&attr, &sp);
+        }
+        if (pthread_create(&run[i]->thread, &attr, run_bridge, run[i]) != 0) {
+            if (rt_prio > 0) {
+                fprintf(stderr, "usb-audio-bridge: SCHED_FIFO %d refused, running unprivileged\n", rt_prio);
+                pthread_attr_setinheritsched(&attr, PTHREAD_INHERIT_SCHED);
+            }
+            if (pthread_create(&run[i]->thread, &attr, run_bridge, run[i]) != 0) {
+                fprintf(stderr, "usb-audio-bridge: cannot start %s thread\n", run[i]->label);
+                stop = 1;
+                n_run = i;
+            }
+        }
+        pthread_attr_destroy(&attr);
+    }
+    for (int i = 0; i < n_run; i++) {
+        pthread_join(run[i]->thread, NULL);
+    }
+    for (int i = 0; i < n_run; i++) {
+        printf("%s: stopped, drift %+.1f ppm, %u xruns, %u stalls\n", run[i]->label, run[i]->integ,
+               run[i]->xruns, run[i]->stalls);
+        snd_pcm_close(run[i]->src.pcm);
+        snd_pcm_close(run[i]->sink.pcm);
+    }
+    return 0;
+}